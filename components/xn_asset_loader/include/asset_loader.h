@@ -0,0 +1,169 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-06 10:18:32
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-06 10:18:32
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_asset_loader\include\asset_loader.h
+ * @Description: 异步资源加载器 - 低优先级 I/O 任务统一读取文件系统资源，预读到 PSRAM 缓冲池并回调通知
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ASSET_LOADER_CHUNK_SIZE         4096    ///< 缓冲池每块字节数（也是每次 fread 的大小）
+#define ASSET_LOADER_POOL_CHUNKS        8       ///< 缓冲池块数（PSRAM）
+#define ASSET_LOADER_READ_AHEAD         2       ///< 每个拉取流最多预读、尚未释放的块数
+#define ASSET_LOADER_MAX_JOBS           4       ///< 同时进行的请求数，轮流每次读一块
+#define ASSET_LOADER_QUEUE_LEN          8       ///< 等待执行的请求队列长度
+#define ASSET_LOADER_PATH_MAX           64      ///< 文件路径最大长度（含结束符）
+#define ASSET_LOADER_MAX_PARTITIONS     4       ///< 分别统计的挂载点数
+#define ASSET_LOADER_MOUNT_MAX          16      ///< 挂载点名称最大长度（含结束符）
+
+/** 整文件读取结果（在加载器任务中回调） */
+typedef struct {
+    const char *path;           ///< 请求的路径
+    esp_err_t err;              ///< ESP_OK 成功, ESP_ERR_NOT_FOUND 打不开, ESP_ERR_INVALID_SIZE 空文件,
+                                ///< ESP_ERR_NO_MEM 缓冲区分配失败, ESP_FAIL 读取出错
+    uint8_t *data;              ///< 文件内容（PSRAM），成功时由接收方负责 asset_loader_free
+    size_t size;                ///< 文件字节数
+    uint32_t latency_us;        ///< 从提交到读完的耗时（含排队）
+} asset_loader_result_t;
+
+/** 流式读取的一块数据 */
+typedef struct {
+    const uint8_t *data;        ///< 块数据（缓冲池，PSRAM）
+    size_t len;                 ///< 块字节数（最后一块可能为 0）
+    size_t offset;              ///< 块在文件中的偏移
+    size_t total;               ///< 文件总字节数
+    bool last;                  ///< 是否为最后一块（出错时也为 true）
+    esp_err_t err;              ///< ESP_OK 正常, ESP_ERR_NOT_FOUND 打不开, ESP_FAIL 读取出错
+} asset_chunk_t;
+
+/** 整文件读取完成回调（在加载器任务中执行，应尽快返回） */
+typedef void (*asset_loader_done_cb_t)(const asset_loader_result_t *result, void *user_ctx);
+
+/** 推送流的块回调（在加载器任务中执行，返回后缓冲块即被回收，不能阻塞） */
+typedef void (*asset_loader_chunk_cb_t)(const asset_chunk_t *chunk, void *user_ctx);
+
+/** 拉取流句柄 */
+typedef struct asset_stream *asset_stream_handle_t;
+
+/** 单个挂载点的吞吐统计（统计窗口为上次重置到现在） */
+typedef struct {
+    char mount[ASSET_LOADER_MOUNT_MAX]; ///< 挂载点（路径第一段，如 "/lottie"）
+    uint32_t requests;          ///< 完成的请求数
+    uint32_t errors;            ///< 其中失败的请求数
+    uint64_t bytes;             ///< 读取字节数
+    uint32_t io_ms;             ///< fopen/fread/fclose 累计耗时
+    uint32_t kb_per_s;          ///< 吞吐（按 I/O 耗时计算）
+    uint32_t avg_latency_ms;    ///< 请求平均完成耗时（含排队与等待消费方）
+    uint32_t max_latency_ms;    ///< 请求最大完成耗时
+} asset_loader_part_stats_t;
+
+/** 加载器统计 */
+typedef struct {
+    asset_loader_part_stats_t parts[ASSET_LOADER_MAX_PARTITIONS];
+    size_t part_count;          ///< 有效的挂载点数
+    uint32_t pool_stalls;       ///< 因缓冲池用尽而推迟读取的次数
+    uint32_t queue_full;        ///< 请求队列满被拒绝的次数
+    uint32_t peak_jobs;         ///< 同时进行的请求数峰值
+} asset_loader_stats_t;
+
+/** 加载器配置 */
+typedef struct {
+    uint32_t task_stack_size;   ///< I/O 任务栈大小（字节，内部 RAM）
+    int task_priority;          ///< I/O 任务优先级（应低于动画、网络、音频任务）
+    int task_core;              ///< 绑定核心，tskNO_AFFINITY 不绑定
+} asset_loader_config_t;
+
+#define ASSET_LOADER_DEFAULT_CONFIG() {         \
+        .task_stack_size = 4 * 1024,            \
+        .task_priority   = 2,                   \
+        .task_core       = tskNO_AFFINITY,      \
+    }
+
+/**
+ * @brief 初始化加载器：分配 PSRAM 缓冲池并启动 I/O 任务（重复调用直接返回 ESP_OK）
+ * @param config 配置，NULL 使用默认配置
+ * @return ESP_OK 成功, ESP_ERR_NO_MEM 内存不足
+ */
+esp_err_t asset_loader_init(const asset_loader_config_t *config);
+
+/**
+ * @brief 异步读取整个文件到 PSRAM，读完后在加载器任务中回调
+ * @param path 文件路径（VFS 路径，如 "/lottie/speak.json"）
+ * @param cb 完成回调（失败时同样回调，err 非 ESP_OK 且 data 为 NULL）
+ * @param user_ctx 回调参数
+ * @return ESP_OK 已排队, ESP_ERR_INVALID_ARG 参数无效或路径过长,
+ *         ESP_ERR_INVALID_STATE 未初始化, ESP_ERR_NO_MEM 请求队列已满
+ */
+esp_err_t asset_loader_read(const char *path, asset_loader_done_cb_t cb, void *user_ctx);
+
+/**
+ * @brief 释放 asset_loader_read 返回的文件内容（可在任意任务中调用）
+ * @param data 文件内容，NULL 忽略
+ */
+void asset_loader_free(uint8_t *data);
+
+/**
+ * @brief 异步分块读取文件，每读完一块在加载器任务中回调（推送方式，适合不会阻塞的消费方）
+ * @param path 文件路径
+ * @param cb 块回调，最后一块（或出错时）last 为 true
+ * @param user_ctx 回调参数
+ * @return 同 asset_loader_read
+ */
+esp_err_t asset_loader_stream(const char *path, asset_loader_chunk_cb_t cb, void *user_ctx);
+
+/**
+ * @brief 打开拉取流：加载器在后台预读最多 ASSET_LOADER_READ_AHEAD 块，消费方按自己的节奏取走
+ * @param path 文件路径
+ * @param out 输出流句柄
+ * @return ESP_OK 已排队, ESP_ERR_INVALID_ARG 参数无效, ESP_ERR_INVALID_STATE 未初始化,
+ *         ESP_ERR_NO_MEM 内存不足或请求队列已满
+ */
+esp_err_t asset_loader_open(const char *path, asset_stream_handle_t *out);
+
+/**
+ * @brief 取下一块预读数据（只等待队列，不接触文件系统）
+ * @param stream 流句柄
+ * @param chunk 输出块，用完后须 asset_loader_stream_release
+ * @param timeout 最长等待
+ * @return ESP_OK 成功（检查 chunk->err / chunk->last）, ESP_ERR_TIMEOUT 超时,
+ *         ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t asset_loader_stream_read(asset_stream_handle_t stream, asset_chunk_t *chunk, TickType_t timeout);
+
+/**
+ * @brief 归还一块数据的缓冲区，加载器可以继续预读
+ * @param stream 流句柄
+ * @param chunk asset_loader_stream_read 取到的块
+ */
+void asset_loader_stream_release(asset_stream_handle_t stream, const asset_chunk_t *chunk);
+
+/**
+ * @brief 关闭拉取流（未读完时取消读取），取到的块须先全部归还
+ * @param stream 流句柄，NULL 忽略
+ */
+void asset_loader_close(asset_stream_handle_t stream);
+
+/**
+ * @brief 获取各挂载点的吞吐统计
+ * @param stats 输出统计
+ * @param reset 读取后是否开始新的统计窗口
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 参数为空, ESP_ERR_INVALID_STATE 未初始化
+ */
+esp_err_t asset_loader_get_stats(asset_loader_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
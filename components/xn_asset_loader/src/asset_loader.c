@@ -0,0 +1,651 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-06 10:18:32
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-06 10:18:32
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_asset_loader\src\asset_loader.c
+ * @Description: 异步资源加载器实现
+ *
+ * 单个低优先级 I/O 任务持有全部文件句柄，最多 ASSET_LOADER_MAX_JOBS 个请求轮流每次读一块，
+ * 大文件不会饿死后面的小请求；拉取流受预读深度限制，消费方不取走时只占用少量缓冲块。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include "asset_loader.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_bit_defs.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "ASSET_LOADER";
+
+#define ASSET_LOADER_IDLE_WAIT_MS   100     ///< 没有可推进的请求时的兜底等待（防止通知丢失）
+
+_Static_assert(ASSET_LOADER_POOL_CHUNKS <= 32, "pool bitmap is 32 bits");
+
+/** 请求类型 */
+typedef enum {
+    ASSET_REQ_READ = 0,         ///< 整文件读入 PSRAM
+    ASSET_REQ_STREAM,           ///< 分块推送给回调
+    ASSET_REQ_PULL,             ///< 分块预读到流队列，由消费方拉取
+} asset_req_kind_t;
+
+/** 请求（按值放入请求队列） */
+typedef struct {
+    asset_req_kind_t kind;
+    char path[ASSET_LOADER_PATH_MAX];
+    asset_loader_done_cb_t done_cb;
+    asset_loader_chunk_cb_t chunk_cb;
+    void *user_ctx;
+    struct asset_stream *stream;
+    int64_t submit_us;
+} asset_req_t;
+
+/** 拉取流（消费方与加载器共享，谁最后放手谁释放） */
+struct asset_stream {
+    QueueHandle_t ready;        ///< 已预读的块（asset_chunk_t）
+    uint32_t outstanding;       ///< 已预读、尚未归还的缓冲块数
+    bool closed;                ///< 消费方已关闭（s_lock 保护）
+    bool finished;              ///< 加载器已结束该流（s_lock 保护）
+};
+
+/** 正在执行的请求 */
+typedef struct {
+    bool active;
+    asset_req_t req;
+    FILE *fp;
+    size_t total;               ///< 文件字节数
+    size_t offset;              ///< 已读字节数
+    uint8_t *data;              ///< 整文件读取的目标缓冲区
+    int part;                   ///< 统计槽位，-1 表示不统计
+    uint64_t io_us;             ///< 本请求的 I/O 耗时
+} asset_job_t;
+
+/** 挂载点累计统计 */
+typedef struct {
+    char mount[ASSET_LOADER_MOUNT_MAX];
+    uint32_t requests;
+    uint32_t errors;
+    uint64_t bytes;
+    uint64_t io_us;
+    uint64_t latency_us;
+    uint32_t max_latency_us;
+} asset_part_acc_t;
+
+typedef struct {
+    bool initialized;
+    QueueHandle_t req_queue;
+    TaskHandle_t task;
+    uint8_t *pool;                              ///< 缓冲池（PSRAM）
+    uint32_t pool_free;                         ///< 空闲块位图（s_lock 保护）
+    asset_job_t jobs[ASSET_LOADER_MAX_JOBS];    ///< 只在加载器任务中访问
+    asset_part_acc_t parts[ASSET_LOADER_MAX_PARTITIONS];
+    size_t part_count;
+    uint32_t pool_stalls;
+    uint32_t queue_full;
+    uint32_t peak_jobs;
+} asset_loader_ctx_t;
+
+static asset_loader_ctx_t s_ctx = {0};
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// ============ 缓冲池 ============
+
+static uint8_t *asset_pool_alloc(void)
+{
+    uint8_t *buf = NULL;
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_ctx.pool_free) {
+        int idx = __builtin_ctz(s_ctx.pool_free);
+        s_ctx.pool_free &= ~BIT(idx);
+        buf = s_ctx.pool + (size_t)idx * ASSET_LOADER_CHUNK_SIZE;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return buf;
+}
+
+static void asset_pool_free(const uint8_t *buf)
+{
+    int idx = (int)((buf - s_ctx.pool) / ASSET_LOADER_CHUNK_SIZE);
+
+    portENTER_CRITICAL(&s_lock);
+    s_ctx.pool_free |= BIT(idx);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static inline void asset_loader_wake(void)
+{
+    if (s_ctx.task) {
+        xTaskNotifyGive(s_ctx.task);
+    }
+}
+
+// ============ 拉取流 ============
+
+static void asset_stream_destroy(struct asset_stream *stream)
+{
+    asset_chunk_t chunk;
+    while (xQueueReceive(stream->ready, &chunk, 0) == pdTRUE) {
+        if (chunk.data) {
+            asset_pool_free(chunk.data);
+        }
+    }
+    vQueueDelete(stream->ready);
+    free(stream);
+    asset_loader_wake();
+}
+
+// ============ 统计 ============
+
+/**
+ * @brief 按路径第一段（挂载点）查找统计槽位，没有则新建，满了返回 -1
+ */
+static int asset_part_find(const char *path)
+{
+    const char *end = strchr(path + 1, '/');
+    size_t len = end ? (size_t)(end - path) : strlen(path);
+    if (len >= ASSET_LOADER_MOUNT_MAX) {
+        len = ASSET_LOADER_MOUNT_MAX - 1;
+    }
+
+    for (size_t i = 0; i < s_ctx.part_count; i++) {
+        if (strncmp(s_ctx.parts[i].mount, path, len) == 0 && s_ctx.parts[i].mount[len] == '\0') {
+            return (int)i;
+        }
+    }
+    if (s_ctx.part_count >= ASSET_LOADER_MAX_PARTITIONS) {
+        return -1;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    asset_part_acc_t *acc = &s_ctx.parts[s_ctx.part_count];
+    memset(acc, 0, sizeof(*acc));
+    memcpy(acc->mount, path, len);
+    int idx = (int)s_ctx.part_count++;
+    portEXIT_CRITICAL(&s_lock);
+    return idx;
+}
+
+static void asset_part_account(const asset_job_t *job, esp_err_t err)
+{
+    if (job->part < 0) {
+        return;
+    }
+
+    uint32_t latency_us = (uint32_t)(esp_timer_get_time() - job->req.submit_us);
+
+    portENTER_CRITICAL(&s_lock);
+    asset_part_acc_t *acc = &s_ctx.parts[job->part];
+    acc->requests++;
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {   // 消费方主动关闭不算失败
+        acc->errors++;
+    }
+    acc->bytes += job->offset;
+    acc->io_us += job->io_us;
+    acc->latency_us += latency_us;
+    if (latency_us > acc->max_latency_us) {
+        acc->max_latency_us = latency_us;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGD(TAG, "%s: %u 字节, I/O %llu us, 完成 %lu us, err=%s", job->req.path,
+             (unsigned)job->offset, (unsigned long long)job->io_us,
+             (unsigned long)latency_us, esp_err_to_name(err));
+}
+
+// ============ 请求执行（只在加载器任务中） ============
+
+static void asset_job_finish(asset_job_t *job, esp_err_t err)
+{
+    asset_req_t *req = &job->req;
+
+    if (job->fp) {
+        int64_t t0 = esp_timer_get_time();
+        fclose(job->fp);
+        job->io_us += esp_timer_get_time() - t0;
+        job->fp = NULL;
+    }
+    asset_part_account(job, err);
+
+    switch (req->kind) {
+    case ASSET_REQ_READ: {
+        if (err != ESP_OK && job->data) {
+            heap_caps_free(job->data);
+            job->data = NULL;
+        }
+        asset_loader_result_t result = {
+            .path = req->path,
+            .err = err,
+            .data = job->data,
+            .size = err == ESP_OK ? job->total : 0,
+            .latency_us = (uint32_t)(esp_timer_get_time() - req->submit_us),
+        };
+        req->done_cb(&result, req->user_ctx);
+        break;
+    }
+
+    case ASSET_REQ_STREAM:
+        if (err != ESP_OK) {
+            asset_chunk_t chunk = {
+                .offset = job->offset, .total = job->total, .last = true, .err = err,
+            };
+            req->chunk_cb(&chunk, req->user_ctx);
+        }
+        break;
+
+    case ASSET_REQ_PULL: {
+        struct asset_stream *stream = req->stream;
+        if (err != ESP_OK && !__atomic_load_n(&stream->closed, __ATOMIC_ACQUIRE)) {
+            // 队列长度为预读深度 + 1，结束块总有位置
+            asset_chunk_t chunk = {
+                .offset = job->offset, .total = job->total, .last = true, .err = err,
+            };
+            xQueueSend(stream->ready, &chunk, 0);
+        }
+        portENTER_CRITICAL(&s_lock);
+        stream->finished = true;
+        bool closed = stream->closed;
+        portEXIT_CRITICAL(&s_lock);
+        if (closed) {
+            asset_stream_destroy(stream);
+        }
+        break;
+    }
+    }
+
+    memset(job, 0, sizeof(*job));
+}
+
+static esp_err_t asset_job_open(asset_job_t *job)
+{
+    int64_t t0 = esp_timer_get_time();
+    job->fp = fopen(job->req.path, "rb");
+    if (job->fp) {
+        fseek(job->fp, 0, SEEK_END);
+        long size = ftell(job->fp);
+        fseek(job->fp, 0, SEEK_SET);
+        job->total = size > 0 ? (size_t)size : 0;
+    }
+    job->io_us += esp_timer_get_time() - t0;
+
+    if (!job->fp) {
+        ESP_LOGE(TAG, "无法打开文件: %s", job->req.path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (job->req.kind == ASSET_REQ_READ) {
+        if (job->total == 0) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        job->data = heap_caps_malloc(job->total, MALLOC_CAP_SPIRAM);
+        if (!job->data) {
+            ESP_LOGE(TAG, "文件缓冲区分配失败: %s (%u 字节)", job->req.path, (unsigned)job->total);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 推进一个请求（打开文件或读一块）
+ * @return 是否有进展；false 表示在等缓冲块或等消费方
+ */
+static bool asset_job_step(asset_job_t *job)
+{
+    asset_req_t *req = &job->req;
+
+    if (req->kind == ASSET_REQ_PULL && __atomic_load_n(&req->stream->closed, __ATOMIC_ACQUIRE)) {
+        asset_job_finish(job, ESP_ERR_INVALID_STATE);   // 消费方提前关闭
+        return true;
+    }
+
+    if (!job->fp) {
+        esp_err_t err = asset_job_open(job);
+        if (err != ESP_OK) {
+            asset_job_finish(job, err);
+        }
+        return true;
+    }
+
+    size_t want = job->total - job->offset;
+    if (want > ASSET_LOADER_CHUNK_SIZE) {
+        want = ASSET_LOADER_CHUNK_SIZE;
+    }
+
+    if (req->kind == ASSET_REQ_READ) {
+        int64_t t0 = esp_timer_get_time();
+        size_t got = fread(job->data + job->offset, 1, want, job->fp);
+        job->io_us += esp_timer_get_time() - t0;
+        job->offset += got;
+        if (got != want) {
+            asset_job_finish(job, ESP_FAIL);
+        } else if (job->offset >= job->total) {
+            asset_job_finish(job, ESP_OK);
+        }
+        return true;
+    }
+
+    if (req->kind == ASSET_REQ_PULL &&
+        __atomic_load_n(&req->stream->outstanding, __ATOMIC_ACQUIRE) >= ASSET_LOADER_READ_AHEAD) {
+        return false;
+    }
+
+    uint8_t *buf = asset_pool_alloc();
+    if (!buf) {
+        portENTER_CRITICAL(&s_lock);
+        s_ctx.pool_stalls++;
+        portEXIT_CRITICAL(&s_lock);
+        return false;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    size_t got = want ? fread(buf, 1, want, job->fp) : 0;
+    job->io_us += esp_timer_get_time() - t0;
+    if (got != want) {
+        asset_pool_free(buf);
+        asset_job_finish(job, ESP_FAIL);
+        return true;
+    }
+
+    asset_chunk_t chunk = {
+        .data = buf,
+        .len = got,
+        .offset = job->offset,
+        .total = job->total,
+        .last = job->offset + got >= job->total,
+        .err = ESP_OK,
+    };
+    job->offset += got;
+
+    if (req->kind == ASSET_REQ_STREAM) {
+        req->chunk_cb(&chunk, req->user_ctx);
+        asset_pool_free(buf);
+    } else {
+        __atomic_add_fetch(&req->stream->outstanding, 1, __ATOMIC_ACQ_REL);
+        xQueueSend(req->stream->ready, &chunk, 0);
+    }
+
+    if (chunk.last) {
+        asset_job_finish(job, ESP_OK);
+    }
+    return true;
+}
+
+/**
+ * @brief 把排队的请求放进空闲的执行槽位
+ */
+static void asset_loader_accept(void)
+{
+    uint32_t active = 0;
+
+    for (int i = 0; i < ASSET_LOADER_MAX_JOBS; i++) {
+        asset_job_t *job = &s_ctx.jobs[i];
+        if (!job->active) {
+            if (xQueueReceive(s_ctx.req_queue, &job->req, 0) != pdTRUE) {
+                continue;
+            }
+            job->active = true;
+            job->part = asset_part_find(job->req.path);
+        }
+        active++;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    if (active > s_ctx.peak_jobs) {
+        s_ctx.peak_jobs = active;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void asset_loader_task(void *arg)
+{
+    (void)arg;
+
+    ESP_LOGI(TAG, "资源加载任务启动");
+
+    while (1) {
+        asset_loader_accept();
+
+        bool progressed = false;
+        for (int i = 0; i < ASSET_LOADER_MAX_JOBS; i++) {
+            if (s_ctx.jobs[i].active) {
+                progressed |= asset_job_step(&s_ctx.jobs[i]);
+            }
+        }
+
+        if (!progressed) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ASSET_LOADER_IDLE_WAIT_MS));
+        }
+    }
+}
+
+// ============ 公共API实现 ============
+
+static esp_err_t asset_loader_submit(asset_req_t *req, const char *path)
+{
+    if (!s_ctx.initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!path || strlen(path) >= sizeof(req->path)) {
+        ESP_LOGE(TAG, "文件路径无效或过长: %s", path ? path : "(null)");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    strcpy(req->path, path);
+    req->submit_us = esp_timer_get_time();
+
+    if (xQueueSend(s_ctx.req_queue, req, 0) != pdTRUE) {
+        portENTER_CRITICAL(&s_lock);
+        s_ctx.queue_full++;
+        portEXIT_CRITICAL(&s_lock);
+        ESP_LOGW(TAG, "请求队列已满: %s", path);
+        return ESP_ERR_NO_MEM;
+    }
+
+    asset_loader_wake();
+    return ESP_OK;
+}
+
+esp_err_t asset_loader_init(const asset_loader_config_t *config)
+{
+    if (s_ctx.initialized) {
+        return ESP_OK;
+    }
+
+    asset_loader_config_t cfg = ASSET_LOADER_DEFAULT_CONFIG();
+    if (config) {
+        cfg = *config;
+    }
+
+    s_ctx.pool = heap_caps_malloc((size_t)ASSET_LOADER_CHUNK_SIZE * ASSET_LOADER_POOL_CHUNKS, MALLOC_CAP_SPIRAM);
+    if (!s_ctx.pool) {
+        ESP_LOGE(TAG, "缓冲池分配失败");
+        return ESP_ERR_NO_MEM;
+    }
+    s_ctx.pool_free = (uint32_t)((1ULL << ASSET_LOADER_POOL_CHUNKS) - 1);
+
+    s_ctx.req_queue = xQueueCreate(ASSET_LOADER_QUEUE_LEN, sizeof(asset_req_t));
+    if (!s_ctx.req_queue) {
+        heap_caps_free(s_ctx.pool);
+        s_ctx.pool = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    // 栈放在内部 RAM：文件系统读写期间 Flash cache 关闭，PSRAM 栈不可用
+    s_ctx.initialized = true;
+    if (xTaskCreatePinnedToCore(asset_loader_task, "asset_loader", cfg.task_stack_size, NULL,
+                                cfg.task_priority, &s_ctx.task, cfg.task_core) != pdPASS) {
+        s_ctx.initialized = false;
+        vQueueDelete(s_ctx.req_queue);
+        s_ctx.req_queue = NULL;
+        heap_caps_free(s_ctx.pool);
+        s_ctx.pool = NULL;
+        ESP_LOGE(TAG, "创建资源加载任务失败");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "✅ 资源加载器已启动: 缓冲池 %d x %d 字节 (PSRAM), 优先级 %d",
+             ASSET_LOADER_POOL_CHUNKS, ASSET_LOADER_CHUNK_SIZE, cfg.task_priority);
+    return ESP_OK;
+}
+
+esp_err_t asset_loader_read(const char *path, asset_loader_done_cb_t cb, void *user_ctx)
+{
+    if (!cb) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    asset_req_t req = {
+        .kind = ASSET_REQ_READ,
+        .done_cb = cb,
+        .user_ctx = user_ctx,
+    };
+    return asset_loader_submit(&req, path);
+}
+
+void asset_loader_free(uint8_t *data)
+{
+    if (data) {
+        heap_caps_free(data);
+    }
+}
+
+esp_err_t asset_loader_stream(const char *path, asset_loader_chunk_cb_t cb, void *user_ctx)
+{
+    if (!cb) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    asset_req_t req = {
+        .kind = ASSET_REQ_STREAM,
+        .chunk_cb = cb,
+        .user_ctx = user_ctx,
+    };
+    return asset_loader_submit(&req, path);
+}
+
+esp_err_t asset_loader_open(const char *path, asset_stream_handle_t *out)
+{
+    if (!out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out = NULL;
+
+    struct asset_stream *stream = calloc(1, sizeof(*stream));
+    if (!stream) {
+        return ESP_ERR_NO_MEM;
+    }
+    stream->ready = xQueueCreate(ASSET_LOADER_READ_AHEAD + 1, sizeof(asset_chunk_t));
+    if (!stream->ready) {
+        free(stream);
+        return ESP_ERR_NO_MEM;
+    }
+
+    asset_req_t req = {
+        .kind = ASSET_REQ_PULL,
+        .stream = stream,
+    };
+    esp_err_t ret = asset_loader_submit(&req, path);
+    if (ret != ESP_OK) {
+        vQueueDelete(stream->ready);
+        free(stream);
+        return ret;
+    }
+
+    *out = stream;
+    return ESP_OK;
+}
+
+esp_err_t asset_loader_stream_read(asset_stream_handle_t stream, asset_chunk_t *chunk, TickType_t timeout)
+{
+    if (!stream || !chunk) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (xQueueReceive(stream->ready, chunk, timeout) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+void asset_loader_stream_release(asset_stream_handle_t stream, const asset_chunk_t *chunk)
+{
+    if (!stream || !chunk || !chunk->data) {
+        return;
+    }
+    asset_pool_free(chunk->data);
+    __atomic_sub_fetch(&stream->outstanding, 1, __ATOMIC_ACQ_REL);
+    asset_loader_wake();
+}
+
+void asset_loader_close(asset_stream_handle_t stream)
+{
+    if (!stream) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    stream->closed = true;
+    bool finished = stream->finished;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (finished) {
+        asset_stream_destroy(stream);
+    } else {
+        asset_loader_wake();    // 由加载器取消读取并释放
+    }
+}
+
+esp_err_t asset_loader_get_stats(asset_loader_stats_t *stats, bool reset)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_ctx.initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+
+    portENTER_CRITICAL(&s_lock);
+    stats->part_count = s_ctx.part_count;
+    for (size_t i = 0; i < s_ctx.part_count; i++) {
+        const asset_part_acc_t *acc = &s_ctx.parts[i];
+        asset_loader_part_stats_t *st = &stats->parts[i];
+
+        memcpy(st->mount, acc->mount, sizeof(st->mount));
+        st->requests = acc->requests;
+        st->errors = acc->errors;
+        st->bytes = acc->bytes;
+        st->io_ms = (uint32_t)(acc->io_us / 1000);
+        st->kb_per_s = acc->io_us ? (uint32_t)(acc->bytes * 1000000ULL / 1024 / acc->io_us) : 0;
+        st->avg_latency_ms = acc->requests ? (uint32_t)(acc->latency_us / acc->requests / 1000) : 0;
+        st->max_latency_ms = acc->max_latency_us / 1000;
+    }
+    stats->pool_stalls = s_ctx.pool_stalls;
+    stats->queue_full = s_ctx.queue_full;
+    stats->peak_jobs = s_ctx.peak_jobs;
+
+    if (reset) {
+        for (size_t i = 0; i < s_ctx.part_count; i++) {
+            asset_part_acc_t *acc = &s_ctx.parts[i];
+            acc->requests = 0;
+            acc->errors = 0;
+            acc->bytes = 0;
+            acc->io_us = 0;
+            acc->latency_us = 0;
+            acc->max_latency_us = 0;
+        }
+        s_ctx.pool_stalls = 0;
+        s_ctx.queue_full = 0;
+        s_ctx.peak_jobs = 0;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    return ESP_OK;
+}
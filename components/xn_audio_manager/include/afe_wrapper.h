@@ -25,8 +25,15 @@ typedef enum {
     AFE_EVENT_WAKEUP_DETECTED,  ///< 唤醒词检测到
     AFE_EVENT_VAD_START,        ///< 人声开始
     AFE_EVENT_VAD_END,          ///< 人声结束
+    AFE_EVENT_MODEL_READY,      ///< 模型异步加载完成，唤醒词可用
+    AFE_EVENT_PRESSURE,         ///< AFE 内部缓冲积压状态变化（进入/解除）
+    AFE_EVENT_COMMAND_DETECTED, ///< 命令词识别到（MultiNet）
 } afe_event_type_t;
 
+/** AFE 积压判定阈值（内部缓冲填充率，带回差避免抖动） */
+#define AFE_PRESSURE_ENTER_PCT      50  ///< 填充率达到该值进入积压
+#define AFE_PRESSURE_LEAVE_PCT      20  ///< 填充率回落到该值以下解除积压
+
 /** AFE 事件数据 */
 typedef struct {
     afe_event_type_t type;
@@ -35,6 +42,15 @@ typedef struct {
             int wake_word_index;
             float volume_db;
         } wakeup;
+        struct {
+            bool active;        ///< true 进入积压，false 解除
+            uint8_t fill_pct;   ///< 触发时的填充率（%）
+        } pressure;
+        struct {
+            int command_id;     ///< 命令 ID（afe_command_word_t.id）
+            float prob;         ///< 识别置信度
+            int64_t detect_us;  ///< 识别时刻（esp_timer_get_time，在 fetch 任务中取得）
+        } command;
     } data;
 } afe_event_t;
 
@@ -52,6 +68,21 @@ typedef struct {
     int sensitivity;
 } afe_wakeup_config_t;
 
+/** 命令词（同一 id 可对应多个说法） */
+typedef struct {
+    int id;                     ///< 命令 ID（≥ 0）
+    const char *phrase;         ///< 中文模型用空格分隔的拼音，如 "kai shi jiao shui"；英文模型用小写单词
+} afe_command_word_t;
+
+/** AFE 命令词配置（MultiNet，与唤醒词共用模型分区） */
+typedef struct {
+    bool enabled;
+    const char *language;               ///< "cn" / "en"，用于从模型分区中挑选 MultiNet 模型
+    int timeout_ms;                     ///< 唤醒后多久没说出命令词即停止识别
+    const afe_command_word_t *words;    ///< 命令表（须在包装器生命周期内有效）
+    size_t word_count;
+} afe_command_config_t;
+
 /** AFE VAD 配置 */
 typedef struct {
     bool enabled;
@@ -73,6 +104,7 @@ typedef struct {
     audio_bsp_handle_t bsp_handle;             ///< BSP 句柄
     ring_buffer_handle_t reference_rb;          ///< 回采缓冲区
     afe_wakeup_config_t wakeup_config;          ///< 唤醒词配置
+    afe_command_config_t command_config;        ///< 命令词配置
     afe_vad_config_t vad_config;                ///< VAD 配置
     afe_feature_config_t feature_config;        ///< 功能配置
     afe_event_callback_t event_callback;        ///< 事件回调
@@ -83,11 +115,25 @@ typedef struct {
     bool *recording_ptr;                        ///< 录音状态指针（外部管理）
 } afe_wrapper_config_t;
 
+/** 模型加载统计（异步加载完成后有效） */
+typedef struct {
+    uint32_t map_ms;                            ///< 模型分区映射 + 解析耗时
+    uint32_t afe_ms;                            ///< AFE 实例创建耗时
+    uint32_t total_ms;                          ///< 加载任务总耗时
+    int model_count;                            ///< 已加载模型数量
+    int command_count;                          ///< 已注册的命令词数量（0 表示命令词不可用）
+    uint32_t command_ms;                        ///< MultiNet 创建 + 命令表编译耗时
+    size_t mapped_bytes;                        ///< 直接映射（不拷贝）的模型分区大小
+    size_t psram_used_bytes;                    ///< 加载过程实际占用的 PSRAM
+} afe_wrapper_load_stats_t;
+
 /** AFE 包装器句柄 */
 typedef struct afe_wrapper_s *afe_wrapper_handle_t;
 
 /**
  * @brief 创建 AFE 包装器
+ * @note 模型在后台任务中加载，本函数立即返回；加载完成前录音走麦克风直通，
+ *       完成后发送 AFE_EVENT_MODEL_READY 事件
  * @param config 配置参数
  * @return AFE 包装器句柄，失败返回 NULL
  */
@@ -99,6 +145,22 @@ afe_wrapper_handle_t afe_wrapper_create(const afe_wrapper_config_t *config);
  */
 void afe_wrapper_destroy(afe_wrapper_handle_t wrapper);
 
+/**
+ * @brief 模型是否已加载完成（唤醒词/VAD 可用）
+ * @param wrapper AFE 包装器句柄
+ * @return true 已就绪
+ */
+bool afe_wrapper_is_ready(afe_wrapper_handle_t wrapper);
+
+/**
+ * @brief 获取模型加载统计
+ * @param wrapper AFE 包装器句柄
+ * @param stats 输出统计
+ * @return ESP_OK 成功，ESP_ERR_INVALID_STATE 尚未加载完成
+ */
+esp_err_t afe_wrapper_get_load_stats(afe_wrapper_handle_t wrapper,
+                                     afe_wrapper_load_stats_t *stats);
+
 /**
  * @brief 更新唤醒词配置
  * @param wrapper AFE 包装器句柄
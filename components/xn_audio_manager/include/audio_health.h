@@ -0,0 +1,122 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-02 15:40:12
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-02 15:40:12
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_audio_manager\include\audio_health.h
+ * @Description: 音频链路健康计数 - I2S / 环形缓冲 / AFE / 编解码异常的统一计数块
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 计数项（除特别说明外均为开机以来的累计值） */
+typedef enum {
+    AUDIO_HEALTH_I2S_TX_QUEUE_OVF = 0,      ///< I2S 发送队列溢出事件（DMA 追上了软件，扬声器出现爆音/断音）
+    AUDIO_HEALTH_I2S_RX_QUEUE_OVF,          ///< I2S 接收队列溢出事件（麦克风数据丢失）
+    AUDIO_HEALTH_I2S_PARTIAL_WRITES,        ///< I2S 写入不完整次数
+    AUDIO_HEALTH_I2S_WRITE_ERRORS,          ///< I2S 写入失败次数
+    AUDIO_HEALTH_I2S_READ_ERRORS,           ///< I2S 读取失败/超时次数
+    AUDIO_HEALTH_PLAYBACK_OVERFLOW_SAMPLES, ///< 播放输入源写入等待超时被丢弃的采样点数
+    AUDIO_HEALTH_PLAYBACK_UNDERRUNS,        ///< 播放流中途断粮的帧数
+    AUDIO_HEALTH_REF_OVERFLOW_SAMPLES,      ///< 回采环形缓冲被覆盖的采样点数
+    AUDIO_HEALTH_REF_UNDERFLOWS,            ///< AFE 读取回采数据不足的次数
+    AUDIO_HEALTH_AFE_FETCH_LAG,             ///< AFE 内部缓冲积压超过一半的 fetch 次数
+    AUDIO_HEALTH_AFE_RING_FILL_MAX_PCT,     ///< AFE 内部缓冲最高填充率（%，峰值）
+    AUDIO_HEALTH_OPUS_DECODE_ERRORS,        ///< Opus 解码失败次数（由应用层同步）
+    AUDIO_HEALTH_UPLINK_OVERWRITE_BYTES,    ///< 上行环形缓冲被覆盖的字节数（由应用层同步）
+    AUDIO_HEALTH_MAX,
+} audio_health_counter_t;
+
+/** 计数快照 */
+typedef struct {
+    int64_t timestamp_ms;                   ///< 快照时间（开机后毫秒）
+    uint32_t counters[AUDIO_HEALTH_MAX];    ///< 各计数项
+} audio_health_snapshot_t;
+
+/**
+ * @brief 周期发布回调
+ * @param total 当前累计值
+ * @param delta 距上次发布的增量（峰值类计数项为当前值）
+ * @param user_ctx 用户上下文
+ */
+typedef void (*audio_health_publish_cb_t)(const audio_health_snapshot_t *total,
+                                          const audio_health_snapshot_t *delta,
+                                          void *user_ctx);
+
+/**
+ * @brief 快照前同步回调（用于把其他模块自行维护的计数写入计数块）
+ * @param user_ctx 用户上下文
+ */
+typedef void (*audio_health_sync_cb_t)(void *user_ctx);
+
+/**
+ * @brief 计数项累加（无锁，可在 ISR 中调用）
+ * @param id 计数项
+ * @param n 增量
+ */
+void audio_health_add(audio_health_counter_t id, uint32_t n);
+
+/**
+ * @brief 更新峰值类计数项（仅在 value 更大时写入，可在 ISR 中调用）
+ * @param id 计数项
+ * @param value 当前值
+ */
+void audio_health_update_max(audio_health_counter_t id, uint32_t value);
+
+/**
+ * @brief 直接设置计数项（用于同步其他模块自行维护的累计值）
+ * @param id 计数项
+ * @param value 累计值
+ */
+void audio_health_set(audio_health_counter_t id, uint32_t value);
+
+/**
+ * @brief 获取所有计数项的快照（只做一次内存拷贝）
+ * @param snapshot 输出快照
+ */
+void audio_health_snapshot(audio_health_snapshot_t *snapshot);
+
+/**
+ * @brief 清零所有计数项
+ */
+void audio_health_reset(void);
+
+/**
+ * @brief 获取计数项名称（用于日志/上报的键名）
+ * @param id 计数项
+ * @return 名称字符串，越界返回 "unknown"
+ */
+const char *audio_health_counter_name(audio_health_counter_t id);
+
+/**
+ * @brief 启动周期发布任务
+ * @param period_ms 发布周期（毫秒）
+ * @param cb 发布回调（在发布任务中调用，可以执行阻塞操作）
+ * @param user_ctx 用户上下文
+ * @return ESP_OK 成功，ESP_ERR_INVALID_STATE 已在运行
+ */
+esp_err_t audio_health_start_publisher(uint32_t period_ms, audio_health_publish_cb_t cb, void *user_ctx);
+
+/**
+ * @brief 设置快照前同步回调，发布任务每个周期先调用它再生成快照
+ * @param cb 同步回调，NULL 取消
+ * @param user_ctx 用户上下文
+ */
+void audio_health_set_sync_hook(audio_health_sync_cb_t cb, void *user_ctx);
+
+/**
+ * @brief 停止周期发布任务
+ */
+void audio_health_stop_publisher(void);
+
+#ifdef __cplusplus
+}
+#endif
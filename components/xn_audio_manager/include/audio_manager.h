@@ -12,6 +12,7 @@
 
 #include "esp_err.h"
 #include "audio_bsp.h"
+#include "playback_controller.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
@@ -30,8 +31,15 @@ extern "C" {
 
 #define AUDIO_MANAGER_PLAYBACK_FRAME_SAMPLES 1024
 #define AUDIO_MANAGER_PLAYBACK_BUFFER_BYTES  (512 * 1024)
+#define AUDIO_MANAGER_PROMPT_BUFFER_BYTES    (64 * 1024)
+#define AUDIO_MANAGER_ALERT_BUFFER_BYTES     (64 * 1024)
+#define AUDIO_MANAGER_PROMPT_DUCK_PERCENT    30
+#define AUDIO_MANAGER_TTS_WRITE_TIMEOUT_MS   1000   ///< TTS 缓冲区满时写入最多等待的时长（流式回复靠它限速）
+#define AUDIO_MANAGER_PROMPT_WRITE_TIMEOUT_MS 1000  ///< 提示音 / 告警音缓冲区满时写入最多等待的时长
 #define AUDIO_MANAGER_REFERENCE_BUFFER_BYTES (16 * 1024)
 
+#define AUDIO_MANAGER_MAX_COMMAND_WORDS      32
+
 // ============ 状态机定义 ============
 
 typedef enum {
@@ -54,6 +62,9 @@ typedef enum {
     AUDIO_MGR_EVENT_WAKEUP_TIMEOUT,     ///< 唤醒超时（无人说话）
     AUDIO_MGR_EVENT_BUTTON_TRIGGER,     ///< 按键手动触发（按下）
     AUDIO_MGR_EVENT_BUTTON_RELEASE,     ///< 按键松开（新增）
+    AUDIO_MGR_EVENT_WAKEWORD_READY,     ///< 唤醒词模型后台加载完成
+    AUDIO_MGR_EVENT_AFE_PRESSURE,       ///< AFE 内部缓冲积压进入/解除（见 AFE_PRESSURE_*_PCT）
+    AUDIO_MGR_EVENT_COMMAND_DETECTED,   ///< 本地命令词识别到（本轮录音已结束，不应再提交云端）
 } audio_mgr_event_type_t;
 
 /** 音频管理器事件数据 */
@@ -64,6 +75,15 @@ typedef struct {
             int wake_word_index;        ///< 唤醒词索引
             float volume_db;            ///< 音量(dB)
         } wakeup;
+        struct {
+            bool active;                ///< true 进入积压，false 解除
+            uint8_t fill_pct;           ///< 触发时的填充率（%）
+        } pressure;
+        struct {
+            int command_id;             ///< 命令 ID（audio_mgr_command_word_t.id）
+            float prob;                 ///< 识别置信度
+            int64_t detect_us;          ///< AFE fetch 任务中识别完成的时刻（esp_timer_get_time）
+        } command;
     } data;
 } audio_mgr_event_t;
 
@@ -92,6 +112,21 @@ typedef struct {
     int wakeup_end_delay_ms;        ///< 说话结束后延迟多久结束唤醒
 } audio_mgr_wakeup_config_t;
 
+/** 命令词（应用层提供） */
+typedef struct {
+    int id;                         ///< 命令 ID，同一 ID 可以有多个说法
+    const char *phrase;             ///< 中文模型为空格分隔的拼音（如 "ting zhi jiao shui"）
+} audio_mgr_command_word_t;
+
+/** 本地命令词配置（esp-sr MultiNet，模型与唤醒词在同一分区） */
+typedef struct {
+    bool enabled;                   ///< 是否加载 MultiNet
+    const char *language;           ///< "cn" / "en"
+    int timeout_ms;                 ///< 录音开始后多久没说出命令词即停止本地识别
+    const audio_mgr_command_word_t *words;  ///< 命令表（初始化时复制条目，phrase 须长期有效；最多 AUDIO_MANAGER_MAX_COMMAND_WORDS 条）
+    size_t word_count;
+} audio_mgr_command_config_t;
+
 /** VAD配置（应用层提供） */
 typedef struct {
     bool enabled;                   ///< 是否启用VAD
@@ -112,6 +147,7 @@ typedef struct {
 typedef struct {
     audio_mgr_hw_config_t      hw_config;       ///< 硬件配置
     audio_mgr_wakeup_config_t  wakeup_config;   ///< 唤醒词配置
+    audio_mgr_command_config_t command_config;  ///< 本地命令词配置
     audio_mgr_vad_config_t     vad_config;      ///< VAD配置
     audio_mgr_afe_config_t     afe_config;      ///< AFE配置
     audio_mgr_event_cb_t       event_callback;  ///< 事件回调
@@ -144,6 +180,15 @@ typedef struct {
         .wakeup_end_delay_ms = 1200,                                 \
     }
 
+#define AUDIO_MANAGER_DEFAULT_COMMAND_CONFIG()                       \
+    (audio_mgr_command_config_t){                                    \
+        .enabled = false,                                            \
+        .language = "cn",                                            \
+        .timeout_ms = 6000,                                          \
+        .words = NULL,                                               \
+        .word_count = 0,                                             \
+    }
+
 #define AUDIO_MANAGER_DEFAULT_VAD_CONFIG()                           \
     (audio_mgr_vad_config_t){                                        \
         .enabled = true,                                             \
@@ -164,6 +209,7 @@ typedef struct {
     (audio_mgr_config_t){                                            \
         .hw_config = AUDIO_MANAGER_DEFAULT_HW_CONFIG(),              \
         .wakeup_config = AUDIO_MANAGER_DEFAULT_WAKEUP_CONFIG(),      \
+        .command_config = AUDIO_MANAGER_DEFAULT_COMMAND_CONFIG(),    \
         .vad_config = AUDIO_MANAGER_DEFAULT_VAD_CONFIG(),            \
         .afe_config = AUDIO_MANAGER_DEFAULT_AFE_CONFIG(),            \
         .event_callback = NULL,                                      \
@@ -219,12 +265,25 @@ esp_err_t audio_manager_stop_recording(void);
 
 /**
  * @brief 播放音频数据（播放器接口）
+ * @note 缓冲区满时阻塞等待播放消耗，最多 AUDIO_MANAGER_TTS_WRITE_TIMEOUT_MS
  * @param pcm_data PCM数据（16bit, 16kHz, 单声道）
  * @param sample_count 采样点数
- * @return ESP_OK 成功
+ * @return ESP_OK 成功，ESP_ERR_TIMEOUT 等待超时、剩余数据已丢弃
  */
 esp_err_t audio_manager_play_audio(const int16_t *pcm_data, size_t sample_count);
 
+/**
+ * @brief 播放音频数据到指定混音输入源
+ * @note 提示音/告警音与 TTS 实时混音，不会打断或排队在 TTS 之后
+ * @note 输入源缓冲区满时阻塞等待播放消耗（不覆盖已缓冲的数据），超时丢弃剩余部分
+ * @param source 输入源（PLAYBACK_SOURCE_TTS 等价于 audio_manager_play_audio）
+ * @param pcm_data PCM数据（16bit, 16kHz, 单声道）
+ * @param sample_count 采样点数
+ * @return ESP_OK 成功，ESP_ERR_TIMEOUT 等待超时、剩余数据已丢弃
+ */
+esp_err_t audio_manager_play_audio_source(playback_source_t source,
+                                          const int16_t *pcm_data, size_t sample_count);
+
 /**
  * @brief 获取播放缓冲区可用空间（样本数）
  * 
@@ -253,6 +312,28 @@ esp_err_t audio_manager_stop_playback(void);
  */
 esp_err_t audio_manager_clear_playback_buffer(void);
 
+/**
+ * @brief 清空指定混音输入源（不影响其他输入源播放）
+ * @param source 输入源
+ * @return ESP_OK 成功
+ */
+esp_err_t audio_manager_clear_playback_source(playback_source_t source);
+
+/**
+ * @brief 设置混音输入源音量
+ * @param source 输入源
+ * @param volume 音量 (0-100)，在主音量之前生效
+ * @return ESP_OK 成功
+ */
+esp_err_t audio_manager_set_source_volume(playback_source_t source, uint8_t volume);
+
+/**
+ * @brief 获取混音器统计（各输入源欠载/溢出次数、混音耗时）
+ * @param stats 输出统计
+ * @return ESP_OK 成功
+ */
+esp_err_t audio_manager_get_mixer_stats(playback_mixer_stats_t *stats);
+
 /**
  * @brief 设置音量
  * @param volume 音量 (0-100)
@@ -285,6 +366,18 @@ esp_err_t audio_manager_get_wakeup_config(audio_mgr_wakeup_config_t *config);
  */
 bool audio_manager_is_running(void);
 
+/**
+ * @brief 唤醒词/VAD 模型是否已加载完成
+ * @note 模型在后台加载，加载完成前仅按键录音可用
+ */
+bool audio_manager_is_wakeword_ready(void);
+
+/**
+ * @brief 本地命令词可用的条数
+ * @note 模型加载完成前、未启用或模型分区中没有 MultiNet 时为 0
+ */
+int audio_manager_get_command_count(void);
+
 /**
  * @brief 检查是否正在录音
  * @return true 录音中
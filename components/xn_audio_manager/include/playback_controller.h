@@ -4,7 +4,7 @@
  * @LastEditors: xingnian jixingnian@gmail.com
  * @LastEditTime: 2025-11-28 21:15:25
  * @FilePath: \xn_esp32_audio\components\xn_audio_manager\include\playback_controller.h
- * @Description: 播放控制模块 - 管理音频播放任务和缓冲区
+ * @Description: 播放控制模块 - 管理音频播放任务、多输入源混音和缓冲区
  * 
  * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved. 
  */
@@ -26,12 +26,51 @@ typedef struct playback_controller_s *playback_controller_handle_t;
 /** 回采数据回调函数类型 */
 typedef void (*playback_reference_callback_t)(const int16_t *samples, size_t count, void *user_ctx);
 
+/** 混音输入源（数值越大优先级越高） */
+typedef enum {
+    PLAYBACK_SOURCE_TTS = 0,    ///< 云端对话 TTS（流式，容量大）
+    PLAYBACK_SOURCE_PROMPT,     ///< 本地提示音（叠加播放，压低 TTS）
+    PLAYBACK_SOURCE_ALERT,      ///< 本地告警音（抢占，暂停低优先级输入）
+    PLAYBACK_SOURCE_MAX,
+} playback_source_t;
+
+/** Q15 定点增益：32767 ≈ 1.0 */
+#define PLAYBACK_GAIN_UNITY      32767
+
+/** 单个输入源配置 */
+typedef struct {
+    size_t buffer_samples;      ///< 输入源缓冲区大小（采样点数）
+    int16_t gain_q15;           ///< 输入源增益（Q15）
+    int16_t duck_q15;           ///< 本源有数据时，低优先级输入源的增益系数（Q15）
+    bool preempt;               ///< 本源有数据时暂停低优先级输入源（数据保留，结束后继续播放）
+    uint32_t write_timeout_ms;  ///< 缓冲区满时写入最多等待的时长（毫秒），超时丢弃未写入的部分，从不覆盖已缓冲的数据
+} playback_source_config_t;
+
+/** 单个输入源统计 */
+typedef struct {
+    uint32_t underruns;         ///< 播放中途数据不足一帧的次数（含流结尾）
+    uint32_t frames;            ///< 参与混音的帧数
+    uint64_t samples;           ///< 已混音的采样点数
+    uint32_t overflows;         ///< 写入等待空间超时、丢弃了数据的次数
+    uint32_t dropped_samples;   ///< 写入超时丢弃的采样点数
+} playback_source_stats_t;
+
+/** 混音器统计 */
+typedef struct {
+    playback_source_stats_t sources[PLAYBACK_SOURCE_MAX];
+    uint32_t mixed_frames;      ///< 输出帧数
+    uint32_t mix_time_avg_us;   ///< 平均每帧混音耗时（微秒）
+    uint32_t mix_time_max_us;   ///< 最大每帧混音耗时（微秒）
+    uint32_t mix_cpu_permille;  ///< 混音耗时占音频时长的千分比
+} playback_mixer_stats_t;
+
 /** 播放控制器配置 */
 typedef struct {
     audio_bsp_handle_t bsp_handle;                  ///< 音频 BSP 句柄（抽象硬件）
-    size_t playback_buffer_samples;                  ///< 播放缓冲区大小（采样点数）
+    playback_source_config_t sources[PLAYBACK_SOURCE_MAX]; ///< 各输入源配置
     size_t reference_buffer_samples;                 ///< 回采缓冲区大小（采样点数）
     size_t frame_samples;                            ///< 每帧采样点数
+    int sample_rate;                                 ///< 采样率（用于统计 CPU 占比）
     playback_reference_callback_t reference_callback; ///< 回采数据回调（可选，用于AFE）
     void *reference_ctx;                             ///< 回采回调上下文
     uint8_t *volume_ptr;                             ///< 音量指针（外部管理）
@@ -65,17 +104,59 @@ esp_err_t playback_controller_start(playback_controller_handle_t controller);
 esp_err_t playback_controller_stop(playback_controller_handle_t controller);
 
 /**
- * @brief 写入音频数据到播放缓冲区
+ * @brief 写入音频数据到 TTS 输入源
  * @param controller 播放控制器句柄
  * @param pcm_data PCM 数据（16bit, 单声道）
  * @param sample_count 采样点数
- * @return ESP_OK 成功
+ * @return ESP_OK 成功，ESP_ERR_TIMEOUT 等待空间超时、未写入的部分已丢弃
+ * @note 缓冲区满时阻塞等待播放任务消耗数据，最多等待该输入源的 write_timeout_ms
  */
 esp_err_t playback_controller_write(playback_controller_handle_t controller, 
                                      const int16_t *pcm_data, size_t sample_count);
 
 /**
- * @brief 清空播放缓冲区
+ * @brief 写入音频数据到指定输入源
+ * @param controller 播放控制器句柄
+ * @param source 输入源
+ * @param pcm_data PCM 数据（16bit, 单声道）
+ * @param sample_count 采样点数
+ * @return ESP_OK 成功，ESP_ERR_TIMEOUT 等待空间超时、未写入的部分已丢弃
+ * @note 缓冲区满时阻塞等待播放任务消耗数据，最多等待该输入源的 write_timeout_ms
+ */
+esp_err_t playback_controller_write_source(playback_controller_handle_t controller,
+                                            playback_source_t source,
+                                            const int16_t *pcm_data, size_t sample_count);
+
+/**
+ * @brief 清空指定输入源（不影响其他输入源）
+ * @param controller 播放控制器句柄
+ * @param source 输入源
+ * @return ESP_OK 成功
+ */
+esp_err_t playback_controller_clear_source(playback_controller_handle_t controller,
+                                            playback_source_t source);
+
+/**
+ * @brief 设置输入源增益
+ * @param controller 播放控制器句柄
+ * @param source 输入源
+ * @param gain_q15 增益（Q15，PLAYBACK_GAIN_UNITY 为原始音量）
+ * @return ESP_OK 成功
+ */
+esp_err_t playback_controller_set_source_gain(playback_controller_handle_t controller,
+                                               playback_source_t source, int16_t gain_q15);
+
+/**
+ * @brief 获取混音器统计
+ * @param controller 播放控制器句柄
+ * @param stats 输出统计
+ * @return ESP_OK 成功
+ */
+esp_err_t playback_controller_get_stats(playback_controller_handle_t controller,
+                                         playback_mixer_stats_t *stats);
+
+/**
+ * @brief 清空所有输入源和回采缓冲区
  * @param controller 播放控制器句柄
  * @return ESP_OK 成功
  */
@@ -89,7 +170,7 @@ esp_err_t playback_controller_clear(playback_controller_handle_t controller);
 bool playback_controller_is_running(playback_controller_handle_t controller);
 
 /**
- * @brief 获取播放缓冲区可用空间（样本数）
+ * @brief 获取 TTS 输入源可用空间（样本数）
  * @param controller 播放控制器句柄
  * @return 可用空间（样本数），用于流控
  */
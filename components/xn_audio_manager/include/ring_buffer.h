@@ -11,6 +11,7 @@
 #pragma once
 
 #include "esp_err.h"
+#include "audio_health.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include <stdint.h>
@@ -47,6 +48,17 @@ void ring_buffer_destroy(ring_buffer_handle_t rb);
  */
 size_t ring_buffer_write(ring_buffer_handle_t rb, const int16_t *data, size_t samples);
 
+/**
+ * @brief 等待空间写入数据（不覆盖旧数据）
+ * @param rb 环形缓冲区句柄
+ * @param data 数据指针
+ * @param samples 采样点数
+ * @param timeout_ms 最多等待空间的总时长（毫秒），0表示只写入当前空闲部分
+ * @return 实际写入的采样点数，超时时小于 samples，未写入的部分由调用方处理
+ */
+size_t ring_buffer_write_wait(ring_buffer_handle_t rb, const int16_t *data, size_t samples,
+                              uint32_t timeout_ms);
+
 /**
  * @brief 从环形缓冲区读取数据
  * @param rb 环形缓冲区句柄
@@ -71,6 +83,13 @@ size_t ring_buffer_available(ring_buffer_handle_t rb);
  */
 esp_err_t ring_buffer_clear(ring_buffer_handle_t rb);
 
+/**
+ * @brief 绑定溢出计数项：写入覆盖旧数据时把丢弃的采样点数累加到该计数项
+ * @param rb 环形缓冲区句柄
+ * @param id 健康计数项
+ */
+void ring_buffer_set_overrun_counter(ring_buffer_handle_t rb, audio_health_counter_t id);
+
 /**
  * @brief 获取环形缓冲区的容量
  * @param rb 环形缓冲区句柄
@@ -9,17 +9,31 @@
  * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved. 
  */
 #include "afe_wrapper.h"
+#include "audio_health.h"
 #include "esp_log.h"
 #include "esp_gmf_afe_manager.h"
 #include "esp_afe_sr_models.h"
 #include "esp_afe_sr_iface.h"
 #include "esp_afe_config.h"
+#include "esp_mn_iface.h"
+#include "esp_mn_models.h"
+#include "esp_mn_speech_commands.h"
 #include "model_path.h"
+#include "esp_partition.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "AFE_WRAPPER";
 
+#define AFE_LOAD_TASK_STACK      (8 * 1024)   ///< 模型加载任务栈（涉及 Flash 映射，放内部RAM）
+#define AFE_LOAD_TASK_PRIORITY   3            ///< 低于 UI/网络任务，只吃空闲 CPU
+#define AFE_BYPASS_TASK_STACK    (3 * 1024)   ///< 麦克风直通任务栈
+#define AFE_BYPASS_FRAME_SAMPLES 256          ///< 直通每次读取采样点数（16ms @16kHz）
+
 /**
  * @brief AFE 包装器上下文结构体
  * 
@@ -41,6 +55,23 @@ typedef struct afe_wrapper_s {
     
     bool *running_ptr;                          ///< 指向运行状态标志的指针
     bool *recording_ptr;                        ///< 指向录音状态标志的指针
+
+    afe_wrapper_config_t config;                ///< 创建参数副本（供后台加载任务使用）
+    TaskHandle_t load_task;                     ///< 模型加载任务（完成后置 NULL）
+    TaskHandle_t bypass_task;                   ///< 麦克风直通任务（停止后置 NULL）
+    volatile bool bypass_stop;                  ///< 请求直通任务退出
+    volatile bool ready;                        ///< 模型与 AFE 已就绪
+    bool pressure;                              ///< AFE 内部缓冲处于积压状态（只在 fetch 任务中读写）
+    afe_wrapper_load_stats_t load_stats;        ///< 模型加载统计
+
+    // 命令词（MultiNet，只在 fetch 任务中识别）
+    esp_mn_iface_t *multinet;                   ///< MultiNet 接口，NULL 表示命令词不可用
+    model_iface_data_t *mn_data;                ///< MultiNet 实例
+    int16_t *mn_buf;                            ///< 凑满一个 MultiNet 帧再识别
+    int mn_chunk;                               ///< MultiNet 每帧采样点数
+    int mn_fill;                                ///< mn_buf 已填充采样点数
+    bool mn_active;                             ///< 本轮录音内正在识别命令词
+    bool mn_last_recording;                     ///< 上一帧的录音状态（上升沿开始识别）
     
     // 静态缓冲区（避免频繁 malloc）
     int16_t mic_buffer[512];                    ///< 麦克风数据缓冲区
@@ -94,6 +125,7 @@ static int32_t afe_read_callback(void *buffer, int buf_sz, void *user_ctx, TickT
 
         // 如果回采数据不足，用静音填充
         if (ref_got < mic_got) {
+            audio_health_add(AUDIO_HEALTH_REF_UNDERFLOWS, 1);
             memset(wrapper->ref_buffer + ref_got, 0, (mic_got - ref_got) * sizeof(int16_t));
         }
 
@@ -111,10 +143,81 @@ static int32_t afe_read_callback(void *buffer, int buf_sz, void *user_ctx, TickT
     return mic_got * channels * sizeof(int16_t);
 }
 
+/**
+ * @brief 结束本轮命令词识别，清空 MultiNet 内部状态
+ */
+static void afe_command_reset(afe_wrapper_t *wrapper)
+{
+    wrapper->mn_active = false;
+    wrapper->mn_fill = 0;
+    wrapper->multinet->clean(wrapper->mn_data);
+}
+
+/**
+ * @brief 命令词识别（在 fetch 任务中逐帧调用）
+ * 
+ * 录音开始（唤醒词或按键）时开始识别，录音结束、识别到命令或 MultiNet 超时后停止。
+ * AFE 输出帧与 MultiNet 帧长度不同时先拼帧，识别结果在凑满的那一帧内同步得出。
+ * 
+ * @param wrapper AFE 包装器
+ * @param data AFE 输出（单声道 16 bit）
+ * @param samples 采样点数
+ */
+static void afe_command_feed(afe_wrapper_t *wrapper, const int16_t *data, size_t samples)
+{
+    bool recording = wrapper->recording_ptr && *wrapper->recording_ptr;
+
+    if (recording && !wrapper->mn_last_recording) {
+        afe_command_reset(wrapper);
+        wrapper->mn_active = true;
+    } else if (!recording && wrapper->mn_active) {
+        afe_command_reset(wrapper);
+    }
+    wrapper->mn_last_recording = recording;
+
+    while (wrapper->mn_active && data && samples > 0) {
+        size_t n = (size_t)(wrapper->mn_chunk - wrapper->mn_fill);
+        if (n > samples) {
+            n = samples;
+        }
+        memcpy(wrapper->mn_buf + wrapper->mn_fill, data, n * sizeof(int16_t));
+        wrapper->mn_fill += (int)n;
+        data += n;
+        samples -= n;
+
+        if (wrapper->mn_fill < wrapper->mn_chunk) {
+            break;
+        }
+        wrapper->mn_fill = 0;
+
+        esp_mn_state_t state = wrapper->multinet->detect(wrapper->mn_data, wrapper->mn_buf);
+        if (state == ESP_MN_STATE_DETECTED) {
+            esp_mn_results_t *res = wrapper->multinet->get_results(wrapper->mn_data);
+            if (res && res->num > 0) {
+                afe_event_t event = {
+                    .type = AFE_EVENT_COMMAND_DETECTED,
+                    .data.command = {
+                        .command_id = res->command_id[0],
+                        .prob = res->prob[0],
+                        .detect_us = esp_timer_get_time(),
+                    },
+                };
+                ESP_LOGI(TAG, "🗣️ 命令词: id=%d \"%s\" 置信度 %.2f",
+                         res->command_id[0], res->string, res->prob[0]);
+                wrapper->event_callback(&event, wrapper->event_ctx);
+            }
+            afe_command_reset(wrapper);
+        } else if (state == ESP_MN_STATE_TIMEOUT) {
+            ESP_LOGD(TAG, "命令词识别超时，交给云端对话");
+            afe_command_reset(wrapper);
+        }
+    }
+}
+
 /**
  * @brief AFE 结果回调函数
  * 
- * 处理 AFE 的处理结果，包括唤醒词检测、VAD 状态变化和录音数据
+ * 处理 AFE 的处理结果，包括唤醒词检测、命令词识别、VAD 状态变化和录音数据
  * 
  * @param result AFE 处理结果
  * @param user_ctx 用户上下文，指向 afe_wrapper_t 结构体
@@ -126,6 +229,27 @@ static void afe_result_callback(afe_fetch_result_t *result, void *user_ctx)
 
     afe_event_t event = {0};
 
+    // AFE 内部缓冲积压：ringbuff_free_pct 越小说明 fetch 越跟不上 feed
+    uint32_t fill_pct = (uint32_t)((1.0f - result->ringbuff_free_pct) * 100.0f);
+    audio_health_update_max(AUDIO_HEALTH_AFE_RING_FILL_MAX_PCT, fill_pct);
+    if (fill_pct > 50) {
+        audio_health_add(AUDIO_HEALTH_AFE_FETCH_LAG, 1);
+    }
+
+    // 积压状态只在跨过阈值时通知一次，上层据此让出 CPU（如冻结界面动画）
+    bool pressure = wrapper->pressure ? fill_pct >= AFE_PRESSURE_LEAVE_PCT : fill_pct >= AFE_PRESSURE_ENTER_PCT;
+    if (pressure != wrapper->pressure) {
+        wrapper->pressure = pressure;
+        afe_event_t pressure_event = {
+            .type = AFE_EVENT_PRESSURE,
+            .data.pressure = {
+                .active = pressure,
+                .fill_pct = (uint8_t)(fill_pct > 100 ? 100 : fill_pct),
+            },
+        };
+        wrapper->event_callback(&pressure_event, wrapper->event_ctx);
+    }
+
     // 处理唤醒词检测事件
     if (result->wakeup_state == WAKENET_DETECTED) {
         event.type = AFE_EVENT_WAKEUP_DETECTED;
@@ -138,6 +262,11 @@ static void afe_result_callback(afe_fetch_result_t *result, void *user_ctx)
         wrapper->event_callback(&event, wrapper->event_ctx);
     }
 
+    // 命令词先于 VAD 处理：同一帧内命令识别完成时不会再提交云端
+    if (wrapper->multinet) {
+        afe_command_feed(wrapper, (const int16_t *)result->data, result->data_size / sizeof(int16_t));
+    }
+
     // 处理 VAD（语音活动检测）状态变化
     static bool vad_active = false;
 
@@ -162,49 +291,161 @@ static void afe_result_callback(afe_fetch_result_t *result, void *user_ctx)
 }
 
 /**
- * @brief 创建 AFE 包装器
+ * @brief 麦克风直通任务
  * 
- * 初始化 AFE Manager，加载唤醒词模型，配置各种音频处理功能
+ * 模型加载完成前 AFE 尚不存在，按键触发的录音直接把原始麦克风数据交给录音回调，
+ * 保证开机后按键立即可用（此阶段无 AEC/NS 处理）。
  * 
- * @param config AFE 包装器配置
- * @return afe_wrapper_handle_t AFE 包装器句柄，失败返回 NULL
+ * @param arg 指向 afe_wrapper_t 结构体
  */
-afe_wrapper_handle_t afe_wrapper_create(const afe_wrapper_config_t *config)
+static void afe_bypass_task(void *arg)
 {
-    if (!config || !config->bsp_handle || !config->reference_rb || !config->event_callback) {
-        ESP_LOGE(TAG, "无效的配置参数");
-        return NULL;
+    afe_wrapper_t *wrapper = (afe_wrapper_t *)arg;
+
+    while (!wrapper->bypass_stop) {
+        bool running = wrapper->running_ptr && *wrapper->running_ptr;
+        bool recording = wrapper->recording_ptr && *wrapper->recording_ptr;
+
+        if (!running || !recording || !wrapper->record_callback) {
+            vTaskDelay(pdMS_TO_TICKS(20));
+            continue;
+        }
+
+        size_t got = 0;
+        esp_err_t ret = audio_bsp_read_mic(wrapper->bsp_handle, wrapper->mic_buffer,
+                                           AFE_BYPASS_FRAME_SAMPLES, &got);
+        if (ret == ESP_OK && got > 0) {
+            wrapper->record_callback(wrapper->mic_buffer, got, wrapper->record_ctx);
+        }
     }
 
-    // 分配包装器上下文内存
-    afe_wrapper_t *wrapper = (afe_wrapper_t *)calloc(1, sizeof(afe_wrapper_t));
-    if (!wrapper) {
-        ESP_LOGE(TAG, "AFE 包装器分配失败");
-        return NULL;
+    wrapper->bypass_task = NULL;
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 停止麦克风直通任务并等待其退出
+ * 
+ * AFE Feed 任务与直通任务都读取 I2S RX，二者不能同时运行。
+ * 
+ * @param wrapper AFE 包装器
+ */
+static void afe_bypass_stop(afe_wrapper_t *wrapper)
+{
+    wrapper->bypass_stop = true;
+    while (wrapper->bypass_task) {
+        vTaskDelay(pdMS_TO_TICKS(10));
     }
+}
 
-    // 保存配置参数
-    wrapper->bsp_handle = config->bsp_handle;
-    wrapper->reference_rb = config->reference_rb;
-    wrapper->wakeup_config = config->wakeup_config;
-    wrapper->event_callback = config->event_callback;
-    wrapper->event_ctx = config->event_ctx;
-    wrapper->record_callback = config->record_callback;
-    wrapper->record_ctx = config->record_ctx;
-    wrapper->running_ptr = config->running_ptr;
-    wrapper->recording_ptr = config->recording_ptr;
+/**
+ * @brief 从已映射的模型分区创建 MultiNet 并编译命令表
+ * 
+ * 失败不影响唤醒词与云端对话，只是命令词不可用。
+ * 
+ * @param wrapper AFE 包装器（models 已加载）
+ * @return ESP_OK 成功
+ */
+static esp_err_t afe_wrapper_load_commands(afe_wrapper_t *wrapper)
+{
+    const afe_command_config_t *cfg = &wrapper->config.command_config;
+    const char *lang = cfg->language ? cfg->language : ESP_MN_CHINESE;
+
+    if (!cfg->words || cfg->word_count == 0) {
+        ESP_LOGW(TAG, "命令表为空，不加载 MultiNet");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char *mn_name = esp_srmodel_filter(wrapper->models, ESP_MN_PREFIX, (char *)lang);
+    if (!mn_name) {
+        ESP_LOGW(TAG, "模型分区中没有 MultiNet 模型（%s），命令词不可用", lang);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_mn_iface_t *multinet = esp_mn_handle_from_name(mn_name);
+    model_iface_data_t *mn_data = multinet ? multinet->create(mn_name, cfg->timeout_ms) : NULL;
+    if (!mn_data) {
+        ESP_LOGE(TAG, "MultiNet 创建失败: %s", mn_name);
+        return ESP_FAIL;
+    }
+
+    int count = 0;
+    esp_mn_commands_alloc(multinet, mn_data);
+    esp_mn_commands_clear();
+    for (size_t i = 0; i < cfg->word_count; i++) {
+        if (esp_mn_commands_add(cfg->words[i].id, cfg->words[i].phrase) == ESP_OK) {
+            count++;
+        } else {
+            ESP_LOGW(TAG, "命令词添加失败: %s", cfg->words[i].phrase);
+        }
+    }
+
+    esp_mn_error_t *err = esp_mn_commands_update();
+    if (err) {
+        for (int i = 0; i < err->num; i++) {
+            ESP_LOGW(TAG, "命令词无法识别: %s", err->phrases[i]->string);
+        }
+        count -= err->num;
+    }
 
-    // 加载唤醒词模型
-    if (config->wakeup_config.enabled) {
+    int chunk = multinet->get_samp_chunksize(mn_data);
+    int16_t *buf = chunk > 0 ? heap_caps_malloc(chunk * sizeof(int16_t), MALLOC_CAP_INTERNAL) : NULL;
+    if (count <= 0 || !buf) {
+        ESP_LOGE(TAG, "命令表不可用（有效 %d 条）", count);
+        free(buf);
+        esp_mn_commands_free();
+        multinet->destroy(mn_data);
+        return ESP_FAIL;
+    }
+
+    wrapper->multinet = multinet;
+    wrapper->mn_data = mn_data;
+    wrapper->mn_buf = buf;
+    wrapper->mn_chunk = chunk;
+    wrapper->load_stats.command_count = count;
+
+    ESP_LOGI(TAG, "✅ 命令词就绪: %s, %d 条, 每帧 %d 点", mn_name, count, chunk);
+    return ESP_OK;
+}
+
+/**
+ * @brief 加载唤醒词/VAD 模型并创建 AFE 实例
+ * 
+ * 模型分区通过 esp_partition_mmap 直接映射（CONFIG_MODEL_IN_FLASH），
+ * 不经过文件系统，也不把模型数据拷贝到 PSRAM。
+ * 
+ * @param wrapper AFE 包装器
+ * @return ESP_OK 成功
+ */
+static esp_err_t afe_wrapper_load(afe_wrapper_t *wrapper)
+{
+    const afe_wrapper_config_t *config = &wrapper->config;
+    int64_t t_start = esp_timer_get_time();
+    size_t psram_before = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+
+    // 加载唤醒词 / 命令词模型（同一分区）
+    if (config->wakeup_config.enabled || config->command_config.enabled) {
         ESP_LOGI(TAG, "加载唤醒词模型: %s", config->wakeup_config.wake_word_name);
         wrapper->models = esp_srmodel_init(config->wakeup_config.model_partition);
         if (!wrapper->models) {
             ESP_LOGE(TAG, "模型加载失败");
-            free(wrapper);
-            return NULL;
+            return ESP_FAIL;
         }
         ESP_LOGI(TAG, "✅ 加载了 %d 个模型", wrapper->models->num);
+
+        const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                               ESP_PARTITION_SUBTYPE_ANY,
+                                                               config->wakeup_config.model_partition);
+        wrapper->load_stats.mapped_bytes = part ? part->size : 0;
+        wrapper->load_stats.model_count = wrapper->models->num;
+    }
+    int64_t t_mapped = esp_timer_get_time();
+
+    // 命令词：加载失败只关闭本地命令，不影响唤醒词和云端对话
+    if (config->command_config.enabled && wrapper->models) {
+        (void)afe_wrapper_load_commands(wrapper);
     }
+    int64_t t_commands = esp_timer_get_time();
 
     // 配置 AFE
     ESP_LOGI(TAG, "配置 AFE Manager...");
@@ -212,9 +453,7 @@ afe_wrapper_handle_t afe_wrapper_create(const afe_wrapper_config_t *config)
                                                 config->feature_config.afe_mode);
     if (!afe_config) {
         ESP_LOGE(TAG, "AFE 配置失败");
-        if (wrapper->models) esp_srmodel_deinit(wrapper->models);
-        free(wrapper);
-        return NULL;
+        return ESP_FAIL;
     }
 
     // 配置音频处理功能
@@ -254,27 +493,141 @@ afe_wrapper_handle_t afe_wrapper_create(const afe_wrapper_config_t *config)
         },
     };
 
+    // Feed 任务启动后接管 I2S RX，先停掉直通
+    afe_bypass_stop(wrapper);
+
     esp_err_t ret = esp_gmf_afe_manager_create(&mgr_cfg, &wrapper->afe_manager);
     afe_config_free(afe_config);
 
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "AFE Manager 创建失败");
-        if (wrapper->models) esp_srmodel_deinit(wrapper->models);
-        free(wrapper);
-        return NULL;
+        return ret;
     }
 
     // 设置结果回调
     esp_gmf_afe_manager_set_result_cb(wrapper->afe_manager, afe_result_callback, wrapper);
 
-    ESP_LOGI(TAG, "✅ AFE 包装器创建成功");
+    int64_t t_done = esp_timer_get_time();
+    size_t psram_after = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+
+    wrapper->load_stats.map_ms = (uint32_t)((t_mapped - t_start) / 1000);
+    wrapper->load_stats.command_ms = (uint32_t)((t_commands - t_mapped) / 1000);
+    wrapper->load_stats.afe_ms = (uint32_t)((t_done - t_commands) / 1000);
+    wrapper->load_stats.total_ms = (uint32_t)((t_done - t_start) / 1000);
+    wrapper->load_stats.psram_used_bytes = psram_before > psram_after ? psram_before - psram_after : 0;
+
+    return ESP_OK;
+}
+
+/**
+ * @brief 模型后台加载任务
+ * 
+ * 加载完成后发送 AFE_EVENT_MODEL_READY；失败时保持麦克风直通，按键录音仍可用。
+ * 
+ * @param arg 指向 afe_wrapper_t 结构体
+ */
+static void afe_load_task(void *arg)
+{
+    afe_wrapper_t *wrapper = (afe_wrapper_t *)arg;
+
+    if (afe_wrapper_load(wrapper) == ESP_OK) {
+        const afe_wrapper_load_stats_t *st = &wrapper->load_stats;
+        ESP_LOGI(TAG, "✅ AFE 就绪: 模型映射 %u ms, 命令词 %u ms, AFE 创建 %u ms, 总计 %u ms",
+                 (unsigned)st->map_ms, (unsigned)st->command_ms, (unsigned)st->afe_ms,
+                 (unsigned)st->total_ms);
+        ESP_LOGI(TAG, "📦 模型分区 %u KB 直接映射, PSRAM 占用 %u KB, 节省约 %u KB",
+                 (unsigned)(st->mapped_bytes / 1024),
+                 (unsigned)(st->psram_used_bytes / 1024),
+                 (unsigned)(st->mapped_bytes > st->psram_used_bytes
+                            ? (st->mapped_bytes - st->psram_used_bytes) / 1024 : 0));
+
+        wrapper->ready = true;
+        if (wrapper->event_callback) {
+            afe_event_t event = { .type = AFE_EVENT_MODEL_READY };
+            wrapper->event_callback(&event, wrapper->event_ctx);
+        }
+    } else {
+        ESP_LOGE(TAG, "AFE 加载失败，保持麦克风直通（仅按键录音可用）");
+        if (wrapper->mn_data) {
+            esp_mn_commands_free();
+            wrapper->multinet->destroy(wrapper->mn_data);
+            wrapper->mn_data = NULL;
+            wrapper->multinet = NULL;
+        }
+        free(wrapper->mn_buf);
+        wrapper->mn_buf = NULL;
+        if (wrapper->models) {
+            esp_srmodel_deinit(wrapper->models);
+            wrapper->models = NULL;
+        }
+        if (!wrapper->bypass_task) {
+            wrapper->bypass_stop = false;
+            xTaskCreate(afe_bypass_task, "afe_bypass", AFE_BYPASS_TASK_STACK,
+                        wrapper, AFE_LOAD_TASK_PRIORITY + 2, &wrapper->bypass_task);
+        }
+    }
+
+    wrapper->load_task = NULL;
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 创建 AFE 包装器
+ * 
+ * 只启动麦克风直通和模型后台加载任务，立即返回，不阻塞开机流程
+ * 
+ * @param config AFE 包装器配置
+ * @return afe_wrapper_handle_t AFE 包装器句柄，失败返回 NULL
+ */
+afe_wrapper_handle_t afe_wrapper_create(const afe_wrapper_config_t *config)
+{
+    if (!config || !config->bsp_handle || !config->reference_rb || !config->event_callback) {
+        ESP_LOGE(TAG, "无效的配置参数");
+        return NULL;
+    }
+
+    // 分配包装器上下文内存
+    afe_wrapper_t *wrapper = (afe_wrapper_t *)calloc(1, sizeof(afe_wrapper_t));
+    if (!wrapper) {
+        ESP_LOGE(TAG, "AFE 包装器分配失败");
+        return NULL;
+    }
+
+    // 保存配置参数
+    wrapper->config = *config;
+    wrapper->bsp_handle = config->bsp_handle;
+    wrapper->reference_rb = config->reference_rb;
+    wrapper->wakeup_config = config->wakeup_config;
+    wrapper->event_callback = config->event_callback;
+    wrapper->event_ctx = config->event_ctx;
+    wrapper->record_callback = config->record_callback;
+    wrapper->record_ctx = config->record_ctx;
+    wrapper->running_ptr = config->running_ptr;
+    wrapper->recording_ptr = config->recording_ptr;
+
+    if (xTaskCreate(afe_bypass_task, "afe_bypass", AFE_BYPASS_TASK_STACK,
+                    wrapper, AFE_LOAD_TASK_PRIORITY + 2, &wrapper->bypass_task) != pdPASS) {
+        ESP_LOGE(TAG, "麦克风直通任务创建失败");
+        free(wrapper);
+        return NULL;
+    }
+
+    if (xTaskCreate(afe_load_task, "afe_load", AFE_LOAD_TASK_STACK,
+                    wrapper, AFE_LOAD_TASK_PRIORITY, &wrapper->load_task) != pdPASS) {
+        ESP_LOGE(TAG, "模型加载任务创建失败");
+        afe_bypass_stop(wrapper);
+        free(wrapper);
+        return NULL;
+    }
+
+    ESP_LOGI(TAG, "✅ AFE 包装器创建成功（模型后台加载中）");
     return wrapper;
 }
 
 /**
  * @brief 销毁 AFE 包装器
  * 
- * 释放 AFE Manager 和模型资源
+ * 等待后台加载结束后释放 AFE Manager 和模型资源
  * 
  * @param wrapper AFE 包装器句柄
  */
@@ -282,11 +635,24 @@ void afe_wrapper_destroy(afe_wrapper_handle_t wrapper)
 {
     if (!wrapper) return;
 
+    // 模型加载不可中断，等待其结束
+    while (wrapper->load_task) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    afe_bypass_stop(wrapper);
+
     // 销毁 AFE Manager
     if (wrapper->afe_manager) {
         esp_gmf_afe_manager_destroy(wrapper->afe_manager);
     }
 
+    // 释放命令词资源（fetch 任务已随 AFE Manager 退出）
+    if (wrapper->mn_data) {
+        esp_mn_commands_free();
+        wrapper->multinet->destroy(wrapper->mn_data);
+    }
+    free(wrapper->mn_buf);
+
     // 释放模型资源
     if (wrapper->models) {
         esp_srmodel_deinit(wrapper->models);
@@ -297,6 +663,38 @@ void afe_wrapper_destroy(afe_wrapper_handle_t wrapper)
     ESP_LOGI(TAG, "AFE 包装器已销毁");
 }
 
+/**
+ * @brief 模型是否已加载完成
+ * 
+ * @param wrapper AFE 包装器句柄
+ * @return true 已就绪
+ */
+bool afe_wrapper_is_ready(afe_wrapper_handle_t wrapper)
+{
+    return wrapper && wrapper->ready;
+}
+
+/**
+ * @brief 获取模型加载统计
+ * 
+ * @param wrapper AFE 包装器句柄
+ * @param stats 用于返回统计的缓冲区
+ * @return esp_err_t ESP_OK 成功，ESP_ERR_INVALID_STATE 尚未加载完成
+ */
+esp_err_t afe_wrapper_get_load_stats(afe_wrapper_handle_t wrapper,
+                                     afe_wrapper_load_stats_t *stats)
+{
+    if (!wrapper || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!wrapper->ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *stats = wrapper->load_stats;
+    return ESP_OK;
+}
+
 /**
  * @brief 更新唤醒词配置
  * 
@@ -0,0 +1,186 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-02 15:40:12
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-02 15:40:12
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_audio_manager\src\audio_health.c
+ * @Description: 音频链路健康计数实现
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include "audio_health.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "AUDIO_HEALTH";
+
+#define AUDIO_HEALTH_TASK_STACK     (4 * 1024)
+#define AUDIO_HEALTH_TASK_PRIORITY  2
+
+// 计数块放在内部 RAM，ISR 中也能安全访问
+static DRAM_ATTR volatile uint32_t s_counters[AUDIO_HEALTH_MAX];
+
+static const char *const s_counter_names[AUDIO_HEALTH_MAX] = {
+    [AUDIO_HEALTH_I2S_TX_QUEUE_OVF]         = "i2s_tx_q_ovf",
+    [AUDIO_HEALTH_I2S_RX_QUEUE_OVF]         = "i2s_rx_q_ovf",
+    [AUDIO_HEALTH_I2S_PARTIAL_WRITES]       = "i2s_partial_wr",
+    [AUDIO_HEALTH_I2S_WRITE_ERRORS]         = "i2s_wr_err",
+    [AUDIO_HEALTH_I2S_READ_ERRORS]          = "i2s_rd_err",
+    [AUDIO_HEALTH_PLAYBACK_OVERFLOW_SAMPLES] = "play_ovf_smp",
+    [AUDIO_HEALTH_PLAYBACK_UNDERRUNS]       = "play_underrun",
+    [AUDIO_HEALTH_REF_OVERFLOW_SAMPLES]     = "ref_ovf_smp",
+    [AUDIO_HEALTH_REF_UNDERFLOWS]           = "ref_underflow",
+    [AUDIO_HEALTH_AFE_FETCH_LAG]            = "afe_lag",
+    [AUDIO_HEALTH_AFE_RING_FILL_MAX_PCT]    = "afe_fill_max",
+    [AUDIO_HEALTH_OPUS_DECODE_ERRORS]       = "opus_dec_err",
+    [AUDIO_HEALTH_UPLINK_OVERWRITE_BYTES]   = "uplink_ovw_b",
+};
+
+/** 周期发布任务上下文 */
+static struct {
+    TaskHandle_t task;
+    volatile bool running;
+    uint32_t period_ms;
+    audio_health_publish_cb_t cb;
+    void *user_ctx;
+    audio_health_sync_cb_t sync_cb;
+    void *sync_ctx;
+} s_pub = {0};
+
+static bool audio_health_is_gauge(audio_health_counter_t id)
+{
+    return id == AUDIO_HEALTH_AFE_RING_FILL_MAX_PCT;
+}
+
+void IRAM_ATTR audio_health_add(audio_health_counter_t id, uint32_t n)
+{
+    if ((unsigned)id >= AUDIO_HEALTH_MAX) {
+        return;
+    }
+    __atomic_fetch_add(&s_counters[id], n, __ATOMIC_RELAXED);
+}
+
+void IRAM_ATTR audio_health_update_max(audio_health_counter_t id, uint32_t value)
+{
+    if ((unsigned)id >= AUDIO_HEALTH_MAX) {
+        return;
+    }
+    uint32_t cur = __atomic_load_n(&s_counters[id], __ATOMIC_RELAXED);
+    while (value > cur &&
+           !__atomic_compare_exchange_n(&s_counters[id], &cur, value, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void audio_health_set(audio_health_counter_t id, uint32_t value)
+{
+    if ((unsigned)id >= AUDIO_HEALTH_MAX) {
+        return;
+    }
+    __atomic_store_n(&s_counters[id], value, __ATOMIC_RELAXED);
+}
+
+void audio_health_snapshot(audio_health_snapshot_t *snapshot)
+{
+    if (!snapshot) {
+        return;
+    }
+
+    snapshot->timestamp_ms = esp_timer_get_time() / 1000;
+    for (int i = 0; i < AUDIO_HEALTH_MAX; i++) {
+        snapshot->counters[i] = __atomic_load_n(&s_counters[i], __ATOMIC_RELAXED);
+    }
+}
+
+void audio_health_reset(void)
+{
+    for (int i = 0; i < AUDIO_HEALTH_MAX; i++) {
+        __atomic_store_n(&s_counters[i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+const char *audio_health_counter_name(audio_health_counter_t id)
+{
+    if ((unsigned)id >= AUDIO_HEALTH_MAX || !s_counter_names[id]) {
+        return "unknown";
+    }
+    return s_counter_names[id];
+}
+
+/**
+ * @brief 周期发布任务：每个周期生成累计快照和增量快照并交给回调
+ */
+static void audio_health_publish_task(void *arg)
+{
+    audio_health_snapshot_t last = {0};
+    audio_health_snapshot_t total = {0};
+    audio_health_snapshot_t delta = {0};
+
+    audio_health_snapshot(&last);
+
+    while (s_pub.running) {
+        vTaskDelay(pdMS_TO_TICKS(s_pub.period_ms));
+        if (!s_pub.running) {
+            break;
+        }
+
+        if (s_pub.sync_cb) {
+            s_pub.sync_cb(s_pub.sync_ctx);
+        }
+        audio_health_snapshot(&total);
+        delta.timestamp_ms = total.timestamp_ms - last.timestamp_ms;
+        for (int i = 0; i < AUDIO_HEALTH_MAX; i++) {
+            delta.counters[i] = audio_health_is_gauge((audio_health_counter_t)i)
+                                    ? total.counters[i]
+                                    : total.counters[i] - last.counters[i];
+        }
+        last = total;
+
+        if (s_pub.cb) {
+            s_pub.cb(&total, &delta, s_pub.user_ctx);
+        }
+    }
+
+    s_pub.task = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t audio_health_start_publisher(uint32_t period_ms, audio_health_publish_cb_t cb, void *user_ctx)
+{
+    if (period_ms == 0 || !cb) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_pub.task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_pub.period_ms = period_ms;
+    s_pub.cb = cb;
+    s_pub.user_ctx = user_ctx;
+    s_pub.running = true;
+
+    if (xTaskCreate(audio_health_publish_task, "audio_health", AUDIO_HEALTH_TASK_STACK,
+                    NULL, AUDIO_HEALTH_TASK_PRIORITY, &s_pub.task) != pdPASS) {
+        ESP_LOGE(TAG, "健康计数发布任务创建失败");
+        s_pub.running = false;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "健康计数发布已启动，周期 %u ms", (unsigned)period_ms);
+    return ESP_OK;
+}
+
+void audio_health_set_sync_hook(audio_health_sync_cb_t cb, void *user_ctx)
+{
+    s_pub.sync_ctx = user_ctx;
+    s_pub.sync_cb = cb;
+}
+
+void audio_health_stop_publisher(void)
+{
+    s_pub.running = false;
+}
@@ -14,6 +14,7 @@
 #include "button_handler.h"
 #include "afe_wrapper.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
@@ -30,6 +31,9 @@ typedef enum {
     AUDIO_INT_EVT_VAD_START,
     AUDIO_INT_EVT_VAD_END,
     AUDIO_INT_EVT_WAKE_TIMEOUT,
+    AUDIO_INT_EVT_MODEL_READY,
+    AUDIO_INT_EVT_AFE_PRESSURE,
+    AUDIO_INT_EVT_COMMAND,
 } audio_mgr_internal_event_t;
 
 typedef struct {
@@ -39,6 +43,15 @@ typedef struct {
             int   wake_word_index;
             float volume_db;
         } wakeup;
+        struct {
+            bool    active;
+            uint8_t fill_pct;
+        } pressure;
+        struct {
+            int     command_id;
+            float   prob;
+            int64_t detect_us;
+        } command;
     } data;
 } audio_mgr_internal_msg_t;
 
@@ -63,6 +76,9 @@ typedef struct {
     button_handler_handle_t button_handler; ///< 按键处理器句柄
     afe_wrapper_handle_t afe_wrapper;      ///< AFE 包装器句柄
     
+    // 命令表副本（AFE 包装器在模型加载任务中读取）
+    afe_command_word_t command_words[AUDIO_MANAGER_MAX_COMMAND_WORDS];
+
     // 共享缓冲区
     ring_buffer_handle_t reference_rb;     ///< 回采缓冲区句柄（播放控制器和 AFE 共享）
     
@@ -235,6 +251,23 @@ static void afe_event_handler(const afe_event_t *event, void *user_ctx)
         case AFE_EVENT_VAD_END:
             msg.type = AUDIO_INT_EVT_VAD_END;
             break;
+
+        case AFE_EVENT_MODEL_READY:
+            msg.type = AUDIO_INT_EVT_MODEL_READY;
+            break;
+
+        case AFE_EVENT_PRESSURE:
+            msg.type = AUDIO_INT_EVT_AFE_PRESSURE;
+            msg.data.pressure.active = event->data.pressure.active;
+            msg.data.pressure.fill_pct = event->data.pressure.fill_pct;
+            break;
+
+        case AFE_EVENT_COMMAND_DETECTED:
+            msg.type = AUDIO_INT_EVT_COMMAND;
+            msg.data.command.command_id = event->data.command.command_id;
+            msg.data.command.prob = event->data.command.prob;
+            msg.data.command.detect_us = event->data.command.detect_us;
+            break;
         default:
             return;
     }
@@ -355,6 +388,38 @@ static void audio_manager_handle_internal_event(const audio_mgr_internal_msg_t *
         audio_manager_clear_wake_timer();
         audio_manager_refresh_state();
         break;
+
+    case AUDIO_INT_EVT_MODEL_READY:
+        ESP_LOGI(TAG, "🧠 唤醒词已就绪（开机后 %lld ms）", esp_timer_get_time() / 1000);
+        evt.type = AUDIO_MGR_EVENT_WAKEWORD_READY;
+        audio_manager_notify_event(&evt);
+        break;
+
+    case AUDIO_INT_EVT_AFE_PRESSURE:
+        ESP_LOGI(TAG, "%s AFE 缓冲积压%s（填充 %u%%）", msg->data.pressure.active ? "⚠️" : "✅",
+                 msg->data.pressure.active ? "" : "解除", msg->data.pressure.fill_pct);
+        evt.type = AUDIO_MGR_EVENT_AFE_PRESSURE;
+        evt.data.pressure.active = msg->data.pressure.active;
+        evt.data.pressure.fill_pct = msg->data.pressure.fill_pct;
+        audio_manager_notify_event(&evt);
+        break;
+
+    case AUDIO_INT_EVT_COMMAND:
+        // 录音已经因 VAD_END / 超时结束时，本轮已提交云端，命令词作废
+        if (!s_ctx.recording) {
+            ESP_LOGW(TAG, "命令词 %d 到达时录音已结束，忽略", msg->data.command.command_id);
+            break;
+        }
+        // 先结束录音再通知：上层收到事件时不会再有上行音频
+        s_ctx.recording = false;
+        audio_manager_clear_wake_timer();
+        audio_manager_refresh_state();
+        evt.type = AUDIO_MGR_EVENT_COMMAND_DETECTED;
+        evt.data.command.command_id = msg->data.command.command_id;
+        evt.data.command.prob = msg->data.command.prob;
+        evt.data.command.detect_us = msg->data.command.detect_us;
+        audio_manager_notify_event(&evt);
+        break;
     }
 }
 
@@ -379,7 +444,7 @@ static void audio_manager_task(void *arg)
  * 1. 创建 I2S HAL（硬件抽象层）
  * 2. 创建回采缓冲区（用于 AEC）
  * 3. 创建播放控制器（管理音频播放）
- * 4. 创建 AFE 包装器（音频前端处理）
+ * 4. 创建 AFE 包装器（音频前端处理，模型在后台任务中加载，不阻塞初始化）
  * 5. 创建按键处理器（处理物理按键）
  * 
  * @param config 音频管理器配置参数
@@ -421,9 +486,32 @@ esp_err_t audio_manager_init(const audio_mgr_config_t *config)
 
     playback_controller_config_t playback_cfg = {
         .bsp_handle = s_ctx.bsp,
-        .playback_buffer_samples = AUDIO_MANAGER_PLAYBACK_BUFFER_BYTES / sizeof(int16_t),
+        .sources = {
+            [PLAYBACK_SOURCE_TTS] = {
+                .buffer_samples = AUDIO_MANAGER_PLAYBACK_BUFFER_BYTES / sizeof(int16_t),
+                .gain_q15 = PLAYBACK_GAIN_UNITY,
+                .duck_q15 = PLAYBACK_GAIN_UNITY,
+                .preempt = false,
+                .write_timeout_ms = AUDIO_MANAGER_TTS_WRITE_TIMEOUT_MS,
+            },
+            [PLAYBACK_SOURCE_PROMPT] = {
+                .buffer_samples = AUDIO_MANAGER_PROMPT_BUFFER_BYTES / sizeof(int16_t),
+                .gain_q15 = PLAYBACK_GAIN_UNITY,
+                .duck_q15 = PLAYBACK_GAIN_UNITY * AUDIO_MANAGER_PROMPT_DUCK_PERCENT / 100,
+                .preempt = false,
+                .write_timeout_ms = AUDIO_MANAGER_PROMPT_WRITE_TIMEOUT_MS,
+            },
+            [PLAYBACK_SOURCE_ALERT] = {
+                .buffer_samples = AUDIO_MANAGER_ALERT_BUFFER_BYTES / sizeof(int16_t),
+                .gain_q15 = PLAYBACK_GAIN_UNITY,
+                .duck_q15 = PLAYBACK_GAIN_UNITY,
+                .preempt = true,
+                .write_timeout_ms = AUDIO_MANAGER_PROMPT_WRITE_TIMEOUT_MS,
+            },
+        },
         .reference_buffer_samples = AUDIO_MANAGER_REFERENCE_BUFFER_BYTES / sizeof(int16_t),
         .frame_samples = AUDIO_MANAGER_PLAYBACK_FRAME_SAMPLES,
+        .sample_rate = s_ctx.config.hw_config.speaker.sample_rate,
         .reference_callback = NULL,
         .reference_ctx = NULL,
         .volume_ptr = &s_ctx.volume,
@@ -457,6 +545,16 @@ esp_err_t audio_manager_init(const audio_mgr_config_t *config)
         goto fail;
     }
 
+    size_t word_count = s_ctx.config.command_config.word_count;
+    if (word_count > AUDIO_MANAGER_MAX_COMMAND_WORDS) {
+        ESP_LOGW(TAG, "命令表 %u 条，只保留前 %d 条", (unsigned)word_count, AUDIO_MANAGER_MAX_COMMAND_WORDS);
+        word_count = AUDIO_MANAGER_MAX_COMMAND_WORDS;
+    }
+    for (size_t i = 0; i < word_count && s_ctx.config.command_config.words; i++) {
+        s_ctx.command_words[i].id = s_ctx.config.command_config.words[i].id;
+        s_ctx.command_words[i].phrase = s_ctx.config.command_config.words[i].phrase;
+    }
+
     afe_wrapper_config_t afe_cfg = {
         .bsp_handle = s_ctx.bsp,
         .reference_rb = s_ctx.reference_rb,
@@ -466,6 +564,13 @@ esp_err_t audio_manager_init(const audio_mgr_config_t *config)
             .model_partition = s_ctx.config.wakeup_config.model_partition,
             .sensitivity = s_ctx.config.wakeup_config.sensitivity,
         },
+        .command_config = (afe_command_config_t){
+            .enabled = s_ctx.config.command_config.enabled && word_count > 0,
+            .language = s_ctx.config.command_config.language,
+            .timeout_ms = s_ctx.config.command_config.timeout_ms,
+            .words = s_ctx.command_words,
+            .word_count = word_count,
+        },
         .vad_config = (afe_vad_config_t){
             .enabled = s_ctx.config.vad_config.enabled,
             .vad_mode = s_ctx.config.vad_config.vad_mode,
@@ -696,6 +801,26 @@ esp_err_t audio_manager_play_audio(const int16_t *pcm_data, size_t sample_count)
     return playback_controller_write(s_ctx.playback_ctrl, pcm_data, sample_count);
 }
 
+/**
+ * @brief 播放音频数据到指定混音输入源
+ * 
+ * @param source 输入源
+ * @param pcm_data PCM 音频数据指针
+ * @param sample_count 采样点数
+ * @return 
+ *     - ESP_OK: 写入成功
+ *     - ESP_ERR_INVALID_ARG: 参数无效或未初始化
+ */
+esp_err_t audio_manager_play_audio_source(playback_source_t source,
+                                          const int16_t *pcm_data, size_t sample_count)
+{
+    if (!s_ctx.initialized || !pcm_data || sample_count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return playback_controller_write_source(s_ctx.playback_ctrl, source, pcm_data, sample_count);
+}
+
 size_t audio_manager_get_playback_free_space(void)
 {
     // 检查是否已初始化
@@ -765,6 +890,59 @@ esp_err_t audio_manager_clear_playback_buffer(void)
     return playback_controller_clear(s_ctx.playback_ctrl);
 }
 
+/**
+ * @brief 清空指定混音输入源
+ * 
+ * 只丢弃该输入源的待播放数据，其他输入源继续播放。
+ * 
+ * @param source 输入源
+ * @return 
+ *     - ESP_OK: 清空成功
+ *     - ESP_ERR_INVALID_STATE: 未初始化
+ */
+esp_err_t audio_manager_clear_playback_source(playback_source_t source)
+{
+    // 检查是否已初始化
+    if (!s_ctx.initialized) return ESP_ERR_INVALID_STATE;
+
+    return playback_controller_clear_source(s_ctx.playback_ctrl, source);
+}
+
+/**
+ * @brief 设置混音输入源音量
+ * 
+ * @param source 输入源
+ * @param volume 音量值（0-100）
+ * @return 
+ *     - ESP_OK: 设置成功
+ *     - ESP_ERR_INVALID_STATE: 未初始化
+ */
+esp_err_t audio_manager_set_source_volume(playback_source_t source, uint8_t volume)
+{
+    // 检查是否已初始化
+    if (!s_ctx.initialized) return ESP_ERR_INVALID_STATE;
+
+    if (volume > 100) volume = 100;
+    return playback_controller_set_source_gain(s_ctx.playback_ctrl, source,
+                                               (int16_t)(PLAYBACK_GAIN_UNITY * volume / 100));
+}
+
+/**
+ * @brief 获取混音器统计
+ * 
+ * @param stats 输出统计
+ * @return 
+ *     - ESP_OK: 获取成功
+ *     - ESP_ERR_INVALID_STATE: 未初始化
+ */
+esp_err_t audio_manager_get_mixer_stats(playback_mixer_stats_t *stats)
+{
+    // 检查是否已初始化
+    if (!s_ctx.initialized) return ESP_ERR_INVALID_STATE;
+
+    return playback_controller_get_stats(s_ctx.playback_ctrl, stats);
+}
+
 /**
  * @brief 设置音量
  * 
@@ -857,6 +1035,30 @@ bool audio_manager_is_running(void)
     return s_ctx.running;
 }
 
+/**
+ * @brief 唤醒词模型是否已加载完成
+ * 
+ * @return true: 已就绪，false: 后台加载中或加载失败
+ */
+bool audio_manager_is_wakeword_ready(void)
+{
+    return afe_wrapper_is_ready(s_ctx.afe_wrapper);
+}
+
+/**
+ * @brief 本地命令词可用的条数
+ * 
+ * @return 已编译进 MultiNet 的命令词条数，不可用时为 0
+ */
+int audio_manager_get_command_count(void)
+{
+    afe_wrapper_load_stats_t stats;
+    if (afe_wrapper_get_load_stats(s_ctx.afe_wrapper, &stats) != ESP_OK) {
+        return 0;
+    }
+    return stats.command_count;
+}
+
 /**
  * @brief 检查是否正在录音
  * 
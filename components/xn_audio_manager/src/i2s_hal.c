@@ -9,7 +9,9 @@
  * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved. 
  */
 #include "i2s_hal.h"
+#include "audio_health.h"
 #include "esp_log.h"
+#include "esp_attr.h"
 #include "esp_heap_caps.h"
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
@@ -36,6 +38,28 @@ typedef struct i2s_hal_s {
     uint8_t mic_bit_shift;          ///< 32位转16位的右移位数（默认14，可调12-16）
 } i2s_hal_t;
 
+/**
+ * @brief I2S 发送队列溢出回调（ISR）
+ * 
+ * DMA 已经发送完所有已填充的缓冲，软件没能及时补充数据
+ */
+static bool IRAM_ATTR i2s_hal_on_send_q_ovf(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    audio_health_add(AUDIO_HEALTH_I2S_TX_QUEUE_OVF, 1);
+    return false;
+}
+
+/**
+ * @brief I2S 接收队列溢出回调（ISR）
+ * 
+ * 软件没能及时读走麦克风数据，最旧的 DMA 缓冲被覆盖
+ */
+static bool IRAM_ATTR i2s_hal_on_recv_q_ovf(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    audio_health_add(AUDIO_HEALTH_I2S_RX_QUEUE_OVF, 1);
+    return false;
+}
+
 /**
  * @brief 创建 I2S HAL 实例
  * 
@@ -99,6 +123,12 @@ i2s_hal_handle_t i2s_hal_create(const i2s_mic_config_t *mic_config,
         return NULL;
     }
 
+    // 注册队列溢出回调（必须在使能前注册）
+    i2s_event_callbacks_t tx_cbs = {
+        .on_send_q_ovf = i2s_hal_on_send_q_ovf,
+    };
+    i2s_channel_register_event_callback(hal->tx_handle, &tx_cbs, hal);
+
     // 使能 TX 通道
     ret = i2s_channel_enable(hal->tx_handle);
     if (ret != ESP_OK) {
@@ -154,6 +184,12 @@ i2s_hal_handle_t i2s_hal_create(const i2s_mic_config_t *mic_config,
         return NULL;
     }
 
+    // 注册队列溢出回调（必须在使能前注册）
+    i2s_event_callbacks_t rx_cbs = {
+        .on_recv_q_ovf = i2s_hal_on_recv_q_ovf,
+    };
+    i2s_channel_register_event_callback(hal->rx_handle, &rx_cbs, hal);
+
     // 使能 RX 通道
     ret = i2s_channel_enable(hal->rx_handle);
     if (ret != ESP_OK) {
@@ -299,6 +335,9 @@ esp_err_t i2s_hal_read_mic(i2s_hal_handle_t hal, int16_t *out_samples,
     size_t bytes_read = 0;
     esp_err_t ret = i2s_channel_read(hal->rx_handle, hal->mic_temp_buffer, 
                                       bytes32, &bytes_read, 100);
+    if (ret != ESP_OK) {
+        audio_health_add(AUDIO_HEALTH_I2S_READ_ERRORS, 1);
+    }
 
     // 将 32 位数据转换为 16 位
     // 根据数据手册：24-bit 有效数据 + 8-bit 低位填充
@@ -361,12 +400,14 @@ esp_err_t i2s_hal_write_speaker(i2s_hal_handle_t hal, const int16_t *samples,
 
     // 检查写入结果
     if (ret != ESP_OK) {
+        audio_health_add(AUDIO_HEALTH_I2S_WRITE_ERRORS, 1);
         ESP_LOGE(TAG, "❌ I2S 写入失败: %s (期望%d字节)", esp_err_to_name(ret), bytes_to_write);
         return ret;
     }
 
     // 检查是否完整写入
     if (written < bytes_to_write) {
+        audio_health_add(AUDIO_HEALTH_I2S_PARTIAL_WRITES, 1);
         ESP_LOGW(TAG, "⚠️ I2S 写入不完整: 期望%d, 实际%d", bytes_to_write, written);
     }
 
@@ -9,7 +9,9 @@
  * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved. 
  */
 #include "playback_controller.h"
+#include "audio_health.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <stdlib.h>
@@ -17,6 +19,21 @@
 
 static const char *TAG = "PLAYBACK_CTRL";
 
+/**
+ * @brief 单个混音输入源
+ */
+typedef struct {
+    ring_buffer_handle_t rb;                        ///< 输入源缓冲区
+    int16_t gain_q15;                               ///< 输入源增益（Q15）
+    int16_t duck_q15;                               ///< 本源活跃时对低优先级输入源的压低系数
+    bool preempt;                                   ///< 本源活跃时暂停低优先级输入源
+    int32_t cur_gain_q15;                           ///< 上一帧结束时的实际增益（用于帧内平滑过渡）
+    bool streaming;                                 ///< 上一帧是否读到数据
+    uint32_t write_timeout_ms;                      ///< 缓冲区满时写入最多等待的时长
+    portMUX_TYPE lock;                              ///< 保护 stats（写入方与播放任务并发更新）
+    playback_source_stats_t stats;                  ///< 统计
+} playback_source_ctx_t;
+
 /**
  * @brief 播放控制器上下文结构体
  * 
@@ -24,20 +41,140 @@ static const char *TAG = "PLAYBACK_CTRL";
  */
 typedef struct playback_controller_s {
     audio_bsp_handle_t bsp_handle;                  ///< BSP 句柄，用于音频输出
-    ring_buffer_handle_t playback_rb;               ///< 播放缓冲区，存储待播放的音频数据
+    playback_source_ctx_t sources[PLAYBACK_SOURCE_MAX]; ///< 混音输入源（下标即优先级）
     ring_buffer_handle_t reference_rb;              ///< 回采缓冲区，存储回采的音频数据供AFE使用
     TaskHandle_t playback_task;                     ///< 播放任务句柄，用于管理播放任务
     bool running;                                   ///< 运行状态标志，true表示正在运行
     size_t frame_samples;                           ///< 每帧采样点数，用于分配帧缓冲区
+    int sample_rate;                                ///< 采样率
     playback_reference_callback_t reference_callback; ///< 回采回调函数，用于将音频数据传递给AFE
     void *reference_ctx;                            ///< 回采回调上下文，传递给回调函数的用户数据
     uint8_t *volume_ptr;                            ///< 音量指针，指向音量值（0-100）
+
+    // 混音统计
+    uint32_t mixed_frames;                          ///< 输出帧数
+    uint64_t mix_time_total_us;                     ///< 混音累计耗时
+    uint32_t mix_time_max_us;                       ///< 单帧最大混音耗时
+    uint64_t mixed_samples;                         ///< 输出采样点总数
 } playback_controller_t;
 
+/**
+ * @brief 唤醒播放任务（有新数据写入或停止时调用）
+ */
+static inline void playback_wake_task(playback_controller_t *ctrl)
+{
+    TaskHandle_t task = ctrl->playback_task;
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+}
+
+/**
+ * @brief 以 Q15 增益把一段输入源数据累加到混音缓冲区
+ *
+ * 增益在帧内从 from_q15 线性过渡到 to_q15，避免压低/恢复时产生咔嗒声。
+ */
+static void mix_accumulate(int32_t *mix, const int16_t *in, size_t n,
+                           int32_t from_q15, int32_t to_q15)
+{
+    if (from_q15 == to_q15) {
+        for (size_t i = 0; i < n; i++) {
+            mix[i] += (in[i] * to_q15) >> 15;
+        }
+        return;
+    }
+
+    // Q23 增量，保证 1024 点帧内也有足够精度
+    int32_t gain_q23 = from_q15 << 8;
+    int32_t step_q23 = ((to_q15 - from_q15) << 8) / (int32_t)n;
+    for (size_t i = 0; i < n; i++) {
+        mix[i] += (in[i] * (gain_q23 >> 8)) >> 15;
+        gain_q23 += step_q23;
+    }
+}
+
+/**
+ * @brief 混音一帧
+ *
+ * 规则：
+ * - 有数据的最高优先级抢占源之下的输入源本帧不读取（暂停，数据保留）
+ * - 其余有数据的输入源按 gain × 高优先级活跃源的 duck 系数混音
+ *
+ * @return 本帧输出的采样点数（0 表示所有输入源都没有数据）
+ */
+static size_t playback_mix_frame(playback_controller_t *ctrl, int32_t *mix,
+                                 int16_t *scratch, int16_t *out)
+{
+    const size_t frame = ctrl->frame_samples;
+    bool has_data[PLAYBACK_SOURCE_MAX];
+    int preempt_level = -1;
+
+    for (int s = 0; s < PLAYBACK_SOURCE_MAX; s++) {
+        playback_source_ctx_t *src = &ctrl->sources[s];
+        has_data[s] = src->rb && ring_buffer_available(src->rb) > 0;
+        if (has_data[s] && src->preempt) {
+            preempt_level = s;
+        }
+    }
+
+    memset(mix, 0, frame * sizeof(int32_t));
+    size_t out_len = 0;
+    int32_t duck_q15 = PLAYBACK_GAIN_UNITY;
+
+    // 从高优先级到低优先级，依次累积压低系数
+    for (int s = PLAYBACK_SOURCE_MAX - 1; s >= 0; s--) {
+        playback_source_ctx_t *src = &ctrl->sources[s];
+        if (!src->rb) {
+            continue;
+        }
+
+        if (s < preempt_level) {
+            // 被抢占：不读取，保持 streaming 状态以便恢复时不计欠载
+            continue;
+        }
+
+        int32_t target_q15 = (src->gain_q15 * duck_q15) >> 15;
+        size_t got = has_data[s] ? ring_buffer_read(src->rb, scratch, frame, 0) : 0;
+
+        if (got > 0) {
+            mix_accumulate(mix, scratch, got, src->cur_gain_q15, target_q15);
+            if (got > out_len) {
+                out_len = got;
+            }
+            bool underrun = src->streaming && got < frame;
+            portENTER_CRITICAL(&src->lock);
+            src->stats.frames++;
+            src->stats.samples += got;
+            if (underrun) {
+                src->stats.underruns++;
+            }
+            portEXIT_CRITICAL(&src->lock);
+            if (underrun) {
+                audio_health_add(AUDIO_HEALTH_PLAYBACK_UNDERRUNS, 1);
+            }
+            src->streaming = true;
+            duck_q15 = (duck_q15 * src->duck_q15) >> 15;
+        } else {
+            src->streaming = false;
+        }
+
+        // 无数据时直接跳到目标增益，下次出声时从正确的电平开始
+        src->cur_gain_q15 = target_q15;
+    }
+
+    // 饱和到 16bit
+    for (size_t i = 0; i < out_len; i++) {
+        int32_t v = mix[i];
+        out[i] = (int16_t)(v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v));
+    }
+
+    return out_len;
+}
+
 /**
  * @brief 播放任务函数
  * 
- * 从播放缓冲区读取音频数据，先回采给AFE，再输出到扬声器
+ * 每帧从各输入源读取数据混音，先回采给AFE，再输出到扬声器
  * 
  * @param arg 播放控制器上下文指针
  */
@@ -45,43 +182,65 @@ static void playback_task(void *arg)
 {
     playback_controller_t *ctrl = (playback_controller_t *)arg;
     
-    // 分配帧缓冲区，用于存储从环形缓冲区读取的音频数据
+    // 分配混音缓冲区（int32 累加）、输入源临时缓冲区和输出帧缓冲区
+    int32_t *mix = (int32_t *)malloc(ctrl->frame_samples * sizeof(int32_t));
+    int16_t *scratch = (int16_t *)malloc(ctrl->frame_samples * sizeof(int16_t));
     int16_t *frame = (int16_t *)malloc(ctrl->frame_samples * sizeof(int16_t));
-    if (!frame) {
+    if (!mix || !scratch || !frame) {
         ESP_LOGE(TAG, "播放任务内存分配失败");
+        free(mix);
+        free(scratch);
+        free(frame);
+        ctrl->running = false;
+        ctrl->playback_task = NULL;
         vTaskDelete(NULL);
         return;
     }
 
     ESP_LOGI(TAG, "播放任务启动");
 
-    // 主循环：持续从播放缓冲区读取数据并播放
+    // 主循环：持续混音并播放
     while (ctrl->running) {
-        // 从播放缓冲区读取一帧音频数据，超时时间200ms
-        size_t got = ring_buffer_read(ctrl->playback_rb, frame, ctrl->frame_samples, 200);
+        int64_t t0 = esp_timer_get_time();
+        size_t got = playback_mix_frame(ctrl, mix, scratch, frame);
 
-        if (got > 0) {
-            // 先回采给 AFE（通过回调或写入缓冲区）
-            // 回采的目的是让AFE能够处理播放的音频，用于回声消除等功能
-            if (ctrl->reference_callback) {
-                // 如果设置了回调函数，直接调用回调函数传递音频数据
-                ctrl->reference_callback(frame, got, ctrl->reference_ctx);
-            } else {
-                // 否则将音频数据写入回采缓冲区，供AFE读取
-                ring_buffer_write(ctrl->reference_rb, frame, got);
-            }
+        if (got == 0) {
+            // 所有输入源为空，等待写入通知（最多200ms）
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(200));
+            continue;
+        }
+
+        uint32_t cost_us = (uint32_t)(esp_timer_get_time() - t0);
+        ctrl->mixed_frames++;
+        ctrl->mixed_samples += got;
+        ctrl->mix_time_total_us += cost_us;
+        if (cost_us > ctrl->mix_time_max_us) {
+            ctrl->mix_time_max_us = cost_us;
+        }
 
-            // 再播放音频数据到扬声器
-            // 获取音量值，如果未设置音量指针则使用默认值80
-            uint8_t volume = ctrl->volume_ptr ? *ctrl->volume_ptr : 80;
-            // 通过 BSP 将音频数据写入扬声器
-            audio_bsp_write_speaker(ctrl->bsp_handle, frame, got, volume);
+        // 先回采给 AFE（通过回调或写入缓冲区）
+        // 回采的是混音后的信号，保证提示音叠加 TTS 时回声消除仍然有效
+        if (ctrl->reference_callback) {
+            // 如果设置了回调函数，直接调用回调函数传递音频数据
+            ctrl->reference_callback(frame, got, ctrl->reference_ctx);
+        } else {
+            // 否则将音频数据写入回采缓冲区，供AFE读取
+            ring_buffer_write(ctrl->reference_rb, frame, got);
         }
+
+        // 再播放音频数据到扬声器
+        // 获取音量值，如果未设置音量指针则使用默认值80
+        uint8_t volume = ctrl->volume_ptr ? *ctrl->volume_ptr : 80;
+        // 通过 BSP 将音频数据写入扬声器
+        audio_bsp_write_speaker(ctrl->bsp_handle, frame, got, volume);
     }
 
     // 清理资源
+    free(mix);
+    free(scratch);
     free(frame);
     ESP_LOGI(TAG, "播放任务结束");
+    ctrl->playback_task = NULL;
     vTaskDelete(NULL);
 }
 
@@ -111,15 +270,38 @@ playback_controller_handle_t playback_controller_create(const playback_controlle
     // 初始化配置参数
     ctrl->bsp_handle = config->bsp_handle;
     ctrl->frame_samples = config->frame_samples;
+    ctrl->sample_rate = config->sample_rate > 0 ? config->sample_rate : 16000;
     ctrl->reference_callback = config->reference_callback;
     ctrl->reference_ctx = config->reference_ctx;
     ctrl->volume_ptr = config->volume_ptr;
 
-    // 创建播放缓冲区（阻塞模式）
-    ctrl->playback_rb = ring_buffer_create(config->playback_buffer_samples, true);
-    if (!ctrl->playback_rb) {
-        ESP_LOGE(TAG, "播放缓冲区创建失败");
-        free(ctrl);
+    // 创建各输入源缓冲区（读取不阻塞，由任务通知唤醒播放任务；写入等待空间，不覆盖）
+    for (int s = 0; s < PLAYBACK_SOURCE_MAX; s++) {
+        const playback_source_config_t *src_cfg = &config->sources[s];
+        playback_source_ctx_t *src = &ctrl->sources[s];
+
+        src->gain_q15 = src_cfg->gain_q15;
+        src->duck_q15 = src_cfg->duck_q15;
+        src->preempt = src_cfg->preempt;
+        src->cur_gain_q15 = src_cfg->gain_q15;
+        src->write_timeout_ms = src_cfg->write_timeout_ms;
+        portMUX_INITIALIZE(&src->lock);
+
+        if (src_cfg->buffer_samples == 0) {
+            continue;  // 未配置的输入源
+        }
+
+        src->rb = ring_buffer_create(src_cfg->buffer_samples, false);
+        if (!src->rb) {
+            ESP_LOGE(TAG, "输入源 %d 缓冲区创建失败", s);
+            playback_controller_destroy(ctrl);
+            return NULL;
+        }
+    }
+
+    if (!ctrl->sources[PLAYBACK_SOURCE_TTS].rb) {
+        ESP_LOGE(TAG, "TTS 输入源未配置");
+        playback_controller_destroy(ctrl);
         return NULL;
     }
 
@@ -127,10 +309,10 @@ playback_controller_handle_t playback_controller_create(const playback_controlle
     ctrl->reference_rb = ring_buffer_create(config->reference_buffer_samples, false);
     if (!ctrl->reference_rb) {
         ESP_LOGE(TAG, "回采缓冲区创建失败");
-        ring_buffer_destroy(ctrl->playback_rb);
-        free(ctrl);
+        playback_controller_destroy(ctrl);
         return NULL;
     }
+    ring_buffer_set_overrun_counter(ctrl->reference_rb, AUDIO_HEALTH_REF_OVERFLOW_SAMPLES);
 
     ESP_LOGI(TAG, "✅ 播放控制器创建成功");
     return ctrl;
@@ -150,9 +332,11 @@ void playback_controller_destroy(playback_controller_handle_t controller)
     // 先停止播放任务
     playback_controller_stop(controller);
 
-    // 销毁播放缓冲区
-    if (controller->playback_rb) {
-        ring_buffer_destroy(controller->playback_rb);
+    // 销毁各输入源缓冲区
+    for (int s = 0; s < PLAYBACK_SOURCE_MAX; s++) {
+        if (controller->sources[s].rb) {
+            ring_buffer_destroy(controller->sources[s].rb);
+        }
     }
 
     // 销毁回采缓冲区
@@ -211,6 +395,7 @@ esp_err_t playback_controller_stop(playback_controller_handle_t controller)
 
     ESP_LOGI(TAG, "⏹️ 停止播放器");
     controller->running = false;
+    playback_wake_task(controller);
 
     // 等待任务结束
     if (controller->playback_task) {
@@ -222,9 +407,7 @@ esp_err_t playback_controller_stop(playback_controller_handle_t controller)
 }
 
 /**
- * @brief 写入音频数据到播放缓冲区
- * 
- * 将PCM音频数据写入播放缓冲区，供播放任务读取
+ * @brief 写入音频数据到 TTS 输入源
  * 
  * @param controller 播放控制器句柄
  * @param pcm_data PCM音频数据指针
@@ -234,19 +417,77 @@ esp_err_t playback_controller_stop(playback_controller_handle_t controller)
 esp_err_t playback_controller_write(playback_controller_handle_t controller, 
                                      const int16_t *pcm_data, size_t sample_count)
 {
-    if (!controller || !pcm_data || sample_count == 0) {
+    return playback_controller_write_source(controller, PLAYBACK_SOURCE_TTS, pcm_data, sample_count);
+}
+
+/**
+ * @brief 写入音频数据到指定输入源
+ * 
+ * 将PCM音频数据写入输入源缓冲区，并唤醒播放任务混音。
+ * 缓冲区满时等待播放任务腾出空间（最多 write_timeout_ms），从不覆盖已缓冲的数据：
+ * 覆盖会吃掉正在播放的提示音开头，或让连续的两段音频互相串音。
+ * 
+ * @param controller 播放控制器句柄
+ * @param source 输入源
+ * @param pcm_data PCM音频数据指针
+ * @param sample_count 采样点数
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效，ESP_ERR_TIMEOUT 等待超时、剩余数据已丢弃
+ */
+esp_err_t playback_controller_write_source(playback_controller_handle_t controller,
+                                            playback_source_t source,
+                                            const int16_t *pcm_data, size_t sample_count)
+{
+    if (!controller || source >= PLAYBACK_SOURCE_MAX || !pcm_data || sample_count == 0) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    // 将音频数据写入播放缓冲区
-    ring_buffer_write(controller->playback_rb, pcm_data, sample_count);
-    return ESP_OK;
+    playback_source_ctx_t *src = &controller->sources[source];
+    if (!src->rb) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 先唤醒播放任务：缓冲区满时它需要先消耗数据才能腾出空间
+    playback_wake_task(controller);
+    size_t written = ring_buffer_write_wait(src->rb, pcm_data, sample_count, src->write_timeout_ms);
+    if (written > 0) {
+        playback_wake_task(controller);
+    }
+    if (written == sample_count) {
+        return ESP_OK;
+    }
+
+    size_t dropped = sample_count - written;
+    portENTER_CRITICAL(&src->lock);
+    src->stats.overflows++;
+    src->stats.dropped_samples += dropped;
+    portEXIT_CRITICAL(&src->lock);
+    audio_health_add(AUDIO_HEALTH_PLAYBACK_OVERFLOW_SAMPLES, dropped);
+    ESP_LOGW(TAG, "⚠️ 输入源 %d 写入超时，丢弃 %u 样本", (int)source, (unsigned)dropped);
+    return ESP_ERR_TIMEOUT;
+}
+
+/**
+ * @brief 清空指定输入源
+ * 
+ * @param controller 播放控制器句柄
+ * @param source 输入源
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t playback_controller_clear_source(playback_controller_handle_t controller,
+                                            playback_source_t source)
+{
+    if (!controller || source >= PLAYBACK_SOURCE_MAX || !controller->sources[source].rb) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    controller->sources[source].streaming = false;
+    return ring_buffer_clear(controller->sources[source].rb);
 }
 
 /**
  * @brief 清空播放缓冲区
  * 
- * 清空播放缓冲区和回采缓冲区中的所有数据
+ * 清空所有输入源和回采缓冲区中的数据
  * 
  * @param controller 播放控制器句柄
  * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效
@@ -257,8 +498,16 @@ esp_err_t playback_controller_clear(playback_controller_handle_t controller)
         return ESP_ERR_INVALID_ARG;
     }
 
-    // 清空播放缓冲区
-    esp_err_t ret = ring_buffer_clear(controller->playback_rb);
+    // 清空各输入源
+    esp_err_t ret = ESP_OK;
+    for (int s = 0; s < PLAYBACK_SOURCE_MAX; s++) {
+        if (controller->sources[s].rb) {
+            esp_err_t err = playback_controller_clear_source(controller, s);
+            if (err != ESP_OK) {
+                ret = err;
+            }
+        }
+    }
     if (ret == ESP_OK) {
         ESP_LOGI(TAG, "🗑️ 已清空播放缓冲区");
     }
@@ -268,6 +517,64 @@ esp_err_t playback_controller_clear(playback_controller_handle_t controller)
     return ret;
 }
 
+/**
+ * @brief 设置输入源增益
+ * 
+ * 新增益在下一帧内平滑过渡生效
+ * 
+ * @param controller 播放控制器句柄
+ * @param source 输入源
+ * @param gain_q15 增益（Q15）
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t playback_controller_set_source_gain(playback_controller_handle_t controller,
+                                               playback_source_t source, int16_t gain_q15)
+{
+    if (!controller || source >= PLAYBACK_SOURCE_MAX || gain_q15 < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    controller->sources[source].gain_q15 = gain_q15;
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取混音器统计
+ * 
+ * @param controller 播放控制器句柄
+ * @param stats 输出统计
+ * @return ESP_OK 成功，ESP_ERR_INVALID_ARG 参数无效
+ */
+esp_err_t playback_controller_get_stats(playback_controller_handle_t controller,
+                                         playback_mixer_stats_t *stats)
+{
+    if (!controller || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    for (int s = 0; s < PLAYBACK_SOURCE_MAX; s++) {
+        playback_source_ctx_t *src = &controller->sources[s];
+        portENTER_CRITICAL(&src->lock);
+        stats->sources[s] = src->stats;
+        portEXIT_CRITICAL(&src->lock);
+    }
+
+    stats->mixed_frames = controller->mixed_frames;
+    stats->mix_time_max_us = controller->mix_time_max_us;
+    if (controller->mixed_frames > 0) {
+        stats->mix_time_avg_us = (uint32_t)(controller->mix_time_total_us / controller->mixed_frames);
+    }
+
+    // 混音耗时 / 对应音频时长
+    uint64_t audio_us = controller->mixed_samples * 1000000ULL / controller->sample_rate;
+    if (audio_us > 0) {
+        stats->mix_cpu_permille = (uint32_t)(controller->mix_time_total_us * 1000ULL / audio_us);
+    }
+
+    return ESP_OK;
+}
+
 /**
  * @brief 检查播放控制器是否正在运行
  * 
@@ -280,7 +587,7 @@ bool playback_controller_is_running(playback_controller_handle_t controller)
 }
 
 /**
- * @brief 获取播放缓冲区可用空间
+ * @brief 获取 TTS 输入源可用空间
  * 
  * 用于流控：让解码任务根据可用空间决定是否延迟
  * 
@@ -289,13 +596,14 @@ bool playback_controller_is_running(playback_controller_handle_t controller)
  */
 size_t playback_controller_get_free_space(playback_controller_handle_t controller)
 {
-    if (!controller || !controller->playback_rb) {
+    if (!controller || !controller->sources[PLAYBACK_SOURCE_TTS].rb) {
         return 0;
     }
     
     // 计算可用空间 = 总容量 - 已占用
-    size_t total_size = ring_buffer_get_size(controller->playback_rb);
-    size_t used_size = ring_buffer_available(controller->playback_rb);
+    ring_buffer_handle_t rb = controller->sources[PLAYBACK_SOURCE_TTS].rb;
+    size_t total_size = ring_buffer_get_size(rb);
+    size_t used_size = ring_buffer_available(rb);
     
     return (total_size > used_size) ? (total_size - used_size) : 0;
 }
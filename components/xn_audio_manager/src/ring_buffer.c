@@ -11,6 +11,7 @@
 #include "ring_buffer.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
+#include "freertos/task.h"
 #include <string.h>
 
 static const char *TAG = "RING_BUFFER";
@@ -23,7 +24,7 @@ static const char *TAG = "RING_BUFFER";
  * - 使用 PSRAM 存储大容量音频数据
  * - 支持多线程并发访问（互斥锁保护）
  * - 可选的阻塞读取机制（信号量）
- * - 缓冲区满时自动覆盖旧数据
+ * - ring_buffer_write 缓冲区满时自动覆盖旧数据；ring_buffer_write_wait 等待读取方腾出空间
  */
 typedef struct ring_buffer_s {
     int16_t *buffer;              ///< 数据缓冲区（PSRAM），存储音频采样点
@@ -32,6 +33,8 @@ typedef struct ring_buffer_s {
     volatile size_t read_pos;     ///< 读位置索引（消费者）
     SemaphoreHandle_t mutex;      ///< 互斥锁，保护读写位置的原子性
     SemaphoreHandle_t data_sem;   ///< 数据可用信号量（可选），用于阻塞读取
+    SemaphoreHandle_t space_sem;  ///< 空间可用信号量，读取 / 清空后释放，用于等待写入
+    int overrun_counter;          ///< 溢出计数项（audio_health_counter_t），-1 表示不统计
 } ring_buffer_t;
 
 /**
@@ -77,6 +80,7 @@ ring_buffer_handle_t ring_buffer_create(size_t samples, bool with_sem)
     rb->size = samples;
     rb->write_pos = 0;
     rb->read_pos = 0;
+    rb->overrun_counter = -1;
 
     // 创建互斥锁（保护并发访问）
     rb->mutex = xSemaphoreCreateMutex();
@@ -87,12 +91,23 @@ ring_buffer_handle_t ring_buffer_create(size_t samples, bool with_sem)
         return NULL;
     }
 
+    // 空间可用信号量（ring_buffer_write_wait 等待读取方腾出空间）
+    rb->space_sem = xSemaphoreCreateBinary();
+    if (!rb->space_sem) {
+        ESP_LOGE(TAG, "信号量创建失败");
+        vSemaphoreDelete(rb->mutex);
+        heap_caps_free(rb->buffer);
+        free(rb);
+        return NULL;
+    }
+
     // 可选：创建数据可用信号量（用于阻塞读取）
     rb->data_sem = NULL;
     if (with_sem) {
         rb->data_sem = xSemaphoreCreateBinary();
         if (!rb->data_sem) {
             ESP_LOGE(TAG, "信号量创建失败");
+            vSemaphoreDelete(rb->space_sem);
             vSemaphoreDelete(rb->mutex);
             heap_caps_free(rb->buffer);
             free(rb);
@@ -131,6 +146,9 @@ void ring_buffer_destroy(ring_buffer_handle_t rb)
     if (rb->data_sem) {
         vSemaphoreDelete(rb->data_sem);
     }
+    if (rb->space_sem) {
+        vSemaphoreDelete(rb->space_sem);
+    }
     
     // 释放缓冲区内存
     if (rb->buffer) {
@@ -185,6 +203,9 @@ size_t ring_buffer_write(ring_buffer_handle_t rb, const int16_t *data, size_t sa
 
     // 缓冲区溢出警告（假设 16kHz 采样率）
     if (overrun_count > 0) {
+        if (rb->overrun_counter >= 0) {
+            audio_health_add((audio_health_counter_t)rb->overrun_counter, overrun_count);
+        }
         ESP_LOGW(TAG, "⚠️ 缓冲区溢出！丢弃 %u 样本 (%.1f ms)", 
                  (unsigned)overrun_count, 
                  (float)overrun_count / 16.0f);
@@ -198,6 +219,73 @@ size_t ring_buffer_write(ring_buffer_handle_t rb, const int16_t *data, size_t sa
     return samples;
 }
 
+/**
+ * @brief 等待空间写入数据（不覆盖旧数据）
+ * 
+ * 每次只写入当前空闲的部分，剩余数据等待读取方腾出空间后继续写入，
+ * 直到全部写完或累计等待超过 timeout_ms。
+ * 
+ * @param rb 环形缓冲区句柄
+ * @param data 待写入的数据指针（int16_t 数组）
+ * @param samples 采样点数
+ * @param timeout_ms 最多等待空间的总时长（毫秒）
+ * 
+ * @return 实际写入的采样点数（超时时小于 samples）
+ * 
+ * @note 线程安全：内部使用互斥锁保护
+ * @note 有多个写入方同时等待时可能错过一次唤醒，因此每次最多等待 20ms 后重新检查
+ */
+size_t ring_buffer_write_wait(ring_buffer_handle_t rb, const int16_t *data, size_t samples,
+                              uint32_t timeout_ms)
+{
+    if (!rb || !data || samples == 0) {
+        return 0;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    TickType_t limit = pdMS_TO_TICKS(timeout_ms);
+    size_t written = 0;
+
+    while (written < samples) {
+        if (xSemaphoreTake(rb->mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+            // 读写位置相等表示空，最多存 size - 1 个采样点
+            size_t used = (rb->write_pos >= rb->read_pos)
+                          ? (rb->write_pos - rb->read_pos)
+                          : (rb->size - rb->read_pos + rb->write_pos);
+            size_t n = rb->size - 1 - used;
+            if (n > samples - written) {
+                n = samples - written;
+            }
+
+            for (size_t i = 0; i < n; i++) {
+                rb->buffer[rb->write_pos] = data[written + i];
+                rb->write_pos = (rb->write_pos + 1) % rb->size;
+            }
+            written += n;
+            xSemaphoreGive(rb->mutex);
+
+            if (n > 0 && rb->data_sem) {
+                xSemaphoreGive(rb->data_sem);
+            }
+            if (written == samples) {
+                break;
+            }
+        }
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= limit) {
+            break;
+        }
+        TickType_t wait = limit - elapsed;
+        if (wait > pdMS_TO_TICKS(20)) {
+            wait = pdMS_TO_TICKS(20);
+        }
+        xSemaphoreTake(rb->space_sem, wait);
+    }
+
+    return written;
+}
+
 /**
  * @brief 从环形缓冲区读取数据
  * 
@@ -249,6 +337,11 @@ size_t ring_buffer_read(ring_buffer_handle_t rb, int16_t *out, size_t samples, u
 
     xSemaphoreGive(rb->mutex);
 
+    // 通知等待空间的写入方
+    if (samples > 0) {
+        xSemaphoreGive(rb->space_sem);
+    }
+
     return samples;
 }
 
@@ -314,6 +407,7 @@ esp_err_t ring_buffer_clear(ring_buffer_handle_t rb)
     rb->write_pos = 0;
 
     xSemaphoreGive(rb->mutex);
+    xSemaphoreGive(rb->space_sem);
 
     return ESP_OK;
 }
@@ -335,3 +429,15 @@ size_t ring_buffer_get_size(ring_buffer_handle_t rb)
     }
     return rb->size;
 }
+
+/**
+ * @brief 绑定溢出计数项
+ * 
+ * @param rb 环形缓冲区句柄
+ * @param id 健康计数项
+ */
+void ring_buffer_set_overrun_counter(ring_buffer_handle_t rb, audio_health_counter_t id)
+{
+    if (!rb) return;
+    rb->overrun_counter = (int)id;
+}
@@ -1,6 +1,6 @@
 /*
  * @Author: AI Assistant
- * @Description: 音效播放模块 - 基于预加载缓存的PCM音效播放
+ * @Description: 音效播放模块 - 基于 Flash 内存映射的压缩音效流式播放
  */
 
 #pragma once
@@ -28,22 +28,24 @@ typedef enum {
 
 /**
  * @brief 初始化音效模块
- * @note 会预加载所有音效到PSRAM，建议在系统启动时调用
+ * @note 映射 prompt_store 分区并解析索引，不占用 PSRAM
  * @return
  *      - ESP_OK: 成功
  *      - ESP_ERR_NO_MEM: 内存不足
- *      - ESP_ERR_NOT_FOUND: 音效文件未找到
+ *      - ESP_ERR_NOT_FOUND: 分区或音效未找到
+ *      - ESP_ERR_INVALID_VERSION: 分区镜像格式无效
  */
 esp_err_t audio_prompt_init(void);
 
 /**
  * @brief 反初始化音效模块
- * @note 释放所有预加载的音效内存
+ * @note 解除分区映射
  */
 void audio_prompt_deinit(void);
 
 /**
  * @brief 播放预定义音效
+ * @note 在调用者任务中分块解码并写入播放缓冲区，播放路径不访问文件系统
  * @param type 音效类型
  * @return
  *      - ESP_OK: 成功
@@ -55,19 +57,21 @@ esp_err_t audio_prompt_play(audio_prompt_type_t type);
 
 /**
  * @brief 播放自定义PCM文件（不使用缓存）
- * @param filename PCM文件路径（如 "/spiffs/custom.pcm"）
- * @note 此函数每次从文件读取，不使用缓存
+ * @param filename PCM文件路径（如 "/spiffs/custom.pcm"，需调用方已挂载对应文件系统）
+ * @note 文件由资源加载器（xn_asset_loader）在后台分块预读，文件播放任务按播放速度取走写入，
+ *       不为整个文件分配内存、不覆盖未播完的提示音；多个文件依次播放。
+ *       函数提交请求后立即返回，文件不存在或为空时只在日志中报告
  * @return
- *      - ESP_OK: 成功
- *      - ESP_ERR_INVALID_ARG: 文件名为空
- *      - ESP_ERR_NOT_FOUND: 文件不存在
- *      - ESP_ERR_NO_MEM: 内存不足
+ *      - ESP_OK: 已提交
+ *      - ESP_ERR_INVALID_ARG: 文件名为空或路径过长
+ *      - ESP_ERR_INVALID_STATE: 模块或资源加载器未初始化
+ *      - ESP_ERR_NO_MEM: 加载器请求队列已满、待播放文件过多或文件播放任务创建失败
  */
 esp_err_t audio_prompt_play_file(const char *filename);
 
 /**
- * @brief 停止当前播放
- * @note 会清空播放缓冲区
+ * @brief 停止当前提示音
+ * @note 只清空提示音输入源，不影响正在播放的 TTS
  */
 void audio_prompt_stop(void);
 
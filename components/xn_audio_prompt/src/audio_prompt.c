@@ -1,141 +1,263 @@
 /*
  * @Author: AI Assistant
- * @Description: 音效播放模块实现 - 预加载缓存方案
+ * @Description: 音效播放模块实现 - 内存映射 + IMA-ADPCM 流式解码方案
  */
 
 #include "audio_prompt.h"
 #include "audio_manager.h"
+#include "asset_loader.h"
 #include "esp_log.h"
-#include "esp_heap_caps.h"
-#include "esp_spiffs.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
 #include <stdio.h>
 #include <string.h>
-#include <sys/stat.h>
 
 static const char *TAG = "AUDIO_PROMPT";
 
-// ============ 音效文件定义 ============
+// ============ 分区镜像格式（与 tools/pack_prompts.py 保持一致） ============
+
+#define PROMPT_STORE_PARTITION   "prompt_store"
+#define PROMPT_STORE_MAGIC       "XNPS"
+#define PROMPT_STORE_VERSION     1
+#define PROMPT_NAME_MAX          16
+
+#define PROMPT_CODEC_PCM16       0
+#define PROMPT_CODEC_IMA_ADPCM   1
+
+#define PROMPT_SAMPLE_RATE       16000
+#define PROMPT_DECODE_SAMPLES    256     // 每次解码推送的采样点数（512 字节，内部RAM）
+
+#define PROMPT_FILE_QUEUE_LEN    2       // 等待播放的文件数
+#define PROMPT_FILE_TASK_STACK   3072
+#define PROMPT_FILE_TASK_PRIO    5
+#define PROMPT_FILE_READ_TIMEOUT_MS 2000 // 等待加载器预读一块的最长时间
+
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint16_t version;
+    uint16_t count;
+    uint32_t image_size;
+    uint32_t reserved;
+} prompt_store_header_t;
+
+typedef struct __attribute__((packed)) {
+    char name[PROMPT_NAME_MAX];
+    uint32_t offset;
+    uint32_t data_bytes;
+    uint32_t samples;
+    uint16_t sample_rate;
+    uint8_t codec;
+    uint8_t reserved;
+} prompt_store_entry_t;
+
+// ============ 音效定义 ============
 
 typedef struct {
-    const char *filename;       // PCM文件路径
-    int16_t *data;              // 预加载的音频数据（PSRAM）
-    size_t samples;             // 采样点数
-    bool loaded;                // 是否已加载
+    const char *name;           // 分区索引中的音效名称
+    const uint8_t *data;        // 映射后的压缩数据（Flash，不占用 RAM）
+    size_t data_bytes;          // 压缩数据字节数
+    size_t samples;             // 解码后的采样点数
+    uint8_t codec;              // 编码格式
+    bool loaded;                // 是否在分区中找到
 } prompt_info_t;
 
-// 音效文件路径映射表
+// 音效名称映射表
 static prompt_info_t s_prompts[AUDIO_PROMPT_MAX] = {
-    {"/prompt_spiffs/beep.pcm", NULL, 0, false},
-    {"/prompt_spiffs/success.pcm", NULL, 0, false},
-    {"/prompt_spiffs/error.pcm", NULL, 0, false},
-    {"/prompt_spiffs/wakeup.pcm", NULL, 0, false},
-    {"/prompt_spiffs/thinking.pcm", NULL, 0, false},
-    {"/prompt_spiffs/version_update.pcm", NULL, 0, false},
+    [AUDIO_PROMPT_BEEP]           = { .name = "beep" },
+    [AUDIO_PROMPT_SUCCESS]        = { .name = "success" },
+    [AUDIO_PROMPT_ERROR]          = { .name = "error" },
+    [AUDIO_PROMPT_WAKEUP]         = { .name = "wakeup" },
+    [AUDIO_PROMPT_THINKING]       = { .name = "thinking" },
+    [AUDIO_PROMPT_VERSION_UPDATE] = { .name = "version_update" },
 };
 
 static bool s_initialized = false;
+static const void *s_store_map = NULL;
+static esp_partition_mmap_handle_t s_store_map_handle;
+static SemaphoreHandle_t s_play_mutex = NULL;
+static QueueHandle_t s_file_queue = NULL;          // 待播放文件的拉取流
+static volatile uint32_t s_stop_gen = 0;           // audio_prompt_stop 每调用一次加一，播放中的文件据此放弃
 
-// ============ 内部函数 ============
+// 解码输出缓冲（内部RAM，播放路径共用，受 s_play_mutex 保护）
+static int16_t s_decode_buf[PROMPT_DECODE_SAMPLES];
 
-static esp_err_t audio_prompt_mount_spiffs(void)
-{
-    esp_vfs_spiffs_conf_t conf = {
-        .base_path = "/prompt_spiffs",
-        .partition_label = "prompt_spiffs",
-        .max_files = 8,
-        .format_if_mount_failed = true,
-    };
+// ============ IMA-ADPCM 解码器 ============
 
-    esp_err_t ret = esp_vfs_spiffs_register(&conf);
+static const int8_t s_ima_index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8,
+};
 
-    if (ret == ESP_ERR_INVALID_STATE) {
-        return ESP_OK;
+static const int16_t s_ima_step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767,
+};
+
+typedef struct {
+    int32_t predictor;
+    int step_index;
+} ima_adpcm_state_t;
+
+static inline int16_t ima_adpcm_decode_nibble(ima_adpcm_state_t *st, uint8_t code)
+{
+    int32_t step = s_ima_step_table[st->step_index];
+    int32_t delta = step >> 3;
+
+    if (code & 4) delta += step;
+    if (code & 2) delta += step >> 1;
+    if (code & 1) delta += step >> 2;
+
+    st->predictor += (code & 8) ? -delta : delta;
+    if (st->predictor > 32767) {
+        st->predictor = 32767;
+    } else if (st->predictor < -32768) {
+        st->predictor = -32768;
     }
 
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "spiffs register failed: %s", esp_err_to_name(ret));
+    st->step_index += s_ima_index_table[code & 0x0F];
+    if (st->step_index < 0) {
+        st->step_index = 0;
+    } else if (st->step_index > 88) {
+        st->step_index = 88;
     }
 
-    return ret;
+    return (int16_t)st->predictor;
 }
 
+// ============ 内部函数 ============
+
 /**
- * @brief 加载单个音效到内存
+ * @brief 映射 prompt_store 分区并解析索引
  */
-static esp_err_t load_prompt(audio_prompt_type_t type)
+static esp_err_t prompt_store_map(void)
 {
-    if (type >= AUDIO_PROMPT_MAX) {
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    prompt_info_t *prompt = &s_prompts[type];
-
-    // 检查文件是否存在
-    struct stat st;
-    if (stat(prompt->filename, &st) != 0) {
-        ESP_LOGW(TAG, "音效文件不存在: %s", prompt->filename);
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY,
+                                                           PROMPT_STORE_PARTITION);
+    if (!part) {
+        ESP_LOGE(TAG, "未找到音效分区: %s", PROMPT_STORE_PARTITION);
         return ESP_ERR_NOT_FOUND;
     }
 
-    size_t file_size = st.st_size;
-    if (file_size == 0 || file_size % 2 != 0) {
-        ESP_LOGE(TAG, "无效的PCM文件大小: %d bytes", (int)file_size);
-        return ESP_ERR_INVALID_SIZE;
+    esp_err_t ret = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA,
+                                       &s_store_map, &s_store_map_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "音效分区映射失败: %s", esp_err_to_name(ret));
+        s_store_map = NULL;
+        return ret;
     }
 
-    // 打开文件
-    FILE *fp = fopen(prompt->filename, "rb");
-    if (!fp) {
-        ESP_LOGE(TAG, "无法打开音效文件: %s", prompt->filename);
-        return ESP_ERR_NOT_FOUND;
+    const prompt_store_header_t *hdr = (const prompt_store_header_t *)s_store_map;
+    size_t index_end = sizeof(*hdr) + (size_t)hdr->count * sizeof(prompt_store_entry_t);
+    if (memcmp(hdr->magic, PROMPT_STORE_MAGIC, 4) != 0 ||
+        hdr->version != PROMPT_STORE_VERSION ||
+        hdr->image_size > part->size || index_end > hdr->image_size) {
+        ESP_LOGE(TAG, "音效分区格式无效（请重新烧录 prompt_store 镜像）");
+        esp_partition_munmap(s_store_map_handle);
+        s_store_map = NULL;
+        return ESP_ERR_INVALID_VERSION;
     }
 
-    // 分配PSRAM内存
-    prompt->samples = file_size / sizeof(int16_t);
-    prompt->data = (int16_t *)heap_caps_malloc(file_size, MALLOC_CAP_SPIRAM);
-    if (!prompt->data) {
-        ESP_LOGE(TAG, "音效内存分配失败: %d bytes", (int)file_size);
-        fclose(fp);
-        return ESP_ERR_NO_MEM;
+    ESP_LOGI(TAG, "音效分区已映射: %d 个音效, %u 字节",
+             hdr->count, (unsigned)hdr->image_size);
+    return ESP_OK;
+}
+
+/**
+ * @brief 在分区索引中查找单个音效
+ */
+static esp_err_t load_prompt(audio_prompt_type_t type)
+{
+    if (type >= AUDIO_PROMPT_MAX || !s_store_map) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    // 读取文件
-    size_t read_bytes = fread(prompt->data, 1, file_size, fp);
-    fclose(fp);
+    prompt_info_t *prompt = &s_prompts[type];
+    const prompt_store_header_t *hdr = (const prompt_store_header_t *)s_store_map;
+    const prompt_store_entry_t *entries = (const prompt_store_entry_t *)(hdr + 1);
 
-    if (read_bytes != file_size) {
-        ESP_LOGE(TAG, "音效文件读取失败: %s", prompt->filename);
-        heap_caps_free(prompt->data);
-        prompt->data = NULL;
-        return ESP_FAIL;
-    }
+    for (int i = 0; i < hdr->count; i++) {
+        const prompt_store_entry_t *e = &entries[i];
+        if (strncmp(e->name, prompt->name, PROMPT_NAME_MAX) != 0) {
+            continue;
+        }
 
-    prompt->loaded = true;
+        if ((uint64_t)e->offset + e->data_bytes > hdr->image_size ||
+            e->sample_rate != PROMPT_SAMPLE_RATE ||
+            (e->codec != PROMPT_CODEC_PCM16 && e->codec != PROMPT_CODEC_IMA_ADPCM)) {
+            ESP_LOGE(TAG, "音效索引无效: %s", prompt->name);
+            return ESP_ERR_INVALID_SIZE;
+        }
 
-    float duration_ms = (prompt->samples * 1000.0f) / 16000.0f;
-    ESP_LOGI(TAG, "✅ 音效已加载: %s (%d samples, %.1f ms, %.1f KB)",
-             prompt->filename,
-             (int)prompt->samples,
-             duration_ms,
-             file_size / 1024.0f);
+        prompt->data = (const uint8_t *)s_store_map + e->offset;
+        prompt->data_bytes = e->data_bytes;
+        prompt->samples = e->samples;
+        prompt->codec = e->codec;
+        prompt->loaded = true;
+
+        ESP_LOGI(TAG, "✅ 音效已索引: %s (%d samples, %.1f ms, %.1f KB %s)",
+                 prompt->name,
+                 (int)prompt->samples,
+                 (prompt->samples * 1000.0f) / PROMPT_SAMPLE_RATE,
+                 prompt->data_bytes / 1024.0f,
+                 prompt->codec == PROMPT_CODEC_IMA_ADPCM ? "ADPCM" : "PCM");
+        return ESP_OK;
+    }
 
-    return ESP_OK;
+    ESP_LOGW(TAG, "音效不在分区中: %s", prompt->name);
+    return ESP_ERR_NOT_FOUND;
 }
 
 /**
- * @brief 卸载单个音效
+ * @brief 将音效分块解码并推入播放缓冲区
+ *
+ * 每次只解码 PROMPT_DECODE_SAMPLES 个采样点，空闲音效不占用任何 RAM。
  */
-static void unload_prompt(audio_prompt_type_t type)
+static esp_err_t stream_prompt(const prompt_info_t *prompt)
 {
-    if (type >= AUDIO_PROMPT_MAX) return;
+    esp_err_t ret = ESP_OK;
+    size_t remaining = prompt->samples;
+
+    if (prompt->codec == PROMPT_CODEC_PCM16) {
+        // Flash 映射区可直接读取，无需额外拷贝
+        const int16_t *pcm = (const int16_t *)prompt->data;
+        while (remaining > 0 && ret == ESP_OK) {
+            size_t n = remaining > PROMPT_DECODE_SAMPLES ? PROMPT_DECODE_SAMPLES : remaining;
+            ret = audio_manager_play_audio_source(PLAYBACK_SOURCE_PROMPT, pcm, n);
+            pcm += n;
+            remaining -= n;
+        }
+        return ret;
+    }
 
-    prompt_info_t *prompt = &s_prompts[type];
-    if (prompt->data) {
-        heap_caps_free(prompt->data);
-        prompt->data = NULL;
+    ima_adpcm_state_t st = { .predictor = 0, .step_index = 0 };
+    const uint8_t *src = prompt->data;
+
+    while (remaining > 0 && ret == ESP_OK) {
+        size_t n = remaining > PROMPT_DECODE_SAMPLES ? PROMPT_DECODE_SAMPLES : remaining;
+
+        // PROMPT_DECODE_SAMPLES 为偶数，块边界总是落在整字节上
+        for (size_t i = 0; i < n; i += 2) {
+            uint8_t byte = *src++;
+            s_decode_buf[i] = ima_adpcm_decode_nibble(&st, byte & 0x0F);
+            if (i + 1 < n) {
+                s_decode_buf[i + 1] = ima_adpcm_decode_nibble(&st, byte >> 4);
+            }
+        }
+
+        ret = audio_manager_play_audio_source(PLAYBACK_SOURCE_PROMPT, s_decode_buf, n);
+        remaining -= n;
     }
-    prompt->samples = 0;
-    prompt->loaded = false;
+
+    return ret;
 }
 
 // ============ 公共API实现 ============
@@ -149,35 +271,36 @@ esp_err_t audio_prompt_init(void)
 
     ESP_LOGI(TAG, "======== 初始化音效模块 ========");
 
-    esp_err_t ret = audio_prompt_mount_spiffs();
+    if (!s_play_mutex) {
+        s_play_mutex = xSemaphoreCreateMutex();
+        if (!s_play_mutex) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    esp_err_t ret = prompt_store_map();
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "挂载音效 SPIFFS 失败: %s", esp_err_to_name(ret));
         return ret;
     }
 
     int loaded_count = 0;
-    int failed_count = 0;
 
-    // 预加载所有音效
     for (int i = 0; i < AUDIO_PROMPT_MAX; i++) {
-        esp_err_t load_ret = load_prompt(i);
-        if (load_ret == ESP_OK) {
+        if (load_prompt(i) == ESP_OK) {
             loaded_count++;
-        } else {
-            failed_count++;
-            // 音效加载失败不是致命错误，继续加载其他音效
-            ESP_LOGW(TAG, "音效 %d 加载失败，将跳过", i);
         }
     }
 
     if (loaded_count == 0) {
-        ESP_LOGE(TAG, "❌ 所有音效加载失败");
+        ESP_LOGE(TAG, "❌ 分区中没有可用音效");
+        esp_partition_munmap(s_store_map_handle);
+        s_store_map = NULL;
         return ESP_ERR_NOT_FOUND;
     }
 
     s_initialized = true;
 
-    ESP_LOGI(TAG, "✅ 音效模块初始化完成: 成功加载 %d/%d 个音效",
+    ESP_LOGI(TAG, "✅ 音效模块初始化完成: 索引 %d/%d 个音效（Flash映射，0 字节 PSRAM）",
              loaded_count, AUDIO_PROMPT_MAX);
 
     return ESP_OK;
@@ -189,12 +312,21 @@ void audio_prompt_deinit(void)
 
     ESP_LOGI(TAG, "卸载音效模块...");
 
-    // 卸载所有音效
+    xSemaphoreTake(s_play_mutex, portMAX_DELAY);
     for (int i = 0; i < AUDIO_PROMPT_MAX; i++) {
-        unload_prompt(i);
+        s_prompts[i].data = NULL;
+        s_prompts[i].data_bytes = 0;
+        s_prompts[i].samples = 0;
+        s_prompts[i].loaded = false;
+    }
+
+    if (s_store_map) {
+        esp_partition_munmap(s_store_map_handle);
+        s_store_map = NULL;
     }
 
     s_initialized = false;
+    xSemaphoreGive(s_play_mutex);
     ESP_LOGI(TAG, "音效模块已卸载");
 }
 
@@ -219,11 +351,12 @@ esp_err_t audio_prompt_play(audio_prompt_type_t type)
     // 确保播放任务运行
     audio_manager_start_playback();
 
-    // 播放音效
-    esp_err_t ret = audio_manager_play_audio(prompt->data, prompt->samples);
+    xSemaphoreTake(s_play_mutex, portMAX_DELAY);
+    esp_err_t ret = stream_prompt(prompt);
+    xSemaphoreGive(s_play_mutex);
 
     if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "播放音效 %d (%s)", type, prompt->filename);
+        ESP_LOGI(TAG, "播放音效 %d (%s)", type, prompt->name);
     } else {
         ESP_LOGW(TAG, "音效播放失败: %s", esp_err_to_name(ret));
     }
@@ -231,70 +364,112 @@ esp_err_t audio_prompt_play(audio_prompt_type_t type)
     return ret;
 }
 
+/**
+ * @brief 文件播放任务：逐块取走加载器预读的数据写入提示音输入源
+ *
+ * 写入会等待输入源腾出空间，所以不能放在加载器的推送回调里（回调不能阻塞）；
+ * 拉取流最多预读 ASSET_LOADER_READ_AHEAD 块，读取节奏跟随播放速度。
+ * 整个文件在 s_play_mutex 内写完，前后两段提示音不会交错。块长度为偶数，采样点不会跨块。
+ */
+static void prompt_file_task(void *arg)
+{
+    (void)arg;
+    asset_stream_handle_t stream;
+
+    while (1) {
+        xQueueReceive(s_file_queue, &stream, portMAX_DELAY);
+
+        uint32_t gen = s_stop_gen;
+        size_t total = 0;
+        asset_chunk_t chunk;
+        esp_err_t ret = ESP_OK;
+
+        xSemaphoreTake(s_play_mutex, portMAX_DELAY);
+        while (1) {
+            ret = asset_loader_stream_read(stream, &chunk, pdMS_TO_TICKS(PROMPT_FILE_READ_TIMEOUT_MS));
+            if (ret != ESP_OK) {
+                break;
+            }
+            ret = chunk.err;
+            size_t samples = chunk.len / sizeof(int16_t);
+            if (ret == ESP_OK && samples > 0 && gen == s_stop_gen) {
+                ret = audio_manager_play_audio_source(PLAYBACK_SOURCE_PROMPT, (const int16_t *)chunk.data, samples);
+            }
+            total = chunk.total;
+            bool last = chunk.last;
+            asset_loader_stream_release(stream, &chunk);
+            if (last || ret != ESP_OK || gen != s_stop_gen) {
+                break;
+            }
+        }
+        xSemaphoreGive(s_play_mutex);
+        asset_loader_close(stream);
+
+        if (gen != s_stop_gen) {
+            ESP_LOGI(TAG, "文件播放已停止");
+        } else if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "播放PCM文件失败: %s", esp_err_to_name(ret));
+        } else if (total < sizeof(int16_t)) {
+            ESP_LOGE(TAG, "无效的PCM文件（空文件）");
+        } else {
+            ESP_LOGI(TAG, "文件播放完成: %d samples", (int)(total / sizeof(int16_t)));
+        }
+    }
+}
+
 esp_err_t audio_prompt_play_file(const char *filename)
 {
     if (!filename) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    // 检查文件是否存在
-    struct stat st;
-    if (stat(filename, &st) != 0) {
-        ESP_LOGE(TAG, "文件不存在: %s", filename);
-        return ESP_ERR_NOT_FOUND;
-    }
-
-    size_t file_size = st.st_size;
-    if (file_size == 0 || file_size % 2 != 0) {
-        ESP_LOGE(TAG, "无效的PCM文件大小: %d bytes", (int)file_size);
-        return ESP_ERR_INVALID_SIZE;
+    if (!s_play_mutex) {
+        ESP_LOGE(TAG, "音效模块未初始化");
+        return ESP_ERR_INVALID_STATE;
     }
 
-    // 打开文件
-    FILE *fp = fopen(filename, "rb");
-    if (!fp) {
-        ESP_LOGE(TAG, "无法打开文件: %s", filename);
-        return ESP_ERR_NOT_FOUND;
+    // 文件播放任务首次使用时创建
+    xSemaphoreTake(s_play_mutex, portMAX_DELAY);
+    if (!s_file_queue) {
+        s_file_queue = xQueueCreate(PROMPT_FILE_QUEUE_LEN, sizeof(asset_stream_handle_t));
+        if (s_file_queue &&
+            xTaskCreate(prompt_file_task, "prompt_file", PROMPT_FILE_TASK_STACK, NULL,
+                        PROMPT_FILE_TASK_PRIO, NULL) != pdPASS) {
+            vQueueDelete(s_file_queue);
+            s_file_queue = NULL;
+        }
     }
-
-    // 分配临时缓冲区
-    int16_t *buffer = (int16_t *)malloc(file_size);
-    if (!buffer) {
-        ESP_LOGE(TAG, "内存分配失败: %d bytes", (int)file_size);
-        fclose(fp);
+    xSemaphoreGive(s_play_mutex);
+    if (!s_file_queue) {
+        ESP_LOGE(TAG, "文件播放任务创建失败");
         return ESP_ERR_NO_MEM;
     }
 
-    // 读取文件
-    size_t read_bytes = fread(buffer, 1, file_size, fp);
-    fclose(fp);
-
-    if (read_bytes != file_size) {
-        ESP_LOGE(TAG, "文件读取失败: %s", filename);
-        free(buffer);
-        return ESP_FAIL;
-    }
-
     // 确保播放任务运行
     audio_manager_start_playback();
 
-    // 播放
-    size_t samples = file_size / sizeof(int16_t);
-    esp_err_t ret = audio_manager_play_audio(buffer, samples);
-
-    free(buffer);
-
-    if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "播放文件: %s (%d samples)", filename, (int)samples);
+    // 文件由资源加载器在后台预读，调用方不阻塞在文件系统上
+    asset_stream_handle_t stream;
+    esp_err_t ret = asset_loader_open(filename, &stream);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "提交文件读取失败: %s (%s)", filename, esp_err_to_name(ret));
+        return ret;
+    }
+    if (xQueueSend(s_file_queue, &stream, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "待播放文件过多，忽略: %s", filename);
+        asset_loader_close(stream);
+        return ESP_ERR_NO_MEM;
     }
 
-    return ret;
+    ESP_LOGI(TAG, "播放文件: %s", filename);
+    return ESP_OK;
 }
 
 void audio_prompt_stop(void)
 {
-    // 停止播放任务（会清空播放缓冲区）
-    audio_manager_stop_playback();
+    // 只丢弃提示音输入源，TTS 等其他输入源继续播放；正在播放的文件不再继续写入
+    s_stop_gen++;
+    audio_manager_clear_playback_source(PLAYBACK_SOURCE_PROMPT);
 }
 
 bool audio_prompt_is_loaded(audio_prompt_type_t type)
@@ -323,9 +498,8 @@ esp_err_t audio_prompt_get_info(audio_prompt_type_t type, size_t *samples, uint3
     }
 
     if (duration_ms) {
-        *duration_ms = (prompt->samples * 1000) / 16000;
+        *duration_ms = (prompt->samples * 1000) / PROMPT_SAMPLE_RATE;
     }
 
     return ESP_OK;
 }
-
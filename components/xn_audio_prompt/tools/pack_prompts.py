@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+音效分区打包工具
+
+把目录下的 16kHz/16bit/单声道 RAW PCM 文件（*.pcm）压缩为 IMA-ADPCM，
+连同紧凑索引一起打包成 prompt_store 分区镜像，供 audio_prompt 通过
+esp_partition_mmap 直接映射读取。
+
+镜像格式（小端）：
+    header  (16 B) : magic "XNPS", u16 version, u16 count, u32 image_size, u32 reserved
+    entry[] (32 B) : char name[16], u32 offset, u32 data_bytes, u32 samples,
+                     u16 sample_rate, u8 codec, u8 reserved
+    data           : 各音效压缩数据，4 字节对齐
+
+用法：
+    python pack_prompts.py --input ../prompts --output prompt_store.bin --size 0x40000
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b"XNPS"
+VERSION = 1
+HEADER_FMT = "<4sHHII"
+ENTRY_FMT = "<16sIIIHBB"
+HEADER_SIZE = struct.calcsize(HEADER_FMT)
+ENTRY_SIZE = struct.calcsize(ENTRY_FMT)
+
+CODEC_PCM16 = 0
+CODEC_IMA_ADPCM = 1
+
+SAMPLE_RATE = 16000
+
+INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8]
+
+STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767,
+]
+
+
+def ima_adpcm_encode(samples):
+    """IMA-ADPCM 编码，初始预测值与步长索引均为 0（与设备端解码器约定一致）"""
+    predictor = 0
+    index = 0
+    out = bytearray()
+    nibble_lo = None
+
+    for sample in samples:
+        step = STEP_TABLE[index]
+        diff = sample - predictor
+        code = 0
+        if diff < 0:
+            code = 8
+            diff = -diff
+
+        # 与解码器完全相同的量化路径，避免编解码累积误差
+        delta = step >> 3
+        if diff >= step:
+            code |= 4
+            diff -= step
+            delta += step
+        step >>= 1
+        if diff >= step:
+            code |= 2
+            diff -= step
+            delta += step
+        step >>= 1
+        if diff >= step:
+            code |= 1
+            delta += step
+
+        predictor = predictor - delta if code & 8 else predictor + delta
+        predictor = max(-32768, min(32767, predictor))
+        index = max(0, min(88, index + INDEX_TABLE[code]))
+
+        if nibble_lo is None:
+            nibble_lo = code
+        else:
+            out.append(nibble_lo | (code << 4))
+            nibble_lo = None
+
+    if nibble_lo is not None:
+        out.append(nibble_lo)
+
+    return bytes(out)
+
+
+def load_pcm(path):
+    with open(path, "rb") as fp:
+        raw = fp.read()
+    if len(raw) == 0 or len(raw) % 2 != 0:
+        raise ValueError("无效的PCM文件大小: %s (%d bytes)" % (path, len(raw)))
+    count = len(raw) // 2
+    return list(struct.unpack("<%dh" % count, raw))
+
+
+def align4(value):
+    return (value + 3) & ~3
+
+
+def build_image(input_dir, codec):
+    names = sorted(f for f in os.listdir(input_dir) if f.endswith(".pcm"))
+    if not names:
+        raise ValueError("目录中没有 .pcm 文件: %s" % input_dir)
+
+    entries = []
+    blobs = []
+    offset = align4(HEADER_SIZE + ENTRY_SIZE * len(names))
+
+    for filename in names:
+        stem = os.path.splitext(filename)[0]
+        if len(stem.encode("utf-8")) > 15:
+            raise ValueError("音效名称过长（最多15字节）: %s" % stem)
+
+        samples = load_pcm(os.path.join(input_dir, filename))
+        if codec == CODEC_IMA_ADPCM:
+            blob = ima_adpcm_encode(samples)
+        else:
+            blob = struct.pack("<%dh" % len(samples), *samples)
+
+        entries.append(struct.pack(ENTRY_FMT, stem.encode("utf-8"), offset, len(blob),
+                                   len(samples), SAMPLE_RATE, codec, 0))
+        blobs.append((offset, blob))
+        print("  %-16s %6d samples  %7d -> %6d bytes" % (stem, len(samples), len(samples) * 2, len(blob)))
+        offset = align4(offset + len(blob))
+
+    image = bytearray(offset)
+    struct.pack_into(HEADER_FMT, image, 0, MAGIC, VERSION, len(names), offset, 0)
+    for i, entry in enumerate(entries):
+        image[HEADER_SIZE + i * ENTRY_SIZE:HEADER_SIZE + (i + 1) * ENTRY_SIZE] = entry
+    for blob_offset, blob in blobs:
+        image[blob_offset:blob_offset + len(blob)] = blob
+
+    return bytes(image)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="打包 prompt_store 音效分区镜像")
+    parser.add_argument("--input", required=True, help="RAW PCM 源目录")
+    parser.add_argument("--output", required=True, help="输出镜像路径")
+    parser.add_argument("--size", type=lambda v: int(v, 0), default=0,
+                        help="分区大小（用于容量校验，0 表示不校验）")
+    parser.add_argument("--raw", action="store_true", help="不压缩，直接存储 PCM16")
+    args = parser.parse_args()
+
+    codec = CODEC_PCM16 if args.raw else CODEC_IMA_ADPCM
+    try:
+        image = build_image(args.input, codec)
+    except ValueError as err:
+        print("错误: %s" % err, file=sys.stderr)
+        return 1
+
+    if args.size and len(image) > args.size:
+        print("错误: 镜像 %d 字节超出分区大小 %d 字节" % (len(image), args.size), file=sys.stderr)
+        return 1
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "wb") as fp:
+        fp.write(image)
+
+    print("prompt_store 镜像: %s (%d bytes)" % (args.output, len(image)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
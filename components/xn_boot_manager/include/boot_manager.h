@@ -0,0 +1,131 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-02 10:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-02 10:12:40
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_boot_manager\include\boot_manager.h
+ * @Description: 启动编排模块 - 按依赖图在双核工作线程上并行执行各子系统初始化
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BOOT_MANAGER_MAX_STAGES      16     ///< 最多可注册的启动阶段数
+#define BOOT_MANAGER_MAX_DEPS        4      ///< 单个阶段最多依赖数
+#define BOOT_MANAGER_MAX_MILESTONES  8      ///< 最多可记录的里程碑数
+#define BOOT_STAGE_ANY_CORE          (-1)   ///< 阶段可在任意核心执行
+
+/** 启动阶段初始化函数 */
+typedef esp_err_t (*boot_stage_fn_t)(void *arg);
+
+/** 启动阶段描述 */
+typedef struct {
+    const char *name;                               ///< 阶段名称（唯一，供依赖引用）
+    boot_stage_fn_t init;                           ///< 初始化函数
+    void *arg;                                      ///< 初始化函数参数
+    const char *deps[BOOT_MANAGER_MAX_DEPS];        ///< 依赖的阶段名称（未用项为 NULL）
+    int core;                                       ///< 指定执行核心，BOOT_STAGE_ANY_CORE 表示不限
+    bool interactive;                               ///< 计入"可交互时间"（TTI）
+} boot_stage_t;
+
+/** 启动阶段状态 */
+typedef enum {
+    BOOT_STAGE_PENDING = 0,     ///< 等待依赖
+    BOOT_STAGE_RUNNING,         ///< 执行中
+    BOOT_STAGE_DONE,            ///< 成功
+    BOOT_STAGE_FAILED,          ///< 初始化函数返回错误
+    BOOT_STAGE_SKIPPED,         ///< 依赖失败/依赖环，未执行
+} boot_stage_state_t;
+
+/** 单个阶段的执行记录（时间均为开机后微秒） */
+typedef struct {
+    const char *name;           ///< 阶段名称
+    boot_stage_state_t state;   ///< 最终状态
+    esp_err_t err;              ///< 初始化函数返回值
+    int core;                   ///< 实际执行核心
+    int64_t start_us;           ///< 开始时间
+    int64_t end_us;             ///< 结束时间
+} boot_stage_record_t;
+
+/** 启动编排配置 */
+typedef struct {
+    uint32_t worker_stack_size; ///< 工作线程栈大小（字节）
+    int worker_priority;        ///< 工作线程优先级
+    uint32_t timeout_ms;        ///< boot_manager_run 最长等待时间
+} boot_manager_config_t;
+
+#define BOOT_MANAGER_DEFAULT_CONFIG() {         \
+        .worker_stack_size = 8 * 1024,          \
+        .worker_priority   = 5,                 \
+        .timeout_ms        = 30000,             \
+    }
+
+/**
+ * @brief 注册启动阶段（须在 boot_manager_run 之前调用）
+ * @param stage 阶段描述（内容会被拷贝，name/deps 字符串需保持有效）
+ * @return
+ *      - ESP_OK: 成功
+ *      - ESP_ERR_INVALID_ARG: 参数无效或名称重复
+ *      - ESP_ERR_NO_MEM: 超出 BOOT_MANAGER_MAX_STAGES
+ *      - ESP_ERR_INVALID_STATE: 已经开始执行
+ */
+esp_err_t boot_manager_register(const boot_stage_t *stage);
+
+/**
+ * @brief 按依赖图并行执行所有已注册阶段，阻塞直到全部结束
+ * @note 每个核心一个工作线程；无依赖关系的阶段并行执行。
+ *       某个核心的工作线程创建失败时，指定该核心的阶段改由其他工作线程执行（日志中逐个列出）
+ * @param config 配置，NULL 使用 BOOT_MANAGER_DEFAULT_CONFIG
+ * @return
+ *      - ESP_OK: 全部阶段成功
+ *      - ESP_ERR_NO_MEM: 一个工作线程也没有创建成功
+ *      - ESP_ERR_NOT_FOUND: 依赖了未注册的阶段
+ *      - ESP_FAIL: 存在失败或被跳过的阶段（详见启动报告）
+ *      - ESP_ERR_TIMEOUT: 超时
+ */
+esp_err_t boot_manager_run(const boot_manager_config_t *config);
+
+/**
+ * @brief 记录启动里程碑（如"唤醒词就绪"），可在任意任务中调用
+ * @param name 里程碑名称（字符串需保持有效）
+ */
+void boot_manager_mark(const char *name);
+
+/**
+ * @brief 获取可交互时间（所有 interactive 阶段完成的时刻）
+ * @return 开机后毫秒数，尚未达到返回 -1
+ */
+int32_t boot_manager_get_tti_ms(void);
+
+/**
+ * @brief 获取里程碑时间
+ * @param name 里程碑名称
+ * @return 开机后毫秒数，未记录返回 -1
+ */
+int32_t boot_manager_get_milestone_ms(const char *name);
+
+/**
+ * @brief 获取阶段执行记录
+ * @param records 输出数组
+ * @param max_count 数组容量
+ * @return 实际写入条数
+ */
+size_t boot_manager_get_records(boot_stage_record_t *records, size_t max_count);
+
+/**
+ * @brief 打印启动报告（各阶段时间线、TTI、里程碑）
+ */
+void boot_manager_print_report(void);
+
+#ifdef __cplusplus
+}
+#endif
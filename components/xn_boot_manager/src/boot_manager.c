@@ -0,0 +1,468 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-02 10:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-02 10:12:40
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_boot_manager\src\boot_manager.c
+ * @Description: 启动编排模块实现
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include "boot_manager.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_bit_defs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "BOOT_MGR";
+
+#define BOOT_WORKER_IDLE_WAIT_MS 50     ///< 无可执行阶段时的兜底等待（防止通知丢失）
+
+/** 阶段内部状态 */
+typedef struct {
+    boot_stage_t desc;                          ///< 注册时的描述
+    int dep_idx[BOOT_MANAGER_MAX_DEPS];         ///< 依赖的阶段下标（-1 表示无）
+    boot_stage_record_t record;                 ///< 执行记录
+} boot_stage_ctx_t;
+
+/** 里程碑 */
+typedef struct {
+    const char *name;
+    int64_t time_us;
+} boot_milestone_t;
+
+/** 模块上下文 */
+typedef struct {
+    boot_stage_ctx_t stages[BOOT_MANAGER_MAX_STAGES];
+    size_t stage_count;
+    boot_milestone_t milestones[BOOT_MANAGER_MAX_MILESTONES];
+    size_t milestone_count;
+    int running_count;                          ///< 正在执行的阶段数
+    bool started;                               ///< 已调用 boot_manager_run
+    int64_t tti_us;                             ///< 可交互时间（0 表示尚未达到）
+    SemaphoreHandle_t mutex;                    ///< 保护阶段状态
+    EventGroupHandle_t done_group;              ///< 每个工作线程退出时置位
+    TaskHandle_t workers[portNUM_PROCESSORS];   ///< 工作线程（每核一个）
+} boot_manager_ctx_t;
+
+static boot_manager_ctx_t s_ctx = {0};
+
+// ============ 内部函数 ============
+
+static int boot_find_stage(const char *name)
+{
+    for (size_t i = 0; i < s_ctx.stage_count; i++) {
+        if (strcmp(s_ctx.stages[i].desc.name, name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static bool boot_state_finished(boot_stage_state_t state)
+{
+    return state == BOOT_STAGE_DONE || state == BOOT_STAGE_FAILED || state == BOOT_STAGE_SKIPPED;
+}
+
+/**
+ * @brief 依赖失败的阶段标记为跳过（需持有 mutex）
+ */
+static void boot_propagate_failures(void)
+{
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < s_ctx.stage_count; i++) {
+            boot_stage_ctx_t *st = &s_ctx.stages[i];
+            if (st->record.state != BOOT_STAGE_PENDING) {
+                continue;
+            }
+            for (int d = 0; d < BOOT_MANAGER_MAX_DEPS && st->dep_idx[d] >= 0; d++) {
+                boot_stage_state_t dep_state = s_ctx.stages[st->dep_idx[d]].record.state;
+                if (dep_state == BOOT_STAGE_FAILED || dep_state == BOOT_STAGE_SKIPPED) {
+                    ESP_LOGW(TAG, "阶段 %s 跳过：依赖 %s 未成功",
+                             st->desc.name, s_ctx.stages[st->dep_idx[d]].desc.name);
+                    st->record.state = BOOT_STAGE_SKIPPED;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief 查找一个依赖已全部完成、且允许在该核心执行的阶段（需持有 mutex）
+ *
+ * 指定核心的工作线程没有创建成功时，该阶段由任意存活的工作线程执行。
+ *
+ * @param core 工作线程所在核心，BOOT_STAGE_ANY_CORE 表示忽略核心约束
+ * @return 阶段下标，无可执行阶段返回 -1
+ */
+static int boot_pick_stage(int core)
+{
+    for (size_t i = 0; i < s_ctx.stage_count; i++) {
+        boot_stage_ctx_t *st = &s_ctx.stages[i];
+        if (st->record.state != BOOT_STAGE_PENDING) {
+            continue;
+        }
+        if (core != BOOT_STAGE_ANY_CORE && st->desc.core != BOOT_STAGE_ANY_CORE &&
+            st->desc.core != core && s_ctx.workers[st->desc.core]) {
+            continue;
+        }
+
+        bool ready = true;
+        for (int d = 0; d < BOOT_MANAGER_MAX_DEPS && st->dep_idx[d] >= 0; d++) {
+            if (s_ctx.stages[st->dep_idx[d]].record.state != BOOT_STAGE_DONE) {
+                ready = false;
+                break;
+            }
+        }
+        if (ready) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static bool boot_all_finished(void)
+{
+    for (size_t i = 0; i < s_ctx.stage_count; i++) {
+        if (!boot_state_finished(s_ctx.stages[i].record.state)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 所有 interactive 阶段结束后记录 TTI（需持有 mutex）
+ */
+static void boot_update_tti(void)
+{
+    if (s_ctx.tti_us) {
+        return;
+    }
+
+    bool has_interactive = false;
+    int64_t latest = 0;
+    for (size_t i = 0; i < s_ctx.stage_count; i++) {
+        boot_stage_ctx_t *st = &s_ctx.stages[i];
+        if (!st->desc.interactive) {
+            continue;
+        }
+        has_interactive = true;
+        if (!boot_state_finished(st->record.state)) {
+            return;
+        }
+        if (st->record.end_us > latest) {
+            latest = st->record.end_us;
+        }
+    }
+
+    if (!has_interactive) {
+        if (!boot_all_finished()) {
+            return;
+        }
+        latest = esp_timer_get_time();
+    }
+
+    s_ctx.tti_us = latest;
+    ESP_LOGI(TAG, "🏁 可交互 (TTI): %lld ms", s_ctx.tti_us / 1000);
+}
+
+static void boot_kick_workers(void)
+{
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        if (s_ctx.workers[i]) {
+            xTaskNotifyGive(s_ctx.workers[i]);
+        }
+    }
+}
+
+/**
+ * @brief 启动工作线程：循环领取可执行阶段，直到全部阶段结束
+ *
+ * @param arg 所在核心编号
+ */
+static void boot_worker_task(void *arg)
+{
+    const int core = (int)(intptr_t)arg;
+
+    while (true) {
+        xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
+        boot_propagate_failures();
+
+        int idx = boot_pick_stage(core);
+        if (idx < 0 && s_ctx.running_count == 0 && boot_pick_stage(BOOT_STAGE_ANY_CORE) < 0) {
+            // 没有阶段在执行，也没有任何核心能执行的阶段：剩余阶段存在依赖环
+            for (size_t i = 0; i < s_ctx.stage_count; i++) {
+                if (s_ctx.stages[i].record.state == BOOT_STAGE_PENDING) {
+                    ESP_LOGE(TAG, "阶段 %s 跳过：存在循环依赖", s_ctx.stages[i].desc.name);
+                    s_ctx.stages[i].record.state = BOOT_STAGE_SKIPPED;
+                }
+            }
+        }
+
+        boot_stage_ctx_t *st = NULL;
+        if (idx >= 0) {
+            st = &s_ctx.stages[idx];
+            st->record.state = BOOT_STAGE_RUNNING;
+            st->record.core = core;
+            st->record.start_us = esp_timer_get_time();
+            s_ctx.running_count++;
+        }
+        bool finished = boot_all_finished();
+        if (finished) {
+            boot_update_tti();
+        }
+        xSemaphoreGive(s_ctx.mutex);
+
+        if (finished) {
+            break;
+        }
+
+        if (!st) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BOOT_WORKER_IDLE_WAIT_MS));
+            continue;
+        }
+
+        ESP_LOGI(TAG, "▶️ [core%d] %s", core, st->desc.name);
+        esp_err_t err = st->desc.init ? st->desc.init(st->desc.arg) : ESP_OK;
+        int64_t end_us = esp_timer_get_time();
+
+        xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
+        st->record.end_us = end_us;
+        st->record.err = err;
+        st->record.state = (err == ESP_OK) ? BOOT_STAGE_DONE : BOOT_STAGE_FAILED;
+        s_ctx.running_count--;
+        boot_propagate_failures();
+        boot_update_tti();
+        boot_kick_workers();    // 持锁通知，避免通知到已退出的工作线程
+        xSemaphoreGive(s_ctx.mutex);
+
+        if (err == ESP_OK) {
+            ESP_LOGI(TAG, "✅ [core%d] %s %lld ms", core, st->desc.name,
+                     (end_us - st->record.start_us) / 1000);
+        } else {
+            ESP_LOGE(TAG, "❌ [core%d] %s 失败: %s", core, st->desc.name, esp_err_to_name(err));
+        }
+    }
+
+    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
+    s_ctx.workers[core] = NULL;
+    xSemaphoreGive(s_ctx.mutex);
+
+    xEventGroupSetBits(s_ctx.done_group, BIT(core));
+    vTaskDelete(NULL);
+}
+
+// ============ 公共 API 实现 ============
+
+esp_err_t boot_manager_register(const boot_stage_t *stage)
+{
+    if (!stage || !stage->name || !stage->init) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_ctx.started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_ctx.stage_count >= BOOT_MANAGER_MAX_STAGES) {
+        ESP_LOGE(TAG, "启动阶段过多: %s", stage->name);
+        return ESP_ERR_NO_MEM;
+    }
+    if (stage->core != BOOT_STAGE_ANY_CORE && (stage->core < 0 || stage->core >= portNUM_PROCESSORS)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (boot_find_stage(stage->name) >= 0) {
+        ESP_LOGE(TAG, "启动阶段重名: %s", stage->name);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    boot_stage_ctx_t *st = &s_ctx.stages[s_ctx.stage_count++];
+    memset(st, 0, sizeof(*st));
+    st->desc = *stage;
+    st->record.name = stage->name;
+    st->record.state = BOOT_STAGE_PENDING;
+    st->record.core = BOOT_STAGE_ANY_CORE;
+    return ESP_OK;
+}
+
+esp_err_t boot_manager_run(const boot_manager_config_t *config)
+{
+    boot_manager_config_t cfg = BOOT_MANAGER_DEFAULT_CONFIG();
+    if (config) {
+        cfg = *config;
+    }
+
+    if (s_ctx.started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // 解析依赖名称
+    for (size_t i = 0; i < s_ctx.stage_count; i++) {
+        boot_stage_ctx_t *st = &s_ctx.stages[i];
+        for (int d = 0; d < BOOT_MANAGER_MAX_DEPS; d++) {
+            st->dep_idx[d] = -1;
+        }
+        int n = 0;
+        for (int d = 0; d < BOOT_MANAGER_MAX_DEPS; d++) {
+            if (!st->desc.deps[d]) {
+                continue;
+            }
+            int dep = boot_find_stage(st->desc.deps[d]);
+            if (dep < 0) {
+                ESP_LOGE(TAG, "阶段 %s 依赖未注册的阶段 %s", st->desc.name, st->desc.deps[d]);
+                return ESP_ERR_NOT_FOUND;
+            }
+            st->dep_idx[n++] = dep;
+        }
+    }
+
+    s_ctx.mutex = xSemaphoreCreateMutex();
+    s_ctx.done_group = xEventGroupCreate();
+    if (!s_ctx.mutex || !s_ctx.done_group) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_ctx.started = true;
+
+    ESP_LOGI(TAG, "======== 并行启动 %d 个阶段（%d 个工作线程）========",
+             (int)s_ctx.stage_count, portNUM_PROCESSORS);
+
+    // 先持锁创建全部工作线程，保证 workers[] 完整后再开始调度
+    EventBits_t all_bits = 0;
+    xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        char name[16];
+        snprintf(name, sizeof(name), "boot_w%d", core);
+        if (xTaskCreatePinnedToCore(boot_worker_task, name, cfg.worker_stack_size,
+                                    (void *)(intptr_t)core, cfg.worker_priority,
+                                    &s_ctx.workers[core], core) != pdPASS) {
+            ESP_LOGE(TAG, "工作线程 %d 创建失败", core);
+            s_ctx.workers[core] = NULL;
+            continue;
+        }
+        all_bits |= BIT(core);
+    }
+
+    // 指定核心没有工作线程的阶段改由其他核心执行（boot_pick_stage），逐个点名便于排查
+    for (size_t i = 0; all_bits && i < s_ctx.stage_count; i++) {
+        const boot_stage_t *desc = &s_ctx.stages[i].desc;
+        if (desc->core != BOOT_STAGE_ANY_CORE && !(all_bits & BIT(desc->core))) {
+            ESP_LOGW(TAG, "阶段 %s 指定的 core%d 没有工作线程，改由其他核心执行", desc->name, desc->core);
+        }
+    }
+    xSemaphoreGive(s_ctx.mutex);
+
+    if (!all_bits) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    EventBits_t bits = xEventGroupWaitBits(s_ctx.done_group, all_bits, pdFALSE, pdTRUE,
+                                           pdMS_TO_TICKS(cfg.timeout_ms));
+    if ((bits & all_bits) != all_bits) {
+        ESP_LOGE(TAG, "启动超时 (%u ms)", (unsigned)cfg.timeout_ms);
+        boot_manager_print_report();
+        return ESP_ERR_TIMEOUT;
+    }
+
+    boot_manager_print_report();
+
+    for (size_t i = 0; i < s_ctx.stage_count; i++) {
+        if (s_ctx.stages[i].record.state != BOOT_STAGE_DONE) {
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+void boot_manager_mark(const char *name)
+{
+    if (!name) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    if (s_ctx.mutex) {
+        xSemaphoreTake(s_ctx.mutex, portMAX_DELAY);
+    }
+
+    bool recorded = false;
+    for (size_t i = 0; i < s_ctx.milestone_count; i++) {
+        if (strcmp(s_ctx.milestones[i].name, name) == 0) {
+            recorded = true;    // 只记录首次到达
+            break;
+        }
+    }
+    if (!recorded && s_ctx.milestone_count < BOOT_MANAGER_MAX_MILESTONES) {
+        s_ctx.milestones[s_ctx.milestone_count].name = name;
+        s_ctx.milestones[s_ctx.milestone_count].time_us = now;
+        s_ctx.milestone_count++;
+    }
+
+    if (s_ctx.mutex) {
+        xSemaphoreGive(s_ctx.mutex);
+    }
+
+    if (!recorded) {
+        ESP_LOGI(TAG, "🏁 里程碑 %s: %lld ms", name, now / 1000);
+    }
+}
+
+int32_t boot_manager_get_tti_ms(void)
+{
+    return s_ctx.tti_us ? (int32_t)(s_ctx.tti_us / 1000) : -1;
+}
+
+int32_t boot_manager_get_milestone_ms(const char *name)
+{
+    if (!name) {
+        return -1;
+    }
+    for (size_t i = 0; i < s_ctx.milestone_count; i++) {
+        if (strcmp(s_ctx.milestones[i].name, name) == 0) {
+            return (int32_t)(s_ctx.milestones[i].time_us / 1000);
+        }
+    }
+    return -1;
+}
+
+size_t boot_manager_get_records(boot_stage_record_t *records, size_t max_count)
+{
+    if (!records) {
+        return 0;
+    }
+
+    size_t n = s_ctx.stage_count < max_count ? s_ctx.stage_count : max_count;
+    for (size_t i = 0; i < n; i++) {
+        records[i] = s_ctx.stages[i].record;
+    }
+    return n;
+}
+
+void boot_manager_print_report(void)
+{
+    static const char *state_str[] = {"pending", "running", "ok", "FAILED", "skipped"};
+
+    ESP_LOGI(TAG, "======== 启动报告 ========");
+    for (size_t i = 0; i < s_ctx.stage_count; i++) {
+        const boot_stage_record_t *r = &s_ctx.stages[i].record;
+        int64_t start_ms = r->start_us / 1000;
+        int64_t end_ms = r->end_us / 1000;
+        ESP_LOGI(TAG, "  %-12s core%-2d %6lld -> %6lld ms (%5lld ms) %s%s",
+                 r->name, r->core, start_ms, end_ms,
+                 r->end_us ? end_ms - start_ms : 0,
+                 state_str[r->state],
+                 s_ctx.stages[i].desc.interactive ? " *" : "");
+    }
+    ESP_LOGI(TAG, "  TTI: %d ms (* 计入可交互)", (int)boot_manager_get_tti_ms());
+    for (size_t i = 0; i < s_ctx.milestone_count; i++) {
+        ESP_LOGI(TAG, "  里程碑 %-12s %6lld ms", s_ctx.milestones[i].name,
+                 s_ctx.milestones[i].time_us / 1000);
+    }
+}
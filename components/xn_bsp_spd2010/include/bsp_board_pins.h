@@ -0,0 +1,33 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 16:20:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 16:20:00
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_bsp_spd2010\include\bsp_board_pins.h
+ * @Description: 板载外设占用的 GPIO 表，供应用层在配置自己的 GPIO 前检查冲突
+ *
+ * Copyright (c) 2026 by ${git_name_email}, All Rights Reserved.
+ */
+
+#pragma once
+
+#include "esp_err.h"
+
+/**
+ * @brief 查询 GPIO 是否已被板载外设（屏幕 QSPI / 背光 / I2C / 触摸）占用
+ *
+ * @return 占用者名称（如 "LCD_BL"、"TP_INT"），未占用或 gpio < 0 时返回 NULL
+ */
+const char *bsp_board_pin_owner(int gpio);
+
+/**
+ * @brief 检查一组应用 GPIO：不得与板载外设重叠，组内也不得重复
+ *
+ * 发现冲突时逐条打印错误日志（GPIO 号与双方用途）后返回错误；gpio < 0 的项跳过。
+ *
+ * @param gpios 待检查的 GPIO
+ * @param names 各 GPIO 的用途（日志用），可为 NULL
+ * @param count 个数
+ * @return ESP_OK 无冲突, ESP_ERR_INVALID_STATE 存在冲突, ESP_ERR_INVALID_ARG 参数错误
+ */
+esp_err_t bsp_board_check_pins(const int *gpios, const char *const *names, int count);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>  // For memcpy
 #include "esp_log.h"
 #include "driver/gpio.h"
@@ -14,6 +15,40 @@
 #define I2C_MASTER_FREQ_HZ          400000    /*!< I2C master clock frequency */
 #define I2C_MASTER_TIMEOUT_MS       1000
 
+/********************* I2C arbiter *********************/
+// All transactions on the shared bus (touch, TCA9554 expander) are queued to one
+// arbiter task, which always drains the high-priority queue first.
+#define I2C_ARBITER_QUEUE_LEN       8         /*!< Pending transactions per priority */
+#define I2C_ARBITER_TASK_STACK      4096
+#define I2C_ARBITER_TASK_PRIORITY   8         /*!< Above the LVGL task so touch reads are not delayed by rendering */
+#define I2C_DEVICE_CACHE_SIZE       4         /*!< Cached device handles (one per 7-bit address) */
+
+/**
+ * @brief Transaction priority
+ */
+typedef enum {
+    I2C_PRIO_HIGH = 0,      /*!< Latency sensitive (touch) */
+    I2C_PRIO_NORMAL,        /*!< Everything else (IO expander) */
+    I2C_PRIO_MAX,
+} i2c_prio_t;
+
+/**
+ * @brief Transaction body, executed in the arbiter task with exclusive bus access
+ */
+typedef esp_err_t (*i2c_txn_fn_t)(void *ctx);
+
+/**
+ * @brief Bus statistics (window since the last reset)
+ */
+typedef struct {
+    uint32_t transactions[I2C_PRIO_MAX];    /*!< Completed transactions per priority */
+    uint32_t errors;                        /*!< Transactions that returned an error */
+    uint32_t txn_per_s_x10;                 /*!< Transactions per second x10 */
+    uint32_t queue_wait_avg_us;             /*!< Average submit-to-start wait */
+    uint32_t queue_wait_max_us;             /*!< Worst submit-to-start wait */
+    uint32_t busy_permille;                 /*!< Bus busy time per mille */
+} i2c_bus_stats_t;
+
 // I2C bus handle
 extern i2c_master_bus_handle_t i2c_bus_handle;
 
@@ -29,6 +64,22 @@ void I2C_Deinit(void);
  * @brief Get I2C bus handle
  */
 i2c_master_bus_handle_t I2C_Get_Bus_Handle(void);
-// Reg addr is 8 bit
+// Reg addr is 8 bit, both go through the arbiter at I2C_PRIO_NORMAL
 esp_err_t I2C_Write(uint8_t Driver_addr, uint8_t Reg_addr, const uint8_t *Reg_data, uint32_t Length);
-esp_err_t I2C_Read(uint8_t Driver_addr, uint8_t Reg_addr, uint8_t *Reg_data, uint32_t Length);
\ No newline at end of file
+esp_err_t I2C_Read(uint8_t Driver_addr, uint8_t Reg_addr, uint8_t *Reg_data, uint32_t Length);
+/**
+ * @brief Run a transaction on the shared bus through the arbiter
+ * @param prio Queue priority
+ * @param fn Transaction body (may issue several I2C operations, they are not interleaved with other users)
+ * @param ctx Argument for fn
+ * @param timeout_ms Maximum time to wait for a queue slot
+ * @return Result of fn, or ESP_ERR_TIMEOUT if the queue stayed full
+ * @note Blocks until fn has run. Runs fn directly if the arbiter is not started.
+ */
+esp_err_t I2C_Submit(i2c_prio_t prio, i2c_txn_fn_t fn, void *ctx, uint32_t timeout_ms);
+/**
+ * @brief Get bus statistics
+ * @param stats Output
+ * @param reset Start a new statistics window after reading
+ */
+void I2C_Get_Stats(i2c_bus_stats_t *stats, bool reset);
\ No newline at end of file
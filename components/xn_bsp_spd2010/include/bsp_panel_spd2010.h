@@ -117,6 +117,15 @@ void Set_Backlight_Official(uint8_t Light);
  */
 esp_err_t SPD2010_Register_LVGL_Callback(lv_display_t *display);
 
+/**
+ * @brief 注册颜色数据传输完成回调
+ * @param cb 传输完成回调（SPI 中断上下文，需放在 IRAM 中）
+ * @param user_ctx 回调上下文
+ * @return esp_err_t 注册结果
+ * @note 与 SPD2010_Register_LVGL_Callback 二选一，后注册的生效
+ */
+esp_err_t SPD2010_Register_Trans_Done_Callback(esp_lcd_panel_io_color_trans_done_cb_t cb, void *user_ctx);
+
 /**
  * @brief 获取面板句柄
  * @return esp_lcd_panel_handle_t 面板句柄
@@ -34,7 +34,8 @@
 
 // 触摸控制引脚配置
 #define TOUCH_RST_PIN                   (-1)                // 复位引脚（-1表示不使用）
-#define TOUCH_INT_PIN                   (-1)                // 中断引脚（-1表示不使用，因为LVGL使用轮询方式）
+#define TOUCH_INT_BOARD_PIN             (4)                 // 板载 TP_INT 的物理引脚，不论是否启用中断都由触摸芯片驱动
+#define TOUCH_INT_PIN                   TOUCH_INT_BOARD_PIN // 中断引脚（TP_INT，低电平有效；-1表示不使用，退回每次轮询都读I2C）
 
 // 触摸屏坐标变换配置
 #define TOUCH_SWAP_XY                   0                   // 是否交换X和Y坐标
@@ -44,6 +45,24 @@
 // 触摸相关常量
 #define TOUCH_MAX_POINTS                5                   // 最大支持触摸点数
 #define TOUCH_DEBOUNCE_TIME_MS          50                  // 触摸防抖时间
+#define TOUCH_I2C_QUEUE_TIMEOUT_MS      20                  // 触摸读取等待I2C仲裁队列的超时
+
+/*********************
+ * 类型定义
+ *********************/
+
+// 触摸中断通知回调（在中断上下文中调用，必须放在IRAM且不能阻塞）
+typedef void (*touch_notify_cb_t)(void);
+
+// 触摸统计（统计窗口为上次重置到现在）
+typedef struct {
+    uint32_t irq_count;         // 触摸中断次数
+    uint32_t reads;             // 实际发起的I2C读取次数
+    uint32_t skipped_reads;     // 无中断、已松开时跳过的轮询次数
+    uint32_t latency_samples;   // 延迟采样数
+    uint32_t latency_avg_us;    // 中断边沿 -> 坐标交给LVGL 的平均延迟
+    uint32_t latency_max_us;    // 最大延迟
+} touch_stats_t;
 
 /*********************
  * 全局变量声明
@@ -64,6 +83,24 @@ bool      Touch_Get_xy_Official(uint16_t *touch_x, uint16_t *touch_y, uint16_t *
 esp_lcd_touch_handle_t Touch_Get_Handle_Official(void);
 bool      Touch_Is_Initialized_Official(void);
 
+/**
+ * @brief 是否由中断驱动（配置了 TOUCH_INT_PIN 且中断注册成功）
+ * @note 中断驱动时，松开状态下没有中断的轮询直接返回未按下，不访问I2C
+ */
+bool      Touch_Is_Interrupt_Driven(void);
+
+/**
+ * @brief 设置触摸中断通知回调（如唤醒LVGL任务立即读取）
+ */
+void      Touch_Set_Notify_Callback(touch_notify_cb_t cb);
+
+/**
+ * @brief 获取触摸统计
+ * @param stats 输出统计
+ * @param reset 读取后是否开始新的统计窗口
+ */
+void      Touch_Get_Stats(touch_stats_t *stats, bool reset);
+
 /*********************
  * 兼容性宏定义
  *********************/
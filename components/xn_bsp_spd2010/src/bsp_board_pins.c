@@ -0,0 +1,82 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 16:20:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 16:20:00
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_bsp_spd2010\src\bsp_board_pins.c
+ * @Description: 板载外设占用的 GPIO 表
+ *
+ * Copyright (c) 2026 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <stddef.h>
+
+#include "esp_log.h"
+
+#include "bsp_board_pins.h"
+#include "bsp_i2c_driver.h"
+#include "bsp_panel_spd2010.h"
+#include "bsp_touch_spd2010.h"
+
+static const char *TAG = "bsp_pins";
+
+typedef struct {
+    int         gpio;
+    const char *name;
+} bsp_pin_t;
+
+static const bsp_pin_t s_board_pins[] = {
+    { ESP_PANEL_LCD_SPI_IO_SCK,     "LCD_SCK" },
+    { ESP_PANEL_LCD_SPI_IO_DATA0,   "LCD_D0" },
+    { ESP_PANEL_LCD_SPI_IO_DATA1,   "LCD_D1" },
+    { ESP_PANEL_LCD_SPI_IO_DATA2,   "LCD_D2" },
+    { ESP_PANEL_LCD_SPI_IO_DATA3,   "LCD_D3" },
+    { ESP_PANEL_LCD_SPI_IO_CS,      "LCD_CS" },
+    { EXAMPLE_LCD_PIN_NUM_RST,      "LCD_RST" },
+    { EXAMPLE_LCD_PIN_NUM_BK_LIGHT, "LCD_BL" },
+    { I2C_SCL_IO,                   "I2C_SCL" },
+    { I2C_SDA_IO,                   "I2C_SDA" },
+    { TOUCH_RST_PIN,                "TP_RST" },
+    { TOUCH_INT_BOARD_PIN,          "TP_INT" },   // 物理引脚，驱动改为轮询时也不能给应用使用
+};
+
+const char *bsp_board_pin_owner(int gpio)
+{
+    if (gpio < 0) {
+        return NULL;
+    }
+    for (size_t i = 0; i < sizeof(s_board_pins) / sizeof(s_board_pins[0]); i++) {
+        if (s_board_pins[i].gpio == gpio) {
+            return s_board_pins[i].name;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t bsp_board_check_pins(const int *gpios, const char *const *names, int count)
+{
+    if (gpios == NULL || count < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    for (int i = 0; i < count; i++) {
+        if (gpios[i] < 0) {
+            continue;
+        }
+        const char *name  = (names && names[i]) ? names[i] : "app";
+        const char *owner = bsp_board_pin_owner(gpios[i]);
+        if (owner) {
+            ESP_LOGE(TAG, "❌ GPIO%d 同时用作 %s 和板载 %s", gpios[i], name, owner);
+            ret = ESP_ERR_INVALID_STATE;
+        }
+        for (int j = 0; j < i; j++) {
+            if (gpios[j] == gpios[i]) {
+                ESP_LOGE(TAG, "❌ GPIO%d 同时用作 %s 和 %s", gpios[i], name,
+                         (names && names[j]) ? names[j] : "app");
+                ret = ESP_ERR_INVALID_STATE;
+            }
+        }
+    }
+    return ret;
+}
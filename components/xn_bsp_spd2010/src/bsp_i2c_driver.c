@@ -2,18 +2,99 @@
  * @Author: xingnian jixingnian@gmail.com
  * @Date: 2025-11-10 15:33:02
  * @LastEditors: xingnian jixingnian@gmail.com
- * @LastEditTime: 2025-11-15 10:28:48
+ * @LastEditTime: 2025-12-03 17:20:41
  * @FilePath: \ESP_ChunFeng\main\bsp\bsp_i2c_driver\bsp_i2c_driver.c
- * @Description: 
- * 
- * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved. 
+ * @Description:
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
  */
 #include "bsp_i2c_driver.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
 
 static const char *I2C_TAG = "I2C";
 
 // I2C bus handle
 i2c_master_bus_handle_t i2c_bus_handle = NULL;
+
+/**
+ * @brief Queued transaction, lives on the submitter's stack until done is given
+ */
+typedef struct {
+    i2c_txn_fn_t fn;
+    void *ctx;
+    int64_t submit_us;
+    esp_err_t result;
+    SemaphoreHandle_t done;
+} i2c_txn_t;
+
+/**
+ * @brief Arbiter state
+ */
+static struct {
+    TaskHandle_t task;
+    QueueHandle_t queues[I2C_PRIO_MAX];     // i2c_txn_t * per priority
+    SemaphoreHandle_t pending;              // Counts queued transactions across all priorities
+
+    // Statistics, only written by the arbiter task
+    int64_t window_start_us;
+    uint32_t transactions[I2C_PRIO_MAX];
+    uint32_t errors;
+    uint64_t wait_total_us;
+    uint32_t wait_max_us;
+    uint64_t busy_us;
+} s_arb = {0};
+
+/**
+ * @brief Device handles are created once per address instead of add/remove per access
+ */
+static struct {
+    uint8_t addr;
+    i2c_master_dev_handle_t dev;
+} s_devices[I2C_DEVICE_CACHE_SIZE];
+
+/**
+ * @brief Arbiter task: always serves the high-priority queue first
+ */
+static void I2C_Arbiter_Task(void *arg)
+{
+    while (1) {
+        xSemaphoreTake(s_arb.pending, portMAX_DELAY);
+
+        i2c_txn_t *txn = NULL;
+        i2c_prio_t prio;
+        for (prio = I2C_PRIO_HIGH; prio < I2C_PRIO_MAX; prio++) {
+            if (xQueueReceive(s_arb.queues[prio], &txn, 0) == pdTRUE) {
+                break;
+            }
+        }
+        if (!txn) {
+            continue;
+        }
+
+        int64_t start_us = esp_timer_get_time();
+        txn->result = txn->fn(txn->ctx);
+        int64_t end_us = esp_timer_get_time();
+
+        uint32_t wait_us = (uint32_t)(start_us - txn->submit_us);
+        s_arb.transactions[prio]++;
+        s_arb.wait_total_us += wait_us;
+        if (wait_us > s_arb.wait_max_us) {
+            s_arb.wait_max_us = wait_us;
+        }
+        s_arb.busy_us += end_us - start_us;
+        if (txn->result != ESP_OK) {
+            s_arb.errors++;
+        }
+
+        xSemaphoreGive(txn->done);
+    }
+}
+
 /**
  * @brief Initialize I2C master bus
  */
@@ -41,6 +122,19 @@ esp_err_t I2C_Init(void)
         return ret;
     }
 
+    // Start the arbiter; without it transactions run directly in the caller
+    s_arb.pending = xSemaphoreCreateCounting(I2C_ARBITER_QUEUE_LEN * I2C_PRIO_MAX, 0);
+    for (int i = 0; i < I2C_PRIO_MAX; i++) {
+        s_arb.queues[i] = xQueueCreate(I2C_ARBITER_QUEUE_LEN, sizeof(i2c_txn_t *));
+    }
+    s_arb.window_start_us = esp_timer_get_time();
+    if (!s_arb.pending || !s_arb.queues[I2C_PRIO_HIGH] || !s_arb.queues[I2C_PRIO_NORMAL] ||
+        xTaskCreate(I2C_Arbiter_Task, "i2c_arbiter", I2C_ARBITER_TASK_STACK, NULL,
+                    I2C_ARBITER_TASK_PRIORITY, &s_arb.task) != pdPASS) {
+        ESP_LOGW(I2C_TAG, "Failed to start I2C arbiter, transactions will run unqueued");
+        s_arb.task = NULL;
+    }
+
     ESP_LOGI(I2C_TAG, "I2C master bus initialized successfully");
     return ESP_OK;
 }
@@ -50,6 +144,28 @@ esp_err_t I2C_Init(void)
  */
 void I2C_Deinit(void)
 {
+    if (s_arb.task) {
+        vTaskDelete(s_arb.task);
+        s_arb.task = NULL;
+    }
+    for (int i = 0; i < I2C_PRIO_MAX; i++) {
+        if (s_arb.queues[i]) {
+            vQueueDelete(s_arb.queues[i]);
+            s_arb.queues[i] = NULL;
+        }
+    }
+    if (s_arb.pending) {
+        vSemaphoreDelete(s_arb.pending);
+        s_arb.pending = NULL;
+    }
+
+    for (int i = 0; i < I2C_DEVICE_CACHE_SIZE; i++) {
+        if (s_devices[i].dev) {
+            i2c_master_bus_rm_device(s_devices[i].dev);
+            s_devices[i].dev = NULL;
+        }
+    }
+
     if (i2c_bus_handle != NULL) {
         i2c_del_master_bus(i2c_bus_handle);
         i2c_bus_handle = NULL;
@@ -65,54 +181,180 @@ i2c_master_bus_handle_t I2C_Get_Bus_Handle(void)
     return i2c_bus_handle;
 }
 
+esp_err_t I2C_Submit(i2c_prio_t prio, i2c_txn_fn_t fn, void *ctx, uint32_t timeout_ms)
+{
+    if (!fn || (unsigned)prio >= I2C_PRIO_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_arb.task) {
+        return fn(ctx);
+    }
+
+    StaticSemaphore_t done_buf;
+    i2c_txn_t txn = {
+        .fn = fn,
+        .ctx = ctx,
+        .submit_us = esp_timer_get_time(),
+        .result = ESP_FAIL,
+        .done = xSemaphoreCreateBinaryStatic(&done_buf),
+    };
+    i2c_txn_t *ptr = &txn;
+
+    if (xQueueSend(s_arb.queues[prio], &ptr, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    xSemaphoreGive(s_arb.pending);
+
+    // Once queued the arbiter owns txn, so wait without a timeout;
+    // the bus operations themselves are bounded by I2C_MASTER_TIMEOUT_MS
+    xSemaphoreTake(txn.done, portMAX_DELAY);
+    return txn.result;
+}
+
+void I2C_Get_Stats(i2c_bus_stats_t *stats, bool reset)
+{
+    if (!stats) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    int64_t window_us = now - s_arb.window_start_us;
+    uint32_t total = 0;
+
+    memset(stats, 0, sizeof(*stats));
+    for (int i = 0; i < I2C_PRIO_MAX; i++) {
+        stats->transactions[i] = s_arb.transactions[i];
+        total += s_arb.transactions[i];
+    }
+    stats->errors = s_arb.errors;
+    if (window_us > 0) {
+        stats->txn_per_s_x10 = (uint32_t)((uint64_t)total * 10000000ULL / window_us);
+        stats->busy_permille = (uint32_t)(s_arb.busy_us * 1000 / window_us);
+    }
+    stats->queue_wait_avg_us = total ? (uint32_t)(s_arb.wait_total_us / total) : 0;
+    stats->queue_wait_max_us = s_arb.wait_max_us;
+
+    if (reset) {
+        s_arb.window_start_us = now;
+        memset(s_arb.transactions, 0, sizeof(s_arb.transactions));
+        s_arb.errors = 0;
+        s_arb.wait_total_us = 0;
+        s_arb.wait_max_us = 0;
+        s_arb.busy_us = 0;
+    }
+}
 
 /**
- * @brief Write data to I2C device register
- * @param Driver_addr I2C device address
- * @param Reg_addr Register address (8-bit)
- * @param Reg_data Data to write
- * @param Length Data length
- * @return esp_err_t ESP_OK on success
+ * @brief Get (or create) the cached device handle for an address
+ * @note Only called from transaction bodies, which the arbiter serializes
  */
-esp_err_t I2C_Write(uint8_t Driver_addr, uint8_t Reg_addr, const uint8_t *Reg_data, uint32_t Length)
+static esp_err_t I2C_Get_Device(uint8_t Driver_addr, i2c_master_dev_handle_t *dev)
 {
-    if (i2c_bus_handle == NULL) {
-        ESP_LOGE(I2C_TAG, "I2C not initialized");
-        return ESP_ERR_INVALID_STATE;
+    int free_slot = -1;
+    for (int i = 0; i < I2C_DEVICE_CACHE_SIZE; i++) {
+        if (s_devices[i].dev && s_devices[i].addr == Driver_addr) {
+            *dev = s_devices[i].dev;
+            return ESP_OK;
+        }
+        if (!s_devices[i].dev && free_slot < 0) {
+            free_slot = i;
+        }
+    }
+    if (free_slot < 0) {
+        ESP_LOGE(I2C_TAG, "Device cache full (addr 0x%02x)", Driver_addr);
+        return ESP_ERR_NO_MEM;
     }
 
-    // Create device configuration
     i2c_device_config_t dev_cfg = {
         .dev_addr_length = I2C_ADDR_BIT_LEN_7,
         .device_address = Driver_addr,
         .scl_speed_hz = I2C_MASTER_FREQ_HZ,
     };
+    esp_err_t ret = i2c_master_bus_add_device(i2c_bus_handle, &dev_cfg, &s_devices[free_slot].dev);
+    if (ret != ESP_OK) {
+        ESP_LOGE(I2C_TAG, "Failed to add device: %s", esp_err_to_name(ret));
+        s_devices[free_slot].dev = NULL;
+        return ret;
+    }
+    s_devices[free_slot].addr = Driver_addr;
+    *dev = s_devices[free_slot].dev;
+    return ESP_OK;
+}
+
+/**
+ * @brief Register access arguments passed through the arbiter
+ */
+typedef struct {
+    uint8_t addr;
+    uint8_t reg;
+    const uint8_t *tx;
+    uint8_t *rx;
+    uint32_t len;
+} i2c_reg_access_t;
 
+static esp_err_t I2C_Write_Txn(void *ctx)
+{
+    i2c_reg_access_t *a = (i2c_reg_access_t *)ctx;
     i2c_master_dev_handle_t dev_handle;
-    esp_err_t ret = i2c_master_bus_add_device(i2c_bus_handle, &dev_cfg, &dev_handle);
+    esp_err_t ret = I2C_Get_Device(a->addr, &dev_handle);
     if (ret != ESP_OK) {
-        ESP_LOGE(I2C_TAG, "Failed to add device: %s", esp_err_to_name(ret));
         return ret;
     }
 
     // Prepare write buffer: [reg_addr][data...]
-    uint8_t *write_buf = malloc(Length + 1);
+    uint8_t stack_buf[16];
+    uint8_t *write_buf = (a->len + 1 <= sizeof(stack_buf)) ? stack_buf : malloc(a->len + 1);
     if (write_buf == NULL) {
-        i2c_master_bus_rm_device(dev_handle);
         return ESP_ERR_NO_MEM;
     }
 
-    write_buf[0] = Reg_addr;
-    memcpy(&write_buf[1], Reg_data, Length);
+    write_buf[0] = a->reg;
+    memcpy(&write_buf[1], a->tx, a->len);
 
-    ret = i2c_master_transmit(dev_handle, write_buf, Length + 1, I2C_MASTER_TIMEOUT_MS);
-    
-    free(write_buf);
-    i2c_master_bus_rm_device(dev_handle);
-    
+    ret = i2c_master_transmit(dev_handle, write_buf, a->len + 1, I2C_MASTER_TIMEOUT_MS);
+
+    if (write_buf != stack_buf) {
+        free(write_buf);
+    }
     return ret;
 }
 
+static esp_err_t I2C_Read_Txn(void *ctx)
+{
+    i2c_reg_access_t *a = (i2c_reg_access_t *)ctx;
+    i2c_master_dev_handle_t dev_handle;
+    esp_err_t ret = I2C_Get_Device(a->addr, &dev_handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    return i2c_master_transmit_receive(dev_handle, &a->reg, 1, a->rx, a->len, I2C_MASTER_TIMEOUT_MS);
+}
+
+/**
+ * @brief Write data to I2C device register
+ * @param Driver_addr I2C device address
+ * @param Reg_addr Register address (8-bit)
+ * @param Reg_data Data to write
+ * @param Length Data length
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t I2C_Write(uint8_t Driver_addr, uint8_t Reg_addr, const uint8_t *Reg_data, uint32_t Length)
+{
+    if (i2c_bus_handle == NULL) {
+        ESP_LOGE(I2C_TAG, "I2C not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    i2c_reg_access_t access = {
+        .addr = Driver_addr,
+        .reg = Reg_addr,
+        .tx = Reg_data,
+        .len = Length,
+    };
+    return I2C_Submit(I2C_PRIO_NORMAL, I2C_Write_Txn, &access, I2C_MASTER_TIMEOUT_MS);
+}
+
 /**
  * @brief Read data from I2C device register
  * @param Driver_addr I2C device address
@@ -128,23 +370,11 @@ esp_err_t I2C_Read(uint8_t Driver_addr, uint8_t Reg_addr, uint8_t *Reg_data, uin
         return ESP_ERR_INVALID_STATE;
     }
 
-    // Create device configuration
-    i2c_device_config_t dev_cfg = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = Driver_addr,
-        .scl_speed_hz = I2C_MASTER_FREQ_HZ,
+    i2c_reg_access_t access = {
+        .addr = Driver_addr,
+        .reg = Reg_addr,
+        .rx = Reg_data,
+        .len = Length,
     };
-
-    i2c_master_dev_handle_t dev_handle;
-    esp_err_t ret = i2c_master_bus_add_device(i2c_bus_handle, &dev_cfg, &dev_handle);
-    if (ret != ESP_OK) {
-        ESP_LOGE(I2C_TAG, "Failed to add device: %s", esp_err_to_name(ret));
-        return ret;
-    }
-
-    ret = i2c_master_transmit_receive(dev_handle, &Reg_addr, 1, Reg_data, Length, I2C_MASTER_TIMEOUT_MS);
-    
-    i2c_master_bus_rm_device(dev_handle);
-    
-    return ret;
+    return I2C_Submit(I2C_PRIO_NORMAL, I2C_Read_Txn, &access, I2C_MASTER_TIMEOUT_MS);
 }
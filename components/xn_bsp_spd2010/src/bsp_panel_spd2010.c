@@ -264,6 +264,33 @@ esp_err_t SPD2010_Register_LVGL_Callback(lv_display_t *display)
     return ESP_OK;
 }
 
+/**
+ * @brief 注册颜色数据传输完成回调（替换 LVGL 默认回调，用于自定义刷新流水线）
+ * @param cb 传输完成回调（在 SPI 中断上下文中执行）
+ * @param user_ctx 回调上下文
+ * @return esp_err_t 注册结果
+ */
+esp_err_t SPD2010_Register_Trans_Done_Callback(esp_lcd_panel_io_color_trans_done_cb_t cb, void *user_ctx)
+{
+    if (!io_handle || !cb) {
+        ESP_LOGE(TAG, "IO句柄或回调为空");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const esp_lcd_panel_io_callbacks_t cbs = {
+        .on_color_trans_done = cb,
+    };
+
+    esp_err_t ret = esp_lcd_panel_io_register_event_callbacks(io_handle, &cbs, user_ctx);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "注册传输完成回调失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "传输完成回调注册成功");
+    return ESP_OK;
+}
+
 /**
  * @brief 获取面板句柄
  * @return esp_lcd_panel_handle_t 面板句柄
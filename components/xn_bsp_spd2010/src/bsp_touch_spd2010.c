@@ -9,6 +9,10 @@
 
 #include "bsp_touch_spd2010.h"
 #include "bsp_i2c_driver.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
 
 static const char *TAG = "TOUCH_SPD2010_OFFICIAL";
 
@@ -16,6 +20,55 @@ static const char *TAG = "TOUCH_SPD2010_OFFICIAL";
 esp_lcd_touch_handle_t touch_handle = NULL;
 esp_lcd_panel_io_handle_t touch_io_handle = NULL;
 
+// 中断与读取状态
+static struct {
+    bool int_mode;                      // 中断驱动模式
+    bool pressed;                       // 上次读取结果
+    volatile bool irq_pending;          // 有未处理的中断边沿
+    volatile int64_t irq_us;            // 未处理的第一个中断边沿时间
+    touch_notify_cb_t notify_cb;
+
+    // 统计
+    volatile uint32_t irq_count;
+    uint32_t reads;
+    uint32_t skipped_reads;
+    uint32_t latency_samples;
+    uint64_t latency_total_us;
+    uint32_t latency_max_us;
+} s_touch = {0};
+
+static portMUX_TYPE s_touch_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief 触摸中断：只记录边沿并通知，I2C读取留给读取方
+ */
+static void IRAM_ATTR Touch_Isr_Callback(esp_lcd_touch_handle_t tp)
+{
+    (void)tp;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL_ISR(&s_touch_lock);
+    if (!s_touch.irq_pending) {
+        s_touch.irq_us = now;
+        s_touch.irq_pending = true;
+    }
+    s_touch.irq_count++;
+    portEXIT_CRITICAL_ISR(&s_touch_lock);
+
+    touch_notify_cb_t cb = s_touch.notify_cb;
+    if (cb) {
+        cb();
+    }
+}
+
+/**
+ * @brief 在I2C仲裁任务中执行的触摸读取
+ */
+static esp_err_t Touch_Read_Txn(void *ctx)
+{
+    return esp_lcd_touch_read_data((esp_lcd_touch_handle_t)ctx);
+}
+
 esp_err_t Touch_Init_Official(void)
 {
     ESP_LOGI(TAG, "开始初始化SPD2010触摸控制器（官方组件版本）");
@@ -58,16 +111,25 @@ esp_err_t Touch_Init_Official(void)
         .int_gpio_num = TOUCH_INT_PIN,
         .levels = {
             .reset = 0,
-            .interrupt = 0,
+            .interrupt = 0,             // 低电平有效，下降沿触发
         },
         .flags = {
             .swap_xy = TOUCH_SWAP_XY,
             .mirror_x = TOUCH_MIRROR_X,
             .mirror_y = TOUCH_MIRROR_Y,
         },
-        .interrupt_callback = NULL,
+        .interrupt_callback = (TOUCH_INT_PIN >= 0) ? Touch_Isr_Callback : NULL,
     };
 
+    // 中断回调通过GPIO ISR服务注册，与按键共用（已安装时返回 ESP_ERR_INVALID_STATE）
+    if (TOUCH_INT_PIN >= 0) {
+        ret = gpio_install_isr_service(0);
+        if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+            ESP_LOGE(TAG, "GPIO ISR 服务安装失败: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+
     ESP_LOGI(TAG, "创建SPD2010触摸控制器");
 
     ret = esp_lcd_touch_new_i2c_spd2010(touch_io_handle, &tp_cfg, &touch_handle);
@@ -76,7 +138,9 @@ esp_err_t Touch_Init_Official(void)
         return ret;
     }
 
-    ESP_LOGI(TAG, "SPD2010触摸控制器初始化成功");
+    s_touch.int_mode = (TOUCH_INT_PIN >= 0);
+    ESP_LOGI(TAG, "SPD2010触摸控制器初始化成功（%s）",
+             s_touch.int_mode ? "中断驱动" : "轮询");
     return ESP_OK;
 }
 
@@ -88,6 +152,9 @@ void Touch_Deinit_Official(void)
         esp_lcd_touch_del(touch_handle);
         touch_handle = NULL;
     }
+    s_touch.int_mode = false;
+    s_touch.pressed = false;
+    s_touch.irq_pending = false;
 
     if (touch_io_handle) {
         esp_lcd_panel_io_del(touch_io_handle);
@@ -104,19 +171,57 @@ bool Touch_Get_xy_Official(uint16_t *touch_x, uint16_t *touch_y, uint16_t *stren
         return false;
     }
 
-    esp_err_t ret = esp_lcd_touch_read_data(touch_handle);
+    // 中断模式：松开状态且没有新的中断边沿时，控制器没有新数据，不占用I2C
+    bool irq = false;
+    int64_t irq_us = 0;
+    if (s_touch.int_mode) {
+        portENTER_CRITICAL(&s_touch_lock);
+        irq = s_touch.irq_pending;
+        irq_us = s_touch.irq_us;
+        s_touch.irq_pending = false;
+        portEXIT_CRITICAL(&s_touch_lock);
+
+        if (!irq && !s_touch.pressed) {
+            s_touch.skipped_reads++;
+            *touch_count = 0;
+            return false;
+        }
+    }
+
+    // 触摸读取以高优先级排队，不会被IO扩展芯片的访问挡住
+    s_touch.reads++;
+    esp_err_t ret = I2C_Submit(I2C_PRIO_HIGH, Touch_Read_Txn, touch_handle, TOUCH_I2C_QUEUE_TIMEOUT_MS);
     if (ret != ESP_OK) {
-        ESP_LOGI(TAG, "读取触摸数据失败: %s", esp_err_to_name(ret));
+        ESP_LOGW(TAG, "读取触摸数据失败: %s", esp_err_to_name(ret));
+        if (irq) {
+            // 中断边沿未被消费，下次轮询重试
+            portENTER_CRITICAL(&s_touch_lock);
+            if (!s_touch.irq_pending) {
+                s_touch.irq_us = irq_us;
+                s_touch.irq_pending = true;
+            }
+            portEXIT_CRITICAL(&s_touch_lock);
+        }
         return false;
     }
 
     bool touch_pressed = esp_lcd_touch_get_coordinates(touch_handle, touch_x, touch_y,
                                                        strength, touch_count, max_points);
+    s_touch.pressed = touch_pressed && *touch_count > 0;
+
+    if (irq && s_touch.pressed) {
+        uint32_t latency = (uint32_t)(esp_timer_get_time() - irq_us);
+        s_touch.latency_samples++;
+        s_touch.latency_total_us += latency;
+        if (latency > s_touch.latency_max_us) {
+            s_touch.latency_max_us = latency;
+        }
+    }
 
-    if (touch_pressed && *touch_count > 0) {
-        ESP_LOGI(TAG, "检测到 %d 个触摸点", *touch_count);
+    if (s_touch.pressed) {
+        ESP_LOGD(TAG, "检测到 %d 个触摸点", *touch_count);
         for (int i = 0; i < *touch_count && i < max_points; i++) {
-            ESP_LOGI(TAG, "触摸点 %d: (%d, %d)", i, touch_x[i], touch_y[i]);
+            ESP_LOGD(TAG, "触摸点 %d: (%d, %d)", i, touch_x[i], touch_y[i]);
         }
     }
 
@@ -132,3 +237,38 @@ bool Touch_Is_Initialized_Official(void)
 {
     return (touch_handle != NULL);
 }
+
+bool Touch_Is_Interrupt_Driven(void)
+{
+    return s_touch.int_mode;
+}
+
+void Touch_Set_Notify_Callback(touch_notify_cb_t cb)
+{
+    s_touch.notify_cb = cb;
+}
+
+void Touch_Get_Stats(touch_stats_t *stats, bool reset)
+{
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    stats->irq_count = s_touch.irq_count;
+    stats->reads = s_touch.reads;
+    stats->skipped_reads = s_touch.skipped_reads;
+    stats->latency_samples = s_touch.latency_samples;
+    stats->latency_avg_us = s_touch.latency_samples
+                            ? (uint32_t)(s_touch.latency_total_us / s_touch.latency_samples) : 0;
+    stats->latency_max_us = s_touch.latency_max_us;
+
+    if (reset) {
+        s_touch.irq_count = 0;
+        s_touch.reads = 0;
+        s_touch.skipped_reads = 0;
+        s_touch.latency_samples = 0;
+        s_touch.latency_total_us = 0;
+        s_touch.latency_max_us = 0;
+    }
+}
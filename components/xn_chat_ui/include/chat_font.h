@@ -0,0 +1,71 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-05 09:26:44
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-05 09:26:44
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_chat_ui\include\chat_font.h
+ * @Description: 字幕字库 - 映射 font_glyphs 分区中的预光栅化字库子集，字形位图经 PSRAM LRU 缓存
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHAT_FONT_PARTITION_LABEL   "font_glyphs"   // 字库分区标签（由 tools/pack_font.py 生成镜像）
+#define CHAT_FONT_CACHE_SLOTS       256             // 位图缓存最多字形数
+#define CHAT_FONT_CACHE_BYTES       (96 * 1024)     // 位图缓存字节预算（A8 展开后，位于 PSRAM）
+
+// 字库统计（只在 LVGL 任务中更新）
+typedef struct {
+    uint32_t glyph_count;           // 分区中的字形数
+    uint32_t hits;                  // 位图缓存命中次数
+    uint32_t misses;                // 未命中（从分区解码）次数
+    uint32_t evictions;             // 因槽位或字节预算不足淘汰的字形数
+    uint32_t not_found;             // 字库中没有、交给回退字体的查询次数
+    uint32_t cached_glyphs;         // 当前缓存字形数
+    uint32_t cached_bytes;          // 当前缓存字节数
+    uint32_t bitmap_calls;          // 取位图次数
+    uint64_t bitmap_us;             // 取位图累计耗时（含解码）
+} chat_font_stats_t;
+
+/**
+ * @brief 映射字库分区并创建 LVGL 字体（回退字体为 lv_font_montserrat_16）
+ * @return ESP_OK 成功, ESP_ERR_NOT_FOUND 未配置分区或镜像为空, ESP_ERR_INVALID_RESPONSE 镜像格式无效,
+ *         ESP_ERR_NO_MEM 缓存分配失败
+ */
+esp_err_t chat_font_init(void);
+
+/**
+ * @brief 获取字库字体
+ * @return 字体指针，未初始化成功时为 NULL
+ */
+const lv_font_t *chat_font_get(void);
+
+/**
+ * @brief 开关位图缓存（关闭时每次绘制都从分区解码到 LVGL 提供的缓冲区，用于对比测量）
+ *
+ * 需在持有 lv_lock 时调用。
+ *
+ * @param enable 是否启用缓存
+ */
+void chat_font_set_cache_enabled(bool enable);
+
+/**
+ * @brief 读取统计（需在持有 lv_lock 时调用）
+ * @param stats 输出统计
+ * @param reset 是否清零计数（缓存占用保留）
+ */
+void chat_font_get_stats(chat_font_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,71 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-04 15:40:18
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-04 15:40:18
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_chat_ui\include\chat_text_ring.h
+ * @Description: 字幕文本无锁环形缓冲 - 单生产者 / 单消费者（LVGL 任务），多个写入任务由 xn_chat_ui 加锁串行化
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHAT_TEXT_RING_SIZE         2048    // 环形缓冲字节数（2 的幂）
+#define CHAT_TEXT_RECORD_MAX        255     // 单条记录最大字节数，更长的片段按 UTF-8 边界拆成多条
+
+// 环形缓冲统计
+typedef struct {
+    uint32_t pushed_fragments;      // 成功写入的片段数
+    uint32_t dropped_fragments;     // 空间不足被整体丢弃的片段数（含消息分隔）
+    uint32_t dropped_bytes;         // 被丢弃的字节数
+    uint32_t high_water_bytes;      // 缓冲占用峰值
+} chat_text_ring_stats_t;
+
+/**
+ * @brief 写入一段 UTF-8 文本（生产者，从不阻塞）
+ *
+ * 片段要么完整写入，要么整体丢弃，不会在字符中间截断。
+ *
+ * @param text 文本
+ * @param len 字节数
+ * @return true 已写入, false 空间不足已丢弃
+ */
+bool chat_text_ring_push(const char *text, size_t len);
+
+/**
+ * @brief 写入消息分隔（生产者），消费者读到后下一段文本开始新的字幕
+ * @return true 已写入, false 空间不足已丢弃
+ */
+bool chat_text_ring_push_break(void);
+
+/**
+ * @brief 读出一条记录（消费者）
+ * @param out 输出缓冲区，至少 CHAT_TEXT_RECORD_MAX 字节（不追加结束符）
+ * @return 记录字节数, 0 表示消息分隔, -1 表示缓冲为空
+ */
+int chat_text_ring_pop(char *out);
+
+/**
+ * @brief 丢弃所有未读记录（消费者）
+ */
+void chat_text_ring_discard(void);
+
+/**
+ * @brief 读取统计
+ * @param stats 输出统计
+ * @param reset 是否清零计数（峰值保留）
+ */
+void chat_text_ring_get_stats(chat_text_ring_stats_t *stats, bool reset);
+
+#ifdef __cplusplus
+}
+#endif
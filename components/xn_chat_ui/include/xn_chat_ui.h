@@ -0,0 +1,148 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-04 10:12:36
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-04 10:12:36
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_chat_ui\include\xn_chat_ui.h
+ * @Description: 对话状态界面 - 静态背景 + 状态图标 + 小尺寸动画区域 + 字幕，只重绘变化的区域
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ * 配置宏定义
+ *********************/
+
+#define CHAT_UI_BG_COLOR            0xFFFFFF    // 背景色（与 pack_frames.py --bg 一致）
+#define CHAT_UI_ANIM_SIZE           240         // 动画区域边长，动画重绘被裁剪在此区域内
+#define CHAT_UI_ANIM_OFFSET_Y       (-10)       // 动画区域相对屏幕中心的 Y 偏移
+#define CHAT_UI_ICON_Y              40          // 状态图标距顶部距离
+#define CHAT_UI_SUBTITLE_WIDTH      280         // 字幕区域宽度
+#define CHAT_UI_SUBTITLE_LINES      2           // 字幕可见行数，新行出现时最早的一行滚出
+#define CHAT_UI_SUBTITLE_BOTTOM     40          // 字幕区域距底部距离
+#define CHAT_UI_LINE_BYTES          128         // 每行文本缓冲字节数
+#define CHAT_UI_GLYPH_CACHE_SIZE    128         // 字宽缓存槽位数（2 的幂，按码点直接映射）
+#define CHAT_UI_TEXT_BATCH          8           // 每次唤醒最多处理的字幕片段数，剩余的下次唤醒继续
+
+// 切换动画时"淡出到背景色 -> 切换 -> 淡入"额外重绘的像素上限；
+// 帧数 = 预算 / 动画区域面积，不足 2 帧时直接切换
+#define CHAT_UI_FADE_PIXEL_BUDGET   (CHAT_UI_ANIM_SIZE * CHAT_UI_ANIM_SIZE * 6)
+#define CHAT_UI_FADE_MAX_MS         600         // 淡入淡出总时长上限
+
+#define CHAT_UI_STATS_PERIOD_MS     30000       // 刷新像素统计输出周期
+
+/*********************
+ * 类型定义
+ *********************/
+
+// 对话界面状态
+typedef enum {
+    CHAT_UI_STATE_BOOT = 0,         // 启动加载
+    CHAT_UI_STATE_WIFI_CONNECTING,  // 等待网络
+    CHAT_UI_STATE_IDLE,             // 待机（等待唤醒词/按键）
+    CHAT_UI_STATE_LISTENING,        // 录音中
+    CHAT_UI_STATE_THINKING,         // 已提交语音，等待回复
+    CHAT_UI_STATE_SPEAKING,         // 播放回复
+    CHAT_UI_STATE_OTA,              // 固件升级
+    CHAT_UI_STATE_MAX,
+} chat_ui_state_t;
+
+// 界面统计
+typedef struct {
+    chat_ui_state_t state;          // 当前状态
+    uint32_t state_changes;         // 状态切换次数
+    uint32_t anim_switches;         // 其中需要切换动画的次数（其余只更新图标）
+    uint32_t fades;                 // 执行了淡入淡出的次数
+    uint32_t fade_frames;           // 每次淡入淡出的帧数（由像素预算算出）
+    uint32_t subtitle_fragments;    // 最近一个统计周期渲染的字幕片段数
+    uint32_t subtitle_dropped;      // 最近一个统计周期因缓冲满被丢弃的片段数
+    uint32_t subtitle_dropped_bytes;// 最近一个统计周期被丢弃的字节数
+    uint32_t delta_render_avg_us;   // 每个片段平均处理耗时（解码 + 测宽 + 更新当前行）
+    uint32_t delta_render_max_us;   // 每个片段最大处理耗时
+    uint32_t glyph_hit_permille;    // 字宽缓存命中率（千分比）
+    uint32_t subtitle_updates;      // 最近一个统计周期字幕行标签更新次数（仅使用字库分区时统计）
+    uint32_t glyph_us_per_update;   // 每次行更新引起的字形位图耗时（取位图总耗时 / 行更新次数）
+    uint32_t font_cache_hit_permille;// 字库位图缓存命中率（千分比）
+    uint32_t pixels_per_s;          // 最近一个统计周期每秒刷新到屏幕的像素数
+    uint32_t pixels_per_frame_avg;  // 最近一个统计周期每帧平均刷新像素数
+    uint32_t fps_x10;               // 最近一个统计周期帧率 x10
+} chat_ui_stats_t;
+
+/*********************
+ * 函数声明
+ *********************/
+
+/**
+ * @brief 在当前屏幕上创建对话界面，并把 Lottie 动画挂到动画区域
+ *
+ * 需在 xn_lottie_manager_init 之后调用。
+ *
+ * @return ESP_OK 成功, ESP_ERR_NO_MEM 创建对象失败
+ */
+esp_err_t chat_ui_init(void);
+
+/**
+ * @brief 切换对话状态（只更新变化的图标/动画，动画切换时按像素预算淡入淡出）
+ * @param state 新状态
+ */
+void chat_ui_set_state(chat_ui_state_t state);
+
+/**
+ * @brief 获取当前对话状态
+ */
+chat_ui_state_t chat_ui_get_state(void);
+
+/**
+ * @brief 更新网络状态图标
+ * @param connected 是否已联网
+ */
+void chat_ui_set_wifi(bool connected);
+
+/**
+ * @brief 追加一段流式字幕片段（如 conversation.message.delta）
+ *
+ * 写入环形缓冲后唤醒 LVGL 任务，不等待 LVGL 锁；缓冲满时整段丢弃并计数。
+ * 环形缓冲本身是单生产者的，字幕写入接口在写入侧用自旋锁串行化，可由多个任务调用。
+ *
+ * @param delta UTF-8 片段
+ */
+void chat_ui_subtitle_push(const char *delta);
+
+/**
+ * @brief 结束当前字幕，下一段片段到来时清空字幕区域重新开始
+ */
+void chat_ui_subtitle_break(void);
+
+/**
+ * @brief 显示一句独立字幕（分隔 + 文本 + 分隔一次写入，不与流式片段交错，下一段片段到来时清空）
+ * @param text UTF-8 文本，NULL 或空串只结束当前字幕
+ */
+void chat_ui_set_subtitle(const char *text);
+
+/**
+ * @brief 开关字库位图缓存（默认开启），关闭后每次重绘都从分区解码，用于对比 glyph_us_per_update
+ * @param enable 是否启用
+ */
+void chat_ui_set_glyph_cache(bool enable);
+
+/**
+ * @brief 获取界面统计
+ * @param stats 输出统计
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 参数为空, ESP_ERR_INVALID_STATE 未初始化
+ */
+esp_err_t chat_ui_get_stats(chat_ui_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,334 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-05 09:26:44
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-05 09:26:44
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_chat_ui\src\chat_font.c
+ * @Description: 字幕字库实现 - 分区映射 + 二分查找字形 + 4bpp 解码到 A8 + PSRAM LRU 位图缓存
+ *
+ * LVGL 每次重绘标签都会逐字取位图，字库位于 flash 映射区，4bpp 需要展开成 A8 才能混合。
+ * 缓存命中时直接返回已展开的位图，不再访问 flash，也不再解码。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "chat_font.h"
+
+static const char *TAG = "CHAT_FONT";
+
+// ============ 分区镜像格式（与 tools/pack_font.py 保持一致） ============
+
+#define CHAT_FONT_MAGIC          "XNFG"
+#define CHAT_FONT_VERSION        1
+#define CHAT_FONT_BPP            4
+
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint16_t version;
+    uint16_t font_px;
+    uint32_t count;
+    uint16_t line_height;
+    int16_t base_line;
+    uint8_t bpp;
+    uint8_t reserved0;
+    uint16_t reserved1;
+    uint32_t image_size;
+} chat_font_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t codepoint;
+    uint32_t bitmap_offset;     // 4bpp 位图偏移（相对镜像起始）
+    uint16_t adv_w;
+    uint8_t box_w;
+    uint8_t box_h;
+    int8_t ofs_x;
+    int8_t ofs_y;
+    uint16_t reserved;
+} chat_font_entry_t;
+
+// ============ 位图缓存 ============
+
+// 缓存槽：一个已展开为 A8 的字形位图
+typedef struct {
+    lv_draw_buf_t buf;          // 交给 LVGL 绘制的描述符，指向 data
+    uint8_t *data;
+    uint32_t size;              // data 字节数
+    uint32_t glyph;             // 字形序号
+    uint32_t last_use;          // 最近使用时间戳（LRU）
+    bool used;
+} chat_font_slot_t;
+
+static const uint8_t *s_map = NULL;
+static esp_partition_mmap_handle_t s_map_handle;
+static const chat_font_header_t *s_hdr = NULL;
+static const chat_font_entry_t *s_index = NULL;
+static lv_font_t s_font;
+
+static chat_font_slot_t *s_slots = NULL;    // CHAT_FONT_CACHE_SLOTS 个槽位
+static uint16_t *s_slot_of = NULL;          // 字形序号 -> 槽位 + 1，0 表示未缓存
+static uint32_t s_clock = 0;
+static bool s_cache_enabled = true;
+static chat_font_stats_t s_stats = {0};
+
+static const chat_font_entry_t *chat_font_find(uint32_t letter)
+{
+    uint32_t lo = 0;
+    uint32_t hi = s_hdr->count;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        uint32_t cp = s_index[mid].codepoint;
+        if (cp == letter) {
+            return &s_index[mid];
+        }
+        if (cp < letter) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return NULL;
+}
+
+/* 4bpp（逐行连续、高 4 位在前）展开为 A8 */
+static void chat_font_decode(const chat_font_entry_t *e, uint8_t *dst, uint32_t stride)
+{
+    const uint8_t *src = s_map + e->bitmap_offset;
+    uint32_t bit = 0;
+    for (uint32_t y = 0; y < e->box_h; y++) {
+        uint8_t *row = dst + y * stride;
+        for (uint32_t x = 0; x < e->box_w; x++, bit++) {
+            uint8_t b = src[bit >> 1];
+            uint8_t v = (bit & 1) ? (b & 0x0F) : (b >> 4);
+            row[x] = v * 17;
+        }
+    }
+}
+
+static void chat_font_evict(chat_font_slot_t *slot)
+{
+    s_slot_of[slot->glyph] = 0;
+    heap_caps_free(slot->data);
+    s_stats.cached_glyphs--;
+    s_stats.cached_bytes -= slot->size;
+    s_stats.evictions++;
+    memset(slot, 0, sizeof(*slot));
+}
+
+/* 取一个可用槽位，槽位或字节预算不足时按 LRU 淘汰 */
+static chat_font_slot_t *chat_font_slot_alloc(uint32_t size)
+{
+    while (s_stats.cached_glyphs > 0 &&
+           (s_stats.cached_glyphs >= CHAT_FONT_CACHE_SLOTS || s_stats.cached_bytes + size > CHAT_FONT_CACHE_BYTES)) {
+        chat_font_slot_t *victim = NULL;
+        for (int i = 0; i < CHAT_FONT_CACHE_SLOTS; i++) {
+            if (s_slots[i].used && (!victim || s_slots[i].last_use < victim->last_use)) {
+                victim = &s_slots[i];
+            }
+        }
+        chat_font_evict(victim);
+    }
+
+    for (int i = 0; i < CHAT_FONT_CACHE_SLOTS; i++) {
+        if (!s_slots[i].used) {
+            return &s_slots[i];
+        }
+    }
+    return NULL;
+}
+
+static const lv_draw_buf_t *chat_font_cache_get(const chat_font_entry_t *e)
+{
+    uint32_t glyph = (uint32_t)(e - s_index);
+    uint16_t slot_no = s_slot_of[glyph];
+    if (slot_no) {
+        chat_font_slot_t *slot = &s_slots[slot_no - 1];
+        slot->last_use = ++s_clock;
+        s_stats.hits++;
+        return &slot->buf;
+    }
+    s_stats.misses++;
+
+    uint32_t stride = lv_draw_buf_width_to_stride(e->box_w, LV_COLOR_FORMAT_A8);
+    uint32_t size = stride * e->box_h;
+    chat_font_slot_t *slot = chat_font_slot_alloc(size);
+    uint8_t *data = slot ? heap_caps_malloc(size, MALLOC_CAP_SPIRAM) : NULL;
+    if (!data) {
+        return NULL;
+    }
+
+    chat_font_decode(e, data, stride);
+    lv_draw_buf_init(&slot->buf, e->box_w, e->box_h, LV_COLOR_FORMAT_A8, stride, data, size);
+    slot->data = data;
+    slot->size = size;
+    slot->glyph = glyph;
+    slot->last_use = ++s_clock;
+    slot->used = true;
+    s_slot_of[glyph] = (uint16_t)(slot - s_slots + 1);
+    s_stats.cached_glyphs++;
+    s_stats.cached_bytes += size;
+    return &slot->buf;
+}
+
+static bool chat_font_get_glyph_dsc(const lv_font_t *font, lv_font_glyph_dsc_t *dsc,
+                                    uint32_t letter, uint32_t letter_next)
+{
+    (void)font;
+    (void)letter_next;
+
+    const chat_font_entry_t *e = chat_font_find(letter);
+    if (!e) {
+        s_stats.not_found++;    // 由回退字体处理
+        return false;
+    }
+
+    dsc->adv_w = e->adv_w;
+    dsc->box_w = e->box_w;
+    dsc->box_h = e->box_h;
+    dsc->ofs_x = e->ofs_x;
+    dsc->ofs_y = e->ofs_y;
+    dsc->format = LV_FONT_GLYPH_FORMAT_A8;
+    dsc->is_placeholder = 0;
+    dsc->gid.index = (uint32_t)(e - s_index);
+    return true;
+}
+
+static const void *chat_font_get_glyph_bitmap(lv_font_glyph_dsc_t *dsc, lv_draw_buf_t *draw_buf)
+{
+    const chat_font_entry_t *e = &s_index[dsc->gid.index];
+    if (e->box_w == 0 || e->box_h == 0) {
+        return NULL;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    const void *ret = NULL;
+    if (s_cache_enabled) {
+        ret = chat_font_cache_get(e);
+    }
+    if (!ret && draw_buf) {
+        // 缓存关闭或分配失败：直接解码到 LVGL 提供的缓冲区
+        chat_font_decode(e, draw_buf->data, draw_buf->header.stride);
+        ret = draw_buf;
+    }
+    s_stats.bitmap_calls++;
+    s_stats.bitmap_us += (uint64_t)(esp_timer_get_time() - start_us);
+    return ret;
+}
+
+esp_err_t chat_font_init(void)
+{
+    if (s_hdr) {
+        return ESP_OK;
+    }
+
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY,
+                                                           CHAT_FONT_PARTITION_LABEL);
+    if (!part) {
+        ESP_LOGI(TAG, "未配置字库分区，字幕使用内置字体");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // 先读头部，只映射镜像实际使用的部分
+    chat_font_header_t hdr;
+    esp_err_t ret = esp_partition_read(part, 0, &hdr, sizeof(hdr));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (memcmp(hdr.magic, CHAT_FONT_MAGIC, 4) != 0 || hdr.count == 0) {
+        ESP_LOGI(TAG, "字库分区为空，字幕使用内置字体");
+        return ESP_ERR_NOT_FOUND;
+    }
+    size_t index_end = sizeof(hdr) + (size_t)hdr.count * sizeof(chat_font_entry_t);
+    if (hdr.version != CHAT_FONT_VERSION || hdr.bpp != CHAT_FONT_BPP || hdr.count > UINT16_MAX ||
+        hdr.image_size > part->size || index_end > hdr.image_size) {
+        ESP_LOGE(TAG, "字库分区格式无效（请重新烧录 font_glyphs 镜像）");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    const void *map = NULL;
+    ret = esp_partition_mmap(part, 0, hdr.image_size, ESP_PARTITION_MMAP_DATA, &map, &s_map_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "字库分区映射失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    s_map = (const uint8_t *)map;
+    s_index = (const chat_font_entry_t *)(s_map + sizeof(hdr));
+
+    // 校验码点升序与位图范围，避免查找和解码时越界
+    for (uint32_t i = 0; i < hdr.count; i++) {
+        const chat_font_entry_t *e = &s_index[i];
+        size_t bitmap_end = e->bitmap_offset + ((size_t)e->box_w * e->box_h + 1) / 2;
+        if ((i > 0 && e->codepoint <= s_index[i - 1].codepoint) || bitmap_end > hdr.image_size) {
+            ESP_LOGE(TAG, "字库索引无效（第 %lu 项）", (unsigned long)i);
+            ret = ESP_ERR_INVALID_RESPONSE;
+            goto fail;
+        }
+    }
+
+    s_slots = heap_caps_calloc(CHAT_FONT_CACHE_SLOTS, sizeof(chat_font_slot_t), MALLOC_CAP_SPIRAM);
+    s_slot_of = heap_caps_calloc(hdr.count, sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+    if (!s_slots || !s_slot_of) {
+        ESP_LOGE(TAG, "字形缓存分配失败");
+        ret = ESP_ERR_NO_MEM;
+        goto fail;
+    }
+
+    memset(&s_font, 0, sizeof(s_font));
+    s_font.get_glyph_dsc = chat_font_get_glyph_dsc;
+    s_font.get_glyph_bitmap = chat_font_get_glyph_bitmap;
+    s_font.line_height = hdr.line_height;
+    s_font.base_line = hdr.base_line;
+    s_font.subpx = LV_FONT_SUBPX_NONE;
+    s_font.underline_position = -1;
+    s_font.underline_thickness = 1;
+    s_font.fallback = &lv_font_montserrat_16;
+
+    s_stats.glyph_count = hdr.count;
+    s_hdr = (const chat_font_header_t *)s_map;
+    ESP_LOGI(TAG, "✅ 字库: %u px, %lu 字形, 行高 %u, 镜像 %lu 字节, 缓存 %d 槽 / %d KB",
+             hdr.font_px, (unsigned long)hdr.count, hdr.line_height, (unsigned long)hdr.image_size,
+             CHAT_FONT_CACHE_SLOTS, CHAT_FONT_CACHE_BYTES / 1024);
+    return ESP_OK;
+
+fail:
+    heap_caps_free(s_slots);
+    heap_caps_free(s_slot_of);
+    s_slots = NULL;
+    s_slot_of = NULL;
+    s_index = NULL;
+    esp_partition_munmap(s_map_handle);
+    s_map = NULL;
+    return ret;
+}
+
+const lv_font_t *chat_font_get(void)
+{
+    return s_hdr ? &s_font : NULL;
+}
+
+void chat_font_set_cache_enabled(bool enable)
+{
+    s_cache_enabled = enable;
+}
+
+void chat_font_get_stats(chat_font_stats_t *stats, bool reset)
+{
+    if (!stats) {
+        return;
+    }
+
+    *stats = s_stats;
+    if (reset) {
+        s_stats.hits = 0;
+        s_stats.misses = 0;
+        s_stats.evictions = 0;
+        s_stats.not_found = 0;
+        s_stats.bitmap_calls = 0;
+        s_stats.bitmap_us = 0;
+    }
+}
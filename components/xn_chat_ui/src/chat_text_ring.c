@@ -0,0 +1,162 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-04 15:40:18
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-04 15:40:18
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_chat_ui\src\chat_text_ring.c
+ * @Description: 字幕文本无锁环形缓冲实现
+ *
+ * 记录格式：1 字节长度 + 文本，长度 0 为消息分隔。
+ * head 只由生产者写、tail 只由消费者写，均为自由递增的计数，用 acquire/release 保证数据先于索引可见。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <string.h>
+#include "chat_text_ring.h"
+
+#define RING_MASK   (CHAT_TEXT_RING_SIZE - 1)
+
+_Static_assert((CHAT_TEXT_RING_SIZE & RING_MASK) == 0, "CHAT_TEXT_RING_SIZE 必须是 2 的幂");
+
+static uint8_t s_buf[CHAT_TEXT_RING_SIZE];
+static uint32_t s_head = 0;     // 生产者写入位置
+static uint32_t s_tail = 0;     // 消费者读取位置
+
+static uint32_t s_pushed = 0;
+static uint32_t s_dropped = 0;
+static uint32_t s_dropped_bytes = 0;
+static uint32_t s_high_water = 0;
+
+static void ring_write(uint32_t pos, const void *src, size_t len)
+{
+    size_t off = pos & RING_MASK;
+    size_t first = CHAT_TEXT_RING_SIZE - off;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(&s_buf[off], src, first);
+    memcpy(s_buf, (const uint8_t *)src + first, len - first);
+}
+
+static void ring_read(uint32_t pos, void *dst, size_t len)
+{
+    size_t off = pos & RING_MASK;
+    size_t first = CHAT_TEXT_RING_SIZE - off;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(dst, &s_buf[off], first);
+    memcpy((uint8_t *)dst + first, s_buf, len - first);
+}
+
+/* 不超过 max 字节的最长前缀，且不切断 UTF-8 字符 */
+static size_t utf8_prefix(const char *text, size_t len, size_t max)
+{
+    if (len <= max) {
+        return len;
+    }
+    size_t n = max;
+    while (n > 0 && ((uint8_t)text[n] & 0xC0) == 0x80) {
+        n--;
+    }
+    return n > 0 ? n : max;
+}
+
+static void ring_drop(size_t len)
+{
+    __atomic_fetch_add(&s_dropped, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&s_dropped_bytes, (uint32_t)len, __ATOMIC_RELAXED);
+}
+
+bool chat_text_ring_push(const char *text, size_t len)
+{
+    if (!text || len == 0) {
+        return true;
+    }
+
+    // 先算出拆分后的总占用，空间不够就整体丢弃
+    size_t need = 0;
+    for (size_t pos = 0; pos < len;) {
+        size_t n = utf8_prefix(text + pos, len - pos, CHAT_TEXT_RECORD_MAX);
+        need += 1 + n;
+        pos += n;
+    }
+
+    uint32_t head = s_head;
+    uint32_t tail = __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE);
+    uint32_t used = head - tail;
+    if (need > CHAT_TEXT_RING_SIZE - used) {
+        ring_drop(len);
+        return false;
+    }
+
+    for (size_t pos = 0; pos < len;) {
+        size_t n = utf8_prefix(text + pos, len - pos, CHAT_TEXT_RECORD_MAX);
+        uint8_t hdr = (uint8_t)n;
+        ring_write(head, &hdr, 1);
+        ring_write(head + 1, text + pos, n);
+        head += 1 + n;
+        pos += n;
+    }
+    __atomic_store_n(&s_head, head, __ATOMIC_RELEASE);
+
+    __atomic_fetch_add(&s_pushed, 1, __ATOMIC_RELAXED);
+    if (used + need > s_high_water) {
+        s_high_water = used + need;
+    }
+    return true;
+}
+
+bool chat_text_ring_push_break(void)
+{
+    uint32_t head = s_head;
+    uint32_t tail = __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= CHAT_TEXT_RING_SIZE) {
+        ring_drop(0);
+        return false;
+    }
+
+    uint8_t hdr = 0;
+    ring_write(head, &hdr, 1);
+    __atomic_store_n(&s_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+int chat_text_ring_pop(char *out)
+{
+    uint32_t tail = s_tail;
+    uint32_t head = __atomic_load_n(&s_head, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return -1;
+    }
+
+    uint8_t len;
+    ring_read(tail, &len, 1);
+    ring_read(tail + 1, out, len);
+    __atomic_store_n(&s_tail, tail + 1 + len, __ATOMIC_RELEASE);
+    return len;
+}
+
+void chat_text_ring_discard(void)
+{
+    __atomic_store_n(&s_tail, __atomic_load_n(&s_head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+}
+
+void chat_text_ring_get_stats(chat_text_ring_stats_t *stats, bool reset)
+{
+    if (!stats) {
+        return;
+    }
+
+    stats->pushed_fragments = __atomic_load_n(&s_pushed, __ATOMIC_RELAXED);
+    stats->dropped_fragments = __atomic_load_n(&s_dropped, __ATOMIC_RELAXED);
+    stats->dropped_bytes = __atomic_load_n(&s_dropped_bytes, __ATOMIC_RELAXED);
+    stats->high_water_bytes = s_high_water;
+
+    if (reset) {
+        __atomic_store_n(&s_pushed, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&s_dropped, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&s_dropped_bytes, 0, __ATOMIC_RELAXED);
+    }
+}
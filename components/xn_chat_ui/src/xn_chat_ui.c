@@ -0,0 +1,624 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-04 10:12:36
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-04 10:12:36
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_chat_ui\src\xn_chat_ui.c
+ * @Description: 对话状态界面实现 - 状态变化只改动对应控件，动画切换按像素预算淡入淡出
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "xn_chat_ui.h"
+#include "chat_text_ring.h"
+#include "chat_font.h"
+#include "xn_lvgl.h"
+#include "xn_lottie_manager.h"
+
+static const char *TAG = "CHAT_UI";
+
+// 字幕环形缓冲是单生产者的：字幕可能由多个任务写入（消息解析、本地命令结果），写入侧在此串行化
+static portMUX_TYPE s_text_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// 各状态对应的动画与状态图标
+typedef struct {
+    const char *name;
+    int anim;                   // LOTTIE_ANIM_*，相同动画的状态之间切换不重绘动画区域
+    const char *icon;           // 状态图标（LVGL 内置符号，空串表示不显示）
+    uint32_t color;             // 图标颜色
+} chat_ui_state_desc_t;
+
+static const chat_ui_state_desc_t s_state_desc[CHAT_UI_STATE_MAX] = {
+    [CHAT_UI_STATE_BOOT]            = {"boot",      LOTTIE_ANIM_LOADING, LV_SYMBOL_REFRESH,    0x9CA3AF},
+    [CHAT_UI_STATE_WIFI_CONNECTING] = {"wifi",      LOTTIE_ANIM_WIFI,    "",                   0x9CA3AF},
+    [CHAT_UI_STATE_IDLE]            = {"idle",      LOTTIE_ANIM_MIC,     "",                   0x9CA3AF},
+    [CHAT_UI_STATE_LISTENING]       = {"listening", LOTTIE_ANIM_MIC,     LV_SYMBOL_AUDIO,      0xEF4444},
+    [CHAT_UI_STATE_THINKING]        = {"thinking",  LOTTIE_ANIM_THINK,   LV_SYMBOL_REFRESH,    0x3B82F6},
+    [CHAT_UI_STATE_SPEAKING]        = {"speaking",  LOTTIE_ANIM_SPEAK,   LV_SYMBOL_VOLUME_MAX, 0x22C55E},
+    [CHAT_UI_STATE_OTA]             = {"ota",       LOTTIE_ANIM_OTA,     LV_SYMBOL_DOWNLOAD,   0x3B82F6},
+};
+
+// 图标：记录当前内容，只有内容或颜色变化时才触发重绘
+typedef struct {
+    lv_obj_t *label;
+    const char *text;
+    uint32_t color;
+} chat_ui_icon_t;
+
+// 字幕行：每行一个单行标签，文字直接引用行缓冲。追加片段只重排当前行，
+// 换行时把最早的一行挪到底部复用，其余行只改 y 坐标，不重排整段文字
+typedef struct {
+    lv_obj_t *label;
+    char text[CHAT_UI_LINE_BYTES];
+    uint16_t len;
+    int32_t width;              // 已占用像素宽度
+} chat_ui_line_t;
+
+// 字宽缓存：码点 -> 前进宽度，换行判断不必每个字都查字体
+typedef struct {
+    uint32_t key;               // 码点 + 1，0 表示空槽
+    uint16_t width;
+} chat_ui_glyph_t;
+
+static chat_ui_glyph_t s_glyph_cache[CHAT_UI_GLYPH_CACHE_SIZE];
+
+static struct {
+    lv_obj_t *anim_area;        // 动画区域（裁剪 Lottie 对象）
+    lv_obj_t *fade_mask;        // 背景色遮罩，淡入淡出时覆盖动画区域
+    lv_obj_t *subtitle_box;     // 字幕区域（裁剪）
+    chat_ui_line_t lines[CHAT_UI_SUBTITLE_LINES];
+    uint8_t line_cur;           // 正在追加的行（显示在最底部）
+    int32_t line_height;
+    const lv_font_t *font;
+    bool subtitle_pending_clear;// 读到消息分隔，下一段片段到来时先清空
+    bool font_cache_enabled;    // 字库位图缓存开关（对比测量用）
+    chat_ui_icon_t wifi_icon;
+    chat_ui_icon_t state_icon;
+    lv_timer_t *stats_timer;
+    chat_ui_state_t state;
+    int target_anim;            // 最终要显示的动画
+    int shown_anim;             // 已交给 Lottie 管理器的动画
+    uint32_t fade_half_ms;      // 淡出/淡入各自时长，0 表示直接切换
+    chat_ui_stats_t stats;
+
+    // 字幕统计（统计周期内累计，只在 LVGL 任务中修改）
+    uint32_t text_fragments;
+    uint64_t text_total_us;
+    uint32_t text_max_us;
+    uint32_t glyph_hits;
+    uint32_t glyph_misses;
+    uint32_t line_updates;      // 字幕行标签更新次数（每次都会触发该行重绘、逐字取位图）
+} s_ui = {
+    .state = CHAT_UI_STATE_MAX,
+    .target_anim = -1,
+    .shown_anim = -1,
+    .font_cache_enabled = true,
+};
+
+/* 图标内容或颜色变化时才更新（每次 set_text 都会重绘标签区域） */
+static void chat_ui_icon_update(chat_ui_icon_t *icon, const char *text, uint32_t color)
+{
+    if (!icon->text || strcmp(icon->text, text) != 0) {
+        icon->text = text;
+        lv_label_set_text_static(icon->label, text);
+    }
+    if (icon->color != color) {
+        icon->color = color;
+        lv_obj_set_style_text_color(icon->label, lv_color_hex(color), 0);
+    }
+}
+
+static lv_obj_t *chat_ui_icon_create(lv_obj_t *parent, int32_t x_ofs)
+{
+    lv_obj_t *label = lv_label_create(parent);
+    if (label) {
+        lv_label_set_text_static(label, "");
+        lv_obj_set_style_text_font(label, &lv_font_montserrat_16, 0);
+        lv_obj_align(label, LV_ALIGN_TOP_MID, x_ofs, CHAT_UI_ICON_Y);
+    }
+    return label;
+}
+
+static void chat_ui_fade_exec_cb(void *var, int32_t v)
+{
+    lv_obj_set_style_bg_opa((lv_obj_t *)var, (lv_opa_t)v, 0);
+}
+
+/* 把遮罩不透明度从当前值变到 to，时长按剩余变化量折算 */
+static void chat_ui_fade_start(lv_opa_t to, uint32_t delay_ms, lv_anim_completed_cb_t completed_cb)
+{
+    lv_obj_t *mask = s_ui.fade_mask;
+    lv_opa_t from = lv_obj_get_style_bg_opa(mask, 0);
+    uint32_t span = from > to ? from - to : to - from;
+    uint32_t duration = s_ui.fade_half_ms * span / LV_OPA_COVER;
+
+    lv_anim_delete(mask, chat_ui_fade_exec_cb);
+    lv_obj_remove_flag(mask, LV_OBJ_FLAG_HIDDEN);
+
+    lv_anim_t a;
+    lv_anim_init(&a);
+    lv_anim_set_var(&a, mask);
+    lv_anim_set_exec_cb(&a, chat_ui_fade_exec_cb);
+    lv_anim_set_values(&a, from, to);
+    lv_anim_set_duration(&a, duration > 0 ? duration : 1);
+    lv_anim_set_delay(&a, delay_ms);
+    lv_anim_set_completed_cb(&a, completed_cb);
+    lv_anim_start(&a);
+}
+
+/* 淡入完成：遮罩完全透明后隐藏，不再参与绘制 */
+static void chat_ui_fade_in_done_cb(lv_anim_t *a)
+{
+    lv_obj_add_flag((lv_obj_t *)a->var, LV_OBJ_FLAG_HIDDEN);
+}
+
+/* 淡出完成：动画区域已被背景色覆盖，此时切换动画，再淡入 */
+static void chat_ui_fade_out_done_cb(lv_anim_t *a)
+{
+    (void)a;
+
+    lottie_manager_play_anim(s_ui.target_anim);
+    s_ui.shown_anim = s_ui.target_anim;
+
+    // Lottie 管理器在自己的任务里切换，留一个刷新周期再开始淡入
+    chat_ui_fade_start(LV_OPA_TRANSP, LV_DEF_REFR_PERIOD, chat_ui_fade_in_done_cb);
+}
+
+/* 切换到新动画（调用方持有 LVGL 锁） */
+static void chat_ui_switch_anim(int anim)
+{
+    if (anim == s_ui.target_anim) {
+        return;
+    }
+    s_ui.target_anim = anim;
+    s_ui.stats.anim_switches++;
+
+    if (s_ui.fade_half_ms == 0 || s_ui.shown_anim < 0) {
+        // 首个动画或像素预算不足以淡入淡出：直接切换
+        lv_anim_delete(s_ui.fade_mask, chat_ui_fade_exec_cb);
+        lv_obj_set_style_bg_opa(s_ui.fade_mask, LV_OPA_TRANSP, 0);
+        lv_obj_add_flag(s_ui.fade_mask, LV_OBJ_FLAG_HIDDEN);
+        lottie_manager_play_anim(anim);
+        s_ui.shown_anim = anim;
+        return;
+    }
+
+    // 正在淡入/淡出时从当前不透明度继续淡出，淡出结束时切换到最新的目标动画
+    s_ui.stats.fades++;
+    chat_ui_fade_start(LV_OPA_COVER, 0, chat_ui_fade_out_done_cb);
+}
+
+/* 解码一个 UTF-8 字符，返回字节数（非法字节按单字节处理） */
+static size_t chat_ui_utf8_next(const char *s, size_t len, uint32_t *cp)
+{
+    uint8_t c = (uint8_t)s[0];
+    size_t n = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 1;
+    if (n > len) {
+        n = 1;
+    }
+    if (n == 1) {
+        *cp = c;
+        return 1;
+    }
+
+    uint32_t v = c & (0x7F >> n);
+    for (size_t i = 1; i < n; i++) {
+        v = (v << 6) | ((uint8_t)s[i] & 0x3F);
+    }
+    *cp = v;
+    return n;
+}
+
+static int32_t chat_ui_glyph_width(uint32_t cp)
+{
+    chat_ui_glyph_t *g = &s_glyph_cache[cp & (CHAT_UI_GLYPH_CACHE_SIZE - 1)];
+    if (g->key == cp + 1) {
+        s_ui.glyph_hits++;
+        return g->width;
+    }
+    s_ui.glyph_misses++;
+    g->key = cp + 1;
+    g->width = lv_font_get_glyph_width(s_ui.font, cp, 0);
+    return g->width;
+}
+
+static void chat_ui_line_refresh(chat_ui_line_t *line)
+{
+    lv_label_set_text_static(line->label, line->text);
+    s_ui.line_updates++;
+}
+
+/* 按当前行号重新排列各行的 y 坐标：当前行在最底部，其余依次向上 */
+static void chat_ui_subtitle_layout(void)
+{
+    for (int i = 0; i < CHAT_UI_SUBTITLE_LINES; i++) {
+        int row = (i - s_ui.line_cur - 1 + 2 * CHAT_UI_SUBTITLE_LINES) % CHAT_UI_SUBTITLE_LINES;
+        lv_obj_set_y(s_ui.lines[i].label, row * s_ui.line_height);
+    }
+}
+
+static void chat_ui_line_reset(chat_ui_line_t *line)
+{
+    bool was_empty = line->len == 0;
+    line->len = 0;
+    line->width = 0;
+    line->text[0] = '\0';
+    if (!was_empty) {
+        chat_ui_line_refresh(line);
+    }
+}
+
+/* 最早的一行清空后挪到底部作为新的当前行 */
+static void chat_ui_subtitle_newline(void)
+{
+    s_ui.line_cur = (s_ui.line_cur + 1) % CHAT_UI_SUBTITLE_LINES;
+    chat_ui_line_reset(&s_ui.lines[s_ui.line_cur]);
+    chat_ui_subtitle_layout();
+}
+
+static void chat_ui_subtitle_clear(void)
+{
+    for (int i = 0; i < CHAT_UI_SUBTITLE_LINES; i++) {
+        chat_ui_line_reset(&s_ui.lines[i]);
+    }
+}
+
+/* 把片段逐字追加到当前行，放不下时换行；每行只在片段处理完（或换行前）刷新一次 */
+static void chat_ui_subtitle_append(const char *text, size_t len)
+{
+    chat_ui_line_t *line = &s_ui.lines[s_ui.line_cur];
+    bool dirty = false;
+
+    for (size_t pos = 0; pos < len;) {
+        uint32_t cp;
+        size_t n = chat_ui_utf8_next(text + pos, len - pos, &cp);
+        pos += n;
+
+        bool hard_break = cp == '\n' || cp == '\r';
+        int32_t w = hard_break ? 0 : chat_ui_glyph_width(cp);
+        bool full = line->width + w > CHAT_UI_SUBTITLE_WIDTH || line->len + n >= CHAT_UI_LINE_BYTES;
+        if (line->len > 0 && (hard_break || full)) {
+            if (dirty) {
+                chat_ui_line_refresh(line);
+            }
+            chat_ui_subtitle_newline();
+            line = &s_ui.lines[s_ui.line_cur];
+            dirty = false;
+        }
+        if (hard_break || (cp == ' ' && line->len == 0) || line->len + n >= CHAT_UI_LINE_BYTES) {
+            continue;   // 行首空格和换行符不显示
+        }
+
+        memcpy(&line->text[line->len], text + pos - n, n);
+        line->len += n;
+        line->text[line->len] = '\0';
+        line->width += w;
+        dirty = true;
+    }
+
+    if (dirty) {
+        chat_ui_line_refresh(line);
+    }
+}
+
+/* LVGL 任务唤醒钩子（持有 lv_lock）：消费环形缓冲中的字幕片段 */
+static void chat_ui_text_hook(void)
+{
+    char buf[CHAT_TEXT_RECORD_MAX];
+
+    for (int i = 0; i < CHAT_UI_TEXT_BATCH; i++) {
+        int len = chat_text_ring_pop(buf);
+        if (len < 0) {
+            return;
+        }
+        if (len == 0) {
+            s_ui.subtitle_pending_clear = true;
+            continue;
+        }
+
+        int64_t start_us = esp_timer_get_time();
+        if (s_ui.subtitle_pending_clear) {
+            s_ui.subtitle_pending_clear = false;
+            chat_ui_subtitle_clear();
+        }
+        chat_ui_subtitle_append(buf, (size_t)len);
+
+        uint32_t us = (uint32_t)(esp_timer_get_time() - start_us);
+        s_ui.text_fragments++;
+        s_ui.text_total_us += us;
+        if (us > s_ui.text_max_us) {
+            s_ui.text_max_us = us;
+        }
+    }
+
+    // 本轮没处理完，下一轮继续，先让出给渲染
+    lvgl_driver_wake();
+}
+
+/* 定期输出刷新像素数，衡量每个状态下的实际重绘面积 */
+static void chat_ui_stats_timer_cb(lv_timer_t *timer)
+{
+    (void)timer;
+
+    lvgl_display_stats_t st;
+    if (lvgl_driver_get_stats(&st, true) != ESP_OK) {
+        return;
+    }
+    s_ui.stats.pixels_per_s = st.pixels_per_s;
+    s_ui.stats.pixels_per_frame_avg = st.pixels_per_frame_avg;
+    s_ui.stats.fps_x10 = st.fps_x10;
+
+    chat_text_ring_stats_t ring;
+    chat_text_ring_get_stats(&ring, true);
+    uint32_t lookups = s_ui.glyph_hits + s_ui.glyph_misses;
+    s_ui.stats.subtitle_fragments = s_ui.text_fragments;
+    s_ui.stats.subtitle_dropped = ring.dropped_fragments;
+    s_ui.stats.subtitle_dropped_bytes = ring.dropped_bytes;
+    s_ui.stats.delta_render_avg_us = s_ui.text_fragments ? (uint32_t)(s_ui.text_total_us / s_ui.text_fragments) : 0;
+    s_ui.stats.delta_render_max_us = s_ui.text_max_us;
+    s_ui.stats.glyph_hit_permille = lookups ? (uint32_t)((uint64_t)s_ui.glyph_hits * 1000 / lookups) : 0;
+    s_ui.text_fragments = 0;
+    s_ui.text_total_us = 0;
+    s_ui.text_max_us = 0;
+    s_ui.glyph_hits = 0;
+    s_ui.glyph_misses = 0;
+
+    // 字形位图耗时在重绘时发生，按本周期行标签更新次数折算成每次更新的耗时
+    chat_font_stats_t font;
+    bool has_font = chat_font_get() != NULL;
+    if (has_font) {
+        chat_font_get_stats(&font, true);
+        uint32_t fetches = font.hits + font.misses;
+        s_ui.stats.subtitle_updates = s_ui.line_updates;
+        s_ui.stats.glyph_us_per_update = s_ui.line_updates ? (uint32_t)(font.bitmap_us / s_ui.line_updates) : 0;
+        s_ui.stats.font_cache_hit_permille = fetches ? (uint32_t)((uint64_t)font.hits * 1000 / fetches) : 0;
+    }
+    s_ui.line_updates = 0;
+
+    uint32_t screen_px = (uint32_t)lv_display_get_horizontal_resolution(g_lvgl_display) *
+                         (uint32_t)lv_display_get_vertical_resolution(g_lvgl_display);
+    ESP_LOGI(TAG, "📊 [%s] 刷新 %lu px/s, %lu px/帧 (整屏 %lu%%), %lu.%lu FPS",
+             s_ui.state < CHAT_UI_STATE_MAX ? s_state_desc[s_ui.state].name : "-",
+             (unsigned long)st.pixels_per_s, (unsigned long)st.pixels_per_frame_avg,
+             (unsigned long)(screen_px ? (uint64_t)st.pixels_per_frame_avg * 100 / screen_px : 0),
+             (unsigned long)(st.fps_x10 / 10), (unsigned long)(st.fps_x10 % 10));
+    if (s_ui.stats.subtitle_fragments > 0 || s_ui.stats.subtitle_dropped > 0) {
+        ESP_LOGI(TAG, "📝 字幕 %lu 段, %lu us/段 (最大 %lu us), 丢弃 %lu 段 %lu 字节, 字宽缓存命中 %lu‰",
+                 (unsigned long)s_ui.stats.subtitle_fragments, (unsigned long)s_ui.stats.delta_render_avg_us,
+                 (unsigned long)s_ui.stats.delta_render_max_us, (unsigned long)s_ui.stats.subtitle_dropped,
+                 (unsigned long)s_ui.stats.subtitle_dropped_bytes, (unsigned long)s_ui.stats.glyph_hit_permille);
+    }
+    if (has_font && font.bitmap_calls > 0) {
+        ESP_LOGI(TAG, "🔤 字形 %lu us/次行更新 (%lu 次更新, %lu 次取位图), 位图缓存%s 命中 %lu‰, 淘汰 %lu, "
+                 "占用 %lu 字 / %lu KB, 回退 %lu 次",
+                 (unsigned long)s_ui.stats.glyph_us_per_update, (unsigned long)s_ui.stats.subtitle_updates,
+                 (unsigned long)font.bitmap_calls, s_ui.font_cache_enabled ? "" : "(已关闭)",
+                 (unsigned long)s_ui.stats.font_cache_hit_permille, (unsigned long)font.evictions,
+                 (unsigned long)font.cached_glyphs, (unsigned long)(font.cached_bytes / 1024),
+                 (unsigned long)font.not_found);
+    }
+}
+
+esp_err_t chat_ui_init(void)
+{
+    if (s_ui.anim_area) {
+        return ESP_OK;
+    }
+
+    // 淡入淡出帧数由像素预算决定：每帧额外重绘整个动画区域
+    uint32_t fade_frames = CHAT_UI_FADE_PIXEL_BUDGET / (CHAT_UI_ANIM_SIZE * CHAT_UI_ANIM_SIZE);
+    uint32_t fade_ms = fade_frames * LV_DEF_REFR_PERIOD;
+    if (fade_ms > CHAT_UI_FADE_MAX_MS) {
+        fade_ms = CHAT_UI_FADE_MAX_MS;
+        fade_frames = fade_ms / LV_DEF_REFR_PERIOD;
+    }
+    s_ui.fade_half_ms = fade_frames >= 2 ? fade_ms / 2 : 0;
+    s_ui.stats.fade_frames = fade_frames >= 2 ? fade_frames : 0;
+
+    lv_lock();
+    lv_obj_t *scr = lv_screen_active();
+
+    // 静态背景：纯色屏幕，之后不再失效
+    lv_obj_set_style_bg_color(scr, lv_color_hex(CHAT_UI_BG_COLOR), 0);
+    lv_obj_set_style_bg_opa(scr, LV_OPA_COVER, 0);
+    lv_obj_remove_flag(scr, LV_OBJ_FLAG_SCROLLABLE);
+
+    // 动画区域：透明容器，子对象超出部分被裁剪，动画每帧只重绘这块区域
+    s_ui.anim_area = lv_obj_create(scr);
+    if (s_ui.anim_area) {
+        lv_obj_remove_style_all(s_ui.anim_area);
+        lv_obj_set_size(s_ui.anim_area, CHAT_UI_ANIM_SIZE, CHAT_UI_ANIM_SIZE);
+        lv_obj_align(s_ui.anim_area, LV_ALIGN_CENTER, 0, CHAT_UI_ANIM_OFFSET_Y);
+        lv_obj_remove_flag(s_ui.anim_area, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+    }
+
+    // 淡入淡出遮罩：与动画区域重合，平时隐藏
+    s_ui.fade_mask = lv_obj_create(scr);
+    if (s_ui.fade_mask) {
+        lv_obj_remove_style_all(s_ui.fade_mask);
+        lv_obj_set_size(s_ui.fade_mask, CHAT_UI_ANIM_SIZE, CHAT_UI_ANIM_SIZE);
+        lv_obj_align(s_ui.fade_mask, LV_ALIGN_CENTER, 0, CHAT_UI_ANIM_OFFSET_Y);
+        lv_obj_set_style_bg_color(s_ui.fade_mask, lv_color_hex(CHAT_UI_BG_COLOR), 0);
+        lv_obj_set_style_bg_opa(s_ui.fade_mask, LV_OPA_TRANSP, 0);
+        lv_obj_remove_flag(s_ui.fade_mask, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_add_flag(s_ui.fade_mask, LV_OBJ_FLAG_HIDDEN);
+    }
+
+    // 状态图标：网络在左，对话状态在右
+    s_ui.wifi_icon.label = chat_ui_icon_create(scr, -16);
+    s_ui.state_icon.label = chat_ui_icon_create(scr, 16);
+
+    // 字幕区域：固定大小并裁剪，由若干单行标签组成，当前行在最底部。
+    // 优先使用 font_glyphs 分区中的中文字库子集，缺字回退到内置字体
+    s_ui.font = chat_font_init() == ESP_OK ? chat_font_get() : &lv_font_montserrat_16;
+    s_ui.line_height = lv_font_get_line_height(s_ui.font);
+    bool lines_ok = false;
+    s_ui.subtitle_box = lv_obj_create(scr);
+    if (s_ui.subtitle_box) {
+        lv_obj_remove_style_all(s_ui.subtitle_box);
+        lv_obj_set_size(s_ui.subtitle_box, CHAT_UI_SUBTITLE_WIDTH, s_ui.line_height * CHAT_UI_SUBTITLE_LINES);
+        lv_obj_align(s_ui.subtitle_box, LV_ALIGN_BOTTOM_MID, 0, -CHAT_UI_SUBTITLE_BOTTOM);
+        lv_obj_remove_flag(s_ui.subtitle_box, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+
+        lines_ok = true;
+        for (int i = 0; i < CHAT_UI_SUBTITLE_LINES && lines_ok; i++) {
+            chat_ui_line_t *line = &s_ui.lines[i];
+            line->label = lv_label_create(s_ui.subtitle_box);
+            if (!line->label) {
+                lines_ok = false;
+                break;
+            }
+            lv_obj_set_width(line->label, CHAT_UI_SUBTITLE_WIDTH);
+            lv_label_set_long_mode(line->label, LV_LABEL_LONG_CLIP);
+            lv_label_set_text_static(line->label, line->text);
+            lv_obj_set_style_text_font(line->label, s_ui.font, 0);
+            lv_obj_set_style_text_color(line->label, lv_color_hex(0x374151), 0);
+            lv_obj_set_style_text_align(line->label, LV_TEXT_ALIGN_CENTER, 0);
+        }
+        if (lines_ok) {
+            chat_ui_subtitle_layout();
+        }
+    }
+
+    s_ui.stats_timer = lv_timer_create(chat_ui_stats_timer_cb, CHAT_UI_STATS_PERIOD_MS, NULL);
+
+    bool ok = s_ui.anim_area && s_ui.fade_mask && s_ui.wifi_icon.label &&
+              s_ui.state_icon.label && lines_ok && s_ui.stats_timer;
+    if (ok) {
+        chat_ui_icon_update(&s_ui.wifi_icon, LV_SYMBOL_WIFI, 0x9CA3AF);
+    }
+    lv_unlock();
+
+    if (!ok) {
+        ESP_LOGE(TAG, "创建对话界面失败");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Lottie 对象挂到动画区域下，下次切换动画时生效
+    xn_lottie_manager_set_parent(s_ui.anim_area);
+
+    // 字幕片段在 LVGL 任务每次唤醒时消费
+    lvgl_driver_set_wake_hook(chat_ui_text_hook);
+
+    ESP_LOGI(TAG, "✅ 对话界面已创建: 动画区域 %dx%d, 淡入淡出 %lu 帧 (%lu ms)",
+             CHAT_UI_ANIM_SIZE, CHAT_UI_ANIM_SIZE,
+             (unsigned long)s_ui.stats.fade_frames, (unsigned long)(s_ui.fade_half_ms * 2));
+    return ESP_OK;
+}
+
+void chat_ui_set_state(chat_ui_state_t state)
+{
+    if (!s_ui.anim_area || state >= CHAT_UI_STATE_MAX) {
+        return;
+    }
+
+    lv_lock();
+    if (state != s_ui.state) {
+        const chat_ui_state_desc_t *desc = &s_state_desc[state];
+        ESP_LOGI(TAG, "状态: %s -> %s",
+                 s_ui.state < CHAT_UI_STATE_MAX ? s_state_desc[s_ui.state].name : "-", desc->name);
+
+        s_ui.state = state;
+        s_ui.stats.state_changes++;
+        chat_ui_icon_update(&s_ui.state_icon, desc->icon, desc->color);
+        chat_ui_switch_anim(desc->anim);
+
+        // 开始新一轮对话或断网时清掉上一轮字幕（持有 lv_lock，与唤醒钩子互斥，可以代替消费者丢弃未读片段）
+        if (state == CHAT_UI_STATE_LISTENING || state == CHAT_UI_STATE_WIFI_CONNECTING) {
+            chat_text_ring_discard();
+            s_ui.subtitle_pending_clear = false;
+            chat_ui_subtitle_clear();
+        }
+    }
+    lv_unlock();
+}
+
+chat_ui_state_t chat_ui_get_state(void)
+{
+    return s_ui.state;
+}
+
+void chat_ui_set_wifi(bool connected)
+{
+    if (!s_ui.anim_area) {
+        return;
+    }
+
+    lv_lock();
+    chat_ui_icon_update(&s_ui.wifi_icon, LV_SYMBOL_WIFI, connected ? 0x22C55E : 0x9CA3AF);
+    lv_unlock();
+}
+
+void chat_ui_subtitle_push(const char *delta)
+{
+    if (!s_ui.anim_area || !delta || !delta[0]) {
+        return;
+    }
+
+    // 只写环形缓冲并通知，不碰 LVGL 锁，解析任务不会被界面阻塞
+    portENTER_CRITICAL(&s_text_lock);
+    bool pushed = chat_text_ring_push(delta, strlen(delta));
+    portEXIT_CRITICAL(&s_text_lock);
+    if (pushed) {
+        lvgl_driver_wake();
+    }
+}
+
+void chat_ui_subtitle_break(void)
+{
+    if (!s_ui.anim_area) {
+        return;
+    }
+    portENTER_CRITICAL(&s_text_lock);
+    chat_text_ring_push_break();
+    portEXIT_CRITICAL(&s_text_lock);
+}
+
+void chat_ui_set_subtitle(const char *text)
+{
+    if (!s_ui.anim_area) {
+        return;
+    }
+
+    // 三条记录一次写入，不会与其他任务的流式片段交错
+    bool pushed = false;
+    portENTER_CRITICAL(&s_text_lock);
+    chat_text_ring_push_break();
+    if (text && text[0]) {
+        pushed = chat_text_ring_push(text, strlen(text));
+    }
+    chat_text_ring_push_break();
+    portEXIT_CRITICAL(&s_text_lock);
+    if (pushed) {
+        lvgl_driver_wake();
+    }
+}
+
+void chat_ui_set_glyph_cache(bool enable)
+{
+    lv_lock();
+    s_ui.font_cache_enabled = enable;
+    chat_font_set_cache_enabled(enable);
+    lv_unlock();
+    ESP_LOGI(TAG, "字库位图缓存: %s", enable ? "开启" : "关闭");
+}
+
+esp_err_t chat_ui_get_stats(chat_ui_stats_t *stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_ui.anim_area) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    lv_lock();
+    *stats = s_ui.stats;
+    stats->state = s_ui.state;
+    lv_unlock();
+    return ESP_OK;
+}
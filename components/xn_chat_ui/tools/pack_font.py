@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+字幕字库子集打包工具
+
+把 TTF/OTF 字体在主机上按固定字号预光栅化为 4bpp 位图，只保留实际会用到的字符，
+打包成 font_glyphs 分区镜像，供 xn_chat_ui 通过 esp_partition_mmap 直接映射，
+设备端不再运行矢量光栅化，也不需要把整套 CJK 字库编进固件。
+
+字符集（去重后按码点排序，设备端二分查找）：
+    1. 可打印 ASCII 与常用中文标点
+    2. --scan 目录下 .c/.cpp/.h 源码中的字符串字面量（跳过日志/printf 行）
+    3. --text 文本文件中的全部字符（设备固定用语，见 font_extra.txt）
+    4. --common-file 按频率降序排列的常用字表取前 --common 个（见 common_chars.txt），
+       字表不足时用 GB2312 一级汉字补足
+
+镜像格式（小端）：
+    header  (24 B) : magic "XNFG", u16 version, u16 font_px, u32 count,
+                     u16 line_height, i16 base_line, u8 bpp, u8 reserved, u16 reserved, u32 image_size
+    entry[] (16 B) : u32 codepoint, u32 bitmap_offset, u16 adv_w, u8 box_w, u8 box_h,
+                     i8 ofs_x, i8 ofs_y, u16 reserved      按 codepoint 升序
+    bitmap         : 4bpp 灰度，逐行连续存放（行间不补齐），每字节高 4 位在前
+
+依赖：Pillow
+    pip install pillow
+
+用法：
+    python pack_font.py --font NotoSansSC-Regular.otf --px 18 --output font_glyphs.bin \\
+        --scan ../../../main --text font_extra.txt --common-file common_chars.txt --common 3500
+
+--optional：缺少字体文件或 Pillow 时输出空镜像（count = 0）而不是报错，设备端回退到内置字体。
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+MAGIC = b"XNFG"
+VERSION = 1
+BPP = 4
+HEADER_FMT = "<4sHHIHhBBHI"
+ENTRY_FMT = "<IIHBBbbH"
+HEADER_SIZE = struct.calcsize(HEADER_FMT)
+ENTRY_SIZE = struct.calcsize(ENTRY_FMT)
+
+BASE_CHARS = "".join(chr(c) for c in range(0x20, 0x7F)) + "，。！？、：；“”‘’（）《》…—·～℃"
+SOURCE_EXTS = (".c", ".cpp", ".h")
+SKIP_LINE = re.compile(r"ESP_LOG|printf")
+STRING_LITERAL = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+NOTDEF_PROBE = "\U000FFFFD"
+
+
+def gb2312_level1():
+    """GB2312 一级汉字（按拼音排序，3755 个），作为常用字表不足时的补充"""
+    chars = []
+    for hi in range(0xB0, 0xD8):
+        for lo in range(0xA1, 0xFF):
+            if hi == 0xD7 and lo > 0xF9:
+                break
+            chars.append(bytes((hi, lo)).decode("gb2312"))
+    return chars
+
+
+def read_text(path):
+    """读取文本文件，忽略 # 开头的注释行与空白字符"""
+    with open(path, encoding="utf-8") as fp:
+        lines = [line for line in fp if not line.startswith("#")]
+    return [c for c in "".join(lines) if not c.isspace()]
+
+
+def scan_sources(paths):
+    """收集源码字符串字面量中的非 ASCII 字符（日志输出不上屏，跳过）"""
+    found = []
+    for root in paths:
+        for dirpath, _, files in os.walk(root):
+            for name in files:
+                if not name.endswith(SOURCE_EXTS):
+                    continue
+                with open(os.path.join(dirpath, name), encoding="utf-8", errors="ignore") as fp:
+                    for line in fp:
+                        if SKIP_LINE.search(line):
+                            continue
+                        for literal in STRING_LITERAL.findall(line):
+                            found.extend(c for c in literal if ord(c) >= 0x80)
+    return found
+
+
+def collect_charset(args):
+    used = set(BASE_CHARS)
+    scanned = scan_sources(args.scan)
+    used.update(scanned)
+    for path in args.text:
+        used.update(read_text(path))
+    fixed = len(used)
+
+    ranked = read_text(args.common_file) if args.common_file else []
+    ranked += gb2312_level1()
+    common = []
+    seen = set()
+    for c in ranked:
+        if len(common) >= args.common:
+            break
+        if c not in seen:
+            seen.add(c)
+            common.append(c)
+    used.update(common)
+
+    print("  字符集: 固定 %d (源码 %d) + 常用字 %d -> %d" %
+          (fixed, len(set(scanned)), len(common), len(used)))
+    return sorted(used, key=ord)
+
+
+def clamp(value, low, high):
+    return max(low, min(high, value))
+
+
+def render_glyph(font, char):
+    """以基线为原点渲染一个字符，返回 (adv_w, box_w, box_h, ofs_x, ofs_y, 4bpp 数据)"""
+    from PIL import Image, ImageDraw
+
+    adv_w = int(round(font.getlength(char)))
+    x0, y0, x1, y1 = font.getbbox(char, anchor="ls")
+    box_w = clamp(x1 - x0, 0, 255)
+    box_h = clamp(y1 - y0, 0, 255)
+    if box_w == 0 or box_h == 0:
+        return adv_w, 0, 0, 0, 0, b""
+
+    img = Image.new("L", (box_w, box_h), 0)
+    ImageDraw.Draw(img).text((-x0, -y0), char, font=font, fill=255, anchor="ls")
+    pixels = img.tobytes()
+
+    data = bytearray((box_w * box_h + 1) // 2)
+    for i, value in enumerate(pixels):
+        nibble = value >> 4
+        data[i >> 1] |= nibble << 4 if (i & 1) == 0 else nibble
+    # LVGL 的 ofs_y 为位图底边相对基线的高度（向上为正）
+    return adv_w, box_w, box_h, clamp(x0, -128, 127), clamp(-y1, -128, 127), bytes(data)
+
+
+def mask_key(font, char):
+    mask = font.getmask(char)
+    return mask.size, bytes(mask)
+
+
+def build_image(args):
+    from PIL import ImageFont
+
+    font = ImageFont.truetype(args.font, args.px)
+    ascent, descent = font.getmetrics()
+
+    # 字体里没有的字会渲染成 .notdef 方框，与私用区码点的渲染结果比对后剔除，交给设备端回退字体
+    notdef = mask_key(font, NOTDEF_PROBE)
+    wanted = collect_charset(args)
+    charset = [c for c in wanted if c == " " or mask_key(font, c) != notdef]
+
+    index = bytearray()
+    bitmaps = bytearray()
+    bitmap_base = HEADER_SIZE + ENTRY_SIZE * len(charset)
+    raw = 0
+    for char in charset:
+        adv_w, box_w, box_h, ofs_x, ofs_y, data = render_glyph(font, char)
+        index += struct.pack(ENTRY_FMT, ord(char), bitmap_base + len(bitmaps), adv_w,
+                             box_w, box_h, ofs_x, ofs_y, 0)
+        bitmaps += data
+        raw += box_w * box_h
+
+    image_size = bitmap_base + len(bitmaps)
+    header = struct.pack(HEADER_FMT, MAGIC, VERSION, args.px, len(charset),
+                         ascent + descent, descent, BPP, 0, 0, image_size)
+    print("  %s %dpx: %d 字形 (缺字 %d), 行高 %d, 位图 %d bytes (A8 展开 %d bytes)" %
+          (os.path.basename(args.font), args.px, len(charset), len(wanted) - len(charset),
+           ascent + descent, len(bitmaps), raw))
+    return header + bytes(index) + bytes(bitmaps)
+
+
+def empty_image(px):
+    return struct.pack(HEADER_FMT, MAGIC, VERSION, px, 0, 0, 0, BPP, 0, 0, HEADER_SIZE)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="打包 font_glyphs 字库子集分区镜像")
+    parser.add_argument("--font", required=True, help="TTF/OTF 字体文件")
+    parser.add_argument("--output", required=True, help="输出镜像路径")
+    parser.add_argument("--px", type=int, default=18, help="字号（像素）")
+    parser.add_argument("--scan", action="append", default=[],
+                        help="扫描字符串字面量的源码目录，可重复")
+    parser.add_argument("--text", action="append", default=[],
+                        help="必须包含的文本文件（全部字符入库），可重复")
+    parser.add_argument("--common-file", help="按频率降序排列的常用字表")
+    parser.add_argument("--common", type=int, default=3500, help="取常用字表前 N 个字")
+    parser.add_argument("--size", type=lambda v: int(v, 0), default=0,
+                        help="分区大小（用于容量校验，0 表示不校验）")
+    parser.add_argument("--optional", action="store_true",
+                        help="缺少字体或 Pillow 时输出空镜像而不是报错")
+    args = parser.parse_args()
+
+    try:
+        if not os.path.isfile(args.font):
+            raise FileNotFoundError("字体文件不存在: %s" % args.font)
+        image = build_image(args)
+    except (ImportError, FileNotFoundError) as err:
+        if not args.optional:
+            print("错误: %s（需要字体文件与 pip install pillow）" % err, file=sys.stderr)
+            return 1
+        print("警告: %s，生成空的 font_glyphs 镜像，设备端将使用内置字体" % err)
+        image = empty_image(args.px)
+    except (OSError, ValueError, UnicodeDecodeError) as err:
+        print("错误: %s" % err, file=sys.stderr)
+        return 1
+
+    if args.size and len(image) > args.size:
+        print("错误: 镜像 %d 字节超出分区大小 %d 字节" % (len(image), args.size), file=sys.stderr)
+        return 1
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "wb") as fp:
+        fp.write(image)
+
+    print("font_glyphs 镜像: %s (%d bytes)" % (args.output, len(image)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,93 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 14:05:12
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 14:05:12
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_conn_supervisor\include\conn_backoff.h
+ * @Description: 指数退避重试（esp_timer 单次定时器 + 抖动）
+ *
+ * 第 n 次重试的退避上界 cap = min(max_ms, base_ms × 2^n)，实际延时在 [cap/2, cap] 内随机（等比抖动），
+ * 既保证退避下限，又让同时掉线的一批设备错开重连。等待期间没有任务轮询，到点由 esp_timer 回调一次。
+ *
+ * Copyright (c) 2026 by ${git_name_email}, All Rights Reserved.
+ */
+
+#ifndef CONN_BACKOFF_H
+#define CONN_BACKOFF_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct conn_backoff_s *conn_backoff_handle_t;
+
+/**
+ * @brief 退避到期回调
+ *
+ * 在 esp_timer 任务中调用，只应置标志 / 通知任务，不要在这里做阻塞的连接操作。
+ */
+typedef void (*conn_backoff_cb_t)(void *ctx);
+
+/**
+ * @brief 退避配置
+ */
+typedef struct {
+    const char       *name;      ///< 名称（日志与恢复统计用），须长期有效
+    uint32_t          base_ms;   ///< 第一次重试的退避上界
+    uint32_t          max_ms;    ///< 退避上界的上限
+    conn_backoff_cb_t cb;        ///< 到期回调
+    void             *ctx;       ///< 回调上下文
+} conn_backoff_config_t;
+
+#define CONN_BACKOFF_DEFAULT_CONFIG()      \
+    (conn_backoff_config_t) {              \
+        .name    = "backoff",              \
+        .base_ms = 1000,                   \
+        .max_ms  = 30000,                  \
+        .cb      = NULL,                   \
+        .ctx     = NULL,                   \
+    }
+
+/**
+ * @brief 计算第 attempt 次重试的延时（纯函数）
+ *
+ * @param attempt 已经退避过的次数（从 0 开始）
+ * @param rnd     随机数（esp_random）
+ */
+uint32_t conn_backoff_delay_ms(uint32_t base_ms, uint32_t max_ms, uint32_t attempt, uint32_t rnd);
+
+conn_backoff_handle_t conn_backoff_create(const conn_backoff_config_t *config);
+
+void conn_backoff_delete(conn_backoff_handle_t handle);
+
+/**
+ * @brief 按当前次数计算延时并启动单次定时器，次数加一
+ *
+ * @param[out] out_delay_ms 本次延时，可为 NULL
+ * @return ESP_OK 已启动, ESP_ERR_INVALID_STATE 已有一次退避在等待（不重复计数）
+ */
+esp_err_t conn_backoff_schedule(conn_backoff_handle_t handle, uint32_t *out_delay_ms);
+
+/**
+ * @brief 取消正在等待的退避，保留次数（下层网络断开时用）
+ */
+void conn_backoff_cancel(conn_backoff_handle_t handle);
+
+/**
+ * @brief 连接成功：取消等待并把次数清零
+ */
+void conn_backoff_reset(conn_backoff_handle_t handle);
+
+/**
+ * @brief 自上次 reset 以来的退避次数
+ */
+uint32_t conn_backoff_attempts(conn_backoff_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONN_BACKOFF_H */
@@ -0,0 +1,148 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 14:05:12
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 14:05:12
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_conn_supervisor\include\conn_supervisor.h
+ * @Description: 联网监督 - 事件驱动的链路 → WiFi 关联 → IP → MQTT 恢复时间线
+ *
+ * WiFi / IP 事件由本模块直接挂在默认事件循环上；RNDIS 与 MQTT 事件由各自模块调用 conn_supervisor_notify 上报。
+ * 从连通（MQTT 就绪）变为不连通的一刻开始一次"恢复"，记录各层恢复的时刻，MQTT 再次就绪时结算：
+ *
+ *   断开 ──link_ms──▶ 链路可用 ──assoc_ms──▶ WiFi 关联 ──ip_ms──▶ 拿到 IP ──mqtt_ms──▶ MQTT 就绪
+ *
+ * 断开时仍然在线的层，其时刻记为断开时刻（对应段为 0）；恢复期间下层再次掉线会清掉上层时刻并计一次 flap。
+ *
+ * Copyright (c) 2026 by ${git_name_email}, All Rights Reserved.
+ */
+
+#ifndef CONN_SUPERVISOR_H
+#define CONN_SUPERVISOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CONN_SUPERVISOR_MAX_LISTENERS 4     ///< 监听者上限
+
+/**
+ * @brief 联网事件
+ *
+ * CONN_EVENT_WIFI_* 由本模块从 WIFI_EVENT / IP_EVENT 生成，其余输入事件由对应模块上报；
+ * CONN_EVENT_NET_* 与 CONN_EVENT_RECOVERED 为派生事件，只发给监听者。
+ */
+typedef enum {
+    CONN_EVENT_WIFI_START = 0,  ///< WiFi STA 启动（链路可用）
+    CONN_EVENT_WIFI_STOP,       ///< WiFi STA 停止
+    CONN_EVENT_WIFI_ASSOC,      ///< 已关联 AP
+    CONN_EVENT_WIFI_DISASSOC,   ///< 与 AP 断开 / 关联失败
+    CONN_EVENT_WIFI_GOT_IP,     ///< STA 拿到 IP
+    CONN_EVENT_WIFI_LOST_IP,    ///< STA 丢失 IP
+    CONN_EVENT_RNDIS_UP,        ///< 4G 模组 RNDIS 链路建立
+    CONN_EVENT_RNDIS_DOWN,      ///< RNDIS 链路断开
+    CONN_EVENT_RNDIS_GOT_IP,    ///< RNDIS 网口拿到 IP
+    CONN_EVENT_RNDIS_LOST_IP,   ///< RNDIS 网口丢失 IP
+    CONN_EVENT_MQTT_UP,         ///< MQTT 已连接且完成订阅
+    CONN_EVENT_MQTT_DOWN,       ///< MQTT 断开 / 连接失败
+    CONN_EVENT_NET_UP,          ///< 派生：任一链路拿到 IP（此前没有可用 IP）
+    CONN_EVENT_NET_DOWN,        ///< 派生：最后一条有 IP 的链路失去 IP
+    CONN_EVENT_RECOVERED,       ///< 派生：一次恢复结算完成，见 conn_supervisor_get_stats
+    CONN_EVENT_MAX,
+} conn_event_t;
+
+typedef enum {
+    CONN_LINK_WIFI = 0,         ///< WiFi STA
+    CONN_LINK_RNDIS,            ///< USB RNDIS 4G
+    CONN_LINK_MAX,
+} conn_link_t;
+
+/**
+ * @brief 一次恢复的起因（断开时最先掉线的层）
+ */
+typedef enum {
+    CONN_CAUSE_BOOT = 0,        ///< 上电后的首次连接
+    CONN_CAUSE_LINK,            ///< 链路断开
+    CONN_CAUSE_ASSOC,           ///< WiFi 关联断开
+    CONN_CAUSE_IP,              ///< IP 丢失
+    CONN_CAUSE_MQTT,            ///< 网络正常，仅 MQTT 断开
+} conn_cause_t;
+
+/**
+ * @brief 一次恢复的分段耗时
+ */
+typedef struct {
+    uint32_t     seq;           ///< 恢复序号（从 1 开始）
+    conn_cause_t cause;         ///< 起因
+    conn_link_t  link;          ///< 恢复所用链路
+    uint32_t     link_ms;       ///< 断开 → 链路可用
+    uint32_t     assoc_ms;      ///< 链路可用 → WiFi 关联（RNDIS 为 0）
+    uint32_t     ip_ms;         ///< 关联 → 拿到 IP
+    uint32_t     mqtt_ms;       ///< 拿到 IP → MQTT 就绪
+    uint32_t     total_ms;      ///< 断开 → MQTT 就绪
+    uint16_t     retries;       ///< 期间各退避器累计的重试次数
+    uint16_t     flaps;         ///< 期间下层再次掉线的次数
+    uint32_t     backoff_ms;    ///< 期间退避等待的总时长（可与其他阶段重叠）
+} conn_recovery_t;
+
+typedef struct {
+    uint32_t        recoveries;     ///< 已结算的恢复次数
+    uint32_t        total_ms_avg;   ///< 平均恢复耗时
+    uint32_t        total_ms_max;   ///< 最长恢复耗时
+    bool            net_up;         ///< 当前是否有链路拿到 IP
+    bool            mqtt_up;        ///< 当前 MQTT 是否就绪
+    bool            recovering;     ///< 是否有一次恢复正在进行
+    conn_recovery_t last;           ///< 最近一次恢复
+} conn_supervisor_stats_t;
+
+/**
+ * @brief 监听回调
+ *
+ * 在上报事件的上下文中同步调用（默认事件循环任务、esp-mqtt 任务等），只应置标志 / 通知任务。
+ */
+typedef void (*conn_supervisor_cb_t)(conn_event_t event, void *ctx);
+
+/**
+ * @brief 初始化（可重复调用，仅第一次生效）
+ *
+ * 容忍默认事件循环已创建；首次初始化即开始一次 CONN_CAUSE_BOOT 恢复。
+ */
+esp_err_t conn_supervisor_init(void);
+
+/**
+ * @brief 上报输入事件（RNDIS / MQTT；WiFi 事件由本模块自行订阅，无需上报）
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG 派生事件或越界, ESP_ERR_INVALID_STATE 未初始化
+ */
+esp_err_t conn_supervisor_notify(conn_event_t event);
+
+/**
+ * @brief 注册监听者（可重复注册同一回调，不会重复调用）
+ * @return ESP_OK, ESP_ERR_NO_MEM 监听者已满
+ */
+esp_err_t conn_supervisor_add_listener(conn_supervisor_cb_t cb, void *ctx);
+
+/**
+ * @brief 当前是否有链路拿到 IP
+ */
+bool conn_supervisor_net_up(void);
+
+esp_err_t conn_supervisor_get_stats(conn_supervisor_stats_t *stats);
+
+/**
+ * @brief 恢复记录序列化为 JSON
+ * @return 写入长度，缓冲区不足时 <0 或 >=len
+ */
+int conn_supervisor_recovery_to_json(const conn_recovery_t *rec, char *buf, size_t len);
+
+const char *conn_supervisor_event_name(conn_event_t event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONN_SUPERVISOR_H */
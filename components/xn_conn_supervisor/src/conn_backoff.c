@@ -0,0 +1,170 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 14:05:12
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 14:05:12
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_conn_supervisor\src\conn_backoff.c
+ * @Description: 指数退避重试实现
+ *
+ * Copyright (c) 2026 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+
+#include "conn_backoff.h"
+#include "conn_supervisor_priv.h"
+
+static const char *TAG = "conn_backoff";
+
+struct conn_backoff_s {
+    conn_backoff_config_t cfg;
+    esp_timer_handle_t    timer;
+    portMUX_TYPE          lock;
+    uint32_t              attempts;   ///< 自上次 reset 以来的退避次数
+    bool                  pending;    ///< 定时器已启动、回调尚未执行
+};
+
+uint32_t conn_backoff_delay_ms(uint32_t base_ms, uint32_t max_ms, uint32_t attempt, uint32_t rnd)
+{
+    uint64_t cap = (attempt >= 32) ? max_ms : ((uint64_t)base_ms << attempt);
+    if (cap > max_ms) {
+        cap = max_ms;
+    }
+
+    /* 等比抖动：[cap/2, cap] 内均匀分布 */
+    uint32_t half = (uint32_t)(cap / 2);
+    return half + rnd % ((uint32_t)cap - half + 1);
+}
+
+static void conn_backoff_timer_cb(void *arg)
+{
+    conn_backoff_handle_t h = (conn_backoff_handle_t)arg;
+
+    portENTER_CRITICAL(&h->lock);
+    h->pending = false;
+    portEXIT_CRITICAL(&h->lock);
+
+    if (h->cfg.cb) {
+        h->cfg.cb(h->cfg.ctx);
+    }
+}
+
+conn_backoff_handle_t conn_backoff_create(const conn_backoff_config_t *config)
+{
+    if (config == NULL || config->cb == NULL) {
+        return NULL;
+    }
+
+    conn_backoff_handle_t h = (conn_backoff_handle_t)calloc(1, sizeof(*h));
+    if (h == NULL) {
+        return NULL;
+    }
+
+    h->cfg = *config;
+    if (h->cfg.name == NULL) {
+        h->cfg.name = "backoff";
+    }
+    if (h->cfg.base_ms > h->cfg.max_ms) {
+        h->cfg.base_ms = h->cfg.max_ms;
+    }
+    portMUX_INITIALIZE(&h->lock);
+
+    const esp_timer_create_args_t args = {
+        .callback        = conn_backoff_timer_cb,
+        .arg             = h,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name            = h->cfg.name,
+    };
+    if (esp_timer_create(&args, &h->timer) != ESP_OK) {
+        free(h);
+        return NULL;
+    }
+    return h;
+}
+
+void conn_backoff_delete(conn_backoff_handle_t handle)
+{
+    if (handle == NULL) {
+        return;
+    }
+    (void)esp_timer_stop(handle->timer);
+    (void)esp_timer_delete(handle->timer);
+    free(handle);
+}
+
+esp_err_t conn_backoff_schedule(conn_backoff_handle_t handle, uint32_t *out_delay_ms)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&handle->lock);
+    if (handle->pending) {
+        portEXIT_CRITICAL(&handle->lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint32_t attempt = handle->attempts;
+    uint32_t delay   = conn_backoff_delay_ms(handle->cfg.base_ms, handle->cfg.max_ms, attempt, esp_random());
+    handle->attempts++;
+    handle->pending = true;
+    portEXIT_CRITICAL(&handle->lock);
+
+    esp_err_t ret = esp_timer_start_once(handle->timer, (uint64_t)delay * 1000);
+    if (ret != ESP_OK) {
+        portENTER_CRITICAL(&handle->lock);
+        handle->pending = false;
+        portEXIT_CRITICAL(&handle->lock);
+        ESP_LOGE(TAG, "%s: esp_timer_start_once failed: %s", handle->cfg.name, esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "⏳ %s 第 %u 次重试，%u ms 后", handle->cfg.name, (unsigned)(attempt + 1), (unsigned)delay);
+    conn_supervisor_on_backoff(delay);
+
+    if (out_delay_ms) {
+        *out_delay_ms = delay;
+    }
+    return ESP_OK;
+}
+
+void conn_backoff_cancel(conn_backoff_handle_t handle)
+{
+    if (handle == NULL) {
+        return;
+    }
+    (void)esp_timer_stop(handle->timer);
+
+    portENTER_CRITICAL(&handle->lock);
+    handle->pending = false;
+    portEXIT_CRITICAL(&handle->lock);
+}
+
+void conn_backoff_reset(conn_backoff_handle_t handle)
+{
+    if (handle == NULL) {
+        return;
+    }
+    (void)esp_timer_stop(handle->timer);
+
+    portENTER_CRITICAL(&handle->lock);
+    handle->pending  = false;
+    handle->attempts = 0;
+    portEXIT_CRITICAL(&handle->lock);
+}
+
+uint32_t conn_backoff_attempts(conn_backoff_handle_t handle)
+{
+    if (handle == NULL) {
+        return 0;
+    }
+    portENTER_CRITICAL(&handle->lock);
+    uint32_t n = handle->attempts;
+    portEXIT_CRITICAL(&handle->lock);
+    return n;
+}
@@ -0,0 +1,448 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 14:05:12
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 14:05:12
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_conn_supervisor\src\conn_supervisor.c
+ * @Description: 联网监督实现
+ *
+ * 每条链路按 链路 / 关联 / IP 三层记录在线状态，MQTT 单独一层。输入事件在临界区内更新状态和恢复时间线，
+ * 派生事件与监听回调在临界区外按 原始事件 → NET_UP / NET_DOWN → RECOVERED 的顺序发出。
+ *
+ * Copyright (c) 2026 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_event.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+
+#include "conn_supervisor.h"
+#include "conn_supervisor_priv.h"
+
+static const char *TAG = "conn_supervisor";
+
+/* 链路内的分层，RNDIS 没有关联过程，链路建立即视为关联 */
+enum {
+    LAYER_LINK = 0,
+    LAYER_ASSOC,
+    LAYER_IP,
+    LAYER_COUNT,
+    LAYER_MQTT = LAYER_COUNT,
+};
+
+typedef struct {
+    uint8_t link;       ///< conn_link_t，MQTT 事件为 CONN_LINK_MAX
+    uint8_t layer;      ///< 事件所在层
+    bool    up;         ///< 上线 / 掉线
+} conn_event_map_t;
+
+static const conn_event_map_t s_event_map[] = {
+    [CONN_EVENT_WIFI_START]      = { CONN_LINK_WIFI,  LAYER_LINK,  true  },
+    [CONN_EVENT_WIFI_STOP]       = { CONN_LINK_WIFI,  LAYER_LINK,  false },
+    [CONN_EVENT_WIFI_ASSOC]      = { CONN_LINK_WIFI,  LAYER_ASSOC, true  },
+    [CONN_EVENT_WIFI_DISASSOC]   = { CONN_LINK_WIFI,  LAYER_ASSOC, false },
+    [CONN_EVENT_WIFI_GOT_IP]     = { CONN_LINK_WIFI,  LAYER_IP,    true  },
+    [CONN_EVENT_WIFI_LOST_IP]    = { CONN_LINK_WIFI,  LAYER_IP,    false },
+    [CONN_EVENT_RNDIS_UP]        = { CONN_LINK_RNDIS, LAYER_ASSOC, true  },
+    [CONN_EVENT_RNDIS_DOWN]      = { CONN_LINK_RNDIS, LAYER_LINK,  false },
+    [CONN_EVENT_RNDIS_GOT_IP]    = { CONN_LINK_RNDIS, LAYER_IP,    true  },
+    [CONN_EVENT_RNDIS_LOST_IP]   = { CONN_LINK_RNDIS, LAYER_IP,    false },
+    [CONN_EVENT_MQTT_UP]         = { CONN_LINK_MAX,   LAYER_MQTT,  true  },
+    [CONN_EVENT_MQTT_DOWN]       = { CONN_LINK_MAX,   LAYER_MQTT,  false },
+};
+
+static const char *const s_event_names[CONN_EVENT_MAX] = {
+    "wifi_start", "wifi_stop", "wifi_assoc", "wifi_disassoc", "wifi_got_ip", "wifi_lost_ip",
+    "rndis_up", "rndis_down", "rndis_got_ip", "rndis_lost_ip",
+    "mqtt_up", "mqtt_down", "net_up", "net_down", "recovered",
+};
+
+static const char *const s_cause_names[] = { "boot", "link", "assoc", "ip", "mqtt" };
+static const char *const s_link_names[]  = { "wifi", "rndis" };
+
+typedef struct {
+    conn_supervisor_cb_t cb;
+    void                *ctx;
+} conn_listener_t;
+
+static struct {
+    portMUX_TYPE    lock;
+    bool            inited;
+    bool            up[CONN_LINK_MAX][LAYER_COUNT];   ///< 各链路各层是否在线
+    bool            mqtt_up;
+
+    /* 当前恢复 */
+    bool            recovering;
+    conn_cause_t    cause;
+    conn_link_t     rec_link;       ///< 最近拿到 IP 的链路
+    int64_t         t_down;         ///< 断开时刻（us）
+    int64_t         t_stage[LAYER_COUNT]; ///< 各层恢复时刻，0 表示尚未恢复
+    uint16_t        retries;
+    uint16_t        flaps;
+    uint32_t        backoff_ms;
+
+    /* 统计 */
+    uint32_t        recoveries;
+    uint64_t        total_ms_sum;
+    uint32_t        total_ms_max;
+    conn_recovery_t last;
+
+    conn_listener_t listeners[CONN_SUPERVISOR_MAX_LISTENERS];
+    uint8_t         listener_count;
+} s_sup = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+/* ---------------- 状态与时间线（调用方持锁） ---------------- */
+
+static bool conn_layer_any_up(int layer)
+{
+    for (int l = 0; l < CONN_LINK_MAX; l++) {
+        if (s_sup.up[l][layer]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void conn_recovery_begin(conn_cause_t cause, int64_t now)
+{
+    s_sup.recovering = true;
+    s_sup.cause      = cause;
+    s_sup.t_down     = now;
+    s_sup.retries    = 0;
+    s_sup.flaps      = 0;
+    s_sup.backoff_ms = 0;
+
+    /* 断开时仍在线的层，其恢复时刻即断开时刻 */
+    for (int layer = 0; layer < LAYER_COUNT; layer++) {
+        s_sup.t_stage[layer] = conn_layer_any_up(layer) ? now : 0;
+    }
+}
+
+static uint32_t conn_span_ms(int64_t from, int64_t to)
+{
+    return to > from ? (uint32_t)((to - from) / 1000) : 0;
+}
+
+static void conn_recovery_finish(int64_t now)
+{
+    /* 缺失的阶段（例如断开期间事件丢失）按下一阶段时刻补齐，保证各段之和等于总耗时 */
+    int64_t t_ip    = s_sup.t_stage[LAYER_IP]    ? s_sup.t_stage[LAYER_IP]    : now;
+    int64_t t_assoc = s_sup.t_stage[LAYER_ASSOC] ? s_sup.t_stage[LAYER_ASSOC] : t_ip;
+    int64_t t_link  = s_sup.t_stage[LAYER_LINK]  ? s_sup.t_stage[LAYER_LINK]  : t_assoc;
+
+    if (t_link < s_sup.t_down) {
+        t_link = s_sup.t_down;
+    }
+    if (t_assoc < t_link) {
+        t_assoc = t_link;
+    }
+    if (t_ip < t_assoc) {
+        t_ip = t_assoc;
+    }
+
+    conn_recovery_t *rec = &s_sup.last;
+    rec->seq        = s_sup.recoveries + 1;
+    rec->cause      = s_sup.cause;
+    rec->link       = s_sup.rec_link;
+    rec->link_ms    = conn_span_ms(s_sup.t_down, t_link);
+    rec->assoc_ms   = conn_span_ms(t_link, t_assoc);
+    rec->ip_ms      = conn_span_ms(t_assoc, t_ip);
+    rec->mqtt_ms    = conn_span_ms(t_ip, now);
+    rec->total_ms   = rec->link_ms + rec->assoc_ms + rec->ip_ms + rec->mqtt_ms;
+    rec->retries    = s_sup.retries;
+    rec->flaps      = s_sup.flaps;
+    rec->backoff_ms = s_sup.backoff_ms;
+
+    s_sup.recoveries++;
+    s_sup.total_ms_sum += rec->total_ms;
+    if (rec->total_ms > s_sup.total_ms_max) {
+        s_sup.total_ms_max = rec->total_ms;
+    }
+    s_sup.recovering = false;
+}
+
+/**
+ * @brief 处理一个输入事件
+ * @return 是否结算了一次恢复
+ */
+static bool conn_apply_event(const conn_event_map_t *m, int64_t now)
+{
+    if (m->layer == LAYER_MQTT) {
+        if (m->up) {
+            if (s_sup.mqtt_up) {
+                return false;
+            }
+            s_sup.mqtt_up = true;
+            if (s_sup.recovering) {
+                conn_recovery_finish(now);
+                return true;
+            }
+        } else if (s_sup.mqtt_up) {
+            s_sup.mqtt_up = false;
+            if (!s_sup.recovering) {
+                conn_recovery_begin(CONN_CAUSE_MQTT, now);
+            }
+        }
+        return false;
+    }
+
+    bool *up = s_sup.up[m->link];
+
+    if (m->up) {
+        /* 上层上线意味着下层也在线（例如漏掉了 STA_START 时直接收到关联事件） */
+        for (int layer = 0; layer <= m->layer; layer++) {
+            up[layer] = true;
+            if (s_sup.recovering && s_sup.t_stage[layer] == 0) {
+                s_sup.t_stage[layer] = now;
+            }
+        }
+        if (m->layer == LAYER_IP) {
+            s_sup.rec_link = (conn_link_t)m->link;
+            if (s_sup.recovering && s_sup.mqtt_up) {
+                /* 短暂掉线期间 MQTT 会话没断（尚未报 MQTT_DOWN），IP 恢复即恢复 */
+                conn_recovery_finish(now);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if (!up[m->layer]) {
+        return false;   /* 已经是掉线状态（如连接尝试失败），不影响时间线 */
+    }
+    for (int layer = m->layer; layer < LAYER_COUNT; layer++) {
+        up[layer] = false;
+    }
+
+    if (s_sup.recovering) {
+        /* 恢复途中下层再次掉线：清掉已不在线的阶段，从头计 */
+        s_sup.flaps++;
+        for (int layer = m->layer; layer < LAYER_COUNT; layer++) {
+            if (!conn_layer_any_up(layer)) {
+                s_sup.t_stage[layer] = 0;
+            }
+        }
+    } else if (!conn_layer_any_up(LAYER_IP)) {
+        /* 另一条链路仍有 IP 时不算断网，MQTT 若随之断开会由 MQTT_DOWN 开始恢复 */
+        static const conn_cause_t causes[LAYER_COUNT] = { CONN_CAUSE_LINK, CONN_CAUSE_ASSOC, CONN_CAUSE_IP };
+        conn_recovery_begin(causes[m->layer], now);
+    }
+    return false;
+}
+
+static void conn_dispatch(conn_event_t event, const conn_listener_t *listeners, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        listeners[i].cb(event, listeners[i].ctx);
+    }
+}
+
+/* ---------------- 对外接口 ---------------- */
+
+esp_err_t conn_supervisor_notify(conn_event_t event)
+{
+    if ((unsigned)event >= sizeof(s_event_map) / sizeof(s_event_map[0])) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_sup.inited) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const conn_event_map_t *m   = &s_event_map[event];
+    int64_t                 now = esp_timer_get_time();
+    conn_listener_t         listeners[CONN_SUPERVISOR_MAX_LISTENERS];
+
+    portENTER_CRITICAL(&s_sup.lock);
+    bool    net_before = conn_layer_any_up(LAYER_IP);
+    bool    recovered  = conn_apply_event(m, now);
+    bool    net_after  = conn_layer_any_up(LAYER_IP);
+    uint8_t count      = s_sup.listener_count;
+    memcpy(listeners, s_sup.listeners, count * sizeof(listeners[0]));
+    conn_recovery_t rec = s_sup.last;
+    portEXIT_CRITICAL(&s_sup.lock);
+
+    ESP_LOGD(TAG, "event %s", s_event_names[event]);
+    conn_dispatch(event, listeners, count);
+
+    if (!net_before && net_after) {
+        conn_dispatch(CONN_EVENT_NET_UP, listeners, count);
+    } else if (net_before && !net_after) {
+        ESP_LOGW(TAG, "📴 网络断开（%s）", s_event_names[event]);
+        conn_dispatch(CONN_EVENT_NET_DOWN, listeners, count);
+    }
+
+    if (recovered) {
+        ESP_LOGI(TAG, "📶 恢复 #%u（%s/%s）: 链路 %u + 关联 %u + IP %u + MQTT %u = %u ms，重试 %u 次，退避 %u ms，反复掉线 %u 次",
+                 (unsigned)rec.seq, s_cause_names[rec.cause], s_link_names[rec.link],
+                 (unsigned)rec.link_ms, (unsigned)rec.assoc_ms, (unsigned)rec.ip_ms, (unsigned)rec.mqtt_ms,
+                 (unsigned)rec.total_ms, (unsigned)rec.retries, (unsigned)rec.backoff_ms, (unsigned)rec.flaps);
+        conn_dispatch(CONN_EVENT_RECOVERED, listeners, count);
+    }
+    return ESP_OK;
+}
+
+void conn_supervisor_on_backoff(uint32_t delay_ms)
+{
+    portENTER_CRITICAL(&s_sup.lock);
+    if (s_sup.recovering) {
+        if (s_sup.retries < UINT16_MAX) {
+            s_sup.retries++;
+        }
+        s_sup.backoff_ms += delay_ms;
+    }
+    portEXIT_CRITICAL(&s_sup.lock);
+}
+
+static void conn_supervisor_event_handler(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    (void)arg;
+    (void)data;
+
+    if (base == WIFI_EVENT) {
+        switch (id) {
+        case WIFI_EVENT_STA_START:
+            (void)conn_supervisor_notify(CONN_EVENT_WIFI_START);
+            break;
+        case WIFI_EVENT_STA_STOP:
+            (void)conn_supervisor_notify(CONN_EVENT_WIFI_STOP);
+            break;
+        case WIFI_EVENT_STA_CONNECTED:
+            (void)conn_supervisor_notify(CONN_EVENT_WIFI_ASSOC);
+            break;
+        case WIFI_EVENT_STA_DISCONNECTED:
+            (void)conn_supervisor_notify(CONN_EVENT_WIFI_DISASSOC);
+            break;
+        default:
+            break;
+        }
+    } else if (base == IP_EVENT) {
+        switch (id) {
+        case IP_EVENT_STA_GOT_IP:
+            (void)conn_supervisor_notify(CONN_EVENT_WIFI_GOT_IP);
+            break;
+        case IP_EVENT_STA_LOST_IP:
+            (void)conn_supervisor_notify(CONN_EVENT_WIFI_LOST_IP);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+esp_err_t conn_supervisor_init(void)
+{
+    portENTER_CRITICAL(&s_sup.lock);
+    if (s_sup.inited) {
+        portEXIT_CRITICAL(&s_sup.lock);
+        return ESP_OK;
+    }
+    s_sup.inited = true;
+    conn_recovery_begin(CONN_CAUSE_BOOT, esp_timer_get_time());
+    portEXIT_CRITICAL(&s_sup.lock);
+
+    esp_err_t ret = esp_event_loop_create_default();
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "event loop create failed: %s", esp_err_to_name(ret));
+        goto fail;
+    }
+
+    ret = esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, conn_supervisor_event_handler, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "esp_event_handler_register(WIFI_EVENT) failed: %s", esp_err_to_name(ret));
+        goto fail;
+    }
+
+    ret = esp_event_handler_register(IP_EVENT, ESP_EVENT_ANY_ID, conn_supervisor_event_handler, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "esp_event_handler_register(IP_EVENT) failed: %s", esp_err_to_name(ret));
+        (void)esp_event_handler_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, conn_supervisor_event_handler);
+        goto fail;
+    }
+
+    ESP_LOGI(TAG, "✅ 联网监督已启动");
+    return ESP_OK;
+
+fail:
+    portENTER_CRITICAL(&s_sup.lock);
+    s_sup.inited = false;
+    portEXIT_CRITICAL(&s_sup.lock);
+    return ret;
+}
+
+esp_err_t conn_supervisor_add_listener(conn_supervisor_cb_t cb, void *ctx)
+{
+    if (cb == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    portENTER_CRITICAL(&s_sup.lock);
+    for (uint8_t i = 0; i < s_sup.listener_count; i++) {
+        if (s_sup.listeners[i].cb == cb && s_sup.listeners[i].ctx == ctx) {
+            portEXIT_CRITICAL(&s_sup.lock);
+            return ESP_OK;
+        }
+    }
+    if (s_sup.listener_count < CONN_SUPERVISOR_MAX_LISTENERS) {
+        s_sup.listeners[s_sup.listener_count].cb  = cb;
+        s_sup.listeners[s_sup.listener_count].ctx = ctx;
+        s_sup.listener_count++;
+    } else {
+        ret = ESP_ERR_NO_MEM;
+    }
+    portEXIT_CRITICAL(&s_sup.lock);
+    return ret;
+}
+
+bool conn_supervisor_net_up(void)
+{
+    portENTER_CRITICAL(&s_sup.lock);
+    bool up = conn_layer_any_up(LAYER_IP);
+    portEXIT_CRITICAL(&s_sup.lock);
+    return up;
+}
+
+esp_err_t conn_supervisor_get_stats(conn_supervisor_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_sup.lock);
+    stats->recoveries   = s_sup.recoveries;
+    stats->total_ms_avg = s_sup.recoveries ? (uint32_t)(s_sup.total_ms_sum / s_sup.recoveries) : 0;
+    stats->total_ms_max = s_sup.total_ms_max;
+    stats->net_up       = conn_layer_any_up(LAYER_IP);
+    stats->mqtt_up      = s_sup.mqtt_up;
+    stats->recovering   = s_sup.recovering;
+    stats->last         = s_sup.last;
+    portEXIT_CRITICAL(&s_sup.lock);
+    return ESP_OK;
+}
+
+int conn_supervisor_recovery_to_json(const conn_recovery_t *rec, char *buf, size_t len)
+{
+    if (rec == NULL || buf == NULL || len == 0) {
+        return -1;
+    }
+    return snprintf(buf, len,
+                    "{\"seq\":%u,\"cause\":\"%s\",\"link\":\"%s\",\"link_ms\":%u,\"assoc_ms\":%u,"
+                    "\"ip_ms\":%u,\"mqtt_ms\":%u,\"total_ms\":%u,\"retries\":%u,\"backoff_ms\":%u,\"flaps\":%u}",
+                    (unsigned)rec->seq, s_cause_names[rec->cause], s_link_names[rec->link],
+                    (unsigned)rec->link_ms, (unsigned)rec->assoc_ms, (unsigned)rec->ip_ms,
+                    (unsigned)rec->mqtt_ms, (unsigned)rec->total_ms, (unsigned)rec->retries,
+                    (unsigned)rec->backoff_ms, (unsigned)rec->flaps);
+}
+
+const char *conn_supervisor_event_name(conn_event_t event)
+{
+    return ((unsigned)event < CONN_EVENT_MAX) ? s_event_names[event] : "unknown";
+}
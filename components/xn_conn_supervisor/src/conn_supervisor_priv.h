@@ -0,0 +1,22 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 14:05:12
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 14:05:12
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_conn_supervisor\src\conn_supervisor_priv.h
+ * @Description: 组件内部接口
+ *
+ * Copyright (c) 2026 by ${git_name_email}, All Rights Reserved.
+ */
+
+#ifndef CONN_SUPERVISOR_PRIV_H
+#define CONN_SUPERVISOR_PRIV_H
+
+#include <stdint.h>
+
+/**
+ * @brief 退避器启动一次等待时调用，计入当前恢复的 retries / backoff_ms
+ */
+void conn_supervisor_on_backoff(uint32_t delay_ms);
+
+#endif /* CONN_SUPERVISOR_PRIV_H */
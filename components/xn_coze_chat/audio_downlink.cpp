@@ -40,6 +40,7 @@ typedef struct audio_downlink_s {
     uint32_t total_packets;
     uint32_t error_count;
     uint32_t buffer_full_count;  // 缓冲区满次数
+    uint32_t decode_error_count; // Opus 解码失败次数
     
 } audio_downlink_t;
 
@@ -93,6 +94,9 @@ static void opus_decode_task(void *arg)
                 }
             } else {
                 downlink->error_count++;
+                if (ret != ESP_OK) {
+                    downlink->decode_error_count++;
+                }
             }
         }
     }
@@ -305,3 +309,16 @@ void audio_downlink_reset_stats(audio_downlink_handle_t handle)
     ESP_LOGI(TAG, "统计信息已重置");
 }
 
+void audio_downlink_get_health(audio_downlink_handle_t handle,
+                               uint32_t *decode_errors,
+                               uint32_t *dropped_packets)
+{
+    if (!handle) return;
+
+    if (decode_errors) {
+        *decode_errors = handle->decode_error_count;
+    }
+    if (dropped_packets) {
+        *dropped_packets = handle->buffer_full_count;
+    }
+}
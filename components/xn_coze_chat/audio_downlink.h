@@ -94,6 +94,17 @@ void audio_downlink_get_stats(audio_downlink_handle_t handle,
  */
 void audio_downlink_reset_stats(audio_downlink_handle_t handle);
 
+/**
+ * @brief 获取音频健康统计（不受 reset_stats 影响）
+ * 
+ * @param handle 模块句柄
+ * @param decode_errors 输出：Opus 解码失败次数
+ * @param dropped_packets 输出：缓冲区满丢弃的包数
+ */
+void audio_downlink_get_health(audio_downlink_handle_t handle,
+                               uint32_t *decode_errors,
+                               uint32_t *dropped_packets);
+
 #ifdef __cplusplus
 }
 #endif
@@ -304,3 +304,8 @@ void audio_uplink_clear(audio_uplink_handle_t handle)
     ESP_LOGI(TAG, "音频缓冲区已清空");
 }
 
+uint32_t audio_uplink_get_overwrite_bytes(audio_uplink_handle_t handle)
+{
+    if (!handle) return 0;
+    return simple_ring_buffer_get_overwrite_bytes(handle->rb);
+}
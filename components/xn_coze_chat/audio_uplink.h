@@ -109,6 +109,14 @@ esp_err_t audio_uplink_write(audio_uplink_handle_t handle,
  */
 void audio_uplink_clear(audio_uplink_handle_t handle);
 
+/**
+ * @brief 获取上行缓冲区累计被覆盖的字节数
+ * 
+ * @param handle 模块句柄
+ * @return uint32_t 被覆盖字节数（编码/发送跟不上采集时增长）
+ */
+uint32_t audio_uplink_get_overwrite_bytes(audio_uplink_handle_t handle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,6 +16,7 @@
 #include "base64_codec.h"
 #include "audio_uplink.h"
 #include "audio_downlink.h"
+#include "coze_tool_bridge.h"
 #include "simple_ring_buffer.h"
 #include "esp_log.h"
 #include "esp_check.h"
@@ -51,6 +52,9 @@ struct coze_chat_t {
     // 音频下行模块（负责解码和回调）
     audio_downlink_handle_t audio_downlink;
     
+    // 工具调用桥接模块（requires_action -> 本地工具 -> submit_tool_outputs）
+    coze_tool_bridge_handle_t tool_bridge;
+    
     // JSON解析任务句柄
     TaskHandle_t parser_task;
     // JSON解析任务运行标志
@@ -114,6 +118,17 @@ static void handle_coze_message(coze_chat_handle_t handle, const std::string &me
         ESP_LOGI(TAG, "📩 事件类型: %s", event_type.c_str());
     }
     
+    // 提交工具输出后服务端恢复输出，结束一次工具往返计时
+    if (event_type == "conversation.audio.delta" ||
+        event_type == "conversation.message.delta" ||
+        event_type == "conversation.message.completed" ||
+        event_type == "conversation.chat.completed" ||
+        event_type == "conversation.chat.failed" ||
+        event_type == "conversation.chat.canceled" ||
+        event_type == "error") {
+        coze_tool_bridge_on_server_event(handle->tool_bridge);
+    }
+    
     // 处理不同类型的事件
     if (event_type == "chat.created") {
         // 对话连接成功
@@ -187,17 +202,18 @@ static void handle_coze_message(coze_chat_handle_t handle, const std::string &me
         cJSON *data_item = cJSON_GetObjectItem(root, "data");
         if (data_item) {
             cJSON *delta = cJSON_GetObjectItem(data_item, "delta");
-            if (delta && cJSON_IsString(delta)) {
-                // 打印文本内容（不换行，模拟流式输出效果）
-                printf("%s", delta->valuestring);
-                fflush(stdout);
+            if (delta && cJSON_IsString(delta) && handle->config.enable_subtitle && handle->event_callback) {
+                // 片段交给应用层（字幕无锁入队，不阻塞解析）
+                handle->event_callback(COZE_CHAT_EVENT_CHAT_MESSAGE_DELTA, delta->valuestring, NULL);
             }
         }
     }
     else if (event_type == "conversation.message.completed") {
-        // 消息完成 - 换行结束流式输出
-        printf("\n");
+        // 消息完成 - 结束本条流式文本
         ESP_LOGI(TAG, "✅ 消息完成");
+        if (handle->config.enable_subtitle && handle->event_callback) {
+            handle->event_callback(COZE_CHAT_EVENT_CHAT_MESSAGE_COMPLETED, NULL, NULL);
+        }
     }
     else if (event_type == "conversation.audio.completed") {
         // 语音回复完成
@@ -210,6 +226,13 @@ static void handle_coze_message(coze_chat_handle_t handle, const std::string &me
             handle->event_callback(COZE_CHAT_EVENT_CHAT_COMPLETED, NULL, NULL);
         }
     }
+    else if (event_type == "conversation.chat.requires_action") {
+        // 智能体调用端插件：交给工具桥接模块（拷贝后入队，不阻塞解析）
+        cJSON *data_item = cJSON_GetObjectItem(root, "data");
+        if (data_item) {
+            coze_tool_bridge_on_requires_action(handle->tool_bridge, data_item);
+        }
+    }
     else if (event_type == "conversation.chat.failed") {
         // 对话失败
         ESP_LOGE(TAG, "❌ 对话失败");
@@ -778,6 +801,7 @@ extern "C" esp_err_t coze_chat_init(const coze_chat_config_t *config, coze_chat_
     h->parser_task = NULL;
     h->parser_running = false;
     h->audio_uplink = NULL;
+    h->tool_bridge = NULL;
     h->ws_ring_buffer = NULL;
     
     // ========== 1. 创建音频模块 ==========
@@ -823,6 +847,22 @@ extern "C" esp_err_t coze_chat_init(const coze_chat_config_t *config, coze_chat_
         return ESP_ERR_NO_MEM;
     }
     
+    // 创建工具调用桥接模块（工具在 init 之后注册，任务随 start 启动）
+    coze_tool_bridge_config_t tool_cfg = {
+        .send_callback = websocket_send_callback,
+        .send_callback_ctx = h,
+        .event_callback = config->event_callback,
+    };
+    
+    h->tool_bridge = coze_tool_bridge_create(&tool_cfg);
+    if (!h->tool_bridge) {
+        ESP_LOGE(TAG, "创建工具桥接模块失败");
+        audio_downlink_destroy(h->audio_downlink);
+        audio_uplink_destroy(h->audio_uplink);
+        delete h;
+        return ESP_ERR_NO_MEM;
+    }
+    
     // 统一网络架构：4G通过USB RNDIS虚拟网卡，与WiFi使用相同的网络栈
     ESP_LOGI(TAG, "✅ 网络初始化成功（统一使用标准TCP/IP栈）");
     
@@ -1040,6 +1080,14 @@ extern "C" esp_err_t coze_chat_start(coze_chat_handle_t handle)
         return ret;
     }
     
+    // ========== 步骤6：启动工具调用桥接任务 ==========
+    
+    ret = coze_tool_bridge_start(handle->tool_bridge);
+    if (ret != ESP_OK) {
+        // 不影响语音对话，只是端插件调用会失败
+        ESP_LOGW(TAG, "⚠️ 启动工具桥接任务失败: %s", esp_err_to_name(ret));
+    }
+    
     ESP_LOGI(TAG, "✅ WebSocket连接已启动");
     return ESP_OK;
 }
@@ -1061,6 +1109,11 @@ extern "C" esp_err_t coze_chat_stop(coze_chat_handle_t handle)
         audio_uplink_stop(handle->audio_uplink);
     }
     
+    // 停止工具桥接任务（在关闭WebSocket之前，避免分发任务发送时连接被销毁）
+    if (handle->tool_bridge) {
+        coze_tool_bridge_stop(handle->tool_bridge);
+    }
+    
     // 停止JSON解析任务
     if (handle->parser_task) {
         handle->parser_running = false;
@@ -1121,6 +1174,12 @@ extern "C" esp_err_t coze_chat_deinit(coze_chat_handle_t handle)
         handle->audio_downlink = NULL;
     }
     
+    // 销毁工具桥接模块
+    if (handle->tool_bridge) {
+        coze_tool_bridge_destroy(handle->tool_bridge);
+        handle->tool_bridge = NULL;
+    }
+    
     // 注意：USB RNDIS统一网络架构下，不再需要modem对象
     
     // 释放句柄
@@ -1153,6 +1212,64 @@ extern "C" esp_err_t coze_chat_send_audio_data(coze_chat_handle_t handle, char *
     return audio_uplink_write(handle->audio_uplink, (const uint8_t *)audio_data, len);
 }
 
+/**
+ * @brief 获取音频链路健康统计
+ * 
+ * @param handle Coze聊天句柄
+ * @param stats 输出统计
+ * @return ESP_OK成功，其他值表示失败
+ */
+extern "C" esp_err_t coze_chat_get_audio_stats(coze_chat_handle_t handle, coze_chat_audio_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(handle != NULL, ESP_ERR_INVALID_ARG, TAG, "handle is NULL");
+    ESP_RETURN_ON_FALSE(stats != NULL, ESP_ERR_INVALID_ARG, TAG, "stats is NULL");
+
+    memset(stats, 0, sizeof(*stats));
+    if (handle->audio_downlink) {
+        audio_downlink_get_health(handle->audio_downlink,
+                                  &stats->opus_decode_errors,
+                                  &stats->downlink_dropped_packets);
+    }
+    if (handle->audio_uplink) {
+        stats->uplink_overwrite_bytes = audio_uplink_get_overwrite_bytes(handle->audio_uplink);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 注册本地工具（端插件）
+ * 
+ * @param handle Coze聊天句柄
+ * @param tool 工具描述
+ * @return ESP_OK成功，其他值表示失败
+ */
+extern "C" esp_err_t coze_chat_register_tool(coze_chat_handle_t handle, const coze_tool_t *tool)
+{
+    ESP_RETURN_ON_FALSE(handle != NULL, ESP_ERR_INVALID_ARG, TAG, "handle is NULL");
+    ESP_RETURN_ON_FALSE(handle->tool_bridge != NULL, ESP_ERR_INVALID_STATE, TAG, "工具桥接模块未初始化");
+    
+    return coze_tool_bridge_register(handle->tool_bridge, tool);
+}
+
+/**
+ * @brief 获取工具调用统计
+ * 
+ * @param handle Coze聊天句柄
+ * @param stats 输出统计
+ * @return ESP_OK成功，其他值表示失败
+ */
+extern "C" esp_err_t coze_chat_get_tool_stats(coze_chat_handle_t handle, coze_tool_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(handle != NULL, ESP_ERR_INVALID_ARG, TAG, "handle is NULL");
+    ESP_RETURN_ON_FALSE(stats != NULL, ESP_ERR_INVALID_ARG, TAG, "stats is NULL");
+    
+    if (!handle->tool_bridge) {
+        memset(stats, 0, sizeof(*stats));
+        return ESP_OK;
+    }
+    return coze_tool_bridge_get_stats(handle->tool_bridge, stats);
+}
+
 /**
  * @brief 发送音频完成信号
  * 
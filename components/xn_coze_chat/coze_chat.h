@@ -16,6 +16,7 @@
 #pragma once
 
 #include "esp_err.h"
+#include "coze_tool.h"
 #include <stdbool.h>
 
 #ifdef __cplusplus
@@ -126,6 +127,9 @@ typedef enum {
     COZE_CHAT_EVENT_INPUT_AUDIO_BUFFER_COMPLETED,     ///< 音频缓冲区处理完成：上行音频缓冲区处理完成
     COZE_CHAT_EVENT_CHAT_SUBTITLE_EVENT,              ///< 字幕事件：收到字幕数据，data字段包含字幕内容
     COZE_CHAT_EVENT_CHAT_CUSTOMER_DATA,               ///< 自定义数据：收到自定义数据，data字段包含数据内容
+    COZE_CHAT_EVENT_CHAT_MESSAGE_DELTA,               ///< 文本增量：收到回复文本片段，data字段为UTF-8片段（需启用字幕）
+    COZE_CHAT_EVENT_CHAT_MESSAGE_COMPLETED,           ///< 文本完成：一条回复消息的文本已全部下发
+    COZE_CHAT_EVENT_TOOL_ROUND_TRIP,                  ///< 工具调用往返：本地工具输出已提交且服务端已恢复，data为JSON耗时摘要
 } coze_chat_event_t;
 
 /**
@@ -627,6 +631,55 @@ esp_err_t coze_chat_send_audio_complete(coze_chat_handle_t handle);
  */
 esp_err_t coze_chat_send_audio_cancel(coze_chat_handle_t handle);
 
+/**
+ * @brief 音频链路健康统计（随句柄创建清零）
+ */
+typedef struct {
+    uint32_t opus_decode_errors;        ///< Opus 解码失败次数
+    uint32_t downlink_dropped_packets;  ///< 下行 Opus 缓冲区满丢弃的包数
+    uint32_t uplink_overwrite_bytes;    ///< 上行缓冲区被覆盖的字节数
+} coze_chat_audio_stats_t;
+
+/**
+ * @brief 获取音频链路健康统计
+ *
+ * @param handle Coze聊天句柄
+ * @param stats 输出统计
+ * @return esp_err_t
+ *         - ESP_OK: 成功
+ *         - ESP_ERR_INVALID_ARG: 参数无效
+ */
+esp_err_t coze_chat_get_audio_stats(coze_chat_handle_t handle, coze_chat_audio_stats_t *stats);
+
+/**
+ * @brief 注册本地工具（端插件）
+ *
+ * @details 智能体发起 conversation.chat.requires_action 时，按 function.name 找到工具，
+ *          按参数规格校验 arguments 后在独立任务中调用处理函数，超过 deadline_ms 直接回错误，
+ *          所有调用完成后通过 conversation.chat.submit_tool_outputs 回传。
+ *          须在 coze_chat_init 之后调用，建议在 coze_chat_start 之前全部注册。
+ *
+ * @param handle Coze聊天句柄
+ * @param tool 工具描述（结构体会被拷贝，指针成员须长期有效）
+ * @return esp_err_t
+ *         - ESP_OK: 成功
+ *         - ESP_ERR_INVALID_ARG: 参数无效
+ *         - ESP_ERR_INVALID_STATE: 同名工具已注册
+ *         - ESP_ERR_NO_MEM: 超过 COZE_TOOL_MAX
+ */
+esp_err_t coze_chat_register_tool(coze_chat_handle_t handle, const coze_tool_t *tool);
+
+/**
+ * @brief 获取工具调用统计（次数、超时、本地耗时和服务端恢复耗时）
+ *
+ * @param handle Coze聊天句柄
+ * @param stats 输出统计
+ * @return esp_err_t
+ *         - ESP_OK: 成功
+ *         - ESP_ERR_INVALID_ARG: 参数无效
+ */
+esp_err_t coze_chat_get_tool_stats(coze_chat_handle_t handle, coze_tool_stats_t *stats);
+
 /**
  * @brief 获取ML307 modem句柄（用于OTA等其他功能）
  *
@@ -0,0 +1,136 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 10:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 10:12:40
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_coze_chat\coze_tool.h
+ * @Description: Coze 本地工具（端插件）类型定义 - 工具描述、参数规格、解析后的参数与统计
+ *
+ * Copyright (c) 2026 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COZE_TOOL_MAX                   8       ///< 最多注册的本地工具数
+#define COZE_TOOL_MAX_PARAMS            8       ///< 单个工具最多参数个数
+#define COZE_TOOL_MAX_CALLS             4       ///< 单次 requires_action 最多处理的调用数（多余的直接回错误）
+#define COZE_TOOL_OUTPUT_MAX            512     ///< 单个调用输出（回传给智能体）最大长度，含结尾 '\0'
+#define COZE_TOOL_STR_MAX               64      ///< 字符串参数最大长度，含结尾 '\0'
+#define COZE_TOOL_DEFAULT_DEADLINE_MS   3000    ///< 未指定 deadline_ms 时的单次调用时限
+
+/**
+ * @brief 参数类型（JSON Schema 子集）
+ */
+typedef enum {
+    COZE_TOOL_PARAM_STRING = 0,     ///< 字符串，可用 enum_values 限定取值
+    COZE_TOOL_PARAM_INT,            ///< 整数（也接受 "30" 这类数字字符串）
+    COZE_TOOL_PARAM_NUMBER,         ///< 浮点数（也接受数字字符串）
+    COZE_TOOL_PARAM_BOOL,           ///< 布尔（也接受 "true"/"false"/0/1）
+} coze_tool_param_type_t;
+
+/**
+ * @brief 参数规格
+ *
+ * min < max 时对 INT / NUMBER 做范围检查，min == max（默认全 0）表示不限范围。
+ */
+typedef struct {
+    const char *name;                   ///< 参数名（与 Coze 端插件中定义的一致）
+    coze_tool_param_type_t type;        ///< 参数类型
+    bool required;                      ///< 是否必填
+    double min;                         ///< 取值下限（含）
+    double max;                         ///< 取值上限（含）
+    const char *const *enum_values;     ///< STRING 可选值列表，NULL 表示不限
+    int enum_count;                     ///< 可选值个数
+} coze_tool_param_t;
+
+/**
+ * @brief 解析后的单个参数
+ */
+typedef struct {
+    const char *name;                   ///< 指向参数规格中的名字
+    coze_tool_param_type_t type;
+    bool present;                       ///< 调用中是否给出该参数
+    union {
+        int32_t i;
+        double d;
+        bool b;
+    } v;
+    char s[COZE_TOOL_STR_MAX];          ///< STRING 类型的值
+} coze_tool_arg_t;
+
+/**
+ * @brief 解析后的参数表（按参数规格顺序排列）
+ */
+typedef struct {
+    int count;
+    coze_tool_arg_t items[COZE_TOOL_MAX_PARAMS];
+} coze_tool_args_t;
+
+/**
+ * @brief 工具处理函数
+ *
+ * 在桥接模块的执行任务中调用（内部 RAM 栈，可访问 Flash / WiFi 驱动），
+ * 参数已按规格校验过。out 中写入回传给智能体的文本（建议 JSON），
+ * 返回非 ESP_OK 且 out 为空时，桥接模块自动回传 {"error":"<错误名>"}。
+ *
+ * @param args    解析后的参数
+ * @param out     输出缓冲区（已清零）
+ * @param out_len 输出缓冲区大小（COZE_TOOL_OUTPUT_MAX）
+ * @param ctx     注册时的用户上下文
+ */
+typedef esp_err_t (*coze_tool_handler_t)(const coze_tool_args_t *args, char *out, size_t out_len, void *ctx);
+
+/**
+ * @brief 工具描述
+ *
+ * 名字和参数须与 Coze 平台上为智能体配置的端插件（本地插件）一致，
+ * name / params 等指针须在整个运行期有效（通常为静态常量）。
+ */
+typedef struct {
+    const char *name;                   ///< 工具名（function.name）
+    const char *description;            ///< 说明（仅用于日志）
+    const coze_tool_param_t *params;    ///< 参数规格
+    int param_count;                    ///< 参数个数（<= COZE_TOOL_MAX_PARAMS）
+    coze_tool_handler_t handler;        ///< 处理函数
+    void *ctx;                          ///< 处理函数上下文
+    uint32_t deadline_ms;               ///< 单次调用时限，0 表示 COZE_TOOL_DEFAULT_DEADLINE_MS
+} coze_tool_t;
+
+/**
+ * @brief 工具调用统计（随句柄创建清零）
+ *
+ * local：收到 requires_action -> 发出 submit_tool_outputs（解析 + 执行 + 组包）
+ * resume：发出 submit_tool_outputs -> 服务端恢复输出（首个文本 / 音频 / 对话结束事件）
+ */
+typedef struct {
+    uint32_t actions;                   ///< 处理的 requires_action 次数
+    uint32_t calls;                     ///< 处理的工具调用数
+    uint32_t errors;                    ///< 参数错误 / 未知工具 / 处理函数失败次数
+    uint32_t timeouts;                  ///< 超过时限的调用数
+    uint32_t submit_failed;             ///< submit_tool_outputs 发送失败次数
+    uint32_t local_ms_avg;
+    uint32_t local_ms_max;
+    uint32_t resume_ms_avg;
+    uint32_t resume_ms_max;
+} coze_tool_stats_t;
+
+/**
+ * @brief 读取参数（未给出时返回默认值）
+ */
+bool coze_tool_arg_has(const coze_tool_args_t *args, const char *name);
+int32_t coze_tool_arg_int(const coze_tool_args_t *args, const char *name, int32_t def);
+double coze_tool_arg_number(const coze_tool_args_t *args, const char *name, double def);
+bool coze_tool_arg_bool(const coze_tool_args_t *args, const char *name, bool def);
+const char *coze_tool_arg_str(const coze_tool_args_t *args, const char *name, const char *def);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,884 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 10:20:11
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 10:20:11
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_coze_chat\coze_tool_bridge.cpp
+ * @Description: 工具调用桥接模块实现
+ *
+ * 线程模型：
+ * - 解析任务：requires_action 只做拷贝和入队，不阻塞音频下行
+ * - 分发任务：逐个调用解析参数、投递给执行任务、按剩余时限等待结果，最后组包回传
+ * - 执行任务：运行处理函数；超时后分发任务不再等待，迟到的结果按序号丢弃
+ *
+ * Copyright (c) 2026 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include "coze_tool_bridge.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static const char *TAG = "COZE_TOOL";
+
+#define BRIDGE_ACTION_QUEUE_LEN     4
+#define BRIDGE_NAME_MAX             48
+#define BRIDGE_ID_MAX               64
+#define BRIDGE_TASK_STACK           6144
+#define BRIDGE_TASK_PRIORITY        5       // 低于解析任务（6），不抢音频
+#define BRIDGE_STOP_WAIT_MS         500
+
+/**
+ * @brief 一次工具调用（来自 tool_calls 数组）
+ */
+typedef struct {
+    char id[BRIDGE_ID_MAX];
+    char name[BRIDGE_NAME_MAX];
+    char *arguments;                    // 堆上的参数 JSON 字符串
+} bridge_call_t;
+
+/**
+ * @brief 一次 requires_action（解析任务分配，分发任务释放）
+ */
+typedef struct {
+    char chat_id[BRIDGE_ID_MAX];
+    int64_t recv_us;
+    int call_count;
+    bridge_call_t *calls;
+} bridge_action_t;
+
+/**
+ * @brief 投递给执行任务的作业 / 执行结果
+ */
+typedef struct {
+    uint32_t seq;
+    int tool_index;
+    coze_tool_args_t args;
+} bridge_job_t;
+
+typedef struct {
+    uint32_t seq;
+    esp_err_t err;
+    uint32_t exec_us;
+    char out[COZE_TOOL_OUTPUT_MAX];
+} bridge_result_t;
+
+/**
+ * @brief 已提交、等待服务端恢复的往返记录
+ */
+typedef struct {
+    char name[BRIDGE_NAME_MAX];
+    bool ok;
+    bool timed_out;
+    uint32_t exec_ms;
+} bridge_call_report_t;
+
+typedef struct {
+    bool active;
+    char chat_id[BRIDGE_ID_MAX];
+    int64_t submit_us;
+    uint32_t local_ms;
+    int call_count;
+    bridge_call_report_t calls[COZE_TOOL_MAX_CALLS];
+} bridge_pending_t;
+
+typedef struct coze_tool_bridge_s {
+    coze_tool_bridge_config_t config;
+
+    // 注册表（只增不减，count 在锁内读写）
+    coze_tool_t tools[COZE_TOOL_MAX];
+    int tool_count;
+
+    // 任务与队列
+    QueueHandle_t action_queue;         // bridge_action_t *
+    QueueHandle_t job_queue;            // bridge_job_t，深度 1
+    QueueHandle_t result_queue;         // bridge_result_t，深度 1（覆盖写）
+    TaskHandle_t dispatch_task;
+    TaskHandle_t runner_task;
+    volatile bool running;
+    volatile bool dispatch_alive;
+    volatile bool runner_alive;
+    uint32_t seq;
+
+    // 任务私有的大块缓冲（避免占栈）
+    bridge_job_t dispatch_job;
+    bridge_result_t dispatch_result;
+    bridge_job_t runner_job;
+    bridge_result_t runner_result;
+    bridge_pending_t dispatch_report;
+
+    // 往返计时与统计
+    volatile bool pending_flag;
+    bridge_pending_t pending;
+    uint64_t local_ms_sum;
+    uint64_t resume_ms_sum;
+    uint32_t resume_count;
+    coze_tool_stats_t stats;
+    portMUX_TYPE lock;
+} coze_tool_bridge_t;
+
+// ============ 参数解析（JSON Schema 子集） ============
+
+static const coze_tool_arg_t *bridge_find_arg(const coze_tool_args_t *args, const char *name)
+{
+    if (!args || !name) {
+        return NULL;
+    }
+    for (int i = 0; i < args->count; i++) {
+        if (args->items[i].present && strcmp(args->items[i].name, name) == 0) {
+            return &args->items[i];
+        }
+    }
+    return NULL;
+}
+
+extern "C" bool coze_tool_arg_has(const coze_tool_args_t *args, const char *name)
+{
+    return bridge_find_arg(args, name) != NULL;
+}
+
+extern "C" int32_t coze_tool_arg_int(const coze_tool_args_t *args, const char *name, int32_t def)
+{
+    const coze_tool_arg_t *a = bridge_find_arg(args, name);
+    if (!a) return def;
+    if (a->type == COZE_TOOL_PARAM_NUMBER) return (int32_t)a->v.d;
+    if (a->type == COZE_TOOL_PARAM_BOOL) return a->v.b ? 1 : 0;
+    return a->type == COZE_TOOL_PARAM_INT ? a->v.i : def;
+}
+
+extern "C" double coze_tool_arg_number(const coze_tool_args_t *args, const char *name, double def)
+{
+    const coze_tool_arg_t *a = bridge_find_arg(args, name);
+    if (!a) return def;
+    if (a->type == COZE_TOOL_PARAM_INT) return (double)a->v.i;
+    return a->type == COZE_TOOL_PARAM_NUMBER ? a->v.d : def;
+}
+
+extern "C" bool coze_tool_arg_bool(const coze_tool_args_t *args, const char *name, bool def)
+{
+    const coze_tool_arg_t *a = bridge_find_arg(args, name);
+    return (a && a->type == COZE_TOOL_PARAM_BOOL) ? a->v.b : def;
+}
+
+extern "C" const char *coze_tool_arg_str(const coze_tool_args_t *args, const char *name, const char *def)
+{
+    const coze_tool_arg_t *a = bridge_find_arg(args, name);
+    return (a && a->type == COZE_TOOL_PARAM_STRING) ? a->s : def;
+}
+
+/**
+ * @brief 把 JSON 数字或数字字符串转成 double（智能体常把数字写成字符串）
+ */
+static bool bridge_item_to_number(const cJSON *item, double *out)
+{
+    if (cJSON_IsNumber(item)) {
+        *out = item->valuedouble;
+        return true;
+    }
+    if (cJSON_IsString(item) && item->valuestring[0] != '\0') {
+        char *end = NULL;
+        double d = strtod(item->valuestring, &end);
+        if (end && *end == '\0') {
+            *out = d;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool bridge_item_to_bool(const cJSON *item, bool *out)
+{
+    if (cJSON_IsBool(item)) {
+        *out = cJSON_IsTrue(item);
+        return true;
+    }
+    if (cJSON_IsNumber(item) && (item->valuedouble == 0 || item->valuedouble == 1)) {
+        *out = item->valuedouble != 0;
+        return true;
+    }
+    if (cJSON_IsString(item)) {
+        if (strcmp(item->valuestring, "true") == 0 || strcmp(item->valuestring, "1") == 0) {
+            *out = true;
+            return true;
+        }
+        if (strcmp(item->valuestring, "false") == 0 || strcmp(item->valuestring, "0") == 0) {
+            *out = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 按参数规格解析 arguments
+ *
+ * @param err 失败时写入给智能体看的原因（英文短句）
+ * @return true 成功
+ */
+static bool bridge_parse_args(const coze_tool_t *tool, const char *arguments,
+                              coze_tool_args_t *args, char *err, size_t err_len)
+{
+    memset(args, 0, sizeof(*args));
+    args->count = tool->param_count;
+
+    cJSON *root = NULL;
+    if (arguments && arguments[0] != '\0') {
+        root = cJSON_Parse(arguments);
+        if (!root || !cJSON_IsObject(root)) {
+            snprintf(err, err_len, "arguments is not a JSON object");
+            cJSON_Delete(root);
+            return false;
+        }
+    }
+
+    bool ok = true;
+    for (int i = 0; i < tool->param_count && ok; i++) {
+        const coze_tool_param_t *p = &tool->params[i];
+        coze_tool_arg_t *a = &args->items[i];
+        a->name = p->name;
+        a->type = p->type;
+
+        const cJSON *item = root ? cJSON_GetObjectItemCaseSensitive(root, p->name) : NULL;
+        if (!item || cJSON_IsNull(item)) {
+            if (p->required) {
+                snprintf(err, err_len, "missing parameter '%s'", p->name);
+                ok = false;
+            }
+            continue;
+        }
+
+        bool has_range = p->min < p->max;
+        double d = 0;
+        switch (p->type) {
+        case COZE_TOOL_PARAM_STRING:
+            if (!cJSON_IsString(item)) {
+                snprintf(err, err_len, "parameter '%s' must be a string", p->name);
+                ok = false;
+                break;
+            }
+            if (strlen(item->valuestring) >= sizeof(a->s)) {
+                snprintf(err, err_len, "parameter '%s' is too long", p->name);
+                ok = false;
+                break;
+            }
+            if (p->enum_values && p->enum_count > 0) {
+                bool matched = false;
+                for (int k = 0; k < p->enum_count && !matched; k++) {
+                    matched = strcmp(item->valuestring, p->enum_values[k]) == 0;
+                }
+                if (!matched) {
+                    snprintf(err, err_len, "parameter '%s' has an unsupported value", p->name);
+                    ok = false;
+                    break;
+                }
+            }
+            strcpy(a->s, item->valuestring);
+            a->present = true;
+            break;
+
+        case COZE_TOOL_PARAM_INT:
+        case COZE_TOOL_PARAM_NUMBER:
+            if (!bridge_item_to_number(item, &d) ||
+                (p->type == COZE_TOOL_PARAM_INT && (d != floor(d) || d < INT32_MIN || d > INT32_MAX))) {
+                snprintf(err, err_len, "parameter '%s' must be %s", p->name,
+                         p->type == COZE_TOOL_PARAM_INT ? "an integer" : "a number");
+                ok = false;
+                break;
+            }
+            if (has_range && (d < p->min || d > p->max)) {
+                snprintf(err, err_len, "parameter '%s' must be within [%g, %g]", p->name, p->min, p->max);
+                ok = false;
+                break;
+            }
+            if (p->type == COZE_TOOL_PARAM_INT) {
+                a->v.i = (int32_t)d;
+            } else {
+                a->v.d = d;
+            }
+            a->present = true;
+            break;
+
+        case COZE_TOOL_PARAM_BOOL:
+            if (!bridge_item_to_bool(item, &a->v.b)) {
+                snprintf(err, err_len, "parameter '%s' must be a boolean", p->name);
+                ok = false;
+                break;
+            }
+            a->present = true;
+            break;
+        }
+    }
+
+    cJSON_Delete(root);
+    return ok;
+}
+
+/**
+ * @brief 生成错误输出 {"error":"..."}（用 cJSON 转义，工具名来自服务端）
+ */
+static void bridge_error_output(char *out, size_t out_len, const char *msg, uint32_t deadline_ms)
+{
+    cJSON *obj = cJSON_CreateObject();
+    cJSON_AddStringToObject(obj, "error", msg);
+    if (deadline_ms > 0) {
+        cJSON_AddNumberToObject(obj, "deadline_ms", deadline_ms);
+    }
+    if (!cJSON_PrintPreallocated(obj, out, (int)out_len, false)) {
+        snprintf(out, out_len, "{\"error\":\"internal\"}");
+    }
+    cJSON_Delete(obj);
+}
+
+// ============ 执行任务 ============
+
+static void bridge_runner_task(void *arg)
+{
+    coze_tool_bridge_t *b = (coze_tool_bridge_t *)arg;
+    bridge_job_t *job = &b->runner_job;
+    bridge_result_t *res = &b->runner_result;
+
+    ESP_LOGI(TAG, "🚀 工具执行任务启动");
+
+    while (b->running) {
+        if (xQueueReceive(b->job_queue, job, pdMS_TO_TICKS(200)) != pdTRUE) {
+            continue;
+        }
+
+        const coze_tool_t *tool = &b->tools[job->tool_index];
+        memset(res, 0, sizeof(*res));
+        res->seq = job->seq;
+
+        int64_t t0 = esp_timer_get_time();
+        res->err = tool->handler(&job->args, res->out, sizeof(res->out), tool->ctx);
+        res->exec_us = (uint32_t)(esp_timer_get_time() - t0);
+        res->out[sizeof(res->out) - 1] = '\0';
+
+        if (res->out[0] == '\0') {
+            if (res->err != ESP_OK) {
+                bridge_error_output(res->out, sizeof(res->out), esp_err_to_name(res->err), 0);
+            } else {
+                snprintf(res->out, sizeof(res->out), "{\"ok\":true}");
+            }
+        }
+
+        // 深度 1 覆盖写：分发任务已超时放弃时，这个结果会被下一次调用按序号丢弃
+        xQueueOverwrite(b->result_queue, res);
+    }
+
+    ESP_LOGI(TAG, "工具执行任务退出");
+    b->runner_alive = false;
+    vTaskDelete(NULL);
+}
+
+// ============ 分发任务 ============
+
+static int bridge_find_tool(coze_tool_bridge_t *b, const char *name)
+{
+    portENTER_CRITICAL(&b->lock);
+    int count = b->tool_count;
+    portEXIT_CRITICAL(&b->lock);
+
+    for (int i = 0; i < count; i++) {
+        if (strcmp(b->tools[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 执行单个调用，结果写入 out
+ *
+ * @return ESP_OK 处理函数成功；ESP_ERR_TIMEOUT 超时；其他为参数 / 工具 / 处理函数错误
+ */
+static esp_err_t bridge_run_call(coze_tool_bridge_t *b, const bridge_call_t *call, char *out, size_t out_len)
+{
+    int idx = bridge_find_tool(b, call->name);
+    if (idx < 0) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "unknown tool '%s'", call->name);
+        bridge_error_output(out, out_len, msg, 0);
+        ESP_LOGW(TAG, "⚠️ 未注册的工具: %s", call->name);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const coze_tool_t *tool = &b->tools[idx];
+    bridge_job_t *job = &b->dispatch_job;
+    char err[96];
+    if (!bridge_parse_args(tool, call->arguments, &job->args, err, sizeof(err))) {
+        bridge_error_output(out, out_len, err, 0);
+        ESP_LOGW(TAG, "⚠️ %s 参数错误: %s (%s)", tool->name, err, call->arguments ? call->arguments : "");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t deadline_ms = tool->deadline_ms > 0 ? tool->deadline_ms : COZE_TOOL_DEFAULT_DEADLINE_MS;
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)deadline_ms * 1000;
+
+    job->seq = ++b->seq;
+    job->tool_index = idx;
+
+    // 执行任务被上一个超时的调用占住时，入队本身也计入时限
+    if (xQueueSend(b->job_queue, job, pdMS_TO_TICKS(deadline_ms)) != pdTRUE) {
+        bridge_error_output(out, out_len, "timeout", deadline_ms);
+        ESP_LOGW(TAG, "⏱️ %s 超时（执行任务忙）", tool->name);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    bridge_result_t *res = &b->dispatch_result;
+    while (true) {
+        int64_t remain_us = deadline_us - esp_timer_get_time();
+        TickType_t wait = remain_us > 0 ? pdMS_TO_TICKS((remain_us + 999) / 1000) : 0;
+        if (remain_us <= 0 || xQueueReceive(b->result_queue, res, wait) != pdTRUE) {
+            bridge_error_output(out, out_len, "timeout", deadline_ms);
+            ESP_LOGW(TAG, "⏱️ %s 超过时限 %lu ms", tool->name, (unsigned long)deadline_ms);
+            return ESP_ERR_TIMEOUT;
+        }
+        if (res->seq == job->seq) {
+            break;
+        }
+        ESP_LOGD(TAG, "丢弃迟到的结果 #%lu", (unsigned long)res->seq);
+    }
+
+    strncpy(out, res->out, out_len - 1);
+    out[out_len - 1] = '\0';
+    ESP_LOGI(TAG, "🔧 %s -> %s (%lu us)", tool->name, esp_err_to_name(res->err), (unsigned long)res->exec_us);
+    return res->err;
+}
+
+static bool bridge_send_outputs(coze_tool_bridge_t *b, const char *chat_id, cJSON *outputs)
+{
+    cJSON *root = cJSON_CreateObject();
+    char event_id[64];
+    snprintf(event_id, sizeof(event_id), "tool_%lld", esp_timer_get_time() / 1000);
+
+    cJSON_AddStringToObject(root, "id", event_id);
+    cJSON_AddStringToObject(root, "event_type", "conversation.chat.submit_tool_outputs");
+
+    cJSON *data = cJSON_CreateObject();
+    cJSON_AddStringToObject(data, "chat_id", chat_id);
+    cJSON_AddItemToObject(data, "tool_outputs", outputs);
+    cJSON_AddItemToObject(root, "data", data);
+
+    char *json_str = cJSON_PrintUnformatted(root);
+    bool success = json_str && b->config.send_callback(json_str, b->config.send_callback_ctx);
+
+    if (json_str) free(json_str);
+    cJSON_Delete(root);
+    return success;
+}
+
+/**
+ * @brief 上报一次往返（resume_ms < 0 表示未提交成功或服务端未恢复）
+ */
+static void bridge_emit_round_trip(coze_tool_bridge_t *b, const bridge_pending_t *p, int32_t resume_ms)
+{
+    ESP_LOGI(TAG, "📊 工具往返: %d 个调用, 本地 %lu ms, 恢复 %ld ms",
+             p->call_count, (unsigned long)p->local_ms, (long)resume_ms);
+
+    if (!b->config.event_callback) {
+        return;
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "chat_id", p->chat_id);
+    cJSON *calls = cJSON_AddArrayToObject(root, "calls");
+    for (int i = 0; i < p->call_count; i++) {
+        cJSON *c = cJSON_CreateObject();
+        cJSON_AddStringToObject(c, "name", p->calls[i].name);
+        cJSON_AddBoolToObject(c, "ok", p->calls[i].ok);
+        if (p->calls[i].timed_out) {
+            cJSON_AddBoolToObject(c, "timeout", true);
+        }
+        cJSON_AddNumberToObject(c, "exec_ms", p->calls[i].exec_ms);
+        cJSON_AddItemToArray(calls, c);
+    }
+    cJSON_AddNumberToObject(root, "local_ms", p->local_ms);
+    cJSON_AddNumberToObject(root, "resume_ms", resume_ms);
+    cJSON_AddNumberToObject(root, "rtt_ms", resume_ms >= 0 ? (int32_t)p->local_ms + resume_ms : -1);
+
+    char *json_str = cJSON_PrintUnformatted(root);
+    if (json_str) {
+        b->config.event_callback(COZE_CHAT_EVENT_TOOL_ROUND_TRIP, json_str, NULL);
+        free(json_str);
+    }
+    cJSON_Delete(root);
+}
+
+static void bridge_handle_action(coze_tool_bridge_t *b, const bridge_action_t *action)
+{
+    bridge_pending_t &report = b->dispatch_report;
+    memset(&report, 0, sizeof(report));
+    strncpy(report.chat_id, action->chat_id, sizeof(report.chat_id) - 1);
+
+    uint32_t errors = 0;
+    uint32_t timeouts = 0;
+    char out[COZE_TOOL_OUTPUT_MAX];
+    cJSON *outputs = cJSON_CreateArray();
+
+    for (int i = 0; i < action->call_count; i++) {
+        const bridge_call_t *call = &action->calls[i];
+        int64_t t0 = esp_timer_get_time();
+        esp_err_t err;
+
+        if (i < COZE_TOOL_MAX_CALLS) {
+            err = bridge_run_call(b, call, out, sizeof(out));
+        } else {
+            // 每个 tool_call_id 都必须有输出，否则服务端会一直等待
+            bridge_error_output(out, sizeof(out), "too many tool calls", 0);
+            err = ESP_ERR_NO_MEM;
+        }
+
+        if (err == ESP_ERR_TIMEOUT) {
+            timeouts++;
+        } else if (err != ESP_OK) {
+            errors++;
+        }
+
+        if (i < COZE_TOOL_MAX_CALLS) {
+            bridge_call_report_t *r = &report.calls[report.call_count++];
+            strncpy(r->name, call->name, sizeof(r->name) - 1);
+            r->ok = err == ESP_OK;
+            r->timed_out = err == ESP_ERR_TIMEOUT;
+            r->exec_ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+        }
+
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "tool_call_id", call->id);
+        cJSON_AddStringToObject(item, "output", out);
+        cJSON_AddItemToArray(outputs, item);
+    }
+
+    bool sent = bridge_send_outputs(b, action->chat_id, outputs);
+    int64_t now = esp_timer_get_time();
+    report.submit_us = now;
+    report.local_ms = (uint32_t)((now - action->recv_us) / 1000);
+
+    if (sent) {
+        ESP_LOGI(TAG, "📤 已提交 %d 个工具输出（本地 %lu ms）",
+                 action->call_count, (unsigned long)report.local_ms);
+    } else {
+        ESP_LOGE(TAG, "❌ 提交工具输出失败");
+    }
+
+    portENTER_CRITICAL(&b->lock);
+    b->stats.actions++;
+    b->stats.calls += action->call_count;
+    b->stats.errors += errors;
+    b->stats.timeouts += timeouts;
+    b->local_ms_sum += report.local_ms;
+    b->stats.local_ms_avg = (uint32_t)(b->local_ms_sum / b->stats.actions);
+    if (report.local_ms > b->stats.local_ms_max) {
+        b->stats.local_ms_max = report.local_ms;
+    }
+    if (sent) {
+        report.active = true;
+        b->pending = report;
+        b->pending_flag = true;
+    } else {
+        b->stats.submit_failed++;
+    }
+    portEXIT_CRITICAL(&b->lock);
+
+    if (!sent) {
+        bridge_emit_round_trip(b, &report, -1);
+    }
+}
+
+static void bridge_action_free(bridge_action_t *action)
+{
+    if (!action) return;
+    for (int i = 0; i < action->call_count; i++) {
+        free(action->calls[i].arguments);
+    }
+    free(action->calls);
+    free(action);
+}
+
+static void bridge_dispatch_task(void *arg)
+{
+    coze_tool_bridge_t *b = (coze_tool_bridge_t *)arg;
+
+    ESP_LOGI(TAG, "🚀 工具分发任务启动");
+
+    while (b->running) {
+        bridge_action_t *action = NULL;
+        if (xQueueReceive(b->action_queue, &action, pdMS_TO_TICKS(200)) != pdTRUE) {
+            continue;
+        }
+        bridge_handle_action(b, action);
+        bridge_action_free(action);
+    }
+
+    ESP_LOGI(TAG, "工具分发任务退出");
+    b->dispatch_alive = false;
+    vTaskDelete(NULL);
+}
+
+// ============ 公共接口 ============
+
+extern "C" coze_tool_bridge_handle_t coze_tool_bridge_create(const coze_tool_bridge_config_t *config)
+{
+    if (!config || !config->send_callback) {
+        ESP_LOGE(TAG, "无效的配置参数");
+        return NULL;
+    }
+
+    coze_tool_bridge_t *b = (coze_tool_bridge_t *)calloc(1, sizeof(coze_tool_bridge_t));
+    if (!b) {
+        ESP_LOGE(TAG, "分配结构体失败");
+        return NULL;
+    }
+
+    memcpy(&b->config, config, sizeof(coze_tool_bridge_config_t));
+    portMUX_INITIALIZE(&b->lock);
+
+    b->action_queue = xQueueCreate(BRIDGE_ACTION_QUEUE_LEN, sizeof(bridge_action_t *));
+    b->job_queue = xQueueCreate(1, sizeof(bridge_job_t));
+    b->result_queue = xQueueCreate(1, sizeof(bridge_result_t));
+    if (!b->action_queue || !b->job_queue || !b->result_queue) {
+        ESP_LOGE(TAG, "创建队列失败");
+        if (b->action_queue) vQueueDelete(b->action_queue);
+        if (b->job_queue) vQueueDelete(b->job_queue);
+        if (b->result_queue) vQueueDelete(b->result_queue);
+        free(b);
+        return NULL;
+    }
+
+    ESP_LOGI(TAG, "✅ 工具桥接模块创建成功");
+    return b;
+}
+
+extern "C" void coze_tool_bridge_destroy(coze_tool_bridge_handle_t handle)
+{
+    if (!handle) return;
+
+    coze_tool_bridge_stop(handle);
+
+    if (handle->runner_alive || handle->dispatch_alive) {
+        // 处理函数卡住：任务仍在引用结构体和队列，只能放弃回收
+        ESP_LOGE(TAG, "❌ 工具任务未退出，放弃释放桥接模块");
+        return;
+    }
+
+    bridge_action_t *action = NULL;
+    while (xQueueReceive(handle->action_queue, &action, 0) == pdTRUE) {
+        bridge_action_free(action);
+    }
+    vQueueDelete(handle->action_queue);
+    vQueueDelete(handle->job_queue);
+    vQueueDelete(handle->result_queue);
+    free(handle);
+    ESP_LOGI(TAG, "工具桥接模块已销毁");
+}
+
+extern "C" esp_err_t coze_tool_bridge_start(coze_tool_bridge_handle_t handle)
+{
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle->running) {
+        return ESP_OK;
+    }
+    if (handle->runner_alive || handle->dispatch_alive) {
+        ESP_LOGE(TAG, "❌ 上一轮工具任务尚未退出");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    handle->running = true;
+    handle->runner_alive = true;
+    handle->dispatch_alive = true;
+
+    // 栈在内部 RAM：处理函数可能写 Flash（NVS）或调用 WiFi 驱动
+    if (xTaskCreate(bridge_runner_task, "coze_tool_run", BRIDGE_TASK_STACK, handle,
+                    BRIDGE_TASK_PRIORITY, &handle->runner_task) != pdPASS) {
+        ESP_LOGE(TAG, "创建执行任务失败");
+        handle->running = false;
+        handle->runner_alive = false;
+        handle->dispatch_alive = false;
+        return ESP_FAIL;
+    }
+    if (xTaskCreate(bridge_dispatch_task, "coze_tool_disp", BRIDGE_TASK_STACK, handle,
+                    BRIDGE_TASK_PRIORITY, &handle->dispatch_task) != pdPASS) {
+        ESP_LOGE(TAG, "创建分发任务失败");
+        handle->dispatch_alive = false;
+        coze_tool_bridge_stop(handle);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "✅ 工具桥接任务已启动（%d 个工具）", handle->tool_count);
+    return ESP_OK;
+}
+
+extern "C" esp_err_t coze_tool_bridge_stop(coze_tool_bridge_handle_t handle)
+{
+    if (!handle || !handle->running) {
+        return ESP_OK;
+    }
+
+    handle->running = false;
+
+    for (int waited = 0; (handle->runner_alive || handle->dispatch_alive) && waited < BRIDGE_STOP_WAIT_MS; waited += 20) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    if (handle->runner_alive || handle->dispatch_alive) {
+        ESP_LOGW(TAG, "⚠️ 工具任务 %d ms 内未退出（处理函数仍在执行）", BRIDGE_STOP_WAIT_MS);
+    }
+    handle->runner_task = NULL;
+    handle->dispatch_task = NULL;
+
+    portENTER_CRITICAL(&handle->lock);
+    handle->pending_flag = false;
+    handle->pending.active = false;
+    portEXIT_CRITICAL(&handle->lock);
+
+    ESP_LOGI(TAG, "工具桥接任务已停止");
+    return ESP_OK;
+}
+
+extern "C" esp_err_t coze_tool_bridge_register(coze_tool_bridge_handle_t handle, const coze_tool_t *tool)
+{
+    if (!handle || !tool || !tool->name || tool->name[0] == '\0' || !tool->handler ||
+        strlen(tool->name) >= BRIDGE_NAME_MAX ||
+        tool->param_count < 0 || tool->param_count > COZE_TOOL_MAX_PARAMS ||
+        (tool->param_count > 0 && !tool->params)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < tool->param_count; i++) {
+        if (!tool->params[i].name) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    if (bridge_find_tool(handle, tool->name) >= 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&handle->lock);
+    esp_err_t ret = ESP_OK;
+    if (handle->tool_count >= COZE_TOOL_MAX) {
+        ret = ESP_ERR_NO_MEM;
+    } else {
+        // 先写条目再增加计数，分发任务只访问 count 以内的条目
+        handle->tools[handle->tool_count] = *tool;
+        handle->tool_count++;
+    }
+    portEXIT_CRITICAL(&handle->lock);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "🔧 注册工具: %s（%d 个参数）", tool->name, tool->param_count);
+    }
+    return ret;
+}
+
+extern "C" void coze_tool_bridge_on_requires_action(coze_tool_bridge_handle_t handle, const cJSON *data)
+{
+    if (!handle || !data) return;
+
+    // 服务端连续发起下一轮调用，也算上一轮已恢复
+    coze_tool_bridge_on_server_event(handle);
+
+    const cJSON *required = cJSON_GetObjectItem(data, "required_action");
+    const cJSON *type = required ? cJSON_GetObjectItem(required, "type") : NULL;
+    if (!cJSON_IsString(type) || strcmp(type->valuestring, "submit_tool_outputs") != 0) {
+        ESP_LOGW(TAG, "⚠️ 不支持的 required_action");
+        return;
+    }
+
+    const cJSON *submit = cJSON_GetObjectItem(required, "submit_tool_outputs");
+    const cJSON *tool_calls = submit ? cJSON_GetObjectItem(submit, "tool_calls") : NULL;
+    int count = cJSON_IsArray(tool_calls) ? cJSON_GetArraySize(tool_calls) : 0;
+    const cJSON *chat_id = cJSON_GetObjectItem(data, "id");
+    if (count == 0 || !cJSON_IsString(chat_id)) {
+        ESP_LOGW(TAG, "⚠️ requires_action 缺少 tool_calls 或 chat id");
+        return;
+    }
+
+    bridge_action_t *action = (bridge_action_t *)calloc(1, sizeof(bridge_action_t));
+    bridge_call_t *calls = (bridge_call_t *)calloc(count, sizeof(bridge_call_t));
+    if (!action || !calls) {
+        ESP_LOGE(TAG, "❌ 分配工具调用失败");
+        free(action);
+        free(calls);
+        return;
+    }
+    action->recv_us = esp_timer_get_time();
+    action->calls = calls;
+    action->call_count = count;
+    strncpy(action->chat_id, chat_id->valuestring, sizeof(action->chat_id) - 1);
+
+    for (int i = 0; i < count; i++) {
+        const cJSON *tc = cJSON_GetArrayItem(tool_calls, i);
+        const cJSON *id = cJSON_GetObjectItem(tc, "id");
+        const cJSON *fn = cJSON_GetObjectItem(tc, "function");
+        const cJSON *name = fn ? cJSON_GetObjectItem(fn, "name") : NULL;
+        const cJSON *arguments = fn ? cJSON_GetObjectItem(fn, "arguments") : NULL;
+
+        if (cJSON_IsString(id)) {
+            strncpy(calls[i].id, id->valuestring, sizeof(calls[i].id) - 1);
+        }
+        if (cJSON_IsString(name)) {
+            strncpy(calls[i].name, name->valuestring, sizeof(calls[i].name) - 1);
+        }
+        if (cJSON_IsString(arguments)) {
+            calls[i].arguments = strdup(arguments->valuestring);
+        } else if (cJSON_IsObject(arguments)) {
+            calls[i].arguments = cJSON_PrintUnformatted(arguments);
+        }
+    }
+
+    if (!handle->running || xQueueSend(handle->action_queue, &action, 0) != pdTRUE) {
+        ESP_LOGE(TAG, "❌ 工具调用队列已满或未启动，丢弃 %d 个调用", count);
+        portENTER_CRITICAL(&handle->lock);
+        handle->stats.errors += count;
+        portEXIT_CRITICAL(&handle->lock);
+        bridge_action_free(action);
+        return;
+    }
+
+    ESP_LOGI(TAG, "📥 requires_action: %d 个调用，首个 %s", count, calls[0].name);
+}
+
+extern "C" void coze_tool_bridge_on_server_event(coze_tool_bridge_handle_t handle)
+{
+    if (!handle || !handle->pending_flag) {
+        return;
+    }
+
+    bridge_pending_t p;
+    int32_t resume_ms = 0;
+
+    portENTER_CRITICAL(&handle->lock);
+    bool active = handle->pending.active;
+    if (active) {
+        p = handle->pending;
+        handle->pending.active = false;
+        resume_ms = (int32_t)((esp_timer_get_time() - p.submit_us) / 1000);
+        handle->resume_count++;
+        handle->resume_ms_sum += resume_ms;
+        handle->stats.resume_ms_avg = (uint32_t)(handle->resume_ms_sum / handle->resume_count);
+        if ((uint32_t)resume_ms > handle->stats.resume_ms_max) {
+            handle->stats.resume_ms_max = resume_ms;
+        }
+    }
+    handle->pending_flag = false;
+    portEXIT_CRITICAL(&handle->lock);
+
+    if (active) {
+        bridge_emit_round_trip(handle, &p, resume_ms);
+    }
+}
+
+extern "C" esp_err_t coze_tool_bridge_get_stats(coze_tool_bridge_handle_t handle, coze_tool_stats_t *stats)
+{
+    if (!handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&handle->lock);
+    *stats = handle->stats;
+    portEXIT_CRITICAL(&handle->lock);
+    return ESP_OK;
+}
@@ -0,0 +1,82 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 10:20:11
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 10:20:11
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_coze_chat\coze_tool_bridge.h
+ * @Description: 工具调用桥接模块 - 把 conversation.chat.requires_action 分发给本地工具
+ *
+ * 功能：
+ * - 本地工具注册表（名字 + 参数规格 + 处理函数）
+ * - 按规格解析 function.arguments（JSON Schema 子集）
+ * - 分发任务逐个调用，执行任务跑处理函数，单次调用超时直接回错误
+ * - 组装 conversation.chat.submit_tool_outputs 回传
+ * - 统计本地耗时和服务端恢复耗时
+ *
+ * Copyright (c) 2026 by ${git_name_email}, All Rights Reserved.
+ */
+
+#pragma once
+
+#include "coze_tool.h"
+#include "coze_chat.h"
+#include "cJSON.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct coze_tool_bridge_s *coze_tool_bridge_handle_t;
+
+/**
+ * @brief WebSocket 发送回调（与 audio_uplink 相同）
+ */
+typedef bool (*coze_tool_bridge_send_callback_t)(const char *json_str, void *user_ctx);
+
+/**
+ * @brief 桥接模块配置
+ */
+typedef struct {
+    coze_tool_bridge_send_callback_t send_callback;  ///< 发送回调
+    void *send_callback_ctx;                         ///< 发送回调上下文
+    coze_event_callback_t event_callback;            ///< 上报 COZE_CHAT_EVENT_TOOL_ROUND_TRIP，可为 NULL
+} coze_tool_bridge_config_t;
+
+coze_tool_bridge_handle_t coze_tool_bridge_create(const coze_tool_bridge_config_t *config);
+
+void coze_tool_bridge_destroy(coze_tool_bridge_handle_t handle);
+
+/**
+ * @brief 启动分发 / 执行任务
+ */
+esp_err_t coze_tool_bridge_start(coze_tool_bridge_handle_t handle);
+
+/**
+ * @brief 停止分发 / 执行任务（处理函数卡住时不等待其返回）
+ */
+esp_err_t coze_tool_bridge_stop(coze_tool_bridge_handle_t handle);
+
+/**
+ * @brief 注册工具（拷贝描述，指针成员须长期有效）
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 描述无效, ESP_ERR_INVALID_STATE 重名, ESP_ERR_NO_MEM 注册表已满
+ */
+esp_err_t coze_tool_bridge_register(coze_tool_bridge_handle_t handle, const coze_tool_t *tool);
+
+/**
+ * @brief 处理 conversation.chat.requires_action 的 data 对象（解析任务中调用，不阻塞）
+ */
+void coze_tool_bridge_on_requires_action(coze_tool_bridge_handle_t handle, const cJSON *data);
+
+/**
+ * @brief 服务端恢复输出（文本 / 音频增量、对话结束、下一轮 requires_action）
+ *
+ * 提交工具输出后的第一个此类事件结束一次往返计时，并上报 COZE_CHAT_EVENT_TOOL_ROUND_TRIP。
+ * 没有挂起的计时时只读一个标志，可在每个音频包上调用。
+ */
+void coze_tool_bridge_on_server_event(coze_tool_bridge_handle_t handle);
+
+esp_err_t coze_tool_bridge_get_stats(coze_tool_bridge_handle_t handle, coze_tool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -22,6 +22,7 @@ typedef struct simple_ring_buffer_s {
     size_t read_pos;           ///< 读指针
     SemaphoreHandle_t mutex;   ///< 互斥锁
     SemaphoreHandle_t data_sem; ///< 数据信号量（用于阻塞读取）
+    uint32_t overwrite_bytes;  ///< 累计被覆盖（丢弃）的字节数
 } simple_ring_buffer_t;
 
 simple_ring_buffer_handle_t simple_ring_buffer_create(size_t size)
@@ -108,6 +109,7 @@ esp_err_t simple_ring_buffer_write(simple_ring_buffer_handle_t rb,
         // 如果写指针追上读指针，强制移动读指针（覆盖旧数据）
         if (rb->write_pos == rb->read_pos) {
             rb->read_pos = (rb->read_pos + 1) % rb->size;
+            rb->overwrite_bytes++;
         }
     }
 
@@ -190,3 +192,8 @@ void simple_ring_buffer_clear(simple_ring_buffer_handle_t rb)
     }
 }
 
+
+uint32_t simple_ring_buffer_get_overwrite_bytes(simple_ring_buffer_handle_t rb)
+{
+    return rb ? rb->overwrite_bytes : 0;
+}
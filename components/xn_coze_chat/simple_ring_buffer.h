@@ -80,6 +80,14 @@ size_t simple_ring_buffer_available(simple_ring_buffer_handle_t rb);
  */
 void simple_ring_buffer_clear(simple_ring_buffer_handle_t rb);
 
+/**
+ * @brief 获取累计被覆盖的字节数（写入速度超过读取速度时丢弃的旧数据）
+ * 
+ * @param rb 缓冲区句柄
+ * @return uint32_t 被覆盖字节数
+ */
+uint32_t simple_ring_buffer_get_overwrite_bytes(simple_ring_buffer_handle_t rb);
+
 #ifdef __cplusplus
 }
 #endif
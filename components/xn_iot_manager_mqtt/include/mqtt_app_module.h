@@ -16,8 +16,11 @@
 #define MQTT_APP_MODULE_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "web_mqtt_manager.h"  ///< 复用管理器中的状态定义
 
 /**
@@ -33,23 +36,88 @@ typedef esp_err_t (*web_mqtt_app_msg_cb_t)(const char    *topic,
                                            const uint8_t *payload,
                                            int            payload_len);
 
+/**
+ * @brief 应用模块注册配置
+ *
+ * queue_len 为 0 时回调直接在 esp-mqtt 事件任务中执行，须尽快返回；
+ * 大于 0 时管理器为模块创建独立的分发队列与工作任务，消息（Topic + 负载）被拷贝入队，
+ * 回调在工作任务中执行，耗时操作（如 WiFi 重连）不会拖住 MQTT 保活和其他模块；
+ * 队列满时丢弃新消息并计数。
+ */
+typedef struct {
+    web_mqtt_app_msg_cb_t cb;                   ///< 模块消息回调，不可为 NULL
+    uint16_t              queue_len;            ///< 分发队列深度，0 表示同步回调
+    uint32_t              task_stack_size;      ///< 工作任务栈大小（字节）
+    UBaseType_t           task_priority;        ///< 工作任务优先级
+    uint32_t              max_msg_size;         ///< 入队消息 Topic + 负载最大字节数，超出丢弃；0 不限制
+} web_mqtt_app_config_t;
+
+#define WEB_MQTT_APP_DEFAULT_CONFIG(callback)                          \
+    (web_mqtt_app_config_t) {                                          \
+        .cb              = (callback),                                 \
+        .queue_len       = 0,                                          \
+        .task_stack_size = 4096,                                       \
+        .task_priority   = tskIDLE_PRIORITY + 2,                       \
+        .max_msg_size    = 1024,                                       \
+    }
+
+/**
+ * @brief 应用模块分发统计
+ */
+typedef struct {
+    uint32_t received;                          ///< 路由命中的消息数
+    uint32_t dropped;                           ///< 因队列满 / 消息过大 / 内存不足丢弃的消息数
+    uint32_t queue_peak;                        ///< 队列中同时等待的消息数峰值
+    uint32_t handler_max_us;                    ///< 回调最长执行耗时
+} web_mqtt_app_stats_t;
+
 /**
  * @brief 在 Web MQTT 管理器中注册一个应用模块消息处理回调
  *
- * 管理器内部会维护一个简单的“路由表”，按如下规则匹配并分发消息：
+ * 注册时把订阅过滤串 "base_topic/topic_suffix/#" 编译进 Topic 路由树（见 mqtt_topic_router.h），
+ * 收到消息时按层级查找，不做字符串格式化：
  *  - 实际 Topic 形如： base_topic "/" topic_suffix "/..."；
  *  - 只要前缀 "base_topic/topic_suffix" 匹配，即调用对应回调；
- *  - 这样可以很方便地按模块前缀拆分：例如 "reg" / "hb" / "wifi_cfg" 等。
+ *  - topic_suffix 可包含 "+" 通配层（如 "dev/+/cmd"），以 "#" 结尾时不再追加 "/#"；
+ *  - 模块数量不设上限（注册表在堆上分配）。
+ *
+ * 回调在 esp-mqtt 事件任务中同步执行，耗时模块请使用 web_mqtt_manager_register_app_ex。
  *
  * @param topic_suffix 模块的 Topic 前缀（不含 base_topic 和前导 '/'），如 "reg"；
  * @param cb           模块的消息处理回调，不可为 NULL。
  *
  * @return
- *  - ESP_OK             : 注册成功
- *  - ESP_ERR_INVALID_ARG: 参数非法
- *  - ESP_ERR_NO_MEM    : 模块数量已达上限
+ *  - ESP_OK               : 注册成功（同名前缀重复注册时更新回调）
+ *  - ESP_ERR_INVALID_ARG  : 参数或通配符非法
+ *  - ESP_ERR_INVALID_STATE: 管理器尚未初始化
+ *  - ESP_ERR_NO_MEM       : 内存不足
  */
 esp_err_t web_mqtt_manager_register_app(const char *topic_suffix,
                                         web_mqtt_app_msg_cb_t cb);
 
+/**
+ * @brief 按配置注册应用模块（可选独立分发队列与工作任务）
+ *
+ * @param topic_suffix 模块的 Topic 前缀，规则同 web_mqtt_manager_register_app；
+ * @param config       注册配置，见 @ref web_mqtt_app_config_t。
+ *
+ * @return 同 web_mqtt_manager_register_app；创建队列或任务失败返回 ESP_ERR_NO_MEM。
+ *         同名前缀重复注册时只更新回调，分发方式保持首次注册时的配置。
+ */
+esp_err_t web_mqtt_manager_register_app_ex(const char *topic_suffix,
+                                           const web_mqtt_app_config_t *config);
+
+/**
+ * @brief 获取应用模块的分发统计
+ *
+ * @param topic_suffix 模块的 Topic 前缀
+ * @param stats        输出统计
+ * @param reset        读取后是否清零（峰值类统计一并清零）
+ *
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 参数为空, ESP_ERR_NOT_FOUND 模块未注册
+ */
+esp_err_t web_mqtt_manager_get_app_stats(const char *topic_suffix,
+                                         web_mqtt_app_stats_t *stats,
+                                         bool reset);
+
 #endif /* MQTT_APP_MODULE_H */
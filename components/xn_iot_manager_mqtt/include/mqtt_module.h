@@ -74,6 +74,7 @@ typedef struct {
     const char           *username;      ///< 用户名，可为 NULL 表示匿名
     const char           *password;      ///< 密码，可为 NULL 表示无密码
     int                   keepalive_sec; ///< keepalive 保活时间（秒），<=0 使用内部默认
+    bool                  disable_auto_reconnect; ///< 关闭 esp-mqtt 内置重连，由上层调用 mqtt_module_reconnect
     mqtt_module_event_cb_t  event_cb;    ///< 连接事件回调，可为 NULL 表示不关心
     mqtt_module_message_cb_t message_cb; ///< 消息回调，可为 NULL 表示不关心
 } mqtt_module_config_t;
@@ -92,6 +93,7 @@ typedef struct {
         .username      = NULL,                      \
         .password      = NULL,                      \
         .keepalive_sec = 60,                        \
+        .disable_auto_reconnect = false,            \
         .event_cb      = NULL,                      \
         .message_cb    = NULL,                      \
     }
@@ -129,6 +131,16 @@ esp_err_t mqtt_module_start(void);
  */
 esp_err_t mqtt_module_stop(void);
 
+/**
+ * @brief 立即发起一次重连（配合 disable_auto_reconnect 使用）
+ *
+ * - 客户端未启动或内部任务已退出时等同 mqtt_module_start；
+ * - 可能阻塞在 esp-mqtt 的 API 锁上，不要在 esp_timer 回调或 MQTT 事件回调中调用。
+ *
+ * @return ESP_OK 已触发, ESP_FAIL 客户端正在连接中（无需重复触发）
+ */
+esp_err_t mqtt_module_reconnect(void);
+
 /**
  * @brief 发布一条 MQTT 消息
  *
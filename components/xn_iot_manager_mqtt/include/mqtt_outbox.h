@@ -0,0 +1,112 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-07 14:05:31
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-07 14:05:31
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_iot_manager_mqtt\include\mqtt_outbox.h
+ * @Description: MQTT 上行发件箱（非阻塞入队 + 优先级 + 最新值合并 + 离线落盘续传）
+ *
+ * 设计要点：
+ *  - 入队只在临界区内摘/挂链表，数据拷贝到预分配槽位，O(1) 且从不阻塞调用方；
+ *  - 每条消息带优先级，发件任务按高 -> 低顺序发送；
+ *  - 带合并键的消息"最新值生效"：队列中已有同键消息时原位替换，只发最后一次的内容；
+ *  - 离线时 QoS>=1 且无合并键的消息写入 mqtt_outbox 分区的循环日志（按扇区轮转擦写，均衡磨损），
+ *    重新连上后按写入顺序补发，补发成功的记录原地标记为已消费；
+ *  - 合并键消息和 QoS0 消息离线时留在内存中，连上后发送。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#ifndef MQTT_OUTBOX_H
+#define MQTT_OUTBOX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define MQTT_OUTBOX_SLOTS            16          ///< 内存槽位数（PSRAM）
+#define MQTT_OUTBOX_SLOT_DATA        1152        ///< 每槽 Topic（含结束符）+ 负载最大字节数（健康上报 JSON 最长 1 KB）
+#define MQTT_OUTBOX_KEY_MAX          24          ///< 合并键最大长度（含结束符）
+#define MQTT_OUTBOX_KEY_BUCKETS      32          ///< 合并键直接映射表大小（2 的幂）
+#define MQTT_OUTBOX_PARTITION_LABEL  "mqtt_outbox" ///< 离线落盘分区名
+#define MQTT_OUTBOX_RETRY_MS         1000        ///< 在线发送失败后的重试间隔
+#define MQTT_OUTBOX_REPORT_MS        60000       ///< 统计日志输出周期
+
+/**
+ * @brief 消息优先级（数值越小越先发送）
+ */
+typedef enum {
+    MQTT_OUTBOX_PRIO_HIGH = 0,                   ///< 状态变化、命令应答
+    MQTT_OUTBOX_PRIO_NORMAL,                     ///< 一般上报
+    MQTT_OUTBOX_PRIO_LOW,                        ///< 心跳、健康统计等可延后的消息
+    MQTT_OUTBOX_PRIO_MAX,
+} mqtt_outbox_prio_t;
+
+/**
+ * @brief 发件箱统计
+ */
+typedef struct {
+    uint32_t depth;                              ///< 当前内存队列中的消息数
+    uint32_t depth_peak;                         ///< 内存队列深度峰值
+    uint32_t enqueued;                           ///< 入队次数
+    uint32_t coalesced;                          ///< 被同键新值替换掉的消息数
+    uint32_t sent;                               ///< 成功交给 MQTT 客户端的消息数
+    uint32_t dropped;                            ///< 槽位用尽 / 消息过大被拒绝的次数
+    uint32_t spilled;                            ///< 离线时写入分区的消息数
+    uint32_t spill_lost;                         ///< 分区写满后被覆盖的未发送消息数
+    uint32_t replayed;                           ///< 从分区补发的消息数
+    uint32_t replay_ms;                          ///< 最近一次补发耗时
+    uint32_t flash_pending;                      ///< 分区中尚未补发的消息数
+    uint32_t flash_erases;                       ///< 分区扇区擦除次数
+} mqtt_outbox_stats_t;
+
+/**
+ * @brief 初始化发件箱：分配槽位、扫描离线分区并启动发件任务（重复调用直接返回 ESP_OK）
+ *
+ * 未配置 mqtt_outbox 分区时不落盘，离线消息留在内存中等待重连。
+ *
+ * @return ESP_OK 成功, ESP_ERR_NO_MEM 内存不足
+ */
+esp_err_t mqtt_outbox_init(void);
+
+/**
+ * @brief 发布一条消息（拷贝后立即返回，从不阻塞）
+ *
+ * @param topic        目标 Topic
+ * @param payload      负载（可为 NULL，len 须为 0）
+ * @param len          负载长度
+ * @param qos          QoS 等级（0/1/2）
+ * @param retain       是否保留
+ * @param prio         优先级
+ * @param coalesce_key 合并键，NULL 表示不合并；同键消息只保留最新一条
+ *
+ * @return ESP_OK 已入队, ESP_ERR_INVALID_ARG 参数非法, ESP_ERR_INVALID_SIZE 超出槽位大小,
+ *         ESP_ERR_NO_MEM 槽位用尽, ESP_ERR_INVALID_STATE 未初始化
+ */
+esp_err_t mqtt_outbox_publish(const char        *topic,
+                              const void        *payload,
+                              int                len,
+                              int                qos,
+                              bool               retain,
+                              mqtt_outbox_prio_t prio,
+                              const char        *coalesce_key);
+
+/**
+ * @brief 通知连接状态（由 web_mqtt_manager 在连上 / 断开时调用）
+ *
+ * 连上后先补发分区中的离线消息，再按优先级发送内存队列。
+ *
+ * @param online 是否已连接
+ */
+void mqtt_outbox_set_online(bool online);
+
+/**
+ * @brief 获取发件箱统计
+ * @param stats 输出统计
+ * @param reset 读取后是否清零计数类统计（深度、分区待发数不清零）
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 参数为空, ESP_ERR_INVALID_STATE 未初始化
+ */
+esp_err_t mqtt_outbox_get_stats(mqtt_outbox_stats_t *stats, bool reset);
+
+#endif /* MQTT_OUTBOX_H */
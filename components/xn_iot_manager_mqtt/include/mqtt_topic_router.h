@@ -0,0 +1,99 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-07 09:40:12
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-07 09:40:12
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_iot_manager_mqtt\include\mqtt_topic_router.h
+ * @Description: MQTT Topic 路由表（按 Topic 层级组织的前缀树，支持 '+' / '#' 通配符）
+ *
+ * 设计要点：
+ *  - 订阅过滤串在注册时编译成前缀树，每个节点对应一个 Topic 层级；
+ *  - 匹配时按 '/' 逐层查找，不做任何字符串格式化，Topic 无需以 '\0' 结尾；
+ *  - 节点与路由只追加不修改，写入用 release 发布、读取用 acquire，
+ *    因此匹配无需加锁，可与注册并发进行（多个写者之间须由调用方互斥）；
+ *  - 不依赖 FreeRTOS，可在主机上单独编译（见 tools/router_bench.c）。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#ifndef MQTT_TOPIC_ROUTER_H
+#define MQTT_TOPIC_ROUTER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_err.h"
+#else
+typedef int esp_err_t;                           ///< 主机编译时的最小替身
+#define ESP_OK                  0
+#define ESP_ERR_NO_MEM          0x101
+#define ESP_ERR_INVALID_ARG     0x102
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** 路由表句柄 */
+typedef struct mqtt_topic_router mqtt_topic_router_t;
+
+/**
+ * @brief 匹配回调：每条命中的路由调用一次
+ * @param target 注册时传入的目标
+ * @param arg    mqtt_topic_router_match 传入的参数
+ * @return true 继续匹配, false 停止
+ */
+typedef bool (*mqtt_topic_match_cb_t)(void *target, void *arg);
+
+/**
+ * @brief 创建空路由表
+ * @return 路由表句柄，内存不足时返回 NULL
+ */
+mqtt_topic_router_t *mqtt_topic_router_create(void);
+
+/**
+ * @brief 销毁路由表（调用方须保证此时没有并发匹配）
+ * @param router 路由表，NULL 忽略
+ */
+void mqtt_topic_router_destroy(mqtt_topic_router_t *router);
+
+/**
+ * @brief 编译一条订阅过滤串并挂上目标
+ *
+ * 过滤串遵循 MQTT 规则："+" 匹配恰好一层，"#" 只能作为最后一层、匹配父层及其以下任意层；
+ * 以 '$' 开头的 Topic 不会被首层通配符匹配。同一过滤串可挂多个目标，按注册顺序回调。
+ *
+ * @param router 路由表
+ * @param filter 订阅过滤串，如 "xn/web/wifi/#"、"xn/web/+/status"
+ * @param target 命中时回调的目标（不可为 NULL）
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 参数或过滤串非法, ESP_ERR_NO_MEM 内存不足
+ */
+esp_err_t mqtt_topic_router_add(mqtt_topic_router_t *router, const char *filter, void *target);
+
+/**
+ * @brief 查找与 Topic 匹配的所有路由
+ * @param router    路由表
+ * @param topic     Topic（不要求以 '\0' 结尾）
+ * @param topic_len Topic 字节长度
+ * @param cb        命中回调
+ * @param arg       回调参数
+ * @return 命中的路由数（回调要求停止时为已回调的数量）
+ */
+size_t mqtt_topic_router_match(const mqtt_topic_router_t *router,
+                               const char *topic, size_t topic_len,
+                               mqtt_topic_match_cb_t cb, void *arg);
+
+/**
+ * @brief 获取路由表规模
+ * @param router 路由表
+ * @param nodes  输出节点数（可为 NULL）
+ * @param routes 输出路由数（可为 NULL）
+ */
+void mqtt_topic_router_get_size(const mqtt_topic_router_t *router, size_t *nodes, size_t *routes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MQTT_TOPIC_ROUTER_H */
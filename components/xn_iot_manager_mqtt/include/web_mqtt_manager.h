@@ -15,13 +15,12 @@
 #include "esp_err.h"           ///< ESP-IDF 通用错误码定义
 
 /**
- * @brief Web MQTT 管理器内部状态机单步运行周期（单位：ms）
+ * @brief 断线重连的首次退避上界（单位：ms）
  *
- * 管理任务会按该间隔周期性驱动内部状态机：
- * - 间隔过小：状态刷新更及时，但占用更多 CPU；
- * - 间隔过大：重连 / 心跳响应会变慢。
+ * 管理任务不再周期唤醒：断开 / 连接失败后按指数退避（加抖动）启动单次定时器，
+ * 上界从该值起每次翻倍，直到 reconnect_interval_ms；网络（IP）恢复时退避清零并立即重连。
  */
-#define WEB_MQTT_MANAGER_STEP_INTERVAL_MS 5000 ///< 默认状态机运行间隔（ms）
+#define WEB_MQTT_MANAGER_RECONNECT_BASE_MS 500 ///< 首次重连退避上界（ms）
 
 /**
  * @brief Web MQTT 管理器状态
@@ -76,8 +75,7 @@ typedef struct {
     const char          *password;              ///< MQTT 密码，可为 NULL 表示无密码
     const char          *base_topic;            ///< Web 管理相关的基础 Topic 前缀，如 "xn/web"
     int                  keepalive_sec;         ///< MQTT keepalive 保活时间（秒），<=0 使用组件默认值
-    int                  reconnect_interval_ms; ///< 连接失败后自动重连间隔；<0 表示关闭自动重连
-    int                  step_interval_ms;      ///< 状态机运行周期（ms），<=0 使用 WEB_MQTT_MANAGER_STEP_INTERVAL_MS
+    int                  reconnect_interval_ms; ///< 重连退避上界的上限（ms）；<0 表示关闭自动重连
     web_mqtt_event_cb_t  event_cb;              ///< 状态及重要事件回调，可为 NULL 表示不关心
 } web_mqtt_manager_config_t;
 
@@ -101,8 +99,7 @@ typedef struct {
         .password              = WEB_MQTT_DEFAULT_PASSWORD,            \
         .base_topic            = NULL,                                 \
         .keepalive_sec         = 60,                                   \
-        .reconnect_interval_ms = 5000,                                 \
-        .step_interval_ms      = WEB_MQTT_MANAGER_STEP_INTERVAL_MS,    \
+        .reconnect_interval_ms = 30000,                                \
         .event_cb              = NULL,                                 \
     }
 
@@ -111,7 +108,7 @@ typedef struct {
  *
  * 功能概览：
  * - 初始化内部 MQTT 客户端及相关资源；
- * - 创建管理任务并启动内部状态机；
+ * - 创建管理任务并启动内部状态机（由 MQTT 事件、联网监督事件和退避定时器唤醒）；
  * - 根据配置自动尝试与服务器建立连接。
  *
  * @note 调用前应确保 WiFi / 以太网 已经就绪并具备网络连接。
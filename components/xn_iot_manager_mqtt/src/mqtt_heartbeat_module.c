@@ -21,6 +21,7 @@
 #include "esp_log.h"
 
 #include "mqtt_module.h"
+#include "mqtt_outbox.h"
 #include "mqtt_reg_module.h"
 #include "mqtt_heartbeat_module.h"
 
@@ -72,11 +73,13 @@ static void mqtt_hb_task(void *arg)
         ESP_LOGI(TAG, "send heartbeat, id=%s, topic=%s", ///< 打印日志
                  device_id, topic);                ///< 设备 ID 与 Topic
 
-        (void)mqtt_module_publish(topic,           ///< 心跳 Topic
+        (void)mqtt_outbox_publish(topic,           ///< 心跳 Topic
                                    device_id,      ///< 负载为设备 ID
                                    (int)strlen(device_id), ///< 负载长度
                                    1,              ///< QoS 1 示例
-                                   false);         ///< 不保留
+                                   false,          ///< 不保留
+                                   MQTT_OUTBOX_PRIO_LOW, ///< 心跳可延后
+                                   "hb");          ///< 积压时只发最新一次
     }
 }
 
@@ -33,6 +33,7 @@ static const char *TAG = "mqtt_module";           ///< 本模块日志 TAG
 static mqtt_module_config_t   s_mqtt_cfg;          ///< 保存一份配置副本
 static bool                   s_mqtt_inited = false; ///< 是否已初始化
 static esp_mqtt_client_handle_t s_mqtt_client = NULL; ///< MQTT 客户端句柄
+static bool                   s_mqtt_started = false; ///< 客户端是否已启动
 
 /**
  * @brief 内部辅助：统一分发事件到上层回调
@@ -134,6 +135,9 @@ esp_err_t mqtt_module_init(const mqtt_module_config_t *config)
         mqtt_cfg.session.keepalive = (uint16_t)s_mqtt_cfg.keepalive_sec; ///< 使用该值
     }
 
+    /* 重连交给上层退避策略时关闭内置的固定间隔重连 */
+    mqtt_cfg.network.disable_auto_reconnect = s_mqtt_cfg.disable_auto_reconnect;
+
     /* 创建 MQTT 客户端实例 */
     s_mqtt_client = esp_mqtt_client_init(&mqtt_cfg); ///< 初始化客户端
     if (s_mqtt_client == NULL) {                    ///< 创建失败
@@ -174,6 +178,7 @@ esp_err_t mqtt_module_start(void)
         return ret;                                 ///< 返回错误
     }
 
+    s_mqtt_started = true;                          ///< 标记已启动
     return ESP_OK;                                  ///< 返回成功
 }
 
@@ -191,9 +196,33 @@ esp_err_t mqtt_module_stop(void)
         return ret;                                 ///< 返回错误
     }
 
+    s_mqtt_started = false;                         ///< 标记已停止
     return ESP_OK;                                  ///< 返回成功
 }
 
+esp_err_t mqtt_module_reconnect(void)
+{
+    if (!s_mqtt_inited || s_mqtt_client == NULL) {  ///< 未初始化或无客户端
+        return ESP_ERR_INVALID_STATE;               ///< 返回状态错误
+    }
+
+    if (!s_mqtt_started) {                          ///< 尚未启动
+        return mqtt_module_start();                 ///< 首次启动即连接
+    }
+
+    /* 客户端在等待重连时立即唤醒；不在等待状态（正在连接或内部任务已退出）时返回失败 */
+    if (esp_mqtt_client_reconnect(s_mqtt_client) == ESP_OK) {
+        return ESP_OK;                              ///< 已触发重连
+    }
+
+    /* 关闭内置重连的旧版 esp-mqtt 断开后会退出内部任务，此时需要重新启动 */
+    if (esp_mqtt_client_start(s_mqtt_client) == ESP_OK) {
+        return ESP_OK;                              ///< 重新启动成功
+    }
+
+    return ESP_FAIL;                                ///< 正在连接中
+}
+
 esp_err_t mqtt_module_publish(const char *topic,
                               const void *payload,
                               int         len,
@@ -0,0 +1,783 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-07 14:05:31
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-07 14:05:31
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_iot_manager_mqtt\src\mqtt_outbox.c
+ * @Description: MQTT 上行发件箱实现
+ *
+ * 内存部分：
+ *  - MQTT_OUTBOX_SLOTS 个固定槽位（PSRAM），用下标组成空闲链表、各优先级队列和待落盘队列；
+ *  - 入队：临界区内摘一个空闲槽 -> 临界区外拷贝 -> 临界区内挂入队列（或原位替换同键消息）；
+ *  - 合并键经直接映射表定位到队列中的槽位，冲突时只是不合并，不影响正确性。
+ *
+ * 分区部分（循环日志）：
+ *  - 记录按写入顺序追加，记录不跨扇区，写到扇区末尾换到下一扇区并先擦除，扇区依次轮转，磨损均匀；
+ *  - 记录头带序号与 CRC，补发成功后把 state 字节从 VALID 改写为 CONSUMED（只把 1 改为 0，无需擦除）；
+ *  - 启动时扫描全部扇区，按最大序号恢复写位置，按最小未消费序号恢复补发位置；
+ *  - 分区写满时覆盖最旧扇区，其中未补发的记录计入 spill_lost。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+#include "mqtt_module.h"
+#include "mqtt_outbox.h"
+
+static const char *TAG = "mqtt_outbox";            ///< 本模块日志 TAG
+
+#define OUTBOX_NONE             (-1)               ///< 空下标
+#define OUTBOX_LIST_SPILL       MQTT_OUTBOX_PRIO_MAX ///< 待落盘队列编号（排在各优先级之后）
+#define OUTBOX_LIST_NUM         (MQTT_OUTBOX_PRIO_MAX + 1)
+#define OUTBOX_LIST_DETACHED    0xFF               ///< 槽位不在任何队列中
+
+#define OUTBOX_SECTOR_SIZE      4096               ///< 分区擦除单位
+#define OUTBOX_REC_MAGIC        0x424F             ///< 记录魔数 "OB"
+#define OUTBOX_REC_VALID        0xFE               ///< 记录有效、未补发
+#define OUTBOX_REC_CONSUMED     0xFC               ///< 记录已补发
+#define OUTBOX_REC_ALIGN(n)     (((n) + 3u) & ~3u)
+
+#define OUTBOX_TASK_STACK       4096               ///< 发件任务栈（内部 RAM，写 flash 时须可访问）
+#define OUTBOX_TASK_PRIO        (tskIDLE_PRIORITY + 2)
+
+/* 内存槽位 */
+typedef struct {
+    int16_t  prev;                                 ///< 队列前一项
+    int16_t  next;                                 ///< 队列后一项 / 空闲链表下一项
+    uint8_t  list;                                 ///< 所在队列
+    uint8_t  qos;                                  ///< QoS 等级
+    bool     retain;                               ///< 是否保留
+    uint16_t topic_len;                            ///< Topic 长度（不含结束符）
+    uint16_t payload_len;                          ///< 负载长度
+    char     key[MQTT_OUTBOX_KEY_MAX];             ///< 合并键，空串表示不合并
+    char     data[MQTT_OUTBOX_SLOT_DATA];          ///< Topic + '\0' + 负载
+} outbox_slot_t;
+
+/* 分区记录头（16 字节），之后紧跟 Topic（无结束符）与负载 */
+typedef struct __attribute__((packed)) {
+    uint16_t magic;                                ///< OUTBOX_REC_MAGIC
+    uint8_t  state;                                ///< OUTBOX_REC_VALID / OUTBOX_REC_CONSUMED
+    uint8_t  flags;                                ///< bit0-1 QoS, bit2 retain
+    uint16_t topic_len;                            ///< Topic 长度
+    uint16_t payload_len;                          ///< 负载长度
+    uint32_t seq;                                  ///< 写入序号
+    uint32_t crc;                                  ///< flags..seq 与数据的 CRC32
+} outbox_rec_t;
+
+/* 分区循环日志状态（只在发件任务中访问，初始化除外） */
+typedef struct {
+    const esp_partition_t *part;                   ///< 分区，NULL 表示不落盘
+    uint32_t head;                                 ///< 下一条记录写入位置
+    uint32_t tail;                                 ///< 最旧的未补发记录位置
+    uint32_t seq;                                  ///< 下一条记录序号
+} outbox_ring_t;
+
+static outbox_slot_t       *s_slots = NULL;        ///< 槽位数组
+static int16_t              s_free  = OUTBOX_NONE; ///< 空闲链表头
+static int16_t              s_head[OUTBOX_LIST_NUM]; ///< 各队列头
+static int16_t              s_tail[OUTBOX_LIST_NUM]; ///< 各队列尾
+static int16_t              s_bucket[MQTT_OUTBOX_KEY_BUCKETS]; ///< 合并键 -> 槽位
+static mqtt_outbox_stats_t  s_stats;               ///< 统计（受 s_lock 保护）
+static portMUX_TYPE         s_lock  = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t         s_task  = NULL;        ///< 发件任务
+static bool                 s_online = false;      ///< 是否已连接（原子读写）
+static outbox_ring_t        s_ring;                ///< 分区循环日志
+static uint8_t              s_rec_buf[sizeof(outbox_rec_t) + MQTT_OUTBOX_SLOT_DATA]; ///< 记录读写缓冲（内部 RAM）
+
+/* -------------------------------------------------------------------------- */
+/*                                  内存队列                                   */
+/* -------------------------------------------------------------------------- */
+
+static uint32_t outbox_key_bucket(const char *key)
+{
+    uint32_t h = 2166136261u;                      ///< FNV-1a
+    while (*key) {
+        h = (h ^ (uint8_t)*key++) * 16777619u;
+    }
+    return h & (MQTT_OUTBOX_KEY_BUCKETS - 1);
+}
+
+/* 以下链表操作均须在 s_lock 内调用 */
+static void outbox_list_append(int16_t idx, uint8_t list)
+{
+    outbox_slot_t *s = &s_slots[idx];
+    s->list = list;
+    s->next = OUTBOX_NONE;
+    s->prev = s_tail[list];
+    if (s_tail[list] != OUTBOX_NONE) {
+        s_slots[s_tail[list]].next = idx;
+    } else {
+        s_head[list] = idx;
+    }
+    s_tail[list] = idx;
+}
+
+static void outbox_list_prepend(int16_t idx, uint8_t list)
+{
+    outbox_slot_t *s = &s_slots[idx];
+    s->list = list;
+    s->prev = OUTBOX_NONE;
+    s->next = s_head[list];
+    if (s_head[list] != OUTBOX_NONE) {
+        s_slots[s_head[list]].prev = idx;
+    } else {
+        s_tail[list] = idx;
+    }
+    s_head[list] = idx;
+}
+
+static void outbox_list_remove(int16_t idx)
+{
+    outbox_slot_t *s = &s_slots[idx];
+    uint8_t list = s->list;
+    if (s->prev != OUTBOX_NONE) {
+        s_slots[s->prev].next = s->next;
+    } else {
+        s_head[list] = s->next;
+    }
+    if (s->next != OUTBOX_NONE) {
+        s_slots[s->next].prev = s->prev;
+    } else {
+        s_tail[list] = s->prev;
+    }
+    s->list = OUTBOX_LIST_DETACHED;
+}
+
+/* 让 idx 顶替 old 在队列中的位置（同一队列，保持原有发送顺序） */
+static void outbox_list_replace(int16_t old, int16_t idx)
+{
+    outbox_slot_t *o = &s_slots[old];
+    outbox_slot_t *s = &s_slots[idx];
+    uint8_t list = o->list;
+
+    s->list = list;
+    s->prev = o->prev;
+    s->next = o->next;
+    if (o->prev != OUTBOX_NONE) {
+        s_slots[o->prev].next = idx;
+    } else {
+        s_head[list] = idx;
+    }
+    if (o->next != OUTBOX_NONE) {
+        s_slots[o->next].prev = idx;
+    } else {
+        s_tail[list] = idx;
+    }
+    o->list = OUTBOX_LIST_DETACHED;
+}
+
+static void outbox_slot_free(int16_t idx)
+{
+    s_slots[idx].list = OUTBOX_LIST_DETACHED;
+    s_slots[idx].next = s_free;
+    s_free = idx;
+}
+
+/* 查找队列中与 key 相同的槽位 */
+static int16_t outbox_key_find(const char *key, uint32_t bucket)
+{
+    int16_t old = s_bucket[bucket];
+    if (old == OUTBOX_NONE || s_slots[old].list == OUTBOX_LIST_DETACHED ||
+        strcmp(s_slots[old].key, key) != 0) {
+        return OUTBOX_NONE;
+    }
+    return old;
+}
+
+/**
+ * @brief 挂入队列（含合并），须在 s_lock 内调用
+ */
+static void outbox_queue_locked(int16_t idx, uint8_t list)
+{
+    outbox_slot_t *s = &s_slots[idx];
+
+    if (s->key[0] != '\0') {
+        uint32_t b = outbox_key_bucket(s->key);
+        int16_t old = outbox_key_find(s->key, b);
+        s_bucket[b] = idx;
+        if (old != OUTBOX_NONE) {                  ///< 最新值生效
+            if (s_slots[old].list == list) {
+                outbox_list_replace(old, idx);     ///< 沿用旧消息的排队位置
+            } else {
+                outbox_list_remove(old);
+                outbox_list_append(idx, list);
+            }
+            outbox_slot_free(old);
+            s_stats.coalesced++;
+            return;
+        }
+    }
+
+    outbox_list_append(idx, list);
+    s_stats.depth++;
+    if (s_stats.depth > s_stats.depth_peak) {
+        s_stats.depth_peak = s_stats.depth;
+    }
+}
+
+/**
+ * @brief 从指定队列取出队首（不在 s_lock 内调用）
+ */
+static int16_t outbox_pop(uint8_t list)
+{
+    portENTER_CRITICAL(&s_lock);
+    int16_t idx = s_head[list];
+    if (idx != OUTBOX_NONE) {
+        outbox_list_remove(idx);
+        if (s_slots[idx].key[0] != '\0') {
+            uint32_t b = outbox_key_bucket(s_slots[idx].key);
+            if (s_bucket[b] == idx) {
+                s_bucket[b] = OUTBOX_NONE;
+            }
+        }
+        s_stats.depth--;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return idx;
+}
+
+/**
+ * @brief 发送失败时放回队首；期间已有同键新消息入队则直接丢弃旧消息
+ */
+static void outbox_push_back(int16_t idx, uint8_t list)
+{
+    portENTER_CRITICAL(&s_lock);
+    outbox_slot_t *s = &s_slots[idx];
+    if (s->key[0] != '\0') {
+        uint32_t b = outbox_key_bucket(s->key);
+        if (outbox_key_find(s->key, b) != OUTBOX_NONE) {
+            outbox_slot_free(idx);
+            s_stats.coalesced++;
+            portEXIT_CRITICAL(&s_lock);
+            return;
+        }
+        s_bucket[b] = idx;
+    }
+    outbox_list_prepend(idx, list);
+    s_stats.depth++;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void outbox_release(int16_t idx)
+{
+    portENTER_CRITICAL(&s_lock);
+    outbox_slot_free(idx);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                分区循环日志                                 */
+/* -------------------------------------------------------------------------- */
+
+static uint32_t outbox_rec_crc(const outbox_rec_t *rec, const uint8_t *data, size_t len)
+{
+    uint32_t crc = esp_rom_crc32_le(0, &rec->flags, 9); ///< flags + topic_len + payload_len + seq
+    return esp_rom_crc32_le(crc, data, len);
+}
+
+static uint32_t outbox_sector_next(uint32_t off)
+{
+    uint32_t next = (off / OUTBOX_SECTOR_SIZE + 1) * OUTBOX_SECTOR_SIZE;
+    return next >= s_ring.part->size ? 0 : next;
+}
+
+/**
+ * @brief 读取并校验 off 处的记录头
+ * @return 记录总长度（对齐后），0 表示此处没有记录（扇区剩余部分为空或损坏）
+ */
+static uint32_t outbox_rec_read(uint32_t off, outbox_rec_t *rec)
+{
+    uint32_t sec_end = (off / OUTBOX_SECTOR_SIZE + 1) * OUTBOX_SECTOR_SIZE;
+    if (off + sizeof(outbox_rec_t) > sec_end ||
+        esp_partition_read(s_ring.part, off, rec, sizeof(*rec)) != ESP_OK ||
+        rec->magic != OUTBOX_REC_MAGIC) {
+        return 0;
+    }
+    uint32_t size = OUTBOX_REC_ALIGN(sizeof(outbox_rec_t) + rec->topic_len + rec->payload_len);
+    if (rec->topic_len + rec->payload_len + 1u > MQTT_OUTBOX_SLOT_DATA || off + size > sec_end) {
+        return 0;
+    }
+    return size;
+}
+
+/* 校验记录数据 CRC（数据读入 s_rec_buf） */
+static bool outbox_rec_check(uint32_t off, const outbox_rec_t *rec)
+{
+    size_t len = rec->topic_len + rec->payload_len;
+    if (esp_partition_read(s_ring.part, off + sizeof(*rec), s_rec_buf, len) != ESP_OK) {
+        return false;
+    }
+    return outbox_rec_crc(rec, s_rec_buf, len) == rec->crc;
+}
+
+/**
+ * @brief 启动时扫描分区，恢复写位置、补发位置与待补发数量
+ */
+static void outbox_ring_scan(void)
+{
+    bool     found = false;
+    uint32_t max_seq = 0, min_seq = 0;
+    uint32_t pending = 0;
+
+    s_ring.head = 0;
+    s_ring.tail = 0;
+    for (uint32_t sec = 0; sec < s_ring.part->size; sec += OUTBOX_SECTOR_SIZE) {
+        uint32_t off = sec;
+        outbox_rec_t rec;
+        uint32_t size;
+        while ((size = outbox_rec_read(off, &rec)) != 0) {
+            if (!found || (int32_t)(rec.seq - max_seq) > 0) {
+                max_seq = rec.seq;
+                s_ring.head = off + size;
+                found = true;
+            }
+            if (rec.state == OUTBOX_REC_VALID && outbox_rec_check(off, &rec)) {
+                if (pending == 0 || (int32_t)(rec.seq - min_seq) < 0) {
+                    min_seq = rec.seq;
+                    s_ring.tail = off;
+                }
+                pending++;
+            }
+            off += size;
+        }
+    }
+
+    if (s_ring.head >= s_ring.part->size) {
+        s_ring.head = 0;
+    }
+    s_ring.seq = found ? max_seq + 1 : 1;
+    if (pending == 0) {
+        s_ring.tail = s_ring.head;
+    }
+    s_stats.flash_pending = pending;
+}
+
+/**
+ * @brief 即将写入新扇区：统计其中未补发的记录，然后擦除
+ */
+static esp_err_t outbox_ring_enter_sector(uint32_t sec)
+{
+    uint32_t lost = 0;
+    uint32_t off = sec;
+    outbox_rec_t rec;
+    uint32_t size;
+    while ((size = outbox_rec_read(off, &rec)) != 0) {
+        if (rec.state == OUTBOX_REC_VALID) {
+            lost++;
+        }
+        off += size;
+    }
+
+    esp_err_t ret = esp_partition_erase_range(s_ring.part, sec, OUTBOX_SECTOR_SIZE);
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.flash_erases++;
+    if (lost > 0) {                                ///< 覆盖了最旧的未补发记录
+        s_stats.spill_lost += lost;
+        s_stats.flash_pending = s_stats.flash_pending > lost ? s_stats.flash_pending - lost : 0;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (lost > 0 && s_ring.tail / OUTBOX_SECTOR_SIZE == sec / OUTBOX_SECTOR_SIZE) {
+        s_ring.tail = outbox_sector_next(sec);     ///< 补发从下一个最旧的扇区开始
+        ESP_LOGW(TAG, "⚠️ 离线分区已满，覆盖 %u 条未补发消息", (unsigned)lost);
+    }
+    return ret;
+}
+
+/**
+ * @brief 把一个槽位的消息追加到分区
+ */
+static esp_err_t outbox_ring_append(const outbox_slot_t *s)
+{
+    outbox_rec_t *rec = (outbox_rec_t *)s_rec_buf;
+    uint8_t *data = s_rec_buf + sizeof(outbox_rec_t);
+    uint32_t len = (uint32_t)s->topic_len + s->payload_len;
+    uint32_t size = OUTBOX_REC_ALIGN(sizeof(outbox_rec_t) + len);
+
+    uint32_t sec_end = (s_ring.head / OUTBOX_SECTOR_SIZE + 1) * OUTBOX_SECTOR_SIZE;
+    if (s_ring.head + size > sec_end) {            ///< 记录不跨扇区
+        s_ring.head = sec_end >= s_ring.part->size ? 0 : sec_end;
+    }
+    if (s_ring.head % OUTBOX_SECTOR_SIZE == 0) {   ///< 进入新扇区，先擦除
+        esp_err_t ret = outbox_ring_enter_sector(s_ring.head);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    memcpy(data, s->data, s->topic_len);           ///< Topic 不存结束符
+    memcpy(data + s->topic_len, s->data + s->topic_len + 1, s->payload_len);
+    memset(data + len, 0xFF, size - sizeof(outbox_rec_t) - len);
+
+    rec->magic       = OUTBOX_REC_MAGIC;
+    rec->state       = OUTBOX_REC_VALID;
+    rec->flags       = (uint8_t)((s->qos & 0x03) | (s->retain ? 0x04 : 0));
+    rec->topic_len   = s->topic_len;
+    rec->payload_len = s->payload_len;
+    rec->seq         = s_ring.seq;
+    rec->crc         = outbox_rec_crc(rec, data, len);
+
+    esp_err_t ret = esp_partition_write(s_ring.part, s_ring.head, s_rec_buf, size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    bool first = false;
+    portENTER_CRITICAL(&s_lock);
+    first = (s_stats.flash_pending == 0);
+    s_stats.flash_pending++;
+    s_stats.spilled++;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (first) {
+        s_ring.tail = s_ring.head;
+    }
+    s_ring.seq++;
+    s_ring.head += size;
+    if (s_ring.head >= s_ring.part->size) {
+        s_ring.head = 0;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 按写入顺序补发分区中的消息
+ * @return true 全部补发完成, false 中途断线或发送失败
+ */
+static bool outbox_ring_replay(void)
+{
+    int64_t  start = esp_timer_get_time();
+    uint32_t sent = 0;
+    uint32_t off = s_ring.tail;
+    uint32_t guard = s_ring.part->size / sizeof(outbox_rec_t); ///< 防止异常数据导致死循环
+    bool     done = true;
+
+    while (off != s_ring.head && guard-- > 0) {
+        if (!__atomic_load_n(&s_online, __ATOMIC_ACQUIRE)) {
+            done = false;
+            break;
+        }
+
+        outbox_rec_t rec;
+        uint32_t size = outbox_rec_read(off, &rec);
+        if (size == 0) {                           ///< 本扇区后面没有记录
+            off = outbox_sector_next(off);
+            continue;
+        }
+        if (rec.state != OUTBOX_REC_VALID || !outbox_rec_check(off, &rec)) {
+            off += size;
+            continue;
+        }
+
+        /* s_rec_buf 中是 Topic + 负载，给 Topic 补结束符 */
+        char *topic = (char *)s_rec_buf;
+        memmove(s_rec_buf + rec.topic_len + 1, s_rec_buf + rec.topic_len, rec.payload_len);
+        topic[rec.topic_len] = '\0';
+        if (mqtt_module_publish(topic, s_rec_buf + rec.topic_len + 1, rec.payload_len,
+                                rec.flags & 0x03, (rec.flags & 0x04) != 0) != ESP_OK) {
+            done = false;
+            break;
+        }
+
+        uint8_t consumed = OUTBOX_REC_CONSUMED;
+        (void)esp_partition_write(s_ring.part, off + offsetof(outbox_rec_t, state), &consumed, 1);
+        sent++;
+        portENTER_CRITICAL(&s_lock);
+        s_stats.replayed++;
+        if (s_stats.flash_pending > 0) {
+            s_stats.flash_pending--;
+        }
+        portEXIT_CRITICAL(&s_lock);
+        off += size;
+    }
+
+    s_ring.tail = off;
+    if (sent > 0) {
+        uint32_t ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+        portENTER_CRITICAL(&s_lock);
+        s_stats.replay_ms = ms;
+        portEXIT_CRITICAL(&s_lock);
+        ESP_LOGI(TAG, "📤 补发离线消息 %u 条，耗时 %u ms", (unsigned)sent, (unsigned)ms);
+    }
+    if (done) {
+        portENTER_CRITICAL(&s_lock);
+        s_stats.flash_pending = 0;                 ///< 走到写位置即全部补发（含校验失败跳过的）
+        portEXIT_CRITICAL(&s_lock);
+    }
+    return done;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  发件任务                                   */
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief 断线时把各优先级队列中尚未发出的可靠消息移入待落盘队列
+ */
+static void outbox_collect_spill(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    for (uint8_t list = 0; list < MQTT_OUTBOX_PRIO_MAX; list++) {
+        int16_t idx = s_head[list];
+        while (idx != OUTBOX_NONE) {
+            int16_t next = s_slots[idx].next;
+            if (s_slots[idx].qos >= 1 && s_slots[idx].key[0] == '\0') {
+                outbox_list_remove(idx);
+                outbox_list_append(idx, OUTBOX_LIST_SPILL);
+            }
+            idx = next;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/**
+ * @brief 离线时把待落盘队列写入分区
+ */
+static void outbox_spill(void)
+{
+    int16_t idx;
+    while ((idx = outbox_pop(OUTBOX_LIST_SPILL)) != OUTBOX_NONE) {
+        esp_err_t ret = outbox_ring_append(&s_slots[idx]);
+        if (ret != ESP_OK) {                       ///< 写失败，留在内存中等重连
+            ESP_LOGE(TAG, "写离线分区失败: %s", esp_err_to_name(ret));
+            outbox_push_back(idx, OUTBOX_LIST_SPILL);
+            return;
+        }
+        outbox_release(idx);
+    }
+}
+
+/**
+ * @brief 在线时发送一个队列
+ * @return true 队列已发空, false 断线或发送失败
+ */
+static bool outbox_drain_list(uint8_t list)
+{
+    int16_t idx;
+    while (__atomic_load_n(&s_online, __ATOMIC_ACQUIRE) &&
+           (idx = outbox_pop(list)) != OUTBOX_NONE) {
+        outbox_slot_t *s = &s_slots[idx];
+        if (mqtt_module_publish(s->data, s->data + s->topic_len + 1, s->payload_len,
+                                s->qos, s->retain) != ESP_OK) {
+            outbox_push_back(idx, list);
+            return false;
+        }
+        outbox_release(idx);
+        portENTER_CRITICAL(&s_lock);
+        s_stats.sent++;
+        portEXIT_CRITICAL(&s_lock);
+    }
+    return __atomic_load_n(&s_online, __ATOMIC_ACQUIRE);
+}
+
+static void outbox_report(void)
+{
+    mqtt_outbox_stats_t st;
+    (void)mqtt_outbox_get_stats(&st, true);
+    if (st.enqueued == 0 && st.replayed == 0 && st.flash_pending == 0) {
+        return;
+    }
+    ESP_LOGI(TAG, "📊 入队 %u 合并 %u 发送 %u 丢弃 %u | 深度 %u 峰值 %u | 落盘 %u 覆盖 %u 补发 %u (%u ms) 待补发 %u 擦除 %u",
+             (unsigned)st.enqueued, (unsigned)st.coalesced, (unsigned)st.sent, (unsigned)st.dropped,
+             (unsigned)st.depth, (unsigned)st.depth_peak,
+             (unsigned)st.spilled, (unsigned)st.spill_lost, (unsigned)st.replayed,
+             (unsigned)st.replay_ms, (unsigned)st.flash_pending, (unsigned)st.flash_erases);
+}
+
+static void outbox_task(void *arg)
+{
+    (void)arg;
+    /* 先发离线期间入队、尚未落盘的消息，再按优先级由高到低 */
+    static const uint8_t drain_order[] = {
+        OUTBOX_LIST_SPILL, MQTT_OUTBOX_PRIO_HIGH, MQTT_OUTBOX_PRIO_NORMAL, MQTT_OUTBOX_PRIO_LOW,
+    };
+    int64_t next_report = esp_timer_get_time() + (int64_t)MQTT_OUTBOX_REPORT_MS * 1000;
+    bool retry = false;
+
+    for (;;) {
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(retry ? MQTT_OUTBOX_RETRY_MS : MQTT_OUTBOX_REPORT_MS));
+        retry = false;
+
+        if (!__atomic_load_n(&s_online, __ATOMIC_ACQUIRE)) {
+            if (s_ring.part != NULL) {
+                outbox_collect_spill();
+                outbox_spill();
+            }
+        } else {
+            if (s_ring.part != NULL && s_ring.tail != s_ring.head && !outbox_ring_replay()) {
+                retry = true;
+            }
+            for (size_t i = 0; !retry && i < sizeof(drain_order); i++) {
+                if (!outbox_drain_list(drain_order[i])) {
+                    retry = true;                  ///< 断线时由 set_online 唤醒，重试只在发送失败时生效
+                }
+            }
+        }
+
+        int64_t now = esp_timer_get_time();
+        if (now >= next_report) {
+            next_report = now + (int64_t)MQTT_OUTBOX_REPORT_MS * 1000;
+            outbox_report();
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  对外接口                                   */
+/* -------------------------------------------------------------------------- */
+
+esp_err_t mqtt_outbox_init(void)
+{
+    if (s_task != NULL) {
+        return ESP_OK;
+    }
+
+    s_slots = heap_caps_calloc(MQTT_OUTBOX_SLOTS, sizeof(outbox_slot_t),
+                               MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (s_slots == NULL) {
+        s_slots = calloc(MQTT_OUTBOX_SLOTS, sizeof(outbox_slot_t));
+    }
+    if (s_slots == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int i = 0; i < OUTBOX_LIST_NUM; i++) {
+        s_head[i] = OUTBOX_NONE;
+        s_tail[i] = OUTBOX_NONE;
+    }
+    for (int i = 0; i < MQTT_OUTBOX_KEY_BUCKETS; i++) {
+        s_bucket[i] = OUTBOX_NONE;
+    }
+    s_free = OUTBOX_NONE;
+    for (int16_t i = MQTT_OUTBOX_SLOTS - 1; i >= 0; i--) {
+        outbox_slot_free(i);
+    }
+
+    s_ring.part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                           ESP_PARTITION_SUBTYPE_ANY,
+                                           MQTT_OUTBOX_PARTITION_LABEL);
+    if (s_ring.part != NULL && s_ring.part->size >= 2 * OUTBOX_SECTOR_SIZE) {
+        outbox_ring_scan();
+        ESP_LOGI(TAG, "离线分区 %u KB，待补发 %u 条",
+                 (unsigned)(s_ring.part->size / 1024), (unsigned)s_stats.flash_pending);
+    } else {
+        s_ring.part = NULL;
+        ESP_LOGI(TAG, "未配置离线分区，离线消息只保留在内存中");
+    }
+
+    if (xTaskCreate(outbox_task, "mqtt_outbox", OUTBOX_TASK_STACK, NULL,
+                    OUTBOX_TASK_PRIO, &s_task) != pdPASS) {
+        s_task = NULL;
+        heap_caps_free(s_slots);
+        s_slots = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t mqtt_outbox_publish(const char        *topic,
+                              const void        *payload,
+                              int                len,
+                              int                qos,
+                              bool               retain,
+                              mqtt_outbox_prio_t prio,
+                              const char        *coalesce_key)
+{
+    if (s_task == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (topic == NULL || topic[0] == '\0' || len < 0 || (len > 0 && payload == NULL) ||
+        qos < 0 || qos > 2 || prio >= MQTT_OUTBOX_PRIO_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t tlen = strlen(topic);
+    size_t klen = coalesce_key ? strlen(coalesce_key) : 0;
+    if (tlen + 1 + (size_t)len > MQTT_OUTBOX_SLOT_DATA || klen >= MQTT_OUTBOX_KEY_MAX) {
+        portENTER_CRITICAL(&s_lock);
+        s_stats.dropped++;
+        portEXIT_CRITICAL(&s_lock);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    int16_t idx = s_free;
+    if (idx != OUTBOX_NONE) {
+        s_free = s_slots[idx].next;
+    } else {
+        s_stats.dropped++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    if (idx == OUTBOX_NONE) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* 槽位已独占，在临界区外拷贝 */
+    outbox_slot_t *s = &s_slots[idx];
+    s->qos         = (uint8_t)qos;
+    s->retain      = retain;
+    s->topic_len   = (uint16_t)tlen;
+    s->payload_len = (uint16_t)len;
+    memcpy(s->key, coalesce_key ? coalesce_key : "", klen + 1);
+    memcpy(s->data, topic, tlen + 1);
+    if (len > 0) {
+        memcpy(s->data + tlen + 1, payload, (size_t)len);
+    }
+
+    /* 离线时可靠消息进入待落盘队列；合并键消息只需保留最新值，留在内存 */
+    bool spill = s_ring.part != NULL && qos >= 1 && klen == 0 &&
+                 !__atomic_load_n(&s_online, __ATOMIC_ACQUIRE);
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.enqueued++;
+    outbox_queue_locked(idx, spill ? OUTBOX_LIST_SPILL : (uint8_t)prio);
+    portEXIT_CRITICAL(&s_lock);
+
+    xTaskNotifyGive(s_task);
+    return ESP_OK;
+}
+
+void mqtt_outbox_set_online(bool online)
+{
+    __atomic_store_n(&s_online, online, __ATOMIC_RELEASE);
+    if (s_task != NULL) {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+esp_err_t mqtt_outbox_get_stats(mqtt_outbox_stats_t *stats, bool reset)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_task == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    if (reset) {
+        uint32_t depth = s_stats.depth;
+        uint32_t pending = s_stats.flash_pending;
+        memset(&s_stats, 0, sizeof(s_stats));
+        s_stats.depth = depth;
+        s_stats.depth_peak = depth;
+        s_stats.flash_pending = pending;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
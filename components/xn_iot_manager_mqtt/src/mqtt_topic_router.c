@@ -0,0 +1,325 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-07 09:40:12
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-07 09:40:12
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_iot_manager_mqtt\src\mqtt_topic_router.c
+ * @Description: MQTT Topic 路由表实现（层级前缀树 + 无锁匹配）
+ *
+ * 每个节点保存一个层级名，子节点分三类：
+ *  - children：精确层级（兄弟链表，按长度 + memcmp 比较）；
+ *  - plus    ：'+' 通配层；
+ *  - hash    ：'#' 通配层（只挂路由，没有子节点）。
+ * 新节点 / 新路由先完整初始化，再用 release 写入父节点指针，读取方 acquire 后即可安全访问。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mqtt_topic_router.h"
+
+#define ROUTER_LEVEL_MAX_LEN    0xFFFF          ///< 单个层级名最大长度
+
+/* 挂在节点上的一条路由 */
+typedef struct router_route {
+    struct router_route *next;                  ///< 同一节点的下一条路由（按注册顺序）
+    void                *target;                ///< 命中时回调的目标
+} router_route_t;
+
+/* 前缀树节点，对应 Topic 的一个层级 */
+typedef struct router_node {
+    struct router_node *sibling;                ///< 下一个精确兄弟节点
+    struct router_node *children;               ///< 精确子节点链表
+    struct router_node *plus;                   ///< '+' 子节点
+    struct router_node *hash;                   ///< '#' 子节点
+    router_route_t     *routes;                 ///< 过滤串恰好结束于本层的路由
+    uint16_t            level_len;              ///< 层级名长度
+    char                level[];                ///< 层级名（不含 '\0'）
+} router_node_t;
+
+struct mqtt_topic_router {
+    router_node_t root;                         ///< 根节点（不对应任何层级）
+    size_t        node_count;                   ///< 节点数（仅写者修改）
+    size_t        route_count;                  ///< 路由数（仅写者修改）
+};
+
+/* 匹配过程上下文 */
+typedef struct {
+    const router_node_t   *root;                ///< 根节点，用于 '$' 规则判断
+    bool                   sys_topic;           ///< Topic 是否以 '$' 开头
+    mqtt_topic_match_cb_t  cb;                  ///< 命中回调
+    void                  *arg;                 ///< 回调参数
+    size_t                 hits;                ///< 已命中数
+    bool                   stop;                ///< 回调要求停止
+} router_match_ctx_t;
+
+#define LOAD_PTR(p)         __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define PUBLISH_PTR(p, v)   __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+static router_node_t *router_node_new(const char *level, size_t len)
+{
+    router_node_t *node = calloc(1, sizeof(router_node_t) + len);
+    if (node == NULL) {
+        return NULL;
+    }
+    node->level_len = (uint16_t)len;
+    memcpy(node->level, level, len);
+    return node;
+}
+
+static void router_node_free(router_node_t *node);
+
+/**
+ * @brief 释放节点下的路由与全部子树（不释放节点本身）
+ */
+static void router_node_clear(router_node_t *node)
+{
+    router_route_t *route = node->routes;
+    while (route != NULL) {
+        router_route_t *next = route->next;
+        free(route);
+        route = next;
+    }
+
+    router_node_t *child = node->children;
+    while (child != NULL) {
+        router_node_t *next = child->sibling;
+        router_node_free(child);
+        child = next;
+    }
+
+    if (node->plus != NULL) {
+        router_node_free(node->plus);
+    }
+    if (node->hash != NULL) {
+        router_node_free(node->hash);
+    }
+}
+
+static void router_node_free(router_node_t *node)
+{
+    router_node_clear(node);
+    free(node);
+}
+
+/**
+ * @brief 检查过滤串是否符合 MQTT 通配符规则
+ */
+static bool router_filter_valid(const char *filter)
+{
+    const char *lvl = filter;
+
+    for (;;) {
+        const char *sep = strchr(lvl, '/');
+        size_t len = sep ? (size_t)(sep - lvl) : strlen(lvl);
+
+        if (len > ROUTER_LEVEL_MAX_LEN) {
+            return false;
+        }
+        for (size_t i = 0; i < len; i++) {
+            if ((lvl[i] == '+' || lvl[i] == '#') && len != 1) {
+                return false;                   ///< 通配符必须独占一层
+            }
+        }
+        if (len == 1 && lvl[0] == '#' && sep != NULL) {
+            return false;                       ///< '#' 只能是最后一层
+        }
+        if (sep == NULL) {
+            return true;
+        }
+        lvl = sep + 1;
+    }
+}
+
+/**
+ * @brief 在 parent 下查找或创建一层精确子节点
+ */
+static router_node_t *router_child_get(mqtt_topic_router_t *router, router_node_t *parent,
+                                       const char *level, size_t len)
+{
+    for (router_node_t *c = parent->children; c != NULL; c = c->sibling) {
+        if (c->level_len == len && memcmp(c->level, level, len) == 0) {
+            return c;
+        }
+    }
+
+    router_node_t *node = router_node_new(level, len);
+    if (node == NULL) {
+        return NULL;
+    }
+    node->sibling = parent->children;
+    PUBLISH_PTR(parent->children, node);        ///< 初始化完成后再挂到树上
+    router->node_count++;
+    return node;
+}
+
+/**
+ * @brief 查找或创建通配子节点（'+' / '#'）
+ */
+static router_node_t *router_wild_get(mqtt_topic_router_t *router, router_node_t **slot, char wild)
+{
+    if (*slot != NULL) {
+        return *slot;
+    }
+
+    router_node_t *node = router_node_new(&wild, 1);
+    if (node == NULL) {
+        return NULL;
+    }
+    PUBLISH_PTR(*slot, node);
+    router->node_count++;
+    return node;
+}
+
+mqtt_topic_router_t *mqtt_topic_router_create(void)
+{
+    return calloc(1, sizeof(mqtt_topic_router_t));
+}
+
+void mqtt_topic_router_destroy(mqtt_topic_router_t *router)
+{
+    if (router == NULL) {
+        return;
+    }
+
+    router_node_clear(&router->root);          ///< 根节点内嵌在路由表中
+    free(router);
+}
+
+esp_err_t mqtt_topic_router_add(mqtt_topic_router_t *router, const char *filter, void *target)
+{
+    if (router == NULL || filter == NULL || filter[0] == '\0' || target == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!router_filter_valid(filter)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    router_node_t *node = &router->root;
+    const char *lvl = filter;
+
+    for (;;) {
+        const char *sep = strchr(lvl, '/');
+        size_t len = sep ? (size_t)(sep - lvl) : strlen(lvl);
+
+        if (len == 1 && lvl[0] == '+') {
+            node = router_wild_get(router, &node->plus, '+');
+        } else if (len == 1 && lvl[0] == '#') {
+            node = router_wild_get(router, &node->hash, '#');
+        } else {
+            node = router_child_get(router, node, lvl, len);
+        }
+        if (node == NULL) {
+            return ESP_ERR_NO_MEM;              ///< 已创建的中间节点保留，不影响匹配结果
+        }
+        if (sep == NULL) {
+            break;
+        }
+        lvl = sep + 1;
+    }
+
+    router_route_t *route = calloc(1, sizeof(router_route_t));
+    if (route == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    route->target = target;
+
+    router_route_t **tail = &node->routes;      ///< 追加到末尾，保持注册顺序
+    while (*tail != NULL) {
+        tail = &(*tail)->next;
+    }
+    PUBLISH_PTR(*tail, route);
+    router->route_count++;
+    return ESP_OK;
+}
+
+/**
+ * @brief 回调节点上的全部路由
+ */
+static void router_emit(const router_node_t *node, router_match_ctx_t *ctx)
+{
+    for (router_route_t *r = LOAD_PTR(node->routes);
+         r != NULL && !ctx->stop;
+         r = LOAD_PTR(r->next)) {
+        ctx->hits++;
+        if (!ctx->cb(r->target, ctx->arg)) {
+            ctx->stop = true;
+        }
+    }
+}
+
+/**
+ * @brief 从 node 开始匹配剩余层级
+ * @param lvl  当前层级起点（done 为 true 时无意义）
+ * @param end  Topic 末尾
+ * @param done 是否已消耗完所有层级
+ */
+static void router_walk(const router_node_t *node, const char *lvl, const char *end,
+                        bool done, router_match_ctx_t *ctx)
+{
+    bool wild_ok = !(node == ctx->root && ctx->sys_topic); ///< '$' 开头的 Topic 不匹配首层通配符
+
+    router_node_t *hash = LOAD_PTR(node->hash);
+    if (hash != NULL && wild_ok) {
+        router_emit(hash, ctx);                 ///< "a/#" 同时匹配 "a" 及其下任意层
+    }
+
+    if (done) {
+        router_emit(node, ctx);
+        return;
+    }
+    if (ctx->stop) {
+        return;
+    }
+
+    const char *sep = memchr(lvl, '/', (size_t)(end - lvl));
+    size_t len = sep ? (size_t)(sep - lvl) : (size_t)(end - lvl);
+    const char *next = sep ? sep + 1 : end;
+    bool next_done = (sep == NULL);
+
+    for (router_node_t *c = LOAD_PTR(node->children); c != NULL; c = c->sibling) {
+        if (c->level_len == len && memcmp(c->level, lvl, len) == 0) {
+            router_walk(c, next, end, next_done, ctx);
+            break;
+        }
+    }
+    if (ctx->stop) {
+        return;
+    }
+
+    router_node_t *plus = LOAD_PTR(node->plus);
+    if (plus != NULL && wild_ok) {
+        router_walk(plus, next, end, next_done, ctx);
+    }
+}
+
+size_t mqtt_topic_router_match(const mqtt_topic_router_t *router,
+                               const char *topic, size_t topic_len,
+                               mqtt_topic_match_cb_t cb, void *arg)
+{
+    if (router == NULL || topic == NULL || topic_len == 0 || cb == NULL) {
+        return 0;
+    }
+
+    router_match_ctx_t ctx = {
+        .root      = &router->root,
+        .sys_topic = (topic[0] == '$'),
+        .cb        = cb,
+        .arg       = arg,
+    };
+    router_walk(&router->root, topic, topic + topic_len, false, &ctx);
+    return ctx.hits;
+}
+
+void mqtt_topic_router_get_size(const mqtt_topic_router_t *router, size_t *nodes, size_t *routes)
+{
+    if (nodes != NULL) {
+        *nodes = router ? __atomic_load_n(&router->node_count, __ATOMIC_RELAXED) : 0;
+    }
+    if (routes != NULL) {
+        *routes = router ? __atomic_load_n(&router->route_count, __ATOMIC_RELAXED) : 0;
+    }
+}
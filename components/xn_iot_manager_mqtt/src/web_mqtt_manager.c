@@ -12,6 +12,8 @@
  *  - 通过 web_mqtt_event_cb_t 回调向上层报告抽象状态变化。
  * 
  * 不直接处理业务 Topic，只关注“是否连上 MQTT 服务器”。
+ * 下行消息经 Topic 路由树（mqtt_topic_router）分发给已注册的应用模块，
+ * 模块可选择在 esp-mqtt 事件任务中同步处理，或使用独立的分发队列与工作任务。
  * 
  * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved. 
  */
@@ -19,18 +21,26 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 
 #include "esp_log.h"
 #include "esp_mac.h"
+#include "esp_timer.h"
 
 #include "mqtt_module.h"
 #include "mqtt_app_module.h"
+#include "mqtt_topic_router.h"
+#include "mqtt_outbox.h"
 #include "mqtt_reg_module.h"
 #include "mqtt_heartbeat_module.h"
 #include "web_mqtt_manager.h"
+#include "conn_supervisor.h"
+#include "conn_backoff.h"
 
 /* 日志 TAG */
 static const char *TAG = "web_mqtt_manager";       ///< 本模块日志 TAG
@@ -39,22 +49,45 @@ static const char *TAG = "web_mqtt_manager";       ///< 本模块日志 TAG
 static web_mqtt_manager_config_t s_mgr_cfg;        ///< 上层传入的管理配置副本
 static web_mqtt_state_t          s_mgr_state = WEB_MQTT_STATE_DISCONNECTED; ///< 当前状态
 static TaskHandle_t              s_mgr_task  = NULL; ///< 管理任务句柄
-static TickType_t                s_last_error_ts = 0; ///< 最近一次错误/断开的时间戳
+static conn_backoff_handle_t     s_backoff   = NULL; ///< 重连退避（单次定时器）
+static volatile bool             s_retry_due = false; ///< 退避到期 / 网络恢复，待管理任务重连
 
 /* 若上层未指定 client_id，则使用该缓冲区生成一个基于 MAC 的默认 ID */
 static char s_client_id_buf[32];
 
-/* 应用模块注册表配置 */
-#define WEB_MQTT_APP_MAX_NUM         8            ///< 支持的应用模块最大数量
-#define WEB_MQTT_APP_SUFFIX_MAX_LEN  16           ///< 单个模块前缀最大长度
+/* 应用模块注册表：堆上分配的单向链表，只追加不删除，读取方无需加锁 */
+typedef struct web_mqtt_app {
+    struct web_mqtt_app  *next;                 ///< 下一个模块（按注册顺序）
+    char                 *suffix;               ///< 模块 Topic 前缀
+    char                 *filter;               ///< 编译进路由树的订阅过滤串，未知 base_topic 时为 NULL
+    web_mqtt_app_msg_cb_t cb;                   ///< 模块消息回调（重复注册时原子更新）
+    QueueHandle_t         queue;                ///< 分发队列，NULL 表示同步回调
+    TaskHandle_t          task;                 ///< 工作任务
+    uint32_t              max_msg_size;         ///< 入队消息最大字节数
+    web_mqtt_app_stats_t  stats;                ///< 分发统计（原子读写）
+} web_mqtt_app_t;
+
+/* 入队消息：Topic 与负载连续存放在 data 中 */
+typedef struct {
+    int  topic_len;                             ///< Topic 长度
+    int  payload_len;                           ///< 负载长度
+    char data[];                                ///< Topic + 负载
+} web_mqtt_app_msg_t;
 
+/* 一次路由匹配的消息参数 */
 typedef struct {
-    char                  suffix[WEB_MQTT_APP_SUFFIX_MAX_LEN]; ///< 模块 Topic 前缀
-    web_mqtt_app_msg_cb_t cb;                   ///< 模块消息回调
-} web_mqtt_app_entry_t;
+    const char    *topic;                       ///< Topic 指针
+    int            topic_len;                   ///< Topic 长度
+    const uint8_t *payload;                     ///< 负载指针
+    int            payload_len;                 ///< 负载长度
+} web_mqtt_route_msg_t;
+
+#define WEB_MQTT_APP_DROP_LOG_EVERY  32           ///< 丢弃日志间隔（首次及每 N 次打印一次）
 
-static web_mqtt_app_entry_t s_app_entries[WEB_MQTT_APP_MAX_NUM]; ///< 模块表
-static int                  s_app_entry_count = 0; ///< 已注册模块数量
+static web_mqtt_app_t      *s_apps      = NULL;  ///< 模块链表头
+static SemaphoreHandle_t    s_app_lock  = NULL;  ///< 注册互斥锁（只保护写者）
+static mqtt_topic_router_t *s_router    = NULL;  ///< Topic 路由树
+static portMUX_TYPE         s_app_mux   = portMUX_INITIALIZER_UNLOCKED; ///< 首次创建注册表用
 
 /**
  * @brief 统一更新状态并通知上层回调
@@ -96,66 +129,285 @@ static void web_mqtt_manager_ensure_client_id(void)
 }
 
 /**
- * @brief 在 MQTT 已连接时，为所有已注册应用模块订阅 Topic
+ * @brief 确保注册表互斥锁与路由树已创建（可在管理器初始化前调用）
  */
-static void web_mqtt_manager_subscribe_all_apps(void)
+static esp_err_t web_mqtt_manager_apps_prepare(void)
 {
-    if (s_mgr_cfg.base_topic == NULL) {            ///< 未配置基础 Topic
-        return;                                    ///< 直接返回
+    if (__atomic_load_n(&s_app_lock, __ATOMIC_ACQUIRE) != NULL) { ///< 已创建
+        return ESP_OK;                             ///< 直接返回
     }
 
-    for (int i = 0; i < s_app_entry_count; ++i) {  ///< 遍历所有模块
-        char filter[256];                          ///< 订阅过滤字符串
-        snprintf(filter, sizeof(filter), "%s/%s/#", ///< base_topic/prefix/#
-                 s_mgr_cfg.base_topic,             ///< 基础 Topic
-                 s_app_entries[i].suffix);         ///< 模块前缀
+    SemaphoreHandle_t lock = xSemaphoreCreateMutex(); ///< 新建互斥锁
+    mqtt_topic_router_t *router = mqtt_topic_router_create(); ///< 新建路由树
+    if (lock == NULL || router == NULL) {          ///< 任一创建失败
+        if (lock) {
+            vSemaphoreDelete(lock);                ///< 释放已创建的锁
+        }
+        mqtt_topic_router_destroy(router);         ///< 释放已创建的路由树
+        return ESP_ERR_NO_MEM;                     ///< 返回内存不足
+    }
 
-        (void)mqtt_module_subscribe(filter, 1);    ///< 订阅，忽略返回值
+    bool used = false;                             ///< 是否由本次调用完成创建
+    portENTER_CRITICAL(&s_app_mux);                ///< 防止并发首次注册
+    if (s_app_lock == NULL) {
+        s_router = router;                         ///< 先发布路由树
+        __atomic_store_n(&s_app_lock, lock, __ATOMIC_RELEASE); ///< 再发布锁
+        used = true;
+    }
+    portEXIT_CRITICAL(&s_app_mux);
+
+    if (!used) {                                   ///< 其他任务已抢先创建
+        vSemaphoreDelete(lock);
+        mqtt_topic_router_destroy(router);
+    }
+    return ESP_OK;                                 ///< 返回成功
+}
+
+/**
+ * @brief 把模块的订阅过滤串编译进路由树（调用方持有 s_app_lock）
+ *
+ * 过滤串为 base_topic/suffix/#，suffix 以 "#" 结尾时不再追加。
+ */
+static esp_err_t web_mqtt_manager_app_compile(web_mqtt_app_t *app)
+{
+    if (app->filter != NULL || s_mgr_cfg.base_topic == NULL) { ///< 已编译或基础 Topic 未知
+        return ESP_OK;                             ///< 无需处理
+    }
+
+    size_t slen = strlen(app->suffix);             ///< 前缀长度
+    bool   has_hash = (strcmp(app->suffix, "#") == 0) || ///< 前缀本身即 "#"
+                      (slen >= 2 && strcmp(app->suffix + slen - 2, "/#") == 0); ///< 或以 "/#" 结尾
+    size_t len = strlen(s_mgr_cfg.base_topic) + 1 + slen + (has_hash ? 0 : 2) + 1; ///< 含结束符
+
+    char *filter = malloc(len);                    ///< 过滤串常驻，订阅时复用
+    if (filter == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    snprintf(filter, len, "%s/%s%s", s_mgr_cfg.base_topic, app->suffix, has_hash ? "" : "/#");
+
+    esp_err_t ret = mqtt_topic_router_add(s_router, filter, app); ///< 编译进路由树
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "compile filter %s failed: %s", filter, esp_err_to_name(ret));
+        free(filter);
+        return ret;
+    }
+
+    __atomic_store_n(&app->filter, filter, __ATOMIC_RELEASE); ///< 发布给订阅流程
+    return ESP_OK;
+}
+
+/**
+ * @brief 按名称查找模块（无锁遍历）
+ */
+static web_mqtt_app_t *web_mqtt_manager_app_find(const char *topic_suffix)
+{
+    for (web_mqtt_app_t *app = __atomic_load_n(&s_apps, __ATOMIC_ACQUIRE);
+         app != NULL;
+         app = __atomic_load_n(&app->next, __ATOMIC_ACQUIRE)) {
+        if (strcmp(app->suffix, topic_suffix) == 0) {
+            return app;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 执行模块回调并记录耗时
+ */
+static void web_mqtt_manager_app_run(web_mqtt_app_t *app,
+                                     const char     *topic,
+                                     int             topic_len,
+                                     const uint8_t  *payload,
+                                     int             payload_len)
+{
+    web_mqtt_app_msg_cb_t cb = __atomic_load_n(&app->cb, __ATOMIC_ACQUIRE); ///< 取最新回调
+    int64_t start = esp_timer_get_time();          ///< 开始时间
+
+    (void)cb(topic, topic_len, payload, payload_len); ///< 将消息转交模块
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start); ///< 回调耗时
+    uint32_t max = __atomic_load_n(&app->stats.handler_max_us, __ATOMIC_RELAXED);
+    while (us > max &&
+           !__atomic_compare_exchange_n(&app->stats.handler_max_us, &max, us, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * @brief 模块工作任务：从分发队列取消息并执行回调
+ */
+static void web_mqtt_manager_app_task(void *arg)
+{
+    web_mqtt_app_t *app = (web_mqtt_app_t *)arg;   ///< 所属模块
+
+    for (;;) {
+        web_mqtt_app_msg_t *msg = NULL;
+        if (xQueueReceive(app->queue, &msg, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        web_mqtt_manager_app_run(app,
+                                 msg->data,
+                                 msg->topic_len,
+                                 (const uint8_t *)msg->data + msg->topic_len,
+                                 msg->payload_len);
+        free(msg);                                 ///< 消息由工作任务释放
     }
 }
 
 /**
- * @brief MQTT 底层消息回调：统一分发到各应用模块
+ * @brief 记录一次丢弃
+ */
+static void web_mqtt_manager_app_drop(web_mqtt_app_t *app, const char *reason)
+{
+    uint32_t n = __atomic_add_fetch(&app->stats.dropped, 1, __ATOMIC_RELAXED);
+    if (n == 1 || (n % WEB_MQTT_APP_DROP_LOG_EVERY) == 0) { ///< 限制日志频率
+        ESP_LOGW(TAG, "app %s drop message (%s), total %u", app->suffix, reason, (unsigned)n);
+    }
+}
+
+/**
+ * @brief 路由命中回调：同步执行或拷贝入队
+ */
+static bool web_mqtt_manager_dispatch(void *target, void *arg)
+{
+    web_mqtt_app_t             *app = (web_mqtt_app_t *)target;
+    const web_mqtt_route_msg_t *m   = (const web_mqtt_route_msg_t *)arg;
+
+    __atomic_add_fetch(&app->stats.received, 1, __ATOMIC_RELAXED);
+
+    if (app->queue == NULL) {                      ///< 同步模块
+        web_mqtt_manager_app_run(app, m->topic, m->topic_len, m->payload, m->payload_len);
+        return true;                               ///< 继续分发给其他模块
+    }
+
+    size_t size = (size_t)m->topic_len + (size_t)m->payload_len; ///< 需拷贝的字节数
+    if (app->max_msg_size > 0 && size > app->max_msg_size) { ///< 超出模块设定上限
+        web_mqtt_manager_app_drop(app, "too large");
+        return true;
+    }
+
+    web_mqtt_app_msg_t *msg = malloc(sizeof(web_mqtt_app_msg_t) + size);
+    if (msg == NULL) {
+        web_mqtt_manager_app_drop(app, "no mem");
+        return true;
+    }
+    msg->topic_len   = m->topic_len;
+    msg->payload_len = m->payload_len;
+    memcpy(msg->data, m->topic, (size_t)m->topic_len);
+    if (m->payload_len > 0) {
+        memcpy(msg->data + m->topic_len, m->payload, (size_t)m->payload_len);
+    }
+
+    if (xQueueSend(app->queue, &msg, 0) != pdTRUE) { ///< 不等待，队列满即丢弃
+        free(msg);
+        web_mqtt_manager_app_drop(app, "queue full");
+        return true;
+    }
+
+    uint32_t waiting = (uint32_t)uxQueueMessagesWaiting(app->queue);
+    if (waiting > __atomic_load_n(&app->stats.queue_peak, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&app->stats.queue_peak, waiting, __ATOMIC_RELAXED); ///< 只有事件任务写入
+    }
+    return true;
+}
+
+/**
+ * @brief 在 MQTT 已连接时，为所有已注册应用模块订阅 Topic
+ *
+ * 在 esp-mqtt 事件任务中调用，无锁遍历注册表，避免与注册流程互相等待。
+ */
+static void web_mqtt_manager_subscribe_all_apps(void)
+{
+    for (web_mqtt_app_t *app = __atomic_load_n(&s_apps, __ATOMIC_ACQUIRE); ///< 遍历所有模块
+         app != NULL;
+         app = __atomic_load_n(&app->next, __ATOMIC_ACQUIRE)) {
+        const char *filter = __atomic_load_n(&app->filter, __ATOMIC_ACQUIRE); ///< 已编译的过滤串
+        if (filter != NULL) {
+            (void)mqtt_module_subscribe(filter, 1); ///< 订阅，忽略返回值
+        }
+    }
+}
+
+/**
+ * @brief MQTT 底层消息回调：经路由树分发到各应用模块
  */
 static void web_mqtt_manager_on_mqtt_message(const char    *topic,
                                              int            topic_len,
                                              const uint8_t *payload,
                                              int            payload_len)
 {
-    if (s_mgr_cfg.base_topic == NULL) {            ///< 未配置基础 Topic
+    mqtt_topic_router_t *router = __atomic_load_n(&s_router, __ATOMIC_ACQUIRE); ///< 路由树
+    if (router == NULL || topic == NULL || topic_len <= 0) { ///< 尚无模块或 Topic 无效
         return;                                    ///< 不做分发
     }
 
-    for (int i = 0; i < s_app_entry_count; ++i) {  ///< 遍历模块表
-        char prefix[128];                          ///< 完整前缀缓冲区
-        int  n = snprintf(prefix, sizeof(prefix),  ///< 生成前缀字符串
-                          "%s/%s",               ///< base_topic/prefix
-                          s_mgr_cfg.base_topic,    ///< 基础 Topic
-                          s_app_entries[i].suffix);///< 模块前缀
-        if (n <= 0 || n >= (int)sizeof(prefix)) {  ///< 生成失败或溢出
-            continue;                              ///< 跳过本模块
-        }
+    web_mqtt_route_msg_t msg = {                   ///< 本次消息参数
+        .topic       = topic,
+        .topic_len   = topic_len,
+        .payload     = payload,
+        .payload_len = payload_len,
+    };
+    (void)mqtt_topic_router_match(router, topic, (size_t)topic_len, ///< 逐层匹配
+                                  web_mqtt_manager_dispatch, &msg);
+}
 
-        int prefix_len = n;                        ///< 前缀长度
-        if (topic_len < prefix_len) {              ///< Topic 过短
-            continue;                              ///< 跳过
-        }
+/**
+ * @brief 唤醒管理任务执行一次状态机
+ */
+static void web_mqtt_manager_kick(void)
+{
+    if (s_mgr_task != NULL) {                      ///< 任务已创建
+        xTaskNotifyGive(s_mgr_task);               ///< 发送任务通知
+    }
+}
 
-        if (memcmp(topic, prefix, prefix_len) != 0) { ///< 前缀不匹配
-            continue;                              ///< 跳过
-        }
+/**
+ * @brief 退避到期回调（esp_timer 任务中执行，只置标志并唤醒管理任务）
+ */
+static void web_mqtt_manager_on_backoff(void *ctx)
+{
+    (void)ctx;                                     ///< 未使用参数
+    s_retry_due = true;                            ///< 标记可以重连
+    web_mqtt_manager_kick();                       ///< 唤醒管理任务
+}
 
-        if (topic_len > prefix_len &&              ///< 有后续字符时
-            topic[prefix_len] != '/') {            ///< 要求分隔符为 '/'
-            continue;                              ///< 否则视为不匹配
-        }
+/**
+ * @brief 断开 / 失败后按指数退避安排下一次重连
+ *
+ * 没有可用 IP 时不安排：此时重连必然失败，等联网监督上报 NET_UP 后立即重连。
+ */
+static void web_mqtt_manager_schedule_retry(void)
+{
+    if (s_mgr_cfg.reconnect_interval_ms < 0) {     ///< 小于 0 表示不自动重连
+        return;                                    ///< 直接返回
+    }
+    if (!conn_supervisor_net_up()) {               ///< 网络未就绪
+        return;                                    ///< 等待 NET_UP
+    }
+    (void)conn_backoff_schedule(s_backoff, NULL);  ///< 已在等待时返回 INVALID_STATE，忽略
+}
 
-        if (s_app_entries[i].cb) {                 ///< 存在回调
-            (void)s_app_entries[i].cb(topic,       ///< 将消息转交模块
-                                       topic_len,
-                                       payload,
-                                       payload_len);
-        }
+/**
+ * @brief 联网监督事件回调：IP 恢复即重连，IP 丢失即停止退避
+ */
+static void web_mqtt_manager_on_conn_event(conn_event_t event, void *ctx)
+{
+    (void)ctx;                                     ///< 未使用参数
+
+    switch (event) {                               ///< 只关心派生的网络事件
+    case CONN_EVENT_NET_UP:                        ///< 任一链路拿到 IP
+        conn_backoff_reset(s_backoff);             ///< 新的网络，退避从头开始
+        s_retry_due = true;                        ///< 不等退避，立即重连
+        web_mqtt_manager_kick();                   ///< 唤醒管理任务
+        break;                                     ///< 结束分支
+
+    case CONN_EVENT_NET_DOWN:                      ///< 所有链路失去 IP
+        conn_backoff_cancel(s_backoff);            ///< 停止无意义的重试
+        s_retry_due = false;                       ///< 清除待重连标志
+        break;                                     ///< 结束分支
+
+    default:                                       ///< 其他事件忽略
+        break;                                     ///< 结束分支
     }
 }
 
@@ -170,22 +422,28 @@ static void web_mqtt_manager_on_mqtt_event(mqtt_module_event_t event)
     case MQTT_MODULE_EVENT_CONNECTED:              ///< 底层已连接
         ESP_LOGI(TAG, "MQTT connected");          ///< 打印日志
         web_mqtt_manager_notify_state(WEB_MQTT_STATE_CONNECTED); ///< 更新为已连接
-        s_last_error_ts = 0;                       ///< 清空错误时间戳
+        conn_backoff_reset(s_backoff);             ///< 退避清零
         web_mqtt_manager_subscribe_all_apps();     ///< 为各模块订阅 Topic
         mqtt_reg_module_on_connected();            ///< 触发一次注册查询
+        mqtt_outbox_set_online(true);              ///< 补发离线消息并发送积压
+        (void)conn_supervisor_notify(CONN_EVENT_MQTT_UP); ///< 结算本次恢复耗时
         break;                                     ///< 结束分支
 
     case MQTT_MODULE_EVENT_DISCONNECTED:           ///< 底层断开
         ESP_LOGW(TAG, "MQTT disconnected");       ///< 打印日志
         web_mqtt_manager_notify_state(WEB_MQTT_STATE_DISCONNECTED); ///< 更新为断开
-        s_last_error_ts = xTaskGetTickCount();     ///< 记录断开时间
+        mqtt_outbox_set_online(false);             ///< 之后的可靠消息落盘
+        (void)conn_supervisor_notify(CONN_EVENT_MQTT_DOWN); ///< 开始一次恢复计时
+        web_mqtt_manager_schedule_retry();         ///< 按退避安排重连
         break;                                     ///< 结束分支
 
     case MQTT_MODULE_EVENT_ERROR:                  ///< 底层错误
     default:                                       ///< 其他视为错误
         ESP_LOGE(TAG, "MQTT error");             ///< 打印日志
         web_mqtt_manager_notify_state(WEB_MQTT_STATE_ERROR); ///< 更新为错误状态
-        s_last_error_ts = xTaskGetTickCount();     ///< 记录错误时间
+        mqtt_outbox_set_online(false);             ///< 之后的可靠消息落盘
+        (void)conn_supervisor_notify(CONN_EVENT_MQTT_DOWN); ///< 连接失败同样视为不可用
+        web_mqtt_manager_schedule_retry();         ///< 按退避安排重连（已在等待时不重复）
         break;                                     ///< 结束分支
     }
 }
@@ -193,61 +451,49 @@ static void web_mqtt_manager_on_mqtt_event(mqtt_module_event_t event)
 /**
  * @brief 单步执行 Web MQTT 管理状态机
  *
- * 根据当前状态与配置决定是否发起连接或等待重试。
+ * 仅在被唤醒时执行：退避到期、网络恢复或初始化。
  */
 static void web_mqtt_manager_step(void)
 {
     switch (s_mgr_state) {                         ///< 根据当前状态分类
     case WEB_MQTT_STATE_DISCONNECTED:              ///< 断开状态
     case WEB_MQTT_STATE_ERROR: {                   ///< 错误状态
-        if (s_mgr_cfg.reconnect_interval_ms < 0) { ///< 小于 0 表示不自动重连
+        if (!s_retry_due) {                        ///< 尚未到重连时机
             break;                                 ///< 保持当前状态
         }
+        s_retry_due = false;                       ///< 消费本次重连
 
-        TickType_t now   = xTaskGetTickCount();    ///< 当前 Tick
-        TickType_t delta = (s_last_error_ts == 0)  ///< 若尚未记录
-                               ? 0                 ///< 则视为已到时间
-                               : (now - s_last_error_ts); ///< 与上次错误的间隔
-
-        TickType_t need = pdMS_TO_TICKS(           ///< 计算需要等待的 Tick
-            (s_mgr_cfg.reconnect_interval_ms <= 0) ///< 间隔 <=0 表示立即重连
-                ? 0
-                : s_mgr_cfg.reconnect_interval_ms);
-
-        if (delta >= need) {                       ///< 已到达重试时间
-            ESP_LOGI(TAG, "try connect MQTT server"); ///< 打印日志
-            web_mqtt_manager_notify_state(WEB_MQTT_STATE_CONNECTING); ///< 进入连接中
-            (void)mqtt_module_start();             ///< 发起一次连接尝试
-            if (s_last_error_ts == 0) {           ///< 首次尝试时记录时间
-                s_last_error_ts = now;            ///< 避免频繁重试
-            }
+        if (!conn_supervisor_net_up()) {           ///< 网络已断开
+            break;                                 ///< 等待 NET_UP
+        }
+
+        ESP_LOGI(TAG, "try connect MQTT server"); ///< 打印日志
+        web_mqtt_manager_notify_state(WEB_MQTT_STATE_CONNECTING); ///< 进入连接中
+        if (mqtt_module_reconnect() != ESP_OK) {   ///< 客户端忙或未能启动
+            web_mqtt_manager_notify_state(WEB_MQTT_STATE_ERROR); ///< 回到错误状态
+            web_mqtt_manager_schedule_retry();     ///< 稍后再试
         }
         break;                                     ///< 结束分支
     }
 
+    case WEB_MQTT_STATE_CONNECTING:                ///< 连接中，等待 MQTT 事件
     case WEB_MQTT_STATE_CONNECTED:                 ///< 已连接状态
     case WEB_MQTT_STATE_READY:                     ///< 业务准备就绪
-    default:                                       ///< 其他状态暂不做周期操作
+    default:                                       ///< 其他状态无需处理
         break;                                     ///< 保持静默
     }
 }
 
 /**
- * @brief Web MQTT 管理任务：周期性驱动状态机
+ * @brief Web MQTT 管理任务：阻塞等待任务通知，被唤醒时驱动一次状态机
  */
 static void web_mqtt_manager_task(void *arg)
 {
     (void)arg;                                     ///< 未使用参数
 
     for (;;) {                                     ///< 永久循环
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);   ///< 空闲时不唤醒 CPU
         web_mqtt_manager_step();                   ///< 单步执行状态机
-
-        int interval_ms = s_mgr_cfg.step_interval_ms; ///< 从配置读取间隔
-        if (interval_ms <= 0) {                    ///< 若未配置或非法
-            interval_ms = WEB_MQTT_MANAGER_STEP_INTERVAL_MS; ///< 使用默认值
-        }
-
-        vTaskDelay(pdMS_TO_TICKS(interval_ms));    ///< 休眠一段时间
     }
 }
 
@@ -269,6 +515,36 @@ esp_err_t web_mqtt_manager_init(const web_mqtt_manager_config_t *config)
     /* 若未指定 client_id，则基于 MAC 生成一个默认 client_id */
     web_mqtt_manager_ensure_client_id();
 
+    /* 联网监督（WiFi 管理通常已初始化，重复调用无副作用）与重连退避 */
+    esp_err_t ret = conn_supervisor_init();
+    if (ret != ESP_OK) {                           ///< 初始化失败
+        return ret;                                 ///< 直接返回错误码
+    }
+    if (s_backoff == NULL) {                       ///< 仅创建一次
+        conn_backoff_config_t backoff_cfg = CONN_BACKOFF_DEFAULT_CONFIG();
+        backoff_cfg.name    = "mqtt_retry";
+        backoff_cfg.base_ms = WEB_MQTT_MANAGER_RECONNECT_BASE_MS;
+        backoff_cfg.max_ms  = (s_mgr_cfg.reconnect_interval_ms > 0)
+                                  ? (uint32_t)s_mgr_cfg.reconnect_interval_ms
+                                  : 0;
+        backoff_cfg.cb      = web_mqtt_manager_on_backoff;
+        s_backoff = conn_backoff_create(&backoff_cfg);
+        if (s_backoff == NULL) {                   ///< 创建失败
+            return ESP_ERR_NO_MEM;                 ///< 返回内存不足
+        }
+    }
+
+    /* 准备应用模块注册表，并编译初始化前已注册模块的过滤串 */
+    ret = web_mqtt_manager_apps_prepare();
+    if (ret != ESP_OK) {                           ///< 创建失败
+        return ret;                                 ///< 直接返回错误码
+    }
+    xSemaphoreTake(s_app_lock, portMAX_DELAY);     ///< 串行化写者
+    for (web_mqtt_app_t *app = s_apps; app != NULL; app = app->next) {
+        (void)web_mqtt_manager_app_compile(app);   ///< 失败时已打印日志
+    }
+    xSemaphoreGive(s_app_lock);
+
     /* 组装 MQTT 模块配置 */
     mqtt_module_config_t mqtt_cfg = MQTT_MODULE_DEFAULT_CONFIG(); ///< 基础配置
 
@@ -281,11 +557,18 @@ esp_err_t web_mqtt_manager_init(const web_mqtt_manager_config_t *config)
         mqtt_cfg.keepalive_sec = s_mgr_cfg.keepalive_sec; ///< 覆盖默认值
     }
 
+    mqtt_cfg.disable_auto_reconnect = true;       ///< 重连由退避定时器驱动
     mqtt_cfg.event_cb      = web_mqtt_manager_on_mqtt_event; ///< 绑定事件回调
     mqtt_cfg.message_cb    = web_mqtt_manager_on_mqtt_message; ///< 绑定消息回调
 
     /* 初始化底层 MQTT 模块 */
-    esp_err_t ret = mqtt_module_init(&mqtt_cfg);   ///< 调用底层初始化
+    ret = mqtt_module_init(&mqtt_cfg);   ///< 调用底层初始化
+    if (ret != ESP_OK) {                           ///< 初始化失败
+        return ret;                                 ///< 直接返回错误码
+    }
+
+    /* 初始化上行发件箱（扫描离线分区，连上后补发） */
+    ret = mqtt_outbox_init();                      ///< 启动发件任务
     if (ret != ESP_OK) {                           ///< 初始化失败
         return ret;                                 ///< 直接返回错误码
     }
@@ -303,7 +586,7 @@ esp_err_t web_mqtt_manager_init(const web_mqtt_manager_config_t *config)
 
     /* 初始化状态 */
     s_mgr_state     = WEB_MQTT_STATE_DISCONNECTED; ///< 初始设为断开
-    s_last_error_ts = 0;                           ///< 清空错误时间戳
+    s_retry_due     = false;                       ///< 首次连接在下方直接发起
 
     /* 创建管理任务（仅创建一次） */
     if (s_mgr_task == NULL) {                      ///< 尚未创建任务
@@ -321,9 +604,18 @@ esp_err_t web_mqtt_manager_init(const web_mqtt_manager_config_t *config)
         }
     }
 
+    /* 之后的重连由联网监督事件与退避定时器驱动 */
+    ret = conn_supervisor_add_listener(web_mqtt_manager_on_conn_event, NULL);
+    if (ret != ESP_OK) {                           ///< 监听者已满
+        return ret;                                 ///< 直接返回错误码
+    }
+
     /* 初始化完成后，可立即触发一次连接尝试 */
-    web_mqtt_manager_notify_state(WEB_MQTT_STATE_DISCONNECTED); ///< 确认状态
-    (void)mqtt_module_start();                     ///< 直接尝试连接一次
+    web_mqtt_manager_notify_state(WEB_MQTT_STATE_CONNECTING); ///< 进入连接中
+    if (mqtt_module_start() != ESP_OK) {           ///< 启动失败
+        web_mqtt_manager_notify_state(WEB_MQTT_STATE_ERROR); ///< 进入错误状态
+        web_mqtt_manager_schedule_retry();         ///< 按退避重试
+    }
 
     return ESP_OK;                                 ///< 返回成功
 }
@@ -331,7 +623,14 @@ esp_err_t web_mqtt_manager_init(const web_mqtt_manager_config_t *config)
 esp_err_t web_mqtt_manager_register_app(const char *topic_suffix,
                                         web_mqtt_app_msg_cb_t cb)
 {
-    if (topic_suffix == NULL || cb == NULL) {      ///< 参数不可为空
+    web_mqtt_app_config_t cfg = WEB_MQTT_APP_DEFAULT_CONFIG(cb); ///< 同步回调
+    return web_mqtt_manager_register_app_ex(topic_suffix, &cfg);
+}
+
+esp_err_t web_mqtt_manager_register_app_ex(const char *topic_suffix,
+                                           const web_mqtt_app_config_t *config)
+{
+    if (topic_suffix == NULL || config == NULL || config->cb == NULL) { ///< 参数不可为空
         return ESP_ERR_INVALID_ARG;                ///< 返回参数错误
     }
 
@@ -339,40 +638,110 @@ esp_err_t web_mqtt_manager_register_app(const char *topic_suffix,
         return ESP_ERR_INVALID_ARG;                ///< 返回参数错误
     }
 
-    if (s_app_entry_count >= WEB_MQTT_APP_MAX_NUM) { ///< 模块数量已达上限
-        return ESP_ERR_NO_MEM;                     ///< 返回内存不足
+    esp_err_t ret = web_mqtt_manager_apps_prepare(); ///< 确保注册表可用
+    if (ret != ESP_OK) {
+        return ret;
     }
 
-    size_t len = strlen(topic_suffix);             ///< 计算前缀长度
-    if (len >= WEB_MQTT_APP_SUFFIX_MAX_LEN) {      ///< 超出可用空间
-        return ESP_ERR_INVALID_ARG;                ///< 返回参数错误
+    xSemaphoreTake(s_app_lock, portMAX_DELAY);     ///< 串行化写者
+
+    web_mqtt_app_t *exist = web_mqtt_manager_app_find(topic_suffix); ///< 查找是否已存在
+    if (exist != NULL) {
+        __atomic_store_n(&exist->cb, config->cb, __ATOMIC_RELEASE); ///< 更新回调
+        xSemaphoreGive(s_app_lock);
+        return ESP_OK;                             ///< 返回成功
+    }
+
+    web_mqtt_app_t *app = calloc(1, sizeof(web_mqtt_app_t)); ///< 新模块
+    char *suffix = strdup(topic_suffix);           ///< 保存前缀
+    if (app == NULL || suffix == NULL) {
+        free(app);
+        free(suffix);
+        xSemaphoreGive(s_app_lock);
+        return ESP_ERR_NO_MEM;                     ///< 返回内存不足
+    }
+    app->suffix       = suffix;
+    app->cb           = config->cb;
+    app->max_msg_size = config->max_msg_size;
+
+    if (config->queue_len > 0) {                   ///< 需要独立分发队列
+        app->queue = xQueueCreate(config->queue_len, sizeof(web_mqtt_app_msg_t *));
+        char name[configMAX_TASK_NAME_LEN];        ///< 任务名 "mqtt_<前缀>"（超长截断）
+        snprintf(name, sizeof(name), "mqtt_%s", topic_suffix);
+        if (app->queue == NULL ||
+            xTaskCreate(web_mqtt_manager_app_task, name, config->task_stack_size,
+                        app, config->task_priority, &app->task) != pdPASS) {
+            if (app->queue) {
+                vQueueDelete(app->queue);
+            }
+            free(app->suffix);
+            free(app);
+            xSemaphoreGive(s_app_lock);
+            return ESP_ERR_NO_MEM;                 ///< 返回内存不足
+        }
     }
 
-    for (int i = 0; i < s_app_entry_count; ++i) {  ///< 查找是否已存在
-        if (strcmp(s_app_entries[i].suffix, topic_suffix) == 0) {
-            s_app_entries[i].cb = cb;              ///< 更新回调
-            return ESP_OK;                         ///< 返回成功
+    ret = web_mqtt_manager_app_compile(app);       ///< 基础 Topic 已知时立即编译
+    if (ret != ESP_OK) {
+        if (app->task) {
+            vTaskDelete(app->task);                ///< 任务尚未收到任何消息
+            vQueueDelete(app->queue);
         }
+        free(app->suffix);
+        free(app);
+        xSemaphoreGive(s_app_lock);
+        return ret;
+    }
+
+    web_mqtt_app_t **tail = &s_apps;               ///< 追加到链表末尾
+    while (*tail != NULL) {
+        tail = &(*tail)->next;
     }
+    __atomic_store_n(tail, app, __ATOMIC_RELEASE); ///< 初始化完成后再发布
 
-    strcpy(s_app_entries[s_app_entry_count].suffix, topic_suffix); ///< 保存前缀
-    s_app_entries[s_app_entry_count].cb = cb;       ///< 保存回调
-    s_app_entry_count++;                            ///< 模块数量加一
+    const char *filter = app->filter;              ///< 需要立即订阅的过滤串
+    bool connected = (s_mgr_state == WEB_MQTT_STATE_CONNECTED ||
+                      s_mgr_state == WEB_MQTT_STATE_READY);
+    xSemaphoreGive(s_app_lock);
 
-    /* 若 MQTT 已连接，则立即为该模块订阅一次 */
-    if (s_mgr_cfg.base_topic != NULL &&
-        (s_mgr_state == WEB_MQTT_STATE_CONNECTED ||
-         s_mgr_state == WEB_MQTT_STATE_READY)) {
-        char filter[256];                          ///< 订阅过滤字符串
-        snprintf(filter, sizeof(filter), "%s/%s/#", ///< base_topic/prefix/#
-                 s_mgr_cfg.base_topic,             ///< 基础 Topic
-                 topic_suffix);                    ///< 模块前缀
+    ESP_LOGI(TAG, "app %s registered (%s)", topic_suffix,
+             app->queue ? "queued" : "inline");
+
+    /* 若 MQTT 已连接，则立即为该模块订阅一次（不持锁，避免与事件任务互相等待） */
+    if (connected && filter != NULL) {
         (void)mqtt_module_subscribe(filter, 1);    ///< 订阅，忽略返回值
     }
 
     return ESP_OK;                                  ///< 返回成功
 }
 
+esp_err_t web_mqtt_manager_get_app_stats(const char *topic_suffix,
+                                         web_mqtt_app_stats_t *stats,
+                                         bool reset)
+{
+    if (topic_suffix == NULL || stats == NULL) {   ///< 参数不可为空
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    web_mqtt_app_t *app = web_mqtt_manager_app_find(topic_suffix);
+    if (app == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (reset) {                                   ///< 读取并清零
+        stats->received       = __atomic_exchange_n(&app->stats.received, 0, __ATOMIC_RELAXED);
+        stats->dropped        = __atomic_exchange_n(&app->stats.dropped, 0, __ATOMIC_RELAXED);
+        stats->queue_peak     = __atomic_exchange_n(&app->stats.queue_peak, 0, __ATOMIC_RELAXED);
+        stats->handler_max_us = __atomic_exchange_n(&app->stats.handler_max_us, 0, __ATOMIC_RELAXED);
+    } else {
+        stats->received       = __atomic_load_n(&app->stats.received, __ATOMIC_RELAXED);
+        stats->dropped        = __atomic_load_n(&app->stats.dropped, __ATOMIC_RELAXED);
+        stats->queue_peak     = __atomic_load_n(&app->stats.queue_peak, __ATOMIC_RELAXED);
+        stats->handler_max_us = __atomic_load_n(&app->stats.handler_max_us, __ATOMIC_RELAXED);
+    }
+    return ESP_OK;
+}
+
 const char *web_mqtt_manager_get_client_id(void)
 {
     return s_mgr_cfg.client_id;
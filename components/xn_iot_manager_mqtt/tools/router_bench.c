@@ -0,0 +1,201 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-07 10:26:48
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-07 10:26:48
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_iot_manager_mqtt\tools\router_bench.c
+ * @Description: Topic 路由主机基准：对比路由树与旧版 snprintf + memcmp 前缀循环的每秒查找次数
+ *
+ * 编译运行（在组件目录下）：
+ *   gcc -O2 -Iinclude src/mqtt_topic_router.c tools/router_bench.c -o router_bench
+ *   ./router_bench [模块数] [迭代轮数]
+ *
+ * 路由表 = 设备实际注册的 reg / wifi / watering 三个模块 + 指定数量的合成模块 + 两条通配符过滤串；
+ * 每轮把一组命中 / 未命中的 Topic 各查一遍。旧版循环按原实现每条消息为每个模块格式化一次前缀。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mqtt_topic_router.h"
+
+#define BENCH_BASE_TOPIC    "xn/web"
+#define BENCH_SUFFIX_LEN    16
+
+typedef struct {
+    char suffix[BENCH_SUFFIX_LEN];
+    unsigned hits;
+} bench_app_t;
+
+static const char *s_topics[] = {
+    "xn/web/reg/ESP32_A0B1C2D3E4F5/resp",
+    "xn/web/wifi/ESP32_A0B1C2D3E4F5/set",
+    "xn/web/wifi/ESP32_A0B1C2D3E4F5/get_status",
+    "xn/web/watering/ESP32_A0B1C2D3E4F5/start",
+    "xn/web/watering/ESP32_A0B1C2D3E4F5/schedule",
+    "xn/web/app12/ESP32_A0B1C2D3E4F5/cmd",
+    "xn/web/ota/ESP32_A0B1C2D3E4F5/status",
+    "xn/web/unknown/ESP32_A0B1C2D3E4F5/x",
+    "xn/esp/wifi/ESP32_A0B1C2D3E4F5/status",
+    "$SYS/broker/uptime",
+};
+#define BENCH_TOPIC_NUM (sizeof(s_topics) / sizeof(s_topics[0]))
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static bool on_match(void *target, void *arg)
+{
+    (void)arg;
+    ((bench_app_t *)target)->hits++;
+    return true;
+}
+
+/* 旧版分发：逐个模块 snprintf 出 "base/suffix" 再比较 */
+static size_t legacy_match(bench_app_t *apps, int count, const char *topic, int topic_len)
+{
+    size_t hits = 0;
+    for (int i = 0; i < count; ++i) {
+        char prefix[128];
+        int n = snprintf(prefix, sizeof(prefix), "%s/%s", BENCH_BASE_TOPIC, apps[i].suffix);
+        if (n <= 0 || n >= (int)sizeof(prefix) || topic_len < n) {
+            continue;
+        }
+        if (memcmp(topic, prefix, (size_t)n) != 0) {
+            continue;
+        }
+        if (topic_len > n && topic[n] != '/') {
+            continue;
+        }
+        apps[i].hits++;
+        hits++;
+    }
+    return hits;
+}
+
+/* 通配符语义自检 */
+static int self_check(void)
+{
+    static const struct {
+        const char *filter;
+        const char *topic;
+        bool match;
+    } cases[] = {
+        { "a/#",   "a",       true  },
+        { "a/#",   "a/b/c",   true  },
+        { "a/#",   "ab",      false },
+        { "a/+",   "a/b",     true  },
+        { "a/+",   "a/",      true  },
+        { "a/+",   "a/b/c",   false },
+        { "+/b",   "a/b",     true  },
+        { "#",     "a/b",     true  },
+        { "#",     "$SYS/x",  false },
+        { "+/x",   "$SYS/x",  false },
+        { "$SYS/#", "$SYS/x", true  },
+        { "a/b",   "a/b/",    false },
+    };
+    int failed = 0;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        mqtt_topic_router_t *r = mqtt_topic_router_create();
+        bench_app_t app = { .hits = 0 };
+        mqtt_topic_router_add(r, cases[i].filter, &app);
+        size_t hits = mqtt_topic_router_match(r, cases[i].topic, strlen(cases[i].topic), on_match, NULL);
+        if ((hits == 1) != cases[i].match) {
+            printf("FAIL: filter \"%s\" topic \"%s\" expect %d\n",
+                   cases[i].filter, cases[i].topic, cases[i].match);
+            failed++;
+        }
+        mqtt_topic_router_destroy(r);
+    }
+
+    static const char *bad[] = { "a/#/b", "a+/b", "a/b#", "" };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        mqtt_topic_router_t *r = mqtt_topic_router_create();
+        bench_app_t app;
+        if (mqtt_topic_router_add(r, bad[i], &app) == ESP_OK) {
+            printf("FAIL: filter \"%s\" should be rejected\n", bad[i]);
+            failed++;
+        }
+        mqtt_topic_router_destroy(r);
+    }
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    int synth = argc > 1 ? atoi(argv[1]) : 5;
+    long rounds = argc > 2 ? atol(argv[2]) : 200000;
+
+    if (self_check() != 0) {
+        return 1;
+    }
+
+    int count = 3 + synth;
+    bench_app_t *apps = calloc((size_t)count + 2, sizeof(bench_app_t));
+    bench_app_t *legacy = calloc((size_t)count, sizeof(bench_app_t));
+    if (apps == NULL || legacy == NULL) {
+        return 1;
+    }
+    strcpy(apps[0].suffix, "reg");
+    strcpy(apps[1].suffix, "wifi");
+    strcpy(apps[2].suffix, "watering");
+    for (int i = 0; i < synth; i++) {
+        snprintf(apps[3 + i].suffix, BENCH_SUFFIX_LEN, "app%d", i);
+    }
+
+    mqtt_topic_router_t *router = mqtt_topic_router_create();
+    char filter[64];
+    for (int i = 0; i < count; i++) {
+        snprintf(filter, sizeof(filter), "%s/%s/#", BENCH_BASE_TOPIC, apps[i].suffix);
+        mqtt_topic_router_add(router, filter, &apps[i]);
+        legacy[i] = apps[i];
+    }
+    mqtt_topic_router_add(router, BENCH_BASE_TOPIC "/+/+/status", &apps[count]);     ///< 通配符路由
+    mqtt_topic_router_add(router, BENCH_BASE_TOPIC "/watering/+/schedule", &apps[count + 1]);
+
+    size_t nodes = 0, routes = 0;
+    mqtt_topic_router_get_size(router, &nodes, &routes);
+
+    int lens[BENCH_TOPIC_NUM];
+    for (size_t t = 0; t < BENCH_TOPIC_NUM; t++) {
+        lens[t] = (int)strlen(s_topics[t]);
+    }
+
+    volatile size_t sink = 0;
+    double t0 = now_s();
+    for (long n = 0; n < rounds; n++) {
+        for (size_t t = 0; t < BENCH_TOPIC_NUM; t++) {
+            sink += mqtt_topic_router_match(router, s_topics[t], (size_t)lens[t], on_match, NULL);
+        }
+    }
+    double t_router = now_s() - t0;
+
+    t0 = now_s();
+    for (long n = 0; n < rounds; n++) {
+        for (size_t t = 0; t < BENCH_TOPIC_NUM; t++) {
+            sink += legacy_match(legacy, count, s_topics[t], lens[t]);
+        }
+    }
+    double t_legacy = now_s() - t0;
+
+    double lookups = (double)rounds * (double)BENCH_TOPIC_NUM;
+    printf("apps: %d (+2 wildcard routes), trie nodes: %zu, routes: %zu\n", count, nodes, routes);
+    printf("router : %10.0f lookups/s  (%.1f ns/lookup)\n", lookups / t_router, t_router * 1e9 / lookups);
+    printf("legacy : %10.0f lookups/s  (%.1f ns/lookup, prefix match only)\n",
+           lookups / t_legacy, t_legacy * 1e9 / lookups);
+    printf("speedup: %.1fx\n", t_legacy / t_router);
+
+    mqtt_topic_router_destroy(router);
+    free(apps);
+    free(legacy);
+    return sink == 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-03 10:05:31
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-03 10:05:31
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_lottie_manager\include\lottie_frames.h
+ * @Description: 预渲染帧序列播放 - 从 lottie_frames 分区映射 RLE/差分压缩的 RGB565 帧并按固定帧率播放
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include "lvgl.h"
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOTTIE_FRAMES_PARTITION_LABEL   "lottie_frames"   ///< 帧序列分区名称
+
+/**
+ * @brief 映射帧序列分区并校验索引
+ * @return
+ *      - ESP_OK: 成功（分区中至少有一个序列）
+ *      - ESP_ERR_NOT_FOUND: 分区不存在或为空镜像
+ *      - ESP_ERR_INVALID_RESPONSE: 镜像格式错误
+ */
+esp_err_t lottie_frames_init(void);
+
+/**
+ * @brief 查询是否有与动画匹配的预渲染序列
+ * @param name 动画名称（JSON 文件名去掉目录和扩展名，如 "speak"）
+ * @param width 播放宽度
+ * @param height 播放高度
+ * @return true 存在尺寸一致的序列
+ */
+bool lottie_frames_available(const char *name, uint16_t width, uint16_t height);
+
+/**
+ * @brief 开始播放预渲染序列（调用方需持有 LVGL 锁）
+ *
+ * 帧解码到调用方提供的缓冲区中，解码和显示由 LVGL 定时器驱动。
+ *
+ * @param name 动画名称
+ * @param buffer 帧缓冲区（至少 width*height*2 字节）
+ * @param buffer_size 帧缓冲区大小
+ * @return 显示帧的图片对象，失败返回 NULL
+ */
+lv_obj_t *lottie_frames_start(const char *name, uint8_t *buffer, size_t buffer_size);
+
+/**
+ * @brief 停止播放并隐藏图片对象（调用方需持有 LVGL 锁）
+ */
+void lottie_frames_stop(void);
+
+/**
+ * @brief 是否正在播放预渲染序列
+ */
+bool lottie_frames_is_playing(void);
+
+/**
+ * @brief 获取开机以来帧解码累计耗时
+ * @return 微秒
+ */
+uint64_t lottie_frames_get_busy_us(void);
+
+#ifdef __cplusplus
+}
+#endif
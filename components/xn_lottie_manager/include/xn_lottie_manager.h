@@ -18,6 +18,7 @@ extern "C" {
 #include "esp_err.h"
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 // 动画类型宏定义
 #define LOTTIE_ANIM_WIFI           0
@@ -34,8 +35,28 @@ extern "C" {
 typedef struct {
     uint16_t screen_width;   // 屏幕宽度
     uint16_t screen_height;  // 屏幕高度
+    size_t cache_budget_bytes; // 已解析动画缓存的 PSRAM 预算，0 使用默认值（1MB）
 } xn_lottie_app_config_t;
 
+// 动画缓存与切换统计
+typedef struct {
+    uint32_t switch_count;           // 动画切换次数
+    uint32_t cache_hits;             // 命中缓存（无需读取/解析 JSON）的次数
+    uint32_t cache_misses;           // 首次加载次数
+    uint32_t prerender_switches;     // 切换到预渲染帧序列的次数
+    uint32_t evictions;              // LRU 淘汰次数
+    uint32_t last_switch_us;         // 最近一次切换耗时（微秒）
+    uint32_t avg_switch_us;          // 平均切换耗时（微秒）
+    uint32_t max_switch_us;          // 最大切换耗时（微秒）
+    uint32_t cached_count;           // 当前缓存的动画数
+    size_t cache_bytes;              // 当前缓存占用估算（字节）
+    size_t cache_budget_bytes;       // 缓存预算（字节）
+    size_t render_pool_bytes;        // 共享渲染缓冲区大小（字节）
+    size_t psram_high_water_bytes;   // 开机以来 PSRAM 最高使用量（字节）
+    uint32_t render_cpu_permille;    // 距上次查询期间动画渲染/解码占 CPU 的千分比
+    bool prerender_active;           // 当前是否在播放预渲染帧序列
+} xn_lottie_stats_t;
+
 /**
  * @brief 初始化 Lottie 管理器（包含底层 LVGL / 屏幕 / SPIFFS / 管理器）
  *
@@ -46,12 +67,24 @@ typedef struct {
  */
 esp_err_t xn_lottie_manager_init(const xn_lottie_app_config_t *cfg);
 
+/**
+ * @brief 挂载 Lottie 资源 SPIFFS 分区（label: "lottie_spiffs"）
+ *
+ * xn_lottie_manager_init 内部会自动调用；已挂载时直接返回 ESP_OK。
+ *
+ * @return esp_err_t ESP_OK 表示成功
+ */
+esp_err_t xn_lottie_manager_mount_storage(void);
+
 /**
  * @brief 播放指定路径的动画
+ *
+ * 缓存未命中时 JSON 由资源加载器在后台读取，读完后在动画任务中解析并切换，期间保持当前画面。
+ *
  * @param file_path 动画文件路径
  * @param width 动画宽度
  * @param height 动画高度
- * @return true 成功，false 失败
+ * @return true 已切换或已提交后台读取，false 失败
  */
 bool lottie_manager_play(const char *file_path, uint16_t width, uint16_t height);
 
@@ -62,15 +95,31 @@ bool lottie_manager_play(const char *file_path, uint16_t width, uint16_t height)
  * @param height 动画高度
  * @param x 相对于中心的X轴偏移
  * @param y 相对于中心的Y轴偏移
- * @return true 成功，false 失败
+ * @return true 已切换或已提交后台读取，false 失败
  */
 bool lottie_manager_play_at_pos(const char *file_path, uint16_t width, uint16_t height, int16_t x, int16_t y);
 
 /**
- * @brief 停止当前动画
+ * @brief 预先读取并解析动画放入缓存（不显示）
+ * @param file_path 动画文件路径
+ * @return true 已在缓存中或已提交后台读取，false 失败
+ */
+bool lottie_manager_preload(const char *file_path);
+
+/**
+ * @brief 停止当前动画（隐藏并暂停，解析结果保留在缓存中）
  */
 void lottie_manager_stop(void);
 
+/**
+ * @brief 设置动画对象的父容器（下次切换动画时生效）
+ *
+ * 动画按容器中心对齐并被容器裁剪，重绘区域限制在容器内。
+ *
+ * @param parent 父容器，NULL 表示当前活动屏幕
+ */
+void xn_lottie_manager_set_parent(lv_obj_t *parent);
+
 /**
  * @brief 隐藏当前动画
  */
@@ -109,6 +158,13 @@ bool lottie_manager_play_anim(int anim_type);
  */
 bool lottie_manager_play_anim_at_pos(int anim_type, int16_t x, int16_t y);
 
+/**
+ * @brief 在动画任务中预加载指定类型的动画（简单API）
+ * @param anim_type 动画类型宏（如LOTTIE_ANIM_THINK）
+ * @return true 命令已发送，false 失败
+ */
+bool lottie_manager_preload_anim(int anim_type);
+
 /**
  * @brief 停止指定类型的动画（简单API）
  * @param anim_type 动画类型宏，-1表示停止当前所有动画
@@ -116,7 +172,20 @@ bool lottie_manager_play_anim_at_pos(int anim_type, int16_t x, int16_t y);
 void lottie_manager_stop_anim(int anim_type);
 
 /**
- * @brief 显示图片
+ * @brief 获取动画缓存与切换统计
+ * @param stats 输出统计
+ * @return ESP_OK 成功，ESP_ERR_INVALID_STATE 未初始化
+ */
+esp_err_t xn_lottie_manager_get_stats(xn_lottie_stats_t *stats);
+
+/**
+ * @brief 开关预渲染帧序列播放（关闭后全部实时渲染，用于对比 CPU 占用）
+ * @param enable true 优先使用 lottie_frames 分区中的预渲染序列
+ */
+void xn_lottie_manager_set_prerender(bool enable);
+
+/**
+ * @brief 显示图片（文件经资源加载器读入 PSRAM 后以内存图片显示，LVGL 格式或已启用解码器的格式）
  */
 bool lottie_manager_show_image(const char *img_path, uint16_t width, uint16_t height);
 
@@ -0,0 +1,340 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-03 10:05:31
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-03 10:05:31
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_lottie_manager\src\lottie_frames.c
+ * @Description: 预渲染帧序列播放实现 - 分区映射 + RLE/差分解码 + LVGL 定时器驱动
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include "lottie_frames.h"
+#include "xn_lvgl.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include <string.h>
+
+static const char *TAG = "LOTTIE_FRAMES";
+
+// ============ 分区镜像格式（与 tools/pack_frames.py 保持一致） ============
+
+#define LOTTIE_FRAMES_MAGIC      "XNLF"
+#define LOTTIE_FRAMES_VERSION    1
+#define LOTTIE_FRAMES_NAME_MAX   16
+
+// 帧数据为小端 u16 指令流：高 2 位操作码，低 14 位像素数
+#define FRAME_OP_SKIP            0   // 跳过 n 个像素（沿用上一帧）
+#define FRAME_OP_COPY            1   // 随后 n 个像素原样拷贝
+#define FRAME_OP_FILL            2   // 随后 1 个像素重复 n 次
+
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint16_t version;
+    uint16_t count;
+    uint32_t image_size;
+    uint32_t reserved;
+} lottie_frames_header_t;
+
+typedef struct __attribute__((packed)) {
+    char name[LOTTIE_FRAMES_NAME_MAX];
+    uint16_t width;
+    uint16_t height;
+    uint16_t frame_count;
+    uint16_t fps;
+    uint32_t table_offset;      // u32[frame_count + 1] 帧偏移表（相对镜像起始）
+    uint32_t reserved;
+} lottie_frames_entry_t;
+
+// ============ 播放状态 ============
+
+static const uint8_t *s_map = NULL;
+static esp_partition_mmap_handle_t s_map_handle;
+static const lottie_frames_header_t *s_hdr = NULL;
+
+static struct {
+    const lottie_frames_entry_t *entry;     ///< 正在播放的序列
+    const uint32_t *table;                  ///< 帧偏移表
+    uint16_t *pixels;                       ///< 解码目标缓冲区
+    uint16_t next_frame;                    ///< 下一帧序号
+    uint32_t period_ms;                     ///< 定时器当前周期（受动画帧间隔下限影响）
+    lv_obj_t *img;                          ///< 显示对象（复用）
+    lv_timer_t *timer;                      ///< 帧定时器（复用）
+    lv_image_dsc_t dsc;                     ///< 图片描述符，指向解码缓冲区
+    bool playing;
+} s_player = {0};
+
+static uint64_t s_busy_us = 0;
+static uint32_t s_decoded = 0;          // 已解码帧数（用于估算每帧耗时）
+
+static const lottie_frames_entry_t *lottie_frames_find(const char *name)
+{
+    if (!s_hdr || !name) {
+        return NULL;
+    }
+
+    const lottie_frames_entry_t *entries = (const lottie_frames_entry_t *)(s_hdr + 1);
+    for (int i = 0; i < s_hdr->count; i++) {
+        if (strncmp(entries[i].name, name, LOTTIE_FRAMES_NAME_MAX) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 把一帧指令流解码到缓冲区（SKIP 区域保持上一帧内容）
+ *
+ * 指令的操作数超出本帧数据末尾时停止解码，截断的帧不会读到下一帧或映射区之外。
+ */
+static void lottie_frames_decode(const uint16_t *src, const uint16_t *end,
+                                 uint16_t *dst, size_t pixel_count)
+{
+    size_t pos = 0;
+
+    while (src < end && pos < pixel_count) {
+        uint16_t token = *src++;
+        size_t n = token & 0x3FFF;
+        if (n > pixel_count - pos) {
+            n = pixel_count - pos;
+        }
+
+        switch (token >> 14) {
+        case FRAME_OP_SKIP:
+            break;
+        case FRAME_OP_COPY:
+            if ((size_t)(end - src) < (size_t)(token & 0x3FFF)) {
+                return;
+            }
+            memcpy(&dst[pos], src, n * sizeof(uint16_t));
+            src += token & 0x3FFF;
+            break;
+        case FRAME_OP_FILL: {
+            if (src >= end) {
+                return;
+            }
+            uint16_t px = *src++;
+            for (size_t i = 0; i < n; i++) {
+                dst[pos + i] = px;
+            }
+            break;
+        }
+        default:
+            return;
+        }
+        pos += n;
+    }
+}
+
+static void lottie_frames_decode_next(void)
+{
+    const lottie_frames_entry_t *e = s_player.entry;
+    uint16_t idx = s_player.next_frame;
+    const uint16_t *src = (const uint16_t *)(s_map + s_player.table[idx]);
+    const uint16_t *end = (const uint16_t *)(s_map + s_player.table[idx + 1]);
+    lottie_frames_decode(src, end, s_player.pixels, (size_t)e->width * e->height);
+
+    s_player.next_frame = (idx + 1 < e->frame_count) ? idx + 1 : 0;
+    s_decoded++;
+}
+
+static void lottie_frames_timer_cb(lv_timer_t *timer)
+{
+    if (!s_player.playing) {
+        return;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    uint32_t avg_us = s_decoded ? (uint32_t)(s_busy_us / s_decoded) : 0;
+
+    // 动画帧间隔下限：冻结时停在当前帧；间隔大于序列帧间隔时降低定时器频率，
+    // 每次把中间帧也解码掉（差分帧依赖上一帧）保持播放速度，但只重绘一次
+    const lottie_frames_entry_t *e = s_player.entry;
+    uint32_t seq_period = 1000 / e->fps;
+    uint32_t cap = lvgl_driver_get_anim_period();
+    uint32_t steps = 1;
+    if (timer) {
+        if (cap == LVGL_FRAME_FREEZE) {
+            lvgl_driver_note_skipped_frame(avg_us);
+            return;
+        }
+        uint32_t period = cap > seq_period ? cap : seq_period;
+        if (s_player.period_ms != period) {
+            s_player.period_ms = period;
+            lv_timer_set_period(timer, period);
+        }
+        steps = (period + seq_period / 2) / seq_period;
+    }
+    for (uint32_t i = 0; i < steps; i++) {
+        lottie_frames_decode_next();
+        if (i > 0) {
+            lvgl_driver_note_skipped_frame(avg_us);
+        }
+    }
+
+    lv_image_cache_drop(&s_player.dsc);
+    lv_obj_invalidate(s_player.img);
+
+    s_busy_us += esp_timer_get_time() - start_us;
+}
+
+/**
+ * @brief 校验帧偏移表：表本身在镜像内，每帧数据位于索引之后、镜像之内，偏移单调且按 u16 对齐
+ */
+static bool lottie_frames_table_valid(const lottie_frames_entry_t *e, uint32_t image_size, size_t index_end)
+{
+    if (e->table_offset < index_end || e->table_offset > image_size ||
+        ((size_t)e->frame_count + 1) * sizeof(uint32_t) > image_size - e->table_offset) {
+        return false;
+    }
+
+    const uint32_t *table = (const uint32_t *)(s_map + e->table_offset);
+    if (table[0] < index_end) {
+        return false;
+    }
+    for (uint32_t k = 0; k <= e->frame_count; k++) {
+        if ((table[k] & 1) || table[k] > image_size || (k > 0 && table[k] < table[k - 1])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+esp_err_t lottie_frames_init(void)
+{
+    if (s_hdr) {
+        return ESP_OK;
+    }
+
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY,
+                                                           LOTTIE_FRAMES_PARTITION_LABEL);
+    if (!part) {
+        ESP_LOGI(TAG, "未配置帧序列分区，使用实时 Lottie 渲染");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // 先读头部，只映射镜像实际使用的部分
+    lottie_frames_header_t hdr;
+    esp_err_t ret = esp_partition_read(part, 0, &hdr, sizeof(hdr));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (memcmp(hdr.magic, LOTTIE_FRAMES_MAGIC, 4) != 0 || hdr.count == 0) {
+        ESP_LOGI(TAG, "帧序列分区为空，使用实时 Lottie 渲染");
+        return ESP_ERR_NOT_FOUND;
+    }
+    size_t index_end = sizeof(hdr) + (size_t)hdr.count * sizeof(lottie_frames_entry_t);
+    if (hdr.version != LOTTIE_FRAMES_VERSION ||
+        hdr.image_size > part->size || index_end > hdr.image_size) {
+        ESP_LOGE(TAG, "帧序列分区格式无效（请重新烧录 lottie_frames 镜像）");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    const void *map = NULL;
+    ret = esp_partition_mmap(part, 0, hdr.image_size, ESP_PARTITION_MMAP_DATA,
+                             &map, &s_map_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "帧序列分区映射失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    s_map = (const uint8_t *)map;
+
+    // 校验每个序列的帧偏移表，避免播放时越界
+    const lottie_frames_header_t *mapped = (const lottie_frames_header_t *)s_map;
+    const lottie_frames_entry_t *entries = (const lottie_frames_entry_t *)(mapped + 1);
+    for (int i = 0; i < mapped->count; i++) {
+        const lottie_frames_entry_t *e = &entries[i];
+        if (e->frame_count == 0 || e->fps == 0 || (e->table_offset & 3) ||
+            !lottie_frames_table_valid(e, mapped->image_size, index_end)) {
+            ESP_LOGE(TAG, "帧序列 %.16s 索引无效", e->name);
+            esp_partition_munmap(s_map_handle);
+            s_map = NULL;
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        const uint32_t *table = (const uint32_t *)(s_map + e->table_offset);
+        ESP_LOGI(TAG, "帧序列 %.16s: %ux%u, %u 帧 @ %u FPS, %u 字节",
+                 e->name, e->width, e->height, e->frame_count, e->fps,
+                 (unsigned)(table[e->frame_count] - table[0]));
+    }
+
+    s_hdr = mapped;
+    return ESP_OK;
+}
+
+bool lottie_frames_available(const char *name, uint16_t width, uint16_t height)
+{
+    const lottie_frames_entry_t *e = lottie_frames_find(name);
+    return e && e->width == width && e->height == height;
+}
+
+lv_obj_t *lottie_frames_start(const char *name, uint8_t *buffer, size_t buffer_size)
+{
+    const lottie_frames_entry_t *e = lottie_frames_find(name);
+    if (!e || !buffer) {
+        return NULL;
+    }
+
+    size_t bytes = (size_t)e->width * e->height * sizeof(uint16_t);
+    if (buffer_size < bytes) {
+        ESP_LOGE(TAG, "帧缓冲区不足: %u < %u", (unsigned)buffer_size, (unsigned)bytes);
+        return NULL;
+    }
+
+    if (!s_player.img) {
+        s_player.img = lv_image_create(lv_screen_active());
+        s_player.timer = lv_timer_create(lottie_frames_timer_cb, 1000 / e->fps, NULL);
+        if (!s_player.img || !s_player.timer) {
+            ESP_LOGE(TAG, "创建帧播放对象失败");
+            return NULL;
+        }
+    }
+
+    s_player.entry = e;
+    s_player.table = (const uint32_t *)(s_map + e->table_offset);
+    s_player.pixels = (uint16_t *)buffer;
+    s_player.next_frame = 0;
+
+    memset(&s_player.dsc, 0, sizeof(s_player.dsc));
+    s_player.dsc.header.magic = LV_IMAGE_HEADER_MAGIC;
+    s_player.dsc.header.cf = LV_COLOR_FORMAT_RGB565;
+    s_player.dsc.header.w = e->width;
+    s_player.dsc.header.h = e->height;
+    s_player.dsc.header.stride = e->width * sizeof(uint16_t);
+    s_player.dsc.data = buffer;
+    s_player.dsc.data_size = bytes;
+
+    // 先同步解出第 0 帧（关键帧），避免显示缓冲区里的旧内容
+    s_player.playing = true;
+    lottie_frames_timer_cb(NULL);
+
+    lv_image_set_src(s_player.img, &s_player.dsc);
+    lv_obj_move_foreground(s_player.img);
+    lv_obj_clear_flag(s_player.img, LV_OBJ_FLAG_HIDDEN);
+    s_player.period_ms = 1000 / e->fps;
+    lv_timer_set_period(s_player.timer, s_player.period_ms);
+    lv_timer_resume(s_player.timer);
+
+    return s_player.img;
+}
+
+void lottie_frames_stop(void)
+{
+    if (!s_player.playing) {
+        return;
+    }
+
+    s_player.playing = false;
+    lv_timer_pause(s_player.timer);
+    lv_obj_add_flag(s_player.img, LV_OBJ_FLAG_HIDDEN);
+}
+
+bool lottie_frames_is_playing(void)
+{
+    return s_player.playing;
+}
+
+uint64_t lottie_frames_get_busy_us(void)
+{
+    return s_busy_us;
+}
@@ -8,16 +8,22 @@
  */
 
  #include "xn_lottie_manager.h"
+ #include "lottie_frames.h"
  #include "xn_lvgl.h"
+ #include "asset_loader.h"
  #include "esp_log.h"
+ #include "sdkconfig.h"
+ #include "esp_attr.h"
  #include "esp_heap_caps.h"
  #include "esp_task_wdt.h"
+ #include "esp_timer.h"
  #include "freertos/FreeRTOS.h"
  #include "freertos/task.h"
  #include "freertos/queue.h"
  #include "esp_spiffs.h"
  #include <string.h>
  #include <stdio.h>
+ #include <stdint.h>
  
  static const char *TAG = "LOTTIE_MANAGER";
  
@@ -31,7 +37,10 @@
      LOTTIE_CMD_SET_POS,
      LOTTIE_CMD_CENTER,
      LOTTIE_CMD_SHOW_IMAGE,
-     LOTTIE_CMD_HIDE_IMAGE
+     LOTTIE_CMD_HIDE_IMAGE,
+     LOTTIE_CMD_PRELOAD,
+     LOTTIE_CMD_LOADED,          // 资源加载器读完动画 JSON
+     LOTTIE_CMD_IMAGE_LOADED     // 资源加载器读完图片文件
  } lottie_cmd_type_t;
  
  // 动画命令结构
@@ -58,6 +67,12 @@
              uint16_t width;
              uint16_t height;
          } image;
+         struct {
+             uint32_t tag;       // 动画：加载槽位；图片：请求序号
+             uint8_t *data;      // 文件内容（PSRAM），处理后 asset_loader_free
+             size_t size;
+             esp_err_t err;
+         } loaded;
      } data;
  } lottie_cmd_t;
  
@@ -68,35 +83,103 @@
      uint16_t height;
  } lottie_anim_config_t;
  
- // 动画配置表 - 全屏显示配置（屏幕尺寸：412x412）
+ // 动画配置表 - 不超过对话界面的动画区域（240x240，屏幕尺寸：412x412）
  static const lottie_anim_config_t anim_configs[] = {
-     [LOTTIE_ANIM_WIFI]    = {"/lottie/loading.json",        256, 256},  // WiFi加载
+     [LOTTIE_ANIM_WIFI]    = {"/lottie/loading.json",        200, 200},  // WiFi加载
      [LOTTIE_ANIM_MIC]     = {"/lottie/emoji_kaixin.json",   128, 128},  // mic
-     [LOTTIE_ANIM_SPEAK]   = {"/lottie/speak.json",          400, 277},  // 说话
-     [LOTTIE_ANIM_THINK]   = {"/lottie/emoji_think.json",    400, 400},  // 思考
-     [LOTTIE_ANIM_COOL]    = {"/lottie/emoji_cool.json",     400, 400},  // 酷
+     [LOTTIE_ANIM_SPEAK]   = {"/lottie/speak.json",          240, 166},  // 说话
+     [LOTTIE_ANIM_THINK]   = {"/lottie/emoji_think.json",    240, 240},  // 思考
+     [LOTTIE_ANIM_COOL]    = {"/lottie/emoji_cool.json",     240, 240},  // 酷
      [LOTTIE_ANIM_LOADING] = {"/lottie/loading.json",        200, 200},  // 通用加载
-     [LOTTIE_ANIM_OTA]     = {"/lottie/loading.json",        400, 400},  // OTA升级动画
+     [LOTTIE_ANIM_OTA]     = {"/lottie/loading.json",        240, 240},  // OTA升级动画
      // 可以继续添加更多动画配置...
  };
  
  #define ANIM_CONFIG_COUNT (sizeof(anim_configs) / sizeof(anim_configs[0]))
  
+ #define LOTTIE_CACHE_MAX_ENTRIES    6
+ #ifndef LOTTIE_CACHE_DEFAULT_BUDGET
+ #define LOTTIE_CACHE_DEFAULT_BUDGET (1024 * 1024)   // 已解析动画的 PSRAM 预算
+ #endif
+ 
  // 静态任务相关 - 参考main.c的实现
  #define LOTTIE_TASK_STACK_SIZE (1024*350/sizeof(StackType_t))  // 8KB栈
  static EXT_RAM_BSS_ATTR StackType_t lottie_task_stack[LOTTIE_TASK_STACK_SIZE];  // PSRAM栈
  static StaticTask_t lottie_task_buffer;  // 内部RAM控制块
  
  // 全局变量管理
- static lv_obj_t *g_lottie_obj = NULL;
- static uint8_t *g_lottie_buffer = NULL;
+ static lv_obj_t *g_lottie_obj = NULL;        // 当前显示的 Lottie 对象（属于某个缓存项）
+ static uint8_t *g_lottie_buffer = NULL;       // 共享渲染缓冲区，按最大配置尺寸一次性分配
+ static size_t g_lottie_buffer_size = 0;
  static bool g_initialized = false;
  static int g_current_anim_type = -1;  // 当前播放的动画类型
  static QueueHandle_t g_cmd_queue = NULL;
  static TaskHandle_t g_anim_task = NULL;
  static SemaphoreHandle_t g_anim_mutex = NULL;  // 动画操作互斥锁
- static volatile bool g_anim_busy = false;      // 动画是否正在操作中
  static lv_obj_t *g_image_obj = NULL;          // 图片对象
+ static lv_obj_t *g_anim_parent = NULL;        // 动画对象的父容器，NULL 表示当前屏幕
+ 
+ // 动画缓存：每个 JSON 解析一次，常驻为隐藏且暂停的 lv_lottie 对象，超出预算按 LRU 淘汰
+ typedef struct {
+     char path[48];
+     lv_obj_t *obj;           // 已解析的 Lottie 对象，NULL 表示空槽位
+     size_t cost;             // 占用：解析期间动画任务自己申请的内存净值，至少为 JSON 大小
+     uint32_t last_use;       // LRU 时钟
+ } lottie_cache_entry_t;
+ 
+ static lottie_cache_entry_t g_cache[LOTTIE_CACHE_MAX_ENTRIES];
+
+ // 异步加载：缓存未命中时 JSON 由资源加载器在后台读入 PSRAM，读完后回到动画任务解析，
+ // 读取期间动画任务与调用方都不阻塞，当前动画继续播放
+ typedef struct {
+     bool busy;               // 已提交、结果尚未处理
+     char path[48];
+ } lottie_pending_load_t;
+
+ static lottie_pending_load_t g_pending[LOTTIE_CACHE_MAX_ENTRIES];
+
+ // 加载完成后要切换到的动画（只保留最近一次请求，新的切换会覆盖它）
+ static struct {
+     bool active;
+     char path[48];
+     uint16_t width;
+     uint16_t height;
+     int16_t x;
+     int16_t y;
+     int64_t start_us;
+ } g_want;
+
+ // 图片：文件读入 PSRAM 后以内存图片显示，LVGL 绘制时不再访问文件系统
+ static uint32_t g_image_seq = 0;              // 最近一次显示/隐藏请求序号，过期的读取结果直接丢弃
+ static uint16_t g_image_width = 0;
+ static uint16_t g_image_height = 0;
+ static uint8_t *g_image_data = NULL;          // 当前图片文件内容
+ static lv_image_dsc_t g_image_dsc;
+ static size_t g_cache_bytes = 0;
+ static size_t g_cache_budget = LOTTIE_CACHE_DEFAULT_BUDGET;
+ static uint32_t g_cache_clock = 0;
+ static xn_lottie_stats_t g_stats = {0};
+ static uint64_t g_switch_total_us = 0;
+
+ // 解析计量：只统计动画任务在解析窗口内的申请/释放，其他任务同时申请的内存不会记到缓存项上
+ static TaskHandle_t volatile g_measure_task = NULL;
+ static volatile int32_t g_measure_bytes = 0;
+ 
+ // 渲染耗时统计：实时 Lottie 通过包装动画回调计时，预渲染序列由 lottie_frames 计时
+ static bool g_prerender_enabled = true;
+ static lv_anim_exec_xcb_t g_lottie_exec_cb = NULL;
+ static volatile uint64_t g_live_busy_us = 0;
+ static uint32_t g_live_renders = 0;           // 实时渲染帧数（用于估算每帧耗时）
+ static int64_t g_live_last_render_us = 0;     // 上次实时渲染时间（按动画帧间隔下限抽帧）
+ static int64_t g_cpu_window_start_us = 0;
+ static uint64_t g_cpu_window_busy_us = 0;
+ 
+ static bool _lottie_pool_ensure(size_t bytes);
+ static void _lottie_anim_name(const char *file_path, char *name, size_t size);
+ static void _lottie_on_loaded(const lottie_cmd_t *cmd);
+ static void _lottie_image_request(const char *img_path, uint16_t width, uint16_t height);
+ static void _lottie_image_show(const lottie_cmd_t *cmd);
+ static void _lottie_image_hide(void);
  
  // 实际执行动画播放的内部函数
  static bool _lottie_play_internal(int anim_type)
@@ -187,6 +270,19 @@
                  _lottie_stop_internal(cmd.data.stop.anim_type);
                  break;
  
+             case LOTTIE_CMD_PRELOAD: {
+                 const lottie_anim_config_t *config = &anim_configs[cmd.data.play.anim_type];
+                 char name[16];
+                 _lottie_anim_name(config->file_path, name, sizeof(name));
+                 if (g_prerender_enabled && lottie_frames_available(name, config->width, config->height)) {
+                     break;  // 有预渲染序列，无需解析 JSON
+                 }
+                 if (!lottie_manager_preload(config->file_path)) {
+                     ESP_LOGW(TAG, "预加载动画失败，类型: %d", cmd.data.play.anim_type);
+                 }
+                 break;
+             }
+ 
              case LOTTIE_CMD_HIDE:
                  if (g_lottie_obj) {
                      lv_lock();
@@ -220,48 +316,22 @@
                  break;
  
              case LOTTIE_CMD_SHOW_IMAGE:
-                 ESP_LOGI(TAG, "处理显示图片命令: %s (%dx%d)", 
+                 ESP_LOGI(TAG, "处理显示图片命令: %s (%dx%d)",
                           cmd.data.image.path, cmd.data.image.width, cmd.data.image.height);
-                 
-                 lv_lock();
-                 if (g_lottie_obj) {
-                     lv_obj_add_flag(g_lottie_obj, LV_OBJ_FLAG_HIDDEN);
-                     ESP_LOGI(TAG, "已隐藏Lottie动画");
-                 }
-                 if (g_image_obj) {
-                     lv_obj_delete(g_image_obj);
-                     g_image_obj = NULL;
-                     ESP_LOGI(TAG, "已删除旧图片");
-                 }
-                 
-                 g_image_obj = lv_image_create(lv_screen_active());
-                 if (g_image_obj) {
-                     ESP_LOGI(TAG, "图片对象创建成功");
-                     lv_image_set_src(g_image_obj, cmd.data.image.path);
-                     if (cmd.data.image.width > 0 && cmd.data.image.height > 0) {
-                         lv_obj_set_size(g_image_obj, cmd.data.image.width, cmd.data.image.height);
-                     }
-                     lv_obj_center(g_image_obj);
-                     ESP_LOGI(TAG, "✅ 图片显示成功: %s", cmd.data.image.path);
-                 } else {
-                     ESP_LOGE(TAG, "❌ 创建图片对象失败");
-                 }
-                 lv_unlock();
+                 _lottie_image_request(cmd.data.image.path, cmd.data.image.width, cmd.data.image.height);
+                 break;
+ 
+             case LOTTIE_CMD_IMAGE_LOADED:
+                 _lottie_image_show(&cmd);
                  break;
  
              case LOTTIE_CMD_HIDE_IMAGE:
                  ESP_LOGI(TAG, "处理隐藏图片命令");
-                 lv_lock();
-                 if (g_image_obj) {
-                     lv_obj_delete(g_image_obj);
-                     g_image_obj = NULL;
-                     ESP_LOGI(TAG, "图片已删除");
-                 }
-                 if (g_lottie_obj) {
-                     lv_obj_clear_flag(g_lottie_obj, LV_OBJ_FLAG_HIDDEN);
-                     ESP_LOGI(TAG, "已恢复Lottie动画");
-                 }
-                 lv_unlock();
+                 _lottie_image_hide();
+                 break;
+ 
+             case LOTTIE_CMD_LOADED:
+                 _lottie_on_loaded(&cmd);
                  break;
  
              default:
@@ -295,6 +365,19 @@
          return false;
      }
  
+     // 共享渲染缓冲区按配置表中最大的动画一次性分配，之后切换动画不再申请/释放
+     size_t pool_bytes = 0;
+     for (int i = 0; i < ANIM_CONFIG_COUNT; i++) {
+         size_t bytes = (size_t)anim_configs[i].width * anim_configs[i].height * 4;  // ARGB8888
+         if (bytes > pool_bytes) {
+             pool_bytes = bytes;
+         }
+     }
+     if (!_lottie_pool_ensure(pool_bytes)) {
+         vSemaphoreDelete(g_anim_mutex);
+         return false;
+     }
+ 
      // 创建命令队列
      g_cmd_queue = xQueueCreate(10, sizeof(lottie_cmd_t));
      if (!g_cmd_queue) {
@@ -326,127 +409,365 @@
      return true;
  }
  
- bool lottie_manager_play(const char *file_path, uint16_t width, uint16_t height)
+ // 实时 Lottie 帧渲染回调的计时包装（在 LVGL 任务中执行）
+ // 动画时间轴照常推进，只是距上次渲染不足动画帧间隔下限（或被冻结）时跳过本帧，恢复后直接渲染当前进度
+ static void _lottie_timed_exec_cb(void *var, int32_t v)
  {
-     if (!g_initialized) {
-         ESP_LOGE(TAG, "管理器未初始化");
-         return false;
+     int64_t start_us = esp_timer_get_time();
+     uint32_t period_ms = lvgl_driver_get_anim_period();
+     // 动画定时器按刷新周期触发，留半个周期余量，避免 200ms 上限被凑成 300ms
+     int64_t min_gap_us = (int64_t)period_ms * 1000 - LV_DEF_REFR_PERIOD * 500;
+     if (period_ms == LVGL_FRAME_FREEZE ||
+         (g_live_last_render_us > 0 && start_us - g_live_last_render_us < min_gap_us)) {
+         lvgl_driver_note_skipped_frame(g_live_renders ? (uint32_t)(g_live_busy_us / g_live_renders) : 0);
+         return;
      }
+
+     g_lottie_exec_cb(var, v);
+     g_live_last_render_us = start_us;
+     g_live_renders++;
+     g_live_busy_us += esp_timer_get_time() - start_us;
+ }
  
-     if (!file_path) {
-         ESP_LOGE(TAG, "文件路径无效");
-         return false;
+ // 隐藏并暂停当前显示的动画（调用方需持有 LVGL 锁）
+ static void _lottie_deactivate_current(void)
+ {
+     if (lottie_frames_is_playing()) {
+         lottie_frames_stop();
+     } else if (g_lottie_obj) {
+         lv_obj_add_flag(g_lottie_obj, LV_OBJ_FLAG_HIDDEN);
+         lv_anim_pause(lv_lottie_get_anim(g_lottie_obj));
      }
+ }
  
-     // 获取互斥锁，确保同一时间只有一个动画操作
-     if (xSemaphoreTake(g_anim_mutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
-         ESP_LOGE(TAG, "获取互斥锁超时");
-         return false;
+ // 把动画对象挂到父容器下（容器裁剪子对象，动画重绘区域不会超出容器）
+ static void _lottie_attach(lv_obj_t *obj)
+ {
+     lv_obj_t *parent = g_anim_parent ? g_anim_parent : lv_screen_active();
+     if (lv_obj_get_parent(obj) != parent) {
+         lv_obj_set_parent(obj, parent);
      }
+ }
  
-     // 等待之前的操作完全完成
-     uint32_t wait_count = 0;
-     while (g_anim_busy && wait_count < 100) {
-         vTaskDelay(pdMS_TO_TICKS(10));
-         wait_count++;
+ // 从文件路径取动画名（去掉目录和扩展名），用于匹配预渲染序列
+ static void _lottie_anim_name(const char *file_path, char *name, size_t size)
+ {
+     const char *base = strrchr(file_path, '/');
+     base = base ? base + 1 : file_path;
+     size_t len = strcspn(base, ".");
+     if (len >= size) {
+         len = size - 1;
      }
+     memcpy(name, base, len);
+     name[len] = '\0';
+ }
  
-     if (g_anim_busy) {
-         ESP_LOGE(TAG, "等待动画操作完成超时");
-         xSemaphoreGive(g_anim_mutex);
-         return false;
+ // 在缓存中查找已解析的动画
+ static lottie_cache_entry_t *_lottie_cache_find(const char *file_path)
+ {
+     for (int i = 0; i < LOTTIE_CACHE_MAX_ENTRIES; i++) {
+         if (g_cache[i].obj && strcmp(g_cache[i].path, file_path) == 0) {
+             return &g_cache[i];
+         }
      }
+     return NULL;
+ }
  
-     g_anim_busy = true;
+ // 删除一个缓存项（对象已隐藏且动画已暂停，不会被渲染，可直接删除）
+ static void _lottie_cache_drop(lottie_cache_entry_t *entry)
+ {
+     ESP_LOGI(TAG, "淘汰动画缓存: %s (%u 字节)", entry->path, (unsigned)entry->cost);
  
-     ESP_LOGI(TAG, "播放动画: %s (%dx%d), 当前动画: %d", file_path, width, height, g_current_anim_type);
+     lv_lock();
+     lv_anim_t *anim = lv_lottie_get_anim(entry->obj);
+     if (anim && anim->exec_cb == _lottie_timed_exec_cb) {
+         anim->exec_cb = g_lottie_exec_cb;
+     }
+     lv_obj_delete(entry->obj);
+     lv_unlock();
  
-     // 先清理之前的动画（包含同步等待）
-     lottie_manager_stop();
+     g_cache_bytes -= entry->cost;
+     g_stats.evictions++;
+     memset(entry, 0, sizeof(*entry));
+ }
  
-     // 等待确保LVGL完全处理完删除操作和内存释放
-     // 增加延迟以避免SPI传输队列冲突
-     vTaskDelay(pdMS_TO_TICKS(100));
+ // 按 LRU 淘汰，直到可以放下 need 字节且有空闲槽位，返回空闲槽位
+ static lottie_cache_entry_t *_lottie_cache_make_room(size_t need)
+ {
+     while (1) {
+         lottie_cache_entry_t *free_slot = NULL;
+         lottie_cache_entry_t *lru = NULL;
+ 
+         for (int i = 0; i < LOTTIE_CACHE_MAX_ENTRIES; i++) {
+             lottie_cache_entry_t *e = &g_cache[i];
+             if (!e->obj) {
+                 if (!free_slot) {
+                     free_slot = e;
+                 }
+                 continue;
+             }
+             if (e->obj == g_lottie_obj) {
+                 continue;  // 正在显示的动画不淘汰
+             }
+             if (!lru || e->last_use < lru->last_use) {
+                 lru = e;
+             }
+         }
  
-     // 第一步：在锁外读取文件到内存（耗时操作）
-     FILE *fp = fopen(file_path, "rb");
-     if (!fp) {
-         ESP_LOGE(TAG, "无法打开文件: %s", file_path);
-         g_anim_busy = false;
-         xSemaphoreGive(g_anim_mutex);
-         return false;
+         if (free_slot && g_cache_bytes + need <= g_cache_budget) {
+             return free_slot;
+         }
+         if (!lru) {
+             // 没有可淘汰的了：允许超出预算，保证当前动画能播放
+             return free_slot;
+         }
+         _lottie_cache_drop(lru);
      }
+ }
  
-     fseek(fp, 0, SEEK_END);
-     size_t file_size = ftell(fp);
-     fseek(fp, 0, SEEK_SET);
+ #if CONFIG_HEAP_USE_HOOKS
+ // 堆钩子对所有任务、所有申请都会调用：未计量时只读一次指针就返回
+ void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+ {
+     (void)size;
+     (void)caps;
+     if (ptr && g_measure_task && g_measure_task == xTaskGetCurrentTaskHandle()) {
+         g_measure_bytes += (int32_t)heap_caps_get_allocated_size(ptr);
+     }
+ }
 
-    ESP_LOGI(TAG, "Lottie JSON 文件: %s, 大小: %u 字节", file_path, (unsigned)file_size);
-     uint8_t *file_data = (uint8_t *)heap_caps_malloc(file_size, MALLOC_CAP_SPIRAM);
-     if (!file_data) {
-         ESP_LOGE(TAG, "文件缓冲区分配失败 (需要 %zu 字节)", file_size);
-         fclose(fp);
-         g_anim_busy = false;
-         xSemaphoreGive(g_anim_mutex);
-         return false;
+ void IRAM_ATTR esp_heap_trace_free_hook(void *ptr)
+ {
+     if (ptr && g_measure_task && g_measure_task == xTaskGetCurrentTaskHandle()) {
+         g_measure_bytes -= (int32_t)heap_caps_get_allocated_size(ptr);
+     }
+ }
+ #endif
+
+ // 用已读入的 JSON 创建隐藏、暂停的 Lottie 对象放入缓存（JSON 由调用方释放）
+ static lottie_cache_entry_t *_lottie_cache_insert(const char *file_path, const uint8_t *file_data, size_t file_size)
+ {
+     // 先用 JSON 大小预留空间，解析后的真实占用在下面计量
+     lottie_cache_entry_t *slot = _lottie_cache_make_room(file_size);
+     if (!slot) {
+         ESP_LOGE(TAG, "动画缓存槽位已满");
+         return NULL;
      }
  
-     size_t read_size = fread(file_data, 1, file_size, fp);
-     fclose(fp);
+     size_t psram_before = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
  
-     if (read_size != file_size) {
-         ESP_LOGE(TAG, "文件读取失败");
-         heap_caps_free(file_data);
-         g_anim_busy = false;
-         xSemaphoreGive(g_anim_mutex);
+     lv_lock();
+     lv_obj_t *obj = lv_lottie_create(lv_screen_active());
+     if (obj) {
+         // 未绑定渲染缓冲区前不会绘制；保持隐藏并暂停，激活时再绑定共享缓冲区
+         lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+         lv_lottie_set_src_data(obj, file_data, file_size);
+         lv_anim_t *anim = lv_lottie_get_anim(obj);
+         if (anim) {
+             g_lottie_exec_cb = anim->exec_cb;
+             anim->exec_cb = _lottie_timed_exec_cb;
+             lv_anim_pause(anim);
+         }
+     }
+     g_measure_task = NULL;
+     lv_unlock();
+ 
+     if (!obj) {
+         ESP_LOGE(TAG, "创建 Lottie 对象失败");
+         return NULL;
+     }
+ 
+     // LVGL 与 ThorVG 都经 malloc 申请，计量到的是对象和解析树的实际块大小；
+     // 未启用 CONFIG_HEAP_USE_HOOKS 时计量为 0，只按 JSON 大小计
+     size_t cost = g_measure_bytes > 0 ? (size_t)g_measure_bytes : 0;
+     if (cost < file_size) {
+         cost = file_size;
+     }
+ 
+     strcpy(slot->path, file_path);
+     slot->obj = obj;
+     slot->cost = cost;
+     g_cache_bytes += cost;
+ 
+     ESP_LOGI(TAG, "Lottie 已解析并缓存: %s, JSON %u 字节, 占用 %u 字节, 缓存合计 %u/%u",
+              file_path, (unsigned)file_size, (unsigned)cost,
+              (unsigned)g_cache_bytes, (unsigned)g_cache_budget);
+ 
+     // 解析后的真实占用可能超出预算，淘汰其他动画补回来
+     while (g_cache_bytes > g_cache_budget) {
+         lottie_cache_entry_t *lru = NULL;
+         for (int i = 0; i < LOTTIE_CACHE_MAX_ENTRIES; i++) {
+             lottie_cache_entry_t *e = &g_cache[i];
+             if (e->obj && e != slot && e->obj != g_lottie_obj &&
+                 (!lru || e->last_use < lru->last_use)) {
+                 lru = e;
+             }
+         }
+         if (!lru) {
+             break;
+         }
+         _lottie_cache_drop(lru);
+     }
+ 
+     return slot;
+ }
+ 
+ // 资源加载器读完 JSON 的回调（加载器任务中执行）：转交动画任务解析
+ static void _lottie_load_done_cb(const asset_loader_result_t *result, void *user_ctx)
+ {
+     lottie_cmd_t cmd;
+     cmd.type = LOTTIE_CMD_LOADED;
+     cmd.data.loaded.tag = (uint32_t)(uintptr_t)user_ctx;
+     cmd.data.loaded.data = result->data;
+     cmd.data.loaded.size = result->size;
+     cmd.data.loaded.err = result->err;
+ 
+     if (xQueueSend(g_cmd_queue, &cmd, pdMS_TO_TICKS(1000)) != pdTRUE) {
+         ESP_LOGE(TAG, "发送加载完成命令失败: %s", result->path);
+         asset_loader_free(result->data);
+         __atomic_store_n(&g_pending[cmd.data.loaded.tag].busy, false, __ATOMIC_RELEASE);
+     }
+ }
+ 
+ // 提交后台读取（需持有 g_anim_mutex），同一文件已在读取中时直接返回
+ static bool _lottie_request_load(const char *file_path)
+ {
+     if (strlen(file_path) >= sizeof(g_pending[0].path)) {
+         ESP_LOGE(TAG, "文件路径过长: %s", file_path);
          return false;
      }
  
-     // 第二步：在锁内操作LVGL对象（快速操作）
-     lv_lock();
+     int free_slot = -1;
+     for (int i = 0; i < LOTTIE_CACHE_MAX_ENTRIES; i++) {
+         bool busy = __atomic_load_n(&g_pending[i].busy, __ATOMIC_ACQUIRE);
+         if (busy && strcmp(g_pending[i].path, file_path) == 0) {
+             return true;
+         }
+         if (!busy && free_slot < 0) {
+             free_slot = i;
+         }
+     }
+     if (free_slot < 0) {
+         ESP_LOGE(TAG, "同时加载的动画过多: %s", file_path);
+         return false;
+     }
  
-     g_lottie_obj = lv_lottie_create(lv_screen_active());
-     if (!g_lottie_obj) {
-         lv_unlock();
-         ESP_LOGE(TAG, "创建 Lottie 对象失败");
-         heap_caps_free(file_data);
-         g_anim_busy = false;
-         xSemaphoreGive(g_anim_mutex);
+     lottie_pending_load_t *pending = &g_pending[free_slot];
+     strcpy(pending->path, file_path);
+     __atomic_store_n(&pending->busy, true, __ATOMIC_RELEASE);
+ 
+     esp_err_t ret = asset_loader_read(file_path, _lottie_load_done_cb, (void *)(uintptr_t)free_slot);
+     if (ret != ESP_OK) {
+         ESP_LOGE(TAG, "提交动画读取失败: %s (%s)", file_path, esp_err_to_name(ret));
+         __atomic_store_n(&pending->busy, false, __ATOMIC_RELEASE);
          return false;
      }
+     return true;
+ }
+ 
+ // 确保共享渲染缓冲区足够大（仅在配置之外的更大尺寸出现时才重新分配）
+ static bool _lottie_pool_ensure(size_t bytes)
+ {
+     if (g_lottie_buffer && g_lottie_buffer_size >= bytes) {
+         return true;
+     }
+ 
+     // 旧缓冲区可能仍被当前动画引用，先停掉
+     lottie_manager_stop();
+ 
+     if (g_lottie_buffer) {
+         heap_caps_free(g_lottie_buffer);
+         g_lottie_buffer = NULL;
+         g_lottie_buffer_size = 0;
+     }
  
-     // 分配渲染缓冲区
-     size_t buffer_size = width * height * 4; // ARGB8888
-     g_lottie_buffer = heap_caps_malloc(buffer_size, MALLOC_CAP_SPIRAM);
+     g_lottie_buffer = heap_caps_aligned_alloc(64, bytes, MALLOC_CAP_SPIRAM);
      if (!g_lottie_buffer) {
-         ESP_LOGE(TAG, "PSRAM缓冲区分配失败 (需要 %zu 字节)", buffer_size);
-         lv_obj_del(g_lottie_obj);
-         lv_unlock();
-         heap_caps_free(file_data);
-         g_lottie_obj = NULL;
-         g_anim_busy = false;
-         xSemaphoreGive(g_anim_mutex);
+         ESP_LOGE(TAG, "PSRAM渲染缓冲区分配失败 (需要 %zu 字节)", bytes);
          return false;
      }
+     g_lottie_buffer_size = bytes;
+     ESP_LOGI(TAG, "共享渲染缓冲区: %u 字节", (unsigned)bytes);
+     return true;
+ }
+ 
+ // 记录一次动画切换的耗时与命中情况
+ static void _lottie_record_switch(int64_t start_us, bool hit, const char *how)
+ {
+     uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+     g_stats.switch_count++;
+     if (hit) {
+         g_stats.cache_hits++;
+     } else {
+         g_stats.cache_misses++;
+     }
+     g_stats.last_switch_us = elapsed_us;
+     if (elapsed_us > g_stats.max_switch_us) {
+         g_stats.max_switch_us = elapsed_us;
+     }
+     g_switch_total_us += elapsed_us;
  
-     // 设置缓冲区和数据源（使用内存数据，避免文件IO）
-     lv_lottie_set_buffer(g_lottie_obj, width, height, g_lottie_buffer);
-     lv_lottie_set_src_data(g_lottie_obj, file_data, file_size);
-     lv_obj_center(g_lottie_obj);
+     ESP_LOGI(TAG, "动画切换完成 (%s)，耗时 %lu us", how, (unsigned long)elapsed_us);
+ }
  
+ // 激活已缓存的动画：重绑共享缓冲区并显示（需持有 g_anim_mutex）
+ static void _lottie_activate(lottie_cache_entry_t *entry, uint16_t width, uint16_t height,
+                              int16_t x, int16_t y, int64_t start_us, bool hit)
+ {
+     entry->last_use = ++g_cache_clock;
+ 
+     lv_lock();
+     if (g_lottie_obj != entry->obj) {
+         _lottie_deactivate_current();
+     }
+ 
+     // 重新绑定共享缓冲区（同时按新尺寸设置画布并渲染当前帧）
+     lv_lottie_set_buffer(entry->obj, width, height, g_lottie_buffer);
+     _lottie_attach(entry->obj);
+     lv_obj_align(entry->obj, LV_ALIGN_CENTER, x, y);
+     lv_obj_move_foreground(entry->obj);
+     if (!g_image_obj) {
+         lv_obj_clear_flag(entry->obj, LV_OBJ_FLAG_HIDDEN);
+     }
+     lv_anim_resume(lv_lottie_get_anim(entry->obj));
      lv_unlock();
  
-     // 释放文件数据（已被ThorVG解析）
-     heap_caps_free(file_data);
+     g_lottie_obj = entry->obj;
+     _lottie_record_switch(start_us, hit, hit ? "缓存命中" : "首次加载");
+ }
+ 
+ // 动画任务处理读取结果：解析入缓存，若仍是最近一次请求的动画则切换过去
+ static void _lottie_on_loaded(const lottie_cmd_t *cmd)
+ {
+     lottie_pending_load_t *pending = &g_pending[cmd->data.loaded.tag];
+ 
+     xSemaphoreTake(g_anim_mutex, portMAX_DELAY);
  
-     ESP_LOGI(TAG, "动画播放成功");
+     lottie_cache_entry_t *entry = NULL;
+     if (cmd->data.loaded.err != ESP_OK) {
+         ESP_LOGE(TAG, "读取动画失败: %s (%s)", pending->path, esp_err_to_name(cmd->data.loaded.err));
+     } else {
+         entry = _lottie_cache_find(pending->path);
+         if (!entry) {
+             entry = _lottie_cache_insert(pending->path, cmd->data.loaded.data, cmd->data.loaded.size);
+         }
+     }
+     asset_loader_free(cmd->data.loaded.data);
+ 
+     if (g_want.active && strcmp(g_want.path, pending->path) == 0) {
+         g_want.active = false;
+         if (entry && _lottie_pool_ensure((size_t)g_want.width * g_want.height * 4)) {
+             _lottie_activate(entry, g_want.width, g_want.height, g_want.x, g_want.y, g_want.start_us, false);
+         }
+     }
  
-     g_anim_busy = false;
+     __atomic_store_n(&pending->busy, false, __ATOMIC_RELEASE);
      xSemaphoreGive(g_anim_mutex);
-     return true;
  }
  
- bool lottie_manager_play_at_pos(const char *file_path, uint16_t width, uint16_t height, int16_t x, int16_t y)
+ // 切换到指定动画：命中缓存时只做缓冲区重绑定和显示/隐藏，不重建对象
+ static bool _lottie_switch(const char *file_path, uint16_t width, uint16_t height,
+                            int16_t x, int16_t y)
  {
      if (!g_initialized) {
          ESP_LOGE(TAG, "管理器未初始化");
@@ -464,166 +785,114 @@
          return false;
      }
  
-     // 等待之前的操作完全完成
-     uint32_t wait_count = 0;
-     while (g_anim_busy && wait_count < 100) {
-         vTaskDelay(pdMS_TO_TICKS(10));
-         wait_count++;
-     }
- 
-     if (g_anim_busy) {
-         ESP_LOGE(TAG, "等待动画操作完成超时");
-         xSemaphoreGive(g_anim_mutex);
-         return false;
-     }
- 
-     g_anim_busy = true;
+     int64_t start_us = esp_timer_get_time();
+     g_want.active = false;  // 新的切换覆盖尚在加载中的请求
  
      ESP_LOGI(TAG, "播放动画: %s (%dx%d) 中心偏移: (%d, %d), 当前动画: %d",
               file_path, width, height, x, y, g_current_anim_type);
  
-     // 先清理之前的动画（包含同步等待）
-     lottie_manager_stop();
- 
-     // 等待确保LVGL完全处理完删除操作和内存释放
-     // 增加延迟以避免SPI传输队列冲突
-     vTaskDelay(pdMS_TO_TICKS(100));
- 
-     // 第一步：在锁外读取文件到内存（耗时操作）
-     FILE *fp = fopen(file_path, "rb");
-     if (!fp) {
-         ESP_LOGE(TAG, "无法打开文件: %s", file_path);
-         g_anim_busy = false;
+     if (!_lottie_pool_ensure((size_t)width * height * 4)) {  // ARGB8888
          xSemaphoreGive(g_anim_mutex);
          return false;
      }
  
-     fseek(fp, 0, SEEK_END);
-     size_t file_size = ftell(fp);
-     fseek(fp, 0, SEEK_SET);
+     // 有尺寸一致的预渲染序列时直接播放帧，不做矢量光栅化
+     char name[16];
+     _lottie_anim_name(file_path, name, sizeof(name));
+     if (g_prerender_enabled && lottie_frames_available(name, width, height)) {
+         lv_lock();
+         _lottie_deactivate_current();
+         lv_obj_t *img = lottie_frames_start(name, g_lottie_buffer, g_lottie_buffer_size);
+         if (img) {
+             _lottie_attach(img);
+             lv_obj_align(img, LV_ALIGN_CENTER, x, y);
+             if (g_image_obj) {
+                 lv_obj_add_flag(img, LV_OBJ_FLAG_HIDDEN);
+             }
+         }
+         lv_unlock();
+ 
+         if (img) {
+             g_lottie_obj = img;
+             g_stats.prerender_switches++;
+             _lottie_record_switch(start_us, true, "预渲染序列");
+             xSemaphoreGive(g_anim_mutex);
+             return true;
+         }
+         ESP_LOGW(TAG, "预渲染序列 %s 启动失败，改用实时渲染", name);
+     }
  
-     uint8_t *file_data = (uint8_t *)heap_caps_malloc(file_size, MALLOC_CAP_SPIRAM);
-     if (!file_data) {
-         ESP_LOGE(TAG, "文件缓冲区分配失败 (需要 %zu 字节)", file_size);
-         fclose(fp);
-         g_anim_busy = false;
+     lottie_cache_entry_t *entry = _lottie_cache_find(file_path);
+     if (entry) {
+         _lottie_activate(entry, width, height, x, y, start_us, true);
          xSemaphoreGive(g_anim_mutex);
-         return false;
+         return true;
      }
  
-     size_t read_size = fread(file_data, 1, file_size, fp);
-     fclose(fp);
- 
-     if (read_size != file_size) {
-         ESP_LOGE(TAG, "文件读取失败");
-         heap_caps_free(file_data);
-         g_anim_busy = false;
+     // 未命中：后台读取 JSON，读完后由动画任务解析并切换，期间保持当前画面
+     if (!_lottie_request_load(file_path)) {
          xSemaphoreGive(g_anim_mutex);
          return false;
      }
+     strcpy(g_want.path, file_path);
+     g_want.width = width;
+     g_want.height = height;
+     g_want.x = x;
+     g_want.y = y;
+     g_want.start_us = start_us;
+     g_want.active = true;
+     ESP_LOGI(TAG, "动画 %s 后台加载中，完成后切换", file_path);
  
-     // 第二步：在锁内操作LVGL对象（快速操作）
-     lv_lock();
+     xSemaphoreGive(g_anim_mutex);
+     return true;
+ }
  
-     g_lottie_obj = lv_lottie_create(lv_screen_active());
-     if (!g_lottie_obj) {
-         lv_unlock();
-         ESP_LOGE(TAG, "创建 Lottie 对象失败");
-         heap_caps_free(file_data);
-         g_anim_busy = false;
-         xSemaphoreGive(g_anim_mutex);
+ bool lottie_manager_play(const char *file_path, uint16_t width, uint16_t height)
+ {
+     return _lottie_switch(file_path, width, height, 0, 0);
+ }
+ 
+ bool lottie_manager_play_at_pos(const char *file_path, uint16_t width, uint16_t height, int16_t x, int16_t y)
+ {
+     return _lottie_switch(file_path, width, height, x, y);
+ }
+ 
+ bool lottie_manager_preload(const char *file_path)
+ {
+     if (!g_initialized || !file_path) {
          return false;
      }
  
-     // 分配渲染缓冲区
-     size_t buffer_size = width * height * 4; // ARGB8888
-     g_lottie_buffer = heap_caps_malloc(buffer_size, MALLOC_CAP_SPIRAM);
-     if (!g_lottie_buffer) {
-         ESP_LOGE(TAG, "PSRAM缓冲区分配失败 (需要 %zu 字节)", buffer_size);
-         lv_obj_del(g_lottie_obj);
-         lv_unlock();
-         heap_caps_free(file_data);
-         g_lottie_obj = NULL;
-         g_anim_busy = false;
-         xSemaphoreGive(g_anim_mutex);
+     if (xSemaphoreTake(g_anim_mutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+         ESP_LOGE(TAG, "获取互斥锁超时");
          return false;
      }
  
-     // 设置缓冲区和数据源（使用内存数据，避免文件IO）
-     lv_lottie_set_buffer(g_lottie_obj, width, height, g_lottie_buffer);
-     lv_lottie_set_src_data(g_lottie_obj, file_data, file_size);
-     lv_obj_align(g_lottie_obj, LV_ALIGN_CENTER, x, y);
- 
-     lv_unlock();
- 
-     // 释放文件数据（已被ThorVG解析）
-     heap_caps_free(file_data);
- 
-     ESP_LOGI(TAG, "动画播放成功，中心对齐偏移: (%d, %d)", x, y);
+     bool ok = _lottie_cache_find(file_path) != NULL || _lottie_request_load(file_path);
  
-     g_anim_busy = false;
      xSemaphoreGive(g_anim_mutex);
-     return true;
+     return ok;
  }
  
  void lottie_manager_stop(void)
  {
+     g_want.active = false;  // 尚在加载中的动画读完后不再显示
+
      if (g_lottie_obj) {
          ESP_LOGI(TAG, "停止动画");
  
-         // 先隐藏对象，避免在删除过程中继续渲染
-         lv_lock();
-         lv_obj_add_flag(g_lottie_obj, LV_OBJ_FLAG_HIDDEN);
-         lv_obj_invalidate(g_lottie_obj);  // 标记需要重绘
-         lv_unlock();
- 
-         // 【关键修复】等待所有LVGL刷新和DMA传输完成
-         // 这样可以确保在删除对象前，所有屏幕刷新的DMA都已完成
-         lv_display_t *disp = lv_display_get_default();
-         if (disp) {
-             uint32_t wait_count = 0;
-             const uint32_t max_wait_ms = 500;  // 最多等待500ms
-             const uint32_t check_interval_ms = 10;
- 
-             // 循环等待直到显示器空闲（无刷新活动）
-             while (wait_count < max_wait_ms) {
-                 vTaskDelay(pdMS_TO_TICKS(check_interval_ms));
- 
-                 uint32_t inactive_time = lv_display_get_inactive_time(disp);
-                 // ⚠️ 增加空闲阈值到500ms，更保守地删除对象
-                 if (inactive_time > 500) {
-                     ESP_LOGI(TAG, "LVGL显示已空闲 %lu ms，安全删除", inactive_time);
-                     break;
-                 }
- 
-                 wait_count += check_interval_ms;
-             }
- 
-             if (wait_count >= max_wait_ms) {
-                 ESP_LOGW(TAG, "等待LVGL空闲超时，强制删除");
-             }
-         } else {
-             // 后备方案：如果无法获取display，使用固定延迟
-             vTaskDelay(pdMS_TO_TICKS(200));
-         }
- 
-         // 安全删除LVGL对象（增加延迟避免释放后使用）
+         // 只隐藏并暂停，解析结果留在缓存中；隐藏对象不参与绘制，共享缓冲区可立即复用
          lv_lock();
-         lv_obj_del(g_lottie_obj);
+         _lottie_deactivate_current();
          lv_unlock();
          g_lottie_obj = NULL;
- 
-         // 增加等待时间，确保LVGL主循环完全处理完删除操作
-         vTaskDelay(pdMS_TO_TICKS(300));
      }
+ }
  
-     if (g_lottie_buffer) {
-         heap_caps_free(g_lottie_buffer);
-         g_lottie_buffer = NULL;
- 
-         // 等待内存完全释放
-         vTaskDelay(pdMS_TO_TICKS(50));
-     }
+
+ void xn_lottie_manager_set_parent(lv_obj_t *parent)
+ {
+     g_anim_parent = parent;
  }
  
  void lottie_manager_hide(void)
@@ -714,6 +983,29 @@
      return true;
  }
  
+ bool lottie_manager_preload_anim(int anim_type)
+ {
+     if (!g_initialized || !g_cmd_queue) {
+         ESP_LOGE(TAG, "管理器未初始化");
+         return false;
+     }
+ 
+     if (anim_type < 0 || anim_type >= ANIM_CONFIG_COUNT || !anim_configs[anim_type].file_path) {
+         ESP_LOGE(TAG, "无效的动画类型: %d", anim_type);
+         return false;
+     }
+ 
+     lottie_cmd_t cmd;
+     cmd.type = LOTTIE_CMD_PRELOAD;
+     cmd.data.play.anim_type = anim_type;
+ 
+     if (xQueueSend(g_cmd_queue, &cmd, pdMS_TO_TICKS(100)) != pdTRUE) {
+         ESP_LOGE(TAG, "发送预加载命令失败，动画类型: %d", anim_type);
+         return false;
+     }
+     return true;
+ }
+ 
  void lottie_manager_stop_anim(int anim_type)
  {
      if (!g_initialized || !g_cmd_queue) {
@@ -732,6 +1024,116 @@
      }
  }
  
+ // 资源加载器读完图片文件的回调（加载器任务中执行）
+ static void _lottie_image_done_cb(const asset_loader_result_t *result, void *user_ctx)
+ {
+     lottie_cmd_t cmd;
+     cmd.type = LOTTIE_CMD_IMAGE_LOADED;
+     cmd.data.loaded.tag = (uint32_t)(uintptr_t)user_ctx;
+     cmd.data.loaded.data = result->data;
+     cmd.data.loaded.size = result->size;
+     cmd.data.loaded.err = result->err;
+ 
+     if (xQueueSend(g_cmd_queue, &cmd, pdMS_TO_TICKS(1000)) != pdTRUE) {
+         ESP_LOGE(TAG, "发送图片加载完成命令失败: %s", result->path);
+         asset_loader_free(result->data);
+     }
+ }
+ 
+ // 提交图片读取（动画任务中执行），路径可带 LVGL 盘符（如 "S:/spiffs/a.png"）
+ static void _lottie_image_request(const char *img_path, uint16_t width, uint16_t height)
+ {
+     if (img_path[0] != '\0' && img_path[1] == ':') {
+         img_path += 2;
+     }
+ 
+     g_image_seq++;
+     g_image_width = width;
+     g_image_height = height;
+ 
+     esp_err_t ret = asset_loader_read(img_path, _lottie_image_done_cb, (void *)(uintptr_t)g_image_seq);
+     if (ret != ESP_OK) {
+         ESP_LOGE(TAG, "❌ 提交图片读取失败: %s (%s)", img_path, esp_err_to_name(ret));
+     }
+ }
+ 
+ // 删除当前图片对象并释放文件内容（需持有 lv_lock）
+ static void _lottie_image_release(void)
+ {
+     if (g_image_obj) {
+         lv_obj_delete(g_image_obj);
+         g_image_obj = NULL;
+     }
+     if (g_image_data) {
+         lv_image_cache_drop(&g_image_dsc);
+         asset_loader_free(g_image_data);
+         g_image_data = NULL;
+     }
+ }
+ 
+ // 图片读完后显示（动画任务中执行）：LVGL 格式 (.bin) 直接引用像素数据，其他格式交给已注册的解码器
+ static void _lottie_image_show(const lottie_cmd_t *cmd)
+ {
+     uint8_t *data = cmd->data.loaded.data;
+     size_t size = cmd->data.loaded.size;
+ 
+     if (cmd->data.loaded.tag != g_image_seq) {
+         asset_loader_free(data);    // 读取期间图片已被隐藏或替换
+         return;
+     }
+     if (cmd->data.loaded.err != ESP_OK) {
+         ESP_LOGE(TAG, "❌ 读取图片失败: %s", esp_err_to_name(cmd->data.loaded.err));
+         return;
+     }
+ 
+     lv_lock();
+     if (g_lottie_obj) {
+         lv_obj_add_flag(g_lottie_obj, LV_OBJ_FLAG_HIDDEN);
+     }
+     _lottie_image_release();
+ 
+     memset(&g_image_dsc, 0, sizeof(g_image_dsc));
+     const lv_image_header_t *header = (const lv_image_header_t *)data;
+     if (size > sizeof(*header) && header->magic == LV_IMAGE_HEADER_MAGIC) {
+         g_image_dsc.header = *header;
+         g_image_dsc.data = data + sizeof(*header);
+         g_image_dsc.data_size = size - sizeof(*header);
+     } else {
+         g_image_dsc.header.magic = LV_IMAGE_HEADER_MAGIC;
+         g_image_dsc.header.cf = LV_COLOR_FORMAT_RAW;
+         g_image_dsc.data = data;
+         g_image_dsc.data_size = size;
+     }
+     g_image_data = data;
+ 
+     g_image_obj = lv_image_create(lv_screen_active());
+     if (g_image_obj) {
+         lv_image_set_src(g_image_obj, &g_image_dsc);
+         if (g_image_width > 0 && g_image_height > 0) {
+             lv_obj_set_size(g_image_obj, g_image_width, g_image_height);
+         }
+         lv_obj_center(g_image_obj);
+         ESP_LOGI(TAG, "✅ 图片显示成功 (%u 字节)", (unsigned)size);
+     } else {
+         ESP_LOGE(TAG, "❌ 创建图片对象失败");
+     }
+     lv_unlock();
+ }
+ 
+ // 隐藏图片并恢复动画（动画任务中执行）
+ static void _lottie_image_hide(void)
+ {
+     g_image_seq++;  // 尚在读取中的图片读完后直接丢弃
+ 
+     lv_lock();
+     _lottie_image_release();
+     if (g_lottie_obj) {
+         lv_obj_clear_flag(g_lottie_obj, LV_OBJ_FLAG_HIDDEN);
+         ESP_LOGI(TAG, "已恢复Lottie动画");
+     }
+     lv_unlock();
+ }
+ 
  bool lottie_manager_show_image(const char *img_path, uint16_t width, uint16_t height)
  {
      if (!g_initialized) {
@@ -782,7 +1184,7 @@
 
 // ---------------- Lottie 应用初始化封装 ----------------
 
-static esp_err_t xn_lottie_mount_spiffs(void)
+esp_err_t xn_lottie_manager_mount_storage(void)
 {
     esp_vfs_spiffs_conf_t conf = {
         .base_path = "/lottie",
@@ -799,16 +1201,71 @@ static esp_err_t xn_lottie_mount_spiffs(void)
     return ret;
 }
 
+esp_err_t xn_lottie_manager_get_stats(xn_lottie_stats_t *stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!g_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(g_anim_mutex, portMAX_DELAY);
+    *stats = g_stats;
+    stats->avg_switch_us = g_stats.switch_count ?
+                           (uint32_t)(g_switch_total_us / g_stats.switch_count) : 0;
+    stats->cached_count = 0;
+    for (int i = 0; i < LOTTIE_CACHE_MAX_ENTRIES; i++) {
+        if (g_cache[i].obj) {
+            stats->cached_count++;
+        }
+    }
+    stats->cache_bytes = g_cache_bytes;
+    stats->cache_budget_bytes = g_cache_budget;
+    stats->render_pool_bytes = g_lottie_buffer_size;
+    stats->prerender_active = lottie_frames_is_playing();
+
+    // 渲染 CPU 占用：统计窗口为上次调用到现在
+    int64_t now_us = esp_timer_get_time();
+    uint64_t busy_us = g_live_busy_us + lottie_frames_get_busy_us();
+    int64_t window_us = now_us - g_cpu_window_start_us;
+    stats->render_cpu_permille = window_us > 0 ?
+                                 (uint32_t)((busy_us - g_cpu_window_busy_us) * 1000 / window_us) : 0;
+    g_cpu_window_start_us = now_us;
+    g_cpu_window_busy_us = busy_us;
+    xSemaphoreGive(g_anim_mutex);
+
+    size_t psram_total = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
+    size_t psram_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM);
+    stats->psram_high_water_bytes = psram_total - psram_min_free;
+    return ESP_OK;
+}
+
+void xn_lottie_manager_set_prerender(bool enable)
+{
+    g_prerender_enabled = enable;
+    ESP_LOGI(TAG, "预渲染序列播放: %s", enable ? "开启" : "关闭（实时渲染）");
+}
+
 esp_err_t xn_lottie_manager_init(const xn_lottie_app_config_t *cfg)
 {
-    (void)cfg; // 目前暂未使用，预留给多屏等扩展
+    if (cfg && cfg->cache_budget_bytes > 0) {
+        g_cache_budget = cfg->cache_budget_bytes;
+    }
 
-    esp_err_t ret = xn_lottie_mount_spiffs();
+    esp_err_t ret = xn_lottie_manager_mount_storage();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "挂载 Lottie SPIFFS 失败: %s", esp_err_to_name(ret));
         return ret;
     }
 
+    // 动画 JSON 与图片都经资源加载器在后台读取（已初始化时直接返回）
+    ret = asset_loader_init(NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "资源加载器初始化失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
     // 初始化 LVGL + 显示 / 触摸驱动
     ret = lvgl_driver_init();
     if (ret != ESP_OK) {
@@ -816,6 +1273,9 @@ esp_err_t xn_lottie_manager_init(const xn_lottie_app_config_t *cfg)
         return ret;
     }
 
+    // 预渲染帧序列分区可选，不存在时全部走实时渲染
+    (void)lottie_frames_init();
+
     // 初始化 Lottie 管理器本身
     if (!lottie_manager_init()) {
         ESP_LOGE(TAG, "Lottie 管理器初始化失败");
@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Lottie 预渲染帧打包工具
+
+把选定的 Lottie 动画在主机上光栅化为 RGB565 帧序列，按关键帧 + 差分帧压缩，
+打包成 lottie_frames 分区镜像，供 xn_lottie_manager 通过 esp_partition_mmap
+直接映射播放，设备端不再运行 ThorVG 矢量渲染。
+
+镜像格式（小端）：
+    header  (16 B) : magic "XNLF", u16 version, u16 count, u32 image_size, u32 reserved
+    entry[] (32 B) : char name[16], u16 width, u16 height, u16 frame_count, u16 fps,
+                     u32 table_offset, u32 reserved
+    table          : 每个序列 u32[frame_count + 1] 帧偏移（相对镜像起始，4 字节对齐）
+    frame          : u16 指令流，高 2 位操作码、低 14 位像素数
+                       0 = SKIP n  沿用上一帧像素
+                       1 = COPY n  随后 n 个像素原样拷贝
+                       2 = FILL n  随后 1 个像素重复 n 次
+                     第 0 帧及每隔 --keyframe 帧为关键帧（不含 SKIP），其余为差分帧
+
+依赖：rlottie-python（渲染）、Pillow、numpy
+    pip install rlottie-python pillow numpy
+
+用法：
+    python pack_frames.py --input ../lottie_spiffs --output lottie_frames.bin \\
+        --anim speak:240x166 --anim emoji_think:240x240 --fps 10 --size 0x400000
+
+--optional：缺少渲染依赖时输出空镜像（count = 0）而不是报错，设备端会回退到实时渲染。
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b"XNLF"
+VERSION = 1
+HEADER_FMT = "<4sHHII"
+ENTRY_FMT = "<16sHHHHII"
+HEADER_SIZE = struct.calcsize(HEADER_FMT)
+ENTRY_SIZE = struct.calcsize(ENTRY_FMT)
+
+OP_SKIP = 0
+OP_COPY = 1
+OP_FILL = 2
+MAX_RUN = 0x3FFF
+MIN_FILL = 3        # 短于该长度的重复像素并入 COPY，避免指令开销
+
+
+def align4(value):
+    return (value + 3) & ~3
+
+
+def parse_anim(spec):
+    """解析 name:WxH[:fps]"""
+    parts = spec.split(":")
+    if len(parts) not in (2, 3) or "x" not in parts[1]:
+        raise argparse.ArgumentTypeError("格式应为 name:WxH[:fps]，例如 speak:400x277")
+    width, height = (int(v) for v in parts[1].lower().split("x"))
+    fps = int(parts[2]) if len(parts) == 3 else 0
+    if len(parts[0].encode("utf-8")) > 15:
+        raise argparse.ArgumentTypeError("动画名称过长（最多15字节）: %s" % parts[0])
+    return parts[0], width, height, fps
+
+
+def emit_runs(out, op, count, payload=None):
+    while count > 0:
+        n = min(count, MAX_RUN)
+        out.append((op << 14) | n)
+        if op == OP_COPY:
+            out.extend(payload[:n])
+            payload = payload[n:]
+        elif op == OP_FILL:
+            out.append(payload)
+        count -= n
+
+
+def encode_pixels(out, seg):
+    """把一段需要写入的像素编码为 COPY/FILL 指令"""
+    import numpy as np
+
+    bounds = np.flatnonzero(np.diff(seg)) + 1
+    starts = np.concatenate(([0], bounds))
+    ends = np.concatenate((bounds, [len(seg)]))
+
+    literal_start = None
+    for start, end in zip(starts.tolist(), ends.tolist()):
+        if end - start >= MIN_FILL:
+            if literal_start is not None:
+                emit_runs(out, OP_COPY, start - literal_start, seg[literal_start:start].tolist())
+                literal_start = None
+            emit_runs(out, OP_FILL, end - start, int(seg[start]))
+        elif literal_start is None:
+            literal_start = start
+    if literal_start is not None:
+        emit_runs(out, OP_COPY, len(seg) - literal_start, seg[literal_start:].tolist())
+
+
+def encode_frame(cur, prev):
+    """prev 为 None 时编码关键帧，否则只编码与上一帧不同的像素"""
+    import numpy as np
+
+    out = []
+    if prev is None:
+        encode_pixels(out, cur)
+    else:
+        changed = cur != prev
+        edges = np.flatnonzero(np.diff(changed.astype(np.int8))) + 1
+        starts = np.concatenate(([0], edges)).tolist()
+        ends = np.concatenate((edges, [len(cur)])).tolist()
+        for start, end in zip(starts, ends):
+            if changed[start]:
+                encode_pixels(out, cur[start:end])
+            else:
+                emit_runs(out, OP_SKIP, end - start)
+    return struct.pack("<%dH" % len(out), *out)
+
+
+def render_frames(path, width, height, fps, bg):
+    """用 rlottie 按目标帧率采样渲染，返回 RGB565 帧列表（numpy uint16）"""
+    import numpy as np
+    from PIL import Image
+    from rlottie_python import LottieAnimation
+
+    anim = LottieAnimation.from_file(path)
+    total = anim.lottie_animation_get_totalframe()
+    src_fps = anim.lottie_animation_get_framerate()
+    count = max(1, int(round(total / src_fps * fps)))
+
+    frames = []
+    for i in range(count):
+        frame_num = min(total - 1, int(round(i * src_fps / fps)))
+        rgba = anim.render_pillow_frame(frame_num=frame_num, width=width, height=height)
+        canvas = Image.new("RGBA", (width, height), bg)
+        canvas.alpha_composite(rgba.convert("RGBA"))
+        rgb = np.asarray(canvas.convert("RGB"), dtype=np.uint16)
+        r, g, b = rgb[:, :, 0], rgb[:, :, 1], rgb[:, :, 2]
+        frames.append((((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3)).astype(np.uint16).ravel())
+    return frames
+
+
+def build_image(input_dir, anims, default_fps, keyframe, bg):
+    entries = []
+    blobs = bytearray()
+    offset = align4(HEADER_SIZE + ENTRY_SIZE * len(anims))
+
+    for name, width, height, fps in anims:
+        fps = fps or default_fps
+        path = os.path.join(input_dir, name + ".json")
+        frames = render_frames(path, width, height, fps, bg)
+
+        encoded = []
+        prev = None
+        for i, frame in enumerate(frames):
+            key = i % keyframe == 0
+            encoded.append(encode_frame(frame, None if key else prev))
+            prev = frame
+
+        table_offset = offset
+        data_offset = align4(table_offset + 4 * (len(encoded) + 1))
+        table = []
+        for blob in encoded:
+            table.append(data_offset)
+            data_offset = align4(data_offset + len(blob))
+        table.append(data_offset)
+
+        chunk = bytearray(data_offset - table_offset)
+        struct.pack_into("<%dI" % len(table), chunk, 0, *table)
+        for start, blob in zip(table, encoded):
+            chunk[start - table_offset:start - table_offset + len(blob)] = blob
+        blobs += chunk
+
+        raw = width * height * 2 * len(frames)
+        print("  %-16s %dx%d %3d 帧 @ %2d FPS  %8d -> %7d bytes (%.1f%%)" %
+              (name, width, height, len(frames), fps, raw, len(chunk), 100.0 * len(chunk) / raw))
+
+        entries.append(struct.pack(ENTRY_FMT, name.encode("utf-8"), width, height,
+                                   len(frames), fps, table_offset, 0))
+        offset = data_offset
+
+    image = bytearray(align4(HEADER_SIZE + ENTRY_SIZE * len(anims)))
+    struct.pack_into(HEADER_FMT, image, 0, MAGIC, VERSION, len(anims), offset, 0)
+    for i, entry in enumerate(entries):
+        image[HEADER_SIZE + i * ENTRY_SIZE:HEADER_SIZE + (i + 1) * ENTRY_SIZE] = entry
+    image += blobs
+    return bytes(image)
+
+
+def empty_image():
+    image = bytearray(HEADER_SIZE)
+    struct.pack_into(HEADER_FMT, image, 0, MAGIC, VERSION, 0, HEADER_SIZE, 0)
+    return bytes(image)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="打包 lottie_frames 预渲染帧分区镜像")
+    parser.add_argument("--input", required=True, help="Lottie JSON 源目录")
+    parser.add_argument("--output", required=True, help="输出镜像路径")
+    parser.add_argument("--anim", action="append", type=parse_anim, default=[],
+                        help="预渲染的动画 name:WxH[:fps]，尺寸须与设备端配置表一致，可重复")
+    parser.add_argument("--fps", type=int, default=10, help="默认播放帧率（与 LVGL 刷新周期匹配）")
+    parser.add_argument("--keyframe", type=int, default=30, help="关键帧间隔（帧）")
+    parser.add_argument("--bg", default="#ffffff", help="背景色（与屏幕背景一致，透明像素与之混合）")
+    parser.add_argument("--size", type=lambda v: int(v, 0), default=0,
+                        help="分区大小（用于容量校验，0 表示不校验）")
+    parser.add_argument("--optional", action="store_true",
+                        help="缺少渲染依赖时输出空镜像而不是报错")
+    args = parser.parse_args()
+
+    try:
+        if not args.anim:
+            image = empty_image()
+        else:
+            image = build_image(args.input, args.anim, args.fps, max(1, args.keyframe), args.bg)
+    except ImportError as err:
+        if not args.optional:
+            print("错误: 缺少依赖 (%s)，请执行 pip install rlottie-python pillow numpy" % err,
+                  file=sys.stderr)
+            return 1
+        print("警告: 缺少依赖 (%s)，生成空的 lottie_frames 镜像，设备端将使用实时渲染" % err)
+        image = empty_image()
+    except (OSError, ValueError) as err:
+        print("错误: %s" % err, file=sys.stderr)
+        return 1
+
+    if args.size and len(image) > args.size:
+        print("错误: 镜像 %d 字节超出分区大小 %d 字节" % (len(image), args.size), file=sys.stderr)
+        return 1
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "wb") as fp:
+        fp.write(image)
+
+    print("lottie_frames 镜像: %s (%d bytes)" % (args.output, len(image)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -28,15 +28,91 @@
  * 配置宏定义
  *********************/
 
-// LVGL Tick 定时器周期 (毫秒)
-// 【性能优化】调整为100ms（10 FPS）以降低CPU负载
-#define LVGL_TICK_PERIOD_MS     100
+// LVGL 任务最长睡眠时间 (毫秒)
+// 任务按 lv_timer_handler() 返回的下一个定时器到期时间睡眠，界面修改/触摸/外部唤醒会提前打断；
+// 这里只是兜底上限，防止漏掉唤醒时界面长时间不更新
+#define LVGL_TASK_MAX_SLEEP_MS  500
+
+// 帧间隔统计上限 (毫秒)：超过该间隔的两帧视为界面曾经静止，不计入抖动统计
+#define LVGL_FRAME_GAP_MAX_MS   500
 
 // LVGL 显示缓冲区大小 (像素数)
 // 【性能优化】设置为屏幕的1/10，减少刷新次数，降低CPU负载
 // 每次可刷新更多像素，减少刷新回调次数（内存增加约8.5KB PSRAM）
 #define LVGL_BUFFER_SIZE        (EXAMPLE_LCD_WIDTH * EXAMPLE_LCD_HEIGHT / 20)
 
+// 环形刷新模式：内部 RAM 渲染缓冲和每个 DMA tile 的行数（整屏宽度，412x10 约 8KB）
+#define LVGL_TILE_LINES         10
+
+// 环形刷新模式：DMA tile 数量（传输 tile N 的同时渲染 tile N+1）
+#define LVGL_TILE_RING_DEPTH    3
+
+// PSRAM 刷新模式：等待传输完成的上限 (毫秒)，超过后放弃在途传输（迟到的完成中断被忽略）
+#define LVGL_FLUSH_WAIT_MAX_MS  1000
+
+// 性能模式数量：每个模式有独立的刷新/动画帧间隔下限和 CPU 统计（模式号含义由应用层定义）
+#define LVGL_PERF_MODE_MAX      8
+
+// 帧间隔为 0 表示冻结：屏幕不再刷新 / 动画停在当前帧
+#define LVGL_FRAME_FREEZE       0
+
+/*********************
+ * 类型定义
+ *********************/
+
+// 显示刷新模式
+typedef enum {
+    LVGL_FLUSH_MODE_PSRAM_DOUBLE = 0,   // 两块 PSRAM 局部缓冲，传输完成后才释放缓冲（原方案）
+    LVGL_FLUSH_MODE_INTERNAL_RING,      // 内部 RAM 渲染 + DMA tile 环形队列，传输与渲染并行（默认）
+    LVGL_FLUSH_MODE_MAX,
+} lvgl_flush_mode_t;
+
+// 显示性能统计（统计窗口为上次重置到现在）
+typedef struct {
+    lvgl_flush_mode_t mode;     // 当前刷新模式
+    uint32_t frames;            // 完成的帧数
+    uint32_t fps_x10;           // 帧率 x10
+    uint32_t frame_avg_us;      // 每帧平均耗时（开始刷新到最后一块提交）
+    uint32_t render_avg_us;     // 每帧平均渲染耗时（扣除 flush 回调；PSRAM 模式含等待传输）
+    uint32_t tile_wait_avg_us;  // 每帧平均等待空闲 tile 的耗时（环形模式）
+    uint32_t flush_count;       // 完成的传输次数
+    uint32_t flush_avg_us;      // 每次传输平均耗时（入队到 DMA 完成）
+    uint32_t flush_errors;      // 入队失败/超时次数
+    uint32_t pixels_per_s;      // 每秒刷新到屏幕的像素数（衡量脏区域大小）
+    uint32_t pixels_per_frame_avg; // 每帧平均刷新像素数（整屏为 412*412）
+    uint32_t frame_interval_avg_us; // 连续帧平均间隔
+    uint32_t frame_jitter_us;   // 连续帧间隔标准差（动画帧时间抖动）
+    uint32_t frame_interval_max_us; // 连续帧最大间隔
+    uint32_t wakeups_per_s_x10; // LVGL 任务每秒唤醒次数 x10
+    uint32_t idle_wakeups_per_s_x10; // 其中没有渲染任何帧的唤醒次数 x10
+    uint32_t notify_wakeups;    // 被通知提前唤醒的次数
+} lvgl_display_stats_t;
+
+// 性能模式统计（统计窗口为上次重置到现在）
+typedef struct {
+    uint32_t refr_period_ms;    // 屏幕刷新间隔下限（LVGL_FRAME_FREEZE 为冻结）
+    uint32_t anim_period_ms;    // 动画帧间隔下限（LVGL_FRAME_FREEZE 为冻结）
+    uint32_t active_ms;         // 处于该模式的时长
+    uint32_t frames;            // 该模式下完成的帧数
+    uint32_t fps_x10;           // 该模式下的帧率 x10
+    uint32_t busy_permille;     // LVGL 任务（定时器、动画渲染/解码、刷新）占所在核心的千分比
+    uint32_t skipped_frames;    // 因帧间隔下限跳过的动画帧数
+    uint32_t saved_ms;          // 跳过的动画帧按平均渲染耗时估算让出的 CPU 时间
+} lvgl_perf_mode_stats_t;
+
+// 唤醒钩子：LVGL 任务每轮处理定时器前在持有 lv_lock 的状态下调用
+typedef void (*lvgl_wake_hook_t)(void);
+
+// 基准测试结果
+typedef struct {
+    lvgl_flush_mode_t mode;     // 刷新模式
+    uint32_t frames;            // 渲染帧数
+    uint32_t elapsed_ms;        // 总耗时（含最后一次传输完成）
+    uint32_t fps_x10;           // 帧率 x10
+    uint32_t render_avg_us;     // 每帧平均渲染耗时
+    uint32_t flush_avg_us;      // 每次传输平均耗时
+} lvgl_bench_result_t;
+
 /*********************
  * 全局变量声明
  *********************/
@@ -63,10 +139,93 @@ esp_err_t lvgl_driver_init(void);
 void lvgl_driver_deinit(void);
 
 /**
- * @brief LVGL tick增加回调函数
- * @param arg 未使用的参数
+ * @brief 切换显示刷新模式（会重新分配显示缓冲区）
+ * @param mode 刷新模式
+ * @return ESP_OK 成功, ESP_ERR_NO_MEM 内存不足（保持原模式）, ESP_ERR_TIMEOUT 等待传输结束超时
+ */
+esp_err_t lvgl_driver_set_flush_mode(lvgl_flush_mode_t mode);
+
+/**
+ * @brief 获取当前显示刷新模式
+ */
+lvgl_flush_mode_t lvgl_driver_get_flush_mode(void);
+
+/**
+ * @brief 获取显示性能统计
+ * @param stats 输出统计
+ * @param reset 读取后是否开始新的统计窗口
+ * @return ESP_OK 成功
+ */
+esp_err_t lvgl_driver_get_stats(lvgl_display_stats_t *stats, bool reset);
+
+/**
+ * @brief 等待所有已提交的面板传输完成
+ * @param timeout_ms 超时时间
+ * @return ESP_OK 成功, ESP_ERR_TIMEOUT 超时
+ */
+esp_err_t lvgl_driver_wait_flush_done(uint32_t timeout_ms);
+
+/**
+ * @brief 运行显示基准测试：在测试屏幕上分别用两种刷新模式连续整屏重绘，并把对比结果显示在屏幕上
+ * @note 阻塞调用，不能在 LVGL 任务中调用；结束后恢复原屏幕和原刷新模式
+ * @param frames 每种模式重绘的帧数
+ * @param results 输出结果，按 lvgl_flush_mode_t 索引，可为 NULL
+ * @return ESP_OK 成功
+ */
+esp_err_t lvgl_driver_run_benchmark(uint32_t frames, lvgl_bench_result_t results[LVGL_FLUSH_MODE_MAX]);
+
+/**
+ * @brief 立即唤醒 LVGL 任务处理定时器和刷新
+ * @note 失效区域会自动唤醒，只有改动不产生重绘（如启动动画、创建定时器）时才需要手动调用
+ */
+void lvgl_driver_wake(void);
+
+/**
+ * @brief 在中断中唤醒 LVGL 任务（如触摸中断）
+ */
+void lvgl_driver_wake_from_isr(void);
+
+/**
+ * @brief 设置唤醒钩子，用于在 LVGL 任务中消费其他任务无锁投递的数据
+ * @note 生产者投递后调用 lvgl_driver_wake() 即可让钩子尽快执行；钩子应在无数据时立即返回
+ * @param hook 钩子函数，NULL 取消
+ */
+void lvgl_driver_set_wake_hook(lvgl_wake_hook_t hook);
+
+/**
+ * @brief 切换性能模式（无锁，可在任意任务中调用，不会等待 LVGL 任务）
+ * @note 由 LVGL 任务在下一轮循环开始时生效：刷新间隔作用于显示刷新定时器，动画间隔由动画播放器读取
+ * @param mode 模式号（< LVGL_PERF_MODE_MAX），用于分别统计
+ * @param refr_period_ms 屏幕刷新间隔下限，LVGL_FRAME_FREEZE 冻结
+ * @param anim_period_ms 动画帧间隔下限，LVGL_FRAME_FREEZE 冻结
+ */
+void lvgl_driver_set_perf_mode(uint8_t mode, uint32_t refr_period_ms, uint32_t anim_period_ms);
+
+/**
+ * @brief 获取当前生效的动画帧间隔下限（供动画播放器在 LVGL 任务中调用）
+ * @return 毫秒，LVGL_FRAME_FREEZE 表示冻结
+ */
+uint32_t lvgl_driver_get_anim_period(void);
+
+/**
+ * @brief 动画播放器因帧间隔下限跳过一帧时调用，计入当前模式的让出时间（在 LVGL 任务中调用）
+ * @param render_us 播放器自身渲染/解码一帧的平均耗时，驱动会再加上平均每帧刷新耗时
+ */
+void lvgl_driver_note_skipped_frame(uint32_t render_us);
+
+/**
+ * @brief 获取各性能模式的统计
+ * @param stats 输出统计，按模式号索引
+ * @param reset 读取后是否开始新的统计窗口
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 参数为空
+ */
+esp_err_t lvgl_driver_get_perf_stats(lvgl_perf_mode_stats_t stats[LVGL_PERF_MODE_MAX], bool reset);
+
+/**
+ * @brief LVGL tick 回调函数，返回 esp_timer 毫秒时间
+ * @return 系统启动以来的毫秒数
  */
-void lvgl_tick_inc_cb(void *arg);
+uint32_t lvgl_tick_get_cb(void);
 
 /**
  * @brief LVGL显示刷新回调函数
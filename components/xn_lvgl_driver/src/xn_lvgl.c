@@ -9,6 +9,10 @@
 
 #include "xn_lvgl.h"
 #include "bsp_panel_spd2010.h"
+#include "esp_heap_caps.h"
+#include "esp_attr.h"
+#include "freertos/semphr.h"
+#include <math.h>
 
 /*********************
  * 静态变量定义
@@ -20,16 +24,96 @@ static const char *TAG = "LVGL_DRIVER";
 lv_display_t *g_lvgl_display = NULL;
 lv_indev_t *g_lvgl_indev = NULL;
 
-// ESP定时器句柄
-static esp_timer_handle_t lvgl_tick_timer = NULL;
-
-// 显示缓冲区
+// 显示缓冲区（PSRAM 双缓冲模式为两块局部缓冲；环形模式只用 buf1 作为内部 RAM 渲染缓冲）
 static uint8_t *lvgl_draw_buf1 = NULL;
 static uint8_t *lvgl_draw_buf2 = NULL;
 
+// 刷新流水线状态
+// 环形模式：flush 回调把渲染好的区域字节交换后拷入空闲 DMA tile 并立即入队传输，
+// 随即通知 LVGL 缓冲可用，于是 tile N 的传输与 tile N+1 的渲染并行；
+// 传输完成中断归还 tile。PSRAM 模式沿用原来的"传输完成才释放缓冲"。
+static struct {
+    lvgl_flush_mode_t mode;
+    uint8_t *tiles[LVGL_TILE_RING_DEPTH];           // 内部 DMA RAM tile
+    size_t tile_bytes;
+    SemaphoreHandle_t free_tiles;                   // 空闲 tile 计数
+    SemaphoreHandle_t flush_done;                   // PSRAM 模式：每次传输完成 give 一次
+    uint32_t head;                                  // 下一个写入的 tile
+    int64_t start_us[LVGL_TILE_RING_DEPTH];         // 各传输入队时间（按提交顺序完成）
+    uint32_t submit_idx;
+    uint32_t done_idx;
+    volatile uint32_t inflight;                     // 已入队未完成的传输数
+
+    // 统计（窗口累计）
+    int64_t window_start_us;
+    int64_t frame_start_us;
+    int64_t frame_flush_cb_us;                      // 当前帧在 flush 回调内花费的时间
+    uint32_t frames;
+    uint64_t frame_total_us;
+    uint64_t render_total_us;
+    uint64_t tile_wait_total_us;
+    uint64_t pixels;                                // 提交给屏幕的像素数（只在 LVGL 任务中累加）
+    volatile uint32_t flush_count;
+    volatile uint64_t flush_total_us;
+    uint32_t flush_errors;
+} s_flush = {
+    .mode = LVGL_FLUSH_MODE_INTERNAL_RING,
+};
+
+// 保护传输记录（flush 回调与传输完成中断可能在不同核心上）
+static portMUX_TYPE s_flush_lock = portMUX_INITIALIZER_UNLOCKED;
+
 // LVGL任务句柄
 static TaskHandle_t lvgl_task_handle = NULL;
 
+// 调度统计：任务唤醒次数与动画帧间隔（用于衡量帧时间抖动）
+static struct {
+    volatile uint32_t wakeups;                      // lv_timer_handler 调用次数
+    volatile uint32_t notify_wakeups;               // 其中被通知提前唤醒的次数
+    volatile uint32_t idle_wakeups;                 // 其中没有渲染任何帧的次数
+    int64_t last_frame_start_us;
+    uint32_t intervals;
+    uint64_t interval_total_us;
+    uint64_t interval_sq_total;                     // 帧间隔平方和（us^2），用于计算标准差
+    uint32_t interval_max_us;
+} s_sched = {0};
+
+// 触摸中断到达，LVGL 任务醒来后立即读取
+static volatile bool s_touch_irq = false;
+
+// 唤醒钩子：每轮 lv_timer_handler 之前持锁调用
+static volatile lvgl_wake_hook_t s_wake_hook = NULL;
+
+// 性能模式：请求由任意任务在自旋锁内写入，LVGL 任务在下一轮循环开始时应用；
+// 应用后的字段和统计只在 LVGL 任务（或持有 lv_lock 时）访问
+static portMUX_TYPE s_perf_lock = portMUX_INITIALIZER_UNLOCKED;
+static struct {
+    volatile uint32_t req_seq;                      // 每次请求加 1
+    uint8_t req_mode;
+    uint32_t req_refr_ms;
+    uint32_t req_anim_ms;
+
+    uint32_t applied_seq;
+    uint8_t mode;
+    uint32_t refr_period_ms;
+    uint32_t anim_period_ms;
+    int64_t mode_start_us;                          // 当前模式开始计时的时间
+    uint32_t mode_refr_ms[LVGL_PERF_MODE_MAX];      // 各模式最近一次生效的帧间隔
+    uint32_t mode_anim_ms[LVGL_PERF_MODE_MAX];
+    struct {
+        uint64_t active_us;
+        uint64_t busy_us;
+        uint64_t saved_us;
+        uint32_t frames;
+        uint32_t skipped;
+    } acc[LVGL_PERF_MODE_MAX];
+} s_perf = {
+    .refr_period_ms = LV_DEF_REFR_PERIOD,
+    .anim_period_ms = LV_DEF_REFR_PERIOD,
+    .mode_refr_ms = {LV_DEF_REFR_PERIOD},
+    .mode_anim_ms = {LV_DEF_REFR_PERIOD},
+};
+
 // LVGL任务栈（使用PSRAM）
 #define LVGL_TASK_STACK_SIZE (1024*64/sizeof(StackType_t))
 static EXT_RAM_BSS_ATTR StackType_t lvgl_task_stack[LVGL_TASK_STACK_SIZE];
@@ -40,8 +124,8 @@ static StaticTask_t lvgl_task_buffer;
  *********************/
 
 static esp_err_t lvgl_display_init(void);
+static esp_err_t lvgl_buffers_setup(lvgl_flush_mode_t mode);
 static esp_err_t lvgl_indev_init(void);
-static esp_err_t lvgl_tick_timer_init(void);
 static esp_err_t lvgl_task_init(void);
 static void lvgl_cleanup_resources(void);
 static void lvgl_timer_task(void *pvParameters);
@@ -50,29 +134,176 @@ static void lvgl_timer_task(void *pvParameters);
  * 回调函数实现
  *********************/
 
-void lvgl_tick_inc_cb(void *arg)
+uint32_t lvgl_tick_get_cb(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/* 面板传输完成中断：环形模式归还 tile，PSRAM 模式唤醒等待传输完成的 LVGL 任务 */
+static bool IRAM_ATTR lvgl_trans_done_cb(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
+{
+    BaseType_t woken = pdFALSE;
+    bool tracked = false;
+
+    portENTER_CRITICAL_ISR(&s_flush_lock);
+    if (s_flush.inflight > 0) {
+        s_flush.flush_total_us += esp_timer_get_time() - s_flush.start_us[s_flush.done_idx];
+        s_flush.done_idx = (s_flush.done_idx + 1) % LVGL_TILE_RING_DEPTH;
+        s_flush.flush_count++;
+        s_flush.inflight--;
+        tracked = true;
+    }
+    portEXIT_CRITICAL_ISR(&s_flush_lock);
+
+    if (s_flush.mode == LVGL_FLUSH_MODE_INTERNAL_RING) {
+        xSemaphoreGiveFromISR(s_flush.free_tiles, &woken);
+    } else if (tracked) {
+        // 由 lvgl_flush_wait_cb 在 LVGL 任务中消费，LVGL 随后自行清除 flushing 标志；
+        // 已被放弃的传输迟到完成时不再 give，否则下一次等待会提前返回
+        xSemaphoreGiveFromISR(s_flush.flush_done, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+/* LVGL 需要复用正在传输的缓冲时调用：阻塞等待传输完成，而不是忙等 flushing 标志
+ *
+ * 传输没完成就返回会让 LVGL 往 DMA 仍在读取的缓冲里渲染下一帧（撕裂），所以超时后继续等待；
+ * 超过 LVGL_FLUSH_WAIT_MAX_MS 视为传输丢失，清除在途记录并丢弃信号量里的残留计数，
+ * 迟到的完成中断不会再 give，下一帧的等待不会拿到上一帧的完成信号。 */
+static void lvgl_flush_wait_cb(lv_display_t *disp)
 {
-    lv_tick_inc(LVGL_TICK_PERIOD_MS);
+    (void)disp;
+    int64_t start_us = esp_timer_get_time();
+    while (xSemaphoreTake(s_flush.flush_done, pdMS_TO_TICKS(100)) != pdTRUE) {
+        s_flush.flush_errors++;
+        if (s_flush.inflight == 0) {
+            // 完成中断恰好在超时后到达（取走它的 give），或在途记录已被撤销
+            xSemaphoreTake(s_flush.flush_done, 0);
+            return;
+        }
+        if (esp_timer_get_time() - start_us < LVGL_FLUSH_WAIT_MAX_MS * 1000) {
+            ESP_LOGW(TAG, "⚠️  等待传输完成超时，继续等待");
+            continue;
+        }
+
+        portENTER_CRITICAL(&s_flush_lock);
+        s_flush.inflight = 0;
+        s_flush.done_idx = s_flush.submit_idx;
+        portEXIT_CRITICAL(&s_flush_lock);
+        xSemaphoreTake(s_flush.flush_done, 0);
+        ESP_LOGE(TAG, "❌ 传输 %d ms 未完成，放弃本次传输", LVGL_FLUSH_WAIT_MAX_MS);
+        return;
+    }
 }
 
-/* SPD2010区域对齐回调函数 - 处理4字节对齐要求 */
+/* 有区域失效时唤醒 LVGL 任务（其他任务在 lv_lock 内修改了界面），解锁后立即刷新 */
+static void lvgl_invalidate_wake_cb(lv_event_t *e)
+{
+    (void)e;
+    if (lvgl_task_handle && xTaskGetCurrentTaskHandle() != lvgl_task_handle) {
+        xTaskNotifyGive(lvgl_task_handle);
+    }
+}
+
+/* 一帧开始刷新 */
+static void lvgl_refr_start_cb(lv_event_t *e)
+{
+    (void)e;
+    int64_t now = esp_timer_get_time();
+    s_flush.frame_start_us = now;
+    s_flush.frame_flush_cb_us = 0;
+
+    // 连续帧之间的间隔；间隔过长说明界面曾经静止，不计入抖动
+    int64_t interval = now - s_sched.last_frame_start_us;
+    if (s_sched.last_frame_start_us > 0 && interval < LVGL_FRAME_GAP_MAX_MS * 1000) {
+        s_sched.intervals++;
+        s_sched.interval_total_us += interval;
+        s_sched.interval_sq_total += (uint64_t)(interval * interval);
+        if (interval > s_sched.interval_max_us) {
+            s_sched.interval_max_us = (uint32_t)interval;
+        }
+    }
+    s_sched.last_frame_start_us = now;
+}
+
+/* SPD2010区域对齐回调函数 - 列地址起点和宽度都必须是4的倍数 */
 static void lvgl_rounder_cb(lv_event_t *e)
 {
-    (void)lv_event_get_target(e);  // 避免未使用变量警告
     lv_area_t *area = lv_event_get_param(e);
+    lv_display_t *disp = lv_event_get_target(e);
+    int32_t hor_res = lv_display_get_horizontal_resolution(disp);
+
+    // 起点向下对齐到4的倍数，终点向上对齐到4N+3
+    area->x1 &= ~3;
+    area->x2 |= 3;
+
+    // 屏幕宽度不是4的倍数时，终点超出屏幕则整体左移，保证宽度仍是4的倍数
+    if (area->x2 >= hor_res) {
+        area->x2 = hor_res - 1;
+        area->x1 = (area->x2 + 1 - (((area->x2 - area->x1 + 1) + 3) & ~3));
+        if (area->x1 < 0) {
+            area->x1 = 0;
+        }
+    }
+}
 
-    // SPD2010需要4字节对齐
-    uint16_t x1 = area->x1;
-    uint16_t x2 = area->x2;
+/* 字节交换拷贝（SPD2010是大端序），一次处理两个像素 */
+static void lvgl_copy_swap_rgb565(uint8_t *dst, const uint8_t *src, uint32_t pixel_count)
+{
+    const uint32_t *s32 = (const uint32_t *)src;
+    uint32_t *d32 = (uint32_t *)dst;
+    uint32_t pairs = pixel_count / 2;
 
-    // 将起始坐标向下对齐到4的倍数
-    area->x1 = (x1 >> 2) << 2;
-    // 将结束坐标向上对齐到4N+3
-    area->x2 = ((x2 >> 2) << 2) + 3;
+    for (uint32_t i = 0; i < pairs; i++) {
+        uint32_t v = s32[i];
+        d32[i] = ((v & 0x00FF00FFu) << 8) | ((v >> 8) & 0x00FF00FFu);
+    }
+    if (pixel_count & 1) {
+        const uint16_t *s16 = (const uint16_t *)src;
+        uint16_t *d16 = (uint16_t *)dst;
+        uint16_t v = s16[pixel_count - 1];
+        d16[pixel_count - 1] = (uint16_t)((v << 8) | (v >> 8));
+    }
+}
+
+/* 记录即将入队的传输 */
+static void lvgl_flush_submit_begin(void)
+{
+    portENTER_CRITICAL(&s_flush_lock);
+    s_flush.start_us[s_flush.submit_idx] = esp_timer_get_time();
+    s_flush.submit_idx = (s_flush.submit_idx + 1) % LVGL_TILE_RING_DEPTH;
+    s_flush.inflight++;
+    portEXIT_CRITICAL(&s_flush_lock);
+}
+
+/* 传输入队失败，撤销记录 */
+static void lvgl_flush_submit_cancel(void)
+{
+    portENTER_CRITICAL(&s_flush_lock);
+    s_flush.inflight--;
+    s_flush.submit_idx = (s_flush.submit_idx + LVGL_TILE_RING_DEPTH - 1) % LVGL_TILE_RING_DEPTH;
+    s_flush.flush_errors++;
+    portEXIT_CRITICAL(&s_flush_lock);
+}
+
+/* 记录一次 flush 回调耗时；最后一块刷新时结算整帧 */
+static void lvgl_flush_account(lv_display_t *disp, int64_t cb_start_us)
+{
+    int64_t now = esp_timer_get_time();
+    s_flush.frame_flush_cb_us += now - cb_start_us;
+
+    if (lv_display_flush_is_last(disp) && s_flush.frame_start_us > 0) {
+        int64_t frame_us = now - s_flush.frame_start_us;
+        s_flush.frames++;
+        s_flush.frame_total_us += frame_us;
+        s_flush.render_total_us += frame_us - s_flush.frame_flush_cb_us;
+        s_flush.frame_start_us = 0;
+    }
 }
 
 void lvgl_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
 {
+    int64_t cb_start_us = esp_timer_get_time();
     esp_lcd_panel_handle_t panel_handle = lv_display_get_user_data(disp);
     int offsetx1 = area->x1;
     int offsetx2 = area->x2;
@@ -81,32 +312,55 @@ void lvgl_flush_cb(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map)
 
     // 计算刷新像素数量
     uint32_t pixel_count = (offsetx2 + 1 - offsetx1) * (offsety2 + 1 - offsety1);
+    s_flush.pixels += pixel_count;
+
+    if (s_flush.mode == LVGL_FLUSH_MODE_INTERNAL_RING) {
+        // 等待空闲 tile（传输比渲染慢时在这里形成背压，而不是让 SPI 队列溢出）
+        if (xSemaphoreTake(s_flush.free_tiles, pdMS_TO_TICKS(100)) != pdTRUE) {
+            ESP_LOGW(TAG, "⚠️  等待空闲 tile 超时，丢弃本次刷新");
+            s_flush.flush_errors++;
+            lv_display_flush_ready(disp);
+            lvgl_flush_account(disp, cb_start_us);
+            return;
+        }
+        s_flush.tile_wait_total_us += esp_timer_get_time() - cb_start_us;
+
+        uint8_t *tile = s_flush.tiles[s_flush.head];
+        s_flush.head = (s_flush.head + 1) % LVGL_TILE_RING_DEPTH;
+        lvgl_copy_swap_rgb565(tile, px_map, pixel_count);
+
+        lvgl_flush_submit_begin();
+        esp_err_t ret = esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, tile);
+        if (ret != ESP_OK) {
+            // 传输未入队，撤销记录并归还 tile
+            lvgl_flush_submit_cancel();
+            xSemaphoreGive(s_flush.free_tiles);
+        }
 
-    // 调试：打印刷新信息（仅前几次）
-    static int flush_count = 0;
-    if (flush_count < 5) {
-        ESP_LOGI(TAG, "Flush #%d: area(%d,%d)-(%d,%d), pixels=%lu", 
-                 flush_count, offsetx1, offsety1, offsetx2, offsety2, pixel_count);
-        flush_count++;
+        // 渲染缓冲内容已拷走，LVGL 可以立即渲染下一块
+        lv_display_flush_ready(disp);
+        lvgl_flush_account(disp, cb_start_us);
+        return;
     }
 
     // SPD2010是大端序，需要交换RGB字节顺序
     lv_draw_sw_rgb565_swap(px_map, pixel_count);
 
     // 将缓冲区内容复制到显示屏的指定区域
+    lvgl_flush_submit_begin();
     esp_err_t ret = esp_lcd_panel_draw_bitmap(panel_handle, offsetx1, offsety1, offsetx2 + 1, offsety2 + 1, px_map);
 
     // 关键修复：检查返回值，如果失败立即通知LVGL
     // 原因：SPI队列满时传输失败，中断不会触发，必须手动清除flushing标志，否则死锁
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "⚠️  SPI传输失败(队列满?)，立即通知LVGL");
+        lvgl_flush_submit_cancel();
         lv_display_flush_ready(disp);
     }
-    // 正常情况下，由硬件中断回调 notify_lvgl_flush_ready() 调用 lv_display_flush_ready()
+    // 正常情况下，由传输完成中断 lvgl_trans_done_cb 调用 lv_display_flush_ready()
+    lvgl_flush_account(disp, cb_start_us);
 }
 
-
-
 void lvgl_touch_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
 {
     uint16_t touch_x[TOUCH_MAX_POINTS];
@@ -121,17 +375,105 @@ void lvgl_touch_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
         data->point.x = touch_x[0];
         data->point.y = touch_y[0];
         data->state = LV_INDEV_STATE_PRESSED;
-        ESP_LOGI("LVGL_TOUCH", "触摸点: (%d, %d)", touch_x[0], touch_y[0]);
+        ESP_LOGD("LVGL_TOUCH", "触摸点: (%d, %d)", touch_x[0], touch_y[0]);
     } else {
         // 无触摸点
         data->state = LV_INDEV_STATE_RELEASED;
+
+        // 中断驱动时松开后停止周期读取，下一次按下由触摸中断恢复
+        if (Touch_Is_Interrupt_Driven()) {
+            lv_timer_pause(lv_indev_get_read_timer(indev));
+        }
     }
 }
 
+/* 触摸中断：标记并唤醒 LVGL 任务 */
+static void IRAM_ATTR lvgl_touch_irq_cb(void)
+{
+    s_touch_irq = true;
+    lvgl_driver_wake_from_isr();
+}
+
 /*********************
  * 静态函数实现
  *********************/
 
+/* 释放一组缓冲区 */
+static void lvgl_buffers_release(uint8_t *buf1, uint8_t *buf2, uint8_t **tiles)
+{
+    heap_caps_free(buf1);
+    heap_caps_free(buf2);
+    for (int i = 0; tiles && i < LVGL_TILE_RING_DEPTH; i++) {
+        heap_caps_free(tiles[i]);
+    }
+}
+
+/* 按刷新模式分配缓冲区并交给 LVGL，成功后释放旧缓冲区（调用方保证无在途传输） */
+static esp_err_t lvgl_buffers_setup(lvgl_flush_mode_t mode)
+{
+    uint8_t *buf1 = NULL;
+    uint8_t *buf2 = NULL;
+    uint8_t *tiles[LVGL_TILE_RING_DEPTH] = {0};
+    size_t buffer_size;
+
+    if (!s_flush.flush_done) {
+        s_flush.flush_done = xSemaphoreCreateBinary();
+        if (!s_flush.flush_done) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    if (mode == LVGL_FLUSH_MODE_INTERNAL_RING) {
+        if (!s_flush.free_tiles) {
+            s_flush.free_tiles = xSemaphoreCreateCounting(LVGL_TILE_RING_DEPTH, LVGL_TILE_RING_DEPTH);
+            if (!s_flush.free_tiles) {
+                return ESP_ERR_NO_MEM;
+            }
+        }
+
+        // 渲染缓冲只需 CPU 访问；tile 由 SPI DMA 直接读取，必须是内部 DMA 内存
+        buffer_size = EXAMPLE_LCD_WIDTH * LVGL_TILE_LINES * 2;
+        buf1 = heap_caps_malloc(buffer_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        bool ok = buf1 != NULL;
+        for (int i = 0; ok && i < LVGL_TILE_RING_DEPTH; i++) {
+            tiles[i] = heap_caps_malloc(buffer_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+            ok = tiles[i] != NULL;
+        }
+        if (!ok) {
+            ESP_LOGE(TAG, "Failed to allocate internal tiles (%u bytes x %d)",
+                     (unsigned)buffer_size, LVGL_TILE_RING_DEPTH + 1);
+            lvgl_buffers_release(buf1, NULL, tiles);
+            return ESP_ERR_NO_MEM;
+        }
+    } else {
+        // LVGL9中缓冲区大小以字节为单位，对于RGB565每像素2字节
+        buffer_size = LVGL_BUFFER_SIZE * 2;
+        buf1 = heap_caps_malloc(buffer_size, MALLOC_CAP_SPIRAM);
+        buf2 = heap_caps_malloc(buffer_size, MALLOC_CAP_SPIRAM);
+        if (!buf1 || !buf2) {
+            ESP_LOGE(TAG, "Failed to allocate PSRAM draw buffers");
+            lvgl_buffers_release(buf1, buf2, NULL);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    // 设置显示缓冲区 - LVGL9中buffer_size参数是字节数
+    lv_display_set_buffers(g_lvgl_display, buf1, buf2, buffer_size, LV_DISPLAY_RENDER_MODE_PARTIAL);
+
+    lvgl_buffers_release(lvgl_draw_buf1, lvgl_draw_buf2, s_flush.tiles);
+    lvgl_draw_buf1 = buf1;
+    lvgl_draw_buf2 = buf2;
+    memcpy(s_flush.tiles, tiles, sizeof(tiles));
+    s_flush.tile_bytes = mode == LVGL_FLUSH_MODE_INTERNAL_RING ? buffer_size : 0;
+    s_flush.head = 0;
+    s_flush.mode = mode;
+
+    ESP_LOGI(TAG, "Flush mode: %s, render buffer %u bytes",
+             mode == LVGL_FLUSH_MODE_INTERNAL_RING ? "internal RAM + DMA tile ring" : "PSRAM double buffer",
+             (unsigned)buffer_size);
+    return ESP_OK;
+}
+
 static esp_err_t lvgl_display_init(void)
 {
     ESP_LOGI(TAG, "Initializing LVGL display");
@@ -143,33 +485,22 @@ static esp_err_t lvgl_display_init(void)
         return ESP_FAIL;
     }
 
-    // 分配显示缓冲区 (使用PSRAM)
-    // LVGL9中缓冲区大小以字节为单位，对于RGB565每像素2字节
-    size_t buffer_size = LVGL_BUFFER_SIZE * 2;  // RGB565每像素2字节
-
-    lvgl_draw_buf1 = heap_caps_malloc(buffer_size, MALLOC_CAP_SPIRAM);
-    if (!lvgl_draw_buf1) {
-        ESP_LOGE(TAG, "Failed to allocate draw buffer 1");
-        return ESP_ERR_NO_MEM;
+    // 分配显示缓冲区：优先内部 RAM 渲染 + DMA tile 环形队列，内存不足时退回 PSRAM 双缓冲
+    esp_err_t ret = lvgl_buffers_setup(LVGL_FLUSH_MODE_INTERNAL_RING);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "内部RAM不足，退回PSRAM双缓冲");
+        ret = lvgl_buffers_setup(LVGL_FLUSH_MODE_PSRAM_DOUBLE);
     }
-
-    lvgl_draw_buf2 = heap_caps_malloc(buffer_size, MALLOC_CAP_SPIRAM);
-    if (!lvgl_draw_buf2) {
-        ESP_LOGE(TAG, "Failed to allocate draw buffer 2");
-        free(lvgl_draw_buf1);
-        lvgl_draw_buf1 = NULL;
-        return ESP_ERR_NO_MEM;
+    if (ret != ESP_OK) {
+        return ret;
     }
 
-    // 设置显示缓冲区 - LVGL9中buffer_size参数是字节数
-    lv_display_set_buffers(g_lvgl_display, lvgl_draw_buf1, lvgl_draw_buf2,
-                           buffer_size, LV_DISPLAY_RENDER_MODE_PARTIAL);
-
     // 设置颜色格式为RGB565（与SPD2010匹配）
     lv_display_set_color_format(g_lvgl_display, LV_COLOR_FORMAT_RGB565);
 
-    // 设置刷新回调
+    // 设置刷新回调；PSRAM 模式下等待传输完成改为阻塞在信号量上
     lv_display_set_flush_cb(g_lvgl_display, lvgl_flush_cb);
+    lv_display_set_flush_wait_cb(g_lvgl_display, lvgl_flush_wait_cb);
 
     // 获取官方组件的面板句柄
     esp_lcd_panel_handle_t official_panel = SPD2010_Get_Panel_Handle();
@@ -181,11 +512,18 @@ static esp_err_t lvgl_display_init(void)
     // 设置用户数据 (LCD面板句柄)
     lv_display_set_user_data(g_lvgl_display, official_panel);
 
-    // 注册区域对齐回调 - 处理SPD2010的4字节对齐要求
+    // 注册区域对齐回调 - 处理SPD2010的4像素对齐要求
     lv_display_add_event_cb(g_lvgl_display, lvgl_rounder_cb, LV_EVENT_INVALIDATE_AREA, NULL);
 
-    // 注册官方组件的硬件完成回调
-    esp_err_t ret = SPD2010_Register_LVGL_Callback(g_lvgl_display);
+    // 界面变化时唤醒 LVGL 任务
+    lv_display_add_event_cb(g_lvgl_display, lvgl_invalidate_wake_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+
+    // 帧开始事件，用于统计帧耗时
+    lv_display_add_event_cb(g_lvgl_display, lvgl_refr_start_cb, LV_EVENT_REFR_START, NULL);
+    s_flush.window_start_us = esp_timer_get_time();
+
+    // 注册传输完成回调（按刷新模式归还 tile 或唤醒等待传输的 LVGL 任务）
+    ret = SPD2010_Register_Trans_Done_Callback(lvgl_trans_done_cb, NULL);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to register LVGL callback");
         return ret;
@@ -210,57 +548,104 @@ static esp_err_t lvgl_indev_init(void)
     lv_indev_set_type(g_lvgl_indev, LV_INDEV_TYPE_POINTER);
     lv_indev_set_read_cb(g_lvgl_indev, lvgl_touch_read_cb);
 
+    // 触摸中断直接唤醒 LVGL 任务读取，不必等下一个读取周期
+    Touch_Set_Notify_Callback(lvgl_touch_irq_cb);
+
     ESP_LOGI(TAG, "LVGL input device initialized successfully");
     return ESP_OK;
 }
 
-static esp_err_t lvgl_tick_timer_init(void)
+/* 把当前模式持续的时间记账（调用方在 LVGL 任务中或持有 lv_lock） */
+static void lvgl_perf_account(int64_t now)
 {
-    ESP_LOGI(TAG, "Initializing LVGL tick timer");
-
-    // 创建定时器配置
-    const esp_timer_create_args_t timer_args = {
-        .callback = lvgl_tick_inc_cb,
-        .name = "lvgl_tick"
-    };
-
-    // 创建定时器
-    esp_err_t ret = esp_timer_create(&timer_args, &lvgl_tick_timer);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to create tick timer: %s", esp_err_to_name(ret));
-        return ret;
+    if (s_perf.mode_start_us > 0) {
+        s_perf.acc[s_perf.mode].active_us += now - s_perf.mode_start_us;
     }
+    s_perf.mode_start_us = now;
+}
 
-    // 启动定时器
-    ret = esp_timer_start_periodic(lvgl_tick_timer, LVGL_TICK_PERIOD_MS * 1000);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to start tick timer: %s", esp_err_to_name(ret));
-        esp_timer_delete(lvgl_tick_timer);
-        lvgl_tick_timer = NULL;
-        return ret;
+/* 应用最新的性能模式请求：刷新间隔直接作用于显示刷新定时器，冻结时暂停它 */
+static void lvgl_perf_apply(void)
+{
+    portENTER_CRITICAL(&s_perf_lock);
+    uint32_t seq = s_perf.req_seq;
+    uint8_t mode = s_perf.req_mode;
+    uint32_t refr_ms = s_perf.req_refr_ms;
+    uint32_t anim_ms = s_perf.req_anim_ms;
+    portEXIT_CRITICAL(&s_perf_lock);
+
+    lv_lock();
+    lvgl_perf_account(esp_timer_get_time());
+    s_perf.applied_seq = seq;
+    s_perf.mode = mode;
+    s_perf.refr_period_ms = refr_ms;
+    s_perf.anim_period_ms = anim_ms;
+    s_perf.mode_refr_ms[mode] = refr_ms;
+    s_perf.mode_anim_ms[mode] = anim_ms;
+
+    lv_timer_t *refr_timer = g_lvgl_display ? lv_display_get_refr_timer(g_lvgl_display) : NULL;
+    if (refr_timer) {
+        if (refr_ms == LVGL_FRAME_FREEZE) {
+            lv_timer_pause(refr_timer);
+        } else {
+            lv_timer_set_period(refr_timer, refr_ms);
+            lv_timer_resume(refr_timer);
+        }
     }
-
-    ESP_LOGI(TAG, "LVGL tick timer started successfully");
-    return ESP_OK;
+    lv_unlock();
 }
 
 static void lvgl_timer_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "LVGL timer task started");
-    
+    s_perf.mode_start_us = esp_timer_get_time();
+
     while (1) {
-        // 调用LVGL定时器处理函数
+        int64_t wake_us = esp_timer_get_time();
+
+        if (s_perf.req_seq != s_perf.applied_seq) {
+            lvgl_perf_apply();
+        }
+
+        // 触摸中断：恢复周期读取（按住期间跟踪移动和松开）并立即读一次
+        if (s_touch_irq && g_lvgl_indev) {
+            s_touch_irq = false;
+            lv_lock();
+            lv_timer_resume(lv_indev_get_read_timer(g_lvgl_indev));
+            lv_indev_read(g_lvgl_indev);
+            lv_unlock();
+        }
+
+        // 其他任务无锁投递的数据（如字幕）在这里被消费
+        lvgl_wake_hook_t hook = s_wake_hook;
+        if (hook) {
+            lv_lock();
+            hook();
+            lv_unlock();
+        }
+
+        // 调用LVGL定时器处理函数，返回值是距离下一个定时器到期的时间
+        uint32_t frames_before = s_flush.frames;
         uint32_t delay_ms = lv_timer_handler();
-        
-        // 动态延时，平衡性能和功耗
-        if (delay_ms == LV_NO_TIMER_READY) {
-            // 无定时器时等待200ms
-            vTaskDelay(pdMS_TO_TICKS(200));
-        } else if (delay_ms < 20) {
-            vTaskDelay(pdMS_TO_TICKS(20));
-        } else {
-            delay_ms = 100;
-            vTaskDelay(pdMS_TO_TICKS(delay_ms));
+        s_sched.wakeups++;
+        if (s_flush.frames == frames_before) {
+            s_sched.idle_wakeups++;
+        }
+
+        // 本轮占用时间（含等待 DMA tile）记到当前性能模式
+        s_perf.acc[s_perf.mode].busy_us += esp_timer_get_time() - wake_us;
+        s_perf.acc[s_perf.mode].frames += s_flush.frames - frames_before;
+
+        // 睡到下一个定时器到期，或被界面修改/触摸/外部唤醒提前打断
+        if (delay_ms == LV_NO_TIMER_READY || delay_ms > LVGL_TASK_MAX_SLEEP_MS) {
+            delay_ms = LVGL_TASK_MAX_SLEEP_MS;
+        }
+        TickType_t ticks = (delay_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+        if (ticks == 0) {
+            ticks = 1;  // 至少让出一个节拍，避免饿死同核低优先级任务
+        }
+        if (ulTaskNotifyTake(pdTRUE, ticks) > 0) {
+            s_sched.notify_wakeups++;
         }
     }
 }
@@ -291,14 +676,8 @@ static esp_err_t lvgl_task_init(void)
 
 static void lvgl_cleanup_resources(void)
 {
-    // 停止并删除定时器
-    if (lvgl_tick_timer) {
-        esp_timer_stop(lvgl_tick_timer);
-        esp_timer_delete(lvgl_tick_timer);
-        lvgl_tick_timer = NULL;
-    }
-
     // 删除输入设备
+    Touch_Set_Notify_Callback(NULL);
     if (g_lvgl_indev) {
         lv_indev_delete(g_lvgl_indev);
         g_lvgl_indev = NULL;
@@ -311,13 +690,17 @@ static void lvgl_cleanup_resources(void)
     }
 
     // 释放缓冲区
-    if (lvgl_draw_buf1) {
-        free(lvgl_draw_buf1);
-        lvgl_draw_buf1 = NULL;
+    lvgl_buffers_release(lvgl_draw_buf1, lvgl_draw_buf2, s_flush.tiles);
+    lvgl_draw_buf1 = NULL;
+    lvgl_draw_buf2 = NULL;
+    memset(s_flush.tiles, 0, sizeof(s_flush.tiles));
+    if (s_flush.free_tiles) {
+        vSemaphoreDelete(s_flush.free_tiles);
+        s_flush.free_tiles = NULL;
     }
-    if (lvgl_draw_buf2) {
-        free(lvgl_draw_buf2);
-        lvgl_draw_buf2 = NULL;
+    if (s_flush.flush_done) {
+        vSemaphoreDelete(s_flush.flush_done);
+        s_flush.flush_done = NULL;
     }
 }
 
@@ -333,8 +716,9 @@ esp_err_t lvgl_driver_init(void)
     // 初始化LCD硬件（包括I2C、显示面板、触摸屏）
     LCD_Init_Official();
 
-    // 初始化LVGL库
+    // 初始化LVGL库，时基直接取 esp_timer（微秒计时），不再依赖周期 tick 中断
     lv_init();
+    lv_tick_set_cb(lvgl_tick_get_cb);
 
     // 初始化显示驱动
     esp_err_t ret = lvgl_display_init();
@@ -350,13 +734,6 @@ esp_err_t lvgl_driver_init(void)
         goto error;
     }
 
-    // 初始化tick定时器
-    ret = lvgl_tick_timer_init();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize tick timer");
-        goto error;
-    }
-
     // 创建LVGL任务
     ret = lvgl_task_init();
     if (ret != ESP_OK) {
@@ -378,3 +755,188 @@ void lvgl_driver_deinit(void)
     lvgl_cleanup_resources();
     ESP_LOGI(TAG, "LVGL driver deinitialized");
 }
+
+esp_err_t lvgl_driver_wait_flush_done(uint32_t timeout_ms)
+{
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    while (s_flush.inflight > 0) {
+        if (esp_timer_get_time() > deadline) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    return ESP_OK;
+}
+
+esp_err_t lvgl_driver_set_flush_mode(lvgl_flush_mode_t mode)
+{
+    if (!g_lvgl_display || mode >= LVGL_FLUSH_MODE_MAX) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (mode == s_flush.mode) {
+        return ESP_OK;
+    }
+
+    // 持有 LVGL 锁期间不会有新的渲染；等在途传输结束后旧缓冲才可以释放
+    lv_lock();
+    esp_err_t ret = lvgl_driver_wait_flush_done(200);
+    if (ret == ESP_OK) {
+        ret = lvgl_buffers_setup(mode);
+    }
+    lv_unlock();
+    return ret;
+}
+
+lvgl_flush_mode_t lvgl_driver_get_flush_mode(void)
+{
+    return s_flush.mode;
+}
+
+esp_err_t lvgl_driver_get_stats(lvgl_display_stats_t *stats, bool reset)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    lv_lock();
+    int64_t window_us = esp_timer_get_time() - s_flush.window_start_us;
+    uint32_t frames = s_flush.frames;
+    portENTER_CRITICAL(&s_flush_lock);
+    uint32_t flushes = s_flush.flush_count;
+    uint64_t flush_total_us = s_flush.flush_total_us;
+    portEXIT_CRITICAL(&s_flush_lock);
+
+    memset(stats, 0, sizeof(*stats));
+    stats->mode = s_flush.mode;
+    stats->frames = frames;
+    stats->fps_x10 = window_us > 0 ? (uint32_t)((uint64_t)frames * 10000000ULL / window_us) : 0;
+    if (frames > 0) {
+        stats->frame_avg_us = (uint32_t)(s_flush.frame_total_us / frames);
+        stats->render_avg_us = (uint32_t)(s_flush.render_total_us / frames);
+        stats->tile_wait_avg_us = (uint32_t)(s_flush.tile_wait_total_us / frames);
+        stats->pixels_per_frame_avg = (uint32_t)(s_flush.pixels / frames);
+    }
+    stats->pixels_per_s = window_us > 0 ? (uint32_t)(s_flush.pixels * 1000000ULL / window_us) : 0;
+    stats->flush_count = flushes;
+    stats->flush_avg_us = flushes > 0 ? (uint32_t)(flush_total_us / flushes) : 0;
+    stats->flush_errors = s_flush.flush_errors;
+
+    uint32_t wakeups = s_sched.wakeups;
+    uint32_t idle_wakeups = s_sched.idle_wakeups;
+    stats->notify_wakeups = s_sched.notify_wakeups;
+    stats->wakeups_per_s_x10 = window_us > 0 ? (uint32_t)((uint64_t)wakeups * 10000000ULL / window_us) : 0;
+    stats->idle_wakeups_per_s_x10 = window_us > 0 ? (uint32_t)((uint64_t)idle_wakeups * 10000000ULL / window_us) : 0;
+    if (s_sched.intervals > 0) {
+        double mean = (double)s_sched.interval_total_us / s_sched.intervals;
+        double var = (double)s_sched.interval_sq_total / s_sched.intervals - mean * mean;
+        stats->frame_interval_avg_us = (uint32_t)mean;
+        stats->frame_jitter_us = var > 0 ? (uint32_t)sqrt(var) : 0;
+        stats->frame_interval_max_us = s_sched.interval_max_us;
+    }
+
+    if (reset) {
+        s_flush.window_start_us = esp_timer_get_time();
+        s_flush.frames = 0;
+        s_flush.frame_total_us = 0;
+        s_flush.render_total_us = 0;
+        s_flush.tile_wait_total_us = 0;
+        s_flush.pixels = 0;
+        s_flush.flush_errors = 0;
+        s_sched.wakeups = 0;
+        s_sched.notify_wakeups = 0;
+        s_sched.idle_wakeups = 0;
+        s_sched.intervals = 0;
+        s_sched.interval_total_us = 0;
+        s_sched.interval_sq_total = 0;
+        s_sched.interval_max_us = 0;
+        // 中断里累加的两个计数一起清零，避免平均值错位
+        portENTER_CRITICAL(&s_flush_lock);
+        s_flush.flush_count = 0;
+        s_flush.flush_total_us = 0;
+        portEXIT_CRITICAL(&s_flush_lock);
+    }
+    lv_unlock();
+    return ESP_OK;
+}
+
+void lvgl_driver_wake(void)
+{
+    if (lvgl_task_handle) {
+        xTaskNotifyGive(lvgl_task_handle);
+    }
+}
+
+void lvgl_driver_set_wake_hook(lvgl_wake_hook_t hook)
+{
+    s_wake_hook = hook;
+}
+
+void lvgl_driver_set_perf_mode(uint8_t mode, uint32_t refr_period_ms, uint32_t anim_period_ms)
+{
+    if (mode >= LVGL_PERF_MODE_MAX) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_perf_lock);
+    s_perf.req_mode = mode;
+    s_perf.req_refr_ms = refr_period_ms;
+    s_perf.req_anim_ms = anim_period_ms;
+    s_perf.req_seq++;
+    portEXIT_CRITICAL(&s_perf_lock);
+
+    lvgl_driver_wake();
+}
+
+uint32_t lvgl_driver_get_anim_period(void)
+{
+    return s_perf.anim_period_ms;
+}
+
+void lvgl_driver_note_skipped_frame(uint32_t render_us)
+{
+    // 跳过的动画帧同时省下一次屏幕刷新，按当前窗口的平均每帧刷新耗时估算
+    uint32_t frame_us = s_flush.frames > 0 ? (uint32_t)(s_flush.frame_total_us / s_flush.frames) : 0;
+    s_perf.acc[s_perf.mode].skipped++;
+    s_perf.acc[s_perf.mode].saved_us += render_us + frame_us;
+}
+
+esp_err_t lvgl_driver_get_perf_stats(lvgl_perf_mode_stats_t stats[LVGL_PERF_MODE_MAX], bool reset)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    lv_lock();
+    lvgl_perf_account(esp_timer_get_time());
+    for (int i = 0; i < LVGL_PERF_MODE_MAX; i++) {
+        lvgl_perf_mode_stats_t *st = &stats[i];
+        uint64_t active_us = s_perf.acc[i].active_us;
+
+        memset(st, 0, sizeof(*st));
+        st->refr_period_ms = s_perf.mode_refr_ms[i];
+        st->anim_period_ms = s_perf.mode_anim_ms[i];
+        st->active_ms = (uint32_t)(active_us / 1000);
+        st->frames = s_perf.acc[i].frames;
+        st->skipped_frames = s_perf.acc[i].skipped;
+        st->saved_ms = (uint32_t)(s_perf.acc[i].saved_us / 1000);
+        if (active_us > 0) {
+            st->fps_x10 = (uint32_t)((uint64_t)st->frames * 10000000ULL / active_us);
+            uint64_t busy = s_perf.acc[i].busy_us < active_us ? s_perf.acc[i].busy_us : active_us;
+            st->busy_permille = (uint32_t)(busy * 1000 / active_us);
+        }
+    }
+    if (reset) {
+        memset(s_perf.acc, 0, sizeof(s_perf.acc));
+    }
+    lv_unlock();
+    return ESP_OK;
+}
+
+void IRAM_ATTR lvgl_driver_wake_from_isr(void)
+{
+    if (lvgl_task_handle) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(lvgl_task_handle, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
@@ -0,0 +1,144 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-03 15:22:47
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-03 15:22:47
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_lvgl_driver\src\xn_lvgl_bench.c
+ * @Description: 显示基准测试 - 对比 PSRAM 双缓冲与内部 RAM DMA tile 环形刷新
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include "xn_lvgl.h"
+
+static const char *TAG = "LVGL_BENCH";
+
+#define BENCH_RESULT_HOLD_MS    5000    // 结果在屏幕上停留时间
+
+static const char *const s_mode_names[LVGL_FLUSH_MODE_MAX] = {
+    [LVGL_FLUSH_MODE_PSRAM_DOUBLE]  = "PSRAM x2",
+    [LVGL_FLUSH_MODE_INTERNAL_RING] = "SRAM ring",
+};
+
+/* 创建测试屏幕：渐变背景 + 移动方块 + 帧号文字，每帧整屏重绘 */
+static lv_obj_t *bench_create_screen(lv_obj_t **box, lv_obj_t **label)
+{
+    lv_obj_t *scr = lv_obj_create(NULL);
+    lv_obj_set_style_bg_color(scr, lv_color_hex(0x1E3A8A), 0);
+    lv_obj_set_style_bg_grad_color(scr, lv_color_hex(0xF97316), 0);
+    lv_obj_set_style_bg_grad_dir(scr, LV_GRAD_DIR_VER, 0);
+    lv_obj_set_style_bg_opa(scr, LV_OPA_COVER, 0);
+
+    *box = lv_obj_create(scr);
+    lv_obj_set_size(*box, 120, 120);
+    lv_obj_set_style_radius(*box, 24, 0);
+    lv_obj_set_style_bg_color(*box, lv_color_white(), 0);
+    lv_obj_set_style_bg_opa(*box, LV_OPA_70, 0);
+
+    *label = lv_label_create(scr);
+    lv_obj_set_style_text_color(*label, lv_color_white(), 0);
+    lv_obj_set_style_text_font(*label, &lv_font_montserrat_26, 0);
+    lv_obj_align(*label, LV_ALIGN_TOP_MID, 0, 40);
+
+    return scr;
+}
+
+/* 用指定模式连续整屏重绘 frames 帧 */
+static esp_err_t bench_run_mode(lvgl_flush_mode_t mode, uint32_t frames,
+                                lv_obj_t *scr, lv_obj_t *box, lv_obj_t *label,
+                                lvgl_bench_result_t *result)
+{
+    esp_err_t ret = lvgl_driver_set_flush_mode(mode);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "切换到 %s 失败: %s", s_mode_names[mode], esp_err_to_name(ret));
+        return ret;
+    }
+
+    lvgl_display_stats_t stats;
+    lvgl_driver_get_stats(&stats, true);
+
+    int64_t start_us = esp_timer_get_time();
+    for (uint32_t i = 0; i < frames; i++) {
+        lv_lock();
+        int32_t span = EXAMPLE_LCD_WIDTH - 120;
+        int32_t pos = (int32_t)((i * 7) % (2 * span));
+        lv_obj_set_pos(box, pos < span ? pos : 2 * span - pos, 150);
+        lv_label_set_text_fmt(label, "%s  #%lu", s_mode_names[mode], (unsigned long)i);
+        lv_obj_invalidate(scr);
+        lv_refr_now(g_lvgl_display);
+        lv_unlock();
+    }
+    lvgl_driver_wait_flush_done(200);
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+    lvgl_driver_get_stats(&stats, true);
+
+    result->mode = mode;
+    result->frames = frames;
+    result->elapsed_ms = (uint32_t)(elapsed_us / 1000);
+    result->fps_x10 = elapsed_us > 0 ? (uint32_t)((uint64_t)frames * 10000000ULL / elapsed_us) : 0;
+    result->render_avg_us = stats.render_avg_us;
+    result->flush_avg_us = stats.flush_avg_us;
+
+    ESP_LOGI(TAG, "%-9s: %lu 帧 %lu ms, %lu.%lu FPS, 渲染 %lu us/帧, 传输 %lu us/块, 错误 %lu",
+             s_mode_names[mode], (unsigned long)frames, (unsigned long)result->elapsed_ms,
+             (unsigned long)(result->fps_x10 / 10), (unsigned long)(result->fps_x10 % 10),
+             (unsigned long)result->render_avg_us, (unsigned long)result->flush_avg_us,
+             (unsigned long)stats.flush_errors);
+    return ESP_OK;
+}
+
+esp_err_t lvgl_driver_run_benchmark(uint32_t frames, lvgl_bench_result_t results[LVGL_FLUSH_MODE_MAX])
+{
+    if (!g_lvgl_display || frames == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    lvgl_bench_result_t local[LVGL_FLUSH_MODE_MAX] = {0};
+    lvgl_bench_result_t *res = results ? results : local;
+    lvgl_flush_mode_t orig_mode = lvgl_driver_get_flush_mode();
+    lv_obj_t *box = NULL;
+    lv_obj_t *label = NULL;
+
+    lv_lock();
+    lv_obj_t *prev = lv_screen_active();
+    lv_obj_t *scr = bench_create_screen(&box, &label);
+    lv_screen_load(scr);
+    lv_unlock();
+
+    ESP_LOGI(TAG, "开始显示基准测试，每种模式 %lu 帧", (unsigned long)frames);
+
+    esp_err_t ret = ESP_OK;
+    for (int mode = 0; mode < LVGL_FLUSH_MODE_MAX && ret == ESP_OK; mode++) {
+        ret = bench_run_mode((lvgl_flush_mode_t)mode, frames, scr, box, label, &res[mode]);
+    }
+    lvgl_driver_set_flush_mode(orig_mode);
+
+    // 结果留在测试屏幕上
+    if (ret == ESP_OK) {
+        const lvgl_bench_result_t *a = &res[LVGL_FLUSH_MODE_PSRAM_DOUBLE];
+        const lvgl_bench_result_t *b = &res[LVGL_FLUSH_MODE_INTERNAL_RING];
+        lv_lock();
+        lv_obj_delete(box);
+        lv_label_set_text_fmt(label,
+                              "%s: %lu.%lu FPS\n"
+                              "render %lu us  flush %lu us\n\n"
+                              "%s: %lu.%lu FPS\n"
+                              "render %lu us  flush %lu us",
+                              s_mode_names[a->mode], (unsigned long)(a->fps_x10 / 10), (unsigned long)(a->fps_x10 % 10),
+                              (unsigned long)a->render_avg_us, (unsigned long)a->flush_avg_us,
+                              s_mode_names[b->mode], (unsigned long)(b->fps_x10 / 10), (unsigned long)(b->fps_x10 % 10),
+                              (unsigned long)b->render_avg_us, (unsigned long)b->flush_avg_us);
+        lv_obj_set_style_text_font(label, &lv_font_montserrat_16, 0);
+        lv_obj_align(label, LV_ALIGN_CENTER, 0, 0);
+        lv_unlock();
+        vTaskDelay(pdMS_TO_TICKS(BENCH_RESULT_HOLD_MS));
+    }
+
+    lv_lock();
+    lv_screen_load(prev);
+    lv_obj_delete(scr);
+    lv_unlock();
+
+    return ret;
+}
@@ -36,6 +36,7 @@
 #include "iot_eth_netif_glue.h"
 #include "iot_usbh_cdc.h"
 #include "usb_rndis_4g.h"
+#include "conn_supervisor.h"
 
 // 日志标签
 static const char *TAG = "usb_rndis_4g";
@@ -136,6 +137,7 @@ static void iot_event_handle(void *arg, esp_event_base_t event_base, int32_t eve
         
     case IOT_ETH_EVENT_STOP:
         ESP_LOGI(TAG, "IOT_ETH_EVENT_STOP");
+        (void)conn_supervisor_notify(CONN_EVENT_RNDIS_DOWN);
         if (g_event_callback) {
             g_event_callback(USB_RNDIS_EVENT_DISCONNECTED, NULL, g_user_data);
         }
@@ -143,6 +145,7 @@ static void iot_event_handle(void *arg, esp_event_base_t event_base, int32_t eve
         
     case IOT_ETH_EVENT_CONNECTED:
         ESP_LOGI(TAG, "IOT_ETH_EVENT_CONNECTED - 4G设备已连接");
+        (void)conn_supervisor_notify(CONN_EVENT_RNDIS_UP);
         if (g_event_callback) {
             g_event_callback(USB_RNDIS_EVENT_CONNECTED, NULL, g_user_data);
         }
@@ -150,6 +153,7 @@ static void iot_event_handle(void *arg, esp_event_base_t event_base, int32_t eve
         
     case IOT_ETH_EVENT_DISCONNECTED:
         ESP_LOGI(TAG, "IOT_ETH_EVENT_DISCONNECTED - 4G设备断开连接");
+        (void)conn_supervisor_notify(CONN_EVENT_RNDIS_DOWN);
         if (g_event_callback) {
             g_event_callback(USB_RNDIS_EVENT_DISCONNECTED, NULL, g_user_data);
         }
@@ -168,6 +172,11 @@ static void iot_event_handle(void *arg, esp_event_base_t event_base, int32_t eve
  */
 static void ip_event_handle(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
 {
+    if (event_id == IP_EVENT_ETH_LOST_IP) {
+        (void)conn_supervisor_notify(CONN_EVENT_RNDIS_LOST_IP);
+        return;
+    }
+
     if (event_id == IP_EVENT_ETH_GOT_IP) {
         ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
         esp_netif_ip_info_t *ip_info = &event->ip_info;
@@ -176,6 +185,9 @@ static void ip_event_handle(void *arg, esp_event_base_t event_base, int32_t even
         ESP_LOGI(TAG, "  IP地址: " IPSTR, IP2STR(&ip_info->ip));
         ESP_LOGI(TAG, "  网关  : " IPSTR, IP2STR(&ip_info->gw));
         ESP_LOGI(TAG, "  子网掩码: " IPSTR, IP2STR(&ip_info->netmask));
+
+        // 联网监督按拿到 IP 的时刻计时，不计入下面的等待
+        (void)conn_supervisor_notify(CONN_EVENT_RNDIS_GOT_IP);
         
         vTaskDelay(2000 / portTICK_PERIOD_MS);  // 等待2秒
         // 通知应用层
@@ -219,6 +231,13 @@ esp_err_t usb_rndis_4g_init(const usb_rndis_config_t *config)
     
     // 注册IP事件处理函数
     ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_ETH_GOT_IP, ip_event_handle, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_ETH_LOST_IP, ip_event_handle, NULL));
+
+    // 链路 / IP 事件同时上报联网监督（WiFi 管理未启用时在这里初始化）
+    ret = conn_supervisor_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "conn_supervisor_init failed: %s", esp_err_to_name(ret));
+    }
     
     /* ========== 第二步：安装USB CDC主机驱动 ========== */
     usbh_cdc_driver_config_t cdc_config = {
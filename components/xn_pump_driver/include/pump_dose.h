@@ -0,0 +1,75 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-11 10:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-11 10:12:40
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_pump_driver\include\pump_dose.h
+ * @Description: 定量浇水换算（纯函数，不依赖 ESP-IDF，可在主机上编译）
+ *
+ * 有流量计时按脉冲闭环：目标脉冲 = 体积 × K 系数；PCNT 观察点提前 lead 个脉冲，
+ * 抵消软停止斜坡与中断延迟期间继续流出的水量，lead 按每次实测过冲做指数平均自学习。
+ * 没有流量计时按额定流量把体积换算为开启时长（开环），实际水量按时长估算。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#ifndef PUMP_DOSE_H
+#define PUMP_DOSE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 体积（ml）换算为流量计脉冲数（四舍五入）
+ * @param pulses_per_l 流量计 K 系数（脉冲 / 升）
+ */
+uint32_t pump_dose_ml_to_pulses(uint32_t ml, uint16_t pulses_per_l);
+
+/**
+ * @brief 脉冲数换算为体积（ml，四舍五入）
+ */
+uint32_t pump_dose_pulses_to_ml(uint32_t pulses, uint16_t pulses_per_l);
+
+#define PUMP_DOSE_LEAD_SHIFT 4            ///< 提前量以 1/16 脉冲为单位，避免小过冲时整数平均停滞
+
+/**
+ * @brief 观察点：目标脉冲减去提前量（四舍五入到整脉冲），至少为 1
+ * @param lead_q4 提前量（1/16 脉冲）
+ */
+uint32_t pump_dose_watch_point(uint32_t target_pulses, uint32_t lead_q4);
+
+/**
+ * @brief 按本次实测更新提前量：lead' = lead + (过冲 - lead) / 4，上限为目标的一半
+ *
+ * @param lead_q4 当前提前量（1/16 脉冲）
+ * @param target  本次目标脉冲
+ * @param watch   本次观察点
+ * @param actual  本次停止后的总脉冲
+ * @return 新的提前量（1/16 脉冲）
+ */
+uint32_t pump_dose_update_lead(uint32_t lead_q4, uint32_t target, uint32_t watch, uint32_t actual);
+
+/**
+ * @brief 开环定量：体积按额定流量换算的开启时长（含软启停斜坡损失）
+ * @return 毫秒，nominal_ml_min 为 0 时返回 0
+ */
+uint32_t pump_dose_open_loop_ms(uint32_t ml, uint16_t nominal_ml_min, uint16_t ramp_ms);
+
+/**
+ * @brief 按开启时长估算水量：软启动 / 软停止斜坡各按一半流量计
+ */
+uint32_t pump_dose_estimate_ml(uint32_t on_ms, uint16_t nominal_ml_min, uint16_t ramp_ms);
+
+/**
+ * @brief 相对误差（千分比），target 为 0 时返回 0
+ */
+int32_t pump_dose_error_permille(uint32_t actual, uint32_t target);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUMP_DOSE_H */
@@ -0,0 +1,168 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-11 10:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-11 10:12:40
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_pump_driver\include\pump_driver.h
+ * @Description: 水泵 / 电磁阀硬件定时驱动（LEDC 软启停 + esp_timer 定时 + PCNT 流量闭环 + 失效保护）
+ *
+ * 设计要点：
+ *  - 输出由 LEDC 驱动，开 / 关是硬件渐变（ledc_set_fade_with_time），斜坡期间 CPU 不参与；
+ *    ramp_ms = 0 时输出直接 0 / 100%，可直接驱动继电器；
+ *  - 开启时长由 esp_timer 单次定时器控制，定时器回调只通知驱动任务开始软停止，不再依赖任务 vTaskDelay；
+ *  - 通道接了流量计时用 PCNT 计脉冲，观察点到达中断即停泵，实现按体积定量；
+ *  - 失效保护：每次从关到开都独立启动一个 max_on_ms 的单次定时器，到点直接 ledc_stop 切断输出，
+ *    不取锁、不等驱动任务，上层重复下发"开"只刷新运行时限，不会延长失效保护；
+ *    开启 ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD 与 LEDC_CTRL_FUNC_IN_IRAM 时该定时器在中断里执行；
+ *  - 每个开启周期结束时回报实际开启时长、目标 / 实际水量、误差和本周期 CPU 被唤醒的次数。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#ifndef PUMP_DRIVER_H
+#define PUMP_DRIVER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "driver/ledc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PUMP_DRIVER_MAX_CHANNELS  6               ///< 通道上限（LEDC 通道 0/1 留给屏幕背光）
+#define PUMP_DRIVER_MAX_PULSES    30000           ///< 单次定量的脉冲上限（PCNT 计数范围内）
+#define PUMP_DRIVER_PWM_BITS      10              ///< PWM 分辨率
+
+/**
+ * @brief 周期结束原因
+ */
+typedef enum {
+    PUMP_STOP_COMMAND  = 0,                       ///< 上层调用 pump_driver_stop
+    PUMP_STOP_TIME     = 1,                       ///< 开启时长到
+    PUMP_STOP_VOLUME   = 2,                       ///< 流量计达到目标水量
+    PUMP_STOP_FAILSAFE = 3,                       ///< 超过最长开启时间，硬切断
+    PUMP_STOP_RESTART  = 4,                       ///< 软停止过程中被重新开启，本周期提前结束
+} pump_stop_reason_t;
+
+/**
+ * @brief 单个开启周期的结果
+ */
+typedef struct {
+    uint8_t            channel;
+    pump_stop_reason_t reason;
+    uint32_t           requested_ms;              ///< 请求的开启时长，0 表示常开
+    uint32_t           on_ms;                     ///< 实际开启时长（开始软启动 ~ 输出完全关闭）
+    uint32_t           target_ml;                 ///< 目标水量，0 表示按时长
+    uint32_t           delivered_ml;              ///< 实际水量：有流量计为实测，否则按额定流量估算
+    uint32_t           pulses;                    ///< 流量计脉冲数
+    bool               measured;                  ///< delivered_ml 是否来自流量计
+    int32_t            error_permille;            ///< 定量误差（‰）：按水量时为水量误差，按时长时为时长误差
+    uint32_t           wakeups;                   ///< 本周期 CPU 被唤醒次数（中断 + 定时器回调 + 驱动任务）
+} pump_cycle_report_t;
+
+/**
+ * @brief 周期结束回调（在驱动任务中执行，可以调用其他模块接口，不可阻塞太久）
+ */
+typedef void (*pump_report_cb_t)(const pump_cycle_report_t *report, void *ctx);
+
+/**
+ * @brief 单个通道的硬件配置
+ */
+typedef struct {
+    int      gpio;                                ///< 输出 GPIO（MOSFET 栅极 / 继电器驱动）
+    int      flow_gpio;                           ///< 流量计脉冲输入，-1 表示没有
+    uint16_t pulses_per_l;                        ///< 流量计 K 系数（脉冲 / 升），如 YF-S201 约 450
+    uint16_t nominal_ml_min;                      ///< 额定流量：无流量计时用于体积换算与估算
+} pump_channel_config_t;
+
+/**
+ * @brief 驱动配置
+ */
+typedef struct {
+    const pump_channel_config_t *channels;        ///< 通道表，下标即通道号
+    uint8_t                      channel_count;   ///< 通道数（1 ~ PUMP_DRIVER_MAX_CHANNELS）
+    ledc_timer_t                 ledc_timer;      ///< LEDC 定时器（定时器 0 被屏幕背光占用）
+    ledc_channel_t               ledc_channel_base; ///< 第一个通道使用的 LEDC 通道，依次递增
+    uint32_t                     pwm_freq_hz;     ///< PWM 频率
+    uint16_t                     ramp_ms;         ///< 软启动 / 软停止斜坡，0 表示直接开关
+    uint32_t                     max_on_ms;       ///< 单次开启上限（失效保护）
+    pump_report_cb_t             report_cb;       ///< 周期结束回调，可为 NULL
+    void                        *ctx;
+    uint32_t                     task_stack_size;
+    UBaseType_t                  task_priority;
+} pump_driver_config_t;
+
+#define PUMP_DRIVER_DEFAULT_CONFIG(chans, count)                   \
+    (pump_driver_config_t) {                                       \
+        .channels          = (chans),                              \
+        .channel_count     = (count),                              \
+        .ledc_timer        = LEDC_TIMER_1,                         \
+        .ledc_channel_base = LEDC_CHANNEL_2,                       \
+        .pwm_freq_hz       = 20000,                                \
+        .ramp_ms           = 300,                                  \
+        .max_on_ms         = 3600 * 1000,                          \
+        .report_cb         = NULL,                                 \
+        .ctx               = NULL,                                 \
+        .task_stack_size   = 3072,                                 \
+        .task_priority     = tskIDLE_PRIORITY + 5,                 \
+    }
+
+/**
+ * @brief 驱动统计
+ */
+typedef struct {
+    uint32_t cycles;                              ///< 已结束的开启周期数
+    uint32_t volume_stops;                        ///< 流量计定量停止次数
+    uint32_t failsafe_trips;                      ///< 失效保护切断次数
+    uint32_t wakeups;                             ///< 累计唤醒次数
+    int32_t  last_error_permille;                 ///< 最近一次周期的定量误差
+    int32_t  max_abs_error_permille;              ///< 定量误差绝对值最大值
+} pump_driver_stats_t;
+
+/**
+ * @brief 初始化 LEDC / PCNT / 定时器并启动驱动任务，所有输出保持关闭
+ *
+ * 任意一步失败都会释放已申请的通道资源并返回错误，之后可重新调用。
+ *
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 配置非法, ESP_ERR_NO_MEM 资源不足, ESP_ERR_INVALID_STATE 已初始化，
+ *         其他值为外设驱动错误
+ */
+esp_err_t pump_driver_init(const pump_driver_config_t *config);
+
+/**
+ * @brief 开启通道
+ *
+ * 关闭状态下开始一个新周期：软启动、启动失效保护；已开启时只按新的 duration_ms 重设停止时刻。
+ * 有流量计且 volume_ml > 0 时到达水量即停止；没有流量计时按额定流量把水量换算为时长。
+ * duration_ms 与水量都给出时以先到者为准。
+ *
+ * @param channel     通道号
+ * @param duration_ms 开启时长，0 表示一直开到 pump_driver_stop（仍受 max_on_ms 限制）
+ * @param volume_ml   目标水量，0 表示不定量
+ */
+esp_err_t pump_driver_start(uint8_t channel, uint32_t duration_ms, uint32_t volume_ml);
+
+/**
+ * @brief 软停止通道（已关闭时无操作）
+ */
+esp_err_t pump_driver_stop(uint8_t channel);
+
+/**
+ * @brief 通道是否开启（含软启动 / 软停止过程）
+ */
+bool pump_driver_is_on(uint8_t channel);
+
+/**
+ * @brief 获取统计
+ */
+esp_err_t pump_driver_get_stats(pump_driver_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PUMP_DRIVER_H */
@@ -0,0 +1,64 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-11 10:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-11 10:12:40
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_pump_driver\src\pump_dose.c
+ * @Description: 定量浇水换算实现
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include "pump_dose.h"
+
+uint32_t pump_dose_ml_to_pulses(uint32_t ml, uint16_t pulses_per_l)
+{
+    return (uint32_t)(((uint64_t)ml * pulses_per_l + 500) / 1000);
+}
+
+uint32_t pump_dose_pulses_to_ml(uint32_t pulses, uint16_t pulses_per_l)
+{
+    if (pulses_per_l == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)pulses * 1000 + pulses_per_l / 2) / pulses_per_l);
+}
+
+uint32_t pump_dose_watch_point(uint32_t target_pulses, uint32_t lead_q4)
+{
+    uint32_t lead = (lead_q4 + (1u << (PUMP_DOSE_LEAD_SHIFT - 1))) >> PUMP_DOSE_LEAD_SHIFT;
+    return target_pulses > lead + 1 ? target_pulses - lead : 1;
+}
+
+uint32_t pump_dose_update_lead(uint32_t lead_q4, uint32_t target, uint32_t watch, uint32_t actual)
+{
+    int64_t overshoot = actual > watch ? (int64_t)(actual - watch) << PUMP_DOSE_LEAD_SHIFT : 0;
+    int64_t next      = (int64_t)lead_q4 + (overshoot - (int64_t)lead_q4) / 4;
+    int64_t cap       = (int64_t)(target / 2) << PUMP_DOSE_LEAD_SHIFT;
+    if (next < 0) {
+        next = 0;
+    }
+    return (uint32_t)(next > cap ? cap : next);
+}
+
+uint32_t pump_dose_open_loop_ms(uint32_t ml, uint16_t nominal_ml_min, uint16_t ramp_ms)
+{
+    if (nominal_ml_min == 0) {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)ml * 60000 + nominal_ml_min / 2) / nominal_ml_min) + ramp_ms;
+}
+
+uint32_t pump_dose_estimate_ml(uint32_t on_ms, uint16_t nominal_ml_min, uint16_t ramp_ms)
+{
+    uint32_t full_ms = on_ms > ramp_ms ? on_ms - ramp_ms : on_ms / 2;
+    return (uint32_t)(((uint64_t)full_ms * nominal_ml_min + 30000) / 60000);
+}
+
+int32_t pump_dose_error_permille(uint32_t actual, uint32_t target)
+{
+    if (target == 0) {
+        return 0;
+    }
+    return (int32_t)(((int64_t)actual - (int64_t)target) * 1000 / (int64_t)target);
+}
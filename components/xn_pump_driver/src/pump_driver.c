@@ -0,0 +1,684 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-11 10:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-11 10:12:40
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_pump_driver\src\pump_driver.c
+ * @Description: 水泵硬件定时驱动实现
+ *
+ * 一个开启周期：OFF -> ON（软启动渐变）-> STOPPING（软停止渐变）-> OFF。
+ *  - 开始 / 停止渐变由 LEDC 硬件完成，只有渐变结束中断会唤醒 CPU；
+ *  - 开启时长到点、PCNT 观察点中断、渐变结束中断、失效保护都只通过任务通知交给驱动任务处理，
+ *    每个事件唤醒一次；定时器回调从不取锁，共享的 esp_timer 任务不会被持锁的任务拖住；
+ *  - 通道状态由 s_mutex 保护；失效保护回调不取锁，先 ledc_stop 切断输出再通知任务收尾。
+ *    开启 ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD 与 LEDC_CTRL_FUNC_IN_IRAM 时失效保护在中断里执行，
+ *    即使 esp_timer 任务被其他回调卡住也能切断输出；
+ *  - 周期结果在持锁时生成，锁外由驱动任务调用 report_cb，上层可以在回调里操作调度引擎。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "driver/pulse_cnt.h"
+
+#include "pump_dose.h"
+#include "pump_driver.h"
+
+static const char *TAG = "pump_driver";
+
+#define PUMP_SPEED_MODE        LEDC_LOW_SPEED_MODE
+#define PUMP_DUTY_FULL         (1u << PUMP_DRIVER_PWM_BITS)
+#define PUMP_GLITCH_NS         5000                 ///< 流量计输入毛刺滤波
+#define PUMP_TIMER_SLACK_US    1000                 ///< 判断定时器回调是否过期的容差
+
+/* 任务通知位：事件 × 通道上限 + 通道 */
+#define PUMP_EV_VOLUME         0
+#define PUMP_EV_FADE_DONE      1
+#define PUMP_EV_REPORT         2
+#define PUMP_EV_FAILSAFE       3
+#define PUMP_EV_TIME           4
+#define PUMP_EV_COUNT          5
+#define PUMP_EV_BIT(ev, ch)    (1u << ((ev) * PUMP_DRIVER_MAX_CHANNELS + (ch)))
+#define PUMP_EV_MASK(ch)       (PUMP_EV_BIT(PUMP_EV_VOLUME, ch) | PUMP_EV_BIT(PUMP_EV_FADE_DONE, ch) | \
+                                PUMP_EV_BIT(PUMP_EV_REPORT, ch) | PUMP_EV_BIT(PUMP_EV_FAILSAFE, ch) | \
+                                PUMP_EV_BIT(PUMP_EV_TIME, ch))
+
+_Static_assert(PUMP_EV_COUNT * PUMP_DRIVER_MAX_CHANNELS <= 32, "pump event bits exceed notification word");
+
+/* 失效保护定时器：能在中断里派发且 ledc_stop 位于 IRAM 时不经过 esp_timer 任务 */
+#if CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD && CONFIG_LEDC_CTRL_FUNC_IN_IRAM
+#define PUMP_SAFE_DISPATCH     ESP_TIMER_ISR
+#define PUMP_SAFE_ATTR         IRAM_ATTR
+#define PUMP_SAFE_IN_ISR       1
+#else
+#define PUMP_SAFE_DISPATCH     ESP_TIMER_TASK
+#define PUMP_SAFE_ATTR
+#define PUMP_SAFE_IN_ISR       0
+#endif
+
+typedef enum {
+    PUMP_STATE_OFF = 0,
+    PUMP_STATE_ON,
+    PUMP_STATE_STOPPING,
+} pump_state_t;
+
+typedef struct {
+    pump_channel_config_t hw;
+    uint8_t               index;
+    ledc_channel_t        ledc;
+    pcnt_unit_handle_t    unit;                     ///< 流量计，NULL 表示没有
+    pcnt_channel_handle_t chan;
+    volatile int          watch;                    ///< 当前定量观察点，0 表示没有
+    esp_timer_handle_t    stop_timer;               ///< 开启时长
+    esp_timer_handle_t    safe_timer;               ///< 失效保护
+
+    volatile pump_state_t state;
+    pump_stop_reason_t    reason;
+    int64_t               start_us;                 ///< 开始软启动
+    volatile int64_t      end_us;                   ///< 输出完全关闭（软停止结束中断里记录）
+    int64_t               stop_at_us;               ///< 开始软停止的时刻，0 表示不定时
+    volatile int64_t      safe_at_us;               ///< 失效保护时刻
+    uint32_t              requested_ms;
+    uint32_t              target_ml;
+    uint32_t              target_pulses;
+    uint32_t              lead_q4;                  ///< 观察点提前量（1/16 脉冲，按实测过冲自学习）
+    uint32_t              wakeups;                  ///< 本周期唤醒次数（原子累加）
+    pump_cycle_report_t   report;                   ///< 最近一次周期结果，等待驱动任务回报
+} pump_channel_t;
+
+static pump_driver_config_t s_cfg;
+static SemaphoreHandle_t    s_mutex;
+static TaskHandle_t         s_task;
+static pump_channel_t       s_chans[PUMP_DRIVER_MAX_CHANNELS];
+static pump_driver_stats_t  s_stats;
+
+static inline void pump_count_wakeup(pump_channel_t *c)
+{
+    __atomic_fetch_add(&c->wakeups, 1, __ATOMIC_RELAXED);
+}
+
+static void pump_notify(pump_channel_t *c, int ev)
+{
+    xTaskNotify(s_task, PUMP_EV_BIT(ev, c->index), eSetBits);
+}
+
+/* -------------------- 中断 / 定时器回调 -------------------- */
+
+static bool IRAM_ATTR pump_on_fade_end(const ledc_cb_param_t *param, void *user_arg)
+{
+    pump_channel_t *c     = (pump_channel_t *)user_arg;
+    BaseType_t      woken = pdFALSE;
+
+    if (param->event != LEDC_FADE_END_EVT) {
+        return false;
+    }
+    pump_count_wakeup(c);
+
+    /* 软启动结束不需要处理，只有降到 0 才唤醒任务收尾 */
+    if (param->duty == 0) {
+        c->end_us = esp_timer_get_time();
+        xTaskNotifyFromISR(s_task, PUMP_EV_BIT(PUMP_EV_FADE_DONE, c->index), eSetBits, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+static bool IRAM_ATTR pump_on_watch(pcnt_unit_handle_t unit, const pcnt_watch_event_data_t *edata, void *user_ctx)
+{
+    pump_channel_t *c     = (pump_channel_t *)user_ctx;
+    BaseType_t      woken = pdFALSE;
+
+    (void)unit;
+    pump_count_wakeup(c);
+
+    /* 上限观察点只用于计数累加，不是定量观察点 */
+    if (c->state == PUMP_STATE_ON && c->watch != 0 && edata->watch_point_value == c->watch) {
+        xTaskNotifyFromISR(s_task, PUMP_EV_BIT(PUMP_EV_VOLUME, c->index), eSetBits, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+static void PUMP_SAFE_ATTR pump_on_safe_timer(void *arg)
+{
+    pump_channel_t *c = (pump_channel_t *)arg;
+
+    pump_count_wakeup(c);
+    if (c->state == PUMP_STATE_OFF || esp_timer_get_time() + PUMP_TIMER_SLACK_US < c->safe_at_us) {
+        return;
+    }
+
+    /* 不取锁：即使持锁的任务卡住也要切断输出，收尾交给驱动任务 */
+    (void)ledc_stop(PUMP_SPEED_MODE, c->ledc, 0);
+#if PUMP_SAFE_IN_ISR
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(s_task, PUMP_EV_BIT(PUMP_EV_FAILSAFE, c->index), eSetBits, &woken);
+    if (woken == pdTRUE) {
+        esp_timer_isr_dispatch_need_yield();
+    }
+#else
+    xTaskNotify(s_task, PUMP_EV_BIT(PUMP_EV_FAILSAFE, c->index), eSetBits);
+#endif
+}
+
+static void pump_on_stop_timer(void *arg)
+{
+    pump_channel_t *c = (pump_channel_t *)arg;
+
+    /* 只通知驱动任务：这里运行在所有模块共享的 esp_timer 任务中，不能等锁 */
+    pump_count_wakeup(c);
+    pump_notify(c, PUMP_EV_TIME);
+}
+
+/* -------------------- 输出与流量计（持锁调用） -------------------- */
+
+static void pump_output_off(pump_channel_t *c)
+{
+    (void)ledc_fade_stop(PUMP_SPEED_MODE, c->ledc);
+    (void)ledc_set_duty(PUMP_SPEED_MODE, c->ledc, 0);
+    (void)ledc_stop(PUMP_SPEED_MODE, c->ledc, 0);
+}
+
+static void pump_output_on(pump_channel_t *c)
+{
+    /* 软停止中途重新开启时从当前占空比继续上升 */
+    (void)ledc_fade_stop(PUMP_SPEED_MODE, c->ledc);
+    if (s_cfg.ramp_ms == 0) {
+        (void)ledc_set_duty(PUMP_SPEED_MODE, c->ledc, PUMP_DUTY_FULL);
+        (void)ledc_update_duty(PUMP_SPEED_MODE, c->ledc);
+        return;
+    }
+    (void)ledc_set_fade_with_time(PUMP_SPEED_MODE, c->ledc, PUMP_DUTY_FULL, s_cfg.ramp_ms);
+    (void)ledc_fade_start(PUMP_SPEED_MODE, c->ledc, LEDC_FADE_NO_WAIT);
+}
+
+/**
+ * @brief 新周期开始计数；target_pulses > 0 时设置定量观察点
+ */
+static void pump_flow_begin(pump_channel_t *c, uint32_t target_pulses)
+{
+    (void)pcnt_unit_stop(c->unit);
+    (void)pcnt_unit_clear_count(c->unit);
+    if (c->watch != 0) {
+        (void)pcnt_unit_remove_watch_point(c->unit, c->watch);
+        c->watch = 0;
+    }
+    if (target_pulses > 0) {
+        int watch = (int)pump_dose_watch_point(target_pulses, c->lead_q4);
+        if (pcnt_unit_add_watch_point(c->unit, watch) == ESP_OK) {
+            c->watch = watch;
+        } else {
+            ESP_LOGW(TAG, "⚠️ ch%u add watch point %d failed, dose by time only", (unsigned)c->index, watch);
+        }
+    }
+    (void)pcnt_unit_start(c->unit);
+}
+
+/**
+ * @brief 设置开启时长：软停止斜坡算在时长内，到点时输出恰好完全关闭
+ */
+static void pump_arm_stop(pump_channel_t *c, int64_t now, uint32_t duration_ms)
+{
+    (void)esp_timer_stop(c->stop_timer);
+    c->stop_at_us = 0;
+    if (duration_ms == 0) {
+        return;
+    }
+
+    uint32_t ramp_ms  = s_cfg.ramp_ms < duration_ms ? s_cfg.ramp_ms : duration_ms;
+    uint64_t delay_us = (uint64_t)(duration_ms - ramp_ms) * 1000;
+    if (delay_us < PUMP_TIMER_SLACK_US) {
+        delay_us = PUMP_TIMER_SLACK_US;
+    }
+    c->stop_at_us = now + (int64_t)delay_us;
+    (void)esp_timer_start_once(c->stop_timer, delay_us);
+}
+
+/**
+ * @brief 结束周期并生成结果（输出已关闭，end_us 已记录）
+ */
+static void pump_finish(pump_channel_t *c)
+{
+    (void)esp_timer_stop(c->stop_timer);
+    (void)esp_timer_stop(c->safe_timer);
+    c->state = PUMP_STATE_OFF;
+
+    pump_cycle_report_t *r = &c->report;
+    memset(r, 0, sizeof(*r));
+    r->channel      = c->index;
+    r->reason       = c->reason;
+    r->requested_ms = c->requested_ms;
+    r->target_ml    = c->target_ml;
+    r->on_ms        = c->end_us > c->start_us ? (uint32_t)((c->end_us - c->start_us) / 1000) : 0;
+
+    if (c->unit != NULL) {
+        int count = 0;
+        (void)pcnt_unit_get_count(c->unit, &count);
+        (void)pcnt_unit_stop(c->unit);
+        r->pulses       = count > 0 ? (uint32_t)count : 0;
+        r->delivered_ml = pump_dose_pulses_to_ml(r->pulses, c->hw.pulses_per_l);
+        r->measured     = true;
+        if (c->reason == PUMP_STOP_VOLUME && c->watch != 0) {
+            c->lead_q4 = pump_dose_update_lead(c->lead_q4, c->target_pulses, (uint32_t)c->watch, r->pulses);
+        }
+    } else {
+        r->delivered_ml = pump_dose_estimate_ml(r->on_ms, c->hw.nominal_ml_min, s_cfg.ramp_ms);
+    }
+
+    if (r->target_ml > 0) {
+        r->error_permille = pump_dose_error_permille(r->delivered_ml, r->target_ml);
+    } else if (r->requested_ms > 0 && c->reason == PUMP_STOP_TIME) {
+        r->error_permille = pump_dose_error_permille(r->on_ms, r->requested_ms);
+    }
+    r->wakeups = __atomic_exchange_n(&c->wakeups, 0, __ATOMIC_RELAXED);
+
+    s_stats.cycles++;
+    s_stats.wakeups += r->wakeups;
+    if (c->reason == PUMP_STOP_VOLUME) {
+        s_stats.volume_stops++;
+    } else if (c->reason == PUMP_STOP_FAILSAFE) {
+        s_stats.failsafe_trips++;
+    }
+    s_stats.last_error_permille = r->error_permille;
+    int32_t abs_err = r->error_permille < 0 ? -r->error_permille : r->error_permille;
+    if (abs_err > s_stats.max_abs_error_permille) {
+        s_stats.max_abs_error_permille = abs_err;
+    }
+}
+
+/**
+ * @brief 开始软停止
+ * @return true 周期已立即结束（无斜坡），调用方需在锁外通知任务回报
+ */
+static bool pump_soft_stop(pump_channel_t *c, pump_stop_reason_t reason)
+{
+    if (c->state != PUMP_STATE_ON) {
+        return false;
+    }
+    (void)esp_timer_stop(c->stop_timer);
+    c->reason = reason;
+    c->state  = PUMP_STATE_STOPPING;
+
+    if (s_cfg.ramp_ms == 0) {
+        pump_output_off(c);
+        c->end_us = esp_timer_get_time();
+        pump_finish(c);
+        return true;
+    }
+
+    /* 软启动未结束时从当前占空比开始下降 */
+    (void)ledc_fade_stop(PUMP_SPEED_MODE, c->ledc);
+    (void)ledc_set_fade_with_time(PUMP_SPEED_MODE, c->ledc, 0, s_cfg.ramp_ms);
+    (void)ledc_fade_start(PUMP_SPEED_MODE, c->ledc, LEDC_FADE_NO_WAIT);
+    return false;
+}
+
+/* -------------------- 驱动任务 -------------------- */
+
+static void pump_task(void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+
+        for (uint8_t i = 0; i < s_cfg.channel_count; i++) {
+            if ((bits & PUMP_EV_MASK(i)) == 0) {
+                continue;
+            }
+            pump_channel_t     *c      = &s_chans[i];
+            bool                report = false;
+            pump_cycle_report_t r;
+
+            pump_count_wakeup(c);
+            xSemaphoreTake(s_mutex, portMAX_DELAY);
+            if ((bits & PUMP_EV_BIT(PUMP_EV_FAILSAFE, i)) && c->state != PUMP_STATE_OFF) {
+                pump_output_off(c);
+                c->reason = PUMP_STOP_FAILSAFE;
+                c->end_us = esp_timer_get_time();
+                pump_finish(c);
+                report = true;
+                ESP_LOGW(TAG, "🛑 ch%u failsafe: on for %u ms", (unsigned)i, (unsigned)c->report.on_ms);
+            }
+            if (bits & PUMP_EV_BIT(PUMP_EV_VOLUME, i)) {
+                report |= pump_soft_stop(c, PUMP_STOP_VOLUME);
+            }
+            /* 通知送达前停止时刻刚被重设（延后）时忽略 */
+            if ((bits & PUMP_EV_BIT(PUMP_EV_TIME, i)) && c->state == PUMP_STATE_ON && c->stop_at_us != 0 &&
+                esp_timer_get_time() + PUMP_TIMER_SLACK_US >= c->stop_at_us) {
+                report |= pump_soft_stop(c, PUMP_STOP_TIME);
+            }
+            if ((bits & PUMP_EV_BIT(PUMP_EV_FADE_DONE, i)) && c->state == PUMP_STATE_STOPPING) {
+                (void)ledc_stop(PUMP_SPEED_MODE, c->ledc, 0);
+                pump_finish(c);
+                report = true;
+            }
+            if (bits & PUMP_EV_BIT(PUMP_EV_REPORT, i)) {
+                report = true;
+            }
+            r = c->report;
+            xSemaphoreGive(s_mutex);
+
+            if (!report) {
+                continue;
+            }
+            ESP_LOGI(TAG, "💧 ch%u done: reason=%d on=%u/%u ms ml=%u/%u err=%d‰ wakeups=%u",
+                     (unsigned)i, (int)r.reason, (unsigned)r.on_ms, (unsigned)r.requested_ms,
+                     (unsigned)r.delivered_ml, (unsigned)r.target_ml, (int)r.error_permille,
+                     (unsigned)r.wakeups);
+            if (s_cfg.report_cb != NULL) {
+                s_cfg.report_cb(&r, s_cfg.ctx);
+            }
+        }
+    }
+}
+
+/* -------------------- 初始化 -------------------- */
+
+static esp_err_t pump_flow_init(pump_channel_t *c)
+{
+    pcnt_unit_config_t unit_cfg = {
+        .low_limit  = -1,
+        .high_limit = PUMP_DRIVER_MAX_PULSES,
+        .flags.accum_count = 1,                     ///< 常开时超过上限继续累加
+    };
+    esp_err_t ret = pcnt_new_unit(&unit_cfg, &c->unit);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    pcnt_glitch_filter_config_t filter = { .max_glitch_ns = PUMP_GLITCH_NS };
+    (void)pcnt_unit_set_glitch_filter(c->unit, &filter);
+
+    pcnt_chan_config_t chan_cfg = {
+        .edge_gpio_num  = c->hw.flow_gpio,
+        .level_gpio_num = -1,
+    };
+    ret = pcnt_new_channel(c->unit, &chan_cfg, &c->chan);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    (void)pcnt_channel_set_edge_action(c->chan, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_HOLD);
+    (void)gpio_pullup_en((gpio_num_t)c->hw.flow_gpio);  ///< 霍尔流量计多为开漏输出
+
+    pcnt_event_callbacks_t cbs = { .on_reach = pump_on_watch };
+    ret = pcnt_unit_register_event_callbacks(c->unit, &cbs, c);
+    if (ret == ESP_OK) {
+        ret = pcnt_unit_add_watch_point(c->unit, PUMP_DRIVER_MAX_PULSES);
+    }
+    if (ret == ESP_OK) {
+        ret = pcnt_unit_enable(c->unit);
+    }
+    return ret;
+}
+
+static esp_err_t pump_channel_init(pump_channel_t *c)
+{
+    ledc_channel_config_t ch_cfg = {
+        .gpio_num   = c->hw.gpio,
+        .speed_mode = PUMP_SPEED_MODE,
+        .channel    = c->ledc,
+        .intr_type  = LEDC_INTR_DISABLE,
+        .timer_sel  = s_cfg.ledc_timer,
+        .duty       = 0,
+        .hpoint     = 0,
+    };
+    esp_err_t ret = ledc_channel_config(&ch_cfg);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    ledc_cbs_t cbs = { .fade_cb = pump_on_fade_end };
+    ret = ledc_cb_register(PUMP_SPEED_MODE, c->ledc, &cbs, c);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    esp_timer_create_args_t stop_args = {
+        .callback        = pump_on_stop_timer,
+        .arg             = c,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name            = "pump_stop",
+    };
+    ret = esp_timer_create(&stop_args, &c->stop_timer);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    esp_timer_create_args_t safe_args = {
+        .callback        = pump_on_safe_timer,
+        .arg             = c,
+        .dispatch_method = PUMP_SAFE_DISPATCH,
+        .name            = "pump_safe",
+    };
+    ret = esp_timer_create(&safe_args, &c->safe_timer);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    if (c->hw.flow_gpio >= 0) {
+        ret = pump_flow_init(c);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "ch%u flow meter init failed: %s", (unsigned)c->index, esp_err_to_name(ret));
+            return ret;
+        }
+    }
+    return ESP_OK;
+}
+
+/* 释放通道已申请的资源（初始化失败时调用），输出保持低电平 */
+static void pump_channel_deinit(pump_channel_t *c)
+{
+    if (c->unit) {
+        (void)pcnt_unit_disable(c->unit);
+        if (c->chan) {
+            (void)pcnt_del_channel(c->chan);
+        }
+        (void)pcnt_del_unit(c->unit);
+    }
+    if (c->safe_timer) {
+        (void)esp_timer_delete(c->safe_timer);
+    }
+    if (c->stop_timer) {
+        (void)esp_timer_delete(c->stop_timer);
+    }
+    ledc_cbs_t no_cbs = { 0 };
+    (void)ledc_cb_register(PUMP_SPEED_MODE, c->ledc, &no_cbs, NULL);
+    (void)ledc_stop(PUMP_SPEED_MODE, c->ledc, 0);
+    memset(c, 0, sizeof(*c));
+}
+
+static void pump_driver_cleanup(uint8_t channels)
+{
+    for (uint8_t i = 0; i < channels; i++) {
+        pump_channel_deinit(&s_chans[i]);
+    }
+    vSemaphoreDelete(s_mutex);
+    s_mutex = NULL;
+}
+
+esp_err_t pump_driver_init(const pump_driver_config_t *config)
+{
+    if (s_task != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (config == NULL || config->channels == NULL ||
+        config->channel_count == 0 || config->channel_count > PUMP_DRIVER_MAX_CHANNELS ||
+        (int)config->ledc_channel_base + config->channel_count > (int)LEDC_CHANNEL_MAX ||
+        config->max_on_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_cfg = *config;
+
+    s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ledc_timer_config_t timer_cfg = {
+        .speed_mode      = PUMP_SPEED_MODE,
+        .duty_resolution = (ledc_timer_bit_t)PUMP_DRIVER_PWM_BITS,
+        .timer_num       = s_cfg.ledc_timer,
+        .freq_hz         = s_cfg.pwm_freq_hz,
+        .clk_cfg         = LEDC_AUTO_CLK,
+    };
+    esp_err_t ret = ledc_timer_config(&timer_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "ledc timer config failed: %s", esp_err_to_name(ret));
+        pump_driver_cleanup(0);
+        return ret;
+    }
+
+    /* 屏幕背光可能已经安装过渐变服务 */
+    ret = ledc_fade_func_install(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "ledc fade install failed: %s", esp_err_to_name(ret));
+        pump_driver_cleanup(0);
+        return ret;
+    }
+
+    for (uint8_t i = 0; i < s_cfg.channel_count; i++) {
+        pump_channel_t *c = &s_chans[i];
+        c->hw    = s_cfg.channels[i];
+        c->index = i;
+        c->ledc  = (ledc_channel_t)(s_cfg.ledc_channel_base + i);
+        ret = pump_channel_init(c);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "ch%u init failed: %s", (unsigned)i, esp_err_to_name(ret));
+            pump_driver_cleanup(i + 1);
+            return ret;
+        }
+    }
+
+    /* 最后创建任务：s_task 非空即表示全部通道已就绪，对外接口据此放行 */
+    BaseType_t ok = xTaskCreate(pump_task, "pump_driver", s_cfg.task_stack_size,
+                                NULL, s_cfg.task_priority, &s_task);
+    if (ok != pdPASS) {
+        s_task = NULL;
+        pump_driver_cleanup(s_cfg.channel_count);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "✅ pump driver started: %u channels, ramp %u ms, max on %u s",
+             (unsigned)s_cfg.channel_count, (unsigned)s_cfg.ramp_ms, (unsigned)(s_cfg.max_on_ms / 1000));
+    return ESP_OK;
+}
+
+/* -------------------- 对外接口 -------------------- */
+
+esp_err_t pump_driver_start(uint8_t channel, uint32_t duration_ms, uint32_t volume_ml)
+{
+    if (s_task == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (channel >= s_cfg.channel_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pump_channel_t *c      = &s_chans[channel];
+    bool            report = false;
+    int64_t         now    = esp_timer_get_time();
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (c->state == PUMP_STATE_ON) {
+        /* 已开启：只重设停止时刻，失效保护不随之延长 */
+        pump_arm_stop(c, now, duration_ms);
+        c->requested_ms = duration_ms == 0 ? 0 : (uint32_t)((now - c->start_us) / 1000) + duration_ms;
+        xSemaphoreGive(s_mutex);
+        return ESP_OK;
+    }
+    if (c->state == PUMP_STATE_STOPPING) {
+        c->reason = PUMP_STOP_RESTART;
+        c->end_us = now;
+        pump_finish(c);
+        report = true;
+    }
+
+    c->state         = PUMP_STATE_ON;
+    c->reason        = PUMP_STOP_COMMAND;
+    c->start_us      = now;
+    c->end_us        = 0;
+    c->target_ml     = volume_ml;
+    c->target_pulses = 0;
+
+    if (volume_ml > 0 && c->unit != NULL) {
+        c->target_pulses = pump_dose_ml_to_pulses(volume_ml, c->hw.pulses_per_l);
+        if (c->target_pulses >= PUMP_DRIVER_MAX_PULSES) {
+            ESP_LOGW(TAG, "⚠️ ch%u dose %u ml exceeds counter range, clamped", (unsigned)channel, (unsigned)volume_ml);
+            c->target_pulses = PUMP_DRIVER_MAX_PULSES - 1;
+        }
+    } else if (volume_ml > 0) {
+        /* 没有流量计：按额定流量换算为时长（开环） */
+        uint32_t ms = pump_dose_open_loop_ms(volume_ml, c->hw.nominal_ml_min, s_cfg.ramp_ms);
+        if (ms > 0 && (duration_ms == 0 || ms < duration_ms)) {
+            duration_ms = ms;
+        }
+    }
+    c->requested_ms = duration_ms;
+
+    if (c->unit != NULL) {
+        pump_flow_begin(c, c->target_pulses);
+    }
+    pump_output_on(c);
+
+    c->safe_at_us = now + (int64_t)s_cfg.max_on_ms * 1000;
+    (void)esp_timer_start_once(c->safe_timer, (uint64_t)s_cfg.max_on_ms * 1000);
+    pump_arm_stop(c, now, duration_ms);
+    xSemaphoreGive(s_mutex);
+
+    if (report) {
+        pump_notify(c, PUMP_EV_REPORT);
+    }
+    ESP_LOGI(TAG, "ch%u start: %u ms, %u ml (%u pulses)",
+             (unsigned)channel, (unsigned)duration_ms, (unsigned)volume_ml, (unsigned)c->target_pulses);
+    return ESP_OK;
+}
+
+esp_err_t pump_driver_stop(uint8_t channel)
+{
+    if (s_task == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (channel >= s_cfg.channel_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pump_channel_t *c = &s_chans[channel];
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool finished = pump_soft_stop(c, PUMP_STOP_COMMAND);
+    xSemaphoreGive(s_mutex);
+
+    if (finished) {
+        pump_notify(c, PUMP_EV_REPORT);
+    }
+    return ESP_OK;
+}
+
+bool pump_driver_is_on(uint8_t channel)
+{
+    if (s_task == NULL || channel >= s_cfg.channel_count) {
+        return false;
+    }
+    return s_chans[channel].state != PUMP_STATE_OFF;
+}
+
+esp_err_t pump_driver_get_stats(pump_driver_stats_t *stats)
+{
+    if (stats == NULL || s_mutex == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_mutex);
+    return ESP_OK;
+}
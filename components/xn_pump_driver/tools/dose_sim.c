@@ -0,0 +1,216 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-11 10:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-11 10:12:40
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_pump_driver\tools\dose_sim.c
+ * @Description: 定量浇水主机自检 + 精度仿真
+ *
+ * 编译运行（在组件目录下）：
+ *   gcc -O2 -Iinclude src/pump_dose.c tools/dose_sim.c -o dose_sim
+ *   ./dose_sim [每种方式的周期数]
+ *
+ * 自检：换算函数的取整与边界。
+ * 仿真：以 0.1 ms 步长积分水泵流量（软启停斜坡按占空比线性），流量计按 K 系数产生脉冲，
+ * 停止请求有 0 ~ 5 ms 的中断 + 任务延迟，每个周期供水压力使流量在额定值 ±15% 内随机变化。
+ * 比较三种方式的实际水量误差：
+ *   - 按时长开环（原来 vTaskDelay 的做法，时长按额定流量换算）；
+ *   - 流量计闭环，观察点 = 目标脉冲（不补偿斜坡过冲）；
+ *   - 流量计闭环，观察点提前量按实测过冲自学习（驱动里的做法）。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pump_dose.h"
+
+#define SIM_STEP_US      100
+#define SIM_RAMP_MS      300
+#define SIM_NOMINAL      2000             ///< 额定流量 ml/min
+#define SIM_K            450              ///< 脉冲 / 升
+#define SIM_TARGET_ML    500
+#define SIM_SPREAD       150              ///< 流量随机偏差 ±‰
+#define SIM_LATENCY_US   5000             ///< 停止请求最大延迟
+
+static int s_failures;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);          \
+            s_failures++;                                                   \
+        }                                                                   \
+    } while (0)
+
+static uint32_t s_rng = 0x2545F491u;
+
+static uint32_t sim_rand(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static void test_convert(void)
+{
+    CHECK(pump_dose_ml_to_pulses(1000, 450) == 450);
+    CHECK(pump_dose_ml_to_pulses(1, 450) == 0);
+    CHECK(pump_dose_ml_to_pulses(2, 450) == 1);
+    CHECK(pump_dose_pulses_to_ml(450, 450) == 1000);
+    CHECK(pump_dose_pulses_to_ml(1, 450) == 2);
+    CHECK(pump_dose_pulses_to_ml(10, 0) == 0);
+
+    CHECK(pump_dose_watch_point(100, 0) == 100);
+    CHECK(pump_dose_watch_point(100, 3 * 16) == 97);
+    CHECK(pump_dose_watch_point(100, 40) == 97);              ///< 2.5 脉冲四舍五入为 3
+    CHECK(pump_dose_watch_point(3, 5 * 16) == 1);
+    CHECK(pump_dose_watch_point(0, 0) == 1);
+
+    CHECK(pump_dose_update_lead(0, 100, 100, 104) == 16);     ///< 过冲 4 脉冲：提前量 1 脉冲
+    CHECK(pump_dose_update_lead(64, 100, 96, 100) == 64);     ///< 已收敛：不变
+    CHECK(pump_dose_update_lead(64, 100, 96, 95) == 48);      ///< 没有过冲：逐步减小
+    CHECK(pump_dose_update_lead(40 * 16, 60, 20, 200) == 30 * 16);   ///< 上限为目标的一半
+
+    uint32_t lead = 0;                                        ///< 稳定过冲 2 脉冲时收敛到 2
+    for (int i = 0; i < 30; i++) {
+        lead = pump_dose_update_lead(lead, 100, pump_dose_watch_point(100, lead),
+                                     pump_dose_watch_point(100, lead) + 2);
+    }
+    CHECK(pump_dose_watch_point(100, lead) == 98);
+
+    CHECK(pump_dose_open_loop_ms(1000, 2000, 300) == 30300);
+    CHECK(pump_dose_open_loop_ms(1000, 0, 300) == 0);
+    CHECK(pump_dose_estimate_ml(30300, 2000, 300) == 1000);
+    CHECK(pump_dose_estimate_ml(200, 2000, 300) == 3);       ///< 斜坡中途停止按一半流量
+
+    CHECK(pump_dose_error_permille(505, 500) == 10);
+    CHECK(pump_dose_error_permille(495, 500) == -10);
+    CHECK(pump_dose_error_permille(5, 0) == 0);
+}
+
+typedef struct {
+    double   ml;                          ///< 实际流出
+    uint32_t pulses;                      ///< 流量计读数
+} sim_result_t;
+
+/**
+ * @brief 仿真一个周期
+ * @param flow_ml_min 本周期实际满流量
+ * @param stop_ms     按时长：开始软停止的时刻（ms），0 表示按脉冲
+ * @param watch       按脉冲：观察点
+ */
+static sim_result_t sim_cycle(double flow_ml_min, uint32_t stop_ms, uint32_t watch)
+{
+    sim_result_t res = { 0 };
+    double  per_us      = flow_ml_min / 60000000.0;
+    int64_t stop_req_us = stop_ms > 0 ? (int64_t)stop_ms * 1000 : -1;
+    int64_t stop_us     = -1;
+    double  stop_duty   = 1.0;
+    double  duty        = 0.0;
+
+    for (int64_t t = 0; t < 3600LL * 1000000; t += SIM_STEP_US) {
+        if (stop_us < 0 && stop_req_us >= 0 && t >= stop_req_us) {
+            stop_us   = t;
+            stop_duty = duty;
+        }
+
+        if (stop_us < 0) {
+            duty = t >= SIM_RAMP_MS * 1000 ? 1.0 : (double)t / (SIM_RAMP_MS * 1000);
+        } else {
+            duty = stop_duty - stop_duty * (double)(t - stop_us) / (SIM_RAMP_MS * 1000);
+            if (duty <= 0) {
+                break;
+            }
+        }
+
+        res.ml    += duty * per_us * SIM_STEP_US;
+        res.pulses = (uint32_t)(res.ml * SIM_K / 1000.0);
+
+        /* 观察点到达：中断 -> 驱动任务开始软停止，有随机延迟 */
+        if (watch > 0 && stop_req_us < 0 && res.pulses >= watch) {
+            stop_req_us = t + (int64_t)(sim_rand() % (SIM_LATENCY_US + 1));
+        }
+    }
+    return res;
+}
+
+typedef enum {
+    MODE_TIME = 0,
+    MODE_PULSE_RAW,
+    MODE_PULSE_LEAD,
+} sim_mode_t;
+
+static void sim_run(sim_mode_t mode, int cycles, const char *name)
+{
+    uint32_t target = pump_dose_ml_to_pulses(SIM_TARGET_ML, SIM_K);
+    uint32_t lead   = 0;
+    double   sum_abs = 0, max_abs = 0, sum_abs_tail = 0;
+    int      tail = 0;
+
+    s_rng = 0x2545F491u;                  ///< 三种方式使用同一组流量偏差
+    for (int i = 0; i < cycles; i++) {
+        double flow = SIM_NOMINAL * (1.0 + ((int)(sim_rand() % (2 * SIM_SPREAD + 1)) - SIM_SPREAD) / 1000.0);
+        sim_result_t r;
+
+        if (mode == MODE_TIME) {
+            uint32_t on_ms = pump_dose_open_loop_ms(SIM_TARGET_ML, SIM_NOMINAL, SIM_RAMP_MS);
+            r = sim_cycle(flow, on_ms - SIM_RAMP_MS, 0);
+        } else {
+            uint32_t watch = pump_dose_watch_point(target, mode == MODE_PULSE_LEAD ? lead : 0);
+            r = sim_cycle(flow, 0, watch);
+            if (mode == MODE_PULSE_LEAD) {
+                lead = pump_dose_update_lead(lead, target, watch, r.pulses);
+            }
+        }
+
+        double err = (r.ml - SIM_TARGET_ML) * 1000.0 / SIM_TARGET_ML;
+        double abs_err = err < 0 ? -err : err;
+        sum_abs += abs_err;
+        if (abs_err > max_abs) {
+            max_abs = abs_err;
+        }
+        if (i >= 5) {                     ///< 前 5 个周期为自学习收敛期
+            sum_abs_tail += abs_err;
+            tail++;
+        }
+    }
+
+    printf("%-28s mean |err| %6.1f‰  max %6.1f‰  after 5 cycles %6.1f‰", name,
+           sum_abs / cycles, max_abs, tail > 0 ? sum_abs_tail / tail : 0.0);
+    if (mode == MODE_PULSE_LEAD) {
+        printf("  lead %.2f pulses", lead / 16.0);
+    }
+    printf("\n");
+
+    if (mode == MODE_PULSE_LEAD) {
+        /* 闭环 + 补偿后误差应在 ±2 个脉冲量化以内 */
+        CHECK(tail > 0 && sum_abs_tail / tail < 2.0 * 1000.0 / SIM_K * 1000.0 / SIM_TARGET_ML);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int cycles = argc > 1 ? atoi(argv[1]) : 40;
+    if (cycles < 6) {
+        cycles = 6;
+    }
+
+    test_convert();
+
+    printf("dose %u ml, pump %u ml/min ±%u‰, K %u pulses/L, ramp %u ms, stop latency ≤ %u ms, %d cycles\n",
+           (unsigned)SIM_TARGET_ML, (unsigned)SIM_NOMINAL, (unsigned)SIM_SPREAD, (unsigned)SIM_K,
+           (unsigned)SIM_RAMP_MS, (unsigned)(SIM_LATENCY_US / 1000), cycles);
+    sim_run(MODE_TIME, cycles, "open loop (time)");
+    sim_run(MODE_PULSE_RAW, cycles, "flow meter, no lead");
+    sim_run(MODE_PULSE_LEAD, cycles, "flow meter, learned lead");
+
+    if (s_failures > 0) {
+        printf("%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
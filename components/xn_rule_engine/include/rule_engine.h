@@ -0,0 +1,138 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-10 09:41:05
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-10 09:41:05
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_rule_engine\include\rule_engine.h
+ * @Description: 设备端浇花规则引擎（固定周期采样输入 -> 字节码求值 -> 按区域汇总决策）
+ *
+ * 设计要点：
+ *  - 应用层按编号注册输入（土壤湿度、雨量、本地时间、区域今日开启秒数等），每个周期统一采样一次；
+ *  - 规则程序为 rule_vm.h 描述的字节码，经 MQTT 下发后校验、原子替换并保存到 NVS，断网 / 重启后照常运行；
+ *  - 每个周期把所有规则的结果按区域汇总：任一 RUN 为真则要求开启，任一 INHIBIT 为真则禁止，
+ *    汇总结果变化时调用区域回调；NOTIFY 规则由假变真时调用事件回调；
+ *  - 统计每周期求值耗时、指令数，以及从采样开始到回调执行完毕的决策延迟。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#include "rule_vm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RULE_ENGINE_MAX_ZONES     8
+#define RULE_ENGINE_NVS_NAMESPACE "rules"
+#define RULE_ENGINE_NVS_KEY       "prog"
+
+/**
+ * @brief 输入读取回调
+ * @param valid 输出是否有效（传感器缺失、时钟未同步时置 false）
+ */
+typedef int32_t (*rule_engine_input_cb_t)(void *ctx, bool *valid);
+
+/**
+ * @brief 区域决策回调（汇总结果变化时调用，在规则任务中执行）
+ *
+ * @param run     是否要求开启
+ * @param max_s   要求开启时各 RUN 规则参数的最大值（单次最长开启秒数）
+ * @param inhibit 是否禁止
+ */
+typedef void (*rule_engine_zone_cb_t)(uint8_t zone, bool run, uint16_t max_s, bool inhibit, void *ctx);
+
+/**
+ * @brief NOTIFY 规则触发回调
+ */
+typedef void (*rule_engine_notify_cb_t)(uint8_t rule, uint16_t code, void *ctx);
+
+/**
+ * @brief 规则引擎配置
+ */
+typedef struct {
+    rule_engine_zone_cb_t   zone_cb;          ///< 不可为 NULL
+    rule_engine_notify_cb_t notify_cb;        ///< 可为 NULL
+    void                   *ctx;
+    uint8_t                 zone_count;       ///< 1 ~ RULE_ENGINE_MAX_ZONES
+    uint32_t                tick_ms;          ///< 求值周期
+    uint32_t                task_stack_size;
+    UBaseType_t             task_priority;
+} rule_engine_config_t;
+
+#define RULE_ENGINE_DEFAULT_CONFIG(callback)                       \
+    (rule_engine_config_t) {                                       \
+        .zone_cb         = (callback),                             \
+        .notify_cb       = NULL,                                   \
+        .ctx             = NULL,                                   \
+        .zone_count      = 1,                                      \
+        .tick_ms         = 1000,                                   \
+        .task_stack_size = 3072,                                   \
+        .task_priority   = tskIDLE_PRIORITY + 2,                   \
+    }
+
+/**
+ * @brief 运行统计
+ */
+typedef struct {
+    uint8_t  rules;                           ///< 当前程序的规则数
+    uint16_t program_size;                    ///< 当前程序字节数
+    uint32_t ticks;                           ///< 求值周期数
+    uint32_t overruns;                        ///< 周期超时（求值 + 回调超过 tick_ms）次数
+    uint32_t ops_last;                        ///< 上个周期执行的指令数
+    uint32_t sample_us_last;                  ///< 上个周期采样输入耗时
+    uint32_t eval_us_last;                    ///< 上个周期求值耗时
+    uint32_t eval_us_max;
+    uint32_t eval_us_avg;
+    uint32_t decisions;                       ///< 区域决策变化次数
+    uint32_t latency_us_last;                 ///< 上次决策：采样开始到回调返回
+    uint32_t latency_us_max;
+    uint32_t unknown;                         ///< 因无效输入按安全值处理的规则求值次数
+    uint32_t loads;                           ///< 成功加载程序次数
+    uint32_t load_errors;                     ///< 校验失败次数
+} rule_engine_stats_t;
+
+/**
+ * @brief 初始化并启动规则任务，加载 NVS 中保存的程序
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 配置非法, ESP_ERR_NO_MEM 资源不足, ESP_ERR_INVALID_STATE 已初始化
+ */
+esp_err_t rule_engine_init(const rule_engine_config_t *config);
+
+/**
+ * @brief 注册输入（init 前后均可调用，重复注册同一编号会覆盖）
+ * @param id 输入编号（0 ~ RULE_VM_MAX_INPUTS-1），与规则字节码中的 IN 操作数对应
+ */
+esp_err_t rule_engine_register_input(uint8_t id, rule_engine_input_cb_t read, void *ctx);
+
+/**
+ * @brief 校验并替换规则程序，下一个周期生效
+ *
+ * @param blob    字节码，len 为 0 表示清空全部规则
+ * @param persist 是否保存到 NVS
+ * @param err     可为 NULL，输出校验错误
+ * @param err_off 可为 NULL，输出出错位置
+ *
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 校验失败（程序不变）, 其他值为 NVS 错误（程序已生效）
+ */
+esp_err_t rule_engine_load(const uint8_t *blob, size_t len, bool persist,
+                           rule_vm_err_t *err, uint16_t *err_off);
+
+/**
+ * @brief 获取运行统计
+ */
+esp_err_t rule_engine_get_stats(rule_engine_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RULE_ENGINE_H */
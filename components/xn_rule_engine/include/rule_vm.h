@@ -0,0 +1,169 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-10 09:41:05
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-10 09:41:05
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_rule_engine\include\rule_vm.h
+ * @Description: 浇花规则字节码虚拟机（纯数据结构，不依赖 FreeRTOS，可在主机上编译）
+ *
+ * 程序格式（小端）：
+ *   'X' 'R' 版本(1) 规则数 { 动作 区域 参数(u16) 代码长度 代码... } × 规则数
+ *
+ * 每条规则是一段无跳转的栈式表达式，执行结束时栈上恰好剩一个值，非 0 为真；
+ * 代码长度有上限且没有跳转，每条规则每个周期的指令数 = 代码长度，评估耗时有上界。
+ * 加载时校验器检查操作码、操作数越界、输入编号和栈深度，运行时不再做这些检查。
+ *
+ * 读到无效输入（传感器缺失 / 时钟未同步）时结果为"未知"，由动作决定安全值：
+ * RUN 视为假（不浇水），INHIBIT 视为真（保持禁止），NOTIFY 视为假。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#ifndef RULE_VM_H
+#define RULE_VM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RULE_VM_VERSION       1
+#define RULE_VM_MAX_RULES     16          ///< 单个程序的规则数上限
+#define RULE_VM_MAX_CODE      64          ///< 单条规则代码长度上限（字节）
+#define RULE_VM_MAX_INPUTS    32          ///< 输入编号 0 ~ 31
+#define RULE_VM_STACK_DEPTH   8           ///< 求值栈深度
+#define RULE_VM_PROGRAM_MAX   512         ///< 程序总长度上限（字节）
+
+/**
+ * @brief 操作码
+ */
+typedef enum {
+    RULE_OP_PUSH8  = 0x01,                ///< + i8   压入常量
+    RULE_OP_PUSH16 = 0x02,                ///< + i16  压入常量
+    RULE_OP_PUSH32 = 0x03,                ///< + i32  压入常量
+    RULE_OP_IN     = 0x04,                ///< + u8   压入输入值
+    RULE_OP_PREV   = 0x05,                ///< 压入本规则上个周期的结果（0 / 1），用于迟滞
+    RULE_OP_SINCE  = 0x06,                ///< 压入本规则结果保持不变的秒数
+
+    RULE_OP_ADD    = 0x10,
+    RULE_OP_SUB    = 0x11,
+    RULE_OP_MUL    = 0x12,
+    RULE_OP_DIV    = 0x13,                ///< 除数为 0 时结果为 0
+    RULE_OP_MIN    = 0x14,
+    RULE_OP_MAX    = 0x15,
+
+    RULE_OP_LT     = 0x20,
+    RULE_OP_LE     = 0x21,
+    RULE_OP_GT     = 0x22,
+    RULE_OP_GE     = 0x23,
+    RULE_OP_EQ     = 0x24,
+    RULE_OP_NE     = 0x25,
+
+    RULE_OP_AND    = 0x30,
+    RULE_OP_OR     = 0x31,
+    RULE_OP_NOT    = 0x32,
+    RULE_OP_SEL    = 0x33,                ///< c a b -> c ? a : b
+} rule_vm_op_t;
+
+/**
+ * @brief 规则动作
+ */
+typedef enum {
+    RULE_ACT_RUN     = 1,                 ///< 为真时要求区域开启，参数 = 单次最长开启秒数
+    RULE_ACT_INHIBIT = 2,                 ///< 为真时禁止区域（联锁 / 雨后暂停 / 日用水量上限）
+    RULE_ACT_NOTIFY  = 3,                 ///< 由假变真时上报事件，参数 = 事件码
+} rule_vm_action_t;
+
+/**
+ * @brief 错误码
+ */
+typedef enum {
+    RULE_VM_OK = 0,
+    RULE_VM_ERR_HEADER,                   ///< 魔数 / 版本 / 长度不对
+    RULE_VM_ERR_TRUNCATED,                ///< 规则或操作数被截断
+    RULE_VM_ERR_ACTION,                   ///< 未知动作
+    RULE_VM_ERR_CODE_LEN,                 ///< 代码为空或过长
+    RULE_VM_ERR_OPCODE,                   ///< 未知操作码
+    RULE_VM_ERR_INPUT,                    ///< 输入编号越界
+    RULE_VM_ERR_STACK,                    ///< 栈下溢 / 上溢，或结束时栈深度不为 1
+    RULE_VM_ERR_TRAILING,                 ///< 规则之后还有多余字节
+} rule_vm_err_t;
+
+/**
+ * @brief 求值结果
+ */
+typedef enum {
+    RULE_VM_FALSE = 0,
+    RULE_VM_TRUE,
+    RULE_VM_UNKNOWN,                      ///< 读到了无效输入
+} rule_vm_result_t;
+
+/**
+ * @brief 单条规则（代码以偏移量引用程序存储区，程序可整体拷贝）
+ */
+typedef struct {
+    uint8_t  action;
+    uint8_t  zone;
+    uint16_t param;
+    uint8_t  code_len;
+    uint16_t code_off;                    ///< 代码在 storage 中的偏移
+} rule_vm_rule_t;
+
+/**
+ * @brief 已校验的程序（自带存储）
+ */
+typedef struct {
+    uint8_t        count;
+    rule_vm_rule_t rules[RULE_VM_MAX_RULES];
+    uint16_t       size;
+    uint8_t        storage[RULE_VM_PROGRAM_MAX];
+} rule_vm_program_t;
+
+/**
+ * @brief 一个周期的输入快照
+ */
+typedef struct {
+    int32_t  value[RULE_VM_MAX_INPUTS];
+    uint32_t valid;                       ///< bit i = value[i] 有效
+} rule_vm_inputs_t;
+
+/**
+ * @brief 规则运行状态（PREV / SINCE 使用）
+ */
+typedef struct {
+    bool     prev;
+    uint32_t since_s;
+} rule_vm_state_t;
+
+/**
+ * @brief 校验并加载程序
+ *
+ * @param prog       输出程序，失败时 count 为 0
+ * @param blob       字节码
+ * @param len        字节码长度
+ * @param err_offset 可为 NULL，失败时输出出错位置（字节偏移）
+ */
+rule_vm_err_t rule_vm_load(rule_vm_program_t *prog, const uint8_t *blob, size_t len, uint16_t *err_offset);
+
+/**
+ * @brief 对已校验程序中的一条规则求值
+ *
+ * @param index 规则下标（< prog->count）
+ * @param ops   可为 NULL，累加执行的指令数
+ */
+rule_vm_result_t rule_vm_eval(const rule_vm_program_t *prog, uint8_t index, const rule_vm_inputs_t *in,
+                              const rule_vm_state_t *state, uint32_t *ops);
+
+/**
+ * @brief 错误码名称
+ */
+const char *rule_vm_err_name(rule_vm_err_t err);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RULE_VM_H */
@@ -0,0 +1,347 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-10 09:41:05
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-10 09:41:05
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_rule_engine\src\rule_engine.c
+ * @Description: 设备端浇花规则引擎实现
+ *
+ * 每个周期：不持锁采样全部输入 -> 持锁求值并汇总区域决策 -> 释放锁后执行回调。
+ * 回调里会调用调度引擎等其他模块，放在锁外可以避免锁顺序问题，也不阻塞 MQTT 线程下发新程序。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+#include "rule_engine.h"
+
+static const char *TAG = "rule_engine";
+
+typedef struct {
+    rule_engine_input_cb_t read;
+    void                  *ctx;
+} rule_input_t;
+
+typedef struct {
+    bool     prev;
+    uint32_t changed_tick;                ///< 结果最近一次变化时的周期号
+} rule_slot_state_t;
+
+typedef struct {
+    bool     run;
+    bool     inhibit;
+    uint16_t max_s;
+} rule_zone_state_t;
+
+static rule_engine_config_t s_cfg;
+static SemaphoreHandle_t    s_mutex;
+static TaskHandle_t         s_task;
+static rule_input_t         s_inputs[RULE_VM_MAX_INPUTS];
+static rule_vm_program_t    s_prog;
+static rule_slot_state_t    s_rule_state[RULE_VM_MAX_RULES];
+static rule_zone_state_t    s_zones[RULE_ENGINE_MAX_ZONES];
+static rule_engine_stats_t  s_stats;
+static uint64_t             s_eval_us_sum;
+
+/* -------------------- NVS -------------------- */
+
+static esp_err_t rule_save(const uint8_t *blob, size_t len)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(RULE_ENGINE_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "nvs_open(write) failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    if (len == 0) {
+        ret = nvs_erase_key(handle, RULE_ENGINE_NVS_KEY);
+        if (ret == ESP_ERR_NVS_NOT_FOUND) {
+            ret = ESP_OK;
+        }
+    } else {
+        ret = nvs_set_blob(handle, RULE_ENGINE_NVS_KEY, blob, len);
+    }
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "save rules failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+static void rule_restore(void)
+{
+    uint8_t *blob = malloc(RULE_VM_PROGRAM_MAX);
+    if (blob == NULL) {
+        return;
+    }
+
+    size_t       len = RULE_VM_PROGRAM_MAX;
+    nvs_handle_t handle;
+    if (nvs_open(RULE_ENGINE_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        esp_err_t ret = nvs_get_blob(handle, RULE_ENGINE_NVS_KEY, blob, &len);
+        nvs_close(handle);
+        if (ret == ESP_OK && len > 0) {
+            rule_vm_err_t err = RULE_VM_OK;
+            if (rule_engine_load(blob, len, false, &err, NULL) != ESP_OK) {
+                ESP_LOGW(TAG, "stored rules rejected: %s", rule_vm_err_name(err));
+            }
+        }
+    }
+    free(blob);
+}
+
+/* -------------------- 规则任务 -------------------- */
+
+typedef struct {
+    uint8_t  zone;
+    rule_zone_state_t state;
+} rule_zone_change_t;
+
+typedef struct {
+    uint8_t  rule;
+    uint16_t code;
+} rule_notify_t;
+
+static void rule_task(void *arg)
+{
+    (void)arg;
+
+    rule_vm_inputs_t   in;
+    rule_zone_change_t changes[RULE_ENGINE_MAX_ZONES];
+    rule_notify_t      notifies[RULE_VM_MAX_RULES];
+    TickType_t         last_wake = xTaskGetTickCount();
+
+    for (;;) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(s_cfg.tick_ms));
+
+        /* 采样：回调可能访问其他模块的锁，不持有本模块的锁 */
+        int64_t t0 = esp_timer_get_time();
+        memset(&in, 0, sizeof(in));
+        for (int i = 0; i < RULE_VM_MAX_INPUTS; i++) {
+            rule_engine_input_cb_t read = s_inputs[i].read;
+            if (read == NULL) {
+                continue;
+            }
+            bool valid = true;
+            in.value[i] = read(s_inputs[i].ctx, &valid);
+            if (valid) {
+                in.valid |= 1u << i;
+            }
+        }
+        int64_t t1 = esp_timer_get_time();
+
+        int change_count = 0;
+        int notify_count = 0;
+
+        xSemaphoreTake(s_mutex, portMAX_DELAY);
+        uint32_t tick = ++s_stats.ticks;
+        uint32_t ops  = 0;
+        rule_zone_state_t want[RULE_ENGINE_MAX_ZONES];
+        memset(want, 0, sizeof(want));
+
+        for (uint8_t i = 0; i < s_prog.count; i++) {
+            const rule_vm_rule_t *r  = &s_prog.rules[i];
+            rule_slot_state_t    *st = &s_rule_state[i];
+            rule_vm_state_t vs = {
+                .prev    = st->prev,
+                .since_s = (uint32_t)((uint64_t)(tick - st->changed_tick) * s_cfg.tick_ms / 1000),
+            };
+
+            rule_vm_result_t res = rule_vm_eval(&s_prog, i, &in, &vs, &ops);
+            bool active;
+            if (res == RULE_VM_UNKNOWN) {
+                s_stats.unknown++;
+                active = (r->action == RULE_ACT_INHIBIT);     ///< 输入无效：不浇水、保持禁止、不上报
+            } else {
+                active = (res == RULE_VM_TRUE);
+            }
+
+            if (active && !st->prev && r->action == RULE_ACT_NOTIFY) {
+                notifies[notify_count].rule = i;
+                notifies[notify_count].code = r->param;
+                notify_count++;
+            }
+            if (active != st->prev) {
+                st->prev         = active;
+                st->changed_tick = tick;
+            }
+
+            if (!active || r->zone >= s_cfg.zone_count) {
+                continue;
+            }
+            if (r->action == RULE_ACT_RUN) {
+                want[r->zone].run = true;
+                if (r->param > want[r->zone].max_s) {
+                    want[r->zone].max_s = r->param;
+                }
+            } else if (r->action == RULE_ACT_INHIBIT) {
+                want[r->zone].inhibit = true;
+            }
+        }
+
+        for (uint8_t z = 0; z < s_cfg.zone_count; z++) {
+            if (want[z].inhibit) {
+                want[z].run   = false;                       ///< 禁止优先于开启
+                want[z].max_s = 0;
+            }
+            if (memcmp(&want[z], &s_zones[z], sizeof(want[z])) != 0) {
+                s_zones[z] = want[z];
+                changes[change_count].zone  = z;
+                changes[change_count].state = want[z];
+                change_count++;
+            }
+        }
+
+        int64_t t2 = esp_timer_get_time();
+        uint32_t eval_us = (uint32_t)(t2 - t1);
+        s_stats.ops_last       = ops;
+        s_stats.sample_us_last = (uint32_t)(t1 - t0);
+        s_stats.eval_us_last   = eval_us;
+        if (eval_us > s_stats.eval_us_max) {
+            s_stats.eval_us_max = eval_us;
+        }
+        s_eval_us_sum      += eval_us;
+        s_stats.eval_us_avg = (uint32_t)(s_eval_us_sum / tick);
+        xSemaphoreGive(s_mutex);
+
+        for (int i = 0; i < change_count; i++) {
+            const rule_zone_change_t *c = &changes[i];
+            ESP_LOGI(TAG, "zone %u: run=%d max=%us inhibit=%d",
+                     (unsigned)c->zone, c->state.run, (unsigned)c->state.max_s, c->state.inhibit);
+            s_cfg.zone_cb(c->zone, c->state.run, c->state.max_s, c->state.inhibit, s_cfg.ctx);
+        }
+        for (int i = 0; i < notify_count; i++) {
+            if (s_cfg.notify_cb != NULL) {
+                s_cfg.notify_cb(notifies[i].rule, notifies[i].code, s_cfg.ctx);
+            }
+        }
+
+        int64_t t3 = esp_timer_get_time();
+
+        xSemaphoreTake(s_mutex, portMAX_DELAY);
+        if (change_count > 0) {
+            uint32_t latency = (uint32_t)(t3 - t0);
+            s_stats.decisions      += (uint32_t)change_count;
+            s_stats.latency_us_last = latency;
+            if (latency > s_stats.latency_us_max) {
+                s_stats.latency_us_max = latency;
+            }
+        }
+        if ((t3 - t0) > (int64_t)s_cfg.tick_ms * 1000) {
+            s_stats.overruns++;
+        }
+        xSemaphoreGive(s_mutex);
+    }
+}
+
+/* -------------------- 对外接口 -------------------- */
+
+esp_err_t rule_engine_init(const rule_engine_config_t *config)
+{
+    if (s_task != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (config == NULL || config->zone_cb == NULL || config->tick_ms == 0 ||
+        config->zone_count == 0 || config->zone_count > RULE_ENGINE_MAX_ZONES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_cfg = *config;
+
+    s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    rule_restore();
+
+    BaseType_t ok = xTaskCreate(rule_task, "rule_engine", s_cfg.task_stack_size,
+                                NULL, s_cfg.task_priority, &s_task);
+    if (ok != pdPASS) {
+        s_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "✅ rule engine started: %u rules, tick %u ms",
+             (unsigned)s_prog.count, (unsigned)s_cfg.tick_ms);
+    return ESP_OK;
+}
+
+esp_err_t rule_engine_register_input(uint8_t id, rule_engine_input_cb_t read, void *ctx)
+{
+    if (id >= RULE_VM_MAX_INPUTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_inputs[id].ctx  = ctx;
+    s_inputs[id].read = read;
+    return ESP_OK;
+}
+
+esp_err_t rule_engine_load(const uint8_t *blob, size_t len, bool persist,
+                           rule_vm_err_t *err, uint16_t *err_off)
+{
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    /* 程序结构约 800 字节，放堆上，避免占用 MQTT 回调线程的栈 */
+    rule_vm_program_t *prog = calloc(1, sizeof(*prog));
+    if (prog == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    rule_vm_err_t e = RULE_VM_OK;
+    if (len > 0) {
+        e = rule_vm_load(prog, blob, len, err_off);
+    }
+    if (err != NULL) {
+        *err = e;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (e != RULE_VM_OK) {
+        s_stats.load_errors++;
+        xSemaphoreGive(s_mutex);
+        free(prog);
+        ESP_LOGW(TAG, "⚠️ rules rejected: %s", rule_vm_err_name(e));
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_prog = *prog;
+    memset(s_rule_state, 0, sizeof(s_rule_state));
+    for (int i = 0; i < RULE_VM_MAX_RULES; i++) {
+        s_rule_state[i].changed_tick = s_stats.ticks;
+    }
+    s_stats.rules        = s_prog.count;
+    s_stats.program_size = s_prog.size;
+    s_stats.loads++;
+    xSemaphoreGive(s_mutex);
+    free(prog);
+
+    ESP_LOGI(TAG, "📜 rules loaded: %u rules, %u bytes", (unsigned)s_prog.count, (unsigned)len);
+
+    return persist ? rule_save(blob, len) : ESP_OK;
+}
+
+esp_err_t rule_engine_get_stats(rule_engine_stats_t *stats)
+{
+    if (stats == NULL || s_mutex == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_mutex);
+    return ESP_OK;
+}
@@ -0,0 +1,259 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-10 09:41:05
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-10 09:41:05
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_rule_engine\src\rule_vm.c
+ * @Description: 浇花规则字节码校验与求值
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <string.h>
+
+#include "rule_vm.h"
+
+#define RULE_HEADER_LEN   4               ///< 'X' 'R' 版本 规则数
+#define RULE_ENTRY_LEN    5               ///< 动作 区域 参数(2) 代码长度
+
+/**
+ * @brief 操作码描述：操作数字节数、出栈数、入栈数；出栈数为 -1 表示未知操作码
+ */
+typedef struct {
+    int8_t operand;
+    int8_t pop;
+    int8_t push;
+} rule_op_info_t;
+
+static rule_op_info_t op_info(uint8_t op)
+{
+    switch (op) {
+    case RULE_OP_PUSH8:  return (rule_op_info_t) { 1, 0, 1 };
+    case RULE_OP_PUSH16: return (rule_op_info_t) { 2, 0, 1 };
+    case RULE_OP_PUSH32: return (rule_op_info_t) { 4, 0, 1 };
+    case RULE_OP_IN:     return (rule_op_info_t) { 1, 0, 1 };
+    case RULE_OP_PREV:
+    case RULE_OP_SINCE:  return (rule_op_info_t) { 0, 0, 1 };
+    case RULE_OP_ADD: case RULE_OP_SUB: case RULE_OP_MUL: case RULE_OP_DIV:
+    case RULE_OP_MIN: case RULE_OP_MAX:
+    case RULE_OP_LT:  case RULE_OP_LE:  case RULE_OP_GT:  case RULE_OP_GE:
+    case RULE_OP_EQ:  case RULE_OP_NE:
+    case RULE_OP_AND: case RULE_OP_OR:
+                         return (rule_op_info_t) { 0, 2, 1 };
+    case RULE_OP_NOT:    return (rule_op_info_t) { 0, 1, 1 };
+    case RULE_OP_SEL:    return (rule_op_info_t) { 0, 3, 1 };
+    default:             return (rule_op_info_t) { 0, -1, 0 };
+    }
+}
+
+/* 校验一条规则的代码，返回出错的代码内偏移 */
+static rule_vm_err_t verify_code(const uint8_t *code, uint8_t len, uint16_t *at)
+{
+    int depth = 0;
+    int pc    = 0;
+
+    while (pc < len) {
+        *at = (uint16_t)pc;
+        rule_op_info_t info = op_info(code[pc]);
+        if (info.pop < 0) {
+            return RULE_VM_ERR_OPCODE;
+        }
+        if (pc + 1 + info.operand > len) {
+            return RULE_VM_ERR_TRUNCATED;
+        }
+        if (code[pc] == RULE_OP_IN && code[pc + 1] >= RULE_VM_MAX_INPUTS) {
+            return RULE_VM_ERR_INPUT;
+        }
+        if (depth < info.pop) {
+            return RULE_VM_ERR_STACK;
+        }
+        depth += info.push - info.pop;
+        if (depth > RULE_VM_STACK_DEPTH) {
+            return RULE_VM_ERR_STACK;
+        }
+        pc += 1 + info.operand;
+    }
+    *at = len;
+    return depth == 1 ? RULE_VM_OK : RULE_VM_ERR_STACK;
+}
+
+rule_vm_err_t rule_vm_load(rule_vm_program_t *prog, const uint8_t *blob, size_t len, uint16_t *err_offset)
+{
+    uint16_t       off = 0;
+    rule_vm_err_t  err = RULE_VM_OK;
+
+    memset(prog, 0, sizeof(*prog));
+
+    if (blob == NULL || len < RULE_HEADER_LEN || len > RULE_VM_PROGRAM_MAX ||
+        blob[0] != 'X' || blob[1] != 'R' || blob[2] != RULE_VM_VERSION ||
+        blob[3] > RULE_VM_MAX_RULES) {
+        err = RULE_VM_ERR_HEADER;
+        goto out;
+    }
+
+    memcpy(prog->storage, blob, len);
+    prog->size = (uint16_t)len;
+
+    uint8_t count = blob[3];
+    off = RULE_HEADER_LEN;
+    for (uint8_t i = 0; i < count; i++) {
+        if ((size_t)off + RULE_ENTRY_LEN > len) {
+            err = RULE_VM_ERR_TRUNCATED;
+            goto out;
+        }
+        const uint8_t *e = &prog->storage[off];
+        rule_vm_rule_t *r = &prog->rules[i];
+        r->action   = e[0];
+        r->zone     = e[1];
+        r->param    = (uint16_t)(e[2] | (e[3] << 8));
+        r->code_len = e[4];
+        r->code_off = (uint16_t)(off + RULE_ENTRY_LEN);
+
+        if (r->action < RULE_ACT_RUN || r->action > RULE_ACT_NOTIFY) {
+            err = RULE_VM_ERR_ACTION;
+            goto out;
+        }
+        if (r->code_len == 0 || r->code_len > RULE_VM_MAX_CODE) {
+            err = RULE_VM_ERR_CODE_LEN;
+            goto out;
+        }
+        off += RULE_ENTRY_LEN;
+        if ((size_t)off + r->code_len > len) {
+            err = RULE_VM_ERR_TRUNCATED;
+            goto out;
+        }
+
+        uint16_t at = 0;
+        err = verify_code(&prog->storage[r->code_off], r->code_len, &at);
+        if (err != RULE_VM_OK) {
+            off += at;
+            goto out;
+        }
+        off += r->code_len;
+    }
+
+    if (off != len) {
+        err = RULE_VM_ERR_TRAILING;
+        goto out;
+    }
+    prog->count = count;
+
+out:
+    if (err != RULE_VM_OK) {
+        memset(prog, 0, sizeof(*prog));
+    }
+    if (err_offset != NULL) {
+        *err_offset = off;
+    }
+    return err;
+}
+
+/* 环绕运算，避免有符号溢出的未定义行为 */
+static int32_t wrap(uint32_t v)
+{
+    return (int32_t)v;
+}
+
+rule_vm_result_t rule_vm_eval(const rule_vm_program_t *prog, uint8_t index, const rule_vm_inputs_t *in,
+                              const rule_vm_state_t *state, uint32_t *ops)
+{
+    const rule_vm_rule_t *rule = &prog->rules[index];
+    int32_t        stack[RULE_VM_STACK_DEPTH];
+    int            sp      = 0;
+    bool           unknown = false;
+    const uint8_t *code    = &prog->storage[rule->code_off];
+    int            len     = rule->code_len;
+    int            pc      = 0;
+    uint32_t       n       = 0;
+
+    while (pc < len) {
+        uint8_t op = code[pc++];
+        n++;
+
+        switch (op) {
+        case RULE_OP_PUSH8:
+            stack[sp++] = (int8_t)code[pc];
+            pc += 1;
+            break;
+        case RULE_OP_PUSH16:
+            stack[sp++] = (int16_t)(code[pc] | (code[pc + 1] << 8));
+            pc += 2;
+            break;
+        case RULE_OP_PUSH32:
+            stack[sp++] = wrap((uint32_t)code[pc] | ((uint32_t)code[pc + 1] << 8) |
+                               ((uint32_t)code[pc + 2] << 16) | ((uint32_t)code[pc + 3] << 24));
+            pc += 4;
+            break;
+        case RULE_OP_IN: {
+            uint8_t id = code[pc++];
+            if ((in->valid & (1u << id)) == 0) {
+                unknown = true;
+            }
+            stack[sp++] = in->value[id];
+            break;
+        }
+        case RULE_OP_PREV:
+            stack[sp++] = state->prev ? 1 : 0;
+            break;
+        case RULE_OP_SINCE:
+            stack[sp++] = state->since_s > INT32_MAX ? INT32_MAX : (int32_t)state->since_s;
+            break;
+        case RULE_OP_NOT:
+            stack[sp - 1] = stack[sp - 1] == 0;
+            break;
+        case RULE_OP_SEL: {
+            int32_t b = stack[--sp];
+            int32_t a = stack[--sp];
+            stack[sp - 1] = stack[sp - 1] != 0 ? a : b;
+            break;
+        }
+        default: {
+            int32_t b = stack[--sp];
+            int32_t a = stack[sp - 1];
+            int32_t r;
+            switch (op) {
+            case RULE_OP_ADD: r = wrap((uint32_t)a + (uint32_t)b); break;
+            case RULE_OP_SUB: r = wrap((uint32_t)a - (uint32_t)b); break;
+            case RULE_OP_MUL: r = wrap((uint32_t)((int64_t)a * b)); break;
+            case RULE_OP_DIV: r = (b == 0 || (a == INT32_MIN && b == -1)) ? 0 : a / b; break;
+            case RULE_OP_MIN: r = a < b ? a : b; break;
+            case RULE_OP_MAX: r = a > b ? a : b; break;
+            case RULE_OP_LT:  r = a <  b; break;
+            case RULE_OP_LE:  r = a <= b; break;
+            case RULE_OP_GT:  r = a >  b; break;
+            case RULE_OP_GE:  r = a >= b; break;
+            case RULE_OP_EQ:  r = a == b; break;
+            case RULE_OP_NE:  r = a != b; break;
+            case RULE_OP_AND: r = a != 0 && b != 0; break;
+            default:          r = a != 0 || b != 0; break;   ///< RULE_OP_OR，其余操作码已被校验器拒绝
+            }
+            stack[sp - 1] = r;
+            break;
+        }
+        }
+    }
+
+    if (ops != NULL) {
+        *ops += n;
+    }
+    if (unknown) {
+        return RULE_VM_UNKNOWN;
+    }
+    return stack[0] != 0 ? RULE_VM_TRUE : RULE_VM_FALSE;
+}
+
+const char *rule_vm_err_name(rule_vm_err_t err)
+{
+    switch (err) {
+    case RULE_VM_OK:            return "ok";
+    case RULE_VM_ERR_HEADER:    return "header";
+    case RULE_VM_ERR_TRUNCATED: return "truncated";
+    case RULE_VM_ERR_ACTION:    return "action";
+    case RULE_VM_ERR_CODE_LEN:  return "code_len";
+    case RULE_VM_ERR_OPCODE:    return "opcode";
+    case RULE_VM_ERR_INPUT:     return "input";
+    case RULE_VM_ERR_STACK:     return "stack";
+    case RULE_VM_ERR_TRAILING:  return "trailing";
+    default:                    return "unknown";
+    }
+}
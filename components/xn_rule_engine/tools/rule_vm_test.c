@@ -0,0 +1,399 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-10 09:41:05
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-10 09:41:05
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_rule_engine\tools\rule_vm_test.c
+ * @Description: 规则字节码主机自检 + 求值基准
+ *
+ * 编译运行（在组件目录下）：
+ *   gcc -O2 -Iinclude src/rule_vm.c tools/rule_vm_test.c -o rule_vm_test
+ *   ./rule_vm_test [随机变异轮数]
+ *
+ * 自检覆盖：校验器拒绝各类非法程序、典型浇花规则（湿度迟滞、雨后暂停、日用水量上限、区域联锁）
+ * 的求值结果、无效输入、算术边界；随机变异合法程序，被接受的程序求值不得越界。
+ * 基准：16 条规则、接近程序长度上限的满载程序每周期求值耗时。
+ *
+ * 与 xn_mqtt_server/lib/RuleCompiler.php 的编码保持一致，s_expect_blob 为编译器对 README 示例的输出。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rule_vm.h"
+
+/* 输入编号，与 main/mqtt_app/rule_app.h 一致 */
+#define IN_SOIL      0
+#define IN_RAIN_AGO  2
+#define IN_ZONE_ON0  8
+#define IN_TODAY_S0  16
+
+static int s_fail;
+
+#define CHECK(cond, ...) do { if (!(cond)) { s_fail++; printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+                                             printf(__VA_ARGS__); printf("\n"); } } while (0)
+
+/* -------------------- 小型汇编器 -------------------- */
+
+typedef struct {
+    uint8_t buf[RULE_VM_PROGRAM_MAX + 64];
+    size_t  len;
+    size_t  rule_start;
+} asm_t;
+
+static void asm_begin(asm_t *a)
+{
+    memset(a, 0, sizeof(*a));
+    a->buf[0] = 'X';
+    a->buf[1] = 'R';
+    a->buf[2] = RULE_VM_VERSION;
+    a->buf[3] = 0;
+    a->len    = 4;
+}
+
+static void asm_rule(asm_t *a, uint8_t action, uint8_t zone, uint16_t param)
+{
+    a->buf[3]++;
+    a->buf[a->len++] = action;
+    a->buf[a->len++] = zone;
+    a->buf[a->len++] = (uint8_t)(param & 0xFF);
+    a->buf[a->len++] = (uint8_t)(param >> 8);
+    a->rule_start    = a->len;
+    a->buf[a->len++] = 0;                              ///< 代码长度，随后续指令更新
+}
+
+static void asm_byte(asm_t *a, uint8_t b)
+{
+    a->buf[a->len++] = b;
+    a->buf[a->rule_start]++;
+}
+
+static void asm_op(asm_t *a, uint8_t op)
+{
+    asm_byte(a, op);
+}
+
+static void asm_in(asm_t *a, uint8_t id)
+{
+    asm_byte(a, RULE_OP_IN);
+    asm_byte(a, id);
+}
+
+static void asm_push(asm_t *a, int32_t v)
+{
+    if (v >= -128 && v <= 127) {
+        asm_byte(a, RULE_OP_PUSH8);
+        asm_byte(a, (uint8_t)v);
+    } else if (v >= -32768 && v <= 32767) {
+        asm_byte(a, RULE_OP_PUSH16);
+        asm_byte(a, (uint8_t)(v & 0xFF));
+        asm_byte(a, (uint8_t)((v >> 8) & 0xFF));
+    } else {
+        asm_byte(a, RULE_OP_PUSH32);
+        for (int i = 0; i < 4; i++) {
+            asm_byte(a, (uint8_t)(((uint32_t)v >> (8 * i)) & 0xFF));
+        }
+    }
+}
+
+/* README 示例程序：
+ *   run zone=0 max=600 when soil < 30 or prev and soil < 40
+ *   inhibit zone=0 when rain_ago < 21600
+ *   inhibit zone=0 when today_s0 >= 900
+ *   inhibit zone=1 when zone_on0
+ */
+static void build_example(asm_t *a)
+{
+    asm_begin(a);
+    asm_rule(a, RULE_ACT_RUN, 0, 600);
+    asm_in(a, IN_SOIL); asm_push(a, 30); asm_op(a, RULE_OP_LT);
+    asm_op(a, RULE_OP_PREV); asm_in(a, IN_SOIL); asm_push(a, 40); asm_op(a, RULE_OP_LT);
+    asm_op(a, RULE_OP_AND); asm_op(a, RULE_OP_OR);
+
+    asm_rule(a, RULE_ACT_INHIBIT, 0, 0);
+    asm_in(a, IN_RAIN_AGO); asm_push(a, 21600); asm_op(a, RULE_OP_LT);
+
+    asm_rule(a, RULE_ACT_INHIBIT, 0, 0);
+    asm_in(a, IN_TODAY_S0); asm_push(a, 900); asm_op(a, RULE_OP_GE);
+
+    asm_rule(a, RULE_ACT_INHIBIT, 1, 0);
+    asm_in(a, IN_ZONE_ON0);
+}
+
+static const uint8_t s_expect_blob[] = {
+    'X', 'R', 0x01, 0x04,
+    0x01, 0x00, 0x58, 0x02, 0x0D,
+    0x04, 0x00, 0x01, 0x1E, 0x20, 0x05, 0x04, 0x00, 0x01, 0x28, 0x20, 0x30, 0x31,
+    0x02, 0x00, 0x00, 0x00, 0x06,
+    0x04, 0x02, 0x02, 0x60, 0x54, 0x20,
+    0x02, 0x00, 0x00, 0x00, 0x06,
+    0x04, 0x10, 0x02, 0x84, 0x03, 0x23,
+    0x02, 0x01, 0x00, 0x00, 0x02,
+    0x04, 0x08,
+};
+
+/* -------------------- 自检 -------------------- */
+
+static rule_vm_result_t eval1(const rule_vm_program_t *p, uint8_t i, rule_vm_inputs_t *in, bool prev)
+{
+    rule_vm_state_t st = { .prev = prev, .since_s = 0 };
+    return rule_vm_eval(p, i, in, &st, NULL);
+}
+
+static void set_in(rule_vm_inputs_t *in, uint8_t id, int32_t v)
+{
+    in->value[id] = v;
+    in->valid    |= 1u << id;
+}
+
+static void test_verifier(void)
+{
+    static rule_vm_program_t p;
+    asm_t a;
+
+    uint8_t bad_magic[] = { 'X', 'Q', 1, 0 };
+    CHECK(rule_vm_load(&p, bad_magic, sizeof(bad_magic), NULL) == RULE_VM_ERR_HEADER, "bad magic");
+
+    uint8_t empty[] = { 'X', 'R', 1, 0 };
+    CHECK(rule_vm_load(&p, empty, sizeof(empty), NULL) == RULE_VM_OK && p.count == 0, "empty program");
+
+    asm_begin(&a);
+    asm_rule(&a, RULE_ACT_RUN, 0, 10);
+    asm_op(&a, RULE_OP_ADD);
+    CHECK(rule_vm_load(&p, a.buf, a.len, NULL) == RULE_VM_ERR_STACK, "stack underflow");
+
+    asm_begin(&a);
+    asm_rule(&a, RULE_ACT_RUN, 0, 10);
+    asm_push(&a, 1); asm_push(&a, 2);
+    CHECK(rule_vm_load(&p, a.buf, a.len, NULL) == RULE_VM_ERR_STACK, "two values left");
+
+    asm_begin(&a);
+    asm_rule(&a, RULE_ACT_RUN, 0, 10);
+    for (int i = 0; i < RULE_VM_STACK_DEPTH + 1; i++) {
+        asm_push(&a, i);
+    }
+    for (int i = 0; i < RULE_VM_STACK_DEPTH; i++) {
+        asm_op(&a, RULE_OP_ADD);
+    }
+    CHECK(rule_vm_load(&p, a.buf, a.len, NULL) == RULE_VM_ERR_STACK, "stack overflow");
+
+    asm_begin(&a);
+    asm_rule(&a, RULE_ACT_RUN, 0, 10);
+    asm_in(&a, RULE_VM_MAX_INPUTS);
+    CHECK(rule_vm_load(&p, a.buf, a.len, NULL) == RULE_VM_ERR_INPUT, "input out of range");
+
+    asm_begin(&a);
+    asm_rule(&a, RULE_ACT_RUN, 0, 10);
+    asm_op(&a, 0x7E);
+    uint16_t at = 0;
+    CHECK(rule_vm_load(&p, a.buf, a.len, &at) == RULE_VM_ERR_OPCODE && at == 9, "bad opcode at %u", at);
+
+    asm_begin(&a);
+    asm_rule(&a, RULE_ACT_RUN, 0, 10);
+    asm_byte(&a, RULE_OP_PUSH16);
+    asm_byte(&a, 0x01);
+    CHECK(rule_vm_load(&p, a.buf, a.len, NULL) == RULE_VM_ERR_TRUNCATED, "truncated operand");
+
+    asm_begin(&a);
+    asm_rule(&a, 9, 0, 10);
+    asm_push(&a, 1);
+    CHECK(rule_vm_load(&p, a.buf, a.len, NULL) == RULE_VM_ERR_ACTION, "bad action");
+
+    asm_begin(&a);
+    asm_rule(&a, RULE_ACT_RUN, 0, 10);
+    CHECK(rule_vm_load(&p, a.buf, a.len, NULL) == RULE_VM_ERR_CODE_LEN, "empty code");
+
+    build_example(&a);
+    a.buf[a.len++] = 0;
+    CHECK(rule_vm_load(&p, a.buf, a.len, NULL) == RULE_VM_ERR_TRAILING, "trailing byte");
+    CHECK(p.count == 0, "rejected program must be empty");
+
+    build_example(&a);
+    a.buf[3] = 5;
+    CHECK(rule_vm_load(&p, a.buf, a.len, NULL) == RULE_VM_ERR_TRUNCATED, "rule count too large");
+}
+
+static void test_example(void)
+{
+    static rule_vm_program_t p;
+    asm_t a;
+    build_example(&a);
+
+    CHECK(a.len == sizeof(s_expect_blob) && memcmp(a.buf, s_expect_blob, a.len) == 0,
+          "assembler output differs from compiler vector");
+    CHECK(rule_vm_load(&p, a.buf, a.len, NULL) == RULE_VM_OK && p.count == 4, "example must load");
+
+    /* 湿度迟滞：低于 30 开始，回到 40 以上才停 */
+    static const int32_t soil[]   = { 45, 35, 29, 33, 38, 41, 35 };
+    static const int     expect[] = { 0,  0,  1,  1,  1,  0,  0 };
+    rule_vm_inputs_t in;
+    memset(&in, 0, sizeof(in));
+    bool prev = false;
+    for (size_t i = 0; i < sizeof(soil) / sizeof(soil[0]); i++) {
+        set_in(&in, IN_SOIL, soil[i]);
+        rule_vm_result_t r = eval1(&p, 0, &in, prev);
+        CHECK((r == RULE_VM_TRUE) == (expect[i] != 0), "hysteresis step %zu soil %d", i, (int)soil[i]);
+        prev = (r == RULE_VM_TRUE);
+    }
+
+    /* 雨后 6 小时内禁止 */
+    set_in(&in, IN_RAIN_AGO, 3600);
+    CHECK(eval1(&p, 1, &in, false) == RULE_VM_TRUE, "rain hold-off active");
+    set_in(&in, IN_RAIN_AGO, 30000);
+    CHECK(eval1(&p, 1, &in, false) == RULE_VM_FALSE, "rain hold-off expired");
+
+    /* 日用水量上限 */
+    set_in(&in, IN_TODAY_S0, 899);
+    CHECK(eval1(&p, 2, &in, false) == RULE_VM_FALSE, "daily limit not reached");
+    set_in(&in, IN_TODAY_S0, 900);
+    CHECK(eval1(&p, 2, &in, false) == RULE_VM_TRUE, "daily limit reached");
+
+    /* 联锁：区域 0 开启时禁止区域 1 */
+    set_in(&in, IN_ZONE_ON0, 1);
+    CHECK(eval1(&p, 3, &in, false) == RULE_VM_TRUE, "interlock");
+
+    /* 传感器缺失：结果未知，由引擎按动作取安全值 */
+    in.valid &= ~(1u << IN_SOIL);
+    CHECK(eval1(&p, 0, &in, false) == RULE_VM_UNKNOWN, "missing input must be unknown");
+}
+
+static void test_arith(void)
+{
+    static rule_vm_program_t p;
+    asm_t a;
+    rule_vm_inputs_t in;
+    memset(&in, 0, sizeof(in));
+
+    asm_begin(&a);
+    asm_rule(&a, RULE_ACT_NOTIFY, 0, 1);                /* 7 / 0 == 0 */
+    asm_push(&a, 7); asm_push(&a, 0); asm_op(&a, RULE_OP_DIV); asm_push(&a, 0); asm_op(&a, RULE_OP_EQ);
+    asm_rule(&a, RULE_ACT_NOTIFY, 0, 2);                /* INT32_MIN / -1 == 0 */
+    asm_push(&a, INT32_MIN); asm_push(&a, -1); asm_op(&a, RULE_OP_DIV); asm_op(&a, RULE_OP_NOT);
+    asm_rule(&a, RULE_ACT_NOTIFY, 0, 3);                /* INT32_MAX + 1 环绕为负 */
+    asm_push(&a, INT32_MAX); asm_push(&a, 1); asm_op(&a, RULE_OP_ADD); asm_push(&a, 0); asm_op(&a, RULE_OP_LT);
+    asm_rule(&a, RULE_ACT_NOTIFY, 0, 4);                /* SEL / MIN / MAX */
+    asm_push(&a, 1); asm_push(&a, 300); asm_push(&a, -5); asm_op(&a, RULE_OP_SEL);
+    asm_push(&a, 100); asm_op(&a, RULE_OP_MIN); asm_push(&a, 100); asm_op(&a, RULE_OP_EQ);
+    asm_rule(&a, RULE_ACT_NOTIFY, 0, 5);                /* SINCE >= 600 */
+    asm_op(&a, RULE_OP_SINCE); asm_push(&a, 600); asm_op(&a, RULE_OP_GE);
+
+    CHECK(rule_vm_load(&p, a.buf, a.len, NULL) == RULE_VM_OK, "arith program must load");
+    for (uint8_t i = 0; i < 4; i++) {
+        CHECK(eval1(&p, i, &in, false) == RULE_VM_TRUE, "arith rule %u", (unsigned)i);
+    }
+    rule_vm_state_t st = { .prev = false, .since_s = 599 };
+    CHECK(rule_vm_eval(&p, 4, &in, &st, NULL) == RULE_VM_FALSE, "since 599");
+    st.since_s = 600;
+    CHECK(rule_vm_eval(&p, 4, &in, &st, NULL) == RULE_VM_TRUE, "since 600");
+}
+
+static unsigned s_rng = 2025;
+
+static unsigned test_rand(void)
+{
+    s_rng = s_rng * 1103515245u + 12345u;
+    return (s_rng >> 16) & 0x7FFF;
+}
+
+/* 随机变异：被校验器接受的程序求值必须不越界（配合 -fsanitize=address,undefined 编译效果更好） */
+static long test_mutation(int rounds)
+{
+    static rule_vm_program_t p;
+    asm_t a;
+    rule_vm_inputs_t in;
+    memset(&in, 0xA5, sizeof(in));
+    long accepted = 0;
+
+    for (int r = 0; r < rounds; r++) {
+        build_example(&a);
+        int flips = 1 + (int)(test_rand() % 4);
+        for (int f = 0; f < flips; f++) {
+            a.buf[test_rand() % a.len] = (uint8_t)test_rand();
+        }
+        if (test_rand() % 8 == 0) {
+            a.len -= test_rand() % 8;
+        }
+        if (rule_vm_load(&p, a.buf, a.len, NULL) != RULE_VM_OK) {
+            continue;
+        }
+        accepted++;
+        for (uint8_t i = 0; i < p.count; i++) {
+            rule_vm_state_t st = { .prev = true, .since_s = 12 };
+            (void)rule_vm_eval(&p, i, &in, &st, NULL);
+        }
+    }
+    return accepted;
+}
+
+/* -------------------- 基准 -------------------- */
+
+static void bench(void)
+{
+    static rule_vm_program_t p;
+    asm_t a;
+    asm_begin(&a);
+
+    /* 16 条规则，每条：IN a; PUSH b; LT; 再接两组 (PREV; IN c; PUSH d; LT; AND; OR)，总长接近程序上限 */
+    for (int r = 0; r < 16; r++) {
+        asm_rule(&a, RULE_ACT_RUN, (uint8_t)(r % 8), 60);
+        asm_in(&a, (uint8_t)(r % RULE_VM_MAX_INPUTS));
+        asm_push(&a, 30);
+        asm_op(&a, RULE_OP_LT);
+        while (a.buf[a.rule_start] + 8 <= 26) {
+            asm_op(&a, RULE_OP_PREV);
+            asm_in(&a, (uint8_t)((r + 3) % RULE_VM_MAX_INPUTS));
+            asm_push(&a, 40);
+            asm_op(&a, RULE_OP_LT);
+            asm_op(&a, RULE_OP_AND);
+            asm_op(&a, RULE_OP_OR);
+        }
+    }
+    if (rule_vm_load(&p, a.buf, a.len, NULL) != RULE_VM_OK) {
+        printf("FAIL: bench program rejected\n");
+        s_fail++;
+        return;
+    }
+
+    rule_vm_inputs_t in;
+    memset(&in, 0, sizeof(in));
+    in.valid = 0xFFFFFFFFu;
+
+    const int ticks = 200000;
+    uint32_t  ops   = 0;
+    uint32_t  trues = 0;
+    clock_t   c0    = clock();
+    for (int t = 0; t < ticks; t++) {
+        for (int i = 0; i < RULE_VM_MAX_INPUTS; i++) {
+            in.value[i] = (int32_t)((t * 7 + i * 13) % 60);
+        }
+        for (uint8_t i = 0; i < p.count; i++) {
+            rule_vm_state_t st = { .prev = (trues & 1) != 0, .since_s = 0 };
+            trues += rule_vm_eval(&p, i, &in, &st, &ops) == RULE_VM_TRUE;
+        }
+    }
+    double sec = (double)(clock() - c0) / CLOCKS_PER_SEC;
+
+    printf("program: %u rules, %u bytes, %.1f ops/tick\n",
+           (unsigned)p.count, (unsigned)p.size, (double)ops / ticks);
+    printf("eval   : %.0f ns/tick, %.1f ns/op (host)\n", sec * 1e9 / ticks, sec * 1e9 / ops);
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 200000;
+
+    test_verifier();
+    test_example();
+    test_arith();
+    long accepted = test_mutation(rounds);
+    printf("mutation: %d rounds, %ld accepted and evaluated\n", rounds, accepted);
+
+    bench();
+
+    printf("%s (%d failures)\n", s_fail ? "FAILED" : "all checks passed", s_fail);
+    return s_fail ? 1 : 0;
+}
@@ -0,0 +1,150 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-08 09:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-08 09:12:40
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_telemetry\include\telemetry.h
+ * @Description: 批量紧凑遥测通道（类型化指标注册 + 定时采样 + CBOR 批量 + 相对已确认快照的增量编码）
+ *
+ * 设计要点：
+ *  - 各模块注册计数器 / 量值 / 枚举三类 int32 指标，可用读取回调拉取，也可用 telemetry_set / telemetry_add 推送；
+ *  - 遥测任务每个周期采样一次，所有指标合成一条 CBOR 消息发布到
+ *    WEB_MQTT_UPLINK_BASE_TOPIC "/telemetry/<device_id>"；
+ *  - 只发送相对"服务器最近确认的快照"发生变化的指标：计数器 / 量值发差值，枚举发绝对值；
+ *  - 带确认请求的批次由服务器回 base_topic "/telemetry/<device_id>/ack"，负载为批次序号，
+ *    确认后该批成为新基准；服务器缺少基准时回 "resync"，设备改发全量快照（含指标名称表）直到被确认；
+ *  - 统计实际上行字节 / 小时，并与同样信息按旧版"每 Topic 一条 JSON"上报的估算值对比。
+ *
+ * 批次格式（CBOR 映射，整数键）：
+ *   { 0: seq, 1: base_seq(0 = 全量), 2: { id: value | delta, ... }, 3: { id: [name, type], ... }(仅全量),
+ *     4: 1(请求确认，可选) }
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TELEMETRY_MAX_METRICS     32          ///< 可注册指标上限
+#define TELEMETRY_NAME_MAX        16          ///< 指标名最大长度（含结束符）
+#define TELEMETRY_HISTORY         4           ///< 等待确认的已发送快照数
+#define TELEMETRY_ACK_EVERY       8           ///< 增量批次每隔多少批请求一次确认
+#define TELEMETRY_BATCH_MAX       1024        ///< 单批 CBOR 最大字节数（全量快照含名称表）
+
+/**
+ * @brief 指标类型
+ */
+typedef enum {
+    TELEMETRY_COUNTER = 0,                    ///< 单调递增计数，增量编码
+    TELEMETRY_GAUGE,                          ///< 瞬时量值（堆余量、RSSI 等），增量编码
+    TELEMETRY_ENUM,                           ///< 离散状态（开关、模式），变化时发绝对值
+} telemetry_type_t;
+
+/**
+ * @brief 指标读取回调（在遥测任务中调用，须快速返回）
+ */
+typedef int32_t (*telemetry_read_cb_t)(void *ctx);
+
+/**
+ * @brief 指标描述
+ */
+typedef struct {
+    const char          *name;                ///< 指标名（服务器侧字段名），长度 < TELEMETRY_NAME_MAX
+    telemetry_type_t     type;                ///< 指标类型
+    telemetry_read_cb_t  read;                ///< 读取回调，NULL 表示由 telemetry_set / telemetry_add 推送
+    void                *ctx;                 ///< 回调上下文
+    const char          *legacy_topic;        ///< 旧版承载该指标的 JSON Topic 子路径（如 "watering/status"），
+                                              ///< 仅用于字节对比估算；NULL 时按每指标一条 Topic 估算
+} telemetry_metric_t;
+
+/**
+ * @brief 遥测任务配置
+ */
+typedef struct {
+    uint32_t    interval_ms;                  ///< 采样 / 发布周期
+    uint32_t    report_ms;                    ///< 字节统计日志输出周期，0 不输出
+    uint32_t    task_stack_size;              ///< 任务栈大小（字节）
+    UBaseType_t task_priority;                ///< 任务优先级
+} telemetry_config_t;
+
+#define TELEMETRY_DEFAULT_CONFIG()                     \
+    (telemetry_config_t) {                             \
+        .interval_ms     = 60 * 1000,                  \
+        .report_ms       = 60 * 60 * 1000,             \
+        .task_stack_size = 4096,                       \
+        .task_priority   = tskIDLE_PRIORITY + 1,       \
+    }
+
+/**
+ * @brief 遥测统计
+ */
+typedef struct {
+    uint32_t batches;                         ///< 已发布批次数
+    uint32_t full_batches;                    ///< 其中全量快照批次数
+    uint32_t skipped;                         ///< 无变化跳过的周期数
+    uint32_t acks;                            ///< 收到的有效确认数
+    uint32_t resyncs;                         ///< 服务器要求的重同步次数
+    uint32_t publish_failed;                  ///< 入发件箱失败次数
+    uint64_t bytes;                           ///< 遥测实际上下行字节（含 MQTT 报文头与确认）
+    uint64_t legacy_bytes;                    ///< 同样信息按旧版每 Topic JSON（QoS1）上报的估算字节
+    uint32_t bytes_per_hour;                  ///< 遥测字节 / 小时
+    uint32_t legacy_bytes_per_hour;           ///< 旧版估算字节 / 小时
+} telemetry_stats_t;
+
+/**
+ * @brief 注册一个指标（可在 telemetry_start 前后调用）
+ *
+ * 启动后再注册的指标会触发一次全量快照，让服务器拿到新的名称表。
+ *
+ * @param metric 指标描述（内容被拷贝，name / legacy_topic 须为静态字符串）
+ * @param out_id 输出指标 ID（1 起），可为 NULL
+ *
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 参数非法, ESP_ERR_NO_MEM 超过 TELEMETRY_MAX_METRICS
+ */
+esp_err_t telemetry_register(const telemetry_metric_t *metric, uint8_t *out_id);
+
+/**
+ * @brief 设置推送型指标的当前值（任意任务可调用）
+ */
+esp_err_t telemetry_set(uint8_t id, int32_t value);
+
+/**
+ * @brief 推送型计数器累加
+ */
+esp_err_t telemetry_add(uint8_t id, int32_t delta);
+
+/**
+ * @brief 启动遥测任务并注册确认 Topic（须在 web_mqtt_manager_init 之后调用，重复调用直接返回 ESP_OK）
+ *
+ * @param config 配置，NULL 使用 TELEMETRY_DEFAULT_CONFIG()
+ *
+ * @return ESP_OK 成功, ESP_ERR_NO_MEM 任务创建失败，其他值见 web_mqtt_manager_register_app
+ */
+esp_err_t telemetry_start(const telemetry_config_t *config);
+
+/**
+ * @brief 请求下一批发送全量快照
+ */
+void telemetry_request_resync(void);
+
+/**
+ * @brief 获取遥测统计
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 参数为空
+ */
+esp_err_t telemetry_get_stats(telemetry_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TELEMETRY_H */
@@ -0,0 +1,66 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-08 09:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-08 09:12:40
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_telemetry\include\telemetry_cbor.h
+ * @Description: 最小 CBOR 编码器（RFC 8949 子集：整数、文本、数组、映射），只写定长容器
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** CBOR 写入器，缓冲区不足时置 overflow，后续写入全部忽略 */
+typedef struct {
+    uint8_t *buf;               ///< 输出缓冲
+    size_t   cap;               ///< 缓冲容量
+    size_t   len;               ///< 已写字节数
+    bool     overflow;          ///< 是否溢出
+} telemetry_cbor_t;
+
+/**
+ * @brief 初始化写入器
+ */
+void telemetry_cbor_init(telemetry_cbor_t *w, uint8_t *buf, size_t cap);
+
+/**
+ * @brief 写无符号整数（主类型 0）
+ */
+void telemetry_cbor_uint(telemetry_cbor_t *w, uint64_t value);
+
+/**
+ * @brief 写有符号整数（负数用主类型 1）
+ */
+void telemetry_cbor_int(telemetry_cbor_t *w, int64_t value);
+
+/**
+ * @brief 写 UTF-8 文本（主类型 3）
+ */
+void telemetry_cbor_text(telemetry_cbor_t *w, const char *text);
+
+/**
+ * @brief 写定长数组头（主类型 4），随后写 count 个元素
+ */
+void telemetry_cbor_array(telemetry_cbor_t *w, size_t count);
+
+/**
+ * @brief 写定长映射头（主类型 5），随后写 count 对键值
+ */
+void telemetry_cbor_map(telemetry_cbor_t *w, size_t count);
+
+/**
+ * @brief 计算整数编码后的字节数（用于估算，不写入）
+ */
+size_t telemetry_cbor_int_size(int64_t value);
+
+#ifdef __cplusplus
+}
+#endif
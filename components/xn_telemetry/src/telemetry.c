@@ -0,0 +1,491 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-08 09:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-08 09:12:40
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_telemetry\src\telemetry.c
+ * @Description: 批量紧凑遥测通道实现
+ *
+ * 增量基准：
+ *  - 每个已发布批次的绝对值快照保存在 TELEMETRY_HISTORY 个历史槽中；
+ *  - 收到某批次的确认后，该批次快照成为新的基准（acked），之后的批次只发相对它的变化；
+ *  - 基准序号为 0（刚启动 / 服务器要求重同步 / 新注册了指标）时发全量快照，直到被确认；
+ *  - 确认报文与增量批次大小相当，只在全量批次和每 TELEMETRY_ACK_EVERY 批请求一次确认，
+ *    基准推进稍慢只让差值多占一两个字节；
+ *  - 批次以 QoS0 + 合并键交给发件箱，离线期间只保留最新一批；任何一批都只依赖已确认的基准，
+ *    丢批不影响后续解码。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "mqtt_app_module.h"
+#include "mqtt_outbox.h"
+#include "web_mqtt_manager.h"
+#include "telemetry_cbor.h"
+#include "telemetry.h"
+
+static const char *TAG = "telemetry";
+
+#define TELEMETRY_TOPIC_SUFFIX    "telemetry"           ///< 上行 / 下行 Topic 模块前缀
+#define TELEMETRY_COALESCE_KEY    "telemetry"           ///< 发件箱合并键
+
+/* 批次映射键 */
+#define TELEMETRY_KEY_SEQ         0
+#define TELEMETRY_KEY_BASE        1
+#define TELEMETRY_KEY_VALUES      2
+#define TELEMETRY_KEY_SCHEMA      3
+#define TELEMETRY_KEY_ACK_REQ     4
+
+typedef struct {
+    telemetry_metric_t desc;                   ///< 注册描述
+    int32_t            pushed;                 ///< 推送型指标的当前值
+} telemetry_slot_t;
+
+typedef struct {
+    uint32_t seq;                              ///< 批次序号，0 表示空槽
+    uint8_t  count;                            ///< 快照包含的指标数
+    int32_t  values[TELEMETRY_MAX_METRICS];    ///< 绝对值快照
+} telemetry_snapshot_t;
+
+static portMUX_TYPE          s_lock = portMUX_INITIALIZER_UNLOCKED;
+static telemetry_slot_t      s_slots[TELEMETRY_MAX_METRICS];
+static uint8_t               s_count;
+static telemetry_snapshot_t  s_history[TELEMETRY_HISTORY];
+static telemetry_snapshot_t  s_acked;          ///< 已确认基准，seq 为 0 表示尚无基准
+static uint32_t              s_seq;
+static TaskHandle_t          s_task;
+static telemetry_config_t    s_cfg;
+static telemetry_stats_t     s_stats;
+static int64_t               s_start_us;
+
+/* 旧版估算用：上一次采样值 */
+static int32_t               s_prev[TELEMETRY_MAX_METRICS];
+static uint8_t               s_prev_count;
+
+/**
+ * @brief MQTT PUBLISH 报文字节数（固定头 + 剩余长度 + Topic + 报文 ID + 负载），QoS1 另计 PUBACK 4 字节
+ */
+static size_t telemetry_mqtt_bytes(size_t topic_len, size_t payload_len, int qos)
+{
+    size_t remaining = 2 + topic_len + payload_len + (qos > 0 ? 2 : 0);
+    size_t len_bytes = remaining < 128 ? 1 : (remaining < 16384 ? 2 : 3);
+    return 1 + len_bytes + remaining + (qos > 0 ? 4 : 0);
+}
+
+static size_t telemetry_dec_len(int32_t value)
+{
+    char buf[12];
+    return (size_t)snprintf(buf, sizeof(buf), "%ld", (long)value);
+}
+
+/**
+ * @brief 估算旧版上报同样变化所需的字节数
+ *
+ * 旧版每个业务 Topic 在内容变化时发一条 QoS1 JSON，JSON 含该 Topic 下的全部字段：
+ * 变化指标按 legacy_topic 归组，每组计一条消息；未指定 legacy_topic 的指标各自一条。
+ */
+static size_t telemetry_legacy_estimate(const int32_t *cur, uint8_t count, size_t cid_len)
+{
+    bool   changed[TELEMETRY_MAX_METRICS] = { false };
+    bool   counted[TELEMETRY_MAX_METRICS] = { false };
+    size_t total = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        changed[i] = (i >= s_prev_count) || (cur[i] != s_prev[i]);
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (!changed[i] || counted[i]) {
+            continue;
+        }
+
+        const char *group = s_slots[i].desc.legacy_topic;
+        size_t      topic_len;
+        size_t      json_len = 2;                          ///< "{}"
+        uint8_t     fields   = 0;
+
+        if (group == NULL) {
+            topic_len = strlen(WEB_MQTT_UPLINK_BASE_TOPIC) + 1 + strlen(s_slots[i].desc.name) + 1 + cid_len;
+            json_len += strlen(s_slots[i].desc.name) + 3 + telemetry_dec_len(cur[i]);
+            fields = 1;
+            counted[i] = true;
+        } else {
+            topic_len = strlen(WEB_MQTT_UPLINK_BASE_TOPIC) + 1 + strlen(group) + 1 + cid_len;
+            for (uint8_t j = i; j < count; j++) {
+                const char *g = s_slots[j].desc.legacy_topic;
+                if (g == NULL || strcmp(g, group) != 0) {
+                    continue;
+                }
+                json_len += strlen(s_slots[j].desc.name) + 3 + telemetry_dec_len(cur[j]); ///< "name":v
+                fields++;
+                counted[j] = true;
+            }
+        }
+        json_len += fields > 1 ? fields - 1 : 0;               ///< 字段间逗号
+        total += telemetry_mqtt_bytes(topic_len, json_len, 1);
+    }
+
+    memcpy(s_prev, cur, sizeof(int32_t) * count);
+    s_prev_count = count;
+    return total;
+}
+
+/**
+ * @brief 编码一批：full 时写全量值与名称表，否则只写相对基准变化的指标
+ *
+ * @return CBOR 字节数，0 表示无变化，负数表示缓冲区不足
+ */
+static int telemetry_encode(uint8_t *buf, size_t cap, uint32_t seq, bool full, bool ack_req,
+                            const int32_t *cur, uint8_t count, const telemetry_snapshot_t *base)
+{
+    uint8_t changed = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (full || i >= base->count || cur[i] != base->values[i]) {
+            changed++;
+        }
+    }
+    if (changed == 0) {
+        return 0;
+    }
+
+    telemetry_cbor_t w;
+    telemetry_cbor_init(&w, buf, cap);
+
+    telemetry_cbor_map(&w, (full ? 4 : 3) + (ack_req ? 1 : 0));
+    telemetry_cbor_uint(&w, TELEMETRY_KEY_SEQ);
+    telemetry_cbor_uint(&w, seq);
+    telemetry_cbor_uint(&w, TELEMETRY_KEY_BASE);
+    telemetry_cbor_uint(&w, full ? 0 : base->seq);
+
+    telemetry_cbor_uint(&w, TELEMETRY_KEY_VALUES);
+    telemetry_cbor_map(&w, changed);
+    for (uint8_t i = 0; i < count; i++) {
+        bool is_new = full || i >= base->count;
+        if (!is_new && cur[i] == base->values[i]) {
+            continue;
+        }
+        telemetry_cbor_uint(&w, (uint64_t)i + 1);
+        if (is_new || s_slots[i].desc.type == TELEMETRY_ENUM) {
+            telemetry_cbor_int(&w, cur[i]);
+        } else {
+            telemetry_cbor_int(&w, (int64_t)cur[i] - (int64_t)base->values[i]);
+        }
+    }
+
+    if (full) {
+        telemetry_cbor_uint(&w, TELEMETRY_KEY_SCHEMA);
+        telemetry_cbor_map(&w, count);
+        for (uint8_t i = 0; i < count; i++) {
+            telemetry_cbor_uint(&w, (uint64_t)i + 1);
+            telemetry_cbor_array(&w, 2);
+            telemetry_cbor_text(&w, s_slots[i].desc.name);
+            telemetry_cbor_uint(&w, s_slots[i].desc.type);
+        }
+    }
+
+    if (ack_req) {
+        telemetry_cbor_uint(&w, TELEMETRY_KEY_ACK_REQ);
+        telemetry_cbor_uint(&w, 1);
+    }
+
+    return w.overflow ? -1 : (int)w.len;
+}
+
+/**
+ * @brief 采样全部指标并发布一批
+ */
+static void telemetry_sample_and_publish(void)
+{
+    static uint8_t              s_buf[TELEMETRY_BATCH_MAX];  ///< 仅遥测任务使用，放静态区省栈
+    static telemetry_snapshot_t s_base;
+    int32_t                     cur[TELEMETRY_MAX_METRICS];
+
+    const char *client_id = web_mqtt_manager_get_client_id();
+    if (client_id == NULL || client_id[0] == '\0') {
+        return;
+    }
+
+    /* 注册表只追加，先取数量再在锁外调用读取回调 */
+    portENTER_CRITICAL(&s_lock);
+    uint8_t count = s_count;
+    portEXIT_CRITICAL(&s_lock);
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (s_slots[i].desc.read != NULL) {
+            cur[i] = s_slots[i].desc.read(s_slots[i].desc.ctx);
+        } else {
+            portENTER_CRITICAL(&s_lock);
+            cur[i] = s_slots[i].pushed;
+            portEXIT_CRITICAL(&s_lock);
+        }
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_base = s_acked;
+    portEXIT_CRITICAL(&s_lock);
+
+    size_t cid_len = strlen(client_id);
+    size_t legacy  = telemetry_legacy_estimate(cur, count, cid_len);
+    bool   full    = (s_base.seq == 0);
+    uint32_t seq   = s_seq + 1;
+    bool   ack_req = full || (seq % TELEMETRY_ACK_EVERY) == 0;
+
+    int len = telemetry_encode(s_buf, sizeof(s_buf), seq, full, ack_req, cur, count, &s_base);
+    if (len < 0) {
+        ESP_LOGE(TAG, "❌ batch exceeds %d bytes, %u metrics", TELEMETRY_BATCH_MAX, (unsigned)count);
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.legacy_bytes += legacy;
+    if (len == 0) {
+        s_stats.skipped++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    if (len == 0) {
+        return;
+    }
+
+    char topic[128];
+    int  n = snprintf(topic, sizeof(topic), "%s/%s/%s",
+                      WEB_MQTT_UPLINK_BASE_TOPIC, TELEMETRY_TOPIC_SUFFIX, client_id);
+    if (n <= 0 || n >= (int)sizeof(topic)) {
+        return;
+    }
+
+    esp_err_t ret = mqtt_outbox_publish(topic, s_buf, len, 0, false,
+                                        MQTT_OUTBOX_PRIO_LOW, TELEMETRY_COALESCE_KEY);
+
+    portENTER_CRITICAL(&s_lock);
+    if (ret == ESP_OK) {
+        s_seq = seq;
+        telemetry_snapshot_t *h = &s_history[seq % TELEMETRY_HISTORY];
+        h->seq   = seq;
+        h->count = count;
+        memcpy(h->values, cur, sizeof(int32_t) * count);
+
+        s_stats.batches++;
+        if (full) {
+            s_stats.full_batches++;
+        }
+        s_stats.bytes += telemetry_mqtt_bytes((size_t)n, (size_t)len, 0);
+    } else {
+        s_stats.publish_failed++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGD(TAG, "batch seq=%lu base=%lu %d bytes (legacy %u)",
+             (unsigned long)seq, (unsigned long)s_base.seq, len, (unsigned)legacy);
+}
+
+/**
+ * @brief 确认 / 重同步消息：base_topic/telemetry/<device_id>/ack
+ */
+static esp_err_t telemetry_on_message(const char    *topic,
+                                      int            topic_len,
+                                      const uint8_t *payload,
+                                      int            payload_len)
+{
+    const char *client_id = web_mqtt_manager_get_client_id();
+    if (client_id == NULL || payload == NULL || payload_len <= 0) {
+        return ESP_OK;
+    }
+
+    char expect[96];
+    int  n = snprintf(expect, sizeof(expect), "/%s/ack", client_id);
+    if (n <= 0 || n >= (int)sizeof(expect) || topic_len < n ||
+        memcmp(topic + topic_len - n, expect, (size_t)n) != 0) {
+        return ESP_OK;
+    }
+
+    char buf[16];
+    if (payload_len >= (int)sizeof(buf)) {
+        return ESP_OK;
+    }
+    memcpy(buf, payload, (size_t)payload_len);
+    buf[payload_len] = '\0';
+
+    size_t ack_bytes = telemetry_mqtt_bytes((size_t)topic_len, (size_t)payload_len, 0);
+
+    if (strcmp(buf, "resync") == 0) {
+        portENTER_CRITICAL(&s_lock);
+        s_acked.seq = 0;
+        s_stats.resyncs++;
+        s_stats.bytes += ack_bytes;
+        portEXIT_CRITICAL(&s_lock);
+        ESP_LOGW(TAG, "⚠️ server requested resync");
+        return ESP_OK;
+    }
+
+    uint32_t seq = (uint32_t)strtoul(buf, NULL, 10);
+    if (seq == 0) {
+        return ESP_OK;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_stats.bytes += ack_bytes;
+    const telemetry_snapshot_t *h = &s_history[seq % TELEMETRY_HISTORY];
+    if (h->seq == seq && seq > s_acked.seq) {
+        s_acked = *h;
+        s_stats.acks++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+static void telemetry_report(void)
+{
+    telemetry_stats_t st;
+    telemetry_get_stats(&st);
+
+    ESP_LOGI(TAG, "📊 %lu batches (%lu full, %lu skipped), %lu acks: %lu B/h vs per-topic JSON %lu B/h",
+             (unsigned long)st.batches, (unsigned long)st.full_batches, (unsigned long)st.skipped,
+             (unsigned long)st.acks, (unsigned long)st.bytes_per_hour,
+             (unsigned long)st.legacy_bytes_per_hour);
+}
+
+static void telemetry_task(void *arg)
+{
+    (void)arg;
+
+    int64_t last_report_us = esp_timer_get_time();
+
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(s_cfg.interval_ms));
+
+        telemetry_sample_and_publish();
+
+        int64_t now_us = esp_timer_get_time();
+        if (s_cfg.report_ms > 0 && now_us - last_report_us >= (int64_t)s_cfg.report_ms * 1000) {
+            last_report_us = now_us;
+            telemetry_report();
+        }
+    }
+}
+
+esp_err_t telemetry_register(const telemetry_metric_t *metric, uint8_t *out_id)
+{
+    if (metric == NULL || metric->name == NULL || metric->name[0] == '\0' ||
+        strlen(metric->name) >= TELEMETRY_NAME_MAX || metric->type > TELEMETRY_ENUM) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_count >= TELEMETRY_MAX_METRICS) {
+        portEXIT_CRITICAL(&s_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    uint8_t idx = s_count;
+    s_slots[idx].desc   = *metric;
+    s_slots[idx].pushed = 0;
+    s_count++;
+    s_acked.seq = 0;                                   ///< 名称表变化，下一批发全量
+    portEXIT_CRITICAL(&s_lock);
+
+    if (out_id != NULL) {
+        *out_id = (uint8_t)(idx + 1);
+    }
+    ESP_LOGI(TAG, "register metric #%u %s", (unsigned)(idx + 1), metric->name);
+    return ESP_OK;
+}
+
+esp_err_t telemetry_set(uint8_t id, int32_t value)
+{
+    esp_err_t ret = ESP_ERR_INVALID_ARG;
+
+    portENTER_CRITICAL(&s_lock);
+    if (id >= 1 && id <= s_count) {
+        s_slots[id - 1].pushed = value;
+        ret = ESP_OK;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return ret;
+}
+
+esp_err_t telemetry_add(uint8_t id, int32_t delta)
+{
+    esp_err_t ret = ESP_ERR_INVALID_ARG;
+
+    portENTER_CRITICAL(&s_lock);
+    if (id >= 1 && id <= s_count) {
+        s_slots[id - 1].pushed += delta;
+        ret = ESP_OK;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return ret;
+}
+
+esp_err_t telemetry_start(const telemetry_config_t *config)
+{
+    if (s_task != NULL) {
+        return ESP_OK;
+    }
+
+    s_cfg = config ? *config : TELEMETRY_DEFAULT_CONFIG();
+    if (s_cfg.interval_ms == 0) {
+        s_cfg.interval_ms = TELEMETRY_DEFAULT_CONFIG().interval_ms;
+    }
+
+    /* 确认消息只做几次比较和拷贝，直接在 MQTT 事件任务中处理 */
+    esp_err_t ret = web_mqtt_manager_register_app(TELEMETRY_TOPIC_SUFFIX, telemetry_on_message);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "register ack topic failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    s_start_us = esp_timer_get_time();
+
+    BaseType_t ok = xTaskCreate(telemetry_task,
+                                "telemetry",
+                                s_cfg.task_stack_size,
+                                NULL,
+                                s_cfg.task_priority,
+                                &s_task);
+    if (ok != pdPASS) {
+        s_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "✅ telemetry started, %u metrics, interval %lu ms",
+             (unsigned)s_count, (unsigned long)s_cfg.interval_ms);
+    return ESP_OK;
+}
+
+void telemetry_request_resync(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_acked.seq = 0;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t telemetry_get_stats(telemetry_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+
+    int64_t elapsed_us = s_task != NULL ? esp_timer_get_time() - s_start_us : 0;
+    if (elapsed_us > 0) {
+        stats->bytes_per_hour        = (uint32_t)(stats->bytes * 3600000000ULL / (uint64_t)elapsed_us);
+        stats->legacy_bytes_per_hour = (uint32_t)(stats->legacy_bytes * 3600000000ULL / (uint64_t)elapsed_us);
+    } else {
+        stats->bytes_per_hour        = 0;
+        stats->legacy_bytes_per_hour = 0;
+    }
+    return ESP_OK;
+}
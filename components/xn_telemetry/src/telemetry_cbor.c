@@ -0,0 +1,118 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-08 09:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-08 09:12:40
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_telemetry\src\telemetry_cbor.c
+ * @Description: 最小 CBOR 编码器实现
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <string.h>
+
+#include "telemetry_cbor.h"
+
+#define CBOR_MAJOR_UINT     0
+#define CBOR_MAJOR_NINT     1
+#define CBOR_MAJOR_TEXT     3
+#define CBOR_MAJOR_ARRAY    4
+#define CBOR_MAJOR_MAP      5
+
+static void cbor_put(telemetry_cbor_t *w, const uint8_t *data, size_t len)
+{
+    if (w->overflow || w->len + len > w->cap) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->len, data, len);
+    w->len += len;
+}
+
+/* 写类型头：参数 < 24 直接放在首字节，否则按 1/2/4/8 字节大端跟随 */
+static void cbor_head(telemetry_cbor_t *w, uint8_t major, uint64_t arg)
+{
+    uint8_t head[9];
+    size_t n;
+
+    if (arg < 24) {
+        head[0] = (uint8_t)((major << 5) | arg);
+        n = 1;
+    } else if (arg <= 0xFF) {
+        head[0] = (uint8_t)((major << 5) | 24);
+        head[1] = (uint8_t)arg;
+        n = 2;
+    } else if (arg <= 0xFFFF) {
+        head[0] = (uint8_t)((major << 5) | 25);
+        head[1] = (uint8_t)(arg >> 8);
+        head[2] = (uint8_t)arg;
+        n = 3;
+    } else if (arg <= 0xFFFFFFFFull) {
+        head[0] = (uint8_t)((major << 5) | 26);
+        for (int i = 0; i < 4; i++) {
+            head[1 + i] = (uint8_t)(arg >> (24 - 8 * i));
+        }
+        n = 5;
+    } else {
+        head[0] = (uint8_t)((major << 5) | 27);
+        for (int i = 0; i < 8; i++) {
+            head[1 + i] = (uint8_t)(arg >> (56 - 8 * i));
+        }
+        n = 9;
+    }
+    cbor_put(w, head, n);
+}
+
+void telemetry_cbor_init(telemetry_cbor_t *w, uint8_t *buf, size_t cap)
+{
+    w->buf = buf;
+    w->cap = cap;
+    w->len = 0;
+    w->overflow = false;
+}
+
+void telemetry_cbor_uint(telemetry_cbor_t *w, uint64_t value)
+{
+    cbor_head(w, CBOR_MAJOR_UINT, value);
+}
+
+void telemetry_cbor_int(telemetry_cbor_t *w, int64_t value)
+{
+    if (value >= 0) {
+        cbor_head(w, CBOR_MAJOR_UINT, (uint64_t)value);
+    } else {
+        cbor_head(w, CBOR_MAJOR_NINT, (uint64_t)(-1 - value)); ///< -1 - n 编码为 n
+    }
+}
+
+void telemetry_cbor_text(telemetry_cbor_t *w, const char *text)
+{
+    size_t len = strlen(text);
+    cbor_head(w, CBOR_MAJOR_TEXT, len);
+    cbor_put(w, (const uint8_t *)text, len);
+}
+
+void telemetry_cbor_array(telemetry_cbor_t *w, size_t count)
+{
+    cbor_head(w, CBOR_MAJOR_ARRAY, count);
+}
+
+void telemetry_cbor_map(telemetry_cbor_t *w, size_t count)
+{
+    cbor_head(w, CBOR_MAJOR_MAP, count);
+}
+
+size_t telemetry_cbor_int_size(int64_t value)
+{
+    uint64_t arg = value >= 0 ? (uint64_t)value : (uint64_t)(-1 - value);
+    if (arg < 24) {
+        return 1;
+    } else if (arg <= 0xFF) {
+        return 2;
+    } else if (arg <= 0xFFFF) {
+        return 3;
+    } else if (arg <= 0xFFFFFFFFull) {
+        return 5;
+    }
+    return 9;
+}
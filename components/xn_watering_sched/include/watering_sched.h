@@ -0,0 +1,167 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-09 10:03:17
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-09 10:03:17
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_watering_sched\include\watering_sched.h
+ * @Description: 浇花调度引擎（多计划 × 多区域，哈希时间轮 + 任务通知即时重排 + NVS 持久化）
+ *
+ * 设计要点：
+ *  - 每个计划 = 区域 + 星期掩码 + 时:分 + 时长，最多 WATERING_SCHED_MAX_PLANS 个，保存在 NVS；
+ *  - 每个计划的下次开始时刻、每个区域的关闭时刻都是时间轮上的一个定时器节点；
+ *  - 调度任务睡到时间轮上最近的到期时刻（最长一圈），修改计划 / 手动开关 / SNTP 校时后
+ *    通过任务通知立刻唤醒重排，不再等待上一次长延时结束；
+ *  - 墙上时间跳变（校时、手动改时间）超过 WATERING_SCHED_JUMP_S 时全部计划重新计算；
+ *    错过开始时刻超过 WATERING_SCHED_LATE_GRACE_S 的一次浇水跳过并计数，不补浇；
+ *  - 区域开关通过回调交给应用层驱动硬件，回调带上剩余开启时长，应用层可以用硬件定时器精确关断，
+ *    引擎自己的关闭定时器作为兜底。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#ifndef WATERING_SCHED_H
+#define WATERING_SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WATERING_SCHED_MAX_PLANS      16          ///< 计划数上限
+#define WATERING_SCHED_MAX_ZONES      8           ///< 区域数上限
+#define WATERING_SCHED_MAX_DURATION_S 3600        ///< 单次浇水时长上限
+#define WATERING_SCHED_LATE_GRACE_S   300         ///< 开始时刻错过多久以内仍然补浇
+#define WATERING_SCHED_JUMP_S         30          ///< 墙上时间与单调时钟偏差超过该值视为时钟跳变
+#define WATERING_SCHED_NVS_NAMESPACE  "watering"
+#define WATERING_SCHED_NVS_KEY        "plans"
+
+/**
+ * @brief 单个浇水计划
+ */
+typedef struct {
+    bool     enabled;                   ///< 是否启用
+    uint8_t  zone;                      ///< 区域编号（0 起）
+    uint8_t  days_mask;                 ///< bit0=周一 ... bit6=周日
+    uint8_t  hour;                      ///< 0~23
+    uint8_t  minute;                    ///< 0~59
+    uint16_t duration_s;                ///< 浇水时长（秒）
+} watering_sched_plan_t;
+
+/**
+ * @brief 区域开关回调（在调度任务或调用 watering_sched_set_zone 的任务中执行，持有引擎锁）
+ *
+ * 区域从关到开、以及已开启区域的关闭时刻变化（计划重叠延长、手动改时长）时都会以 on=true 回调。
+ *
+ * @param duration_s 开启时为距关闭时刻的秒数，0 表示一直开到手动关闭；关闭时为 0
+ */
+typedef void (*watering_sched_zone_cb_t)(uint8_t zone, bool on, uint32_t duration_s, void *ctx);
+
+/**
+ * @brief 调度引擎配置
+ */
+typedef struct {
+    watering_sched_zone_cb_t zone_cb;   ///< 区域开关回调，不可为 NULL
+    void                    *ctx;       ///< 回调上下文
+    uint8_t                  zone_count;///< 实际区域数（1 ~ WATERING_SCHED_MAX_ZONES）
+    const char              *timezone;  ///< POSIX TZ 字符串，NULL 表示不修改
+    const char              *sntp_server; ///< SNTP 服务器，NULL 表示不启动 SNTP（由外部校时）
+    uint32_t                 task_stack_size;
+    UBaseType_t              task_priority;
+} watering_sched_config_t;
+
+#define WATERING_SCHED_DEFAULT_CONFIG(callback)                    \
+    (watering_sched_config_t) {                                    \
+        .zone_cb         = (callback),                             \
+        .ctx             = NULL,                                   \
+        .zone_count      = 1,                                      \
+        .timezone        = "CST-8",                                \
+        .sntp_server     = "ntp.aliyun.com",                       \
+        .task_stack_size = 3072,                                   \
+        .task_priority   = tskIDLE_PRIORITY + 2,                   \
+    }
+
+/**
+ * @brief 调度统计
+ */
+typedef struct {
+    uint32_t runs;                      ///< 按计划开始的浇水次数
+    uint32_t missed;                    ///< 错过宽限期被跳过的次数
+    uint32_t rearms;                    ///< 全部计划重新计算的次数（改计划 / 时钟跳变 / 校时）
+    uint32_t clock_jumps;               ///< 检测到的墙上时间跳变次数
+    uint32_t wakeups;                   ///< 调度任务唤醒次数
+    uint32_t inhibited;                 ///< 因区域被禁止而跳过的计划次数
+} watering_sched_stats_t;
+
+/**
+ * @brief 初始化调度引擎：加载 NVS 中的计划、设置时区、启动 SNTP 与调度任务
+ *
+ * NVS 中没有计划时写入一条默认计划（区域 0，每天 08:00，10 秒，未启用）。
+ *
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 配置非法, ESP_ERR_NO_MEM 资源不足, ESP_ERR_INVALID_STATE 已初始化
+ */
+esp_err_t watering_sched_init(const watering_sched_config_t *config);
+
+/**
+ * @brief 新增 / 修改计划并保存到 NVS，调度任务立即按新计划重排
+ *
+ * @param id   计划编号（0 ~ WATERING_SCHED_MAX_PLANS-1）
+ * @param plan 计划内容
+ *
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 参数越界, ESP_ERR_INVALID_STATE 未初始化，其他值为 NVS 错误
+ */
+esp_err_t watering_sched_set_plan(uint8_t id, const watering_sched_plan_t *plan);
+
+/**
+ * @brief 删除计划（槽位清空并保存）
+ */
+esp_err_t watering_sched_delete_plan(uint8_t id);
+
+/**
+ * @brief 读取计划
+ * @param next_fire 输出下次开始时刻，可为 NULL；未排期（未启用 / 时钟未同步）为 0
+ * @return ESP_OK 成功, ESP_ERR_NOT_FOUND 槽位为空, ESP_ERR_INVALID_ARG 参数非法
+ */
+esp_err_t watering_sched_get_plan(uint8_t id, watering_sched_plan_t *plan, time_t *next_fire);
+
+/**
+ * @brief 手动开关区域
+ *
+ * @param zone       区域编号
+ * @param on         开 / 关
+ * @param duration_s 开启时长，0 表示一直开到手动关闭或计划结束
+ */
+esp_err_t watering_sched_set_zone(uint8_t zone, bool on, uint32_t duration_s);
+
+/**
+ * @brief 区域当前是否开启
+ */
+bool watering_sched_zone_is_on(uint8_t zone);
+
+/**
+ * @brief 禁止 / 解除禁止区域（联锁、雨后暂停、日用水量上限等）
+ *
+ * 禁止期间区域立即关闭，计划开始跳过并计入 inhibited，手动开启返回 ESP_ERR_INVALID_STATE。
+ */
+esp_err_t watering_sched_set_inhibit(uint8_t zone, bool inhibit);
+
+/**
+ * @brief 区域今天（本地日期）累计开启秒数；时钟未同步时按上电以来统计
+ */
+uint32_t watering_sched_zone_today_s(uint8_t zone);
+
+/**
+ * @brief 获取调度统计
+ */
+esp_err_t watering_sched_get_stats(watering_sched_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WATERING_SCHED_H */
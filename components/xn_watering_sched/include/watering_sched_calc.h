@@ -0,0 +1,67 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-09 10:03:17
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-09 10:03:17
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_watering_sched\include\watering_sched_calc.h
+ * @Description: 浇花计划下次触发时间计算（纯函数，不依赖 FreeRTOS，可在主机上编译）
+ *
+ * 时间规则：
+ *  - 计划按本地墙上时间描述（星期掩码 + 时:分），本地时间由 TZ 环境变量决定；
+ *  - 按"本地日期"逐日生成候选时刻，每个本地日期最多一个候选：
+ *      - 夏令时跳过的时刻（如 02:30 不存在）由 mktime 顺延到跳变之后，当天仍浇一次；
+ *      - 夏令时回拨重复出现的时刻只取 mktime 选中的那一个，当天不会浇两次；
+ *  - last_day 记录上次触发的本地日期，时钟回拨后不会在同一天重复触发。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#ifndef WATERING_SCHED_CALC_H
+#define WATERING_SCHED_CALC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WATERING_SCHED_MIN_VALID_TIME  1704067200   ///< 2024-01-01 00:00:00 UTC，早于此视为时钟未同步
+#define WATERING_SCHED_SEARCH_DAYS     8            ///< 向后搜索的本地日期数（覆盖一周 + 今天）
+
+/**
+ * @brief 计划时间规则
+ */
+typedef struct {
+    uint8_t days_mask;                  ///< bit0=周一 ... bit6=周日
+    uint8_t hour;                       ///< 0~23
+    uint8_t minute;                     ///< 0~59
+} watering_sched_rule_t;
+
+/**
+ * @brief 时钟是否已同步（早于 WATERING_SCHED_MIN_VALID_TIME 视为未同步）
+ */
+bool watering_sched_time_valid(time_t now);
+
+/**
+ * @brief 本地日期键 yyyymmdd（按当前 TZ）
+ */
+int32_t watering_sched_day_key(time_t t);
+
+/**
+ * @brief 计算规则在 now 之后的下一次触发时刻
+ *
+ * @param rule     时间规则
+ * @param now      当前时刻
+ * @param last_day 上次触发的本地日期键，该日期及之前的候选被跳过；0 表示无
+ *
+ * @return 下一次触发时刻（> now），规则无效（掩码为 0、时分越界）返回 -1
+ */
+time_t watering_sched_next_fire(const watering_sched_rule_t *rule, time_t now, int32_t last_day);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WATERING_SCHED_CALC_H */
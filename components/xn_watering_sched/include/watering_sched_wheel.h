@@ -0,0 +1,98 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-09 10:03:17
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-09 10:03:17
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_watering_sched\include\watering_sched_wheel.h
+ * @Description: 哈希时间轮（按墙上时间秒散列，纯数据结构，不加锁，可在主机上编译）
+ *
+ * - 定时器按 expires % SLOTS 挂到槽位链表，插入 / 删除 O(1)，定时器节点由调用方持有（侵入式）；
+ * - 推进时只扫描 (cursor, now] 经过的槽位，跨度超过一圈（时钟前跳）时整圈扫描一次；
+ * - 同一槽位里 expires 属于后面几圈的节点保留不动；
+ * - 到期节点先全部摘下，按 (expires, kind) 排序后再逐个回调，回调里可以重新插入；
+ *   同一批里先回调的节点可能把后面的节点重新插入，调用方的回调应按自身状态校验是否仍然到期。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#ifndef WATERING_SCHED_WHEEL_H
+#define WATERING_SCHED_WHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WATERING_SCHED_WHEEL_SLOTS   256         ///< 槽位数（2 的幂），每槽 1 秒，一圈约 4 分钟
+
+/**
+ * @brief 定时器节点
+ */
+typedef struct watering_sched_timer {
+    struct watering_sched_timer  *next;
+    struct watering_sched_timer **pprev;          ///< 指向前驱的 next 字段，NULL 表示未挂入时间轮
+    struct watering_sched_timer  *due_next;       ///< 推进时的到期链表（与槽位链表分开，回调中可重新插入任意节点）
+    int64_t                       expires;        ///< 到期时刻（秒，墙上时间）
+    uint8_t                       kind;           ///< 调用方自定义类型，同一时刻按 kind 从小到大回调
+    uint8_t                       index;          ///< 调用方自定义索引（计划 / 区域编号）
+} watering_sched_timer_t;
+
+/**
+ * @brief 时间轮
+ */
+typedef struct {
+    watering_sched_timer_t *slots[WATERING_SCHED_WHEEL_SLOTS];
+    int64_t                 cursor;               ///< 已处理到的时刻
+    uint32_t                pending;              ///< 挂入的节点数
+} watering_sched_wheel_t;
+
+/**
+ * @brief 到期回调
+ */
+typedef void (*watering_sched_expire_cb_t)(watering_sched_timer_t *timer, void *arg);
+
+/**
+ * @brief 初始化时间轮，cursor 设为 now
+ */
+void watering_sched_wheel_init(watering_sched_wheel_t *wheel, int64_t now);
+
+/**
+ * @brief 插入（已挂入时先摘下再插入）；expires <= cursor 的节点在下一次推进时到期
+ */
+void watering_sched_wheel_add(watering_sched_wheel_t *wheel, watering_sched_timer_t *timer, int64_t expires);
+
+/**
+ * @brief 摘下节点（未挂入时无操作）
+ */
+void watering_sched_wheel_remove(watering_sched_wheel_t *wheel, watering_sched_timer_t *timer);
+
+/**
+ * @brief 节点是否挂在时间轮上
+ */
+static inline bool watering_sched_timer_pending(const watering_sched_timer_t *timer)
+{
+    return timer->pprev != NULL;
+}
+
+/**
+ * @brief 推进到 now，回调所有 expires <= now 的节点
+ *
+ * now 小于 cursor（时钟回拨）时只把 cursor 拉回 now，节点的绝对到期时刻不变。
+ *
+ * @return 到期回调次数
+ */
+uint32_t watering_sched_wheel_advance(watering_sched_wheel_t *wheel, int64_t now,
+                                      watering_sched_expire_cb_t cb, void *arg);
+
+/**
+ * @brief 下一个需要唤醒的时刻：一圈之内最早的到期时刻，一圈内没有则返回 cursor + SLOTS
+ */
+int64_t watering_sched_wheel_next(const watering_sched_wheel_t *wheel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WATERING_SCHED_WHEEL_H */
@@ -0,0 +1,601 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-09 10:03:17
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-09 10:03:17
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_watering_sched\src\watering_sched.c
+ * @Description: 浇花调度引擎实现
+ *
+ * 所有计划 / 区域状态和时间轮由 s_mutex 保护；时间轮只在持锁时操作。
+ * 调度任务每次醒来：检测时钟跳变 -> 需要时重排全部计划 -> 推进时间轮 -> 睡到下一个到期时刻。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_sntp.h"
+#include "nvs.h"
+
+#include "watering_sched_calc.h"
+#include "watering_sched_wheel.h"
+#include "watering_sched.h"
+
+static const char *TAG = "watering_sched";
+
+#define SCHED_NVS_VERSION        1
+#define SCHED_NVS_RECORD         8              ///< used, enabled, zone, days, hour, minute, dur_lo, dur_hi
+#define SCHED_UNSYNCED_WAIT_MS   10000          ///< 时钟未同步时的轮询间隔
+
+/* 同一时刻先关后开：上一段计划结束与下一段计划开始重合时区域保持开启 */
+#define SCHED_KIND_ZONE_OFF      0
+#define SCHED_KIND_PLAN_START    1
+
+typedef struct {
+    bool                   used;
+    watering_sched_plan_t  plan;
+    int32_t                last_day;            ///< 上次触发的本地日期键
+    time_t                 next;                ///< 下次开始时刻，0 表示未排期
+    watering_sched_timer_t timer;
+} sched_plan_slot_t;
+
+typedef struct {
+    bool                   on;
+    bool                   inhibit;             ///< 被规则禁止：保持关闭
+    int64_t                off_at;              ///< 自动关闭时刻，0 表示不自动关闭
+    int64_t                on_since_us;         ///< 本次开启的单调时刻
+    uint32_t               today_s;             ///< 今天已关闭部分的累计开启秒数
+    int32_t                today_key;           ///< today_s 对应的本地日期键
+    watering_sched_timer_t timer;
+} sched_zone_t;
+
+static watering_sched_config_t s_cfg;
+static SemaphoreHandle_t       s_mutex;
+static TaskHandle_t            s_task;
+static watering_sched_wheel_t  s_wheel;
+static sched_plan_slot_t       s_plans[WATERING_SCHED_MAX_PLANS];
+static sched_zone_t            s_zones[WATERING_SCHED_MAX_ZONES];
+static watering_sched_stats_t  s_stats;
+static bool                    s_rearm;         ///< 下次醒来时重排全部计划
+static bool                    s_valid;         ///< 上次醒来时时钟是否已同步
+
+/* -------------------- NVS -------------------- */
+
+static esp_err_t sched_save(void)
+{
+    uint8_t blob[1 + WATERING_SCHED_MAX_PLANS * SCHED_NVS_RECORD];
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    blob[0] = SCHED_NVS_VERSION;
+    for (int i = 0; i < WATERING_SCHED_MAX_PLANS; i++) {
+        const sched_plan_slot_t *s = &s_plans[i];
+        uint8_t *r = &blob[1 + i * SCHED_NVS_RECORD];
+        r[0] = s->used ? 1 : 0;
+        r[1] = s->plan.enabled ? 1 : 0;
+        r[2] = s->plan.zone;
+        r[3] = s->plan.days_mask;
+        r[4] = s->plan.hour;
+        r[5] = s->plan.minute;
+        r[6] = (uint8_t)(s->plan.duration_s & 0xFF);
+        r[7] = (uint8_t)(s->plan.duration_s >> 8);
+    }
+    xSemaphoreGive(s_mutex);
+
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(WATERING_SCHED_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "nvs_open(write) failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    ret = nvs_set_blob(handle, WATERING_SCHED_NVS_KEY, blob, sizeof(blob));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "save plans failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief 从 NVS 加载计划（init 阶段调用，任务尚未启动）
+ * @return 加载到的计划数，-1 表示没有保存过
+ */
+static int sched_load(void)
+{
+    uint8_t blob[1 + WATERING_SCHED_MAX_PLANS * SCHED_NVS_RECORD];
+    size_t  len = sizeof(blob);
+
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(WATERING_SCHED_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (ret != ESP_OK) {
+        return -1;                                   ///< 命名空间不存在：尚未保存过
+    }
+    ret = nvs_get_blob(handle, WATERING_SCHED_NVS_KEY, blob, &len);
+    nvs_close(handle);
+    if (ret != ESP_OK || len < 1 || blob[0] != SCHED_NVS_VERSION) {
+        return -1;
+    }
+
+    int count = 0;
+    int records = (int)((len - 1) / SCHED_NVS_RECORD);
+    for (int i = 0; i < records && i < WATERING_SCHED_MAX_PLANS; i++) {
+        const uint8_t *r = &blob[1 + i * SCHED_NVS_RECORD];
+        if (r[0] == 0) {
+            continue;
+        }
+        sched_plan_slot_t *s = &s_plans[i];
+        s->used            = true;
+        s->plan.enabled    = r[1] != 0;
+        s->plan.zone       = r[2];
+        s->plan.days_mask  = r[3];
+        s->plan.hour       = r[4];
+        s->plan.minute     = r[5];
+        s->plan.duration_s = (uint16_t)(r[6] | (r[7] << 8));
+        count++;
+    }
+    return count;
+}
+
+/* -------------------- 区域 / 计划（持锁调用） -------------------- */
+
+/* 跨过本地日期时清零；跨午夜仍在开启的那一段整段计入关闭时的日期 */
+static void sched_zone_roll_day(sched_zone_t *z)
+{
+    int32_t key = watering_sched_day_key(time(NULL));
+    if (key != z->today_key) {
+        z->today_key = key;
+        z->today_s   = 0;
+    }
+}
+
+static uint32_t sched_zone_remaining(const sched_zone_t *z)
+{
+    if (z->off_at == 0) {
+        return 0;
+    }
+    int64_t left = z->off_at - (int64_t)time(NULL);
+    return left > 0 ? (uint32_t)left : 1;
+}
+
+/* 调用前先设置好 off_at：回调带上剩余时长 */
+static void sched_zone_switch(uint8_t zone, bool on)
+{
+    sched_zone_t *z = &s_zones[zone];
+    if (z->on == on) {
+        if (on) {
+            s_cfg.zone_cb(zone, true, sched_zone_remaining(z), s_cfg.ctx);   ///< 已开启：只刷新关闭时刻
+        }
+        return;
+    }
+    z->on = on;
+    sched_zone_roll_day(z);
+    if (on) {
+        z->on_since_us = esp_timer_get_time();
+    } else {
+        z->today_s += (uint32_t)((esp_timer_get_time() - z->on_since_us) / 1000000);
+    }
+    ESP_LOGI(TAG, "zone %u %s", (unsigned)zone, on ? "ON" : "OFF");
+    s_cfg.zone_cb(zone, on, on ? sched_zone_remaining(z) : 0, s_cfg.ctx);
+}
+
+static void sched_zone_off(uint8_t zone)
+{
+    sched_zone_t *z = &s_zones[zone];
+    watering_sched_wheel_remove(&s_wheel, &z->timer);
+    z->off_at = 0;
+    sched_zone_switch(zone, false);
+}
+
+/**
+ * @brief 开启区域 duration_s 秒；多个计划重叠时取最晚的关闭时刻，手动常开时保持常开
+ */
+static void sched_zone_run(uint8_t zone, int64_t now, uint32_t duration_s)
+{
+    sched_zone_t *z = &s_zones[zone];
+    bool manual_hold = z->on && z->off_at == 0;
+
+    if (manual_hold) {
+        return;
+    }
+
+    int64_t off_at = now + (int64_t)duration_s;
+    if (off_at > z->off_at) {
+        z->off_at = off_at;
+        watering_sched_wheel_add(&s_wheel, &z->timer, off_at);
+        sched_zone_switch(zone, true);
+    }
+}
+
+static void sched_plan_arm(uint8_t id, time_t now)
+{
+    sched_plan_slot_t *s = &s_plans[id];
+
+    if (!s->used || !s->plan.enabled || !s_valid) {
+        watering_sched_wheel_remove(&s_wheel, &s->timer);
+        s->next = 0;
+        return;
+    }
+
+    watering_sched_rule_t rule = {
+        .days_mask = s->plan.days_mask,
+        .hour      = s->plan.hour,
+        .minute    = s->plan.minute,
+    };
+    time_t next = watering_sched_next_fire(&rule, now, s->last_day);
+    if (next <= 0) {
+        watering_sched_wheel_remove(&s_wheel, &s->timer);
+        s->next = 0;
+        return;
+    }
+    s->next = next;
+    watering_sched_wheel_add(&s_wheel, &s->timer, (int64_t)next);
+}
+
+static void sched_rearm_all(time_t now)
+{
+    for (uint8_t i = 0; i < WATERING_SCHED_MAX_PLANS; i++) {
+        sched_plan_arm(i, now);
+    }
+    s_stats.rearms++;
+}
+
+static void sched_on_expire(watering_sched_timer_t *timer, void *arg)
+{
+    time_t now = *(const time_t *)arg;
+
+    if (timer->kind == SCHED_KIND_ZONE_OFF) {
+        sched_zone_t *z = &s_zones[timer->index];
+        /* 同批中开始回调可能已把关闭时刻后延并重新挂入 */
+        if (z->on && z->off_at != 0 && z->off_at <= (int64_t)now) {
+            sched_zone_off(timer->index);
+        }
+        return;
+    }
+
+    sched_plan_slot_t *s = &s_plans[timer->index];
+    if (!s->used || !s->plan.enabled || s->next == 0 || s->next > now ||
+        watering_sched_timer_pending(&s->timer)) {
+        return;
+    }
+
+    int64_t late = (int64_t)(now - s->next);
+    s->last_day = watering_sched_day_key(s->next);
+
+    if (late > WATERING_SCHED_LATE_GRACE_S) {
+        s_stats.missed++;
+        ESP_LOGW(TAG, "⚠️ plan %u missed by %lld s, skip", (unsigned)timer->index, (long long)late);
+    } else if (s->plan.zone < s_cfg.zone_count && s_zones[s->plan.zone].inhibit) {
+        s_stats.inhibited++;
+        ESP_LOGI(TAG, "⛔ plan %u skipped: zone %u inhibited", (unsigned)timer->index, (unsigned)s->plan.zone);
+    } else if (s->plan.zone < s_cfg.zone_count) {
+        s_stats.runs++;
+        ESP_LOGI(TAG, "🌱 plan %u start zone %u for %u s",
+                 (unsigned)timer->index, (unsigned)s->plan.zone, (unsigned)s->plan.duration_s);
+        sched_zone_run(s->plan.zone, now, s->plan.duration_s);
+    }
+
+    sched_plan_arm(timer->index, now);
+}
+
+/* -------------------- 调度任务 -------------------- */
+
+static int64_t sched_wall_ms(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+static void sched_task(void *arg)
+{
+    (void)arg;
+
+    int64_t last_wall_ms = sched_wall_ms();
+    int64_t last_mono_us = esp_timer_get_time();
+
+    for (;;) {
+        int64_t now_ms  = sched_wall_ms();
+        int64_t mono_us = esp_timer_get_time();
+        time_t  now     = (time_t)(now_ms / 1000);
+        uint32_t wait_ms;
+
+        xSemaphoreTake(s_mutex, portMAX_DELAY);
+        s_stats.wakeups++;
+
+        /* 墙上时间相对单调时钟的偏移：校时 / 手动改时间 */
+        int64_t drift_ms = now_ms - (last_wall_ms + (mono_us - last_mono_us) / 1000);
+        if (llabs(drift_ms) > (int64_t)WATERING_SCHED_JUMP_S * 1000) {
+            s_stats.clock_jumps++;
+            /* 计划开始时刻是绝对时间，前跳后由推进 + 宽限期处理；回拨后重新推算（last_day 防止同日重复） */
+            if (drift_ms < 0) {
+                s_rearm = true;
+            }
+            ESP_LOGW(TAG, "⏰ clock jumped %lld s", (long long)(drift_ms / 1000));
+            /* 区域关闭时刻是相对时长，随时钟一起平移，避免回拨时多浇 */
+            for (uint8_t z = 0; z < s_cfg.zone_count; z++) {
+                if (s_zones[z].off_at != 0) {
+                    s_zones[z].off_at += drift_ms / 1000;
+                    watering_sched_wheel_add(&s_wheel, &s_zones[z].timer, s_zones[z].off_at);
+                }
+            }
+        }
+
+        bool valid = watering_sched_time_valid(now);
+        if (valid != s_valid) {
+            s_valid = valid;
+            s_rearm = true;
+        }
+        if (s_rearm) {
+            s_rearm = false;
+            sched_rearm_all(now);
+        }
+
+        watering_sched_wheel_advance(&s_wheel, (int64_t)now, sched_on_expire, &now);
+
+        if (s_valid || s_wheel.pending > 0) {
+            int64_t next_ms = watering_sched_wheel_next(&s_wheel) * 1000;
+            int64_t delta   = next_ms - now_ms;
+            wait_ms = delta < 10 ? 10 : (uint32_t)delta;
+        } else {
+            wait_ms = SCHED_UNSYNCED_WAIT_MS;
+        }
+        xSemaphoreGive(s_mutex);
+
+        last_wall_ms = now_ms;
+        last_mono_us = mono_us;
+
+        /* 计划变更 / 手动开关 / 校时通过任务通知提前唤醒 */
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms));
+    }
+}
+
+static void sched_kick(bool rearm)
+{
+    if (rearm) {
+        xSemaphoreTake(s_mutex, portMAX_DELAY);
+        s_rearm = true;
+        xSemaphoreGive(s_mutex);
+    }
+    if (s_task != NULL) {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+static void sched_on_time_sync(struct timeval *tv)
+{
+    (void)tv;
+    ESP_LOGI(TAG, "🕒 time synchronized");
+    sched_kick(true);
+}
+
+static bool sched_plan_valid(const watering_sched_plan_t *plan)
+{
+    return plan != NULL &&
+           plan->zone < s_cfg.zone_count &&
+           (plan->days_mask & 0x7F) != 0 && (plan->days_mask & 0x80) == 0 &&
+           plan->hour <= 23 && plan->minute <= 59 &&
+           plan->duration_s >= 1 && plan->duration_s <= WATERING_SCHED_MAX_DURATION_S;
+}
+
+/* -------------------- 对外接口 -------------------- */
+
+esp_err_t watering_sched_init(const watering_sched_config_t *config)
+{
+    if (s_task != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (config == NULL || config->zone_cb == NULL ||
+        config->zone_count == 0 || config->zone_count > WATERING_SCHED_MAX_ZONES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_cfg = *config;
+
+    s_mutex = xSemaphoreCreateMutex();
+    if (s_mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (uint8_t i = 0; i < WATERING_SCHED_MAX_PLANS; i++) {
+        s_plans[i].timer.kind  = SCHED_KIND_PLAN_START;
+        s_plans[i].timer.index = i;
+    }
+    for (uint8_t z = 0; z < WATERING_SCHED_MAX_ZONES; z++) {
+        s_zones[z].timer.kind  = SCHED_KIND_ZONE_OFF;
+        s_zones[z].timer.index = z;
+    }
+    watering_sched_wheel_init(&s_wheel, (int64_t)time(NULL));
+
+    int loaded = sched_load();
+    if (loaded < 0) {
+        s_plans[0].used = true;
+        s_plans[0].plan = (watering_sched_plan_t) {
+            .enabled = false, .zone = 0, .days_mask = 0x7F, .hour = 8, .minute = 0, .duration_s = 10,
+        };
+        (void)sched_save();
+        loaded = 1;
+    }
+
+    if (s_cfg.timezone != NULL) {
+        setenv("TZ", s_cfg.timezone, 1);
+        tzset();
+    }
+    if (s_cfg.sntp_server != NULL && !esp_sntp_enabled()) {
+        esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
+        esp_sntp_setservername(0, s_cfg.sntp_server);
+        sntp_set_time_sync_notification_cb(sched_on_time_sync);
+        esp_sntp_init();
+    }
+
+    BaseType_t ok = xTaskCreate(sched_task, "watering_sched", s_cfg.task_stack_size,
+                                NULL, s_cfg.task_priority, &s_task);
+    if (ok != pdPASS) {
+        s_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "✅ scheduler started: %d plans, %u zones", loaded, (unsigned)s_cfg.zone_count);
+    return ESP_OK;
+}
+
+esp_err_t watering_sched_set_plan(uint8_t id, const watering_sched_plan_t *plan)
+{
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (id >= WATERING_SCHED_MAX_PLANS || !sched_plan_valid(plan)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    sched_plan_slot_t *s = &s_plans[id];
+    if (!s->used || s->plan.hour != plan->hour || s->plan.minute != plan->minute ||
+        s->plan.days_mask != plan->days_mask) {
+        s->last_day = 0;                             ///< 改了时间允许当天按新时间再浇一次
+    }
+    s->used = true;
+    s->plan = *plan;
+    xSemaphoreGive(s_mutex);
+
+    sched_kick(true);
+    return sched_save();
+}
+
+esp_err_t watering_sched_delete_plan(uint8_t id)
+{
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (id >= WATERING_SCHED_MAX_PLANS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_plans[id].used = false;
+    memset(&s_plans[id].plan, 0, sizeof(s_plans[id].plan));
+    s_plans[id].last_day = 0;
+    xSemaphoreGive(s_mutex);
+
+    sched_kick(true);
+    return sched_save();
+}
+
+esp_err_t watering_sched_get_plan(uint8_t id, watering_sched_plan_t *plan, time_t *next_fire)
+{
+    if (s_mutex == NULL || id >= WATERING_SCHED_MAX_PLANS || plan == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (!s_plans[id].used) {
+        ret = ESP_ERR_NOT_FOUND;
+    } else {
+        *plan = s_plans[id].plan;
+        if (next_fire != NULL) {
+            *next_fire = s_plans[id].next;
+        }
+    }
+    xSemaphoreGive(s_mutex);
+    return ret;
+}
+
+esp_err_t watering_sched_set_zone(uint8_t zone, bool on, uint32_t duration_s)
+{
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (zone >= s_cfg.zone_count || duration_s > WATERING_SCHED_MAX_DURATION_S) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (on && s_zones[zone].inhibit) {
+        xSemaphoreGive(s_mutex);
+        ESP_LOGW(TAG, "⛔ zone %u inhibited, ignore manual on", (unsigned)zone);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!on) {
+        sched_zone_off(zone);
+    } else if (duration_s == 0) {
+        watering_sched_wheel_remove(&s_wheel, &s_zones[zone].timer);
+        s_zones[zone].off_at = 0;                    ///< 手动常开
+        sched_zone_switch(zone, true);
+    } else {
+        int64_t off_at = (int64_t)time(NULL) + duration_s;
+        s_zones[zone].off_at = off_at;
+        watering_sched_wheel_add(&s_wheel, &s_zones[zone].timer, off_at);
+        sched_zone_switch(zone, true);
+    }
+    xSemaphoreGive(s_mutex);
+
+    sched_kick(false);                               ///< 关闭时刻可能早于任务当前的睡眠终点
+    return ESP_OK;
+}
+
+bool watering_sched_zone_is_on(uint8_t zone)
+{
+    if (s_mutex == NULL || zone >= WATERING_SCHED_MAX_ZONES) {
+        return false;
+    }
+    return s_zones[zone].on;
+}
+
+esp_err_t watering_sched_set_inhibit(uint8_t zone, bool inhibit)
+{
+    if (s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (zone >= s_cfg.zone_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (s_zones[zone].inhibit != inhibit) {
+        s_zones[zone].inhibit = inhibit;
+        ESP_LOGI(TAG, "zone %u %s", (unsigned)zone, inhibit ? "inhibited" : "released");
+        if (inhibit) {
+            sched_zone_off(zone);
+        }
+    }
+    xSemaphoreGive(s_mutex);
+    return ESP_OK;
+}
+
+uint32_t watering_sched_zone_today_s(uint8_t zone)
+{
+    if (s_mutex == NULL || zone >= s_cfg.zone_count) {
+        return 0;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    sched_zone_t *z = &s_zones[zone];
+    sched_zone_roll_day(z);
+    uint32_t total = z->today_s;
+    if (z->on) {
+        total += (uint32_t)((esp_timer_get_time() - z->on_since_us) / 1000000);
+    }
+    xSemaphoreGive(s_mutex);
+    return total;
+}
+
+esp_err_t watering_sched_get_stats(watering_sched_stats_t *stats)
+{
+    if (stats == NULL || s_mutex == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_mutex);
+    return ESP_OK;
+}
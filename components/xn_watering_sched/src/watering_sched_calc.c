@@ -0,0 +1,85 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-09 10:03:17
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-09 10:03:17
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_watering_sched\src\watering_sched_calc.c
+ * @Description: 浇花计划下次触发时间计算
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <string.h>
+
+#include "watering_sched_calc.h"
+
+bool watering_sched_time_valid(time_t now)
+{
+    return now >= (time_t)WATERING_SCHED_MIN_VALID_TIME;
+}
+
+static int32_t day_key_of(const struct tm *tm)
+{
+    return (int32_t)(tm->tm_year + 1900) * 10000 + (tm->tm_mon + 1) * 100 + tm->tm_mday;
+}
+
+int32_t watering_sched_day_key(time_t t)
+{
+    struct tm tm;
+    if (localtime_r(&t, &tm) == NULL) {
+        return 0;
+    }
+    return day_key_of(&tm);
+}
+
+time_t watering_sched_next_fire(const watering_sched_rule_t *rule, time_t now, int32_t last_day)
+{
+    if (rule == NULL || (rule->days_mask & 0x7F) == 0 || rule->hour > 23 || rule->minute > 59) {
+        return -1;
+    }
+
+    struct tm today;
+    if (localtime_r(&now, &today) == NULL) {
+        return -1;
+    }
+
+    for (int d = 0; d <= WATERING_SCHED_SEARCH_DAYS; d++) {
+        /* 从当天正午出发再加天数，避开日期边界附近的夏令时跳变，mktime 负责跨月 / 跨年进位 */
+        struct tm day;
+        memset(&day, 0, sizeof(day));
+        day.tm_year  = today.tm_year;
+        day.tm_mon   = today.tm_mon;
+        day.tm_mday  = today.tm_mday + d;
+        day.tm_hour  = 12;
+        day.tm_isdst = -1;
+        if (mktime(&day) == (time_t)-1) {
+            continue;
+        }
+
+        int bit = (day.tm_wday + 6) % 7;             ///< tm_wday 0=周日，掩码 bit0=周一
+        if ((rule->days_mask & (1 << bit)) == 0) {
+            continue;
+        }
+
+        int32_t key = day_key_of(&day);
+        if (key <= last_day) {
+            continue;
+        }
+
+        struct tm cand;
+        memset(&cand, 0, sizeof(cand));
+        cand.tm_year  = day.tm_year;
+        cand.tm_mon   = day.tm_mon;
+        cand.tm_mday  = day.tm_mday;
+        cand.tm_hour  = rule->hour;
+        cand.tm_min   = rule->minute;
+        cand.tm_isdst = -1;
+
+        time_t t = mktime(&cand);                    ///< 不存在的时刻被顺延，重复的时刻只取一个
+        if (t == (time_t)-1 || t <= now) {
+            continue;
+        }
+        return t;
+    }
+    return -1;
+}
@@ -0,0 +1,116 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-09 10:03:17
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-09 10:03:17
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_watering_sched\src\watering_sched_wheel.c
+ * @Description: 哈希时间轮实现
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <string.h>
+
+#include "watering_sched_wheel.h"
+
+#define WHEEL_MASK  (WATERING_SCHED_WHEEL_SLOTS - 1)
+
+void watering_sched_wheel_init(watering_sched_wheel_t *wheel, int64_t now)
+{
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->cursor = now;
+}
+
+void watering_sched_wheel_remove(watering_sched_wheel_t *wheel, watering_sched_timer_t *timer)
+{
+    if (timer->pprev == NULL) {
+        return;
+    }
+    *timer->pprev = timer->next;
+    if (timer->next != NULL) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next  = NULL;
+    timer->pprev = NULL;
+    wheel->pending--;
+}
+
+void watering_sched_wheel_add(watering_sched_wheel_t *wheel, watering_sched_timer_t *timer, int64_t expires)
+{
+    watering_sched_wheel_remove(wheel, timer);
+
+    /* 已过期的节点放到下一个要扫描的槽位，保证下次推进时被处理 */
+    int64_t at = expires > wheel->cursor ? expires : wheel->cursor + 1;
+    watering_sched_timer_t **head = &wheel->slots[(uint64_t)at & WHEEL_MASK];
+
+    timer->expires = expires;
+    timer->next    = *head;
+    timer->pprev   = head;
+    if (*head != NULL) {
+        (*head)->pprev = &timer->next;
+    }
+    *head = timer;
+    wheel->pending++;
+}
+
+/* 按 (expires, kind) 升序插入到期链表 */
+static void due_insert(watering_sched_timer_t **due, watering_sched_timer_t *timer)
+{
+    while (*due != NULL &&
+           ((*due)->expires < timer->expires ||
+            ((*due)->expires == timer->expires && (*due)->kind <= timer->kind))) {
+        due = &(*due)->due_next;
+    }
+    timer->due_next = *due;
+    *due = timer;
+}
+
+uint32_t watering_sched_wheel_advance(watering_sched_wheel_t *wheel, int64_t now,
+                                      watering_sched_expire_cb_t cb, void *arg)
+{
+    if (now <= wheel->cursor) {
+        wheel->cursor = now;                     ///< 时钟回拨：节点到期时刻是绝对值，无需调整
+        return 0;
+    }
+
+    int64_t span = now - wheel->cursor;
+    int     steps = span >= WATERING_SCHED_WHEEL_SLOTS ? WATERING_SCHED_WHEEL_SLOTS : (int)span;
+    watering_sched_timer_t *due = NULL;
+
+    for (int i = 1; i <= steps; i++) {
+        watering_sched_timer_t **link = &wheel->slots[(uint64_t)(wheel->cursor + i) & WHEEL_MASK];
+        while (*link != NULL) {
+            watering_sched_timer_t *t = *link;
+            if (t->expires > now) {
+                link = &t->next;
+                continue;
+            }
+            watering_sched_wheel_remove(wheel, t);
+            due_insert(&due, t);
+        }
+    }
+    wheel->cursor = now;
+
+    uint32_t fired = 0;
+    while (due != NULL) {
+        watering_sched_timer_t *t = due;
+        due         = t->due_next;
+        t->due_next = NULL;
+        cb(t, arg);                              ///< 回调里可重新插入任意节点
+        fired++;
+    }
+    return fired;
+}
+
+int64_t watering_sched_wheel_next(const watering_sched_wheel_t *wheel)
+{
+    for (int i = 1; i <= WATERING_SCHED_WHEEL_SLOTS; i++) {
+        int64_t at = wheel->cursor + i;
+        for (const watering_sched_timer_t *t = wheel->slots[(uint64_t)at & WHEEL_MASK]; t != NULL; t = t->next) {
+            if (t->expires <= at) {
+                return at;
+            }
+        }
+    }
+    return wheel->cursor + WATERING_SCHED_WHEEL_SLOTS;
+}
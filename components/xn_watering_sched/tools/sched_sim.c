@@ -0,0 +1,361 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-09 10:03:17
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-09 10:03:17
+ * @FilePath: \xn_esp32_coze_chat_watering\components\xn_watering_sched\tools\sched_sim.c
+ * @Description: 调度计算 + 时间轮主机仿真：虚拟时钟从一个到期时刻跳到下一个，约 0.1 秒跑完一整年
+ *
+ * 编译运行（在组件目录下）：
+ *   gcc -O2 -Iinclude src/watering_sched_calc.c src/watering_sched_wheel.c tools/sched_sim.c -o sched_sim
+ *   ./sched_sim [计划数] [年份]
+ *
+ * 每个时区跑两轮：
+ *  - 稳定时钟：每个计划在掩码里的每个本地日期恰好浇一次，时刻等于 时:分（落在夏令时空档时顺延一小时），
+ *    区域在最晚的关闭时刻准时关闭；
+ *  - 随机跳变：插入前跳 / 回拨（校时、手动改时间），检查同一计划同一本地日期不会浇两次，
+ *    迟到不超过宽限期，超过的计为 missed。
+ * 最后统计旧实现（tm_wday 0=周日 直接当作掩码 bit0=周一）会浇错星期的比例。
+ *
+ * 调度逻辑与 src/watering_sched.c 中的 sched_on_expire / sched_task 保持一致，只是去掉了锁和 NVS。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "watering_sched_calc.h"
+#include "watering_sched_wheel.h"
+
+#define SIM_MAX_PLANS    64
+#define SIM_ZONES        4
+#define SIM_GRACE_S      300                     ///< 与 WATERING_SCHED_LATE_GRACE_S 相同
+#define SIM_DAY_SLOTS    400
+
+#define KIND_ZONE_OFF    0
+#define KIND_PLAN_START  1
+
+typedef struct {
+    watering_sched_rule_t  rule;
+    uint8_t                zone;
+    uint16_t               duration_s;
+    int32_t                last_day;
+    time_t                 next;
+    watering_sched_timer_t timer;
+    int32_t                fired_days[SIM_DAY_SLOTS];
+    int                    fired;
+} sim_plan_t;
+
+typedef struct {
+    int                    on;
+    int64_t                off_at;
+    watering_sched_timer_t timer;
+} sim_zone_t;
+
+static sim_plan_t             s_plans[SIM_MAX_PLANS];
+static int                    s_plan_count;
+static sim_zone_t             s_zones[SIM_ZONES];
+static watering_sched_wheel_t s_wheel;
+static int                    s_jumps;           ///< 本轮是否插入时钟跳变
+static unsigned               s_rng = 12345;
+static long                   s_runs, s_missed, s_late_max, s_errors, s_wakeups;
+
+static unsigned sim_rand(void)
+{
+    s_rng = s_rng * 1103515245u + 12345u;
+    return (s_rng >> 16) & 0x7FFF;
+}
+
+#define SIM_FAIL(...) do { if (s_errors++ < 10) { printf("FAIL: " __VA_ARGS__); printf("\n"); } } while (0)
+
+static void plan_arm(int id, time_t now)
+{
+    sim_plan_t *p = &s_plans[id];
+    time_t next = watering_sched_next_fire(&p->rule, now, p->last_day);
+    if (next <= 0) {
+        watering_sched_wheel_remove(&s_wheel, &p->timer);
+        p->next = 0;
+        return;
+    }
+    p->next = next;
+    watering_sched_wheel_add(&s_wheel, &p->timer, (int64_t)next);
+}
+
+static void zone_run(uint8_t zone, int64_t now, uint32_t duration_s)
+{
+    sim_zone_t *z = &s_zones[zone];
+    z->on = 1;
+    if (now + (int64_t)duration_s > z->off_at) {
+        z->off_at = now + (int64_t)duration_s;
+        watering_sched_wheel_add(&s_wheel, &z->timer, z->off_at);
+    }
+}
+
+/* 校验一次触发：星期、时分（夏令时空档允许顺延）、同日不重复 */
+static void check_fire(int id, time_t fire)
+{
+    sim_plan_t *p = &s_plans[id];
+    struct tm tm;
+    localtime_r(&fire, &tm);
+
+    int bit = (tm.tm_wday + 6) % 7;
+    if ((p->rule.days_mask & (1 << bit)) == 0) {
+        SIM_FAIL("plan %d fired on masked-out weekday %d (mask 0x%02x)", id, bit, p->rule.days_mask);
+    }
+
+    int want = p->rule.hour * 60 + p->rule.minute;
+    int got  = tm.tm_hour * 60 + tm.tm_min;
+    if (got != want && got != want + 60) {
+        SIM_FAIL("plan %d fired at %02d:%02d, want %02d:%02d",
+                 id, tm.tm_hour, tm.tm_min, p->rule.hour, p->rule.minute);
+    }
+    if (got == want + 60) {
+        /* 只允许在春季跳过的那一小时里顺延：同一天 want 时刻不存在 */
+        struct tm probe = tm;
+        probe.tm_hour  = p->rule.hour;
+        probe.tm_min   = p->rule.minute;
+        probe.tm_isdst = -1;
+        time_t t = mktime(&probe);
+        struct tm back;
+        localtime_r(&t, &back);
+        if (back.tm_hour == p->rule.hour && back.tm_min == p->rule.minute) {
+            SIM_FAIL("plan %d shifted by an hour on a normal day", id);
+        }
+    }
+
+    int32_t key = watering_sched_day_key(fire);
+    for (int i = 0; i < p->fired; i++) {
+        if (p->fired_days[i] == key) {
+            SIM_FAIL("plan %d fired twice on %ld", id, (long)key);
+        }
+    }
+    if (p->fired < SIM_DAY_SLOTS) {
+        p->fired_days[p->fired++] = key;
+    }
+}
+
+static void on_expire(watering_sched_timer_t *timer, void *arg)
+{
+    time_t now = *(const time_t *)arg;
+
+    if (timer->kind == KIND_ZONE_OFF) {
+        sim_zone_t *z = &s_zones[timer->index];
+        if (z->on && z->off_at != 0 && z->off_at <= (int64_t)now) {
+            if (!s_jumps && z->off_at != (int64_t)now) {
+                SIM_FAIL("zone %u closed %lld s late", (unsigned)timer->index, (long long)(now - z->off_at));
+            }
+            z->on     = 0;
+            z->off_at = 0;
+        }
+        return;
+    }
+
+    sim_plan_t *p = &s_plans[timer->index];
+    if (p->next == 0 || p->next > now || watering_sched_timer_pending(&p->timer)) {
+        return;
+    }
+
+    long late = (long)(now - p->next);
+    p->last_day = watering_sched_day_key(p->next);
+
+    if (late > SIM_GRACE_S) {
+        s_missed++;
+        if (!s_jumps) {
+            SIM_FAIL("plan %u missed by %ld s on a stable clock", (unsigned)timer->index, late);
+        }
+    } else {
+        if (late > s_late_max) {
+            s_late_max = late;
+        }
+        if (!s_jumps && late != 0) {
+            SIM_FAIL("plan %u started %ld s late on a stable clock", (unsigned)timer->index, late);
+        }
+        s_runs++;
+        check_fire(timer->index, p->next);
+        zone_run(p->zone, now, p->duration_s);
+    }
+    plan_arm(timer->index, now);
+}
+
+static time_t local_midnight(int year, int mon, int mday)
+{
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_year  = year - 1900;
+    tm.tm_mon   = mon;
+    tm.tm_mday  = mday;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
+static void setup_plans(int count)
+{
+    /* 固定几条覆盖边界：夏令时空档 02:30、重复的 02:30 / 01:30、跨年 23:59、每天 00:00 */
+    static const watering_sched_rule_t fixed[] = {
+        { 0x7F, 2, 30 }, { 0x7F, 1, 30 }, { 0x7F, 23, 59 }, { 0x7F, 0, 0 },
+        { 0x01, 8, 0 },  { 0x40, 8, 0 },  { 0x41, 6, 15 },
+    };
+
+    memset(s_plans, 0, sizeof(s_plans));
+    memset(s_zones, 0, sizeof(s_zones));
+    s_plan_count = count;
+
+    for (int i = 0; i < count; i++) {
+        sim_plan_t *p = &s_plans[i];
+        if (i < (int)(sizeof(fixed) / sizeof(fixed[0]))) {
+            p->rule = fixed[i];
+        } else {
+            p->rule.days_mask = (uint8_t)(1 + sim_rand() % 0x7F);
+            p->rule.hour      = (uint8_t)(sim_rand() % 24);
+            p->rule.minute    = (uint8_t)(sim_rand() % 60);
+        }
+        p->zone        = (uint8_t)(i % SIM_ZONES);
+        p->duration_s  = (uint16_t)(5 + sim_rand() % 900);
+        p->timer.kind  = KIND_PLAN_START;
+        p->timer.index = (uint8_t)i;
+    }
+    for (int z = 0; z < SIM_ZONES; z++) {
+        s_zones[z].timer.kind  = KIND_ZONE_OFF;
+        s_zones[z].timer.index = (uint8_t)z;
+    }
+}
+
+/* 期望的触发次数：[start, end) 内每个掩码日期一次 */
+static long expected_runs(time_t start, time_t end)
+{
+    long total = 0;
+    for (int i = 0; i < s_plan_count; i++) {
+        time_t t = start;
+        int32_t last = 0;
+        for (;;) {
+            time_t next = watering_sched_next_fire(&s_plans[i].rule, t - 1, last);
+            if (next <= 0 || next >= end) {
+                break;
+            }
+            total++;
+            last = watering_sched_day_key(next);
+            t = next + 1;
+        }
+    }
+    return total;
+}
+
+/* 旧实现把 tm_wday（0=周日）直接当掩码下标，掩码 bit0 实际落在周日 */
+static long legacy_wrong_weekday(void)
+{
+    long wrong = 0, total = 0;
+    for (int i = 0; i < s_plan_count; i++) {
+        for (int bit = 0; bit < 7; bit++) {
+            if ((s_plans[i].rule.days_mask & (1 << bit)) == 0) {
+                continue;
+            }
+            total++;
+            int legacy_bit = (bit + 6) % 7;      ///< 旧实现 bit b 对应 tm_wday b，换算成周一起算的下标
+            if ((s_plans[i].rule.days_mask & (1 << legacy_bit)) == 0) {
+                wrong++;
+            }
+        }
+    }
+    return total ? wrong * 100 / total : 0;
+}
+
+static int run_year(const char *tz, int year, int count, int jumps)
+{
+    setenv("TZ", tz, 1);
+    tzset();
+
+    s_jumps = jumps;
+    s_runs = s_missed = s_late_max = s_errors = s_wakeups = 0;
+    setup_plans(count);
+
+    time_t start = local_midnight(year, 0, 1);
+    time_t end   = local_midnight(year + 1, 0, 1);
+
+    /* 从前一秒开始，元旦 00:00 的计划也计入 */
+    watering_sched_wheel_init(&s_wheel, (int64_t)start - 1);
+    for (int i = 0; i < count; i++) {
+        plan_arm(i, start - 1);
+    }
+
+    long  n_jumps = 0;
+    time_t now    = start - 1;
+    clock_t c0    = clock();
+
+    while (now < end) {
+        s_wakeups++;
+        watering_sched_wheel_advance(&s_wheel, (int64_t)now, on_expire, &now);
+
+        time_t next = (time_t)watering_sched_wheel_next(&s_wheel);
+        if (jumps && sim_rand() % 2000 == 0) {
+            /* 前跳 1 秒 ~ 2 小时，或回拨 1 秒 ~ 2 小时 */
+            long delta = 1 + (long)(sim_rand() % 7200);
+            if (sim_rand() & 1) {
+                delta = -delta;
+            }
+            n_jumps++;
+            if (delta < 0) {
+                for (int z = 0; z < SIM_ZONES; z++) {
+                    if (s_zones[z].off_at != 0) {
+                        s_zones[z].off_at += delta;
+                        watering_sched_wheel_add(&s_wheel, &s_zones[z].timer, s_zones[z].off_at);
+                    }
+                }
+                now += delta;
+                for (int i = 0; i < count; i++) {
+                    plan_arm(i, now);
+                }
+                continue;
+            }
+            now += delta;
+            continue;
+        }
+        now = next;
+    }
+
+    double ms = (double)(clock() - c0) * 1000.0 / CLOCKS_PER_SEC;
+
+    if (!jumps) {
+        long want = expected_runs(start, end);
+        if (want != s_runs) {
+            SIM_FAIL("runs %ld, expected %ld", s_runs, want);
+        }
+    }
+
+    printf("%-28s %s: runs %6ld  missed %4ld  max late %3ld s  jumps %4ld  wakeups %7ld  %6.1f ms  %s\n",
+           tz, jumps ? "jumps " : "stable", s_runs, s_missed, s_late_max, n_jumps, s_wakeups, ms,
+           s_errors ? "FAIL" : "ok");
+    return s_errors ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 32;
+    int year  = argc > 2 ? atoi(argv[2]) : 2025;
+    if (count < 8) {
+        count = 8;
+    }
+    if (count > SIM_MAX_PLANS) {
+        count = SIM_MAX_PLANS;
+    }
+
+    static const char *zones[] = {
+        "CST-8",
+        "CET-1CEST,M3.5.0,M10.5.0/3",
+        "EST5EDT,M3.2.0,M11.1.0",
+        "AEST-10AEDT,M10.1.0,M4.1.0/3",
+    };
+
+    int fails = 0;
+    for (size_t i = 0; i < sizeof(zones) / sizeof(zones[0]); i++) {
+        fails += run_year(zones[i], year, count, 0);
+        fails += run_year(zones[i], year, count, 1);
+    }
+
+    printf("plans: %d, legacy weekday mapping fires on a wrong weekday for %ld%% of masked days\n",
+           count, legacy_wrong_weekday());
+    printf("%s\n", fails ? "FAILED" : "all checks passed");
+    return fails ? 1 : 0;
+}
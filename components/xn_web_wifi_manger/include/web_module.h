@@ -147,5 +147,17 @@ typedef struct {
  */
 esp_err_t web_module_init(const web_module_config_t *config);
 
+/**
+ * @brief 挂载网页资源 SPIFFS 分区（label: "wifi_spiffs"）
+ *
+ * web_module_init 内部会自动调用；启动编排时可提前单独调用，
+ * 避免与其它模块并行挂载 SPIFFS 产生竞争。
+ *
+ * @return
+ *  - ESP_OK     : 挂载成功或已挂载
+ *  - 其它 esp_err_t : SPIFFS 挂载失败
+ */
+esp_err_t web_module_mount_storage(void);
+
 #endif /* WEB_MODULE_H */
 
@@ -19,13 +19,13 @@
 #include "esp_err.h"
 
 /**
- * @brief WiFi 管理状态机单步运行周期（单位：ms）
+ * @brief 整轮失败后首次重试的退避上界（单位：ms）
  *
- * 管理任务会按该间隔周期性调用内部状态机：
- * - 间隔过小：状态更新更及时，但占用更多 CPU；
- * - 间隔过大：重连/轮询响应变慢。
+ * 管理任务不再周期唤醒，只在 WiFi 事件或退避定时器到期时运行状态机：
+ * - 单条配置连接失败：立即尝试下一条；
+ * - 整轮失败：按指数退避（加抖动）等待，上界从该值起每轮翻倍，直到 reconnect_interval_ms。
  */
-#define WIFI_MANAGE_STEP_INTERVAL_MS 1000
+#define WIFI_MANAGE_RECONNECT_BASE_MS 1000
 
 /**
  * @brief WiFi 管理层抽象的连接状态
@@ -55,7 +55,7 @@ typedef void (*wifi_event_cb_t)(wifi_manage_state_t state);
  */
 typedef struct {
     int  max_retry_count;          ///< 单个 AP 最多连续重试次数（<=0 表示只尝试一次）
-    int  reconnect_interval_ms;    ///< 整轮失败后等待多久再自动重试；<0 表示关闭自动重试
+    int  reconnect_interval_ms;    ///< 整轮失败后重试退避上界的上限；<0 表示关闭自动重试
     char ap_ssid[32];              ///< 配网 AP SSID（最长 31 字符，需手动保证 '\0' 结尾）
     char ap_password[64];          ///< 配网 AP 密码（8~63 字符，留 1 字节给 '\0'）
     char ap_ip[16];                ///< 配网 AP 网口 IP 地址，如 "192.168.4.1"
@@ -91,7 +91,7 @@ typedef struct {
  *
  * 功能概览：
  * - 初始化内部 WiFi / 存储 / Web 配网子模块；
- * - 创建管理任务并启动状态机；
+ * - 创建管理任务并启动状态机（事件驱动，并接入联网监督 conn_supervisor）；
  * - 根据配置启动 STA + AP 模式。
  *
  * @param config 若为 NULL，则使用 @ref WIFI_MANAGE_DEFAULT_CONFIG
@@ -102,4 +102,14 @@ typedef struct {
  */
 esp_err_t wifi_manage_init(const wifi_manage_config_t *config);
 
+/**
+ * @brief 获取当前 WiFi 管理状态
+ *
+ * 状态先更新再调用 wifi_event_cb，晚于 WiFi 启动的模块（如显示）可据此补齐错过的事件。
+ * 可在任意任务中调用，未初始化时返回 WIFI_MANAGE_STATE_DISCONNECTED。
+ *
+ * @return 当前状态（见 @ref wifi_manage_state_t）
+ */
+wifi_manage_state_t wifi_manage_get_state(void);
+
 #endif /* XN_WIFI_MANAGE_H */
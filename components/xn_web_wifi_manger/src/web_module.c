@@ -22,11 +22,15 @@
 #include "esp_spiffs.h"
 #include "esp_http_server.h"
 
+#include "asset_loader.h"
 #include "web_module.h"
 
 /* 日志 TAG */
 static const char *TAG = "web_module";
 
+/* 等待资源加载器预读一块数据的超时时间 */
+#define WEB_FILE_READ_TIMEOUT_MS 2000
+
 /* Web 模块配置与状态 */
 static bool               s_web_inited = false;
 static web_module_config_t s_web_cfg;        /* 保存一份配置副本 */
@@ -95,7 +99,7 @@ static void web_url_decode_inplace(char *str)
  * - base_path:  "/spiffs"（HTTP 处理函数按此路径访问文件）
  * - max_files:  4（当前仅三个静态文件，预留 1 个）
  */
-static esp_err_t web_module_mount_spiffs(void)
+esp_err_t web_module_mount_storage(void)
 {
     esp_vfs_spiffs_conf_t conf = {
         .base_path              = "/spiffs",
@@ -123,6 +127,9 @@ static esp_err_t web_module_mount_spiffs(void)
 /**
  * @brief 以分块响应的方式发送一个静态文件
  *
+ * 文件由资源加载器在后台预读，httpd 工作线程只等待预读队列并发送，
+ * 读 Flash 与网络发送重叠进行，工作线程不直接阻塞在文件系统上。
+ *
  * @param req          HTTP 请求对象
  * @param file_path    文件在 SPIFFS 上的完整路径（如 "/spiffs/index.html"）
  * @param content_type Content-Type 头部值
@@ -131,9 +138,14 @@ static esp_err_t web_module_serve_file(httpd_req_t *req,
                                        const char  *file_path,
                                        const char  *content_type)
 {
-    FILE *f = fopen(file_path, "r");
-    if (f == NULL) {
+    asset_stream_handle_t stream = NULL;
+    asset_chunk_t         chunk;
+
+    if (asset_loader_open(file_path, &stream) != ESP_OK ||
+        asset_loader_stream_read(stream, &chunk, pdMS_TO_TICKS(WEB_FILE_READ_TIMEOUT_MS)) != ESP_OK ||
+        chunk.err != ESP_OK) {
         ESP_LOGE(TAG, "open file failed: %s", file_path);
+        asset_loader_close(stream);
         httpd_resp_send_err(req,
                             HTTPD_500_INTERNAL_SERVER_ERROR,
                             "open file failed");
@@ -143,17 +155,36 @@ static esp_err_t web_module_serve_file(httpd_req_t *req,
     httpd_resp_set_type(req, content_type);
     httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
 
-    char  buf[512];
-    size_t n;
-    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
-        if (httpd_resp_send_chunk(req, buf, n) != ESP_OK) {
-            fclose(f);
-            httpd_resp_sendstr_chunk(req, NULL); /* 结束分块 */
-            return ESP_FAIL;
+    esp_err_t ret = ESP_OK;
+    while (1) {
+        bool last = chunk.last;
+        if (chunk.len > 0 &&
+            httpd_resp_send_chunk(req, (const char *)chunk.data, chunk.len) != ESP_OK) {
+            ret = ESP_FAIL;
+        }
+        asset_loader_stream_release(stream, &chunk);
+        if (ret != ESP_OK || last) {
+            break;
+        }
+
+        if (asset_loader_stream_read(stream, &chunk, pdMS_TO_TICKS(WEB_FILE_READ_TIMEOUT_MS)) != ESP_OK) {
+            ESP_LOGE(TAG, "read file timeout: %s", file_path);
+            ret = ESP_ERR_TIMEOUT;
+            break;
         }
+        if (chunk.err != ESP_OK) {
+            ESP_LOGE(TAG, "read file failed: %s", file_path);
+            ret = chunk.err;
+            break;
+        }
+    }
+    asset_loader_close(stream);
+
+    if (ret != ESP_OK) {
+        httpd_resp_sendstr_chunk(req, NULL); /* 结束分块 */
+        return ESP_FAIL;
     }
 
-    fclose(f);
     httpd_resp_send_chunk(req, NULL, 0); /* 告知响应结束 */
     return ESP_OK;
 }
@@ -703,7 +734,7 @@ esp_err_t web_module_init(const web_module_config_t *config)
         return ESP_OK;
     }
 
-    esp_err_t ret = web_module_mount_spiffs();
+    esp_err_t ret = web_module_mount_storage();
     if (ret != ESP_OK) {
         return ret;
     }
@@ -23,6 +23,8 @@
 #include "storage_module.h"
 #include "web_module.h"
 #include "xn_wifi_manage.h"
+#include "conn_supervisor.h"
+#include "conn_backoff.h"
 
 /* 日志 TAG（如需日志输出，使用 ESP_LOGx(TAG, ...)） */
 static const char *TAG = "wifi_manage";
@@ -37,7 +39,7 @@ static TaskHandle_t         s_wifi_manage_task  = NULL;
 /* 统一更新状态并通知上层回调（若配置了 wifi_event_cb） */
 static void wifi_manage_notify_state(wifi_manage_state_t new_state)
 {
-    s_wifi_manage_state = new_state;
+    __atomic_store_n(&s_wifi_manage_state, new_state, __ATOMIC_RELEASE);
 
     if (s_wifi_cfg.wifi_event_cb) {
         s_wifi_cfg.wifi_event_cb(new_state);
@@ -45,9 +47,35 @@ static void wifi_manage_notify_state(wifi_manage_state_t new_state)
 }
 
 /* 遍历已保存 WiFi 时的状态 */
-static bool       s_wifi_connecting   = false;  /* 当前是否有一次 STA 连接正在进行 */
-static uint8_t    s_wifi_try_index    = 0;      /* 本轮遍历中，正在尝试的 WiFi 下标 */
-static TickType_t s_connect_failed_ts = 0;      /* 最近一次全轮尝试失败的时间戳 */
+static bool                  s_wifi_connecting = false;  /* 当前是否有一次 STA 连接正在进行 */
+static uint8_t               s_wifi_try_index  = 0;      /* 本轮遍历中，正在尝试的 WiFi 下标 */
+static volatile bool         s_retry_due       = false;  /* 整轮失败后的退避已到期 */
+static conn_backoff_handle_t s_wifi_backoff    = NULL;   /* 整轮失败后的重试退避 */
+
+/* 唤醒管理任务执行一次状态机 */
+static void wifi_manage_kick(void)
+{
+    if (s_wifi_manage_task != NULL) {
+        xTaskNotifyGive(s_wifi_manage_task);
+    }
+}
+
+/* 退避到期（esp_timer 任务中执行，只置标志并唤醒管理任务） */
+static void wifi_manage_on_backoff(void *ctx)
+{
+    (void)ctx;
+    s_retry_due = true;
+    wifi_manage_kick();
+}
+
+/* 整轮失败后按退避安排下一轮；reconnect_interval_ms < 0 表示关闭自动重试 */
+static void wifi_manage_schedule_retry(void)
+{
+    if (s_wifi_cfg.reconnect_interval_ms < 0) {
+        return;
+    }
+    (void)conn_backoff_schedule(s_wifi_backoff, NULL);
+}
 
 /* -------------------- Web 回调：查询当前 WiFi 状态 -------------------- */
 /**
@@ -375,7 +403,8 @@ static void wifi_manage_on_wifi_event(wifi_module_event_t event)
         wifi_manage_notify_state(WIFI_MANAGE_STATE_CONNECTED);
         s_wifi_connecting   = false;
         s_wifi_try_index    = 0;      /* 下次自动重连从首选 WiFi 开始 */
-        s_connect_failed_ts = 0;
+        s_retry_due         = false;
+        conn_backoff_reset(s_wifi_backoff);
 
         /* 将当前配置上报给存储模块，用于调整优先级等策略 */
         wifi_config_t current_cfg = {0};
@@ -386,16 +415,18 @@ static void wifi_manage_on_wifi_event(wifi_module_event_t event)
     }
 
     case WIFI_MODULE_EVENT_STA_DISCONNECTED:
-        /* 连接断开，等待管理任务按策略进行重连 */
+        /* 连接断开，立即唤醒管理任务从首选 WiFi 开始重连 */
         wifi_manage_notify_state(WIFI_MANAGE_STATE_DISCONNECTED);
         s_wifi_connecting   = false;
         s_wifi_try_index    = 0;
+        wifi_manage_kick();
         break;
 
     case WIFI_MODULE_EVENT_STA_CONNECT_FAILED:
-        /* 本次尝试失败，简单移动到下一条配置 */
+        /* 本次尝试失败，立即尝试下一条配置 */
         s_wifi_connecting = false;
         s_wifi_try_index++;
+        wifi_manage_kick();
         break;
 
     default:
@@ -409,6 +440,7 @@ static void wifi_manage_on_wifi_event(wifi_module_event_t event)
  * @brief 单步执行 WiFi 管理状态机
  *
  * 按当前状态决定是否发起连接、切换状态或等待重试。
+ * 仅在被唤醒时执行：WiFi 事件、退避到期、跳过一条配置或初始化。
  */
 static void wifi_manage_step(void)
 {
@@ -429,14 +461,16 @@ static void wifi_manage_step(void)
         /* 为避免在任务栈上分配大数组，这里通过堆申请临时缓冲区 */
         wifi_config_t *list = (wifi_config_t *)malloc(max_num * sizeof(wifi_config_t));
         if (list == NULL) {
-            /* 内存不足时保留在断开状态，等待下次循环再尝试 */
+            /* 内存不足时保留在断开状态，按退避稍后再唤醒 */
+            (void)conn_backoff_schedule(s_wifi_backoff, NULL);
             break;
         }
 
         uint8_t count = 0;
 
         if (wifi_storage_load_all(list, &count) != ESP_OK || count == 0) {
-            /* 没有可用配置，交由上层决定是否启用纯 AP 配网等逻辑 */
+            /* 没有可用配置，交由上层决定是否启用纯 AP 配网等逻辑；
+             * Web / MQTT 配网发起连接后会产生 WiFi 事件再次唤醒 */
             free(list);
             break;
         }
@@ -444,9 +478,9 @@ static void wifi_manage_step(void)
         if (s_wifi_try_index >= count) {
             /* 本轮所有配置均尝试过，仍未连接成功，进入“整轮失败”状态 */
             wifi_manage_notify_state(WIFI_MANAGE_STATE_CONNECT_FAILED);
-            s_connect_failed_ts = xTaskGetTickCount();
             s_wifi_try_index    = 0;
             s_wifi_connecting   = false;
+            wifi_manage_schedule_retry();
             free(list);
             break;
         }
@@ -455,6 +489,7 @@ static void wifi_manage_step(void)
         if (cfg->sta.ssid[0] == '\0') {
             /* 跳过无效 SSID */
             s_wifi_try_index++;
+            wifi_manage_kick();
             free(list);
             break;
         }
@@ -469,6 +504,7 @@ static void wifi_manage_step(void)
             s_wifi_connecting = true;
         } else {
             s_wifi_try_index++;
+            wifi_manage_kick();
         }
 
         free(list);
@@ -479,28 +515,16 @@ static void wifi_manage_step(void)
         /* 已连接状态下，当前不做周期性操作，保持静默 */
         break;
 
-    case WIFI_MANAGE_STATE_CONNECT_FAILED: {
-        /* 一轮全部失败，根据配置的重连间隔决定何时重新遍历 */
-
-        if (s_wifi_cfg.reconnect_interval_ms < 0) {
-            /* 小于 0 表示关闭自动重连，保持在失败状态 */
-            break;
-        }
-
-        TickType_t now   = xTaskGetTickCount();
-        TickType_t delta = now - s_connect_failed_ts;
-        TickType_t need  = pdMS_TO_TICKS((s_wifi_cfg.reconnect_interval_ms <= 0)
-                                             ? 0
-                                             : s_wifi_cfg.reconnect_interval_ms);
-
-        if (delta >= need) {
-            /* 到达重试时间，从头开始新一轮遍历 */
-            s_wifi_try_index    = 0;
-            s_wifi_connecting   = false;
+    case WIFI_MANAGE_STATE_CONNECT_FAILED:
+        /* 一轮全部失败，等待退避定时器到期后从头开始新一轮遍历 */
+        if (s_retry_due) {
+            s_retry_due       = false;
+            s_wifi_try_index  = 0;
+            s_wifi_connecting = false;
             wifi_manage_notify_state(WIFI_MANAGE_STATE_DISCONNECTED);
+            wifi_manage_kick();
         }
         break;
-    }
 
     default:
         /* 理论上不应到达，保留作防护 */
@@ -510,15 +534,15 @@ static void wifi_manage_step(void)
 
 /* -------------------- WiFi 管理任务 -------------------- */
 /**
- * @brief 管理任务：周期性驱动状态机运行
+ * @brief 管理任务：阻塞等待任务通知，被唤醒时驱动一次状态机（空闲时不唤醒 CPU）
  */
 static void wifi_manage_task(void *arg)
 {
     (void)arg;
 
     for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
         wifi_manage_step();
-        vTaskDelay(pdMS_TO_TICKS(WIFI_MANAGE_STEP_INTERVAL_MS));
     }
 }
 
@@ -532,6 +556,8 @@ static void wifi_manage_task(void *arg)
  * 3. 初始化存储模块（保存常用 WiFi）
  * 4. 初始化 Web 配网模块（HTTP 服务与回调）
  * 5. 创建管理任务，启动状态机
+ *
+ * 联网监督在 WiFi 启动前初始化，以便记录上电后首次连接的 STA_START 时刻。
  */
 esp_err_t wifi_manage_init(const wifi_manage_config_t *config)
 {
@@ -542,6 +568,26 @@ esp_err_t wifi_manage_init(const wifi_manage_config_t *config)
         s_wifi_cfg = *config;
     }
 
+    /* ---- 初始化联网监督与整轮失败退避 ---- */
+    esp_err_t ret = conn_supervisor_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    if (s_wifi_backoff == NULL) {
+        conn_backoff_config_t backoff_cfg = CONN_BACKOFF_DEFAULT_CONFIG();
+        backoff_cfg.name    = "wifi_retry";
+        backoff_cfg.base_ms = WIFI_MANAGE_RECONNECT_BASE_MS;
+        backoff_cfg.max_ms  = (s_wifi_cfg.reconnect_interval_ms > 0)
+                                  ? (uint32_t)s_wifi_cfg.reconnect_interval_ms
+                                  : 0;
+        backoff_cfg.cb      = wifi_manage_on_backoff;
+        s_wifi_backoff = conn_backoff_create(&backoff_cfg);
+        if (s_wifi_backoff == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
     /* ---- 初始化 WiFi 模块 ---- */
     wifi_module_config_t wifi_cfg = WIFI_MODULE_DEFAULT_CONFIG();
 
@@ -568,7 +614,7 @@ esp_err_t wifi_manage_init(const wifi_manage_config_t *config)
     wifi_cfg.event_cb = wifi_manage_on_wifi_event;
 
     /* 初始化底层 WiFi 模块 */
-    esp_err_t ret = wifi_module_init(&wifi_cfg);
+    ret = wifi_module_init(&wifi_cfg);
     if (ret != ESP_OK) {
         return ret;
     }
@@ -626,5 +672,13 @@ esp_err_t wifi_manage_init(const wifi_manage_config_t *config)
         }
     }
 
+    /* 立即运行一次状态机，按已保存列表发起首次连接 */
+    wifi_manage_kick();
+
     return ESP_OK;
 }
+
+wifi_manage_state_t wifi_manage_get_state(void)
+{
+    return __atomic_load_n(&s_wifi_manage_state, __ATOMIC_ACQUIRE);
+}
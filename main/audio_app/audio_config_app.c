@@ -9,6 +9,7 @@
  * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved. 
  */
 #include "audio_config_app.h"
+#include "voice_cmd_app.h"
 
 /**
  * @brief 构建音频管理器配置
@@ -63,6 +64,9 @@ void audio_config_app_build(audio_mgr_config_t *cfg,
     cfg->wakeup_config.wakeup_timeout_ms = 8000;     // 唤醒超时 8 秒
     cfg->wakeup_config.wakeup_end_delay_ms = 1200;   // 说话结束延迟 1.2 秒
 
+    // ========== 本地命令词配置 ==========
+    voice_cmd_app_fill_config(&cfg->command_config);  // 浇花命令表，与唤醒词共用 model 分区
+
     // ========== VAD（语音活动检测）配置 ==========
     cfg->vad_config.enabled = true;           // 启用 VAD
     cfg->vad_config.vad_mode = 2;             // VAD 模式 2（中等灵敏度）
@@ -0,0 +1,178 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-02 16:20:05
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-02 16:20:05
+ * @FilePath: \xn_esp32_coze_chat_watering\main\audio_app\audio_health_app.c
+ * @Description: 音频健康计数上报 - 汇总各模块计数并通过日志 / MQTT 周期发布
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+
+#include "audio_health.h"
+#include "audio_manager.h"
+#include "coze_chat.h"
+#include "mqtt_outbox.h"
+#include "web_mqtt_manager.h"
+#include "audio_app/audio_health_app.h"
+
+static const char *TAG = "audio_health_app";
+
+#define AUDIO_HEALTH_APP_PERIOD_MS  (30 * 1000)
+
+extern coze_chat_handle_t coze_chat_get_handle(void);
+
+/**
+ * Coze 模块重新初始化后内部计数会归零，这里记录上次读到的值，
+ * 发现回退时把旧值累加到基数上，保证统一计数块始终单调递增。
+ */
+typedef struct {
+    uint32_t base;
+    uint32_t last;
+} audio_health_app_mono_t;
+
+static audio_health_app_mono_t s_opus_errors;
+static audio_health_app_mono_t s_uplink_overwrite;
+
+static uint32_t audio_health_app_mono_update(audio_health_app_mono_t *m, uint32_t value)
+{
+    if (value < m->last) {
+        m->base += m->last;
+    }
+    m->last = value;
+    return m->base + value;
+}
+
+/**
+ * @brief 把 Coze 链路计数同步进统一计数块
+ */
+static void audio_health_app_sync_coze(void *user_ctx)
+{
+    (void)user_ctx;
+
+    coze_chat_handle_t handle = coze_chat_get_handle();
+    if (handle == NULL) {
+        return;
+    }
+
+    coze_chat_audio_stats_t stats = {0};
+    if (coze_chat_get_audio_stats(handle, &stats) != ESP_OK) {
+        return;
+    }
+
+    audio_health_set(AUDIO_HEALTH_OPUS_DECODE_ERRORS,
+                     audio_health_app_mono_update(&s_opus_errors, stats.opus_decode_errors));
+    audio_health_set(AUDIO_HEALTH_UPLINK_OVERWRITE_BYTES,
+                     audio_health_app_mono_update(&s_uplink_overwrite, stats.uplink_overwrite_bytes));
+}
+
+/**
+ * @brief 有异常增量时打印一行紧凑日志（峰值类计数项不参与判断）
+ */
+static void audio_health_app_log(const audio_health_snapshot_t *delta)
+{
+    char line[256];
+    int  pos = 0;
+
+    for (int i = 0; i < AUDIO_HEALTH_MAX; i++) {
+        if (i == AUDIO_HEALTH_AFE_RING_FILL_MAX_PCT || delta->counters[i] == 0) {
+            continue;
+        }
+        int n = snprintf(line + pos, sizeof(line) - pos, " %s=+%u",
+                         audio_health_counter_name((audio_health_counter_t)i),
+                         (unsigned)delta->counters[i]);
+        if (n <= 0 || n >= (int)(sizeof(line) - pos)) {
+            break;
+        }
+        pos += n;
+    }
+
+    if (pos > 0) {
+        ESP_LOGW(TAG, "⚠️ 最近 %lld ms 音频异常:%s (afe_fill_max=%u%%)",
+                 (long long)delta->timestamp_ms, line,
+                 (unsigned)delta->counters[AUDIO_HEALTH_AFE_RING_FILL_MAX_PCT]);
+    }
+}
+
+/**
+ * @brief 通过 MQTT 上报累计值、增量与负载上下文
+ */
+static void audio_health_app_publish(const audio_health_snapshot_t *total,
+                                     const audio_health_snapshot_t *delta)
+{
+    const char *client_id = web_mqtt_manager_get_client_id();
+    if (client_id == NULL || client_id[0] == '\0') {
+        return;
+    }
+
+    char topic[128];
+    int  n = snprintf(topic,
+                      sizeof(topic),
+                      "%s/audio/%s/health",
+                      WEB_MQTT_UPLINK_BASE_TOPIC,
+                      client_id);
+    if (n <= 0 || n >= (int)sizeof(topic)) {
+        return;
+    }
+
+    playback_mixer_stats_t mixer = {0};
+    (void)audio_manager_get_mixer_stats(&mixer);
+
+    char json[1024];
+    int  pos = snprintf(json, sizeof(json),
+                        "{\"uptime_ms\":%lld,\"period_ms\":%lld,\"total\":{",
+                        (long long)total->timestamp_ms,
+                        (long long)delta->timestamp_ms);
+
+    for (int i = 0; i < AUDIO_HEALTH_MAX && pos < (int)sizeof(json); i++) {
+        pos += snprintf(json + pos, sizeof(json) - pos, "%s\"%s\":%u",
+                        i ? "," : "",
+                        audio_health_counter_name((audio_health_counter_t)i),
+                        (unsigned)total->counters[i]);
+    }
+    if (pos < (int)sizeof(json)) {
+        pos += snprintf(json + pos, sizeof(json) - pos, "},\"delta\":{");
+    }
+    for (int i = 0; i < AUDIO_HEALTH_MAX && pos < (int)sizeof(json); i++) {
+        pos += snprintf(json + pos, sizeof(json) - pos, "%s\"%s\":%u",
+                        i ? "," : "",
+                        audio_health_counter_name((audio_health_counter_t)i),
+                        (unsigned)delta->counters[i]);
+    }
+    if (pos < (int)sizeof(json)) {
+        pos += snprintf(json + pos, sizeof(json) - pos,
+                        "},\"mix_cpu_permille\":%u,\"heap_internal\":%u,\"heap_psram\":%u}",
+                        (unsigned)mixer.mix_cpu_permille,
+                        (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+                        (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    }
+    if (pos >= (int)sizeof(json)) {
+        ESP_LOGW(TAG, "健康上报内容超长，已丢弃");
+        return;
+    }
+
+    (void)mqtt_outbox_publish(topic, json, pos, 0, false, MQTT_OUTBOX_PRIO_LOW, "audio_health");
+}
+
+static void audio_health_app_on_publish(const audio_health_snapshot_t *total,
+                                        const audio_health_snapshot_t *delta,
+                                        void *user_ctx)
+{
+    (void)user_ctx;
+
+    audio_health_app_log(delta);
+    audio_health_app_publish(total, delta);
+}
+
+esp_err_t audio_health_app_start(void)
+{
+    audio_health_set_sync_hook(audio_health_app_sync_coze, NULL);
+    return audio_health_start_publisher(AUDIO_HEALTH_APP_PERIOD_MS,
+                                        audio_health_app_on_publish, NULL);
+}
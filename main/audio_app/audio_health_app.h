@@ -0,0 +1,22 @@
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 启动音频健康计数的周期上报
+ *
+ * 每个周期把 Coze 链路自行维护的计数（Opus 解码错误、上行覆盖字节）
+ * 同步进统一计数块，有异常增量时打印一行日志，并在 MQTT 可用时上报到
+ * xn/esp/audio/<device_id>/health。
+ *
+ * @return ESP_OK 成功，其他值见 audio_health_start_publisher
+ */
+esp_err_t audio_health_app_start(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,284 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-12 15:06:18
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-12 15:06:18
+ * @FilePath: \xn_esp32_coze_chat_watering\main\audio_app\voice_cmd_app.c
+ * @Description: 本地语音命令 - MultiNet 命令词直达浇花动作，不经过 Coze 云端
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "audio_prompt.h"
+#include "mqtt_outbox.h"
+#include "web_mqtt_manager.h"
+#include "watering_sched.h"
+#include "mqtt_app/watering_app.h"
+#include "lottie_app/lottie_app.h"
+#include "audio_app/voice_cmd_app.h"
+
+static const char *TAG = "voice_cmd_app";
+
+/* "开始浇水" 不带时长时的默认浇水时长 */
+#ifndef VOICE_CMD_DEFAULT_WATER_S
+#define VOICE_CMD_DEFAULT_WATER_S 60
+#endif
+
+#define VOICE_CMD_FRAME_BUDGET_US  32000                ///< 一个 AFE 帧（512 点 @16kHz）
+#define VOICE_CMD_CLOUD_WINDOW_US  (30LL * 1000 * 1000) ///< 超过该时长才到的回复不计入云端延迟
+
+typedef enum {
+    VOICE_CMD_WATER = 0,
+    VOICE_CMD_WATER_30S,
+    VOICE_CMD_WATER_1MIN,
+    VOICE_CMD_WATER_5MIN,
+    VOICE_CMD_STOP,
+    VOICE_CMD_STATUS,
+    VOICE_CMD_MAX,
+} voice_cmd_id_t;
+
+typedef enum {
+    VOICE_CMD_ACTION_ON = 0,
+    VOICE_CMD_ACTION_OFF,
+    VOICE_CMD_ACTION_STATUS,
+} voice_cmd_action_t;
+
+typedef struct {
+    const char        *name;        ///< 上报用名称
+    voice_cmd_action_t action;
+    uint8_t            zone;
+    uint32_t           duration_s;  ///< 开启时长（仅 ON）
+} voice_cmd_t;
+
+static const voice_cmd_t s_cmds[VOICE_CMD_MAX] = {
+    [VOICE_CMD_WATER]      = { "water",      VOICE_CMD_ACTION_ON,     0, VOICE_CMD_DEFAULT_WATER_S },
+    [VOICE_CMD_WATER_30S]  = { "water_30s",  VOICE_CMD_ACTION_ON,     0, 30 },
+    [VOICE_CMD_WATER_1MIN] = { "water_1min", VOICE_CMD_ACTION_ON,     0, 60 },
+    [VOICE_CMD_WATER_5MIN] = { "water_5min", VOICE_CMD_ACTION_ON,     0, 300 },
+    [VOICE_CMD_STOP]       = { "stop",       VOICE_CMD_ACTION_OFF,    0, 0 },
+    [VOICE_CMD_STATUS]     = { "status",     VOICE_CMD_ACTION_STATUS, 0, 0 },
+};
+
+/* 中文 MultiNet 命令词用拼音，同一命令可以有多个说法 */
+static const audio_mgr_command_word_t s_words[] = {
+    { VOICE_CMD_WATER,      "kai shi jiao shui" },      ///< 开始浇水
+    { VOICE_CMD_WATER,      "da kai shui beng" },       ///< 打开水泵
+    { VOICE_CMD_WATER_30S,  "jiao shui san shi miao" }, ///< 浇水三十秒
+    { VOICE_CMD_WATER_1MIN, "jiao shui yi fen zhong" }, ///< 浇水一分钟
+    { VOICE_CMD_WATER_5MIN, "jiao shui wu fen zhong" }, ///< 浇水五分钟
+    { VOICE_CMD_STOP,       "ting zhi jiao shui" },     ///< 停止浇水
+    { VOICE_CMD_STOP,       "guan bi shui beng" },      ///< 关闭水泵
+    { VOICE_CMD_STATUS,     "jiao shui zhuang tai" },   ///< 浇水状态
+};
+
+static portMUX_TYPE      s_lock = portMUX_INITIALIZER_UNLOCKED;
+static voice_cmd_stats_t s_stats;
+static int64_t           s_cloud_submit_us;             ///< 0 表示没有等待中的云端回复
+static bool              s_prompt_ready;
+
+static void voice_cmd_latency_add(voice_cmd_latency_t *l, uint32_t v)
+{
+    if (l->count == 0 || v < l->min) {
+        l->min = v;
+    }
+    if (v > l->max) {
+        l->max = v;
+    }
+    l->sum += v;
+    l->count++;
+}
+
+static uint32_t voice_cmd_latency_avg(const voice_cmd_latency_t *l)
+{
+    return l->count ? (uint32_t)(l->sum / l->count) : 0;
+}
+
+void voice_cmd_app_fill_config(audio_mgr_command_config_t *cfg)
+{
+    if (cfg == NULL) {
+        return;
+    }
+    cfg->enabled    = true;
+    cfg->language   = "cn";
+    cfg->timeout_ms = 6000;
+    cfg->words      = s_words;
+    cfg->word_count = sizeof(s_words) / sizeof(s_words[0]);
+}
+
+esp_err_t voice_cmd_app_init(void)
+{
+    esp_err_t ret = audio_prompt_init();
+    s_prompt_ready = (ret == ESP_OK);
+    if (!s_prompt_ready) {
+        ESP_LOGW(TAG, "prompt store unavailable, voice commands run without confirmation: %s",
+                 esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief 上报一次命令执行结果与延迟对比
+ */
+static void voice_cmd_publish(const voice_cmd_t *cmd, const audio_mgr_event_t *event, esp_err_t ret,
+                              bool on, uint32_t today_s, uint32_t local_us,
+                              const voice_cmd_stats_t *stats)
+{
+    const char *client_id = web_mqtt_manager_get_client_id();
+    if (client_id == NULL || client_id[0] == '\0') {
+        return;
+    }
+
+    char topic[128];
+    int  n = snprintf(topic,
+                      sizeof(topic),
+                      "%s/voice/%s/command",
+                      WEB_MQTT_UPLINK_BASE_TOPIC,
+                      client_id);
+    if (n <= 0 || n >= (int)sizeof(topic)) {
+        return;
+    }
+
+    char json[320];
+    n = snprintf(json,
+                 sizeof(json),
+                 "{\"cmd\":\"%s\",\"id\":%d,\"prob\":%.2f,\"zone\":%u,\"ok\":%s,\"on\":%s,\"today_s\":%u,"
+                 "\"local_us\":%u,\"local_avg_us\":%u,\"local_max_us\":%u,\"over_budget\":%u,"
+                 "\"cloud_avg_ms\":%u,\"cloud_min_ms\":%u,\"cloud_n\":%u}",
+                 cmd->name,
+                 event->data.command.command_id,
+                 (double)event->data.command.prob,
+                 (unsigned)cmd->zone,
+                 ret == ESP_OK ? "true" : "false",
+                 on ? "true" : "false",
+                 (unsigned)today_s,
+                 (unsigned)local_us,
+                 (unsigned)voice_cmd_latency_avg(&stats->local_us),
+                 (unsigned)stats->local_us.max,
+                 (unsigned)stats->over_budget,
+                 (unsigned)voice_cmd_latency_avg(&stats->cloud_ms),
+                 (unsigned)stats->cloud_ms.min,
+                 (unsigned)stats->cloud_ms.count);
+    if (n <= 0 || n >= (int)sizeof(json)) {
+        return;
+    }
+
+    /* 每条命令一条记录，不合并 */
+    (void)mqtt_outbox_publish(topic, json, n, 1, false, MQTT_OUTBOX_PRIO_NORMAL, NULL);
+}
+
+/**
+ * @brief 在字幕区显示执行结果（本地命令没有 TTS 回复）
+ */
+static void voice_cmd_show(const voice_cmd_t *cmd, esp_err_t ret, bool on, uint32_t today_s)
+{
+    char text[64];
+
+    if (ret != ESP_OK) {
+        snprintf(text, sizeof(text), "浇花控制暂不可用");
+    } else if (cmd->action == VOICE_CMD_ACTION_ON) {
+        snprintf(text, sizeof(text), "开始浇水 %u 秒", (unsigned)cmd->duration_s);
+    } else if (cmd->action == VOICE_CMD_ACTION_OFF) {
+        snprintf(text, sizeof(text), "已停止浇水");
+    } else {
+        snprintf(text, sizeof(text), "%s，今日已浇 %u 秒", on ? "正在浇水" : "水泵已关闭", (unsigned)today_s);
+    }
+
+    lottie_app_subtitle_show(text);
+}
+
+void voice_cmd_app_handle(const audio_mgr_event_t *event)
+{
+    if (event == NULL || event->type != AUDIO_MGR_EVENT_COMMAND_DETECTED) {
+        return;
+    }
+
+    int id = event->data.command.command_id;
+    if (id < 0 || id >= VOICE_CMD_MAX) {
+        ESP_LOGW(TAG, "unknown command id %d", id);
+        return;
+    }
+    const voice_cmd_t *cmd = &s_cmds[id];
+
+    /* 先执行动作再做其他事：延迟只统计识别到动作生效 */
+    esp_err_t ret = ESP_OK;
+    if (cmd->action == VOICE_CMD_ACTION_ON) {
+        ret = watering_app_set_zone(cmd->zone, true, cmd->duration_s);
+    } else if (cmd->action == VOICE_CMD_ACTION_OFF) {
+        ret = watering_app_set_zone(cmd->zone, false, 0);
+    } else if (cmd->zone >= watering_app_zone_count()) {
+        ret = ESP_ERR_INVALID_ARG;
+    }
+    uint32_t local_us = (uint32_t)(esp_timer_get_time() - event->data.command.detect_us);
+
+    if (s_prompt_ready) {
+        (void)audio_prompt_play(ret != ESP_OK ? AUDIO_PROMPT_ERROR
+                                : cmd->action == VOICE_CMD_ACTION_STATUS ? AUDIO_PROMPT_BEEP
+                                                                         : AUDIO_PROMPT_SUCCESS);
+    }
+
+    bool     on      = watering_sched_zone_is_on(cmd->zone);
+    uint32_t today_s = watering_sched_zone_today_s(cmd->zone);
+    voice_cmd_show(cmd, ret, on, today_s);
+
+    voice_cmd_stats_t stats;
+    portENTER_CRITICAL(&s_lock);
+    voice_cmd_latency_add(&s_stats.local_us, local_us);
+    if (local_us > VOICE_CMD_FRAME_BUDGET_US) {
+        s_stats.over_budget++;
+    }
+    if (ret != ESP_OK) {
+        s_stats.failed++;
+    }
+    stats = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "command %s failed: %s", cmd->name, esp_err_to_name(ret));
+    }
+    ESP_LOGI(TAG, "⚡ 本地命令 %s: 识别→执行 %u us（平均 %u us）, 云端对话平均 %u ms（%u 轮）",
+             cmd->name, (unsigned)local_us, (unsigned)voice_cmd_latency_avg(&stats.local_us),
+             (unsigned)voice_cmd_latency_avg(&stats.cloud_ms), (unsigned)stats.cloud_ms.count);
+
+    voice_cmd_publish(cmd, event, ret, on, today_s, local_us, &stats);
+}
+
+void voice_cmd_app_cloud_submit(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    s_cloud_submit_us = now;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void voice_cmd_app_cloud_reply(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    int64_t submit_us = s_cloud_submit_us;
+    s_cloud_submit_us = 0;
+    if (submit_us > 0 && now - submit_us < VOICE_CMD_CLOUD_WINDOW_US) {
+        voice_cmd_latency_add(&s_stats.cloud_ms, (uint32_t)((now - submit_us) / 1000));
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t voice_cmd_app_get_stats(voice_cmd_stats_t *out)
+{
+    if (out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "audio_manager.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 延迟统计（本地命令以微秒计，云端对话以毫秒计）
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} voice_cmd_latency_t;
+
+typedef struct {
+    voice_cmd_latency_t local_us;       ///< 命令词识别完成 -> 浇水动作执行完成
+    voice_cmd_latency_t cloud_ms;       ///< 提交语音（audio complete）-> 收到第一帧回复音频
+    uint32_t over_budget;               ///< 本地执行超过一个 AFE 帧（32 ms）的次数
+    uint32_t failed;                    ///< 动作执行失败次数（未初始化、区域被禁止等）
+} voice_cmd_stats_t;
+
+/**
+ * @brief 填充本地命令词配置（命令表由本模块提供）
+ */
+void voice_cmd_app_fill_config(audio_mgr_command_config_t *cfg);
+
+/**
+ * @brief 初始化本地确认音（映射 prompt_store 分区），须在 audio_manager_init 之后调用
+ * @return ESP_OK 成功；失败时命令仍会执行，只是没有确认音
+ */
+esp_err_t voice_cmd_app_init(void);
+
+/**
+ * @brief 执行识别到的命令（在音频管理器任务中调用）
+ *
+ * 直接调用浇花模块开关区域，播放本地确认音，记录延迟并上报到
+ * xn/esp/voice/<device_id>/command。
+ */
+void voice_cmd_app_handle(const audio_mgr_event_t *event);
+
+/**
+ * @brief 记录一轮语音提交云端的时刻（VAD 结束 / 松开按键 / 唤醒超时提交）
+ */
+void voice_cmd_app_cloud_submit(void);
+
+/**
+ * @brief 收到云端回复音频（每帧都可调用，只有提交后的第一帧计入延迟）
+ */
+void voice_cmd_app_cloud_reply(void);
+
+/**
+ * @brief 读取延迟统计
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 参数为空
+ */
+esp_err_t voice_cmd_app_get_stats(voice_cmd_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
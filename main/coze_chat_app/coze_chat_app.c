@@ -20,7 +20,9 @@
 
 #include "coze_chat.h"
 #include "audio_manager.h"
-// #include "lottie_manager.h"
+#include "lottie_app.h"
+#include "voice_cmd_app.h"
+#include "coze_tools_app.h"
 
 static const char *TAG = "COZE_CHAT_APP";
 
@@ -84,22 +86,44 @@ static void coze_event_callback(coze_chat_event_t event, char *data, void *ctx)
 
     case COZE_CHAT_EVENT_CHAT_SPEECH_STARTED:
         ESP_LOGI(TAG, "🗣️ Coze开始说话");
+        lottie_app_show_speaking();
         break;
 
     case COZE_CHAT_EVENT_CHAT_SPEECH_STOPED:
         ESP_LOGI(TAG, "🤐 Coze停止说话");
+        lottie_app_show_mic_idle();
         break;
 
     case COZE_CHAT_EVENT_CHAT_ERROR:
         ESP_LOGE(TAG, "❌ Coze错误");
+        lottie_app_show_mic_idle();
         break;
 
     case COZE_CHAT_EVENT_INPUT_AUDIO_BUFFER_COMPLETED:
         ESP_LOGI(TAG, "🎤 音频缓冲区处理完成");
+        lottie_app_show_thinking();
         break;
 
     case COZE_CHAT_EVENT_CHAT_SUBTITLE_EVENT:
-        // 字幕事件（显示 Coze 返回的文字）
+        // 整句字幕与 MESSAGE_DELTA 内容相同，屏幕上显示流式片段，这里只记录
+        if (data) {
+            ESP_LOGD(TAG, "📝 字幕: %s", data);
+        }
+        break;
+
+    case COZE_CHAT_EVENT_CHAT_MESSAGE_DELTA:
+        // 流式文本片段：写入字幕环形缓冲（不等 LVGL 锁），LVGL 任务逐字追加到字幕
+        lottie_app_subtitle_push(data);
+        break;
+
+    case COZE_CHAT_EVENT_CHAT_MESSAGE_COMPLETED:
+        // 本条消息结束，下一条片段到来时清空字幕
+        lottie_app_subtitle_break();
+        break;
+
+    case COZE_CHAT_EVENT_TOOL_ROUND_TRIP:
+        // 端插件调用完成且服务端已恢复输出：记录耗时并上报
+        coze_tools_app_report(g_coze_chat, data);
         break;
 
     case COZE_CHAT_EVENT_CHAT_CUSTOMER_DATA:
@@ -133,6 +157,9 @@ static void coze_audio_callback(char *data, int len, void *ctx)
         return;
     }
 
+    // 本轮提交后的第一帧回复：记录云端对话延迟，与本地命令对比
+    voice_cmd_app_cloud_reply();
+
     // 组件已解码为PCM，len是字节数，样本数 = len / sizeof(int16_t) = len / 2
     size_t samples = len / sizeof(int16_t);
 
@@ -238,6 +265,12 @@ esp_err_t coze_chat_app_init(void)
         return ret;
     }
 
+    // 注册端插件（本地工具），失败不影响语音对话
+    ret = coze_tools_app_register(g_coze_chat);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "⚠️ 部分本地工具注册失败: %s", esp_err_to_name(ret));
+    }
+
     // 启动Coze聊天（连接WebSocket）
     ret = coze_chat_start(g_coze_chat);
     if (ret != ESP_OK) {
@@ -0,0 +1,181 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 11:02:35
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 11:02:35
+ * @FilePath: \xn_esp32_coze_chat_watering\main\coze_chat_app\coze_tools_app.c
+ * @Description: Coze 端插件 - 浇花控制 / 浇花状态 / WiFi 状态
+ *
+ * 处理函数在 coze_chat 工具桥接模块的执行任务中调用，输出 JSON 文本回传给智能体，
+ * 由智能体组织成语音回复。
+ *
+ * Copyright (c) 2026 by ${git_name_email}, All Rights Reserved.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "mqtt_outbox.h"
+#include "web_mqtt_manager.h"
+#include "watering_sched.h"
+#include "mqtt_app/watering_app.h"
+#include "mqtt_app/wifi_config_app.h"
+#include "coze_chat_app/coze_tools_app.h"
+
+static const char *TAG = "coze_tools_app";
+
+/* set_watering 打开时未给出时长的默认浇水时长 */
+#ifndef COZE_TOOLS_DEFAULT_WATER_S
+#define COZE_TOOLS_DEFAULT_WATER_S 60
+#endif
+
+/* -------------------- set_watering -------------------- */
+
+static const coze_tool_param_t s_set_watering_params[] = {
+    { .name = "on",         .type = COZE_TOOL_PARAM_BOOL, .required = true },
+    { .name = "zone",       .type = COZE_TOOL_PARAM_INT,  .min = 0, .max = WATERING_SCHED_MAX_ZONES - 1 },
+    { .name = "duration_s", .type = COZE_TOOL_PARAM_INT,  .min = 1, .max = WATERING_SCHED_MAX_DURATION_S },
+};
+
+static esp_err_t tool_set_watering(const coze_tool_args_t *args, char *out, size_t out_len, void *ctx)
+{
+    bool     on         = coze_tool_arg_bool(args, "on", false);
+    uint8_t  zone       = (uint8_t)coze_tool_arg_int(args, "zone", 0);
+    uint32_t duration_s = on ? (uint32_t)coze_tool_arg_int(args, "duration_s", COZE_TOOLS_DEFAULT_WATER_S) : 0;
+
+    esp_err_t ret = watering_app_set_zone(zone, on, duration_s);
+    if (ret == ESP_ERR_INVALID_ARG) {
+        snprintf(out, out_len, "{\"error\":\"zone %u does not exist\",\"zone_count\":%u}",
+                 (unsigned)zone, (unsigned)watering_app_zone_count());
+        return ret;
+    }
+    if (ret != ESP_OK) {
+        /* 未联网初始化或该区域被规则引擎禁止 */
+        snprintf(out, out_len, "{\"error\":\"watering unavailable\",\"zone\":%u}", (unsigned)zone);
+        return ret;
+    }
+
+    snprintf(out, out_len, "{\"ok\":true,\"zone\":%u,\"on\":%s,\"duration_s\":%u}",
+             (unsigned)zone, on ? "true" : "false", (unsigned)duration_s);
+    ESP_LOGI(TAG, "🌱 智能体%s浇水: 区域 %u, %u 秒", on ? "开始" : "停止", (unsigned)zone, (unsigned)duration_s);
+    return ESP_OK;
+}
+
+/* -------------------- get_watering_status -------------------- */
+
+static const coze_tool_param_t s_watering_status_params[] = {
+    { .name = "zone", .type = COZE_TOOL_PARAM_INT, .min = 0, .max = WATERING_SCHED_MAX_ZONES - 1 },
+};
+
+static esp_err_t tool_get_watering_status(const coze_tool_args_t *args, char *out, size_t out_len, void *ctx)
+{
+    uint8_t zone_count = watering_app_zone_count();
+    uint8_t first      = 0;
+    uint8_t last       = zone_count;
+
+    if (coze_tool_arg_has(args, "zone")) {
+        first = (uint8_t)coze_tool_arg_int(args, "zone", 0);
+        last  = first + 1;
+        if (first >= zone_count) {
+            snprintf(out, out_len, "{\"error\":\"zone %u does not exist\",\"zone_count\":%u}",
+                     (unsigned)first, (unsigned)zone_count);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    size_t pos = (size_t)snprintf(out, out_len, "{\"zones\":[");
+    for (uint8_t z = first; z < last && pos < out_len; z++) {
+        pos += (size_t)snprintf(out + pos, out_len - pos, "%s{\"zone\":%u,\"on\":%s,\"today_s\":%u}",
+                                z == first ? "" : ",", (unsigned)z,
+                                watering_sched_zone_is_on(z) ? "true" : "false",
+                                (unsigned)watering_sched_zone_today_s(z));
+    }
+
+    watering_plan_t plan = {0};
+    if (pos < out_len && watering_app_get_plan(&plan) == ESP_OK) {
+        pos += (size_t)snprintf(out + pos, out_len - pos,
+                                "],\"plan\":{\"enabled\":%s,\"days_mask\":%d,\"time\":\"%02d:%02d\",\"duration_s\":%d}}",
+                                plan.enabled ? "true" : "false", plan.days_mask, plan.hour, plan.minute,
+                                plan.duration_s);
+    } else if (pos < out_len) {
+        pos += (size_t)snprintf(out + pos, out_len - pos, "]}");
+    }
+
+    return pos < out_len ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+/* -------------------- get_wifi_status -------------------- */
+
+static esp_err_t tool_get_wifi_status(const coze_tool_args_t *args, char *out, size_t out_len, void *ctx)
+{
+    return wifi_config_app_get_status_json(out, out_len);
+}
+
+static const coze_tool_t s_tools[] = {
+    {
+        .name        = "set_watering",
+        .description = "开关浇花区域",
+        .params      = s_set_watering_params,
+        .param_count = sizeof(s_set_watering_params) / sizeof(s_set_watering_params[0]),
+        .handler     = tool_set_watering,
+        .deadline_ms = 2000,
+    },
+    {
+        .name        = "get_watering_status",
+        .description = "查询浇花状态和定时计划",
+        .params      = s_watering_status_params,
+        .param_count = sizeof(s_watering_status_params) / sizeof(s_watering_status_params[0]),
+        .handler     = tool_get_watering_status,
+        .deadline_ms = 1000,
+    },
+    {
+        .name        = "get_wifi_status",
+        .description = "查询 WiFi 连接状态",
+        .handler     = tool_get_wifi_status,
+        .deadline_ms = 1000,
+    },
+};
+
+esp_err_t coze_tools_app_register(coze_chat_handle_t handle)
+{
+    esp_err_t first_err = ESP_OK;
+
+    for (size_t i = 0; i < sizeof(s_tools) / sizeof(s_tools[0]); i++) {
+        esp_err_t ret = coze_chat_register_tool(handle, &s_tools[i]);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "register tool %s failed: %s", s_tools[i].name, esp_err_to_name(ret));
+            if (first_err == ESP_OK) {
+                first_err = ret;
+            }
+        }
+    }
+    return first_err;
+}
+
+void coze_tools_app_report(coze_chat_handle_t handle, const char *json)
+{
+    if (json == NULL) {
+        return;
+    }
+
+    coze_tool_stats_t stats = {0};
+    (void)coze_chat_get_tool_stats(handle, &stats);
+    ESP_LOGI(TAG, "🔧 工具往返 %s（累计 %u 次, 本地平均 %u ms, 恢复平均 %u ms, 超时 %u）",
+             json, (unsigned)stats.actions, (unsigned)stats.local_ms_avg,
+             (unsigned)stats.resume_ms_avg, (unsigned)stats.timeouts);
+
+    const char *client_id = web_mqtt_manager_get_client_id();
+    if (client_id == NULL || client_id[0] == '\0') {
+        return;
+    }
+
+    char topic[128];
+    int  n = snprintf(topic, sizeof(topic), "%s/coze/%s/tool", WEB_MQTT_UPLINK_BASE_TOPIC, client_id);
+    if (n <= 0 || n >= (int)sizeof(topic)) {
+        return;
+    }
+
+    /* 每次往返一条记录，不合并 */
+    (void)mqtt_outbox_publish(topic, json, strlen(json), 1, false, MQTT_OUTBOX_PRIO_NORMAL, NULL);
+}
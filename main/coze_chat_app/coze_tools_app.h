@@ -0,0 +1,41 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 11:02:35
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 11:02:35
+ * @FilePath: \xn_esp32_coze_chat_watering\main\coze_chat_app\coze_tools_app.h
+ * @Description: Coze 端插件 - 对话中由智能体调用的本地工具（浇花、WiFi 状态）
+ *
+ * Copyright (c) 2026 by ${git_name_email}, All Rights Reserved.
+ */
+#pragma once
+
+#include "esp_err.h"
+#include "coze_chat.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 注册本地工具，须在 coze_chat_init 之后、coze_chat_start 之前调用
+ *
+ * 工具名和参数须与 Coze 平台上智能体配置的端插件一致：
+ * - set_watering(on: bool, zone?: int, duration_s?: int)
+ * - get_watering_status(zone?: int)
+ * - get_wifi_status()
+ *
+ * @return ESP_OK 成功；失败时语音对话不受影响，只是智能体调用会收到错误
+ */
+esp_err_t coze_tools_app_register(coze_chat_handle_t handle);
+
+/**
+ * @brief 处理 COZE_CHAT_EVENT_TOOL_ROUND_TRIP：记录并上报到 xn/esp/coze/<device_id>/tool
+ *
+ * @param json 桥接模块生成的往返摘要
+ */
+void coze_tools_app_report(coze_chat_handle_t handle, const char *json);
+
+#ifdef __cplusplus
+}
+#endif
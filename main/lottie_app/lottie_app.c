@@ -11,12 +11,70 @@
 #include "esp_log.h"
 
 #include "xn_lottie_manager.h"
+#include "xn_chat_ui.h"
+#include "xn_lvgl.h"
+#include "xn_wifi_manage.h"
 #include "lottie_app.h"
 
 static const char *TAG = "LOTTIE_APP";
 
 static bool s_lottie_inited = false;
 
+/* 显示模式表：默认刷新周期为 LV_DEF_REFR_PERIOD（100ms，即 10 FPS），
+ * 录音/播放时屏幕与动画降到 5 FPS，把 CPU 让给 AFE 与编解码；AFE 积压时动画冻结 */
+typedef struct {
+    const char *name;
+    uint32_t refr_ms;
+    uint32_t anim_ms;
+} lottie_app_mode_cfg_t;
+
+static lottie_app_mode_cfg_t s_modes[LOTTIE_APP_MODE_MAX] = {
+    [LOTTIE_APP_MODE_DISABLED]     = { "disabled",  100, 100 },
+    [LOTTIE_APP_MODE_IDLE]         = { "idle",      100, 100 },
+    [LOTTIE_APP_MODE_LISTENING]    = { "listening", 100, 100 },
+    [LOTTIE_APP_MODE_RECORDING]    = { "recording", 200, 200 },
+    [LOTTIE_APP_MODE_PLAYBACK]     = { "playback",  200, 200 },
+    [LOTTIE_APP_MODE_AFE_PRESSURE] = { "afe_busy",  200, LVGL_FRAME_FREEZE },
+};
+
+_Static_assert(LOTTIE_APP_MODE_MAX <= LVGL_PERF_MODE_MAX, "too many display modes");
+
+static uint8_t s_audio_state = AUDIO_MGR_STATE_DISABLED;
+static bool s_afe_pressure = false;
+
+/**
+ * @brief 按当前音频状态与 AFE 积压标志投递显示模式（无锁，可在音频任务中调用）
+ */
+static void lottie_app_apply_mode(void)
+{
+    uint8_t mode = __atomic_load_n(&s_audio_state, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&s_afe_pressure, __ATOMIC_RELAXED)) {
+        mode = LOTTIE_APP_MODE_AFE_PRESSURE;
+    }
+    lvgl_driver_set_perf_mode(mode, s_modes[mode].refr_ms, s_modes[mode].anim_ms);
+}
+
+static void lottie_app_perf_report_cb(lv_timer_t *timer)
+{
+    (void)timer;
+
+    static lvgl_perf_mode_stats_t stats[LVGL_PERF_MODE_MAX];
+    if (lvgl_driver_get_perf_stats(stats, true) != ESP_OK) {
+        return;
+    }
+    for (int i = 0; i < LOTTIE_APP_MODE_MAX; i++) {
+        const lvgl_perf_mode_stats_t *st = &stats[i];
+        if (st->active_ms == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "📊 显示模式 %-9s: %lu ms, %lu.%lu FPS, LVGL 占用 %lu.%lu%%, 跳过 %lu 帧, 让出约 %lu ms CPU",
+                 s_modes[i].name, (unsigned long)st->active_ms,
+                 (unsigned long)(st->fps_x10 / 10), (unsigned long)(st->fps_x10 % 10),
+                 (unsigned long)(st->busy_permille / 10), (unsigned long)(st->busy_permille % 10),
+                 (unsigned long)st->skipped_frames, (unsigned long)st->saved_ms);
+    }
+}
+
 esp_err_t lottie_app_init(void)
 {
     if (s_lottie_inited) {
@@ -35,10 +93,32 @@ esp_err_t lottie_app_init(void)
         return ret;
     }
 
+    /* 对话界面：静态背景 + 状态图标 + 动画区域 + 字幕，动画只在动画区域内重绘 */
+    ret = chat_ui_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "chat_ui_init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    /* 各显示模式的帧率/占用统计定期输出，用于评估降帧让出的 CPU */
+    lv_lock();
+    lv_timer_create(lottie_app_perf_report_cb, LOTTIE_APP_PERF_REPORT_MS, NULL);
+    lv_unlock();
+    lottie_app_apply_mode();
+
+    /* WiFi 与显示并行启动，显示就绪前的 WiFi 事件被忽略：置位后按当前 WiFi 状态补齐图标和动画，
+     * 之后的事件由 WiFi 回调直接更新（持锁保证回调的更新排在这次之后） */
+    lv_lock();
     s_lottie_inited = true;
+    bool connected = wifi_manage_get_state() == WIFI_MANAGE_STATE_CONNECTED;
+    chat_ui_set_wifi(connected);
+    chat_ui_set_state(connected ? CHAT_UI_STATE_IDLE : CHAT_UI_STATE_WIFI_CONNECTING);
+    lv_unlock();
 
-    /* 默认显示一个加载动画 */
-    lottie_app_show_loading();
+    /* 对话中频繁切换的状态动画提前解析进缓存，切换时只需重绑缓冲区 */
+    lottie_manager_preload_anim(LOTTIE_ANIM_MIC);
+    lottie_manager_preload_anim(LOTTIE_ANIM_THINK);
+    lottie_manager_preload_anim(LOTTIE_ANIM_SPEAK);
 
     return ESP_OK;
 }
@@ -57,7 +137,7 @@ void lottie_app_show_wifi_connecting(void)
     if (!lottie_app_is_ready()) {
         return;
     }
-    lottie_manager_play_anim(LOTTIE_ANIM_WIFI);
+    chat_ui_set_state(CHAT_UI_STATE_WIFI_CONNECTING);
 }
 
 void lottie_app_show_mic_idle(void)
@@ -65,7 +145,15 @@ void lottie_app_show_mic_idle(void)
     if (!lottie_app_is_ready()) {
         return;
     }
-    lottie_manager_play_anim(LOTTIE_ANIM_MIC);
+    chat_ui_set_state(CHAT_UI_STATE_IDLE);
+}
+
+void lottie_app_show_listening(void)
+{
+    if (!lottie_app_is_ready()) {
+        return;
+    }
+    chat_ui_set_state(CHAT_UI_STATE_LISTENING);
 }
 
 void lottie_app_show_speaking(void)
@@ -73,7 +161,7 @@ void lottie_app_show_speaking(void)
     if (!lottie_app_is_ready()) {
         return;
     }
-    lottie_manager_play_anim(LOTTIE_ANIM_SPEAK);
+    chat_ui_set_state(CHAT_UI_STATE_SPEAKING);
 }
 
 void lottie_app_show_thinking(void)
@@ -81,7 +169,7 @@ void lottie_app_show_thinking(void)
     if (!lottie_app_is_ready()) {
         return;
     }
-    lottie_manager_play_anim(LOTTIE_ANIM_THINK);
+    chat_ui_set_state(CHAT_UI_STATE_THINKING);
 }
 
 void lottie_app_show_loading(void)
@@ -89,7 +177,7 @@ void lottie_app_show_loading(void)
     if (!lottie_app_is_ready()) {
         return;
     }
-    lottie_manager_play_anim(LOTTIE_ANIM_LOADING);
+    chat_ui_set_state(CHAT_UI_STATE_BOOT);
 }
 
 void lottie_app_show_ota(void)
@@ -97,7 +185,67 @@ void lottie_app_show_ota(void)
     if (!lottie_app_is_ready()) {
         return;
     }
-    lottie_manager_play_anim(LOTTIE_ANIM_OTA);
+    chat_ui_set_state(CHAT_UI_STATE_OTA);
+}
+
+void lottie_app_set_wifi(bool connected)
+{
+    if (!lottie_app_is_ready()) {
+        return;
+    }
+    chat_ui_set_wifi(connected);
+}
+
+void lottie_app_subtitle_push(const char *delta)
+{
+    if (!lottie_app_is_ready()) {
+        return;
+    }
+    chat_ui_subtitle_push(delta);
+}
+
+void lottie_app_subtitle_break(void)
+{
+    if (!lottie_app_is_ready()) {
+        return;
+    }
+    chat_ui_subtitle_break();
+}
+
+void lottie_app_subtitle_show(const char *text)
+{
+    if (!lottie_app_is_ready()) {
+        return;
+    }
+    chat_ui_set_subtitle(text);
+}
+
+esp_err_t lottie_app_set_display_mode(lottie_app_mode_t mode, uint32_t refr_period_ms, uint32_t anim_period_ms)
+{
+    if (mode >= LOTTIE_APP_MODE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_modes[mode].refr_ms = refr_period_ms;
+    s_modes[mode].anim_ms = anim_period_ms;
+    lottie_app_apply_mode();
+    return ESP_OK;
+}
+
+void lottie_app_on_audio_state(audio_mgr_state_t state, void *user_ctx)
+{
+    (void)user_ctx;
+
+    if ((int)state >= (int)LOTTIE_APP_MODE_AFE_PRESSURE) {
+        return;
+    }
+    __atomic_store_n(&s_audio_state, (uint8_t)state, __ATOMIC_RELAXED);
+    lottie_app_apply_mode();
+}
+
+void lottie_app_set_afe_pressure(bool active)
+{
+    __atomic_store_n(&s_afe_pressure, active, __ATOMIC_RELAXED);
+    lottie_app_apply_mode();
 }
 
 void lottie_app_stop(void)
@@ -7,7 +7,10 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "esp_err.h"
+#include "audio_manager.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,6 +34,11 @@ void lottie_app_show_wifi_connecting(void);
  */
 void lottie_app_show_mic_idle(void);
 
+/**
+ * @brief 显示录音中状态（与待机共用动画，只更新状态图标）
+ */
+void lottie_app_show_listening(void);
+
 /**
  * @brief 显示「说话中」动画
  */
@@ -51,6 +59,65 @@ void lottie_app_show_loading(void);
  */
 void lottie_app_show_ota(void);
 
+/**
+ * @brief 更新网络状态图标
+ */
+void lottie_app_set_wifi(bool connected);
+
+/**
+ * @brief 追加一段流式字幕片段（不等待 LVGL 锁）
+ */
+void lottie_app_subtitle_push(const char *delta);
+
+/**
+ * @brief 结束当前字幕，下一段片段到来时重新开始
+ */
+void lottie_app_subtitle_break(void);
+
+/**
+ * @brief 显示一句独立字幕（如本地命令结果），不会与正在流式输出的片段交错
+ */
+void lottie_app_subtitle_show(const char *text);
+
+/**
+ * @brief 显示模式：每个音频状态一组帧率上限，另加一个 AFE 积压时的冻结模式
+ *
+ * 模式号与 audio_mgr_state_t 一一对应，同时作为 lvgl_driver_set_perf_mode 的统计编号。
+ */
+typedef enum {
+    LOTTIE_APP_MODE_DISABLED = AUDIO_MGR_STATE_DISABLED,
+    LOTTIE_APP_MODE_IDLE = AUDIO_MGR_STATE_IDLE,
+    LOTTIE_APP_MODE_LISTENING = AUDIO_MGR_STATE_LISTENING,
+    LOTTIE_APP_MODE_RECORDING = AUDIO_MGR_STATE_RECORDING,
+    LOTTIE_APP_MODE_PLAYBACK = AUDIO_MGR_STATE_PLAYBACK,
+    LOTTIE_APP_MODE_AFE_PRESSURE,       ///< AFE 结果队列积压：动画冻结，屏幕降频，优先保证语音链路
+    LOTTIE_APP_MODE_MAX,
+} lottie_app_mode_t;
+
+#define LOTTIE_APP_PERF_REPORT_MS   60000   ///< 各显示模式统计输出周期
+
+/**
+ * @brief 修改某个显示模式的帧间隔下限
+ * @param mode 显示模式
+ * @param refr_period_ms 屏幕刷新间隔下限（ms），0 冻结
+ * @param anim_period_ms 动画帧间隔下限（ms），0 冻结
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 模式无效
+ */
+esp_err_t lottie_app_set_display_mode(lottie_app_mode_t mode, uint32_t refr_period_ms, uint32_t anim_period_ms);
+
+/**
+ * @brief 音频状态机回调（填入 audio_mgr_config_t.state_callback），按状态切换显示模式
+ *
+ * 在音频任务中调用，只投递模式，不获取 lv_lock。
+ */
+void lottie_app_on_audio_state(audio_mgr_state_t state, void *user_ctx);
+
+/**
+ * @brief AFE 积压状态变化（AUDIO_MGR_EVENT_AFE_PRESSURE），积压期间冻结动画
+ * @param active 是否积压
+ */
+void lottie_app_set_afe_pressure(bool active);
+
 /**
  * @brief 停止当前动画
  */
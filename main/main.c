@@ -16,14 +16,24 @@
 #include "esp_log.h"
 #include "esp_err.h"
 #include "xn_wifi_manage.h"
+#include "web_module.h"
+#include "boot_manager.h"
+#include "asset_loader.h"
+#include "xn_lottie_manager.h"
 #include "audio_manager.h"
 #include "coze_chat.h"
 #include "coze_chat_app.h"
 #include "audio_app/audio_config_app.h"
+#include "audio_app/audio_health_app.h"
+#include "audio_app/voice_cmd_app.h"
 #include "lottie_app/lottie_app.h"
 #include "web_mqtt_manager.h"
 #include "mqtt_app/wifi_config_app.h"
 #include "mqtt_app/watering_app.h"
+#include "mqtt_app/rule_app.h"
+#include "mqtt_app/telemetry_app.h"
+#include "mqtt_app/conn_app.h"
+#include "mqtt_app/display_app.h"
 
 static const char *TAG = "app";
 
@@ -41,9 +51,11 @@ static void app_wifi_event_cb(wifi_manage_state_t state)
 {
     switch (state) {
     case WIFI_MANAGE_STATE_CONNECTED:
+        boot_manager_mark("wifi_connected");
         if (!s_mqtt_inited) {
             ESP_LOGI(TAG, "WiFi connected, init Coze chat");
 
+            lottie_app_set_wifi(true);
             if (coze_chat_app_init() == ESP_OK) {
                 s_coze_started = true;
                 lottie_app_show_mic_idle();
@@ -61,6 +73,9 @@ static void app_wifi_event_cb(wifi_manage_state_t state)
 
             (void)wifi_config_app_init();
             (void)watering_app_init();
+            (void)rule_app_init();
+            (void)telemetry_app_init();
+            (void)display_app_init();
 
             s_mqtt_inited = true;
         }
@@ -73,6 +88,7 @@ static void app_wifi_event_cb(wifi_manage_state_t state)
             coze_chat_app_deinit();
             s_coze_started = false;
         }
+        lottie_app_set_wifi(false);
         lottie_app_show_wifi_connecting();
         break;
 
@@ -173,6 +189,8 @@ static void audio_event_cb(const audio_mgr_event_t *event, void *user_ctx)
         // 开启新一轮对话：重置本轮上行计数
         s_uplink_samples_this_turn = 0;
 
+        lottie_app_show_listening();
+
         // 重新启动播放任务（准备接收新的回复）
         audio_manager_start_playback();
         break;
@@ -189,6 +207,7 @@ static void audio_event_cb(const audio_mgr_event_t *event, void *user_ctx)
         coze_chat_handle_t handle = coze_chat_get_handle();
         if (handle) {
             coze_chat_send_audio_complete(handle);
+            voice_cmd_app_cloud_submit();
         }
         // 本轮提交完成，复位计数
         s_uplink_samples_this_turn = 0;
@@ -202,9 +221,11 @@ static void audio_event_cb(const audio_mgr_event_t *event, void *user_ctx)
             if (s_uplink_samples_this_turn > 0) {
                 ESP_LOGW(TAG, "wake window timeout, auto send audio complete (%u samples)", (unsigned)s_uplink_samples_this_turn);
                 coze_chat_send_audio_complete(handle);
+                voice_cmd_app_cloud_submit();
             } else {
                 ESP_LOGW(TAG, "wake window timeout, cancel Coze audio (no input)");
                 coze_chat_send_audio_cancel(handle);
+                lottie_app_show_mic_idle();
             }
             s_uplink_samples_this_turn = 0;
         }
@@ -231,7 +252,7 @@ static void audio_event_cb(const audio_mgr_event_t *event, void *user_ctx)
         // 开启新一轮对话：重置本轮上行计数
         s_uplink_samples_this_turn = 0;
 
-        lottie_app_show_mic_idle();
+        lottie_app_show_listening();
         
         // 重新启动播放任务（准备接收新的回复）
         audio_manager_start_playback();
@@ -244,48 +265,122 @@ static void audio_event_cb(const audio_mgr_event_t *event, void *user_ctx)
         coze_chat_handle_t handle = coze_chat_get_handle();
         if (handle) {
             coze_chat_send_audio_complete(handle);
+            voice_cmd_app_cloud_submit();
         }
         s_uplink_samples_this_turn = 0;
         break;
     }
 
+    case AUDIO_MGR_EVENT_COMMAND_DETECTED: {
+        // 本地命令词：丢弃已上行的音频，本轮不提交云端
+        ESP_LOGI(TAG, "⚡ 本地命令 %d（置信度 %.2f），跳过云端对话",
+                 event->data.command.command_id, event->data.command.prob);
+        coze_chat_handle_t handle = coze_chat_get_handle();
+        if (handle && s_uplink_samples_this_turn > 0) {
+            coze_chat_send_audio_cancel(handle);
+        }
+        s_uplink_samples_this_turn = 0;
+
+        voice_cmd_app_handle(event);
+        lottie_app_show_mic_idle();
+        break;
+    }
+
+    case AUDIO_MGR_EVENT_AFE_PRESSURE:
+        // AFE 结果队列积压：冻结动画直到队列回落
+        lottie_app_set_afe_pressure(event->data.pressure.active);
+        break;
+
+    case AUDIO_MGR_EVENT_WAKEWORD_READY: {
+        // 唤醒词模型后台加载完成，此前仅按键录音可用
+        boot_manager_mark("wakeword");
+        break;
+    }
+
     default:
         break;
     }
 }
 
+// ============ 启动阶段 ============
+
 /**
- * @brief 应用程序主入口函数
+ * @brief 挂载各模块的 SPIFFS 分区
  * 
- * 初始化音频管理器，配置录音回调，启动音频采集和播放任务
+ * esp_vfs_spiffs_register 不是线程安全的，统一在一个阶段内串行挂载，
+ * 之后各模块初始化时检测到已挂载会直接跳过。
  */
-void app_main(void)
+static esp_err_t boot_stage_storage(void *arg)
 {
-    esp_err_t ret;
+    (void)arg;
 
-    printf("esp32 网页WiFi配网 By.星年\n");
+    // 资源加载器：各模块的文件读取统一交给低优先级 I/O 任务
+    esp_err_t ret = asset_loader_init(NULL);
+    if (ret != ESP_OK) {
+        return ret;
+    }
 
-    ret = lottie_app_init();
+    ret = xn_lottie_manager_mount_storage();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return web_module_mount_storage();
+}
+
+/**
+ * @brief 显示：LVGL / 屏幕 / Lottie
+ */
+static esp_err_t boot_stage_display(void *arg)
+{
+    (void)arg;
+
+    esp_err_t ret = lottie_app_init();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "lottie_app_init failed: %s", esp_err_to_name(ret));
-    } else {
-        lottie_app_show_wifi_connecting();
+        return ret;
     }
+    return ESP_OK;
+}
+
+/**
+ * @brief WiFi 管理（连接成功后再启动 Coze / MQTT）
+ */
+static esp_err_t boot_stage_wifi(void *arg)
+{
+    (void)arg;
 
     wifi_manage_config_t wifi_cfg = WIFI_MANAGE_DEFAULT_CONFIG();
     wifi_cfg.wifi_event_cb = app_wifi_event_cb;
-    ret = wifi_manage_init(&wifi_cfg);
+    esp_err_t ret = wifi_manage_init(&wifi_cfg);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "wifi_manage_init failed: %s", esp_err_to_name(ret));
+        return ret;
     }
-    
+
+    // 每次断网恢复的分段耗时上报到 xn/esp/conn/<device_id>/recovery
+    (void)conn_app_init();
+    return ESP_OK;
+}
+
+/**
+ * @brief 音频管理器（唤醒词模型在其内部后台加载）
+ */
+static esp_err_t boot_stage_audio(void *arg)
+{
+    (void)arg;
+
     // 构建音频管理器配置
     audio_mgr_config_t audio_cfg = {0};
     audio_config_app_build(&audio_cfg, audio_event_cb, NULL);
+    // 音频状态机驱动显示模式：录音/播放时降帧，把 CPU 让给语音链路
+    audio_cfg.state_callback = lottie_app_on_audio_state;
 
     // 初始化音频管理器
     ESP_LOGI(TAG, "init audio manager");
-    ESP_ERROR_CHECK(audio_manager_init(&audio_cfg));
+    esp_err_t ret = audio_manager_init(&audio_cfg);
+    if (ret != ESP_OK) {
+        return ret;
+    }
     
     // 设置播放音量为100%
     audio_manager_set_volume(100);
@@ -294,8 +389,53 @@ void app_main(void)
     audio_manager_set_record_callback(loopback_record_cb, NULL);
     
     // 启动播放任务（保持播放任务常驻，随时准备播放数据）
-    ESP_ERROR_CHECK(audio_manager_start_playback());
+    ret = audio_manager_start_playback();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // 本地命令确认音（失败只影响确认音，命令照常执行）
+    (void)voice_cmd_app_init();
     
     // 启动音频管理器（开始录音和VAD检测）
-    ESP_ERROR_CHECK(audio_manager_start());
+    ret = audio_manager_start();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // 音频链路健康计数周期上报（失败不影响主流程）
+    if (audio_health_app_start() != ESP_OK) {
+        ESP_LOGW(TAG, "audio health publisher not started");
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 应用程序主入口函数
+ * 
+ * 注册各子系统启动阶段及其依赖，由启动编排模块在双核上并行执行
+ */
+void app_main(void)
+{
+    printf("esp32 网页WiFi配网 By.星年\n");
+
+    const boot_stage_t stages[] = {
+        { .name = "storage", .init = boot_stage_storage, .core = BOOT_STAGE_ANY_CORE },
+        { .name = "display", .init = boot_stage_display, .deps = {"storage"},
+          .core = BOOT_STAGE_ANY_CORE, .interactive = true },
+        { .name = "audio",   .init = boot_stage_audio,
+          .core = BOOT_STAGE_ANY_CORE, .interactive = true },
+        /* 与显示并行：显示就绪前的 WiFi 状态由 lottie_app_init 补齐 */
+        { .name = "wifi",    .init = boot_stage_wifi,   .deps = {"storage"},
+          .core = BOOT_STAGE_ANY_CORE },
+    };
+
+    for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++) {
+        ESP_ERROR_CHECK(boot_manager_register(&stages[i]));
+    }
+
+    esp_err_t ret = boot_manager_run(NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "boot finished with errors: %s", esp_err_to_name(ret));
+    }
 }
@@ -0,0 +1,64 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 14:05:12
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 14:05:12
+ * @FilePath: \xn_esp32_coze_chat_watering\main\mqtt_app\conn_app.c
+ * @Description: 联网恢复耗时上报
+ *
+ * 监听回调在 esp-mqtt 事件任务中执行（MQTT_UP 时结算），这里只格式化并投递到发件箱。
+ *
+ * Copyright (c) 2026 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "conn_supervisor.h"
+#include "mqtt_outbox.h"
+#include "web_mqtt_manager.h"
+#include "mqtt_app/conn_app.h"
+
+static const char *TAG = "conn_app";
+
+static void conn_app_on_event(conn_event_t event, void *ctx)
+{
+    (void)ctx;
+
+    if (event != CONN_EVENT_RECOVERED) {
+        return;
+    }
+
+    conn_supervisor_stats_t stats = {0};
+    if (conn_supervisor_get_stats(&stats) != ESP_OK) {
+        return;
+    }
+
+    char json[256];
+    int  len = conn_supervisor_recovery_to_json(&stats.last, json, sizeof(json));
+    if (len <= 0 || len >= (int)sizeof(json)) {
+        return;
+    }
+    ESP_LOGI(TAG, "📶 %s（累计 %u 次，平均 %u ms，最长 %u ms）", json, (unsigned)stats.recoveries,
+             (unsigned)stats.total_ms_avg, (unsigned)stats.total_ms_max);
+
+    const char *client_id = web_mqtt_manager_get_client_id();
+    if (client_id == NULL || client_id[0] == '\0') {
+        return;
+    }
+
+    char topic[128];
+    int  n = snprintf(topic, sizeof(topic), "%s/conn/%s/recovery", WEB_MQTT_UPLINK_BASE_TOPIC, client_id);
+    if (n <= 0 || n >= (int)sizeof(topic)) {
+        return;
+    }
+
+    (void)mqtt_outbox_publish(topic, json, len, 1, false, MQTT_OUTBOX_PRIO_NORMAL, NULL);
+}
+
+esp_err_t conn_app_init(void)
+{
+    return conn_supervisor_add_listener(conn_app_on_event, NULL);
+}
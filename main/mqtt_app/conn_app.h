@@ -0,0 +1,23 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 14:05:12
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 14:05:12
+ * @FilePath: \xn_esp32_coze_chat_watering\main\mqtt_app\conn_app.h
+ * @Description: 联网恢复耗时上报
+ *
+ * Copyright (c) 2026 by ${git_name_email}, All Rights Reserved.
+ */
+#ifndef CONN_APP_H
+#define CONN_APP_H
+
+#include "esp_err.h"
+
+/**
+ * @brief 监听联网监督的 RECOVERED 事件，每次恢复发布到 xn/esp/conn/<device_id>/recovery
+ *
+ * 须在 wifi_manage_init 之后调用，以便收到上电后的首次恢复（在 MQTT 就绪时结算，此时发件箱已可用）。
+ */
+esp_err_t conn_app_init(void);
+
+#endif /* CONN_APP_H */
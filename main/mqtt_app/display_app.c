@@ -0,0 +1,128 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 10:20:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 10:20:00
+ * @FilePath: \xn_esp32_coze_chat_watering\main\mqtt_app\display_app.c
+ * @Description: 显示诊断：MQTT 触发刷新模式基准测试并上报结果
+ *
+ * 基准测试会占用屏幕并阻塞数秒，使用独立分发队列，在模块工作任务中运行，
+ * 不拖住 esp-mqtt 事件任务；测试期间再收到的命令排不进队列，直接丢弃。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "mqtt_app_module.h"
+#include "mqtt_outbox.h"
+#include "xn_lvgl.h"
+#include "mqtt_app/display_app.h"
+
+static const char *TAG = "display_app";
+
+#define DISPLAY_APP_BENCH_FRAMES     120     ///< 未指定帧数时每种模式重绘的帧数
+#define DISPLAY_APP_BENCH_FRAMES_MAX 1000
+
+static const char *const s_mode_keys[LVGL_FLUSH_MODE_MAX] = {
+    [LVGL_FLUSH_MODE_PSRAM_DOUBLE]  = "psram_double",
+    [LVGL_FLUSH_MODE_INTERNAL_RING] = "internal_ring",
+};
+
+static void display_publish_bench(esp_err_t ret, const lvgl_bench_result_t *res)
+{
+    const char *client_id = web_mqtt_manager_get_client_id();
+    if (client_id == NULL || client_id[0] == '\0') {
+        return;
+    }
+
+    char topic[128];
+    int  n = snprintf(topic, sizeof(topic), "%s/display/%s/bench", WEB_MQTT_UPLINK_BASE_TOPIC, client_id);
+    if (n <= 0 || n >= (int)sizeof(topic)) {
+        return;
+    }
+
+    char json[384];
+    int  pos = snprintf(json, sizeof(json), "{\"ok\":%s", ret == ESP_OK ? "true" : "false");
+    if (ret != ESP_OK) {
+        pos += snprintf(json + pos, sizeof(json) - pos, ",\"err\":\"%s\"", esp_err_to_name(ret));
+    } else {
+        for (int m = 0; m < LVGL_FLUSH_MODE_MAX && pos < (int)sizeof(json); m++) {
+            pos += snprintf(json + pos, sizeof(json) - pos,
+                            ",\"%s\":{\"frames\":%lu,\"ms\":%lu,\"fps_x10\":%lu,\"render_us\":%lu,\"flush_us\":%lu}",
+                            s_mode_keys[m],
+                            (unsigned long)res[m].frames, (unsigned long)res[m].elapsed_ms,
+                            (unsigned long)res[m].fps_x10, (unsigned long)res[m].render_avg_us,
+                            (unsigned long)res[m].flush_avg_us);
+        }
+    }
+    if (pos >= (int)sizeof(json) - 1) {
+        ESP_LOGW(TAG, "bench result too long");
+        return;
+    }
+    json[pos++] = '}';
+
+    (void)mqtt_outbox_publish(topic, json, pos, 0, false, MQTT_OUTBOX_PRIO_LOW, "display_bench");
+}
+
+static void display_handle_bench(const uint8_t *payload, int payload_len)
+{
+    char buf[12] = {0};
+    if (payload != NULL && payload_len > 0) {
+        memcpy(buf, payload, payload_len < (int)sizeof(buf) ? (size_t)payload_len : sizeof(buf) - 1);
+    }
+
+    int frames = atoi(buf);
+    if (frames <= 0) {
+        frames = DISPLAY_APP_BENCH_FRAMES;
+    } else if (frames > DISPLAY_APP_BENCH_FRAMES_MAX) {
+        frames = DISPLAY_APP_BENCH_FRAMES_MAX;
+    }
+
+    ESP_LOGI(TAG, "display benchmark requested: %d frames per mode", frames);
+    lvgl_bench_result_t res[LVGL_FLUSH_MODE_MAX] = {0};
+    esp_err_t ret = lvgl_driver_run_benchmark((uint32_t)frames, res);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "display benchmark failed: %s", esp_err_to_name(ret));
+    }
+    display_publish_bench(ret, res);
+}
+
+static esp_err_t display_app_on_message(const char    *topic,
+                                        int            topic_len,
+                                        const uint8_t *payload,
+                                        int            payload_len)
+{
+    const char *base_topic = web_mqtt_manager_get_base_topic();
+    const char *client_id  = web_mqtt_manager_get_client_id();
+
+    if (base_topic == NULL || base_topic[0] == '\0' ||
+        client_id == NULL || client_id[0] == '\0' ||
+        topic == NULL || topic_len <= 0) {
+        return ESP_OK;
+    }
+
+    /* 只处理 <base>/display/<device_id>/bench */
+    char expect[128];
+    int  n = snprintf(expect, sizeof(expect), "%s/display/%s/bench", base_topic, client_id);
+    if (n <= 0 || n >= (int)sizeof(expect)) {
+        return ESP_OK;
+    }
+
+    if (topic_len == n && memcmp(topic, expect, (size_t)n) == 0) {
+        display_handle_bench(payload, payload_len);
+    }
+    return ESP_OK;
+}
+
+esp_err_t display_app_init(void)
+{
+    web_mqtt_app_config_t cfg = WEB_MQTT_APP_DEFAULT_CONFIG(display_app_on_message);
+    cfg.queue_len       = 1;
+    cfg.task_stack_size = 4096;
+    cfg.max_msg_size    = 256;
+    return web_mqtt_manager_register_app_ex("display", &cfg);
+}
@@ -0,0 +1,24 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2026-10-19 10:20:00
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2026-10-19 10:20:00
+ * @FilePath: \xn_esp32_coze_chat_watering\main\mqtt_app\display_app.h
+ * @Description: 显示诊断：MQTT 触发刷新模式基准测试并上报结果
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#ifndef DISPLAY_APP_H
+#define DISPLAY_APP_H
+
+#include "esp_err.h"
+
+/**
+ * @brief 注册显示诊断命令（须在 web_mqtt_manager_init 之后调用）
+ *
+ *  - xn/web/display/<device_id>/bench   负载为每种模式的帧数（可为空，默认 DISPLAY_APP_BENCH_FRAMES）
+ *  - xn/esp/display/<device_id>/bench   JSON 格式的两种刷新模式对比结果
+ */
+esp_err_t display_app_init(void);
+
+#endif /* DISPLAY_APP_H */
@@ -0,0 +1,312 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-10 09:41:05
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-10 09:41:05
+ * @FilePath: \xn_esp32_coze_chat_watering\main\mqtt_app\rule_app.c
+ * @Description: 设备端浇花规则应用模块
+ *
+ * 职责：
+ *  - 向规则引擎注册本地输入：土壤湿度（ADC）、雨量（GPIO）、本地时间、各区域开关状态与今日开启秒数；
+ *  - 把规则引擎的区域决策落到调度引擎：RUN -> watering_sched_set_zone，INHIBIT -> watering_sched_set_inhibit；
+ *  - 通过 watering 模块的 Topic 接收字节码（rules）并回报状态（get_rules）：
+ *      - xn/web/watering/<device_id>/rules       规则字节码（二进制负载，空负载清空）
+ *      - xn/web/watering/<device_id>/get_rules   请求规则引擎状态
+ *      - xn/esp/watering/<device_id>/rules       JSON 状态（校验结果、求值耗时、决策延迟）
+ *      - xn/esp/watering/<device_id>/rule_event  NOTIFY 规则触发事件
+ *
+ * 传感器引脚默认未接（-1），对应输入无效；按实际硬件在编译选项中定义即可。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+
+#include "rule_engine.h"
+#include "watering_sched.h"
+#include "watering_sched_calc.h"
+#include "mqtt_outbox.h"
+#include "web_mqtt_manager.h"
+#include "mqtt_app/watering_app.h"
+#include "mqtt_app/rule_app.h"
+
+/* 土壤湿度传感器 ADC 通道（ADC1），-1 表示未接 */
+#ifndef WATERING_SOIL_ADC_CHANNEL
+#define WATERING_SOIL_ADC_CHANNEL   -1
+#endif
+#ifndef WATERING_SOIL_RAW_DRY
+#define WATERING_SOIL_RAW_DRY       3000        ///< 空气中的读数（0%）
+#endif
+#ifndef WATERING_SOIL_RAW_WET
+#define WATERING_SOIL_RAW_WET       1200        ///< 泡水时的读数（100%）
+#endif
+
+/* 雨量传感器 GPIO，-1 表示未接；常见模块检测到雨时输出低电平 */
+#ifndef WATERING_RAIN_GPIO
+#define WATERING_RAIN_GPIO          -1
+#endif
+#ifndef WATERING_RAIN_ACTIVE_LEVEL
+#define WATERING_RAIN_ACTIVE_LEVEL  0
+#endif
+
+#if WATERING_SOIL_ADC_CHANNEL >= 0
+#include "esp_adc/adc_oneshot.h"
+#endif
+
+static const char *TAG = "rule_app";
+
+#define RULE_TICK_MS     1000
+
+static bool    s_rule_running[RULE_ENGINE_MAX_ZONES];   ///< 区域是否由 RUN 规则开启
+static int64_t s_last_rain_us = -1;
+static char    s_last_err[16] = "";
+static uint16_t s_last_err_off;
+
+#if WATERING_SOIL_ADC_CHANNEL >= 0
+static adc_oneshot_unit_handle_t s_adc;
+#endif
+
+/* -------------------- 输入 -------------------- */
+
+static int32_t read_soil(void *ctx, bool *valid)
+{
+    (void)ctx;
+#if WATERING_SOIL_ADC_CHANNEL >= 0
+    int raw = 0;
+    if (s_adc == NULL || adc_oneshot_read(s_adc, (adc_channel_t)WATERING_SOIL_ADC_CHANNEL, &raw) != ESP_OK) {
+        *valid = false;
+        return 0;
+    }
+    int32_t pct = (int32_t)(WATERING_SOIL_RAW_DRY - raw) * 100 / (WATERING_SOIL_RAW_DRY - WATERING_SOIL_RAW_WET);
+    return pct < 0 ? 0 : (pct > 100 ? 100 : pct);
+#else
+    *valid = false;
+    return 0;
+#endif
+}
+
+static bool rain_now(bool *valid)
+{
+#if WATERING_RAIN_GPIO >= 0
+    bool raining = gpio_get_level((gpio_num_t)WATERING_RAIN_GPIO) == WATERING_RAIN_ACTIVE_LEVEL;
+    if (raining) {
+        s_last_rain_us = esp_timer_get_time();
+    }
+    return raining;
+#else
+    *valid = false;
+    return false;
+#endif
+}
+
+static int32_t read_rain(void *ctx, bool *valid)
+{
+    (void)ctx;
+    return rain_now(valid) ? 1 : 0;
+}
+
+static int32_t read_rain_ago(void *ctx, bool *valid)
+{
+    (void)ctx;
+    if (rain_now(valid)) {
+        return 0;
+    }
+    if (s_last_rain_us < 0) {
+        return INT32_MAX;
+    }
+    int64_t ago = (esp_timer_get_time() - s_last_rain_us) / 1000000;
+    return ago > INT32_MAX ? INT32_MAX : (int32_t)ago;
+}
+
+static int32_t read_local_time(void *ctx, bool *valid)
+{
+    time_t now = time(NULL);
+    struct tm tm;
+    if (!watering_sched_time_valid(now) || localtime_r(&now, &tm) == NULL) {
+        *valid = false;
+        return 0;
+    }
+
+    switch ((rule_app_input_t)(uintptr_t)ctx) {
+    case RULE_IN_HOUR:
+        return tm.tm_hour;
+    case RULE_IN_MINUTE:
+        return tm.tm_min;
+    default:
+        return (tm.tm_wday + 6) % 7;
+    }
+}
+
+static int32_t read_zone_on(void *ctx, bool *valid)
+{
+    (void)valid;
+    return watering_sched_zone_is_on((uint8_t)(uintptr_t)ctx) ? 1 : 0;
+}
+
+static int32_t read_today_s(void *ctx, bool *valid)
+{
+    (void)valid;
+    return (int32_t)watering_sched_zone_today_s((uint8_t)(uintptr_t)ctx);
+}
+
+/* -------------------- 决策 -------------------- */
+
+static void rule_zone_cb(uint8_t zone, bool run, uint16_t max_s, bool inhibit, void *ctx)
+{
+    (void)ctx;
+
+    (void)watering_sched_set_inhibit(zone, inhibit);
+
+    if (run && !s_rule_running[zone]) {
+        /* 参数 0 表示规则为真期间一直开启；超过调度引擎上限的按上限处理 */
+        uint32_t dur = max_s > WATERING_SCHED_MAX_DURATION_S ? WATERING_SCHED_MAX_DURATION_S : max_s;
+        if (watering_sched_set_zone(zone, true, dur) == ESP_OK) {
+            s_rule_running[zone] = true;
+        }
+    } else if (!run && s_rule_running[zone]) {
+        s_rule_running[zone] = false;
+        (void)watering_sched_set_zone(zone, false, 0);
+    }
+}
+
+static int rule_topic(char *topic, size_t size, const char *leaf)
+{
+    const char *client_id = web_mqtt_manager_get_client_id();
+    if (client_id == NULL || client_id[0] == '\0') {
+        return -1;
+    }
+
+    int n = snprintf(topic, size, "%s/watering/%s/%s", WEB_MQTT_UPLINK_BASE_TOPIC, client_id, leaf);
+    return (n <= 0 || n >= (int)size) ? -1 : n;
+}
+
+static void rule_notify_cb(uint8_t rule, uint16_t code, void *ctx)
+{
+    (void)ctx;
+
+    char topic[128];
+    if (rule_topic(topic, sizeof(topic), "rule_event") < 0) {
+        return;
+    }
+
+    char json[64];
+    snprintf(json, sizeof(json), "{\"rule\":%u,\"code\":%u}", (unsigned)rule, (unsigned)code);
+
+    /* 事件每条都要送达，不合并 */
+    (void)mqtt_outbox_publish(topic, json, (int)strlen(json), 1, false, MQTT_OUTBOX_PRIO_HIGH, NULL);
+}
+
+/* -------------------- MQTT -------------------- */
+
+void rule_app_publish_status(void)
+{
+    char topic[128];
+    if (rule_topic(topic, sizeof(topic), "rules") < 0) {
+        return;
+    }
+
+    rule_engine_stats_t st;
+    if (rule_engine_get_stats(&st) != ESP_OK) {
+        return;
+    }
+
+    char json[384];
+    snprintf(json,
+             sizeof(json),
+             "{\"rules\":%u,\"bytes\":%u,\"err\":\"%s\",\"err_at\":%u,\"ticks\":%u,\"ops\":%u,"
+             "\"sample_us\":%u,\"eval_us\":%u,\"eval_us_avg\":%u,\"eval_us_max\":%u,"
+             "\"decisions\":%u,\"latency_us\":%u,\"latency_us_max\":%u,\"unknown\":%u,\"overruns\":%u}",
+             (unsigned)st.rules, (unsigned)st.program_size, s_last_err, (unsigned)s_last_err_off,
+             (unsigned)st.ticks, (unsigned)st.ops_last,
+             (unsigned)st.sample_us_last, (unsigned)st.eval_us_last, (unsigned)st.eval_us_avg,
+             (unsigned)st.eval_us_max, (unsigned)st.decisions, (unsigned)st.latency_us_last,
+             (unsigned)st.latency_us_max, (unsigned)st.unknown, (unsigned)st.overruns);
+
+    (void)mqtt_outbox_publish(topic, json, (int)strlen(json), 1, false,
+                              MQTT_OUTBOX_PRIO_NORMAL, "watering/rules");
+}
+
+void rule_app_handle_load(const uint8_t *payload, int payload_len)
+{
+    rule_vm_err_t err     = RULE_VM_OK;
+    uint16_t      err_off = 0;
+
+    esp_err_t ret = rule_engine_load(payload, payload_len > 0 ? (size_t)payload_len : 0, true, &err, &err_off);
+    if (ret == ESP_ERR_INVALID_ARG) {
+        snprintf(s_last_err, sizeof(s_last_err), "%s", rule_vm_err_name(err));
+        s_last_err_off = err_off;
+        ESP_LOGW(TAG, "rules rejected: %s at %u", s_last_err, (unsigned)err_off);
+    } else {
+        s_last_err[0]  = '\0';
+        s_last_err_off = 0;
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "rules active but not saved: %s", esp_err_to_name(ret));
+        }
+    }
+
+    rule_app_publish_status();
+}
+
+/* -------------------- 初始化 -------------------- */
+
+static void rule_sensor_init(void)
+{
+#if WATERING_SOIL_ADC_CHANNEL >= 0
+    adc_oneshot_unit_init_cfg_t unit_cfg = { .unit_id = ADC_UNIT_1 };
+    adc_oneshot_chan_cfg_t      chan_cfg = { .atten = ADC_ATTEN_DB_12, .bitwidth = ADC_BITWIDTH_DEFAULT };
+    if (adc_oneshot_new_unit(&unit_cfg, &s_adc) != ESP_OK ||
+        adc_oneshot_config_channel(s_adc, (adc_channel_t)WATERING_SOIL_ADC_CHANNEL, &chan_cfg) != ESP_OK) {
+        ESP_LOGE(TAG, "soil ADC init failed");
+        s_adc = NULL;
+    }
+#endif
+
+#if WATERING_RAIN_GPIO >= 0
+    gpio_config_t io_conf = {0};
+    io_conf.intr_type    = GPIO_INTR_DISABLE;
+    io_conf.mode         = GPIO_MODE_INPUT;
+    io_conf.pin_bit_mask = 1ULL << WATERING_RAIN_GPIO;
+    io_conf.pull_up_en   = WATERING_RAIN_ACTIVE_LEVEL == 0;
+    io_conf.pull_down_en = 0;
+    gpio_config(&io_conf);
+#endif
+}
+
+esp_err_t rule_app_init(void)
+{
+    rule_sensor_init();
+
+    uint8_t zones = watering_app_zone_count();
+    if (zones > RULE_ENGINE_MAX_ZONES) {
+        zones = RULE_ENGINE_MAX_ZONES;
+    }
+
+    rule_engine_register_input(RULE_IN_SOIL,     read_soil,       NULL);
+    rule_engine_register_input(RULE_IN_RAIN,     read_rain,       NULL);
+    rule_engine_register_input(RULE_IN_RAIN_AGO, read_rain_ago,   NULL);
+    rule_engine_register_input(RULE_IN_HOUR,     read_local_time, (void *)(uintptr_t)RULE_IN_HOUR);
+    rule_engine_register_input(RULE_IN_MINUTE,   read_local_time, (void *)(uintptr_t)RULE_IN_MINUTE);
+    rule_engine_register_input(RULE_IN_WDAY,     read_local_time, (void *)(uintptr_t)RULE_IN_WDAY);
+    for (uint8_t z = 0; z < zones; z++) {
+        rule_engine_register_input(RULE_IN_ZONE_ON + z, read_zone_on, (void *)(uintptr_t)z);
+        rule_engine_register_input(RULE_IN_TODAY_S + z, read_today_s, (void *)(uintptr_t)z);
+    }
+
+    rule_engine_config_t cfg = RULE_ENGINE_DEFAULT_CONFIG(rule_zone_cb);
+    cfg.notify_cb  = rule_notify_cb;
+    cfg.zone_count = zones;
+    cfg.tick_ms    = RULE_TICK_MS;
+
+    esp_err_t ret = rule_engine_init(&cfg);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "rule engine init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    return ESP_OK;
+}
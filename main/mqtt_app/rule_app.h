@@ -0,0 +1,49 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-10 09:41:05
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-10 09:41:05
+ * @FilePath: \xn_esp32_coze_chat_watering\main\mqtt_app\rule_app.h
+ * @Description: 设备端浇花规则：输入注册、决策落到调度引擎、MQTT 下发字节码
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#ifndef RULE_APP_H
+#define RULE_APP_H
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+/**
+ * @brief 规则输入编号（与 xn_mqtt_server/lib/RuleCompiler.php 的名称表一致）
+ */
+typedef enum {
+    RULE_IN_SOIL        = 0,    ///< 土壤湿度 %（0 干 ~ 100 湿），未接传感器时无效
+    RULE_IN_RAIN        = 1,    ///< 雨量传感器当前是否检测到雨（0 / 1），未接时无效
+    RULE_IN_RAIN_AGO    = 2,    ///< 距上次检测到雨的秒数，上电后没下过雨为 INT32_MAX
+    RULE_IN_HOUR        = 3,    ///< 本地时间：时，时钟未同步时无效
+    RULE_IN_MINUTE      = 4,    ///< 本地时间：分
+    RULE_IN_WDAY        = 5,    ///< 本地星期：0=周一 ... 6=周日
+    RULE_IN_ZONE_ON     = 8,    ///< + 区域号：区域是否开启
+    RULE_IN_TODAY_S     = 16,   ///< + 区域号：区域今天累计开启秒数
+} rule_app_input_t;
+
+/**
+ * @brief 注册输入并启动规则引擎（在 watering_app_init 之后调用）
+ */
+esp_err_t rule_app_init(void);
+
+/**
+ * @brief 处理 xn/web/watering/<device_id>/rules：负载为规则字节码，空负载清空规则
+ *
+ * 处理结果（校验错误、规则数）随状态一起回报到 xn/esp/watering/<device_id>/rules。
+ */
+void rule_app_handle_load(const uint8_t *payload, int payload_len);
+
+/**
+ * @brief 回报规则引擎状态（规则数、每周期求值耗时、决策延迟等）
+ */
+void rule_app_publish_status(void);
+
+#endif /* RULE_APP_H */
@@ -0,0 +1,167 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-08 09:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-08 09:12:40
+ * @FilePath: \xn_esp32_coze_chat_watering\main\mqtt_app\telemetry_app.c
+ * @Description: 设备遥测指标注册
+ *
+ * legacy_topic 对应旧版承载同样字段的 JSON Topic，仅用于遥测模块的字节对比统计。
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+
+#include <stddef.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_wifi.h"
+
+#include "telemetry.h"
+#include "mqtt_outbox.h"
+#include "rule_engine.h"
+#include "mqtt_app/watering_app.h"
+#include "mqtt_app/telemetry_app.h"
+
+static const char *TAG = "telemetry_app";
+
+typedef enum {
+    PLAN_FIELD_ENABLED = 0,
+    PLAN_FIELD_DAYS,
+    PLAN_FIELD_HOUR,
+    PLAN_FIELD_MINUTE,
+    PLAN_FIELD_DURATION,
+} plan_field_t;
+
+typedef enum {
+    RULE_FIELD_EVAL_US = 0,
+    RULE_FIELD_DECISIONS,
+} rule_field_t;
+
+typedef enum {
+    OUTBOX_FIELD_DEPTH = 0,
+    OUTBOX_FIELD_DROPPED,
+    OUTBOX_FIELD_PENDING,
+} outbox_field_t;
+
+static int32_t read_uptime_s(void *ctx)
+{
+    (void)ctx;
+    return (int32_t)(esp_timer_get_time() / 1000000);
+}
+
+/* 堆余量按 KB 上报，避免每周期几十字节的抖动都产生增量 */
+static int32_t read_heap_kb(void *ctx)
+{
+    return (int32_t)(heap_caps_get_free_size((uint32_t)(uintptr_t)ctx) / 1024);
+}
+
+static int32_t read_wifi_rssi(void *ctx)
+{
+    (void)ctx;
+    wifi_ap_record_t ap_info = {0};
+    if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
+        return 0;
+    }
+    return ap_info.rssi;
+}
+
+static int32_t read_wifi_conn(void *ctx)
+{
+    (void)ctx;
+    wifi_ap_record_t ap_info = {0};
+    return (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK && ap_info.ssid[0] != '\0') ? 1 : 0;
+}
+
+static int32_t read_water_on(void *ctx)
+{
+    (void)ctx;
+    return watering_app_is_on() ? 1 : 0;
+}
+
+static int32_t read_plan(void *ctx)
+{
+    watering_plan_t plan;
+    if (watering_app_get_plan(&plan) != ESP_OK) {
+        return 0;
+    }
+
+    switch ((plan_field_t)(uintptr_t)ctx) {
+    case PLAN_FIELD_ENABLED:
+        return plan.enabled ? 1 : 0;
+    case PLAN_FIELD_DAYS:
+        return plan.days_mask;
+    case PLAN_FIELD_HOUR:
+        return plan.hour;
+    case PLAN_FIELD_MINUTE:
+        return plan.minute;
+    case PLAN_FIELD_DURATION:
+        return plan.duration_s;
+    default:
+        return 0;
+    }
+}
+
+static int32_t read_outbox(void *ctx)
+{
+    mqtt_outbox_stats_t st;
+    if (mqtt_outbox_get_stats(&st, false) != ESP_OK) {
+        return 0;
+    }
+
+    switch ((outbox_field_t)(uintptr_t)ctx) {
+    case OUTBOX_FIELD_DEPTH:
+        return (int32_t)st.depth;
+    case OUTBOX_FIELD_DROPPED:
+        return (int32_t)st.dropped;
+    case OUTBOX_FIELD_PENDING:
+        return (int32_t)st.flash_pending;
+    default:
+        return 0;
+    }
+}
+
+static int32_t read_rules(void *ctx)
+{
+    rule_engine_stats_t st;
+    if (rule_engine_get_stats(&st) != ESP_OK) {
+        return 0;
+    }
+    return (rule_field_t)(uintptr_t)ctx == RULE_FIELD_EVAL_US ? (int32_t)st.eval_us_max : (int32_t)st.decisions;
+}
+
+#define METRIC(n, t, cb, c, legacy) \
+    { .name = (n), .type = (t), .read = (cb), .ctx = (void *)(uintptr_t)(c), .legacy_topic = (legacy) }
+
+static const telemetry_metric_t s_metrics[] = {
+    METRIC("uptime_s",    TELEMETRY_COUNTER, read_uptime_s,  0,                     "hb"),
+    METRIC("heap_int_kb", TELEMETRY_GAUGE,   read_heap_kb,   MALLOC_CAP_INTERNAL,   NULL),
+    METRIC("psram_kb",    TELEMETRY_GAUGE,   read_heap_kb,   MALLOC_CAP_SPIRAM,     NULL),
+    METRIC("wifi_rssi",   TELEMETRY_GAUGE,   read_wifi_rssi, 0,                     "wifi/status"),
+    METRIC("wifi_conn",   TELEMETRY_ENUM,    read_wifi_conn, 0,                     "wifi/status"),
+    METRIC("water_on",    TELEMETRY_ENUM,    read_water_on,  0,                     "watering/status"),
+    METRIC("plan_en",     TELEMETRY_ENUM,    read_plan,      PLAN_FIELD_ENABLED,    "watering/plan"),
+    METRIC("plan_days",   TELEMETRY_ENUM,    read_plan,      PLAN_FIELD_DAYS,       "watering/plan"),
+    METRIC("plan_hour",   TELEMETRY_ENUM,    read_plan,      PLAN_FIELD_HOUR,       "watering/plan"),
+    METRIC("plan_min",    TELEMETRY_ENUM,    read_plan,      PLAN_FIELD_MINUTE,     "watering/plan"),
+    METRIC("plan_dur_s",  TELEMETRY_GAUGE,   read_plan,      PLAN_FIELD_DURATION,   "watering/plan"),
+    METRIC("obx_depth",   TELEMETRY_GAUGE,   read_outbox,    OUTBOX_FIELD_DEPTH,    NULL),
+    METRIC("obx_dropped", TELEMETRY_COUNTER, read_outbox,    OUTBOX_FIELD_DROPPED,  NULL),
+    METRIC("obx_pending", TELEMETRY_GAUGE,   read_outbox,    OUTBOX_FIELD_PENDING,  NULL),
+    METRIC("rule_us_max", TELEMETRY_GAUGE,   read_rules,     RULE_FIELD_EVAL_US,    NULL),
+    METRIC("rule_dec",    TELEMETRY_COUNTER, read_rules,     RULE_FIELD_DECISIONS,  NULL),
+};
+
+esp_err_t telemetry_app_init(void)
+{
+    for (size_t i = 0; i < sizeof(s_metrics) / sizeof(s_metrics[0]); i++) {
+        esp_err_t ret = telemetry_register(&s_metrics[i], NULL);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "register %s failed: %s", s_metrics[i].name, esp_err_to_name(ret));
+            return ret;
+        }
+    }
+
+    return telemetry_start(NULL);
+}
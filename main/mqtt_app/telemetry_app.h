@@ -0,0 +1,23 @@
+/*
+ * @Author: 星年 && jixingnian@gmail.com
+ * @Date: 2025-12-08 09:12:40
+ * @LastEditors: xingnian jixingnian@gmail.com
+ * @LastEditTime: 2025-12-08 09:12:40
+ * @FilePath: \xn_esp32_coze_chat_watering\main\mqtt_app\telemetry_app.h
+ * @Description: 设备遥测指标注册（堆、WiFi、浇花状态与计划、发件箱）
+ *
+ * Copyright (c) 2025 by ${git_name_email}, All Rights Reserved.
+ */
+#ifndef TELEMETRY_APP_H
+#define TELEMETRY_APP_H
+
+#include "esp_err.h"
+
+/**
+ * @brief 注册设备遥测指标并启动批量遥测任务
+ *
+ * 须在 web_mqtt_manager_init 之后调用；批次发布到 xn/esp/telemetry/<device_id>。
+ */
+esp_err_t telemetry_app_init(void);
+
+#endif /* TELEMETRY_APP_H */
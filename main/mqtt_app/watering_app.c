@@ -4,66 +4,81 @@
  *
  * 职责：
  *  - 订阅 Web 下发的浇花相关 Topic（基于 base_topic = "xn/web"）：
- *      - xn/web/watering/<device_id>/set        下发浇花开关命令（payload: "on" / "off"）
+ *      - xn/web/watering/<device_id>/set        下发浇花开关命令（payload: "on" / "off" / "dose=<ml>"，可加 "N:" 区域前缀）
  *      - xn/web/watering/<device_id>/get_status 请求当前浇花开关状态
+ *      - xn/web/watering/<device_id>/set_plan   新增 / 修改 / 删除定时计划（key=value 行，id= 指定计划）
+ *      - xn/web/watering/<device_id>/get_plan   请求定时计划（payload 为空回报全部，"id=N" 回报一个）
+ *      - xn/web/watering/<device_id>/rules      下发本地规则字节码 / get_rules 请求规则状态（见 rule_app.c）
  *  - 将结果通过上行前缀 WEB_MQTT_UPLINK_BASE_TOPIC（"xn/esp"）回报给服务器：
  *      - xn/esp/watering/<device_id>/status     JSON 格式的当前浇花状态
+ *      - xn/esp/watering/<device_id>/plan       JSON 格式的计划（含下次开始时刻 next）
+ *      - xn/esp/watering/<device_id>/cycle      每次浇水结束的实际时长 / 水量 / 误差 / CPU 唤醒次数
+ *  - 定时与多区域开关交给 xn_watering_sched 调度引擎，输出交给 xn_pump_driver：
+ *    LEDC 软启停、esp_timer 硬件定时关断、可选 PCNT 流量计定量、最长开启时间失效保护
  */
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <time.h>
 
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
-
 #include "esp_log.h"
 #include "driver/gpio.h"
 
-#include "mqtt_module.h"
+#include "watering_sched.h"
+#include "pump_driver.h"
+#include "bsp_board_pins.h"
+
+#include "mqtt_outbox.h"
 #include "web_mqtt_manager.h"
 #include "mqtt_app_module.h"
 #include "mqtt_app/watering_app.h"
+#include "mqtt_app/rule_app.h"
 
 static const char *TAG = "watering_app";
 
-/* 浇花电机控制 GPIO，可按实际硬件修改 */
+/* 浇花电机控制 GPIO，可按实际硬件修改（GPIO4 是板载触摸中断 TP_INT，不可使用） */
 #ifndef WATERING_MOTOR_GPIO
-#define WATERING_MOTOR_GPIO GPIO_NUM_4
+#define WATERING_MOTOR_GPIO GPIO_NUM_6
 #endif
 
-static bool s_gpio_inited  = false;
-static bool s_watering_on  = false;
+/* 各区域的电机 / 电磁阀 GPIO，下标即区域编号；默认只有区域 0 */
+#ifndef WATERING_ZONE_GPIOS
+#define WATERING_ZONE_GPIOS { WATERING_MOTOR_GPIO }
+#endif
 
-typedef struct {
-    bool enabled;
-    int  days_mask;  /* bit0=Mon ... bit6=Sun */
-    int  hour;
-    int  minute;
-    int  duration_s;
-} watering_plan_t;
+/* 各区域的流量计脉冲输入 GPIO，-1 表示没有流量计（定量按额定流量换算为时长）；表短于区域数时其余区域视为没有 */
+#ifndef WATERING_FLOW_GPIOS
+#define WATERING_FLOW_GPIOS { -1 }
+#endif
 
-static watering_plan_t s_plan      = { false, 0x7F, 8, 0, 10 };
-static TaskHandle_t    s_plan_task = NULL;
+/* 流量计 K 系数（脉冲 / 升），YF-S201 约 450 */
+#ifndef WATERING_FLOW_PULSES_PER_L
+#define WATERING_FLOW_PULSES_PER_L 450
+#endif
 
-static void watering_gpio_init(void)
-{
-    if (s_gpio_inited) {
-        return;
-    }
+/* 水泵额定流量（ml / 分钟），没有流量计时用于体积换算与水量估算 */
+#ifndef WATERING_PUMP_ML_PER_MIN
+#define WATERING_PUMP_ML_PER_MIN 1000
+#endif
 
-    gpio_config_t io_conf = {0};
-    io_conf.intr_type    = GPIO_INTR_DISABLE;
-    io_conf.mode         = GPIO_MODE_OUTPUT;
-    io_conf.pin_bit_mask = 1ULL << WATERING_MOTOR_GPIO;
-    io_conf.pull_down_en = 0;
-    io_conf.pull_up_en   = 0;
-    gpio_config(&io_conf);
+/* 软启动 / 软停止斜坡，驱动继电器时设为 0 */
+#ifndef WATERING_PUMP_RAMP_MS
+#define WATERING_PUMP_RAMP_MS 300
+#endif
 
-    gpio_set_level(WATERING_MOTOR_GPIO, 0);
-    s_gpio_inited = true;
-}
+static const gpio_num_t s_zone_gpios[] = WATERING_ZONE_GPIOS;
+static const int        s_flow_gpios[] = WATERING_FLOW_GPIOS;
+#define WATERING_ZONE_COUNT ((uint8_t)(sizeof(s_zone_gpios) / sizeof(s_zone_gpios[0])))
+#define WATERING_FLOW_COUNT (sizeof(s_flow_gpios) / sizeof(s_flow_gpios[0]))
+
+_Static_assert(sizeof(s_zone_gpios) / sizeof(s_zone_gpios[0]) <= PUMP_DRIVER_MAX_CHANNELS,
+               "too many watering zones for pump driver");
+
+static pump_channel_config_t s_pump_channels[sizeof(s_zone_gpios) / sizeof(s_zone_gpios[0])];
+static uint32_t              s_dose_ml[sizeof(s_zone_gpios) / sizeof(s_zone_gpios[0])];  ///< 下次开启的定量
+static uint8_t               s_zone_mask;                                                  ///< 已回报的开关状态
 
 static void watering_publish_status(void)
 {
@@ -82,16 +97,26 @@ static void watering_publish_status(void)
         return;
     }
 
+    int zones = 0;
+    for (uint8_t i = 0; i < WATERING_ZONE_COUNT; i++) {
+        if (watering_sched_zone_is_on(i)) {
+            zones |= 1 << i;
+        }
+    }
+
     char json[64];
     snprintf(json,
              sizeof(json),
-             "{\"on\":%s}",
-             s_watering_on ? "true" : "false");
+             "{\"on\":%s,\"zones\":%d}",
+             (zones & 1) ? "true" : "false",
+             zones);
 
-    (void)mqtt_module_publish(topic, json, (int)strlen(json), 1, false);
+    /* 开关状态只关心最新值，断线期间多次切换只在重连后上报最后一次 */
+    (void)mqtt_outbox_publish(topic, json, (int)strlen(json), 1, false,
+                              MQTT_OUTBOX_PRIO_HIGH, "watering/status");
 }
 
-static void watering_publish_plan(void)
+static void watering_publish_plan(uint8_t id)
 {
     const char *client_id = web_mqtt_manager_get_client_id();
     if (client_id == NULL || client_id[0] == '\0') {
@@ -108,149 +133,164 @@ static void watering_publish_plan(void)
         return;
     }
 
-    watering_plan_t plan = s_plan;
+    watering_sched_plan_t plan;
+    time_t                next = 0;
+    bool                  used = watering_sched_get_plan(id, &plan, &next) == ESP_OK;
+
+    char json[192];
+    if (used) {
+        snprintf(json,
+                 sizeof(json),
+                 "{\"id\":%u,\"enabled\":%s,\"zone\":%u,\"days_mask\":%u,\"hour\":%u,\"minute\":%u,"
+                 "\"duration_s\":%u,\"next\":%lld}",
+                 (unsigned)id,
+                 plan.enabled ? "true" : "false",
+                 (unsigned)plan.zone,
+                 (unsigned)plan.days_mask,
+                 (unsigned)plan.hour,
+                 (unsigned)plan.minute,
+                 (unsigned)plan.duration_s,
+                 (long long)next);
+    } else {
+        snprintf(json, sizeof(json), "{\"id\":%u,\"deleted\":true}", (unsigned)id);
+    }
+
+    /* 每个计划单独一个合并键，多次修改同一计划只保留最新 */
+    char key[24];
+    snprintf(key, sizeof(key), "watering/plan/%u", (unsigned)id);
 
-    char json[160];
-    snprintf(json,
-             sizeof(json),
-             "{\"enabled\":%s,\"days_mask\":%d,\"hour\":%d,\"minute\":%d,\"duration_s\":%d}",
-             plan.enabled ? "true" : "false",
-             plan.days_mask,
-             plan.hour,
-             plan.minute,
-             plan.duration_s);
-
-    (void)mqtt_module_publish(topic, json, (int)strlen(json), 1, false);
+    (void)mqtt_outbox_publish(topic, json, (int)strlen(json), 1, false,
+                              MQTT_OUTBOX_PRIO_NORMAL, key);
 }
 
-static void watering_set_state(bool on)
+static const char *watering_stop_reason_name(pump_stop_reason_t reason)
 {
-    watering_gpio_init();
-
-    gpio_set_level(WATERING_MOTOR_GPIO, on ? 1 : 0);
-    s_watering_on = on;
-
-    ESP_LOGI(TAG, "set watering %s", on ? "ON" : "OFF");
-
-    watering_publish_status();
+    switch (reason) {
+    case PUMP_STOP_COMMAND:  return "command";
+    case PUMP_STOP_TIME:     return "time";
+    case PUMP_STOP_VOLUME:   return "volume";
+    case PUMP_STOP_FAILSAFE: return "failsafe";
+    case PUMP_STOP_RESTART:  return "restart";
+    default:                 return "unknown";
+    }
 }
 
-static void watering_plan_task(void *arg)
+static void watering_publish_cycle(const pump_cycle_report_t *r)
 {
-    (void)arg;
-
-    for (;;) {
-        watering_plan_t plan = s_plan;
-
-        if (!plan.enabled || plan.duration_s <= 0) {
-            vTaskDelay(pdMS_TO_TICKS(10000));
-            continue;
-        }
-
-        time_t    now = 0;
-        struct tm tm_now;
-        memset(&tm_now, 0, sizeof(tm_now));
-
-        if (time(&now) < 0 || localtime_r(&now, &tm_now) == NULL) {
-            vTaskDelay(pdMS_TO_TICKS(60000));
-            continue;
-        }
-
-        int week_min = 7 * 24 * 60;
-
-        int now_wday = tm_now.tm_wday;
-        if (now_wday < 0 || now_wday > 6) {
-            now_wday = 0;
-        }
-
-        int now_total_min = now_wday * 24 * 60 + tm_now.tm_hour * 60 + tm_now.tm_min;
-
-        int days_mask = plan.days_mask;
-        if (days_mask <= 0) {
-            vTaskDelay(pdMS_TO_TICKS(10000));
-            continue;
-        }
-
-        int plan_hour = plan.hour;
-        if (plan_hour < 0) {
-            plan_hour = 0;
-        }
-        if (plan_hour > 23) {
-            plan_hour = 23;
-        }
-
-        int plan_minute = plan.minute;
-        if (plan_minute < 0) {
-            plan_minute = 0;
-        }
-        if (plan_minute > 59) {
-            plan_minute = 59;
-        }
-
-        int best_diff_min = week_min;
+    const char *client_id = web_mqtt_manager_get_client_id();
+    if (client_id == NULL || client_id[0] == '\0') {
+        return;
+    }
 
-        for (int d = 1; d <= 7; d++) {
-            if ((days_mask & (1 << (d - 1))) == 0) {
-                continue;
-            }
+    char topic[128];
+    int  n = snprintf(topic,
+                      sizeof(topic),
+                      "%s/watering/%s/cycle",
+                      WEB_MQTT_UPLINK_BASE_TOPIC,
+                      client_id);
+    if (n <= 0 || n >= (int)sizeof(topic)) {
+        return;
+    }
 
-            int plan_total_min = (d - 1) * 24 * 60 + plan_hour * 60 + plan_minute;
-            int diff_min;
-            if (plan_total_min > now_total_min) {
-                diff_min = plan_total_min - now_total_min;
-            } else {
-                diff_min = week_min - (now_total_min - plan_total_min);
-            }
+    char json[256];
+    snprintf(json,
+             sizeof(json),
+             "{\"zone\":%u,\"reason\":\"%s\",\"on_ms\":%u,\"req_ms\":%u,\"ml\":%u,\"target_ml\":%u,"
+             "\"measured\":%s,\"pulses\":%u,\"err_permille\":%d,\"wakeups\":%u}",
+             (unsigned)r->channel,
+             watering_stop_reason_name(r->reason),
+             (unsigned)r->on_ms,
+             (unsigned)r->requested_ms,
+             (unsigned)r->delivered_ml,
+             (unsigned)r->target_ml,
+             r->measured ? "true" : "false",
+             (unsigned)r->pulses,
+             (int)r->error_permille,
+             (unsigned)r->wakeups);
+
+    /* 每次浇水一条记录，不合并 */
+    (void)mqtt_outbox_publish(topic, json, (int)strlen(json), 1, false,
+                              MQTT_OUTBOX_PRIO_NORMAL, NULL);
+}
 
-            if (diff_min < best_diff_min) {
-                best_diff_min = diff_min;
-            }
-        }
+/**
+ * @brief 水泵周期结束回调（驱动任务中执行）
+ */
+static void watering_pump_report_cb(const pump_cycle_report_t *report, void *ctx)
+{
+    (void)ctx;
 
-        if (best_diff_min <= 0 || best_diff_min > week_min) {
-            best_diff_min = 1;
-        }
+    /* 定量达到 / 硬件定时到点 / 失效保护先于调度引擎结束时，同步调度引擎的区域状态 */
+    if (report->reason != PUMP_STOP_COMMAND && report->reason != PUMP_STOP_RESTART &&
+        !pump_driver_is_on(report->channel)) {
+        (void)watering_sched_set_zone(report->channel, false, 0);
+    }
 
-        int64_t diff_ms = (int64_t)best_diff_min * 60 * 1000;
-        if (diff_ms <= 0) {
-            diff_ms = 1000;
-        }
+    watering_publish_cycle(report);
+}
 
-        vTaskDelay(pdMS_TO_TICKS((uint32_t)diff_ms));
+/**
+ * @brief 调度引擎的区域开关回调：交给水泵驱动并上报状态（在调度引擎锁内调用，不可回调引擎接口）
+ *
+ * 已开启区域的关闭时刻变化也会回调，此时只刷新水泵驱动的硬件定时。
+ */
+static void watering_zone_cb(uint8_t zone, bool on, uint32_t duration_s, void *ctx)
+{
+    (void)ctx;
 
-        plan = s_plan;
-        if (!plan.enabled || plan.duration_s <= 0) {
-            continue;
-        }
+    if (zone >= WATERING_ZONE_COUNT) {
+        return;
+    }
 
-        watering_set_state(true);
+    esp_err_t ret;
+    if (on) {
+        uint32_t dose_ml = s_dose_ml[zone];
+        s_dose_ml[zone]  = 0;
+        ret = pump_driver_start(zone, duration_s * 1000, dose_ml);
+    } else {
+        ret = pump_driver_stop(zone);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "pump zone %u %s failed: %s", (unsigned)zone, on ? "start" : "stop", esp_err_to_name(ret));
+    }
 
-        int64_t dur_ms = (int64_t)plan.duration_s * 1000;
-        if (dur_ms <= 0) {
-            dur_ms = 1000;
-        }
+    uint8_t mask = on ? (uint8_t)(s_zone_mask | (1u << zone)) : (uint8_t)(s_zone_mask & ~(1u << zone));
+    if (mask == s_zone_mask) {
+        return;
+    }
+    s_zone_mask = mask;
 
-        vTaskDelay(pdMS_TO_TICKS((uint32_t)dur_ms));
+    ESP_LOGI(TAG, "set watering zone %u %s (%u s)", (unsigned)zone, on ? "ON" : "OFF", (unsigned)duration_s);
 
-        watering_set_state(false);
-    }
+    watering_publish_status();
 }
 
-static void watering_ensure_plan_task(void)
+/**
+ * @brief 按体积浇水：调度引擎的时长只作为兜底（开环换算时长的 2 倍 + 10 s）
+ */
+static esp_err_t watering_start_dose(uint8_t zone, uint32_t ml)
 {
-    if (s_plan_task != NULL) {
-        return;
+    if (zone >= WATERING_ZONE_COUNT || ml == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (watering_sched_zone_is_on(zone)) {
+        return ESP_ERR_INVALID_STATE;               ///< 定量只在区域关闭时开始
     }
 
-    BaseType_t ret = xTaskCreate(watering_plan_task,
-                                 "watering_plan",
-                                 2048,
-                                 NULL,
-                                 tskIDLE_PRIORITY + 1,
-                                 &s_plan_task);
-    if (ret != pdPASS) {
-        s_plan_task = NULL;
+    uint32_t limit_s = (uint32_t)(((uint64_t)ml * 60 * 2) / WATERING_PUMP_ML_PER_MIN) + 10;
+    if (limit_s > WATERING_SCHED_MAX_DURATION_S) {
+        limit_s = WATERING_SCHED_MAX_DURATION_S;
     }
+
+    s_dose_ml[zone] = ml;
+    esp_err_t ret = watering_sched_set_zone(zone, true, limit_s);
+    s_dose_ml[zone] = 0;
+    return ret;
+}
+
+static int watering_clamp(int v, int lo, int hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
 }
 
 static void watering_handle_set(const uint8_t *payload, int payload_len)
@@ -279,12 +319,28 @@ static void watering_handle_set(const uint8_t *payload, int payload_len)
         }
     }
 
-    if (strcmp(buf, "on") == 0) {
-        watering_set_state(true);
-    } else if (strcmp(buf, "off") == 0) {
-        watering_set_state(false);
+    /* 可选的区域前缀："1:on" 控制区域 1，无前缀为区域 0 */
+    uint8_t     zone = 0;
+    const char *cmd  = buf;
+    if (buf[0] >= '0' && buf[0] <= '9' && buf[1] == ':') {
+        zone = (uint8_t)(buf[0] - '0');
+        cmd  = buf + 2;
+    }
+
+    esp_err_t ret;
+    if (strcmp(cmd, "on") == 0) {
+        ret = watering_sched_set_zone(zone, true, 0);
+    } else if (strncmp(cmd, "dose=", 5) == 0) {
+        ret = watering_start_dose(zone, (uint32_t)watering_clamp(atoi(cmd + 5), 1, 100000));
+    } else if (strcmp(cmd, "off") == 0) {
+        ret = watering_sched_set_zone(zone, false, 0);
     } else {
         ESP_LOGW(TAG, "unknown watering cmd: %s", buf);
+        return;
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "watering cmd %s failed: %s", buf, esp_err_to_name(ret));
     }
 }
 
@@ -307,7 +363,16 @@ static void watering_handle_set_plan(const uint8_t *payload, int payload_len)
     memcpy(buf, payload, (size_t)payload_len);
     buf[payload_len] = '\0';
 
-    watering_plan_t plan = s_plan;
+    /* 先找 id=，其余字段在该计划现有内容上修改；未指定 id 时为计划 0（兼容旧网页） */
+    uint8_t id = 0;
+    const char *id_line = strstr(buf, "id=");
+    if (id_line != NULL && (id_line == buf || id_line[-1] == '\n')) {
+        id = (uint8_t)watering_clamp(atoi(id_line + 3), 0, WATERING_SCHED_MAX_PLANS - 1);
+    }
+
+    watering_sched_plan_t plan = { false, 0, 0x7F, 8, 0, 10 };
+    (void)watering_sched_get_plan(id, &plan, NULL);
+    bool remove = false;
 
     char *line = buf;
     while (line != NULL && *line != '\0') {
@@ -323,53 +388,21 @@ static void watering_handle_set_plan(const uint8_t *payload, int payload_len)
         }
 
         if (strncmp(line, "enabled=", 8) == 0) {
-            int v = atoi(line + 8);
-            plan.enabled = (v != 0);
+            plan.enabled = (atoi(line + 8) != 0);
+        } else if (strncmp(line, "delete=", 7) == 0) {
+            remove = (atoi(line + 7) != 0);
+        } else if (strncmp(line, "zone=", 5) == 0) {
+            plan.zone = (uint8_t)watering_clamp(atoi(line + 5), 0, WATERING_ZONE_COUNT - 1);
         } else if (strncmp(line, "days_mask=", 10) == 0) {
-            int v = atoi(line + 10);
-            if (v < 0) {
-                v = 0;
-            }
-            if (v > 0x7F) {
-                v = 0x7F;
-            }
-            plan.days_mask = v;
+            plan.days_mask = (uint8_t)watering_clamp(atoi(line + 10), 0, 0x7F);
         } else if (strncmp(line, "weekday=", 8) == 0) {
-            int v = atoi(line + 8);
-            if (v < 1) {
-                v = 1;
-            }
-            if (v > 7) {
-                v = 7;
-            }
-            plan.days_mask = (1 << (v - 1));
+            plan.days_mask = (uint8_t)(1 << (watering_clamp(atoi(line + 8), 1, 7) - 1));
         } else if (strncmp(line, "hour=", 5) == 0) {
-            int v = atoi(line + 5);
-            if (v < 0) {
-                v = 0;
-            }
-            if (v > 23) {
-                v = 23;
-            }
-            plan.hour = v;
+            plan.hour = (uint8_t)watering_clamp(atoi(line + 5), 0, 23);
         } else if (strncmp(line, "minute=", 7) == 0) {
-            int v = atoi(line + 7);
-            if (v < 0) {
-                v = 0;
-            }
-            if (v > 59) {
-                v = 59;
-            }
-            plan.minute = v;
+            plan.minute = (uint8_t)watering_clamp(atoi(line + 7), 0, 59);
         } else if (strncmp(line, "duration_s=", 11) == 0) {
-            int v = atoi(line + 11);
-            if (v < 1) {
-                v = 1;
-            }
-            if (v > 600) {
-                v = 600;
-            }
-            plan.duration_s = v;
+            plan.duration_s = (uint16_t)watering_clamp(atoi(line + 11), 1, 600);
         }
 
         if (next == NULL) {
@@ -378,15 +411,43 @@ static void watering_handle_set_plan(const uint8_t *payload, int payload_len)
         line = next + 1;
     }
 
-    s_plan = plan;
+    esp_err_t ret;
+    if (remove) {
+        ret = watering_sched_delete_plan(id);
+    } else if (plan.days_mask == 0) {
+        /* 旧网页用 days_mask=0 表示不浇水，引擎要求掩码非空：保留原掩码并停用 */
+        plan.enabled   = false;
+        plan.days_mask = 0x7F;
+        ret = watering_sched_set_plan(id, &plan);
+    } else {
+        ret = watering_sched_set_plan(id, &plan);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "set plan %u failed: %s", (unsigned)id, esp_err_to_name(ret));
+    }
 
-    watering_publish_plan();
-    watering_ensure_plan_task();
+    watering_publish_plan(id);
 }
 
-static void watering_handle_get_plan(void)
+static void watering_handle_get_plan(const uint8_t *payload, int payload_len)
 {
-    watering_publish_plan();
+    char buf[16] = {0};
+    if (payload != NULL && payload_len > 0) {
+        memcpy(buf, payload, (size_t)(payload_len < (int)sizeof(buf) ? payload_len : (int)sizeof(buf) - 1));
+    }
+
+    /* "id=N" 只回报一个计划，否则回报全部已配置的计划 */
+    if (strncmp(buf, "id=", 3) == 0) {
+        watering_publish_plan((uint8_t)watering_clamp(atoi(buf + 3), 0, WATERING_SCHED_MAX_PLANS - 1));
+        return;
+    }
+
+    watering_sched_plan_t plan;
+    for (uint8_t id = 0; id < WATERING_SCHED_MAX_PLANS; id++) {
+        if (watering_sched_get_plan(id, &plan, NULL) == ESP_OK) {
+            watering_publish_plan(id);
+        }
+    }
 }
 
 static esp_err_t watering_app_on_message(const char    *topic,
@@ -439,16 +500,126 @@ static esp_err_t watering_app_on_message(const char    *topic,
     } else if (cmd_len == 8 && strncmp(cmd, "set_plan", 8) == 0) {
         watering_handle_set_plan(payload, payload_len);
     } else if (cmd_len == 8 && strncmp(cmd, "get_plan", 8) == 0) {
-        watering_handle_get_plan();
+        watering_handle_get_plan(payload, payload_len);
+    } else if (cmd_len == 5 && strncmp(cmd, "rules", 5) == 0) {
+        rule_app_handle_load(payload, payload_len);
+    } else if (cmd_len == 9 && strncmp(cmd, "get_rules", 9) == 0) {
+        rule_app_publish_status();
     }
 
     return ESP_OK;
 }
 
+static esp_err_t watering_pump_init(void)
+{
+    for (uint8_t i = 0; i < WATERING_ZONE_COUNT; i++) {
+        s_pump_channels[i] = (pump_channel_config_t) {
+            .gpio           = s_zone_gpios[i],
+            .flow_gpio      = i < WATERING_FLOW_COUNT ? s_flow_gpios[i] : -1,
+            .pulses_per_l   = WATERING_FLOW_PULSES_PER_L,
+            .nominal_ml_min = WATERING_PUMP_ML_PER_MIN,
+        };
+    }
+
+    pump_driver_config_t cfg = PUMP_DRIVER_DEFAULT_CONFIG(s_pump_channels, WATERING_ZONE_COUNT);
+    cfg.ramp_ms   = WATERING_PUMP_RAMP_MS;
+    cfg.max_on_ms = (WATERING_SCHED_MAX_DURATION_S + 60) * 1000;   ///< 比调度引擎的单次上限多 1 分钟
+    cfg.report_cb = watering_pump_report_cb;
+    return pump_driver_init(&cfg);
+}
+
+/* 水泵 / 流量计 GPIO 不得与板载外设（屏幕、背光、I2C、触摸）重叠，彼此也不得重复 */
+static esp_err_t watering_app_check_pins(void)
+{
+    static const char *const zone_names[] = { "PUMP0", "PUMP1", "PUMP2", "PUMP3",
+                                              "PUMP4", "PUMP5", "PUMP6", "PUMP7" };
+    static const char *const flow_names[] = { "FLOW0", "FLOW1", "FLOW2", "FLOW3",
+                                              "FLOW4", "FLOW5", "FLOW6", "FLOW7" };
+    _Static_assert(PUMP_DRIVER_MAX_CHANNELS <= sizeof(zone_names) / sizeof(zone_names[0]),
+                   "extend zone_names");
+
+    int         gpios[2 * PUMP_DRIVER_MAX_CHANNELS];
+    const char *names[2 * PUMP_DRIVER_MAX_CHANNELS];
+    int         n = 0;
+
+    for (uint8_t i = 0; i < WATERING_ZONE_COUNT; i++) {
+        gpios[n] = (int)s_zone_gpios[i];
+        names[n] = zone_names[i];
+        n++;
+    }
+    for (size_t i = 0; i < WATERING_FLOW_COUNT && i < WATERING_ZONE_COUNT; i++) {
+        gpios[n] = s_flow_gpios[i];
+        names[n] = flow_names[i];
+        n++;
+    }
+    return bsp_board_check_pins(gpios, names, n);
+}
+
 esp_err_t watering_app_init(void)
 {
-    watering_gpio_init();
-    watering_set_state(false);
+    /* 与板载外设（触摸中断、背光等）重叠时不碰任何 GPIO，避免改掉对方的引脚配置 */
+    esp_err_t ret = watering_app_check_pins();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "watering GPIO conflict, pump disabled");
+        return ret;
+    }
+
+    ret = watering_pump_init();
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "pump driver init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    watering_sched_config_t cfg = WATERING_SCHED_DEFAULT_CONFIG(watering_zone_cb);
+    cfg.zone_count = WATERING_ZONE_COUNT;
+
+    ret = watering_sched_init(&cfg);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "watering scheduler init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    watering_publish_status();
 
     return web_mqtt_manager_register_app("watering", watering_app_on_message);
 }
+
+uint8_t watering_app_zone_count(void)
+{
+    return WATERING_ZONE_COUNT;
+}
+
+bool watering_app_is_on(void)
+{
+    return watering_sched_zone_is_on(0);
+}
+
+esp_err_t watering_app_set_zone(uint8_t zone, bool on, uint32_t duration_s)
+{
+    if (zone >= WATERING_ZONE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (duration_s > WATERING_SCHED_MAX_DURATION_S) {
+        duration_s = WATERING_SCHED_MAX_DURATION_S;
+    }
+    return watering_sched_set_zone(zone, on, on ? duration_s : 0);
+}
+
+esp_err_t watering_app_get_plan(watering_plan_t *out)
+{
+    if (out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    watering_sched_plan_t plan;
+    if (watering_sched_get_plan(0, &plan, NULL) != ESP_OK) {
+        memset(out, 0, sizeof(*out));
+        return ESP_OK;
+    }
+
+    out->enabled    = plan.enabled;
+    out->days_mask  = plan.days_mask;
+    out->hour       = plan.hour;
+    out->minute     = plan.minute;
+    out->duration_s = plan.duration_s;
+    return ESP_OK;
+}
@@ -11,8 +11,48 @@
 #ifndef WATERING_APP_H
 #define WATERING_APP_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "esp_err.h"
 
+/**
+ * @brief 定时浇花计划
+ */
+typedef struct {
+    bool enabled;
+    int  days_mask;  /* bit0=Mon ... bit6=Sun */
+    int  hour;
+    int  minute;
+    int  duration_s;
+} watering_plan_t;
+
 esp_err_t watering_app_init(void);
 
+/**
+ * @brief 当前浇花电机是否开启
+ */
+bool watering_app_is_on(void);
+
+/**
+ * @brief 实际接线的区域数（WATERING_ZONE_GPIOS 的长度）
+ */
+uint8_t watering_app_zone_count(void);
+
+/**
+ * @brief 本地开关区域（语音命令等设备端入口，与 MQTT set 命令走同一调度路径）
+ *
+ * @param zone       区域编号
+ * @param on         开 / 关
+ * @param duration_s 开启时长，超过调度引擎单次上限时截断；0 表示一直开到手动关闭
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 区域不存在, ESP_ERR_INVALID_STATE 未初始化或区域被禁止
+ */
+esp_err_t watering_app_set_zone(uint8_t zone, bool on, uint32_t duration_s);
+
+/**
+ * @brief 读取当前定时计划
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 参数为空
+ */
+esp_err_t watering_app_get_plan(watering_plan_t *out);
+
 #endif /* WATERING_APP_H */
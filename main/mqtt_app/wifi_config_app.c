@@ -27,7 +27,7 @@
 
 #include "wifi_module.h"
 #include "storage_module.h"
-#include "mqtt_module.h"
+#include "mqtt_outbox.h"
 #include "mqtt_app_module.h"
 #include "web_mqtt_manager.h"
 #include "mqtt_app/wifi_config_app.h"
@@ -56,7 +56,12 @@ static void wifi_cfg_publish_json(const char *sub, const char *json)
         return;
     }
 
-    (void)mqtt_module_publish(topic, json, (int)strlen(json), 1, false);
+    /* 同一子 Topic 只保留最新一份（状态 / 列表都是全量快照） */
+    char key[MQTT_OUTBOX_KEY_MAX];
+    snprintf(key, sizeof(key), "wifi/%s", sub);
+
+    (void)mqtt_outbox_publish(topic, json, (int)strlen(json), 1, false,
+                              MQTT_OUTBOX_PRIO_HIGH, key);
 }
 
 /* -------------------- 处理命令：下发新 WiFi 配置 -------------------- */
@@ -122,10 +127,14 @@ static void wifi_cfg_handle_set(const char *payload, int payload_len)
 
 /* -------------------- 处理命令：上报当前 WiFi 状态 -------------------- */
 /**
- * @brief 读取当前 WiFi 连接状态并通过 MQTT 上报 JSON
+ * @brief 读取当前 WiFi 连接状态，生成 JSON（MQTT 上报与 Coze 工具共用）
  */
-static void wifi_cfg_handle_get_status(void)
+esp_err_t wifi_config_app_get_status_json(char *buf, size_t len)
 {
+    if (buf == NULL || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
     bool   connected = false;
     char   ssid[32]  = "-";
     char   ip[16]    = "-";
@@ -172,17 +181,26 @@ static void wifi_cfg_handle_get_status(void)
     }
 
     /* 组装简单 JSON（不依赖额外 JSON 库） */
+    int n = snprintf(buf,
+                     len,
+                     "{\"connected\":%s,\"ssid\":\"%s\",\"ip\":\"%s\",\"rssi\":%d,\"mode\":\"%s\"}",
+                     connected ? "true" : "false",
+                     ssid,
+                     ip,
+                     (int)rssi,
+                     mode);
+    return (n > 0 && (size_t)n < len) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+/**
+ * @brief 读取当前 WiFi 连接状态并通过 MQTT 上报 JSON
+ */
+static void wifi_cfg_handle_get_status(void)
+{
     char json[256];
-    snprintf(json,
-             sizeof(json),
-             "{\"connected\":%s,\"ssid\":\"%s\",\"ip\":\"%s\",\"rssi\":%d,\"mode\":\"%s\"}",
-             connected ? "true" : "false",
-             ssid,
-             ip,
-             (int)rssi,
-             mode);
-
-    wifi_cfg_publish_json("status", json);
+    if (wifi_config_app_get_status_json(json, sizeof(json)) == ESP_OK) {
+        wifi_cfg_publish_json("status", json);
+    }
 }
 
 /* -------------------- 处理命令：上报已保存 WiFi 列表 -------------------- */
@@ -378,6 +396,10 @@ static esp_err_t wifi_config_app_on_message(const char    *topic,
 
 esp_err_t wifi_config_app_init(void)
 {
-    /* 注册到 Web MQTT 管理器，使用模块前缀 "wifi" */
-    return web_mqtt_manager_register_app("wifi", wifi_config_app_on_message);
+    /* 注册到 Web MQTT 管理器，使用模块前缀 "wifi"；
+     * 存储读写与断开重连较慢，使用独立分发队列，避免阻塞 esp-mqtt 事件任务 */
+    web_mqtt_app_config_t cfg = WEB_MQTT_APP_DEFAULT_CONFIG(wifi_config_app_on_message);
+    cfg.queue_len       = 4;
+    cfg.task_stack_size = 4096;
+    return web_mqtt_manager_register_app_ex("wifi", &cfg);
 }
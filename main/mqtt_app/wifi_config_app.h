@@ -1,6 +1,8 @@
 #ifndef WIFI_CONFIG_APP_H
 #define WIFI_CONFIG_APP_H
 
+#include <stddef.h>
+
 #include "esp_err.h"
 
 /**
@@ -11,4 +13,15 @@
  */
 esp_err_t wifi_config_app_init(void);
 
+/**
+ * @brief 生成当前 WiFi 状态 JSON
+ *
+ * 格式：{"connected":true,"ssid":"xx","ip":"192.168.1.2","rssi":-50,"mode":"STA"}
+ *
+ * @param buf 输出缓冲区（建议 256 字节）
+ * @param len 缓冲区大小
+ * @return ESP_OK 成功, ESP_ERR_INVALID_ARG 参数为空, ESP_ERR_INVALID_SIZE 缓冲区不足
+ */
+esp_err_t wifi_config_app_get_status_json(char *buf, size_t len);
+
 #endif /* WIFI_CONFIG_APP_H */
@@ -0,0 +1,88 @@
+<?php
+// MQTT 上行消息批量接入入口
+// 请求体为消息数组，或 {"messages": [...]}；每条消息格式与 mqtt_ingest.php 的 JSON 请求体相同。
+// 整批在一个事务内入库，数据库出错时整批回滚并返回 500，调用方可原样重试。
+
+require_once __DIR__ . '/../config.php';
+require_once __DIR__ . '/../db.php';
+require_once __DIR__ . '/../mqtt_config.php';
+require_once __DIR__ . '/../lib/MqttClient.php';
+require_once __DIR__ . '/../lib/TelemetryCbor.php';
+require_once __DIR__ . '/../lib/IngestLog.php';
+require_once __DIR__ . '/../lib/IngestPipeline.php';
+
+header('Content-Type: application/json; charset=utf-8');
+
+// 简单令牌校验
+if (XN_INGEST_SHARED_SECRET !== '') {
+    $token = (string)($_GET['token'] ?? '');
+    if ($token !== XN_INGEST_SHARED_SECRET) {
+        http_response_code(403);
+        echo json_encode(['status' => 'error', 'message' => 'forbidden']);
+        exit;
+    }
+}
+
+$raw  = file_get_contents('php://input');
+$ip   = $_SERVER['REMOTE_ADDR'] ?? null;
+$data = json_decode($raw, true);
+
+if (is_array($data) && isset($data['messages']) && is_array($data['messages'])) {
+    $data = $data['messages'];
+}
+if (!is_array($data) || ($data !== [] && array_keys($data) !== range(0, count($data) - 1))) {
+    XnIngestLog::line(sprintf('batch ip=%s bad request raw=%s', $ip ?? '-', XnIngestLog::raw($raw)));
+    http_response_code(400);
+    echo json_encode(['status' => 'error', 'message' => 'expect array of messages']);
+    exit;
+}
+if (count($data) > XN_INGEST_BATCH_MAX) {
+    XnIngestLog::line(sprintf('batch ip=%s too large n=%d', $ip ?? '-', count($data)));
+    http_response_code(413);
+    echo json_encode(['status' => 'error', 'message' => 'too many messages, max ' . XN_INGEST_BATCH_MAX]);
+    exit;
+}
+
+$messages = [];
+$rejected = 0;
+foreach ($data as $item) {
+    $msg = XnIngestPipeline::normalize($item, $ip);
+    if ($msg === null) {
+        $rejected++;
+        continue;
+    }
+    $messages[] = $msg;
+}
+
+$t0       = microtime(true);
+$pipeline = new XnIngestPipeline(xn_get_db());
+try {
+    $stats = $pipeline->process($messages);
+    $dbMs  = (microtime(true) - $t0) * 1000;
+} catch (Throwable $e) {
+    XnIngestLog::line(sprintf('batch ip=%s n=%d db error: %s', $ip ?? '-', count($messages), $e->getMessage()));
+    http_response_code(500);
+    echo json_encode(['status' => 'error', 'message' => 'db error']);
+    exit;
+}
+
+echo json_encode([
+    'status'   => 'ok',
+    'accepted' => $stats['messages'],
+    'rejected' => $rejected,
+]);
+
+// 响应已交还调用方，再发送设备回复和写日志
+XnIngestLog::finishRequest();
+$sent = $pipeline->flushReplies();
+XnIngestLog::line(sprintf(
+    'batch ip=%s n=%d rejected=%d devices=%d created=%d meta=%d replies=%d db_ms=%.1f',
+    $ip ?? '-',
+    $stats['messages'],
+    $rejected,
+    $stats['devices'],
+    $stats['created'],
+    $stats['meta'],
+    $sent,
+    $dbMs
+));
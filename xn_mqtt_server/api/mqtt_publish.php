@@ -5,6 +5,7 @@
 require_once __DIR__ . '/../auth.php';
 require_once __DIR__ . '/../mqtt_config.php';
 require_once __DIR__ . '/../lib/MqttClient.php';
+require_once __DIR__ . '/../lib/RuleCompiler.php';
 
 header('Content-Type: application/json; charset=utf-8');
 
@@ -22,6 +23,25 @@ $topic   = isset($data['topic']) ? (string)$data['topic'] : '';
 $payload = isset($data['payload']) ? (string)$data['payload'] : '';
 $retain  = isset($data['retain']) ? (bool)$data['retain'] : false;
 
+// 二进制负载：payload_b64 直接解码；rules 为规则文本，编译成设备端规则字节码
+if (isset($data['payload_b64']) && is_string($data['payload_b64'])) {
+    $decoded = base64_decode($data['payload_b64'], true);
+    if ($decoded === false) {
+        http_response_code(400);
+        echo json_encode(['status' => 'error', 'message' => 'invalid payload_b64']);
+        exit;
+    }
+    $payload = $decoded;
+} elseif (isset($data['rules']) && is_string($data['rules'])) {
+    try {
+        $payload = XnRuleCompiler::compile($data['rules']);
+    } catch (InvalidArgumentException $e) {
+        http_response_code(400);
+        echo json_encode(['status' => 'error', 'message' => 'rules: ' . $e->getMessage()]);
+        exit;
+    }
+}
+
 if ($topic === '') {
     http_response_code(400);
     echo json_encode(['status' => 'error', 'message' => 'missing topic']);
@@ -40,7 +60,7 @@ try {
 
     $client->publish($topic, $payload, $retain);
 
-    echo json_encode(['status' => 'ok']);
+    echo json_encode(['status' => 'ok', 'bytes' => strlen($payload)]);
 } catch (Throwable $e) {
     http_response_code(500);
     echo json_encode([
@@ -0,0 +1,362 @@
+<?php
+// 接入压测：生成模拟设备上行消息（心跳为主，夹带 WiFi / 浇花状态、CBOR 批量遥测与注册查询），测量每秒入库消息数。
+// --telemetry 时只发 CBOR 遥测（xn/esp/telemetry/<id>，全量快照带确认请求），专门压测二进制负载与 ack 回复路径：
+//  - pipeline / broker 模式以原始字节交给接入流程（与订阅进程收到的一致）；
+//  - http 模式按 EMQX 规则的格式以 payload_b64 转发。
+//
+//   php cli/ingest_loadgen.php --mode=pipeline [--messages=20000] [--devices=2000] [--batch=200]
+//       直接调用 XnIngestPipeline，测数据库侧上限；
+//   php cli/ingest_loadgen.php --mode=http --url=http://127.0.0.1/api/mqtt_ingest_batch.php?token=XXX [--batch=200]
+//       POST 到批量接口（--batch=1 时请把 url 指向 mqtt_ingest.php，对比逐条转发）；
+//   php cli/ingest_loadgen.php --mode=broker [--listen=18830] [--subscribers=1] [--rate=0]
+//       本进程充当本地 MQTT 服务器替身，等待订阅进程连接：
+//         php cli/mqtt_ingest_subscriber.php --host=127.0.0.1 --port=18830 --shard=0
+//       然后把消息按设备 ID 哈希分给已连接的订阅进程（模拟 hash_clientid 共享订阅），
+//       以 mqtt_messages 中出现全部消息的时间计算端到端吞吐。
+//
+// 模拟设备 ID 以 lg<运行号>- 开头，结束后删除本次写入的设备与消息（--keep 保留）。
+
+if (PHP_SAPI !== 'cli') {
+    http_response_code(403);
+    exit;
+}
+
+require_once __DIR__ . '/../config.php';
+require_once __DIR__ . '/../db.php';
+require_once __DIR__ . '/../mqtt_config.php';
+require_once __DIR__ . '/../lib/MqttClient.php';
+require_once __DIR__ . '/../lib/TelemetryCbor.php';
+require_once __DIR__ . '/../lib/IngestLog.php';
+require_once __DIR__ . '/../lib/IngestPipeline.php';
+
+$opt = getopt('', ['mode:', 'messages:', 'devices:', 'batch:', 'url:', 'listen:', 'subscribers:', 'rate:', 'timeout:', 'telemetry', 'keep']);
+
+$mode     = (string)($opt['mode'] ?? 'pipeline');
+$total    = max(1, (int)($opt['messages'] ?? 20000));
+$devices  = max(1, (int)($opt['devices'] ?? 2000));
+$batch    = max(1, min(XN_INGEST_BATCH_MAX, (int)($opt['batch'] ?? 200)));
+$timeout  = max(1, (int)($opt['timeout'] ?? 120));
+$prefix   = 'lg' . dechex(time()) . '-';
+$onlyTele = isset($opt['telemetry']);
+
+/**
+ * 最小 CBOR 编码：整数、文本、数组编码为列表，对象编码为整数键映射（与设备端 telemetry_cbor 的输出格式一致）。
+ */
+function xn_lg_cbor($v): string
+{
+    $head = function (int $major, int $n): string {
+        if ($n < 24) {
+            return chr(($major << 5) | $n);
+        }
+        if ($n < 0x100) {
+            return chr(($major << 5) | 24) . chr($n);
+        }
+        if ($n < 0x10000) {
+            return chr(($major << 5) | 25) . pack('n', $n);
+        }
+        return chr(($major << 5) | 26) . pack('N', $n);
+    };
+
+    if (is_int($v)) {
+        return $v >= 0 ? $head(0, $v) : $head(1, -1 - $v);
+    }
+    if (is_string($v)) {
+        return $head(3, strlen($v)) . $v;
+    }
+    $out = '';
+    if (is_object($v)) {
+        $v = get_object_vars($v);
+        foreach ($v as $k => $item) {
+            $out .= xn_lg_cbor((int)$k) . xn_lg_cbor($item);
+        }
+        return $head(5, count($v)) . $out;
+    }
+    foreach ($v as $item) {
+        $out .= xn_lg_cbor($item);
+    }
+    return $head(4, count($v)) . $out;
+}
+
+/**
+ * 一条全量遥测快照（base_seq = 0，带名称表与确认请求），负载为原始 CBOR 字节。
+ */
+function xn_lg_telemetry(string $id, int $seq, int $i): array
+{
+    $batch = (object)[
+        0 => $seq,
+        1 => 0,
+        2 => (object)[0 => 180000 - $i % 5000, 1 => -40 - $i % 30, 2 => $i & 1, 3 => $i % 7],
+        3 => (object)[0 => ['heap_free', 1], 1 => ['rssi', 1], 2 => ['pump_on', 2], 3 => ['outbox_depth', 1]],
+        4 => 1,
+    ];
+    return ['client_id' => $id, 'topic' => rtrim(XN_MQTT_UPLINK_BASE_TOPIC, '/') . '/telemetry/' . $id,
+            'payload' => xn_lg_cbor($batch)];
+}
+
+/**
+ * 第 $i 条模拟消息（带规则引擎格式的 client_id，遥测负载为原始 CBOR 字节）。
+ */
+function xn_lg_message(int $i, int $devices, string $prefix, bool $onlyTele = false): array
+{
+    $id   = $prefix . ($i % $devices);
+    $up   = rtrim(XN_MQTT_UPLINK_BASE_TOPIC, '/');
+    $kind = $i % 20;
+
+    if ($onlyTele || $kind === 3) {
+        return xn_lg_telemetry($id, intdiv($i, $devices) + 1, $i);
+    }
+    if ($kind === 1) {
+        return ['client_id' => $id, 'topic' => $up . '/wifi/' . $id . '/status',
+                'payload' => json_encode(['connected' => true, 'ssid' => 'lg', 'rssi' => -40 - $i % 30])];
+    }
+    if ($kind === 2) {
+        return ['client_id' => $id, 'topic' => $up . '/watering/' . $id . '/status',
+                'payload' => json_encode(['on' => ($i & 1) === 1])];
+    }
+    if ($i < $devices) {
+        // 每台设备第一次出现时先发注册查询（服务端会回复）
+        return ['client_id' => $id, 'topic' => $up . '/reg/query', 'payload' => $id];
+    }
+    return ['client_id' => $id, 'topic' => $up . '/hb', 'payload' => $id];
+}
+
+function xn_lg_mqtt_string(string $s): string
+{
+    return chr(strlen($s) >> 8) . chr(strlen($s) & 0xFF) . $s;
+}
+
+function xn_lg_mqtt_packet(int $header, string $body): string
+{
+    $len = strlen($body);
+    $enc = '';
+    do {
+        $digit = $len % 128;
+        $len   = intdiv($len, 128);
+        $enc  .= chr($len > 0 ? ($digit | 0x80) : $digit);
+    } while ($len > 0);
+    return chr($header) . $enc . $body;
+}
+
+/**
+ * 从接收缓存中取出一个完整报文，不完整时返回 null。
+ */
+function xn_lg_mqtt_take(string &$buf): ?array
+{
+    $n = strlen($buf);
+    if ($n < 2) {
+        return null;
+    }
+    $len   = 0;
+    $mul   = 1;
+    $pos   = 1;
+    do {
+        if ($pos >= $n || $pos > 4) {
+            return null;
+        }
+        $digit = ord($buf[$pos++]);
+        $len  += ($digit & 127) * $mul;
+        $mul  *= 128;
+    } while (($digit & 128) !== 0);
+    if ($n < $pos + $len) {
+        return null;
+    }
+    $pkt = ['type' => ord($buf[0]) >> 4, 'body' => substr($buf, $pos, $len)];
+    $buf = (string)substr($buf, $pos + $len);
+    return $pkt;
+}
+
+$db        = xn_get_db();
+$startId   = (int)$db->query('SELECT COALESCE(MAX(id), 0) FROM mqtt_messages')->fetchColumn();
+$countStmt = $db->prepare('SELECT COUNT(*) FROM mqtt_messages WHERE id > ? AND client_id LIKE ?');
+$countRows = function () use ($countStmt, $startId, $prefix): int {
+    $countStmt->execute([$startId, $prefix . '%']);
+    return (int)$countStmt->fetchColumn();
+};
+
+printf("mode=%s messages=%d devices=%d batch=%d telemetry_only=%d prefix=%s\n", $mode, $total, $devices, $batch, $onlyTele ? 1 : 0, $prefix);
+$t0      = microtime(true);
+$stored  = 0;
+$replies = 0;
+
+if ($mode === 'pipeline') {
+    $pipeline = new XnIngestPipeline($db);
+    for ($i = 0; $i < $total; $i += $batch) {
+        $msgs = [];
+        for ($j = $i; $j < min($total, $i + $batch); $j++) {
+            $msgs[] = XnIngestPipeline::normalize(xn_lg_message($j, $devices, $prefix, $onlyTele), '127.0.0.1');
+        }
+        $stored += $pipeline->process($msgs)['messages'];
+    }
+    $stored = $countRows();
+} elseif ($mode === 'http') {
+    $url = (string)($opt['url'] ?? '');
+    if ($url === '') {
+        fwrite(STDERR, "--url is required in http mode\n");
+        exit(2);
+    }
+    $requests = 0;
+    $failed   = 0;
+    for ($i = 0; $i < $total; $i += $batch) {
+        $msgs = [];
+        for ($j = $i; $j < min($total, $i + $batch); $j++) {
+            $msg = xn_lg_message($j, $devices, $prefix, $onlyTele);
+            if (strpos($msg['topic'], '/telemetry/') !== false) {
+                // 与 EMQX 规则一致：二进制负载以 payload_b64 转发
+                $msg['payload_b64'] = base64_encode($msg['payload']);
+                $msg['payload']     = '';
+            }
+            $msgs[] = $msg;
+        }
+        $body = json_encode($batch === 1 ? $msgs[0] : $msgs, JSON_UNESCAPED_UNICODE);
+        $ctx  = stream_context_create(['http' => [
+            'method'        => 'POST',
+            'header'        => "Content-Type: application/json\r\n",
+            'content'       => $body,
+            'timeout'       => 30,
+            'ignore_errors' => true,
+        ]]);
+        $resp = @file_get_contents($url, false, $ctx);
+        $data = is_string($resp) ? json_decode($resp, true) : null;
+        if (!is_array($data) || ($data['status'] ?? '') !== 'ok') {
+            $failed++;
+        }
+        $requests++;
+    }
+    $stored = $countRows();
+    printf("requests=%d failed=%d\n", $requests, $failed);
+} elseif ($mode === 'broker') {
+    $listen  = (int)($opt['listen'] ?? 18830);
+    $want    = max(1, (int)($opt['subscribers'] ?? 1));
+    $rate    = max(0, (int)($opt['rate'] ?? 0));
+    $server  = @stream_socket_server('tcp://127.0.0.1:' . $listen, $errno, $errstr);
+    if (!$server) {
+        fwrite(STDERR, "listen failed: $errstr\n");
+        exit(2);
+    }
+    stream_set_blocking($server, false);
+    printf("broker stand-in on 127.0.0.1:%d, waiting for %d subscriber(s)...\n", $listen, $want);
+
+    $conns    = [];   // [sock, in, out, subscribed]
+    $sent     = 0;
+    $sendAt   = 0.0;
+    $deadline = microtime(true) + $timeout;
+    $checkAt  = 0.0;
+
+    while (microtime(true) < $deadline) {
+        $read  = [$server];
+        $write = [];
+        foreach ($conns as $c) {
+            $read[] = $c['sock'];
+            if ($c['out'] !== '') {
+                $write[] = $c['sock'];
+            }
+        }
+        $except = null;
+        if (@stream_select($read, $write, $except, 0, 20000) === false) {
+            break;
+        }
+
+        foreach ($read as $sock) {
+            if ($sock === $server) {
+                $new = @stream_socket_accept($server, 0);
+                if ($new) {
+                    stream_set_blocking($new, false);
+                    $conns[(int)$new] = ['sock' => $new, 'in' => '', 'out' => '', 'subscribed' => false];
+                }
+                continue;
+            }
+            $k    = (int)$sock;
+            $data = @fread($sock, 65536);
+            if ($data === '' || $data === false) {
+                if (feof($sock)) {
+                    fclose($sock);
+                    unset($conns[$k]);
+                }
+                continue;
+            }
+            $conns[$k]['in'] .= $data;
+            while (($pkt = xn_lg_mqtt_take($conns[$k]['in'])) !== null) {
+                switch ($pkt['type']) {
+                    case 1:  // CONNECT -> CONNACK
+                        $conns[$k]['out'] .= chr(0x20) . chr(0x02) . chr(0x00) . chr(0x00);
+                        break;
+                    case 8:  // SUBSCRIBE -> SUBACK（每个过滤器授予 QoS 0）
+                        $filters = 0;
+                        for ($p = 2; $p + 2 <= strlen($pkt['body']); $filters++) {
+                            $p += 2 + ((ord($pkt['body'][$p]) << 8) | ord($pkt['body'][$p + 1])) + 1;
+                        }
+                        $conns[$k]['out'] .= xn_lg_mqtt_packet(0x90, substr($pkt['body'], 0, 2) . str_repeat(chr(0), max(1, $filters)));
+                        $conns[$k]['subscribed'] = true;
+                        break;
+                    case 12: // PINGREQ -> PINGRESP
+                        $conns[$k]['out'] .= chr(0xD0) . chr(0x00);
+                        break;
+                    case 3:  // 订阅进程发出的回复
+                        $replies++;
+                        break;
+                }
+            }
+        }
+
+        foreach ($write as $sock) {
+            $k = (int)$sock;
+            if (!isset($conns[$k])) {
+                continue;   // 本轮读取时已断开
+            }
+            $n = @fwrite($sock, $conns[$k]['out']);
+            if ($n > 0) {
+                $conns[$k]['out'] = (string)substr($conns[$k]['out'], $n);
+            }
+        }
+
+        // 订阅进程到齐后开始发送，每个连接最多积压 1MB
+        $subs = [];
+        foreach ($conns as $k => $c) {
+            if ($c['subscribed']) {
+                $subs[] = $k;
+            }
+        }
+        if (count($subs) >= $want && $sent < $total) {
+            if ($sendAt === 0.0) {
+                $sendAt = microtime(true);
+                $t0     = $sendAt;
+            }
+            $allow = $rate > 0 ? min($total, (int)((microtime(true) - $sendAt) * $rate) + 1) : $total;
+            while ($sent < $allow) {
+                $msg = xn_lg_message($sent, $devices, $prefix, $onlyTele);
+                $k   = $subs[crc32($msg['client_id']) % count($subs)];
+                if (strlen($conns[$k]['out']) >= 1024 * 1024) {
+                    break;
+                }
+                $conns[$k]['out'] .= xn_lg_mqtt_packet(0x30, xn_lg_mqtt_string($msg['topic']) . $msg['payload']);
+                $sent++;
+            }
+        }
+
+        if ($sent >= $total && microtime(true) >= $checkAt) {
+            $checkAt = microtime(true) + 0.2;
+            $stored  = $countRows();
+            if ($stored >= $total) {
+                break;
+            }
+        }
+    }
+    foreach ($conns as $c) {
+        fclose($c['sock']);
+    }
+    fclose($server);
+    printf("published=%d replies_seen=%d\n", $sent, $replies);
+} else {
+    fwrite(STDERR, "unknown --mode, expect pipeline | http | broker\n");
+    exit(2);
+}
+
+$elapsed = max(0.001, microtime(true) - $t0);
+printf("stored=%d/%d elapsed=%.2fs rate=%.1f msg/s\n", $stored, $total, $elapsed, $stored / $elapsed);
+
+if (!isset($opt['keep'])) {
+    $db->prepare('DELETE FROM mqtt_messages WHERE id > ? AND client_id LIKE ?')->execute([$startId, $prefix . '%']);
+    $db->prepare('DELETE FROM devices WHERE device_id LIKE ?')->execute([$prefix . '%']);
+}
+XnIngestLog::flush();
+exit($stored >= $total ? 0 : 1);
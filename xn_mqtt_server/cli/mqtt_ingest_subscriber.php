@@ -0,0 +1,143 @@
+<?php
+// 本地订阅接入进程：直接订阅设备上行 Topic，攒批后走 XnIngestPipeline 入库，不再经过每条消息一次的 HTTP 转发。
+//
+//   php cli/mqtt_ingest_subscriber.php [--shard=0] [--batch=200] [--flush-ms=500] [--duration=0]
+//                                      [--host=127.0.0.1] [--port=1883] [--filter=xn/esp/#] [--no-share]
+//
+// 分片：多个进程使用不同 --shard 启动，加入同一个 EMQX 共享订阅组 $share/<XN_INGEST_SHARE_GROUP>/<filter>，
+// 由 EMQX 把消息分摊到各分片。共享订阅策略建议设为 hash_clientid，同一设备的消息固定落在同一分片，
+// 保证 meta_json 按到达顺序更新。
+//
+// 进程只负责一段连续运行：连接断开或数据库出错时写日志并以非 0 退出，由 supervisor / 宝塔守护进程拉起。
+
+if (PHP_SAPI !== 'cli') {
+    http_response_code(403);
+    exit;
+}
+
+require_once __DIR__ . '/../config.php';
+require_once __DIR__ . '/../db.php';
+require_once __DIR__ . '/../mqtt_config.php';
+require_once __DIR__ . '/../lib/MqttClient.php';
+require_once __DIR__ . '/../lib/TelemetryCbor.php';
+require_once __DIR__ . '/../lib/IngestLog.php';
+require_once __DIR__ . '/../lib/IngestPipeline.php';
+
+$opt = getopt('', ['shard:', 'batch:', 'flush-ms:', 'duration:', 'host:', 'port:', 'filter:', 'no-share']);
+
+$shard    = max(0, (int)($opt['shard'] ?? 0));
+$batchMax = max(1, (int)($opt['batch'] ?? XN_INGEST_SUB_BATCH));
+$flushSec = max(10, (int)($opt['flush-ms'] ?? XN_INGEST_SUB_FLUSH_MS)) / 1000;
+$duration = max(0, (int)($opt['duration'] ?? 0));
+$host     = (string)($opt['host'] ?? XN_MQTT_HOST);
+$port     = (int)($opt['port'] ?? XN_MQTT_PORT);
+$filter   = (string)($opt['filter'] ?? (rtrim(XN_MQTT_UPLINK_BASE_TOPIC, '/') . '/#'));
+if (!isset($opt['no-share'])) {
+    $filter = '$share/' . XN_INGEST_SHARE_GROUP . '/' . $filter;
+}
+$tag = 'sub#' . $shard;
+
+$stop = false;
+if (function_exists('pcntl_async_signals')) {
+    pcntl_async_signals(true);
+    $onSignal = function () use (&$stop) {
+        $stop = true;
+    };
+    pcntl_signal(SIGTERM, $onSignal);
+    pcntl_signal(SIGINT, $onSignal);
+}
+
+function xn_sub_log(string $tag, string $msg): void
+{
+    XnIngestLog::line($tag . ' ' . $msg);
+    fwrite(STDERR, '[' . date('Y-m-d H:i:s') . '] ' . $tag . ' ' . $msg . "\n");
+}
+
+try {
+    $mqtt = new XnMqttClient(
+        $host,
+        $port,
+        XN_MQTT_CLIENT_ID . '_ingest_' . $shard,   // 每个分片独立 client_id，避免互相踢下线
+        XN_MQTT_USERNAME,
+        XN_MQTT_PASSWORD,
+        XN_MQTT_KEEPALIVE
+    );
+    $mqtt->connect();
+    $mqtt->subscribe($filter);
+    $pipeline = new XnIngestPipeline(xn_get_db(), $mqtt);   // 回复复用订阅连接
+} catch (Throwable $e) {
+    xn_sub_log($tag, 'start failed: ' . $e->getMessage());
+    XnIngestLog::flush();
+    exit(1);
+}
+xn_sub_log($tag, sprintf('subscribed %s:%d %s batch=%d flush=%.0fms', $host, $port, $filter, $batchMax, $flushSec * 1000));
+
+$pending  = [];
+$firstAt  = 0.0;   // 当前批第一条消息的到达时间
+$dropped  = 0;
+$total    = 0;
+$batches  = 0;
+$statAt   = microtime(true);
+$statMsgs = 0;
+$endAt    = $duration > 0 ? microtime(true) + $duration : 0.0;
+$exitCode = 0;
+
+$onMessage = function (string $topic, string $payload) use (&$pending, &$firstAt, &$dropped) {
+    $msg = XnIngestPipeline::normalize(['topic' => $topic, 'payload' => $payload]);
+    if ($msg === null) {
+        $dropped++;
+        return;
+    }
+    if ($pending === []) {
+        $firstAt = microtime(true);
+    }
+    $pending[] = $msg;
+};
+
+while (!$stop && ($endAt === 0.0 || microtime(true) < $endAt)) {
+    try {
+        // 攒批期间只等到本批的截止时间，空闲时最多等 1 秒（期间照常发送 PINGREQ）
+        $wait = $pending === [] ? 1.0 : max(0.001, $firstAt + $flushSec - microtime(true));
+        $mqtt->poll($onMessage, $wait);
+
+        $now = microtime(true);
+        if ($pending !== [] && (count($pending) >= $batchMax || $now - $firstAt >= $flushSec)) {
+            $pipeline->process($pending);
+            $total    += count($pending);
+            $statMsgs += count($pending);
+            $batches++;
+            $pending = [];
+            $pipeline->flushReplies();
+        }
+
+        // 每分钟一行吞吐统计，同时把日志缓存写盘
+        if ($now - $statAt >= 60) {
+            xn_sub_log($tag, sprintf('rate=%.1f msg/s total=%d batches=%d dropped=%d', $statMsgs / ($now - $statAt), $total, $batches, $dropped));
+            XnIngestLog::flush();
+            $statAt   = $now;
+            $statMsgs = 0;
+        }
+    } catch (Throwable $e) {
+        xn_sub_log($tag, sprintf('stopped: %s (lost %d pending)', $e->getMessage(), count($pending)));
+        $pending  = [];
+        $exitCode = 1;
+        break;
+    }
+}
+
+// 正常退出时把已攒下的消息入库
+if ($pending !== []) {
+    try {
+        $pipeline->process($pending);
+        $total += count($pending);
+        $pipeline->flushReplies();
+    } catch (Throwable $e) {
+        xn_sub_log($tag, sprintf('final flush failed: %s (lost %d)', $e->getMessage(), count($pending)));
+        $exitCode = 1;
+    }
+}
+
+xn_sub_log($tag, sprintf('exit total=%d batches=%d dropped=%d', $total, $batches, $dropped));
+$mqtt->disconnect();
+XnIngestLog::flush();
+exit($exitCode);
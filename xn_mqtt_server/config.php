@@ -31,3 +31,18 @@ define('XN_INGEST_SHARED_SECRET', 'Li2k0e3mVRW4akNjvmwK');
 
 // 多久未收到心跳视为离线（秒）
 define('XN_DEVICE_OFFLINE_SECONDS', 90);
+
+// 上行接入日志：请求内先缓存，响应返回后统一追加写盘，超过大小后轮转为 .1 ~ .N
+define('XN_INGEST_LOG_FILE', __DIR__ . '/mqtt_ingest.log');
+define('XN_INGEST_LOG_MAX_BYTES', 10 * 1024 * 1024);   // 单个日志文件上限
+define('XN_INGEST_LOG_KEEP', 5);                       // 保留的历史文件数
+define('XN_INGEST_LOG_RAW_MAX', 1024);                 // 每行最多记录的原始请求体字节数
+
+// 批量接入（api/mqtt_ingest_batch.php 与本地订阅进程）
+define('XN_INGEST_BATCH_MAX', 1000);    // 单个 HTTP 批次最多消息数
+define('XN_INGEST_SQL_CHUNK', 200);     // 单条多行 SQL 最多行数
+
+// 本地订阅进程（cli/mqtt_ingest_subscriber.php）：EMQX 共享订阅组、攒批条数与最长等待
+define('XN_INGEST_SHARE_GROUP', 'xn_ingest');
+define('XN_INGEST_SUB_BATCH', 200);
+define('XN_INGEST_SUB_FLUSH_MS', 500);
@@ -0,0 +1,115 @@
+<?php
+/**
+ * 接入日志：先缓存在内存，请求结束（或订阅进程定期）时一次性追加写盘，超过大小后按 .1 ~ .N 轮转。
+ *
+ *  - Web 请求中配合 finishRequest()：先把响应交还给 FastCGI（EMQX 不再等待），再写日志 / 发回复；
+ *  - 多个 PHP-FPM 进程与订阅进程可同时写同一文件：追加与轮转都在独占锁内完成；
+ *  - 首次写入时注册 shutdown 回调，提前 exit 的错误分支也不会丢日志。
+ */
+
+class XnIngestLog
+{
+    /** 缓存超过该字节数时立即写盘，避免长驻进程占用过多内存 */
+    private const BUFFER_MAX = 256 * 1024;
+
+    /** @var string[] */
+    private static array $lines = [];
+    private static int $bytes = 0;
+    private static bool $hooked = false;
+
+    /**
+     * 追加一行（自动加时间戳与换行）。
+     */
+    public static function line(string $msg): void
+    {
+        if (!self::$hooked) {
+            register_shutdown_function([self::class, 'flush']);
+            self::$hooked = true;
+        }
+
+        $line = '[' . date('Y-m-d H:i:s') . '] ' . $msg . "\n";
+        self::$lines[] = $line;
+        self::$bytes  += strlen($line);
+
+        if (self::$bytes >= self::BUFFER_MAX) {
+            self::flush();
+        }
+    }
+
+    /**
+     * 截断过长的原始请求体，日志只用于排查，不保留完整负载。
+     */
+    public static function raw(string $raw): string
+    {
+        if (strlen($raw) <= XN_INGEST_LOG_RAW_MAX) {
+            return $raw;
+        }
+        return substr($raw, 0, XN_INGEST_LOG_RAW_MAX) . '...(' . strlen($raw) . ' bytes)';
+    }
+
+    /**
+     * 结束 HTTP 响应（PHP-FPM 下客户端立即拿到结果），之后脚本继续执行收尾工作。
+     */
+    public static function finishRequest(): void
+    {
+        if (function_exists('fastcgi_finish_request')) {
+            fastcgi_finish_request();
+        }
+    }
+
+    /**
+     * 把缓存写入日志文件；写失败时丢弃本批，不影响接入流程。
+     */
+    public static function flush(): void
+    {
+        if (self::$lines === []) {
+            return;
+        }
+        $data = implode('', self::$lines);
+        self::$lines = [];
+        self::$bytes = 0;
+
+        $fp = @fopen(XN_INGEST_LOG_FILE, 'ab');
+        if (!$fp) {
+            return;
+        }
+        if (@flock($fp, LOCK_EX)) {
+            // 其他进程可能刚轮转过：确认句柄仍指向当前文件，否则重新打开
+            clearstatcache(true, XN_INGEST_LOG_FILE);
+            $stat = @fstat($fp);
+            if ($stat === false || @fileinode(XN_INGEST_LOG_FILE) !== $stat['ino']) {
+                flock($fp, LOCK_UN);
+                fclose($fp);
+                $fp = @fopen(XN_INGEST_LOG_FILE, 'ab');
+                if (!$fp || !@flock($fp, LOCK_EX)) {
+                    return;
+                }
+                $stat = @fstat($fp);
+            }
+
+            @fwrite($fp, $data);
+            fflush($fp);
+
+            if ($stat !== false && $stat['size'] + strlen($data) >= XN_INGEST_LOG_MAX_BYTES) {
+                self::rotate();
+            }
+            flock($fp, LOCK_UN);
+        }
+        fclose($fp);
+    }
+
+    /**
+     * 轮转：log.(N-1) -> log.N ... log -> log.1（调用方持有当前文件的独占锁）。
+     */
+    private static function rotate(): void
+    {
+        $keep = max(1, (int)XN_INGEST_LOG_KEEP);
+        @unlink(XN_INGEST_LOG_FILE . '.' . $keep);
+        for ($i = $keep - 1; $i >= 1; $i--) {
+            if (file_exists(XN_INGEST_LOG_FILE . '.' . $i)) {
+                @rename(XN_INGEST_LOG_FILE . '.' . $i, XN_INGEST_LOG_FILE . '.' . ($i + 1));
+            }
+        }
+        @rename(XN_INGEST_LOG_FILE, XN_INGEST_LOG_FILE . '.1');
+    }
+}
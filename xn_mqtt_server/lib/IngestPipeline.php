@@ -0,0 +1,400 @@
+<?php
+/**
+ * 设备上行消息批量入库：HTTP 接口（单条 / 批量）与本地订阅进程共用。
+ *
+ * 一批消息在一个事务内完成，语句条数与消息条数无关：
+ *  1. SELECT ... FOR UPDATE 按 device_id 锁定本批设备（索引顺序加锁，并发分片之间不易死锁）；
+ *  2. 新设备 INSERT IGNORE 多行插入（并发请求同时插入同一设备时不报错）；
+ *  3. 在线信息按 last_ip 分组，每组一条 UPDATE ... WHERE device_id IN (...)；
+ *  4. 消息记录多行 INSERT 到 mqtt_messages；
+ *  5. 注册 / WiFi / 浇花 / 遥测等需要改 meta_json 的消息按到达顺序合并到内存，每台设备只写一次。
+ * 已有设备不走 INSERT ... ON DUPLICATE KEY UPDATE：InnoDB 会为每次冲突消耗一个自增 id，
+ * 心跳量大时 devices.id 很快耗尽。
+ *
+ * 需要回复设备的消息（注册应答、遥测 ack）在提交后由 flushReplies() 通过同一个 MQTT 连接发送。
+ */
+
+class XnIngestPipeline
+{
+    private PDO $db;
+    private ?XnMqttClient $mqtt;
+    private bool $ownMqtt = false;
+
+    /** @var array<string, PDOStatement> SQL 模板 + 行数 => 预处理语句 */
+    private array $stmts = [];
+
+    /** @var array<int, array{0: string, 1: string}> 待发送的回复 [topic, payload] */
+    private array $replies = [];
+
+    /**
+     * @param XnMqttClient|null $mqtt 发送回复用的连接；为空时首次需要回复才按 mqtt_config.php 建立
+     */
+    public function __construct(PDO $db, ?XnMqttClient $mqtt = null)
+    {
+        $this->db   = $db;
+        $this->mqtt = $mqtt;
+    }
+
+    /**
+     * 把一条规则引擎 / 订阅得到的消息整理为内部格式，缺少设备 ID 时返回 null。
+     *
+     * @param mixed       $item {client_id?, topic, payload?, payload_b64?}
+     * @param string|null $ip   来源地址（写入 devices.last_ip，null 表示不更新）
+     */
+    public static function normalize($item, ?string $ip = null): ?array
+    {
+        if (!is_array($item)) {
+            return null;
+        }
+
+        $topic   = isset($item['topic']) ? (string)$item['topic'] : '';
+        $payload = '';
+        $bin     = null;   // 二进制负载（遥测 CBOR），规则引擎以 payload_b64 字段转发
+
+        if (array_key_exists('payload', $item)) {
+            $payload = is_string($item['payload']) ? $item['payload'] : json_encode($item['payload']);
+        }
+        if (isset($item['payload_b64']) && is_string($item['payload_b64'])) {
+            $decoded = base64_decode($item['payload_b64'], true);
+            if ($decoded !== false) {
+                $bin = $decoded;
+                if ($payload === '') {
+                    $payload = $item['payload_b64'];   // 消息表中保留 base64 文本
+                }
+            }
+        }
+
+        // 遥测 CBOR 与非 UTF-8 负载不能写入 utf8mb4 的 TEXT 列（严格模式下报 1366 导致整批回滚），
+        // 订阅模式拿到的是原始字节：同样按二进制处理，消息表中保留 base64 文本
+        $telemetry = strpos($topic, rtrim(XN_MQTT_UPLINK_BASE_TOPIC, '/') . '/telemetry/') === 0;
+        if ($payload !== '' && ($telemetry || preg_match('//u', $payload) !== 1)) {
+            if ($bin === null) {
+                $bin = $payload;
+            }
+            $payload = base64_encode($bin);
+        }
+
+        $clientId = isset($item['client_id']) ? (string)$item['client_id'] : '';
+        if ($clientId === '') {
+            $clientId = self::clientIdFromTopic($topic, $bin ?? $payload);
+        }
+        if ($clientId === '' || strlen($clientId) > 128) {
+            return null;
+        }
+
+        return [
+            'client_id' => $clientId,
+            'topic'     => $topic,
+            'payload'   => $payload,
+            'bin'       => $bin,
+            'ip'        => $ip,
+        ];
+    }
+
+    /**
+     * 从上行 Topic 推出设备 ID（订阅模式下没有规则引擎提供的 clientid）：
+     *  - xn/esp/hb、xn/esp/reg/query：负载即设备 ID；
+     *  - xn/esp/<模块>/<device_id>/...：取第二段。
+     */
+    public static function clientIdFromTopic(string $topic, string $payload): string
+    {
+        $base = rtrim(XN_MQTT_UPLINK_BASE_TOPIC, '/') . '/';
+        if (strpos($topic, $base) !== 0) {
+            return '';
+        }
+
+        $rest = substr($topic, strlen($base));
+        if ($rest === 'hb' || $rest === 'reg/query') {
+            return trim($payload);
+        }
+
+        $parts = explode('/', $rest);
+        return $parts[1] ?? '';
+    }
+
+    /**
+     * 在一个事务内写入一批已整理的消息，失败时回滚并抛出异常（回复队列同时丢弃）。
+     *
+     * @param array $messages normalize() 的结果
+     * @return array{messages: int, devices: int, created: int, meta: int}
+     */
+    public function process(array $messages): array
+    {
+        $stats = ['messages' => 0, 'devices' => 0, 'created' => 0, 'meta' => 0];
+        if ($messages === []) {
+            return $stats;
+        }
+
+        $now     = date('Y-m-d H:i:s');
+        $lastIp  = [];   // device_id => 最后一条带地址消息的来源地址
+        $metaIds = [];   // 需要改 meta_json 的设备
+        foreach ($messages as $msg) {
+            $id = $msg['client_id'];
+            if (!array_key_exists($id, $lastIp) || $msg['ip'] !== null) {
+                $lastIp[$id] = $msg['ip'];
+            }
+            if ($this->touchesMeta($msg)) {
+                $metaIds[$id] = true;
+            }
+        }
+        $deviceIds = array_keys($lastIp);
+        sort($deviceIds, SORT_STRING);
+
+        $replies = [];
+        $this->db->beginTransaction();
+        try {
+            // 1. 锁定已有设备，2. 插入新设备
+            $existing = [];
+            foreach (array_chunk($deviceIds, XN_INGEST_SQL_CHUNK) as $chunk) {
+                $stmt = $this->stmt('SELECT device_id FROM devices WHERE device_id IN (%s) FOR UPDATE', '?', count($chunk));
+                $stmt->execute($chunk);
+                foreach ($stmt->fetchAll(PDO::FETCH_COLUMN) as $id) {
+                    $existing[(string)$id] = true;
+                }
+            }
+
+            $missing = [];
+            foreach ($deviceIds as $id) {
+                if (!isset($existing[$id])) {
+                    $missing[] = $id;
+                }
+            }
+            foreach (array_chunk($missing, XN_INGEST_SQL_CHUNK) as $chunk) {
+                $params = [];
+                foreach ($chunk as $id) {
+                    array_push($params, $id, $now, $now);
+                }
+                $stmt = $this->stmt('INSERT IGNORE INTO devices (device_id, created_at, updated_at) VALUES %s', '(?, ?, ?)', count($chunk));
+                $stmt->execute($params);
+                $stats['created'] += $stmt->rowCount();
+            }
+
+            // 3. 在线信息：同一来源地址的设备一条 UPDATE（HTTP 批次通常只有一组，订阅模式不更新地址）
+            $byIp = [];
+            foreach ($deviceIds as $id) {
+                $byIp[$lastIp[$id] ?? ''][] = $id;
+            }
+            foreach ($byIp as $ip => $ids) {
+                foreach (array_chunk($ids, XN_INGEST_SQL_CHUNK) as $chunk) {
+                    if ($ip === '') {
+                        $stmt = $this->stmt('UPDATE devices SET last_seen_at = ?, updated_at = ? WHERE device_id IN (%s)', '?', count($chunk));
+                        $stmt->execute(array_merge([$now, $now], $chunk));
+                    } else {
+                        $stmt = $this->stmt('UPDATE devices SET last_seen_at = ?, last_ip = ?, updated_at = ? WHERE device_id IN (%s)', '?', count($chunk));
+                        $stmt->execute(array_merge([$now, (string)$ip, $now], $chunk));
+                    }
+                }
+            }
+
+            // 4. 消息记录
+            foreach (array_chunk($messages, XN_INGEST_SQL_CHUNK) as $chunk) {
+                $params = [];
+                foreach ($chunk as $msg) {
+                    array_push($params, $msg['client_id'], $msg['topic'], $msg['payload'], $now);
+                }
+                $stmt = $this->stmt('INSERT INTO mqtt_messages (client_id, topic, payload, created_at) VALUES %s', '(?, ?, ?, ?)', count($chunk));
+                $stmt->execute($params);
+            }
+
+            // 5. meta_json：行已在第 1 步锁定，按消息顺序合并后每台设备写一次
+            if ($metaIds !== []) {
+                $metas = [];
+                foreach (array_chunk(array_keys($metaIds), XN_INGEST_SQL_CHUNK) as $chunk) {
+                    $stmt = $this->stmt('SELECT device_id, meta_json FROM devices WHERE device_id IN (%s)', '?', count($chunk));
+                    $stmt->execute($chunk);
+                    foreach ($stmt->fetchAll() as $row) {
+                        $decoded = !empty($row['meta_json']) ? json_decode($row['meta_json'], true) : null;
+                        $metas[(string)$row['device_id']] = is_array($decoded) ? $decoded : [];
+                    }
+                }
+
+                $dirty = [];
+                foreach ($messages as $msg) {
+                    $id = $msg['client_id'];
+                    if (!isset($metaIds[$id])) {
+                        continue;
+                    }
+                    $meta = $metas[$id] ?? [];
+                    if ($this->applyMeta($meta, $msg, $now, $replies)) {
+                        $metas[$id] = $meta;
+                        $dirty[$id] = true;
+                    }
+                }
+
+                if ($dirty !== []) {
+                    $upd = $this->stmt('UPDATE devices SET meta_json = ?, updated_at = ? WHERE device_id = ?', '', 0);
+                    foreach (array_keys($dirty) as $id) {
+                        $upd->execute([json_encode($metas[$id], JSON_UNESCAPED_UNICODE), $now, (string)$id]);
+                    }
+                    $stats['meta'] = count($dirty);
+                }
+            }
+
+            $this->db->commit();
+        } catch (Throwable $e) {
+            if ($this->db->inTransaction()) {
+                $this->db->rollBack();
+            }
+            throw $e;
+        }
+
+        foreach ($replies as $reply) {
+            $this->replies[] = $reply;
+        }
+        $stats['messages'] = count($messages);
+        $stats['devices']  = count($deviceIds);
+        return $stats;
+    }
+
+    /**
+     * 发送已提交批次的回复，返回发送成功条数。
+     *
+     * 回复丢失不影响正确性：设备会重发注册查询，遥测继续以旧基准发送增量。
+     */
+    public function flushReplies(): int
+    {
+        $replies       = $this->replies;
+        $this->replies = [];
+        if ($replies === []) {
+            return 0;
+        }
+
+        $sent = 0;
+        try {
+            if ($this->mqtt === null) {
+                $this->mqtt = new XnMqttClient(
+                    XN_MQTT_HOST,
+                    XN_MQTT_PORT,
+                    XN_MQTT_CLIENT_ID,
+                    XN_MQTT_USERNAME,
+                    XN_MQTT_PASSWORD,
+                    XN_MQTT_KEEPALIVE
+                );
+                $this->ownMqtt = true;
+            }
+            foreach ($replies as [$topic, $payload]) {
+                $this->mqtt->publish($topic, $payload, false);
+                $sent++;
+            }
+        } catch (Throwable $e) {
+            XnIngestLog::line('reply failed: sent=' . $sent . '/' . count($replies) . ' err=' . $e->getMessage());
+            if ($this->ownMqtt) {
+                $this->mqtt    = null;   // 下次重新建立
+                $this->ownMqtt = false;
+            }
+        }
+        return $sent;
+    }
+
+    // ---------------- 内部工具方法 ----------------
+
+    /**
+     * 取预处理语句：$sql 中的 %s 展开为 $rows 个 $tuple（以逗号分隔），按 SQL + 行数缓存。
+     */
+    private function stmt(string $sql, string $tuple, int $rows): PDOStatement
+    {
+        $key = $sql . '#' . $rows;
+        if (!isset($this->stmts[$key])) {
+            $text = $rows > 0 ? sprintf($sql, implode(', ', array_fill(0, $rows, $tuple))) : $sql;
+            $this->stmts[$key] = $this->db->prepare($text);
+        }
+        return $this->stmts[$key];
+    }
+
+    private function uplink(string $suffix): string
+    {
+        return rtrim(XN_MQTT_UPLINK_BASE_TOPIC, '/') . '/' . $suffix;
+    }
+
+    private function downlink(string $suffix): string
+    {
+        return rtrim(XN_MQTT_BASE_TOPIC, '/') . '/' . $suffix;
+    }
+
+    /**
+     * 该消息是否需要读写 meta_json（心跳等普通消息不需要）。
+     */
+    private function touchesMeta(array $msg): bool
+    {
+        $topic = $msg['topic'];
+        $id    = $msg['client_id'];
+        if ($topic === '') {
+            return false;
+        }
+        if (strpos($topic, $this->uplink('reg/query')) === 0 || $topic === $this->uplink('telemetry/' . $id)) {
+            return true;
+        }
+        return $msg['payload'] !== ''
+            && (strpos($topic, $this->uplink('wifi/' . $id . '/')) === 0
+                || strpos($topic, $this->uplink('watering/' . $id . '/')) === 0);
+    }
+
+    /**
+     * 按 Topic 把一条消息合并进设备 meta，返回 meta 是否有改动；需要回复的追加到 $replies。
+     *
+     *  - xn/esp/reg/query                    标记已注册，回复 xn/web/reg/<device_id>/resp
+     *  - xn/esp/wifi/<device_id>/status      当前 WiFi 连接状态（JSON）
+     *  - xn/esp/wifi/<device_id>/saved       已保存 WiFi 列表（JSON）
+     *  - xn/esp/watering/<device_id>/status  当前浇花开关状态（JSON）
+     *  - xn/esp/watering/<device_id>/plan    浇花计划（JSON）
+     *  - xn/esp/telemetry/<device_id>        CBOR 批量遥测，按已确认快照还原增量，设备请求时回 ack
+     */
+    private function applyMeta(array &$meta, array $msg, string $now, array &$replies): bool
+    {
+        $topic = $msg['topic'];
+        $id    = $msg['client_id'];
+
+        if (strpos($topic, $this->uplink('reg/query')) === 0) {
+            $meta['registered']    = true;
+            $meta['registered_at'] = $now;
+            $replies[] = [
+                $this->downlink('reg/' . $id . '/resp'),
+                json_encode([
+                    'status'     => 'ok',
+                    'device_id'  => $id,
+                    'registered' => true,
+                ], JSON_UNESCAPED_UNICODE),
+            ];
+            return true;
+        }
+
+        if ($topic === $this->uplink('telemetry/' . $id)) {
+            $ack     = 'resync';
+            $changed = false;
+            try {
+                $batch = XnTelemetryCbor::decode($msg['bin'] ?? $msg['payload']);
+                if (is_array($batch)) {
+                    $result            = XnTelemetryCbor::apply($meta['telemetry'] ?? [], $batch);
+                    $meta['telemetry'] = $result['state'];
+                    $meta['telemetry']['updated_at'] = $now;
+                    $ack               = $result['ack'];
+                    $changed           = true;
+                }
+            } catch (Throwable $e) {
+                // 解码失败：要求设备重发全量快照
+            }
+            if ($ack !== null) {
+                $replies[] = [$this->downlink('telemetry/' . $id . '/ack'), $ack];
+            }
+            return $changed;
+        }
+
+        $keys = [
+            'wifi/' . $id . '/status'     => 'wifi_status',
+            'wifi/' . $id . '/saved'      => 'wifi_saved',
+            'watering/' . $id . '/status' => 'watering_status',
+            'watering/' . $id . '/plan'   => 'watering_plan',
+        ];
+        foreach ($keys as $suffix => $key) {
+            if (strpos($topic, $this->uplink($suffix)) === 0) {
+                $value = json_decode($msg['payload'], true);
+                if (!is_array($value)) {
+                    return false;
+                }
+                $meta[$key] = $value;
+                return true;
+            }
+        }
+        return false;
+    }
+}
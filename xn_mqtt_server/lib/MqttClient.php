@@ -4,11 +4,15 @@
  *
  * 仅用于网站后台与 EMQX 交互：
  *  - 典型用法：短连接 + publish；
- *  - subscribe 适合在 CLI/守护脚本中使用，不建议在 Web 请求中长时间阻塞。
+ *  - subscribe / poll 适合在 CLI/守护脚本中使用，不建议在 Web 请求中长时间阻塞；
+ *    长连接期间 poll 会按 keepAlive 的一半发送 PINGREQ，连接断开时抛出异常由调用方重连。
  */
 
 class XnMqttClient
 {
+    /** 收到报文首字节后读完整个报文的超时（秒） */
+    private const PACKET_READ_TIMEOUT = 10;
+
     private string $host;
     private int $port;
     private string $clientId;
@@ -19,6 +23,8 @@ class XnMqttClient
     /** @var resource|null */
     private $socket = null;
     private bool $connected = false;
+    private int $packetId = 0;
+    private float $lastWrite = 0.0;
 
     public function __construct(
         string $host,
@@ -99,41 +105,83 @@ class XnMqttClient
     }
 
     /**
-     * 简单订阅并处理一段时间内的消息（适合 CLI 脚本）。
+     * 订阅一个 Topic 过滤器（QoS 0），等待 SUBACK。
      *
-     * @param string   $topicFilter  订阅的 Topic 过滤器
-     * @param callable $callback     function(string $topic, string $payload): void
-     * @param int      $durationSec  处理时长（秒）
+     * 支持 EMQX 共享订阅，例如 "$share/group/xn/esp/#"：同组的多个客户端分摊消息。
+     *
+     * @throws RuntimeException 未收到 SUBACK 或服务器拒绝订阅
      */
-    public function subscribeLoop(string $topicFilter, callable $callback, int $durationSec = 30): void
+    public function subscribe(string $topicFilter): void
     {
         if (!$this->connected) {
             $this->connect();
         }
 
-        // 发送 SUBSCRIBE（QoS 0），报文标识符固定用 1
-        $packetId = 1;
+        $this->packetId = ($this->packetId % 0xFFFF) + 1;
+        $packetId = $this->packetId;
         $topicBin = $this->encodeString($topicFilter) . chr(0x00); // QoS 0
         $body = chr($packetId >> 8) . chr($packetId & 0xFF) . $topicBin;
         $fixedHeader = 0x82; // SUBSCRIBE, QoS 1
         $packet = chr($fixedHeader) . $this->encodeLength(strlen($body)) . $body;
         $this->write($packet);
 
-        // 先读 SUBACK（忽略内容）
         $suback = $this->readPacket();
         if ($suback === null || $suback['type'] !== 9) { // 9 = SUBACK
             throw new RuntimeException('Did not receive SUBACK');
         }
+        if (strlen($suback['body']) >= 3 && ord($suback['body'][2]) === 0x80) {
+            throw new RuntimeException('MQTT subscribe rejected: ' . $topicFilter);
+        }
+    }
+
+    /**
+     * 等待并处理一个报文（适合长驻订阅进程的主循环）。
+     *
+     * @param callable $callback   function(string $topic, string $payload): void
+     * @param float    $timeoutSec 最长等待时间
+     * @return bool 是否收到了一条 PUBLISH
+     * @throws RuntimeException 连接已断开
+     */
+    public function poll(callable $callback, float $timeoutSec = 1.0): bool
+    {
+        if (!$this->connected) {
+            throw new RuntimeException('MQTT client is not connected');
+        }
+
+        // 空闲超过保活时间的一半时发送 PINGREQ，避免服务器按 1.5 倍保活时间断开
+        if ($this->keepAlive > 0 && microtime(true) - $this->lastWrite >= $this->keepAlive / 2) {
+            $this->write(chr(0xC0) . chr(0x00));
+        }
+
+        $pkt = $this->readPacket($timeoutSec);
+        if ($pkt === null) {
+            if (feof($this->socket)) {
+                $this->disconnect();
+                throw new RuntimeException('MQTT connection closed by server');
+            }
+            return false;
+        }
+        if ($pkt['type'] === 3) { // PUBLISH
+            $this->handlePublish($pkt['body'], $callback);
+            return true;
+        }
+        return false; // PINGRESP 等其他报文忽略
+    }
+
+    /**
+     * 简单订阅并处理一段时间内的消息（适合 CLI 脚本）。
+     *
+     * @param string   $topicFilter  订阅的 Topic 过滤器
+     * @param callable $callback     function(string $topic, string $payload): void
+     * @param int      $durationSec  处理时长（秒）
+     */
+    public function subscribeLoop(string $topicFilter, callable $callback, int $durationSec = 30): void
+    {
+        $this->subscribe($topicFilter);
 
         $endTime = time() + $durationSec;
         while (time() < $endTime) {
-            $pkt = $this->readPacket(1.0);
-            if ($pkt === null) {
-                continue;
-            }
-            if ($pkt['type'] === 3) { // PUBLISH
-                $this->handlePublish($pkt['body'], $callback);
-            }
+            $this->poll($callback, 1.0);
         }
     }
 
@@ -203,7 +251,12 @@ class XnMqttClient
     }
 
     /**
-     * 读取一个 MQTT 报文，返回 [type, flags, body]，或在超时时返回 null。
+     * 读取一个 MQTT 报文，返回 [type, flags, body]，或在等待首字节超时时返回 null。
+     *
+     * $timeoutSec 只用于等待报文的首字节（订阅进程攒批时可能只有几毫秒）；首字节到达后剩余长度和报文体
+     * 按 PACKET_READ_TIMEOUT 阻塞读完——报文可能分多个 TCP 段到达，提前返回会让之后的报文全部错位。
+     *
+     * @throws RuntimeException 报文中途超时、连接断开或剩余长度非法（此时连接已关闭）
      */
     private function readPacket(float $timeoutSec = 5.0): ?array
     {
@@ -216,39 +269,30 @@ class XnMqttClient
 
         $header = @fread($this->socket, 1);
         if ($header === '' || $header === false) {
-            $meta = stream_get_meta_data($this->socket);
-            if (!empty($meta['timed_out'])) {
-                return null;
-            }
-            return null;
+            return null; // 超时或连接断开，由调用方通过 feof 区分
         }
         $byte1 = ord($header);
         $type = $byte1 >> 4;
         $flags = $byte1 & 0x0F;
 
-        // Remaining Length (可变长度编码)
+        stream_set_timeout($this->socket, self::PACKET_READ_TIMEOUT);
+
+        // Remaining Length (可变长度编码，最多 4 字节)
         $multiplier = 1;
         $value = 0;
+        $bytes = 0;
         do {
-            $ch = @fread($this->socket, 1);
-            if ($ch === '' || $ch === false) {
-                return null;
+            if ($bytes === 4) {
+                $this->disconnect();
+                throw new RuntimeException('Malformed MQTT remaining length');
             }
-            $digit = ord($ch);
+            $digit = ord($this->readExact(1));
             $value += ($digit & 127) * $multiplier;
             $multiplier *= 128;
-        } while (($digit & 128) !== 0 && $multiplier <= 128 * 128 * 128);
+            $bytes++;
+        } while (($digit & 128) !== 0);
 
-        $body = '';
-        $remaining = $value;
-        while ($remaining > 0) {
-            $chunk = @fread($this->socket, $remaining);
-            if ($chunk === '' || $chunk === false) {
-                break;
-            }
-            $body .= $chunk;
-            $remaining -= strlen($chunk);
-        }
+        $body = $value > 0 ? $this->readExact($value) : '';
 
         return [
             'type'  => $type,
@@ -257,6 +301,23 @@ class XnMqttClient
         ];
     }
 
+    /**
+     * 阻塞读满 $len 字节，读不满时关闭连接并抛出异常（流位置已无法恢复）。
+     */
+    private function readExact(int $len): string
+    {
+        $data = '';
+        while (strlen($data) < $len) {
+            $chunk = @fread($this->socket, $len - strlen($data));
+            if ($chunk === '' || $chunk === false) {
+                $this->disconnect();
+                throw new RuntimeException(sprintf('MQTT packet truncated (%d/%d bytes)', strlen($data), $len));
+            }
+            $data .= $chunk;
+        }
+        return $data;
+    }
+
     /**
      * 处理 PUBLISH 报文体并调用回调。
      */
@@ -288,5 +349,6 @@ class XnMqttClient
             }
             $written += $n;
         }
+        $this->lastWrite = microtime(true);
     }
 }
@@ -0,0 +1,299 @@
+<?php
+/**
+ * 浇花规则编译器：把文本规则编译成设备端规则引擎（components/xn_rule_engine）执行的字节码。
+ *
+ * 每行一条规则，# 之后为注释：
+ *   run     zone=0 max=600 when soil < 30 or prev and soil < 40   # 湿度迟滞：低于 30 开始，40 以上停止
+ *   inhibit zone=0 when rain_ago < 21600                          # 雨后 6 小时内不浇
+ *   inhibit zone=0 when today_s0 >= 900                           # 区域 0 每天最多 15 分钟
+ *   inhibit zone=1 when zone_on0                                  # 区域 0 开启时区域 1 联锁
+ *   notify  code=1 when soil < 10                                 # 过干时上报事件
+ *
+ * 表达式：or / and / not，比较 < <= > >= == !=，算术 + - * /，函数 min(a,b) max(a,b) if(c,a,b)，
+ * 整数常量，输入名（见 INPUTS），prev（本规则上个周期结果）、since（结果保持不变的秒数）。
+ *
+ * 程序格式：'X' 'R' 版本 规则数 { 动作 区域 参数(u16 小端) 代码长度 代码 }...
+ * 编码与 components/xn_rule_engine/tools/rule_vm_test.c 中的测试向量一致。
+ */
+
+class XnRuleCompiler
+{
+    public const VERSION     = 1;
+    public const MAX_RULES   = 16;
+    public const MAX_CODE    = 64;
+    public const MAX_PROGRAM = 512;
+    public const STACK_DEPTH = 8;
+
+    private const ACTIONS = ['run' => 1, 'inhibit' => 2, 'notify' => 3];
+
+    /** 输入名 => 编号，与 main/mqtt_app/rule_app.h 的 rule_app_input_t 一致 */
+    private const INPUTS = [
+        'soil' => 0, 'rain' => 1, 'rain_ago' => 2, 'hour' => 3, 'minute' => 4, 'wday' => 5,
+    ];
+    private const INPUT_ZONE_ON = 8;
+    private const INPUT_TODAY_S = 16;
+    private const MAX_ZONES     = 8;
+
+    private const OP_PUSH8 = 0x01, OP_PUSH16 = 0x02, OP_PUSH32 = 0x03, OP_IN = 0x04;
+    private const OP_PREV  = 0x05, OP_SINCE  = 0x06;
+    private const BINARY = [
+        '+' => 0x10, '-' => 0x11, '*' => 0x12, '/' => 0x13,
+        '<' => 0x20, '<=' => 0x21, '>' => 0x22, '>=' => 0x23, '==' => 0x24, '!=' => 0x25,
+        'and' => 0x30, 'or' => 0x31,
+    ];
+    private const OP_MIN = 0x14, OP_MAX = 0x15, OP_NOT = 0x32, OP_SEL = 0x33;
+
+    /** @var array<int, array{0:string,1:string}> */
+    private $tokens = [];
+    private $pos    = 0;
+    private $code   = '';
+    private $depth  = 0;
+    private $maxDepth = 0;
+
+    /**
+     * 编译整段规则文本。
+     *
+     * @throws InvalidArgumentException 语法错误或超出设备限制（消息带行号）
+     */
+    public static function compile(string $source): string
+    {
+        $rules = [];
+        foreach (preg_split('/\r?\n/', $source) as $i => $line) {
+            $line = trim(preg_replace('/#.*$/', '', $line));
+            if ($line === '') {
+                continue;
+            }
+            try {
+                $rules[] = (new self())->compileRule($line);
+            } catch (InvalidArgumentException $e) {
+                throw new InvalidArgumentException('line ' . ($i + 1) . ': ' . $e->getMessage());
+            }
+        }
+
+        if (count($rules) > self::MAX_RULES) {
+            throw new InvalidArgumentException('too many rules (max ' . self::MAX_RULES . ')');
+        }
+        $blob = 'XR' . chr(self::VERSION) . chr(count($rules)) . implode('', $rules);
+        if (strlen($blob) > self::MAX_PROGRAM) {
+            throw new InvalidArgumentException('program too large: ' . strlen($blob) . ' bytes (max ' . self::MAX_PROGRAM . ')');
+        }
+        return $blob;
+    }
+
+    private function compileRule(string $line): string
+    {
+        if (!preg_match('/^(\w+)((?:\s+\w+=\d+)*)\s+when\s+(.+)$/i', $line, $m)) {
+            throw new InvalidArgumentException('expected "<action> [key=value...] when <expr>"');
+        }
+        $action = strtolower($m[1]);
+        if (!isset(self::ACTIONS[$action])) {
+            throw new InvalidArgumentException("unknown action '$action'");
+        }
+
+        $opts = ['zone' => 0, 'max' => 0, 'code' => 0];
+        preg_match_all('/(\w+)=(\d+)/', $m[2], $kv, PREG_SET_ORDER);
+        foreach ($kv as $pair) {
+            if (!array_key_exists($pair[1], $opts)) {
+                throw new InvalidArgumentException("unknown option '{$pair[1]}'");
+            }
+            $opts[$pair[1]] = (int)$pair[2];
+        }
+        if ($opts['zone'] >= self::MAX_ZONES) {
+            throw new InvalidArgumentException('zone out of range');
+        }
+        $param = $action === 'notify' ? $opts['code'] : ($action === 'run' ? $opts['max'] : 0);
+        if ($param > 0xFFFF) {
+            throw new InvalidArgumentException('parameter out of range');
+        }
+
+        $this->tokenize($m[3]);
+        $this->parseOr();
+        if ($this->pos !== count($this->tokens)) {
+            throw new InvalidArgumentException("unexpected '" . $this->tokens[$this->pos][1] . "'");
+        }
+        if (strlen($this->code) > self::MAX_CODE) {
+            throw new InvalidArgumentException('expression too long: ' . strlen($this->code) . ' bytes (max ' . self::MAX_CODE . ')');
+        }
+        if ($this->maxDepth > self::STACK_DEPTH) {
+            throw new InvalidArgumentException('expression too deep');
+        }
+
+        return chr(self::ACTIONS[$action]) . chr($opts['zone']) . pack('v', $param)
+             . chr(strlen($this->code)) . $this->code;
+    }
+
+    private function tokenize(string $expr): void
+    {
+        preg_match_all('/\s*(?:(\d+)|([A-Za-z_]\w*)|(<=|>=|==|!=|[<>+\-*\/(),])|(\S))/', $expr, $all, PREG_SET_ORDER);
+        $this->tokens = [];
+        foreach ($all as $t) {
+            if (isset($t[4]) && $t[4] !== '') {
+                throw new InvalidArgumentException("unexpected character '{$t[4]}'");
+            }
+            if ($t[1] !== '') {
+                $this->tokens[] = ['num', $t[1]];
+            } elseif (isset($t[2]) && $t[2] !== '') {
+                $this->tokens[] = ['name', strtolower($t[2])];
+            } else {
+                $this->tokens[] = ['op', $t[3]];
+            }
+        }
+    }
+
+    private function peek(): ?string
+    {
+        return $this->tokens[$this->pos][1] ?? null;
+    }
+
+    private function expect(string $tok): void
+    {
+        if ($this->peek() !== $tok) {
+            throw new InvalidArgumentException("expected '$tok'");
+        }
+        $this->pos++;
+    }
+
+    /** 追加指令并跟踪栈深度 */
+    private function emit(string $bytes, int $pop, int $push): void
+    {
+        $this->code .= $bytes;
+        $this->depth += $push - $pop;
+        $this->maxDepth = max($this->maxDepth, $this->depth);
+    }
+
+    private function emitPush(int $v): void
+    {
+        if ($v >= -128 && $v <= 127) {
+            $this->emit(chr(self::OP_PUSH8) . pack('c', $v), 0, 1);
+        } elseif ($v >= -32768 && $v <= 32767) {
+            $this->emit(chr(self::OP_PUSH16) . pack('v', $v & 0xFFFF), 0, 1);
+        } elseif ($v >= -2147483648 && $v <= 2147483647) {
+            $this->emit(chr(self::OP_PUSH32) . pack('V', $v & 0xFFFFFFFF), 0, 1);
+        } else {
+            throw new InvalidArgumentException("constant $v out of range");
+        }
+    }
+
+    private function parseBinary(array $ops, callable $next): void
+    {
+        $next();
+        while (($op = $this->peek()) !== null && in_array($op, $ops, true)) {
+            $this->pos++;
+            $next();
+            $this->emit(chr(self::BINARY[$op]), 2, 1);
+        }
+    }
+
+    private function parseOr(): void
+    {
+        $this->parseBinary(['or'], [$this, 'parseAnd']);
+    }
+
+    private function parseAnd(): void
+    {
+        $this->parseBinary(['and'], [$this, 'parseNot']);
+    }
+
+    private function parseNot(): void
+    {
+        if ($this->peek() === 'not') {
+            $this->pos++;
+            $this->parseNot();
+            $this->emit(chr(self::OP_NOT), 1, 1);
+            return;
+        }
+        $this->parseCompare();
+    }
+
+    private function parseCompare(): void
+    {
+        $this->parseBinary(['<', '<=', '>', '>=', '==', '!='], [$this, 'parseAdd']);
+    }
+
+    private function parseAdd(): void
+    {
+        $this->parseBinary(['+', '-'], [$this, 'parseMul']);
+    }
+
+    private function parseMul(): void
+    {
+        $this->parseBinary(['*', '/'], [$this, 'parsePrimary']);
+    }
+
+    private function parsePrimary(): void
+    {
+        $tok = $this->tokens[$this->pos] ?? null;
+        if ($tok === null) {
+            throw new InvalidArgumentException('unexpected end of expression');
+        }
+        $this->pos++;
+
+        if ($tok[1] === '-' && ($this->tokens[$this->pos][0] ?? '') === 'num') {
+            $this->emitPush(-(int)$this->tokens[$this->pos++][1]);
+            return;
+        }
+        if ($tok[0] === 'num') {
+            $this->emitPush((int)$tok[1]);
+            return;
+        }
+        if ($tok[1] === '(') {
+            $this->parseOr();
+            $this->expect(')');
+            return;
+        }
+        if ($tok[0] !== 'name') {
+            throw new InvalidArgumentException("unexpected '{$tok[1]}'");
+        }
+
+        $name = $tok[1];
+        switch ($name) {
+            case 'prev':
+                $this->emit(chr(self::OP_PREV), 0, 1);
+                return;
+            case 'since':
+                $this->emit(chr(self::OP_SINCE), 0, 1);
+                return;
+            case 'min':
+            case 'max':
+            case 'if':
+                $argc = $name === 'if' ? 3 : 2;
+                $this->expect('(');
+                for ($i = 0; $i < $argc; $i++) {
+                    if ($i > 0) {
+                        $this->expect(',');
+                    }
+                    $this->parseOr();
+                }
+                $this->expect(')');
+                $op = $name === 'if' ? self::OP_SEL : ($name === 'min' ? self::OP_MIN : self::OP_MAX);
+                $this->emit(chr($op), $argc, 1);
+                return;
+        }
+
+        $this->emit(chr(self::OP_IN) . chr(self::inputId($name)), 0, 1);
+    }
+
+    private static function inputId(string $name): int
+    {
+        if (isset(self::INPUTS[$name])) {
+            return self::INPUTS[$name];
+        }
+        if (preg_match('/^(zone_on|today_s)(\d)$/', $name, $m) && (int)$m[2] < self::MAX_ZONES) {
+            return ($m[1] === 'zone_on' ? self::INPUT_ZONE_ON : self::INPUT_TODAY_S) + (int)$m[2];
+        }
+        throw new InvalidArgumentException("unknown input '$name'");
+    }
+}
+
+// 命令行：php lib/RuleCompiler.php rules.txt  输出 base64（可直接作为 mqtt_publish.php 的 payload_b64）
+if (PHP_SAPI === 'cli' && isset($argv[0]) && realpath($argv[0]) === __FILE__) {
+    try {
+        $src = file_get_contents($argv[1] ?? 'php://stdin');
+        $bin = XnRuleCompiler::compile((string)$src);
+        fwrite(STDERR, strlen($bin) . " bytes\n");
+        echo base64_encode($bin), "\n";
+    } catch (Throwable $e) {
+        fwrite(STDERR, $e->getMessage() . "\n");
+        exit(1);
+    }
+}
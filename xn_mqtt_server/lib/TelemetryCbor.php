@@ -0,0 +1,188 @@
+<?php
+/**
+ * 设备遥测批次解码（CBOR + 相对已确认快照的增量还原）。
+ *
+ * 设备每个周期发布一条 CBOR 映射到 xn/esp/telemetry/<device_id>：
+ *   { 0: seq, 1: base_seq(0 = 全量), 2: { id: value | delta }, 3: { id: [name, type] }(仅全量), 4: 1(请求确认) }
+ *  - type：0 计数器、1 量值（增量编码，值 = 基准值 + delta），2 枚举（绝对值）；
+ *  - 批次带确认请求时回 ack（负载为 seq），并保存该批还原结果——设备只会以被确认过的批次为基准；
+ *    找不到 base_seq 对应快照或尚无名称表时回 "resync"，设备改发全量。
+ */
+
+class XnTelemetryCbor
+{
+    public const TYPE_COUNTER = 0;
+    public const TYPE_GAUGE   = 1;
+    public const TYPE_ENUM    = 2;
+
+    /** 服务器保留的已确认快照数（确认报文丢失时设备仍以较早的快照为基准） */
+    public const KEEP_SNAPSHOTS = 4;
+
+    /**
+     * 解码一段 CBOR（支持整数、字节串、文本、数组、映射、true/false/null、浮点）。
+     *
+     * @throws RuntimeException 数据截断或遇到不支持的类型
+     */
+    public static function decode(string $data)
+    {
+        $pos   = 0;
+        $value = self::decodeItem($data, $pos);
+        if ($pos !== strlen($data)) {
+            throw new RuntimeException('CBOR trailing bytes');
+        }
+        return $value;
+    }
+
+    /**
+     * 把一个批次应用到设备的遥测状态上。
+     *
+     * @param array $state meta_json 中保存的 telemetry 状态（首次为空数组）
+     * @param array $batch decode() 的结果
+     *
+     * @return array ['state' => 新状态, 'ack' => 回给设备的负载（seq / "resync"），null 表示无需回复]
+     */
+    public static function apply(array $state, array $batch): array
+    {
+        $seq  = (int)($batch[0] ?? 0);
+        $base = (int)($batch[1] ?? 0);
+        $vals = is_array($batch[2] ?? null) ? $batch[2] : [];
+
+        if ($seq <= 0) {
+            return ['state' => $state, 'ack' => 'resync'];
+        }
+
+        if ($base === 0) {
+            // 全量快照：重建名称表，丢弃旧快照（设备可能已重启，序号重新计数）
+            $schema = [];
+            foreach ((is_array($batch[3] ?? null) ? $batch[3] : []) as $id => $desc) {
+                if (is_array($desc) && count($desc) >= 2) {
+                    $schema[(int)$id] = [(string)$desc[0], (int)$desc[1]];
+                }
+            }
+            $snapshot = [];
+            foreach ($vals as $id => $v) {
+                $snapshot[(int)$id] = (int)$v;
+            }
+            $state = ['schema' => $schema, 'snapshots' => []];
+        } else {
+            $snapshots = $state['snapshots'] ?? [];
+            if (empty($state['schema']) || !isset($snapshots[$base])) {
+                return ['state' => $state, 'ack' => 'resync'];
+            }
+            $snapshot = $snapshots[$base];
+            foreach ($vals as $id => $v) {
+                $id   = (int)$id;
+                $type = $state['schema'][$id][1] ?? self::TYPE_ENUM;
+                if ($type === self::TYPE_ENUM || !isset($snapshot[$id])) {
+                    $snapshot[$id] = (int)$v;
+                } else {
+                    $snapshot[$id] = (int)$snapshot[$id] + (int)$v;
+                }
+            }
+        }
+
+        $ackReq = !empty($batch[4]) || $base === 0;
+        if ($ackReq) {
+            $state['snapshots'][$seq] = $snapshot;
+            ksort($state['snapshots']);
+            while (count($state['snapshots']) > self::KEEP_SNAPSHOTS) {
+                unset($state['snapshots'][array_key_first($state['snapshots'])]);
+            }
+        }
+
+        $named = [];
+        foreach ($snapshot as $id => $v) {
+            $name         = $state['schema'][$id][0] ?? ('#' . $id);
+            $named[$name] = $v;
+        }
+        $state['seq']    = $seq;
+        $state['values'] = $named;
+
+        return ['state' => $state, 'ack' => $ackReq ? (string)$seq : null];
+    }
+
+    private static function need(string $data, int $pos, int $len): void
+    {
+        if ($pos + $len > strlen($data)) {
+            throw new RuntimeException('CBOR truncated');
+        }
+    }
+
+    private static function readArg(string $data, int &$pos, int $info): int
+    {
+        if ($info < 24) {
+            return $info;
+        }
+        $sizes = [24 => 1, 25 => 2, 26 => 4, 27 => 8];
+        if (!isset($sizes[$info])) {
+            throw new RuntimeException('CBOR indefinite length not supported');
+        }
+        $n = $sizes[$info];
+        self::need($data, $pos, $n);
+        $v = 0;
+        for ($i = 0; $i < $n; $i++) {
+            $v = ($v << 8) | ord($data[$pos + $i]);
+        }
+        $pos += $n;
+        return $v;
+    }
+
+    private static function decodeItem(string $data, int &$pos)
+    {
+        self::need($data, $pos, 1);
+        $ib    = ord($data[$pos++]);
+        $major = $ib >> 5;
+        $info  = $ib & 0x1F;
+
+        if ($major === 7) {
+            switch ($info) {
+                case 20: return false;
+                case 21: return true;
+                case 22:
+                case 23: return null;
+                case 26:
+                    self::need($data, $pos, 4);
+                    $f = unpack('G', substr($data, $pos, 4))[1];
+                    $pos += 4;
+                    return $f;
+                case 27:
+                    self::need($data, $pos, 8);
+                    $f = unpack('E', substr($data, $pos, 8))[1];
+                    $pos += 8;
+                    return $f;
+                default:
+                    throw new RuntimeException('CBOR simple value not supported');
+            }
+        }
+
+        $arg = self::readArg($data, $pos, $info);
+
+        switch ($major) {
+            case 0:
+                return $arg;
+            case 1:
+                return -1 - $arg;
+            case 2:
+            case 3:
+                self::need($data, $pos, $arg);
+                $s = substr($data, $pos, $arg);
+                $pos += $arg;
+                return $s;
+            case 4:
+                $out = [];
+                for ($i = 0; $i < $arg; $i++) {
+                    $out[] = self::decodeItem($data, $pos);
+                }
+                return $out;
+            case 5:
+                $out = [];
+                for ($i = 0; $i < $arg; $i++) {
+                    $k       = self::decodeItem($data, $pos);
+                    $out[$k] = self::decodeItem($data, $pos);
+                }
+                return $out;
+            default:
+                throw new RuntimeException('CBOR tag not supported');
+        }
+    }
+}